@@ -0,0 +1,235 @@
+# This file is part of Pyborist.
+#
+# Distributed under the MIT License:  see the accompanying LICENSE.
+
+"""Random forests over the Arborist bridge layer.
+
+Observation blocks are handed to the extension as column-major float64
+and int32 buffers.  Blocks already in that layout, including NumPy
+arrays in Fortran order and null-free Arrow float64 columns, are read
+in place; others are converted once.  Training and prediction release
+the GIL.
+"""
+
+import math
+
+import numpy as np
+
+from . import _pyborist
+
+__all__ = ["Rborist", "seed"]
+
+
+def seed(value):
+    """Reseeds the sampling engine, for reproducible training."""
+    _pyborist.seed(int(value))
+
+
+def _column(col):
+    """Views a single column as a NumPy array, without copying if possible."""
+    to_numpy = getattr(col, "to_numpy", None)
+    if to_numpy is None:
+        return np.asarray(col)
+    try:  # Arrow arrays refuse a copy unless told otherwise.
+        return to_numpy(zero_copy_only=True)
+    except TypeError:  # pandas signature.
+        return to_numpy()
+    except Exception:  # Nulls or chunking preclude zero copy.
+        return to_numpy(zero_copy_only=False)
+
+
+def _split_frame(x, levels=None):
+    """Separates observations into numeric and factor blocks.
+
+    Accepts a 2-d NumPy array, a pandas DataFrame or a pyarrow Table.
+    Categorical columns become factors, their codes zero-based with
+    negative values denoting missing.
+
+    Returns the numeric block, the factor block, the factor
+    cardinalities and the factor levels.
+    """
+    if isinstance(x, np.ndarray):
+        if x.ndim != 2:
+            raise ValueError("Observations must be two-dimensional")
+        num = np.asfortranarray(x, dtype=np.float64)
+        return num, np.empty((num.shape[0], 0), dtype=np.int32, order="F"), [], []
+
+    names = list(x.column_names) if hasattr(x, "column_names") else list(x.columns)
+    num_cols, fac_cols, fac_levels = [], [], []
+    for name in names:
+        col = x.column(name) if hasattr(x, "column_names") else x[name]
+        categories = _categories(col)
+        if categories is None:
+            num_cols.append(_column(col).astype(np.float64, copy=False))
+        else:
+            codes, categories = categories
+            fac_cols.append(codes)
+            fac_levels.append(categories)
+
+    n_row = x.num_rows if hasattr(x, "num_rows") else len(x)
+    if levels is not None:
+        fac_cols = [_recode(codes, have, want) for codes, have, want in zip(fac_cols, fac_levels, levels)]
+        fac_levels = levels
+
+    num = _stack(num_cols, n_row, np.float64)
+    fac = _stack(fac_cols, n_row, np.int32)
+    return num, fac, [len(lv) for lv in fac_levels], fac_levels
+
+
+def _categories(col):
+    """Returns the codes and levels of a categorical column, else None."""
+    cat = getattr(col, "cat", None)
+    if cat is not None:  # pandas categorical.
+        return np.asarray(cat.codes, dtype=np.int32), list(cat.categories)
+    if hasattr(col, "combine_chunks") and hasattr(col.type, "index_type"):
+        arr = col.combine_chunks()  # Arrow dictionary:  nulls become -1.
+        codes = arr.indices.to_numpy(zero_copy_only=False)
+        codes = np.where(arr.is_null().to_numpy(zero_copy_only=False), -1, codes)
+        return codes.astype(np.int32), arr.dictionary.to_pylist()
+    return None
+
+
+def _recode(codes, have, want):
+    """Maps codes over the levels seen now onto those seen in training."""
+    if list(have) == list(want):
+        return codes
+    position = {level: idx for idx, level in enumerate(want)}
+    remap = np.array([position.get(level, -1) for level in have], dtype=np.int32)
+    return np.where(codes < 0, -1, remap[np.maximum(codes, 0)]).astype(np.int32)
+
+
+def _stack(cols, n_row, dtype):
+    """Stacks columns into a column-major block.
+
+    A single column is reshaped in place.
+    """
+    if not cols:
+        return np.empty((n_row, 0), dtype=dtype, order="F")
+    if len(cols) == 1:
+        return np.asfortranarray(cols[0].reshape(n_row, 1), dtype=dtype)
+    block = np.empty((n_row, len(cols)), dtype=dtype, order="F")
+    for idx, col in enumerate(cols):
+        block[:, idx] = col
+    return block
+
+
+class Rborist:
+    """Random forest for regression or classification.
+
+    Parameters mirror those of the R front end's `rfArb`.
+    """
+
+    def __init__(self,
+                 n_tree=500,
+                 n_samp=0,
+                 with_repl=True,
+                 pred_fixed=0,
+                 pred_prob=0.0,
+                 min_node=None,
+                 n_level=0,
+                 min_info=0.01,
+                 split_quant=None,
+                 max_leaf=0,
+                 thin_leaves=None,
+                 tree_block=1,
+                 n_thread=0,
+                 n_bin=0,
+                 n_cut=0,
+                 auto_compress=0.25,
+                 class_weight=None):
+        if n_tree <= 0:
+            raise ValueError("Tree count must be positive")
+        if n_bin < 0 or n_bin > 256:
+            raise ValueError("Bin count must lie between 0 and 256")
+        if pred_prob != 0.0 and pred_fixed != 0:
+            raise ValueError("Only one of 'pred_prob' and 'pred_fixed' may be specified")
+        self.params = dict(n_tree=n_tree, n_samp=n_samp, with_repl=with_repl,
+                           pred_fixed=pred_fixed, pred_prob=pred_prob,
+                           min_node=min_node, n_level=n_level, min_info=min_info,
+                           split_quant=split_quant, max_leaf=max_leaf,
+                           thin_leaves=thin_leaves, tree_block=tree_block,
+                           n_thread=n_thread, n_bin=n_bin, n_cut=n_cut,
+                           auto_compress=auto_compress, class_weight=class_weight)
+        self.model = None
+
+    def _args(self, n_pred, is_ctg):
+        p = self.params
+        args = _pyborist.TrainArgs()
+        pred_fixed, pred_prob = p["pred_fixed"], p["pred_prob"]
+        if pred_fixed == 0 and pred_prob == 0.0:  # Defaults as in rfArb.
+            if n_pred < 16:
+                pred_fixed = math.floor(math.sqrt(n_pred)) if is_ctg else max(n_pred // 3, 1)
+            else:
+                pred_prob = math.ceil(math.sqrt(n_pred)) / n_pred if is_ctg else 0.4
+        if pred_fixed > n_pred:
+            raise ValueError("'pred_fixed' exceeds predictor count")
+        mean_weight = 1.0 if pred_prob == 0.0 else pred_prob
+        split_quant = p["split_quant"]
+        if split_quant is None:
+            split_quant = [0.5] * n_pred
+        if len(split_quant) != n_pred:
+            raise ValueError("'split_quant' length differs from predictor count")
+
+        args.nTree = p["n_tree"]
+        args.nSamp = p["n_samp"]
+        args.withRepl = p["with_repl"]
+        args.predFixed = pred_fixed
+        args.predProb = [mean_weight] * n_pred
+        args.minNode = p["min_node"] if p["min_node"] is not None else (2 if is_ctg else 3)
+        args.nLevel = p["n_level"]
+        args.minInfo = p["min_info"]
+        args.splitQuant = list(split_quant)
+        args.maxLeaf = p["max_leaf"]
+        args.thinLeaves = p["thin_leaves"] if p["thin_leaves"] is not None else is_ctg
+        args.treeBlock = p["tree_block"]
+        args.nThread = p["n_thread"]
+        args.nBin = p["n_bin"]
+        args.nCut = p["n_cut"]
+        args.autoCompress = p["auto_compress"]
+        return args
+
+    def fit(self, x, y):
+        """Trains the forest.
+
+        A categorical response, pandas or Arrow dictionary-encoded,
+        trains a classifier; otherwise a regressor.
+        """
+        num, fac, fac_card, fac_levels = _split_frame(x)
+        n_pred = num.shape[1] + fac.shape[1]
+        categories = _categories(y)
+        if categories is None:
+            y_num = np.ascontiguousarray(_column(y), dtype=np.float64)
+            self.model = _pyborist.train_reg(num, fac, fac_card, y_num, self._args(n_pred, False))
+            self.levels_ = None
+        else:
+            codes, levels = categories
+            if (codes < 0).any():
+                raise ValueError("Missing response values are not supported")
+            weight = self.params["class_weight"]
+            class_weight = [1.0] * len(levels) if weight is None else \
+                [0.0] * len(levels) if weight == "balance" else list(weight)
+            self.model = _pyborist.train_ctg(num, fac, fac_card, np.ascontiguousarray(codes),
+                                             len(levels), class_weight, self._args(n_pred, True))
+            self.levels_ = levels
+        self.fac_levels_ = fac_levels
+        self.feature_importances_ = self.model["predInfo"]
+        return self
+
+    def predict(self, x, bagging=False, prob=False, float32=False):
+        """Predicts over new observations.
+
+        Purely numeric observations are walked in place; observations
+        with factors are first presorted.  'bagging' restricts each row
+        to out-of-bag trees, for observations drawn from training.
+        'float32' reports probabilities in single precision, halving
+        their footprint.
+        """
+        if self.model is None:
+            raise RuntimeError("Forest has not been trained")
+        num, fac, fac_card, _ = _split_frame(x, self.fac_levels_ or None)
+        n_thread = self.params["n_thread"]
+        if self.levels_ is None:
+            return _pyborist.predict_reg(self.model, num, fac, fac_card, bagging, n_thread)
+        predicted = _pyborist.predict_ctg(self.model, num, fac, fac_card, bagging, prob, float32, n_thread)
+        labels = np.asarray(self.levels_, dtype=object)[predicted["yPred"]]
+        return (labels, predicted["prob"]) if prob else labels
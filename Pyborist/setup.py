@@ -0,0 +1,40 @@
+# This file is part of Pyborist.
+#
+# Distributed under the MIT License:  see the accompanying LICENSE.
+
+"""Builds the extension from the shared core and the Python bridge."""
+
+import glob
+import os
+
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+from setuptools import setup
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+
+# Core directories, as copied by the R package build, less R glue.
+CORE_DIRS = ["core", "obs", "split", "frontier", "forest", "forest/bridge", "rf", "cart", "deframe"]
+PY_DIRS = ["src", "src/callback"]
+
+core_dirs = [os.path.join(ROOT, d) for d in CORE_DIRS]
+py_dirs = [os.path.join(HERE, d) for d in PY_DIRS]
+sources = sorted(src for d in core_dirs + py_dirs for src in glob.glob(os.path.join(d, "*.cc")))
+
+ext = Pybind11Extension("pyborist._pyborist",
+                        sources,
+                        include_dirs=core_dirs + py_dirs,
+                        cxx_std=17,
+                        extra_compile_args=["-fopenmp"],
+                        extra_link_args=["-fopenmp"])
+
+setup(name="pyborist",
+      version="0.3.0",
+      description="Extensible, parallelizable implementation of the Random Forest algorithm",
+      license="MIT",
+      packages=["pyborist"],
+      install_requires=["numpy"],
+      extras_require={"arrow": ["pyarrow"], "pandas": ["pandas"]},
+      ext_modules=[ext],
+      cmdclass={"build_ext": build_ext},
+      zip_safe=False)
@@ -0,0 +1,62 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file prng.cc
+
+   @brief Implements random variate generation on behalf of the core.
+
+   Python offers no process-wide generator callable without the GIL, so
+   variates are drawn from a locally-seeded engine, serialized by mutex.
+
+   @author Mark Seligman
+ */
+
+#include "prng.h"
+#include "prngPy.h"
+
+#include <mutex>
+#include <random>
+
+
+namespace {
+  mutex engineLock;
+  mt19937_64 engine(mt19937_64::default_seed);
+}
+
+
+void PRNGPy::seed(uint64_t seed) {
+  lock_guard<mutex> guard(engineLock);
+  engine.seed(seed);
+}
+
+
+vector<double> PRNG::rUnif(size_t len, double scale) {
+  if (PRNGLocal::active())
+    return PRNGLocal::rUnif(len, scale);
+
+  uniform_real_distribution<double> unif(0.0, 1.0);
+  vector<double> rn(len);
+  lock_guard<mutex> guard(engineLock);
+  for (auto & variate : rn) {
+    variate = unif(engine) * scale;
+  }
+  return rn;
+}
+
+
+vector<size_t> PRNG::rUnifIndex(size_t len, size_t scale) {
+  vector<double> rn = rUnif(len, scale);
+  return vector<size_t>(rn.begin(), rn.end());
+}
+
+
+vector<size_t> PRNG::rUnifIndex(const vector<size_t>& scale) {
+  vector<double> rn = rUnif(scale.size());
+  vector<size_t> rnOut(scale.size());
+  for (size_t idx = 0; idx < scale.size(); idx++)
+    rnOut[idx] = rn[idx] * scale[idx];
+  return rnOut;
+}
@@ -0,0 +1,28 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file prngPy.h
+
+   @brief Seeding of the generator backing the core's variates.
+
+   @author Mark Seligman
+ */
+
+#ifndef PYBORIST_CALLBACK_PRNGPY_H
+#define PYBORIST_CALLBACK_PRNGPY_H
+
+#include <cstdint>
+
+using namespace std;
+
+struct PRNGPy {
+  /**
+     @brief Reseeds the engine, for reproducible sessions.
+   */
+  static void seed(uint64_t seed);
+};
+
+#endif
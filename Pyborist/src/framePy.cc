@@ -0,0 +1,104 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file framePy.cc
+
+   @brief Presorts and aliases NumPy observation blocks.
+
+   @author Mark Seligman
+ */
+
+#include "framePy.h"
+#include "rlecresc.h"
+#include "rleframe.h"
+#include "denseframe.h"
+
+
+size_t FramePy::checkRows(const NumBlock& num,
+			  const FacBlock& fac) {
+  if (num.ndim() != 2 || fac.ndim() != 2)
+    throw py::value_error("Observation blocks must be two-dimensional");
+  if (num.shape(1) > 0 && fac.shape(1) > 0 && num.shape(0) != fac.shape(0))
+    throw py::value_error("Observation blocks differ in row count");
+
+  return num.shape(1) > 0 ? num.shape(0) : fac.shape(0);
+}
+
+
+unique_ptr<RLEFrame> FramePy::presort(const NumBlock& num,
+				      const FacBlock& fac,
+				      const vector<unsigned int>& facCard) {
+  size_t nRow = checkRows(num, fac);
+  unsigned int nPredNum = num.shape(1);
+  unsigned int nPredFac = fac.shape(1);
+  if (facCard.size() != nPredFac)
+    throw py::value_error("Factor cardinalities do not match factor block");
+
+  // Factor codes are re-based:  missing codes exceed the top level.
+  vector<unsigned int> facCode(nRow * nPredFac);
+  const int32_t* facIn = fac.data();
+  for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++) {
+    for (size_t row = 0; row < nRow; row++) {
+      int32_t code = facIn[facIdx * nRow + row];
+      if (code >= static_cast<int32_t>(facCard[facIdx]))
+	throw py::value_error("Factor code exceeds cardinality");
+      facCode[facIdx * nRow + row] = code < 0 ? facCard[facIdx] + 1 : code + 1;
+    }
+  }
+
+  RLECresc rleCresc(nRow, nPredNum + nPredFac);
+  vector<void*> colBase(nPredNum + nPredFac);
+  for (unsigned int numIdx = 0; numIdx < nPredNum; numIdx++) {
+    rleCresc.setFactor(numIdx, 0);
+    colBase[numIdx] = const_cast<double*>(num.data() + numIdx * nRow);
+  }
+  for (unsigned int facIdx = 0; facIdx < nPredFac; facIdx++) {
+    rleCresc.setFactor(nPredNum + facIdx, facCard[facIdx]);
+    colBase[nPredNum + facIdx] = &facCode[facIdx * nRow];
+  }
+
+  {
+    py::gil_scoped_release release;
+    rleCresc.encodeFrame(colBase);
+  }
+
+  vector<size_t> rleHeight(rleCresc.getHeight());
+  size_t height = rleHeight.back();
+  vector<szType> runVal(height), runLength(height), runRow(height);
+  rleCresc.dump(runVal, runLength, runRow);
+
+  vector<double> numVal;
+  vector<size_t> numHeight;
+  for (auto & valNum : rleCresc.getValNum()) {
+    numVal.insert(numVal.end(), valNum.begin(), valNum.end());
+    numHeight.push_back(numVal.size());
+  }
+  vector<unsigned int> facVal;
+  vector<size_t> facHeight;
+  for (auto & valFac : rleCresc.getValFac()) {
+    facVal.insert(facVal.end(), valFac.begin(), valFac.end());
+    facHeight.push_back(facVal.size());
+  }
+
+  return make_unique<RLEFrame>(nRow,
+			       rleCresc.dumpTopIdx(),
+			       move(runVal),
+			       move(runLength),
+			       move(runRow),
+			       move(rleHeight),
+			       move(numVal),
+			       move(numHeight),
+			       move(facVal),
+			       move(facHeight));
+}
+
+
+unique_ptr<DenseFrame> FramePy::alias(const NumBlock& num) {
+  if (num.ndim() != 2)
+    throw py::value_error("Observation block must be two-dimensional");
+
+  return make_unique<DenseFrame>(num.shape(0), num.shape(1), num.data(), 0, nullptr, true);
+}
@@ -0,0 +1,71 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file framePy.h
+
+   @brief Presorts and aliases NumPy observation blocks.
+
+   @author Mark Seligman
+ */
+
+#ifndef PYBORIST_FRAMEPY_H
+#define PYBORIST_FRAMEPY_H
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <memory>
+#include <vector>
+
+using namespace std;
+namespace py = pybind11;
+
+/**
+   @brief Numeric block:  column-major float64, referenced in place.
+ */
+typedef py::array_t<double, py::array::f_style> NumBlock;
+
+/**
+   @brief Factor block:  column-major int32 codes, zero-based, with
+   negative values denoting missing observations, as in pandas.
+ */
+typedef py::array_t<int32_t, py::array::f_style> FacBlock;
+
+
+struct FramePy {
+  /**
+     @brief Presorts the observations into run-length encoded form.
+
+     Numeric columns are read in place, from the block's own buffer.
+     Factor codes are small, so are shifted into the one-based coding
+     expected by the encoder, with missing codes mapped beyond the top
+     level.
+
+     @param facCard is the per-column factor cardinality.
+
+     @return ranked frame, numeric predictors preceding factors.
+   */
+  static unique_ptr<struct RLEFrame> presort(const NumBlock& num,
+					     const FacBlock& fac,
+					     const vector<unsigned int>& facCard);
+
+
+  /**
+     @brief Aliases a purely numeric block, without ranking.
+
+     @return dense frame referencing the block, which must remain live.
+   */
+  static unique_ptr<struct DenseFrame> alias(const NumBlock& num);
+
+
+  /**
+     @return row count common to the blocks.
+   */
+  static size_t checkRows(const NumBlock& num,
+			  const FacBlock& fac);
+};
+
+#endif
@@ -0,0 +1,46 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file module.cc
+
+   @brief Registers the extension module's entries.
+
+   @author Mark Seligman
+ */
+
+#include "trainPy.h"
+#include "predictPy.h"
+#include "prngPy.h"
+
+
+PYBIND11_MODULE(_pyborist, mod) {
+  mod.doc() = "Bridge-level entries of the Arborist random forest";
+
+  py::class_<TrainArgs>(mod, "TrainArgs")
+    .def(py::init<>())
+    .def_readwrite("nTree", &TrainArgs::nTree)
+    .def_readwrite("nSamp", &TrainArgs::nSamp)
+    .def_readwrite("withRepl", &TrainArgs::withRepl)
+    .def_readwrite("predFixed", &TrainArgs::predFixed)
+    .def_readwrite("predProb", &TrainArgs::predProb)
+    .def_readwrite("minNode", &TrainArgs::minNode)
+    .def_readwrite("nLevel", &TrainArgs::nLevel)
+    .def_readwrite("minInfo", &TrainArgs::minInfo)
+    .def_readwrite("splitQuant", &TrainArgs::splitQuant)
+    .def_readwrite("maxLeaf", &TrainArgs::maxLeaf)
+    .def_readwrite("thinLeaves", &TrainArgs::thinLeaves)
+    .def_readwrite("treeBlock", &TrainArgs::treeBlock)
+    .def_readwrite("nThread", &TrainArgs::nThread)
+    .def_readwrite("nBin", &TrainArgs::nBin)
+    .def_readwrite("nCut", &TrainArgs::nCut)
+    .def_readwrite("autoCompress", &TrainArgs::autoCompress);
+
+  mod.def("seed", &PRNGPy::seed, "Reseeds the sampling engine");
+  mod.def("train_reg", &TrainPy::trainReg);
+  mod.def("train_ctg", &TrainPy::trainCtg);
+  mod.def("predict_reg", &PredictPy::predictReg);
+  mod.def("predict_ctg", &PredictPy::predictCtg);
+}
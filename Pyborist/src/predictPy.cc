@@ -0,0 +1,171 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file predictPy.cc
+
+   @brief Python entry for prediction.
+
+   @author Mark Seligman
+ */
+
+#include "predictPy.h"
+#include "rleframe.h"
+#include "denseframe.h"
+#include "predictbridge.h"
+#include "samplerbridge.h"
+#include "forestbridge.h"
+#include "leafbridge.h"
+
+#include <complex>
+
+
+unique_ptr<ForestBridge> PredictPy::unwrapForest(const py::dict& model,
+						 unsigned int nThread) {
+  return make_unique<ForestBridge>(model["nTree"].cast<unsigned int>(),
+				   member<double>(model, "nodeExtent"),
+				   member<complex<double>>(model, "treeNode"),
+				   member<double>(model, "scores"),
+				   member<double>(model, "facExtent"),
+				   member<unsigned char>(model, "facSplit"),
+				   nThread);
+}
+
+
+unique_ptr<LeafBridge> PredictPy::unwrapLeaf(const py::dict& model,
+					     const SamplerBridge* samplerBridge) {
+  bool thin = model["leafExtent"].cast<py::array>().size() == 0;
+  return LeafBridge::FactoryPredict(samplerBridge,
+				    thin,
+				    member<double>(model, "leafExtent"),
+				    member<double>(model, "leafIndex"));
+}
+
+
+py::array_t<double> PredictPy::predictReg(const py::dict& model,
+					  const NumBlock& num,
+					  const FacBlock& fac,
+					  const vector<unsigned int>& facCard,
+					  bool bagging,
+					  unsigned int nThread) {
+  py::array yTrainFE = model["yTrain"].cast<py::array>();
+  const double* yBase = member<double>(model, "yTrain");
+  vector<double> yTrain(yBase, yBase + yTrainFE.size());
+  unique_ptr<SamplerBridge> samplerBridge = SamplerBridge::readReg(yTrain,
+								   model["nSamp"].cast<size_t>(),
+								   model["nTree"].cast<unsigned int>(),
+								   member<double>(model, "samples"),
+								   bagging);
+  unique_ptr<LeafBridge> leafBridge = unwrapLeaf(model, samplerBridge.get());
+
+  // Purely numeric blocks are walked in place; factors are presorted.
+  unique_ptr<DenseFrame> denseFrame;
+  shared_ptr<RLEFrame> rleFrame;
+  if (fac.shape(1) == 0)
+    denseFrame = FramePy::alias(num);
+  else
+    rleFrame = FramePy::presort(num, fac, facCard);
+
+  PredictRegBridge pbr(move(rleFrame),
+		       move(denseFrame),
+		       unwrapForest(model, nThread),
+		       move(samplerBridge),
+		       move(leafBridge),
+		       vector<double>(),
+		       0,
+		       false,
+		       false,
+		       false,
+		       false,
+		       false,
+		       nullptr,
+		       0,
+		       nThread,
+		       vector<double>(),
+		       0,
+		       false,
+		       vector<unsigned int>());
+  py::array_t<double> yPred(pbr.getNRow());
+  pbr.bindYPred(yPred.mutable_data());
+  {
+    py::gil_scoped_release release;
+    pbr.predict();
+  }
+
+  return yPred;
+}
+
+
+py::dict PredictPy::predictCtg(const py::dict& model,
+			       const NumBlock& num,
+			       const FacBlock& fac,
+			       const vector<unsigned int>& facCard,
+			       bool bagging,
+			       bool ctgProb,
+			       bool single,
+			       unsigned int nThread) {
+  py::array yTrainFE = model["yTrain"].cast<py::array>();
+  const int32_t* yBase = member<int32_t>(model, "yTrain");
+  vector<unsigned int> yTrain(yBase, yBase + yTrainFE.size());
+  unsigned int nCtg = model["nCtg"].cast<unsigned int>();
+  unique_ptr<SamplerBridge> samplerBridge = SamplerBridge::readCtg(yTrain,
+								   nCtg,
+								   model["nSamp"].cast<size_t>(),
+								   model["nTree"].cast<unsigned int>(),
+								   member<double>(model, "samples"),
+								   bagging);
+  unique_ptr<LeafBridge> leafBridge = unwrapLeaf(model, samplerBridge.get());
+
+  unique_ptr<DenseFrame> denseFrame;
+  shared_ptr<RLEFrame> rleFrame;
+  if (fac.shape(1) == 0)
+    denseFrame = FramePy::alias(num);
+  else
+    rleFrame = FramePy::presort(num, fac, facCard);
+
+  PredictCtgBridge pbc(move(rleFrame),
+		       move(denseFrame),
+		       unwrapForest(model, nThread),
+		       move(samplerBridge),
+		       move(leafBridge),
+		       vector<unsigned int>(),
+		       0,
+		       ctgProb,
+		       false,
+		       false,
+		       0,
+		       false,
+		       false,
+		       false,
+		       false,
+		       false,
+		       nullptr,
+		       0,
+		       false,
+		       0.0,
+		       nThread,
+		       vector<unsigned int>());
+  // Probabilities are written in place, row-major as NumPy expects.
+  py::dict predicted;
+  vector<py::ssize_t> probShape{static_cast<py::ssize_t>(pbc.getNRow()), static_cast<py::ssize_t>(nCtg)};
+  if (ctgProb && single) {
+    py::array_t<float> prob(probShape);
+    pbc.bindProb(prob.mutable_data(), false);
+    predicted["prob"] = prob;
+  }
+  else if (ctgProb) {
+    py::array_t<double> prob(probShape);
+    pbc.bindProb(prob.mutable_data(), false);
+    predicted["prob"] = prob;
+  }
+  {
+    py::gil_scoped_release release;
+    pbc.predict();
+  }
+
+  const vector<unsigned int>& yPred = pbc.getYPred();
+  predicted["yPred"] = py::array_t<unsigned int>(yPred.size(), yPred.data());
+  return predicted;
+}
@@ -0,0 +1,84 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file predictPy.h
+
+   @brief Python entry for prediction.
+
+   @author Mark Seligman
+ */
+
+#ifndef PYBORIST_PREDICTPY_H
+#define PYBORIST_PREDICTPY_H
+
+#include "framePy.h"
+
+#include <pybind11/stl.h>
+
+
+struct PredictPy {
+  /**
+     @brief Regression entry.
+
+     @param model is the dictionary produced by training.  Its buffers
+     are referenced in place, so must retain their trained dtypes.
+
+     @return predicted responses.
+   */
+  static py::array_t<double> predictReg(const py::dict& model,
+					const NumBlock& num,
+					const FacBlock& fac,
+					const vector<unsigned int>& facCard,
+					bool bagging,
+					unsigned int nThread);
+
+
+  /**
+     @brief Classification entry.
+
+     @param single is true iff probabilities are reported as float32.
+
+     @return dictionary of zero-based predicted codes and, if requested,
+     per-category probabilities.
+   */
+  static py::dict predictCtg(const py::dict& model,
+			     const NumBlock& num,
+			     const FacBlock& fac,
+			     const vector<unsigned int>& facCard,
+			     bool bagging,
+			     bool ctgProb,
+			     bool single,
+			     unsigned int nThread);
+
+private:
+  /**
+     @brief Aliases a buffer held by the model, failing on dtype mismatch.
+   */
+  template<typename T>
+  static const T* member(const py::dict& model,
+			 const char* key) {
+    py::object buffer = model[key];
+    if (!py::isinstance<py::array_t<T, py::array::c_style>>(buffer))
+      throw py::type_error(string("Model buffer has unexpected layout:  ") + key);
+    return static_cast<const T*>(buffer.cast<py::array>().data());
+  }
+
+
+  /**
+     @brief Rebuilds the forest from the model buffers, in place.
+   */
+  static unique_ptr<struct ForestBridge> unwrapForest(const py::dict& model,
+						      unsigned int nThread);
+
+
+  /**
+     @brief Rebuilds the leaf from the model buffers, in place.
+   */
+  static unique_ptr<struct LeafBridge> unwrapLeaf(const py::dict& model,
+						  const struct SamplerBridge* samplerBridge);
+};
+
+#endif
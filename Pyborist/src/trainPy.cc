@@ -0,0 +1,195 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file trainPy.cc
+
+   @brief Python entry for training.
+
+   @author Mark Seligman
+ */
+
+#include "trainPy.h"
+#include "rleframe.h"
+#include "trainbridge.h"
+#include "samplerbridge.h"
+#include "forestbridge.h"
+#include "leafbridge.h"
+
+#include <complex>
+
+
+py::array_t<double> TrainPy::sample(size_t nObs,
+				    const TrainArgs& args) {
+  size_t nSamp = args.nSamp == 0 ? nObs : args.nSamp;
+  unique_ptr<SamplerBridge> sb = SamplerBridge::preSample(nSamp, nObs, args.nTree, args.withRepl, nullptr);
+  py::array_t<double> samples(sb->getNuxCount());
+  {
+    py::gil_scoped_release release;
+    sb->sampleTrees(args.nThread, 0);
+    sb->dumpNux(samples.mutable_data());
+  }
+  return samples;
+}
+
+
+py::dict TrainPy::trainReg(const NumBlock& num,
+			   const FacBlock& fac,
+			   const vector<unsigned int>& facCard,
+			   const py::array_t<double>& y,
+			   const TrainArgs& args) {
+  size_t nObs = FramePy::checkRows(num, fac);
+  if (static_cast<size_t>(y.size()) != nObs)
+    throw py::value_error("Response length differs from row count");
+
+  size_t nSamp = args.nSamp == 0 ? nObs : args.nSamp;
+  py::array_t<double> samples = sample(nObs, args);
+  vector<double> yTrain(y.data(), y.data() + nObs);
+  unique_ptr<SamplerBridge> sb = SamplerBridge::trainReg(yTrain, nSamp, args.nTree, samples.data());
+
+  py::dict model = train(num, fac, facCard, sb.get(), args);
+  model["yTrain"] = py::array_t<double>(nObs, y.data());
+  model["nSamp"] = nSamp;
+  model["samples"] = samples;
+  return model;
+}
+
+
+py::dict TrainPy::trainCtg(const NumBlock& num,
+			   const FacBlock& fac,
+			   const vector<unsigned int>& facCard,
+			   const py::array_t<int32_t>& y,
+			   unsigned int nCtg,
+			   const vector<double>& classWeight,
+			   const TrainArgs& args) {
+  size_t nObs = FramePy::checkRows(num, fac);
+  if (static_cast<size_t>(y.size()) != nObs)
+    throw py::value_error("Response length differs from row count");
+  if (classWeight.size() != nCtg)
+    throw py::value_error("Class weights differ in length from category count");
+
+  vector<unsigned int> yTrain(nObs);
+  for (size_t row = 0; row < nObs; row++) {
+    int32_t ctg = y.data()[row];
+    if (ctg < 0 || ctg >= static_cast<int32_t>(nCtg))
+      throw py::value_error("Response code out of range");
+    yTrain[row] = ctg;
+  }
+
+  size_t nSamp = args.nSamp == 0 ? nObs : args.nSamp;
+  py::array_t<double> samples = sample(nObs, args);
+  unique_ptr<SamplerBridge> sb = SamplerBridge::trainCtg(yTrain, nSamp, args.nTree, samples.data(), nCtg, ctgWeight(yTrain, nCtg, classWeight));
+
+  py::dict model = train(num, fac, facCard, sb.get(), args);
+  model["yTrain"] = py::array_t<int32_t>(nObs, y.data());
+  model["nCtg"] = nCtg;
+  model["nSamp"] = nSamp;
+  model["samples"] = samples;
+  return model;
+}
+
+
+vector<double> TrainPy::ctgWeight(const vector<unsigned int>& yCtg,
+				  unsigned int nCtg,
+				  const vector<double>& classWeight) {
+  vector<double> scaledWeight(classWeight);
+  // All zeroes is a place-holder to indicate balanced scaling, as in
+  // the R front end.
+  bool balanced = true;
+  for (auto weight : classWeight) {
+    balanced = balanced && weight == 0.0;
+  }
+  if (balanced) {
+    vector<size_t> census(nCtg);
+    for (auto ctg : yCtg) {
+      census[ctg]++;
+    }
+    for (unsigned int ctg = 0; ctg < nCtg; ctg++) {
+      scaledWeight[ctg] = census[ctg] == 0 ? 0.0 : 1.0 / census[ctg];
+    }
+  }
+
+  double weightSum = 0.0;
+  for (auto weight : scaledWeight) {
+    weightSum += weight;
+  }
+  vector<double> rowWeight(yCtg.size());
+  for (size_t row = 0; row < yCtg.size(); row++) {
+    rowWeight[row] = scaledWeight[yCtg[row]] / weightSum;
+  }
+  return rowWeight;
+}
+
+
+py::dict TrainPy::train(const NumBlock& num,
+			const FacBlock& fac,
+			const vector<unsigned int>& facCard,
+			const SamplerBridge* sb,
+			const TrainArgs& args) {
+  FrameCache frameCache(FramePy::presort(num, fac, facCard), args.autoCompress, false);
+  TrainBridge trainBridge(&frameCache);
+  trainBridge.initProb(args.predFixed, args.predProb);
+  trainBridge.initSplit(args.minNode, args.nLevel, args.minInfo, args.splitQuant);
+  trainBridge.initTree(args.maxLeaf);
+  trainBridge.initBlock(args.treeBlock);
+  trainBridge.initOmp(args.nThread);
+  trainBridge.initBin(args.nBin);
+  trainBridge.initSketch(args.nCut);
+
+  ForestBridge fb(args.nTree);
+  unique_ptr<LeafBridge> lb = LeafBridge::FactoryTrain(sb, args.thinLeaves);
+  unique_ptr<TrainedChunk> trainedChunk;
+  {
+    py::gil_scoped_release release;
+    trainedChunk = trainBridge.train(fb, sb, 0, args.nTree, lb.get());
+  }
+
+  // Model buffers are allocated by NumPy and dumped into directly.
+  const vector<size_t>& nodeExtents = fb.getNodeExtents();
+  py::array_t<double> nodeExtent(nodeExtents.size());
+  copy(nodeExtents.begin(), nodeExtents.end(), nodeExtent.mutable_data());
+  py::array_t<complex<double>> treeNode(fb.getNodeCount());
+  fb.dumpTree(treeNode.mutable_data());
+  py::array_t<double> scores(fb.getNodeCount());
+  fb.dumpScore(scores.mutable_data());
+  const vector<size_t>& facExtents = fb.getFacExtents();
+  py::array_t<double> facExtent(facExtents.size());
+  copy(facExtents.begin(), facExtents.end(), facExtent.mutable_data());
+  py::array_t<unsigned char> facSplit(fb.getFactorBytes());
+  fb.dumpFactorRaw(facSplit.mutable_data());
+  py::array_t<unsigned char> facObserved(fb.getFactorBytes());
+  fb.dumpFactorObserved(facObserved.mutable_data());
+
+  py::array_t<double> leafExtent(lb->getExtentSize());
+  lb->dumpExtent(leafExtent.mutable_data());
+  py::array_t<double> leafIndex(lb->getIndexSize());
+  lb->dumpIndex(leafIndex.mutable_data());
+
+  // Information is mapped back to front-end order and scaled per tree.
+  const vector<double>& infoCore = trainedChunk->getPredInfo();
+  vector<unsigned int> predMap = trainBridge.getPredMap();
+  py::array_t<double> predInfo(infoCore.size());
+  for (size_t predIdx = 0; predIdx < infoCore.size(); predIdx++) {
+    predInfo.mutable_data()[predMap[predIdx]] = infoCore[predIdx] / args.nTree;
+  }
+
+  py::dict model;
+  model["nTree"] = args.nTree;
+  model["nodeExtent"] = nodeExtent;
+  model["treeNode"] = treeNode;
+  model["scores"] = scores;
+  model["facExtent"] = facExtent;
+  model["facSplit"] = facSplit;
+  model["facObserved"] = facObserved;
+  model["leafExtent"] = leafExtent;
+  model["leafIndex"] = leafIndex;
+  model["predInfo"] = predInfo;
+  model["nPredNum"] = num.shape(1);
+  model["nPredFac"] = fac.shape(1);
+  model["nBag"] = sb->getBagTotal(args.nTree);
+
+  TrainBridge::deInit();
+  return model;
+}
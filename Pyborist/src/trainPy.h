@@ -0,0 +1,103 @@
+// This file is part of Pyborist.
+
+/* Distributed under the MIT License:  see the accompanying LICENSE.
+ */
+
+/**
+   @file trainPy.h
+
+   @brief Python entry for training.
+
+   @author Mark Seligman
+ */
+
+#ifndef PYBORIST_TRAINPY_H
+#define PYBORIST_TRAINPY_H
+
+#include "framePy.h"
+
+#include <pybind11/stl.h>
+
+
+/**
+   @brief Training options, as unpacked from the keyword arguments.
+ */
+struct TrainArgs {
+  unsigned int nTree;
+  size_t nSamp; // Zero defaults to # observations.
+  bool withRepl;
+  unsigned int predFixed;
+  vector<double> predProb;
+  unsigned int minNode;
+  unsigned int nLevel;
+  double minInfo;
+  vector<double> splitQuant;
+  size_t maxLeaf;
+  bool thinLeaves;
+  unsigned int treeBlock;
+  unsigned int nThread;
+  unsigned int nBin;
+  unsigned int nCut;
+  double autoCompress;
+};
+
+
+struct TrainPy {
+  /**
+     @brief Regression entry.
+
+     @param y is the numeric response, referenced in place.
+
+     @return dictionary of NumPy buffers encoding the trained model.
+   */
+  static py::dict trainReg(const NumBlock& num,
+			   const FacBlock& fac,
+			   const vector<unsigned int>& facCard,
+			   const py::array_t<double>& y,
+			   const TrainArgs& args);
+
+
+  /**
+     @brief Classification entry.
+
+     @param y holds zero-based response codes.
+
+     @param classWeight is the per-category weighting, all zeroes
+     denoting balanced weights.
+   */
+  static py::dict trainCtg(const NumBlock& num,
+			   const FacBlock& fac,
+			   const vector<unsigned int>& facCard,
+			   const py::array_t<int32_t>& y,
+			   unsigned int nCtg,
+			   const vector<double>& classWeight,
+			   const TrainArgs& args);
+
+
+private:
+  /**
+     @brief Samples observations and dumps the records.
+   */
+  static py::array_t<double> sample(size_t nObs,
+				    const TrainArgs& args);
+
+
+  /**
+     @brief Trains a single chunk and dumps the model into owned buffers.
+   */
+  static py::dict train(const NumBlock& num,
+			const FacBlock& fac,
+			const vector<unsigned int>& facCard,
+			const struct SamplerBridge* sb,
+			const TrainArgs& args);
+
+
+  /**
+     @return per-row weights normalized over categories.
+   */
+  static vector<double> ctgWeight(const vector<unsigned int>& yCtg,
+				  unsigned int nCtg,
+				  const vector<double>& classWeight);
+};
+
+#endif
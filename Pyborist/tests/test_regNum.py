@@ -0,0 +1,23 @@
+# Regression, numeric predictors.
+
+import numpy as np
+
+import pyborist
+
+
+def reg_num_pass(m, nrow, ncol, min_rsq, n_thread):
+    rng = np.random.default_rng(1)
+    a = rng.uniform(size=ncol)
+    b = rng.uniform(size=ncol) * m
+    x = np.asfortranarray(rng.uniform(size=(nrow, ncol)) * m)
+    y = (b * np.round(x / m - a + 0.5)).sum(axis=1)
+
+    pyborist.seed(1)
+    rs = pyborist.Rborist(n_tree=500, n_thread=n_thread).fit(x, y)
+    y_pred = rs.predict(x, bagging=True)
+    rsq = 1.0 - ((y - y_pred) ** 2).mean() / y.var()
+    return rsq >= min_rsq
+
+
+def test_numeric_only_regression_accuracy():
+    assert reg_num_pass(10, 1000, 20, 0.6, 1)
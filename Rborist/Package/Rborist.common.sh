@@ -10,6 +10,7 @@ cp ../R/DESCRIPTION Rborist/
 cp ../R/NAMESPACE Rborist/
 cp ../R/*.Rd Rborist/man/
 cp ../R/NEWS Rborist/inst/
+cp -r ../benchmark Rborist/inst/
 cp ../R/*R Rborist/R/
 cp ../../deframeR/*.R Rborist/R/
 cp ../src/*.cc Rborist/src/
@@ -30,6 +30,9 @@ using namespace Rcpp;
 
 
 vector<double> PRNG::rUnif(size_t len, double scale) {
+  if (PRNGLocal::active())
+    return PRNGLocal::rUnif(len, scale);
+
   double dLen = len; // May be necessary for values > 2^32.
   RNGScope scope;
   NumericVector rn(runif(dLen));
@@ -41,6 +44,11 @@ vector<double> PRNG::rUnif(size_t len, double scale) {
 
 
 vector<size_t> PRNG::rUnifIndex(size_t len, size_t scale) {
+  if (PRNGLocal::active()) {
+    vector<double> rn = PRNGLocal::rUnif(len, scale);
+    return vector<size_t>(rn.begin(), rn.end());
+  }
+
   double dLen = len; // May be necessary for values > 2^32.
   RNGScope scope;
   NumericVector rn(runif(dLen));
@@ -51,6 +59,14 @@ vector<size_t> PRNG::rUnifIndex(size_t len, size_t scale) {
 
 
 vector<size_t> PRNG::rUnifIndex(const vector<size_t>& scale) {
+  if (PRNGLocal::active()) {
+    vector<double> rn = PRNGLocal::rUnif(scale.size());
+    vector<size_t> rnOut(scale.size());
+    for (size_t idx = 0; idx < scale.size(); idx++)
+      rnOut[idx] = rn[idx] * scale[idx];
+    return rnOut;
+  }
+
   double dLen = scale.size(); // May be necessary for values > 2^32.
   RNGScope scope;
   NumericVector scaleCopy(scale.begin(), scale.end());
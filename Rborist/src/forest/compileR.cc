@@ -0,0 +1,62 @@
+// Copyright (C)  2012-2022   Mark Seligman
+//
+// This file is part of rfR.
+//
+// rfR is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// rfR is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with rfR.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+   @file compileR.cc
+
+   @brief C++ interface to R entry for forest compilation.
+
+   @author Mark Seligman
+ */
+
+#include "compileR.h"
+#include "forestR.h"
+#include "forestbridge.h"
+#include "signature.h"
+
+
+RcppExport SEXP Compile(SEXP sArbOut) {
+  BEGIN_RCPP
+
+  List arbOut(sArbOut);
+  if (!arbOut.inherits("rfArb")) {
+    stop("Expecting an rfArb object");
+  }
+
+  IntegerVector predMap((SEXP) arbOut["predMap"]);
+  List predLevel, predFactor;
+  StringVector predNames;
+  Signature::unwrapExport(arbOut, predLevel, predFactor, predNames);
+  unsigned int nPredNum = predMap.length() - predLevel.length();
+
+  unique_ptr<ForestBridge> forestBridge(ForestRf::unwrap(arbOut));
+  return StringVector(forestBridge->emitSource(nPredNum));
+
+  END_RCPP
+}
+
+
+CompiledWalk unwrapCompiled(SEXP sCompiled) {
+  if (Rf_isNull(sCompiled)) {
+    return nullptr;
+  }
+  // Native symbols are wrapped as external pointers by getNativeSymbolInfo().
+  if (TYPEOF(sCompiled) != EXTPTRSXP) {
+    stop("Expecting native symbol address for compiled forest");
+  }
+  return reinterpret_cast<CompiledWalk>(R_ExternalPtrAddrFn(sCompiled));
+}
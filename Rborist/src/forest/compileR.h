@@ -0,0 +1,55 @@
+// Copyright (C)  2012-2022  Mark Seligman
+//
+// This file is part of rf.
+//
+// rf is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// rf is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with rfR.  If not, see <http://www.gnu.org/licenses/>.
+
+
+/**
+   @file compileR.h
+
+   @brief Emits a trained forest as C++ source for native compilation.
+
+   @author Mark Seligman
+ */
+
+
+#ifndef RF_COMPILE_R_H
+#define RF_COMPILE_R_H
+
+#include <Rcpp.h>
+using namespace Rcpp;
+
+#include "predictbridge.h"
+
+/**
+   @brief Generates source for a trained forest.
+
+   @param sArbOut is the training output.
+
+   @return source text, as a character vector of length one.
+ */
+RcppExport SEXP Compile(SEXP sArbOut);
+
+
+/**
+   @brief Unwraps a compiled walker passed as native symbol address.
+
+   @param sCompiled is an external pointer or null.
+
+   @return walker address, if any, else null.
+ */
+CompiledWalk unwrapCompiled(SEXP sCompiled);
+
+#endif
@@ -25,8 +25,9 @@
 
 #include "exportR.h"
 #include "dumpR.h"
-#include "forestR.h"
-#include "forestbridge.h"
+#include "crit.h"
+
+#include <cstring>
 
 /**
    @brief Structures forest summary for analysis by Dump package.
@@ -39,7 +40,7 @@ RcppExport SEXP Dump(SEXP sArbOut) {
   BEGIN_RCPP
 
   DumpRf dumper(sArbOut);
-  dumper.dumpTree();
+  dumper.dumpForest();
   
   return StringVector(dumper.outStr.str());
   END_RCPP
@@ -47,109 +48,137 @@ RcppExport SEXP Dump(SEXP sArbOut) {
 
 
 DumpRf::DumpRf(SEXP sArbOut) :
-  primExport((SEXP) Export(sArbOut)),
-  treeOut((SEXP) primExport["tree"]),
-  predMap((SEXP) primExport["predMap"]),
-  forest(ForestExport::unwrap(List(sArbOut), predMap)),
-  factorMap((SEXP) primExport["factorMap"]),
-  facLevel((SEXP) primExport["predFactor"]),
-  factorBase(predMap.length() - factorMap.length()),
-  treeReg((SEXP) treeOut["internal"]),
-  leafReg((SEXP) treeOut["leaf"]),
-  treePred((SEXP) treeReg["predIdx"]),
-  leafIdx((SEXP) treeReg["leafIdx"]),
-  delIdx((SEXP) treeReg["delIdx"]),
-  split((SEXP) treeReg["split"]),
-  cutSense((SEXP) treeReg["cutSense"]),
-  facBits(forest->getFacSplitTree(0)),
-  score((SEXP) leafReg["score"]),
+  flat((SEXP) ExportFlat(sArbOut, wrap(0))),
+  predMap((SEXP) flat["predMap"]),
+  predLevel((SEXP) flat["predLevel"]),
+  factorBase(predMap.length() - predLevel.length()),
+  nodeOrigin((SEXP) flat["nodeOrigin"]),
+  pred((SEXP) flat["pred"]),
+  delIdx((SEXP) flat["delIdx"]),
+  split((SEXP) flat["split"]),
+  invert((SEXP) flat["invert"]),
+  score((SEXP) flat["score"]),
+  bitOrigin((SEXP) flat["bitOrigin"]),
+  facBits((SEXP) flat["facBits"]),
   predInv(IntegerVector(predMap.length())) {
   predInv[predMap] = IntegerVector(seq(0, predMap.length() - 1));
 }
 
 
-void DumpRf::dumpTree() {
-  for (unsigned int treeIdx = 0; treeIdx < delIdx.length(); treeIdx++) {
-    delIdx[treeIdx] == 0 ?  dumpTerminal(treeIdx) : dumpNonterminal(treeIdx);
+void DumpRf::dumpForest() {
+  for (unsigned int tIdx = 0; tIdx < nodeOrigin.length(); tIdx++) {
+    dumpTree(tIdx);
   }
 }
 
 
-void DumpRf::dumpNonterminal(unsigned int treeIdx) {
-  if (predInv[treePred[treeIdx]] < factorBase) {
-    dumpNumericSplit(treeIdx);
+void DumpRf::dumpTree(unsigned int tIdx) {
+  R_xlen_t origin = nodeOrigin[tIdx];
+  R_xlen_t nodeEnd = tIdx + 1 < nodeOrigin.length() ? R_xlen_t(nodeOrigin[tIdx + 1]) : pred.length();
+  outStr << "tree " << tIdx << ":" << endl;
+  for (R_xlen_t nodeIdx = origin; nodeIdx < nodeEnd; nodeIdx++) {
+    delIdx[nodeIdx] == 0 ?  dumpTerminal(nodeIdx, origin) : dumpNonterminal(nodeIdx, origin, tIdx);
+  }
+}
+
+
+void DumpRf::dumpNonterminal(R_xlen_t nodeIdx,
+			     R_xlen_t origin,
+			     unsigned int tIdx) {
+  if (predInv[pred[nodeIdx]] < factorBase) {
+    dumpNumericSplit(nodeIdx, origin);
   }
   else {
-    dumpFactorSplit(treeIdx);
+    dumpFactorSplit(nodeIdx, origin, tIdx);
   }
 }
 
 
-void DumpRf::dumpHead(unsigned int treeIdx) {
-  outStr << treeIdx << ":  @" << treePred[treeIdx];
+void DumpRf::dumpHead(R_xlen_t nodeIdx,
+		      R_xlen_t origin) {
+  outStr << nodeIdx - origin << ":  @" << pred[nodeIdx];
 }
 
 
 
-void DumpRf::dumpNumericSplit(unsigned int treeIdx) {
-  dumpHead(treeIdx);
-  outStr << (cutSense[treeIdx] == 1 ? " <= " : " >= ")<< split[treeIdx];
-  dumpBranch(treeIdx);
+void DumpRf::dumpNumericSplit(R_xlen_t nodeIdx,
+			      R_xlen_t origin) {
+  dumpHead(nodeIdx, origin);
+  outStr << " <= " << split[nodeIdx];
+  dumpBranch(nodeIdx, origin);
+}
+
+
+void DumpRf::dumpBranch(R_xlen_t nodeIdx,
+			R_xlen_t origin) {
+  outStr << " ? " << branchTrue(nodeIdx) - origin << " : " << branchFalse(nodeIdx) - origin;
+  outStr << " (NA: " << (invert[nodeIdx] ? branchTrue(nodeIdx) : branchFalse(nodeIdx)) - origin << ")" << endl;
 }
 
-void DumpRf::dumpBranch(unsigned int treeIdx) {
-  outStr << " ? " << branchTrue(treeIdx) << " : " << branchFalse(treeIdx) << endl;
+
+R_xlen_t DumpRf::branchTrue(R_xlen_t nodeIdx) const {
+  return nodeIdx + delIdx[nodeIdx];
 }
 
 
-unsigned int DumpRf::branchTrue(unsigned int treeIdx) const {
-  return treeIdx + delIdx[treeIdx] + 1;
+R_xlen_t DumpRf::branchFalse(R_xlen_t nodeIdx) const {
+  return nodeIdx + delIdx[nodeIdx] + 1;
 }
 
 
-unsigned int DumpRf::branchFalse(unsigned int treeIdx) const {
-  return treeIdx + 1;
+size_t DumpRf::getBitOffset(R_xlen_t nodeIdx) const {
+  return size_t(split[nodeIdx]) & ~Crit::sparseBit;
 }
 
 
-size_t DumpRf::getBitOffset(unsigned int treeIdx) const {
-  return *((unsigned int*) &split[treeIdx]);
+bool DumpRf::isSparse(R_xlen_t nodeIdx) const {
+  return (size_t(split[nodeIdx]) & Crit::sparseBit) != 0;
 }
 
 
-unsigned int DumpRf::getCardinality(unsigned int treeIdx) const {
-  unsigned int predIdx = treePred[treeIdx];
-  unsigned int facIdx = predInv[predIdx] - factorBase;
-  return StringVector((SEXP) facLevel[facIdx]).length();
+unsigned int DumpRf::getCardinality(R_xlen_t nodeIdx) const {
+  unsigned int facIdx = predInv[pred[nodeIdx]] - factorBase;
+  return StringVector((SEXP) predLevel[facIdx]).length();
 }
 
 
-void DumpRf::dumpFactorSplit(unsigned int treeIdx) {
-  dumpHead(treeIdx);
+void DumpRf::dumpFactorSplit(R_xlen_t nodeIdx,
+			     R_xlen_t origin,
+			     unsigned int tIdx) {
+  dumpHead(nodeIdx, origin);
 
   bool first = true;
-  size_t bitOffset = getBitOffset(treeIdx);
+  size_t bitOffset = getBitOffset(nodeIdx);
+  size_t byteOrigin = bitOrigin[tIdx];
 
+  // Slots are little-endian on supported platforms, so bits address bytewise.
   outStr << " in {";
-  for (unsigned int fac = 0; fac < getCardinality(treeIdx); fac++) {
-    size_t bit = bitOffset + fac;
-    if (facBits[bit / slotBits] & (1ul << (bit & (slotBits - 1)))) {
+  if (isSparse(nodeIdx)) { // Slot-aligned list:  count, then levels.
+    size_t listByte = byteOrigin + bitOffset / 8;
+    size_t nTrue;
+    memcpy(&nTrue, &facBits[listByte], sizeof(nTrue));
+    for (size_t idx = 1; idx <= nTrue; idx++) {
+      size_t fac;
+      memcpy(&fac, &facBits[listByte + idx * sizeof(fac)], sizeof(fac));
       outStr << (first ? "" : ", ") << fac;
       first = false;
     }
   }
+  else {
+    for (unsigned int fac = 0; fac < getCardinality(nodeIdx); fac++) {
+      size_t bit = bitOffset + fac;
+      if (facBits[byteOrigin + bit / 8] & (1u << (bit % 8))) {
+	outStr << (first ? "" : ", ") << fac;
+	first = false;
+      }
+    }
+  }
   outStr << "}";
-  dumpBranch(treeIdx);
+  dumpBranch(nodeIdx, origin);
 }
 
 
-void DumpRf::dumpTerminal(unsigned int treeIdx) {
-  outStr << treeIdx << ":  leaf score ";
-  unsigned int scoreIdx = leafIdx[treeIdx];
-  if (scoreIdx >= delIdx.length()) {
-    outStr << " (error) " << endl;
-  }
-  else {
-    outStr << score[scoreIdx]  << endl;
- }
+void DumpRf::dumpTerminal(R_xlen_t nodeIdx,
+			  R_xlen_t origin) {
+  outStr << nodeIdx - origin << ":  leaf " << -(pred[nodeIdx] + 1) << " score " << score[nodeIdx] << endl;
 }
@@ -29,6 +29,7 @@
 
 #include <vector>
 #include <memory>
+#include <sstream>
 using namespace std;
 
 #include <Rcpp.h>
@@ -36,76 +37,89 @@ using namespace Rcpp;
 
 RcppExport SEXP Dump(SEXP sTrain);
 
+/**
+   @brief Renders the flat export as text, tree by tree.
+ */
 struct DumpRf {
-  List primExport;
-  List treeOut;
+  const List flat; ///> Flat export, as produced by ExportFlat.
 
   const IntegerVector predMap;
-  const unique_ptr<class ForestExport> forest;
-  const IntegerVector factorMap;
-  const List facLevel;
-  const int factorBase;
-  const List treeReg;
-  const List leafReg;
-
-  const IntegerVector treePred;
-  const IntegerVector leafIdx;
+  const List predLevel;
+  const int factorBase; ///> Core index of the first factor.
+  const NumericVector nodeOrigin;
+  const IntegerVector pred;
   const IntegerVector delIdx;
   const NumericVector split;
-  const IntegerVector cutSense;
-  const vector<unsigned char> facBits;
+  const LogicalVector invert;
   const NumericVector score;
+  const NumericVector bitOrigin;
+  const RawVector facBits;
 
-  static constexpr unsigned int slotBits = 8 * sizeof(unsigned int);
   IntegerVector predInv; // Inversion of predMap.
 
   stringstream outStr;
   DumpRf(SEXP sArbOut);
 
   /**
-     @brief Dumps tree label and splitting predictor.
+     @brief Dumps node label and splitting predictor.
    */
-  void dumpHead(unsigned int treeIdx);
+  void dumpHead(R_xlen_t nodeIdx,
+		R_xlen_t origin);
 
 
   /**
      @brief Dumps branch targets of split as C-style ternary.
    */
-  void dumpBranch(unsigned int treeIdx);
+  void dumpBranch(R_xlen_t nodeIdx,
+		  R_xlen_t origin);
+
   
-  unsigned int branchTrue(unsigned int treeIdx) const;
+  R_xlen_t branchTrue(R_xlen_t nodeIdx) const;
 
   
-  unsigned int branchFalse(unsigned int treeIdx) const;
+  R_xlen_t branchFalse(R_xlen_t nodeIdx) const;
 
 
   /**
-     @brief Reads split encoding as offset into bit vector.
+     @return bit offset of a factor split, relative to its tree.
+   */
+  size_t getBitOffset(R_xlen_t nodeIdx) const;
 
-     @return bit offset associated with tree index.
+
+  /**
+     @return true iff the factor split is coded as a level list.
    */
-  size_t getBitOffset(unsigned int treeIdx) const;
+  bool isSparse(R_xlen_t nodeIdx) const;
 
   
   /**
      @return cardinality of factor associated with split.
    */
-  unsigned int getCardinality(unsigned int treeIdx) const;
+  unsigned int getCardinality(R_xlen_t nodeIdx) const;
 
   
-  void dumpTree();
+  void dumpForest();
+
+
+  void dumpTree(unsigned int tIdx);
 
 
-  void dumpNonterminal(unsigned int treeIdx);
+  void dumpNonterminal(R_xlen_t nodeIdx,
+		       R_xlen_t origin,
+		       unsigned int tIdx);
 
 
-  void dumpNumericSplit(unsigned int treeIdx);
+  void dumpNumericSplit(R_xlen_t nodeIdx,
+			R_xlen_t origin);
 
 
-  void dumpFactorSplit(unsigned int treeIdx);
+  void dumpFactorSplit(R_xlen_t nodeIdx,
+		       R_xlen_t origin,
+		       unsigned int tIdx);
 
   
-  void dumpTerminal(unsigned int treeIdx);
+  void dumpTerminal(R_xlen_t nodeIdx,
+		    R_xlen_t origin);
 };
 
 #endif
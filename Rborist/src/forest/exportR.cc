@@ -29,6 +29,10 @@
 #include "signature.h"
 #include "forestR.h"
 #include "forestbridge.h"
+#include "leafR.h"
+#include "leafbridge.h"
+#include "modelbridge.h"
+#include "modelregistry.h"
 
 #include <vector>
 
@@ -70,6 +74,116 @@ RcppExport SEXP Export(SEXP sArbOut) {
 }
 
 
+RcppExport SEXP ExportFlat(SEXP sArbOut,
+			   SEXP sNThread) {
+  BEGIN_RCPP
+
+  List arbOut(sArbOut);
+  if (!arbOut.inherits("rfArb")) {
+    stop("Expecting an rfArb object");
+  }
+
+  IntegerVector predMap((SEXP) arbOut["predMap"]);
+  List predLevel, predFactor;
+  StringVector predNames;
+  Signature::unwrapExport(arbOut, predLevel, predFactor, predNames);
+  unsigned int nPredNum = predMap.length() - predLevel.length();
+
+  unique_ptr<ForestBridge> forestBridge(ForestRf::unwrap(arbOut, as<unsigned int>(sNThread)));
+  return ExportRf::exportFlat(forestBridge->tabulate(nPredNum, as<unsigned int>(sNThread)), predMap, predLevel, predFactor);
+
+  END_RCPP
+}
+
+
+RcppExport SEXP ExportModel(SEXP sArbOut,
+			    SEXP sPath,
+			    SEXP sQuantiles) {
+  BEGIN_RCPP
+
+  List arbOut(sArbOut);
+  if (!arbOut.inherits("rfArb")) {
+    stop("Expecting an rfArb object");
+  }
+
+  List lSampler((SEXP) arbOut["sampler"]);
+  unique_ptr<SamplerBridge> samplerBridge(SamplerR::unwrapPredict(lSampler, true));
+  unique_ptr<LeafBridge> leafBridge(LeafR::unwrap(arbOut, samplerBridge.get()));
+  unique_ptr<ForestBridge> forestBridge(ForestRf::unwrap(arbOut));
+  if (as<bool>(sQuantiles)) {
+    leafBridge->prepareQuantiles(samplerBridge.get());
+  }
+  ModelBridge::save(as<string>(sPath), forestBridge.get(), samplerBridge.get(), leafBridge.get());
+
+  return sPath;
+  END_RCPP
+}
+
+
+RcppExport SEXP PredictModel(SEXP sPath,
+			     SEXP sNumT,
+			     SEXP sNThread) {
+  BEGIN_RCPP
+
+  NumericMatrix numT(sNumT);
+  size_t nRow = numT.ncol();
+  unsigned int nThread = as<unsigned int>(sNThread);
+  ModelRegistry registry(numT.nrow(), 0);
+  registry.load(as<string>(sPath));
+  if (registry.acquire()->predictorReg != nullptr) {
+    NumericVector yPred(nRow);
+    registry.predict(numT.begin(), nullptr, nRow, yPred.begin(), nThread);
+    return yPred;
+  }
+  else {
+    vector<unsigned int> ctgPred(nRow);
+    registry.predict(numT.begin(), nullptr, nRow, ctgPred.data(), nThread);
+    IntegerVector yPred(nRow);
+    for (size_t row = 0; row < nRow; row++) {
+      yPred[row] = ctgPred[row] + 1;
+    }
+    return yPred;
+  }
+
+  END_RCPP
+}
+
+
+List ExportRf::exportFlat(const ForestTable& table,
+			  const IntegerVector& predMap,
+			  const List& predLevel,
+			  const List& predFactor) {
+  BEGIN_RCPP
+
+  R_xlen_t nNode = table.predIdx.size();
+  IntegerVector pred(nNode);
+  IntegerVector delIdx(table.delIdx.begin(), table.delIdx.end());
+  LogicalVector invert(nNode);
+  for (R_xlen_t idx = 0; idx < nNode; idx++) {
+    pred[idx] = delIdx[idx] == 0 ? -int(table.predIdx[idx] + 1) : predMap[table.predIdx[idx]];
+    invert[idx] = table.invert[idx] != 0;
+  }
+
+  List ffe =
+    List::create(_["predMap"] = predMap,
+		 _["predLevel"] = predLevel,
+		 _["predFactor"] = predFactor,
+		 _["nodeOrigin"] = NumericVector(table.nodeOrigin.begin(), table.nodeOrigin.end()),
+		 _["pred"] = pred,
+		 _["delIdx"] = delIdx,
+		 _["split"] = NumericVector(table.split.begin(), table.split.end()),
+		 _["invert"] = invert,
+		 _["score"] = NumericVector(table.score.begin(), table.score.end()),
+		 _["bitOrigin"] = NumericVector(table.bitOrigin.begin(), table.bitOrigin.end()),
+		 _["facBits"] = RawVector(table.facBits.begin(), table.facBits.end())
+		 );
+  ffe.attr("class") = "ExportFlat";
+  return ffe;
+
+  END_RCPP
+}
+
+
 /**
  */
 List ExportRf::exportForest(const ForestExport *forest,
@@ -37,6 +37,41 @@ using namespace Rcpp;
 
 RcppExport SEXP Export(SEXP sTrain);
 
+
+/**
+   @brief Exports the forest as flat, node-indexed columns.
+
+   @param sNThread is the team size for tabulating trees in parallel.
+ */
+RcppExport SEXP ExportFlat(SEXP sArbOut,
+			   SEXP sNThread);
+
+
+/**
+   @brief Streams the trained model to a binary model file.
+
+   @param sPath names the file to be written.
+
+   @param sQuantiles is true iff quantile support is to be persisted.
+ */
+RcppExport SEXP ExportModel(SEXP sArbOut,
+			    SEXP sPath,
+			    SEXP sQuantiles);
+
+
+/**
+   @brief Scores numeric rows against a binary model file.
+
+   @param sPath names a file written by ExportModel.
+
+   @param sNumT holds the numeric predictors transposed, one column per row.
+
+   @return mean scores for regression, else one-based category codes.
+ */
+RcppExport SEXP PredictModel(SEXP sPath,
+			     SEXP sNumT,
+			     SEXP sNThread);
+
 struct ExportRf {
 
   static List exportLeafReg(const struct LeafExportReg* leaf,
@@ -67,6 +102,20 @@ struct ExportRf {
   static List exportCtg(const List& sTrain,
                         const IntegerVector& predMap,
                         const List& predLevel);
+
+
+  /**
+     @brief Wraps a tabulated forest as R columns.
+
+     Terminal 'pred' values are encoded as -(leaf index + 1), as with
+     the per-tree export.
+
+     @param predMap maps core predictor indices to front-end indices.
+   */
+  static List exportFlat(const struct ForestTable& table,
+			 const IntegerVector& predMap,
+			 const List& predLevel,
+			 const List& predFactor);
 };
 
 struct LeafExport {
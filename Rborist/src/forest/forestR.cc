@@ -42,6 +42,7 @@ FBTrain::FBTrain(unsigned int nTree_) :
   nTree(nTree_),
   nodeExtent(NumericVector(nTree)),
   nodeTop(0),
+  nodeBound(numeric_limits<size_t>::max()),
   scores(NumericVector(0)),
   facExtent(NumericVector(nTree)),
   facTop(0),
@@ -49,6 +50,17 @@ FBTrain::FBTrain(unsigned int nTree_) :
 }
 
 
+void FBTrain::trim(unsigned int nTrained) {
+  nTree = nTrained;
+  nodeExtent = NumericVector(nodeExtent.begin(), nodeExtent.begin() + nTrained);
+  facExtent = NumericVector(facExtent.begin(), facExtent.begin() + nTrained);
+  cNode = ComplexVector(cNode.begin(), cNode.begin() + nodeTop);
+  scores = NumericVector(scores.begin(), scores.begin() + nodeTop);
+  facRaw = RawVector(facRaw.begin(), facRaw.begin() + facTop);
+  facObserved = RawVector(facObserved.begin(), facObserved.begin() + facTop);
+}
+
+
 void FBTrain::bridgeConsume(const ForestBridge& bridge,
 			    unsigned int tIdx,
 			    double scale) {
@@ -68,8 +80,8 @@ void FBTrain::nodeConsume(const ForestBridge& bridge,
 
   size_t nodeCount = bridge.getNodeCount();
   if (nodeTop + nodeCount > static_cast<size_t>(cNode.length())) {
-    cNode = move(ResizeR::resize<ComplexVector>(cNode, nodeTop, nodeCount, scale));
-    scores = move(ResizeR::resize<NumericVector>(scores, nodeTop, nodeCount, scale));
+    cNode = move(ResizeR::resize<ComplexVector>(cNode, nodeTop, nodeCount, scale, nodeBound));
+    scores = move(ResizeR::resize<NumericVector>(scores, nodeTop, nodeCount, scale, nodeBound));
   }
   bridge.dumpTree((complex<double>*)&cNode[nodeTop]);
   bridge.dumpScore(&scores[nodeTop]);
@@ -140,7 +152,48 @@ List FBTrain::wrap() {
 }
 
 
-unique_ptr<ForestBridge> ForestRf::unwrap(const List& lTrain) {
+List FBTrain::snapshot(unsigned int nTrained) const {
+  BEGIN_RCPP
+  List wrappedNode = List::create(_[strTreeNode] = ComplexVector(cNode.begin(), cNode.begin() + nodeTop),
+				  _[strExtent] = NumericVector(nodeExtent.begin(), nodeExtent.begin() + nTrained)
+				  );
+  wrappedNode.attr("class") = "Node";
+  List wrappedFactor = List::create(_[strFacSplit] = RawVector(facRaw.begin(), facRaw.begin() + facTop),
+				    _[strExtent] = NumericVector(facExtent.begin(), facExtent.begin() + nTrained),
+				    _[strObserved] = RawVector(facObserved.begin(), facObserved.begin() + facTop)
+				    );
+  wrappedFactor.attr("class") = "Factor";
+  List forest = List::create(_[strNTree] = nTrained,
+			     _[strNode] = wrappedNode,
+			     _[strScores] = NumericVector(scores.begin(), scores.begin() + nodeTop),
+			     _[strFactor] = wrappedFactor
+			     );
+  forest.attr("class") = "Forest";
+
+  return forest;
+  END_RCPP
+}
+
+
+void FBTrain::restore(const List& lForest) {
+  List lNode((SEXP) lForest[strNode]);
+  NumericVector extentIn((SEXP) lNode[strExtent]);
+  copy(extentIn.begin(), extentIn.end(), nodeExtent.begin());
+  cNode = clone(ComplexVector((SEXP) lNode[strTreeNode]));
+  scores = clone(NumericVector((SEXP) lForest[strScores]));
+  nodeTop = scores.length();
+
+  List lFactor((SEXP) lForest[strFactor]);
+  NumericVector facExtentIn((SEXP) lFactor[strExtent]);
+  copy(facExtentIn.begin(), facExtentIn.end(), facExtent.begin());
+  facRaw = clone(RawVector((SEXP) lFactor[strFacSplit]));
+  facObserved = clone(RawVector((SEXP) lFactor[strObserved]));
+  facTop = facRaw.length();
+}
+
+
+unique_ptr<ForestBridge> ForestRf::unwrap(const List& lTrain,
+					  unsigned int nThread) {
   List lForest(checkForest(lTrain));
   List lNode((SEXP) lForest[FBTrain::strNode]);
   List lFactor((SEXP) lForest[FBTrain::strFactor]);
@@ -149,7 +202,8 @@ unique_ptr<ForestBridge> ForestRf::unwrap(const List& lTrain) {
 				   (complex<double>*) as<ComplexVector>(lNode[FBTrain::strTreeNode]).begin(),
 				   as<NumericVector>(lForest[FBTrain::strScores]).begin(),
 				   as<NumericVector>(lFactor[FBTrain::strExtent]).begin(),
-				   as<RawVector>(lFactor[FBTrain::strFacSplit]).begin());
+				   as<RawVector>(lFactor[FBTrain::strFacSplit]).begin(),
+				   nThread);
 }
 
 
@@ -53,9 +53,12 @@ struct ForestRf {
 
      @param sTrain is an R-stye List node containing forest vectors.
 
+     @param nThread is the team size for decoding.
+
      @return bridge specialization of Forest prediction type.
   */
-  static unique_ptr<struct ForestBridge> unwrap(const List &sTrain);
+  static unique_ptr<struct ForestBridge> unwrap(const List &sTrain,
+						unsigned int nThread = 1);
 };
 
 
@@ -124,11 +127,12 @@ struct FBTrain {
   static const string strFacSplit;
   static const string strObserved;
 
-  const unsigned int nTree; // Total # trees under training.
+  unsigned int nTree; // Total # trees under training, until trimmed.
 
   // Decision node related:
   NumericVector nodeExtent; // # nodes in respective tree.
   size_t nodeTop; // Next available index in node/score buffers.
+  size_t nodeBound; // Bounds the forest-wide node count.
   ComplexVector cNode; // Nodes encoded as complex pairs.
   NumericVector scores; // Same indices as nodeRaw.
 
@@ -141,12 +145,46 @@ struct FBTrain {
   FBTrain(unsigned int nTree);
 
 
+  /**
+     @brief Caps buffer estimates by a known bound on node count.
+   */
+  void setNodeBound(size_t nodeBound) {
+    this->nodeBound = nodeBound;
+  }
+
+
+  /**
+     @brief Shrinks buffers to the leading trees, as when stopping early.
+
+     @param nTrained is the number of trees actually trained.
+   */
+  void trim(unsigned int nTrained);
+
+
   /**
      @brief Decorates trained forest for storage by front end.
    */
   List wrap();
 
 
+  /**
+     @brief Copies the leading trained trees, for checkpointing.
+
+     @param nTrained is the number of trees consumed.
+
+     @return forest in the form produced by 'wrap'.
+   */
+  List snapshot(unsigned int nTrained) const;
+
+
+  /**
+     @brief Reinstates a snapshot as the leading trees.
+
+     @param lForest is a forest produced by 'snapshot'.
+   */
+  void restore(const List& lForest);
+
+
   /**
      @brief Copies core representation of forest components.
 
@@ -37,7 +37,7 @@ LeafR::LeafR() :
   extentTop(0),
   indexTop(0),
   extent(NumericVector(0)),
-  index(NumericVector(0)) {
+  index(RawVector(0)) {
 }
 
 
@@ -51,15 +51,62 @@ void LeafR::bridgeConsume(const LeafBridge* bridge,
   bridge->dumpExtent(&extent[extentTop]);
   extentTop += extentSize;
 
-  size_t indexSize = bridge->getIndexSize();
+  size_t indexSize = bridge->getPackSize();
   if (indexTop + indexSize > static_cast<size_t>(index.length())) {
-    index = move(ResizeR::resize<NumericVector>(index, indexTop, indexSize, scale));
+    index = move(ResizeR::resize<RawVector>(index, indexTop, indexSize, scale));
   }
-  bridge->dumpIndex(&index[indexTop]);
+  bridge->dumpPack(&index[indexTop]);
   indexTop += indexSize;
 }
 
 
+void LeafR::reserve(size_t indexTotal,
+		    size_t leafBound) {
+  index = RawVector(no_init(indexTotal));
+  extent = NumericVector(no_init(leafBound));
+}
+
+
+void LeafR::trim() {
+  if (static_cast<size_t>(extent.length()) > extentTop) {
+    extent = NumericVector(extent.begin(), extent.begin() + extentTop);
+  }
+  if (static_cast<size_t>(index.length()) > indexTop) {
+    index = RawVector(index.begin(), index.begin() + indexTop);
+  }
+}
+
+
+List LeafR::snapshot() const {
+  BEGIN_RCPP
+
+  List leaf = List::create(_[strExtent] = NumericVector(extent.begin(), extent.begin() + extentTop),
+			   _[strIndex] = RawVector(index.begin(), index.begin() + indexTop)
+			   );
+  leaf.attr("class") = "Leaf";
+
+  return leaf;
+  END_RCPP
+}
+
+
+void LeafR::restore(const List& lLeaf) {
+  NumericVector extentIn((SEXP) lLeaf[strExtent]);
+  if (static_cast<size_t>(extentIn.length()) > static_cast<size_t>(extent.length())) {
+    extent = move(ResizeR::resize<NumericVector>(extent, 0, extentIn.length(), 1.0));
+  }
+  copy(extentIn.begin(), extentIn.end(), extent.begin());
+  extentTop = extentIn.length();
+
+  RawVector indexIn((SEXP) lLeaf[strIndex]);
+  if (static_cast<size_t>(indexIn.length()) > static_cast<size_t>(index.length())) {
+    index = move(ResizeR::resize<RawVector>(index, 0, indexIn.length(), 1.0));
+  }
+  copy(indexIn.begin(), indexIn.end(), index.begin());
+  indexTop = indexIn.length();
+}
+
+
 List LeafR::wrap() {
   BEGIN_RCPP
 
@@ -78,7 +125,22 @@ unique_ptr<LeafBridge> LeafR::unwrap(const List& lTrain,
   List lLeaf((SEXP) lTrain["leaf"]);
 
   bool empty = (Rf_isNull(lLeaf[strIndex]) || Rf_isNull(lLeaf[strExtent]));
+  // Buffers are referenced in place and decoded only on demand, so must
+  // not be coerced into temporaries.  Indices are packed unless saved
+  // by an earlier version, in which case they are numeric.
+  bool packed = !empty && TYPEOF(lLeaf[strIndex]) == RAWSXP;
+  if (!empty && !((packed || Rf_isReal(lLeaf[strIndex])) && Rf_isReal(lLeaf[strExtent]))) {
+    stop("Leaf extent must be numeric and index packed or numeric");
+  }
   bool thin = empty || as<NumericVector>(lLeaf[strExtent]).length() == 0;
+  if (packed) {
+    RawVector pack((SEXP) lLeaf[strIndex]);
+    return LeafBridge::FactoryPredict(samplerBridge,
+				      thin,
+				      as<NumericVector>(lLeaf[strExtent]).begin(),
+				      pack.begin(),
+				      pack.length());
+  }
   return LeafBridge::FactoryPredict(samplerBridge,
 				    thin,
 				    empty ? nullptr : as<NumericVector>(lLeaf[strExtent]).begin(),
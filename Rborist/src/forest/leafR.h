@@ -40,10 +40,10 @@ struct LeafR {
   static const string strIndex;
 
   size_t extentTop; // " " leaf extent buffer.
-  size_t indexTop;  // " " sample index buffer.
+  size_t indexTop;  // " " sample index buffer, in bytes.
 
   NumericVector extent; // Leaf extents.
-  NumericVector index; // Sample indices.
+  RawVector index; // Sample indices, packed.
 
   LeafR();
 
@@ -57,6 +57,44 @@ struct LeafR {
    */
   List wrap();
 
+
+  /**
+     @brief Preallocates buffers, unless leaves are thinned.
+
+     Packed sample indices are estimated at a byte apiece, and grown
+     as needed.  Extents, one per leaf, are allocated to their bound
+     without initialization, so that untouched pages remain
+     uncommitted until trimmed.
+
+     @param indexTotal is the forest-wide bag count.
+
+     @param leafBound bounds the forest-wide leaf count.
+   */
+  void reserve(size_t indexTotal,
+	       size_t leafBound);
+
+
+  /**
+     @brief Shrinks buffers to their consumed extent, if larger.
+   */
+  void trim();
+
+
+  /**
+     @brief Copies the consumed extent of the buffers, for checkpointing.
+
+     @return leaf in the form produced by 'wrap'.
+   */
+  List snapshot() const;
+
+
+  /**
+     @brief Reinstates a snapshot as the consumed leading extent.
+
+     @param lLeaf is a leaf produced by 'snapshot'.
+   */
+  void restore(const List& lLeaf);
+
   
   /**
      @brief Consumes a block of samples following training.
@@ -22,6 +22,10 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 
+#include <algorithm>
+#include <limits>
+using namespace std;
+
 /**
    @file resizeR.h
 
@@ -30,12 +34,16 @@ using namespace Rcpp;
    @author Mark Seligman
  */
 namespace ResizeR {
+  /**
+     @param cap bounds the estimated size, if known.
+   */
   template<typename vecType>
   vecType resize(const vecType& raw,
 		 size_t offset,
 		 size_t count,
-		 double scale) { // Assumes scale >= 1.0.
-    vecType temp(scale * (offset + count));
+		 double scale,
+		 size_t cap = numeric_limits<size_t>::max()) { // Assumes scale >= 1.0.
+    vecType temp(max(offset + count, min(cap, static_cast<size_t>(scale * (offset + count)))));
     for (size_t i = 0; i < offset; i++)
       temp[i] = raw[i];
 
@@ -41,15 +41,22 @@ RcppExport SEXP rootSample(const SEXP sY,
 			   const SEXP sRowWeight,
 			   const SEXP sNSamp,
 			   const SEXP sNTree,
-			   const SEXP sWithRepl) {
+			   const SEXP sWithRepl,
+			   const SEXP sNThread,
+			   const SEXP sTreeOffset,
+			   const SEXP sCtgSamp,
+			   const SEXP sBlockSize) {
   BEGIN_RCPP
 
+  if (!Rf_isNull(sCtgSamp)) {
+    return SamplerR::rootSampleStrata(sY, as<vector<size_t>>(sCtgSamp), as<unsigned int>(sNTree), as<bool>(sWithRepl), as<unsigned int>(sNThread), as<size_t>(sTreeOffset));
+  }
   NumericVector weight;
   if (!Rf_isNull(sRowWeight)) {
     NumericVector rowWeight(as<NumericVector>(sRowWeight));
     weight = rowWeight / sum(rowWeight);
   }
-  return SamplerR::rootSample(sY, weight, as<size_t>(sNSamp), as<unsigned int>(sNTree), as<bool>(sWithRepl));
+  return SamplerR::rootSample(sY, weight, as<size_t>(sNSamp), as<unsigned int>(sNTree), as<bool>(sWithRepl), as<unsigned int>(sNThread), as<size_t>(sTreeOffset), as<size_t>(sBlockSize));
 
   END_RCPP
 }
@@ -59,18 +66,38 @@ List SamplerR::rootSample(const SEXP sY,
 			  NumericVector& weight, // RCPP method overwrites.
 			  size_t nSamp,
 			  unsigned int nTree,
-			  bool withRepl) {
+			  bool withRepl,
+			  unsigned int nThread,
+			  size_t treeOffset,
+			  size_t blockSize) {
   size_t nObs = Rf_isFactor(sY) ? as<IntegerVector>(sY).length() : as<NumericVector>(sY).length();
   unique_ptr<SamplerBridge> sb = SamplerBridge::preSample(nSamp, nObs, nTree, withRepl, weight.length() == 0 ? nullptr : &weight[0]);
+  if (blockSize > 1)
+    sb->setBlocks(blockSize);
+
+  // Trees are sampled jointly, in parallel.
+  // Rcpp implementation, per tree:
+  //  vector<size_t> idx = sampleObs(nSamp, withRepl, weight);
+  //  sb->appendSamples(idx);
+  sb->sampleTrees(nThread, treeOffset);
+
+  return wrap(sb.get(), sY);
+}
+
 
-  // Trees exposed at this level to allow front end to parallelize.
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    sb->sample();
-    // Rcpp implementation:
-    //  vector<size_t> idx = sampleObs(nSamp, withRepl, weight);
-    //  sb->appendSamples(idx);
-    //}
+List SamplerR::rootSampleStrata(const SEXP sY,
+				const vector<size_t>& ctgSamp,
+				unsigned int nTree,
+				bool withRepl,
+				unsigned int nThread,
+				size_t treeOffset) {
+  IntegerVector yOne(as<IntegerVector>(sY));
+  vector<unsigned int> yCtg(yOne.begin(), yOne.end());
+  for (auto & ctg : yCtg) {
+    ctg--; // Zero-based.
   }
+  unique_ptr<SamplerBridge> sb = SamplerBridge::preSampleStrata(yCtg.size(), nTree, withRepl, yCtg, ctgSamp);
+  sb->sampleTrees(nThread, treeOffset);
 
   return wrap(sb.get(), sY);
 }
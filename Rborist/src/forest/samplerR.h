@@ -37,7 +37,11 @@ RcppExport SEXP rootSample(const SEXP sY,
 			   const SEXP sRowWeight,
 			   const SEXP sNSamp,
 			   const SEXP sNTree,
-			   const SEXP sWithRepl);
+			   const SEXP sWithRepl,
+			   const SEXP sNThread,
+			   const SEXP sTreeOffset,
+			   const SEXP sCtgSamp,
+			   const SEXP sBlockSize);
 
 
 /**
@@ -55,13 +59,31 @@ struct SamplerR {
   /**
      @brief Samples according to specification.
 
+     @param blockSize is the number of consecutive rows drawn together.
+
      @return wrapped list of sample records.
    */
   static List rootSample(const SEXP sY,
 			 NumericVector& weight, // Change to const when Sampler completed.
 			 size_t nSamp,
 			 unsigned int nTree,
-			 bool withRepl);
+			 bool withRepl,
+			 unsigned int nThread,
+			 size_t treeOffset,
+			 size_t blockSize = 0);
+
+
+  /**
+     @brief As above, but drawing fixed counts from each category.
+
+     @param ctgSamp are the per-category sample counts.
+   */
+  static List rootSampleStrata(const SEXP sY,
+			       const vector<size_t>& ctgSamp,
+			       unsigned int nTree,
+			       bool withRepl,
+			       unsigned int nThread,
+			       size_t treeOffset);
 
 
   /**
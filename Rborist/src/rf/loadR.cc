@@ -0,0 +1,49 @@
+// Copyright (C)  2012-2022   Mark Seligman
+//
+// This file is part of rfR.
+//
+// rfR is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// rfR is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with rfR.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+   @file loadR.cc
+
+   @brief C++ interface to R summary of thread utilization.
+
+   @author Mark Seligman
+ */
+
+#include "loadR.h"
+#include "loadstat.h"
+
+
+NumericMatrix LoadR::wrap(const vector<string>& regionName,
+			  const vector<const LoadStat*>& loadStat) {
+  BEGIN_RCPP
+  NumericMatrix load(regionName.size(), 7);
+  for (R_xlen_t regionIdx = 0; regionIdx < load.nrow(); regionIdx++) {
+    const LoadStat* stat = loadStat[regionIdx];
+    load(regionIdx, 0) = stat->nCall;
+    load(regionIdx, 1) = stat->nCall == 0 ? NA_REAL : double(stat->nPart) / stat->nCall;
+    load(regionIdx, 2) = stat->nIter;
+    load(regionIdx, 3) = stat->tBusy;
+    load(regionIdx, 4) = stat->nCall == 0 ? NA_REAL : stat->imbalance();
+    load(regionIdx, 5) = stat->nCall == 0 ? NA_REAL : stat->iterImbalance();
+    load(regionIdx, 6) = stat->nCall == 0 ? NA_REAL : stat->utilization();
+  }
+  rownames(load) = CharacterVector(regionName.begin(), regionName.end());
+  colnames(load) = CharacterVector::create("call", "thread", "iteration", "busy", "imbalance", "iterImbalance", "utilization");
+
+  return load;
+  END_RCPP
+}
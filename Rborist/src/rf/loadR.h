@@ -0,0 +1,54 @@
+// Copyright (C)  2012-2022   Mark Seligman
+//
+// This file is part of rfR.
+//
+// rfR is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// rfR is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with rfR.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+   @file loadR.h
+
+   @brief C++ interface to R summary of thread utilization.
+
+   @author Mark Seligman
+ */
+
+#ifndef RF_LOAD_R_H
+#define RF_LOAD_R_H
+
+#include <Rcpp.h>
+using namespace Rcpp;
+
+#include <string>
+#include <vector>
+using namespace std;
+
+
+/**
+   @brief Summarizes parallel regions for the front end.
+ */
+struct LoadR {
+  /**
+     @brief Tabulates the utilization of several regions.
+
+     @param regionName names each region.
+
+     @param loadStat holds the statistics of each region.
+
+     @return matrix having one row per region.
+   */
+  static NumericMatrix wrap(const vector<string>& regionName,
+			    const vector<const struct LoadStat*>& loadStat);
+};
+
+#endif
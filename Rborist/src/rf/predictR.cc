@@ -24,6 +24,8 @@
  */
 
 #include "predictbridge.h"
+#include "predictstat.h"
+#include "loadR.h"
 #include "predictR.h"
 #include "samplerR.h"
 #include "leafR.h"
@@ -33,6 +35,9 @@
 #include "leafbridge.h"
 #include "rleframeR.h"
 #include "signature.h"
+#include "compileR.h"
+#include "ompthread.h"
+#include "tracelog.h"
 
 #include <algorithm>
 
@@ -91,6 +96,212 @@ RcppExport SEXP validateRcpp(const SEXP sDeframe,
 }
 
 
+RcppExport SEXP predictBatchRcpp(const SEXP sDeframe,
+				 const SEXP sTrains,
+				 const SEXP sArgs) {
+  BEGIN_RCPP
+    List lArgs(sArgs);
+  bool verbose = as<bool>(lArgs["verbose"]);
+  if (verbose)
+    Rcout << "Entering batch prediction" << endl;
+
+  List summary = PBRf::predictBatch(List(sDeframe), List(sTrains), lArgs);
+
+  if (verbose)
+    Rcout << "Batch prediction completed" << endl;
+
+  return summary;
+  END_RCPP
+}
+
+
+RcppExport SEXP rfThreadsRcpp(const SEXP sAffinity,
+			      const SEXP sCpus,
+			      const SEXP sSpin,
+			      const SEXP sWarm) {
+  BEGIN_RCPP
+
+  string policy = as<string>(sAffinity);
+  Affinity affinity;
+  if (policy == "none")
+    affinity = Affinity::none;
+  else if (policy == "compact")
+    affinity = Affinity::compact;
+  else if (policy == "scatter")
+    affinity = Affinity::scatter;
+  else
+    stop("Unrecognized affinity policy");
+
+  OmpThread::initPool(affinity, as<vector<unsigned int>>(sCpus), as<unsigned int>(sSpin), as<bool>(sWarm));
+  return wrap(OmpThread::keepWarm);
+  END_RCPP
+}
+
+
+RcppExport SEXP rfTraceRcpp(const SEXP sPath,
+			    const SEXP sCapacity) {
+  BEGIN_RCPP
+
+  if (Rf_isNull(sPath)) {
+    TraceLog::start(as<size_t>(sCapacity));
+    return wrap(0.0);
+  }
+  return wrap(static_cast<double>(TraceLog::dump(as<string>(sPath))));
+  END_RCPP
+}
+
+
+List PBRf::predictBatch(const List& lDeframe,
+			const List& lTrains,
+			const List& lArgs) {
+  BEGIN_RCPP
+
+  shared_ptr<RLEFrame> rleFrame(RLEFrameR::unwrap(lDeframe));
+  R_xlen_t nModel = lTrains.length();
+  vector<unique_ptr<PredictRegBridge>> regBridge(nModel);
+  vector<unique_ptr<PredictCtgBridge>> ctgBridge(nModel);
+  vector<unique_ptr<PredictOutR>> out(nModel);
+  vector<PredictBridge*> models;
+  for (R_xlen_t modelIdx = 0; modelIdx < nModel; modelIdx++) {
+    List lTrain(lTrains[modelIdx]);
+    List lSampler((SEXP) lTrain["sampler"]);
+    SEXP yTrain = lSampler["yTrain"];
+    if (Rf_isFactor(yTrain)) {
+      ctgBridge[modelIdx] = unwrapCtg(lDeframe, lTrain, lSampler, R_NilValue, lArgs, rleFrame);
+      if (as<bool>(lArgs["stat"]))
+	ctgBridge[modelIdx]->enableStat();
+      if (as<bool>(lArgs["shareNodes"]))
+	ctgBridge[modelIdx]->enableShare();
+      if (as<string>(lArgs["engine"]) != "fixed")
+	ctgBridge[modelIdx]->enableAuto(as<string>(lArgs["engine"]) == "calibrate");
+      out[modelIdx] = make_unique<PredictOutR>(ctgBridge[modelIdx].get(), lArgs, as<CharacterVector>(IntegerVector(yTrain).attr("levels")).length());
+      models.push_back(ctgBridge[modelIdx].get());
+    }
+    else {
+      regBridge[modelIdx] = unwrapReg(lDeframe, lTrain, lSampler, R_NilValue, lArgs, rleFrame);
+      if (as<bool>(lArgs["stat"]))
+	regBridge[modelIdx]->enableStat();
+      if (as<bool>(lArgs["shareNodes"]))
+	regBridge[modelIdx]->enableShare();
+      if (as<string>(lArgs["engine"]) != "fixed")
+	regBridge[modelIdx]->enableAuto(as<string>(lArgs["engine"]) == "calibrate");
+      out[modelIdx] = make_unique<PredictOutR>(regBridge[modelIdx].get());
+      models.push_back(regBridge[modelIdx].get());
+    }
+  }
+  PredictBridge::predictBatch(models);
+
+  List summaryBatch(nModel);
+  for (R_xlen_t modelIdx = 0; modelIdx < nModel; modelIdx++) {
+    List lTrain(lTrains[modelIdx]);
+    if (regBridge[modelIdx])
+      summaryBatch[modelIdx] = summary(lDeframe, R_NilValue, regBridge[modelIdx].get(), *out[modelIdx]);
+    else
+      summaryBatch[modelIdx] = LeafCtgRf::summary(lDeframe, List((SEXP) lTrain["sampler"]), ctgBridge[modelIdx].get(), *out[modelIdx], R_NilValue);
+  }
+  return summaryBatch;
+
+  END_RCPP
+}
+
+
+LeafSinkR::LeafSinkR(bool embed_,
+		     unsigned int nNbr,
+		     double proxMin) :
+  embed(embed_),
+  proximity(nNbr > 0 ? make_unique<Proximity>(nNbr, proxMin) : nullptr) {
+}
+
+
+PredictOutR::PredictOutR(const PredictRegBridge* pBridge) :
+  yPred(NumericVector(pBridge->getNRow())),
+  qPred(pBridge->getNQuant() == 0 ? NumericMatrix(0) : NumericMatrix(pBridge->getNRow(), pBridge->getNQuant())),
+  qEst(pBridge->getNQuant() == 0 ? NumericVector(0) : NumericVector(pBridge->getNRow())) {
+  pBridge->bindYPred(yPred.begin());
+  if (pBridge->getNQuant() > 0)
+    pBridge->bindQuant(qPred.begin(), qEst.begin(), true);
+}
+
+
+PredictOutR::PredictOutR(const PredictCtgBridge* pBridge,
+			 const List& lArgs,
+			 unsigned int nCtg) :
+  census(as<bool>(lArgs["census"]) ? IntegerMatrix(pBridge->getNRow(), nCtg) : IntegerMatrix(0)),
+  prob(as<bool>(lArgs["ctgProb"]) ? NumericMatrix(pBridge->getNRow(), nCtg) : NumericMatrix(0)) {
+  // R integers are 32-bit, and vote counts fall well within range.
+  if (census.nrow() > 0)
+    pBridge->bindCensus(reinterpret_cast<unsigned int*>(census.begin()), true);
+  if (prob.nrow() > 0)
+    pBridge->bindProb(prob.begin(), true);
+}
+
+
+unique_ptr<LeafSinkR> LeafSinkR::unwrap(const List& lArgs) {
+  bool embed = as<bool>(lArgs["leafEmbed"]);
+  unsigned int nNbr = as<unsigned int>(lArgs["proximity"]);
+  return (embed || nNbr > 0) ? make_unique<LeafSinkR>(embed, nNbr, as<double>(lArgs["proxMin"])) : nullptr;
+}
+
+
+void LeafSinkR::consume(const PredictBridge* pBridge) {
+  if (proximity) {
+    proximity->compute(this, pBridge->getLeafOrigin());
+  }
+}
+
+
+void LeafSinkR::annotate(List& prediction,
+			 const PredictBridge* pBridge) const {
+  if (embed) {
+    prediction["leaf"] = getLeaves(pBridge);
+  }
+  if (proximity) {
+    prediction["proximity"] = getProximity();
+  }
+}
+
+
+List LeafSinkR::getProximity() const {
+  BEGIN_RCPP
+
+  unsigned int nNbr = proximity->getNNbr();
+  size_t nRow = getNRow();
+  IntegerMatrix nbrOut(nRow, nNbr);
+  NumericMatrix proxOut(nRow, nNbr);
+  const vector<IndexT>& nbrRow = proximity->getNbrRow();
+  const vector<double>& nbrProx = proximity->getNbrProx();
+  const vector<unsigned int>& nbrCount = proximity->getNbrCount();
+  for (size_t row = 0; row < nRow; row++) {
+    for (unsigned int nbrIdx = 0; nbrIdx < nNbr; nbrIdx++) {
+      bool present = nbrIdx < nbrCount[row];
+      nbrOut(row, nbrIdx) = present ? static_cast<int>(nbrRow[row * nNbr + nbrIdx]) + 1 : NA_INTEGER;
+      proxOut(row, nbrIdx) = present ? nbrProx[row * nNbr + nbrIdx] : NA_REAL;
+    }
+  }
+  List proxList = List::create(_["row"] = nbrOut,
+			       _["prox"] = proxOut
+			       );
+  return proxList;
+
+  END_RCPP
+}
+
+
+List LeafSinkR::getLeaves(const PredictBridge* pBridge) const {
+  BEGIN_RCPP
+
+  const vector<size_t>& leafOrigin = pBridge->getLeafOrigin();
+  List leaves = List::create(_["p"] = NumericVector(rowPtr.begin(), rowPtr.end()),
+			     _["j"] = IntegerVector(leafCol.begin(), leafCol.end()),
+			     _["treeOrigin"] = NumericVector(leafOrigin.begin(), leafOrigin.end() - 1),
+			     _["nCol"] = static_cast<double>(leafOrigin.back())
+			     );
+  return leaves;
+
+  END_RCPP
+}
+
+
 List PBRf::predictReg(const List& lDeframe,
 		      const List& lTrain,
 		      const List& lSampler,
@@ -99,9 +310,45 @@ List PBRf::predictReg(const List& lDeframe,
   BEGIN_RCPP
 
     unique_ptr<PredictRegBridge> pBridge(unwrapReg(lDeframe, lTrain, lSampler, sYTest, lArgs));
+  if (as<bool>(lArgs["stat"]))
+    pBridge->enableStat();
+  if (as<bool>(lArgs["shareNodes"]))
+    pBridge->enableShare();
+  if (as<string>(lArgs["engine"]) != "fixed")
+    pBridge->enableAuto(as<string>(lArgs["engine"]) == "calibrate");
+  if (as<bool>(lArgs["traffic"]))
+    pBridge->enableTraffic();
+  bool shap = as<bool>(lArgs["shap"]);
+  if (shap)
+    pBridge->enableShap();
+  bool partial = enablePartial(pBridge.get(), lArgs);
+  if (as<bool>(lArgs["jackVar"]))
+    pBridge->enableJackVar();
+  if (!Rf_isNull(lArgs["yMulti"])) {
+    NumericMatrix yMulti((SEXP) lArgs["yMulti"]);
+    pBridge->enableMulti(vector<double>(yMulti.begin(), yMulti.end()), yMulti.ncol());
+  }
+  bool localImp = as<bool>(lArgs["localImp"]);
+  if (localImp)
+    pBridge->enableLocalImp();
+  unique_ptr<LeafSinkR> leafSink(LeafSinkR::unwrap(lArgs));
+  if (leafSink)
+    pBridge->setLeafSink(leafSink.get());
+  PredictOutR out(pBridge.get());
   pBridge->predict();
-
-  return summary(lDeframe, sYTest, pBridge.get());
+  if (leafSink)
+    leafSink->consume(pBridge.get());
+
+  List summaryReg = summary(lDeframe, sYTest, pBridge.get(), out, leafSink.get());
+  if (shap)
+    summaryReg.push_back(wrapShap(pBridge.get(), lTrain, lDeframe, R_NilValue), "shap");
+  if (partial)
+    summaryReg.push_back(wrapPartial(pBridge.get(), lArgs, R_NilValue), "partial");
+  if (localImp)
+    summaryReg.push_back(wrapLocalImp(pBridge.get(), lTrain, lDeframe, R_NilValue), "localImp");
+  if (shap || partial || localImp)
+    summaryReg.attr("class") = "SummaryReg";
+  return summaryReg;
   
   END_RCPP
 }
@@ -111,18 +358,33 @@ unique_ptr<PredictRegBridge> PBRf::unwrapReg(const List& lDeframe,
 					     const List& lTrain,
 					     const List& lSampler,
 					     const SEXP sYTest,
-					     const List& lArgs) {
+					     const List& lArgs,
+					     shared_ptr<RLEFrame> rleShared) {
   unique_ptr<SamplerBridge> samplerBridge(SamplerR::unwrapPredict(lSampler, lDeframe, as<bool>(lArgs["bagging"])));
   unique_ptr<LeafBridge> leafBridge(LeafR::unwrap(lTrain, samplerBridge.get()));
-  return make_unique<PredictRegBridge>(RLEFrameR::unwrap(lDeframe),
-				       ForestRf::unwrap(lTrain),
+  unique_ptr<DenseFrame> denseFrame(rleShared ? nullptr : RLEFrameR::unwrapDense(lDeframe));
+  shared_ptr<RLEFrame> rleFrame(rleShared);
+  if (!rleFrame && !denseFrame)
+    rleFrame = RLEFrameR::unwrap(lDeframe);
+  return make_unique<PredictRegBridge>(move(rleFrame),
+				       move(denseFrame),
+				       ForestRf::unwrap(lTrain, as<unsigned int>(lArgs["nThread"])),
 				       move(samplerBridge),
 				       move(leafBridge),
 				       regTest(sYTest),
 				       as<unsigned int>(lArgs["impPermute"]),
 				       as<bool>(lArgs["trapUnobserved"]),
+				       as<bool>(lArgs["quickScore"]),
+				       as<bool>(lArgs["binCode"]),
+				       as<bool>(lArgs["compact"]),
+				       as<bool>(lArgs["reuseRuns"]),
+				       unwrapCompiled(lArgs["compiled"]),
+				       as<unsigned int>(lArgs["nReplica"]),
 				       as<unsigned int>(lArgs["nThread"]),
-				       quantVec(lArgs));
+				       quantVec(lArgs),
+				       as<unsigned int>(lArgs["quantSketch"]),
+				       as<bool>(lArgs["quantExact"]),
+				       sweepVec(lArgs));
 }
 
 
@@ -146,24 +408,37 @@ vector<double> PBRf::quantVec(const List& lArgs) {
 }
 
 
-List PBRf::summary(const List& lDeframe, SEXP sYTest, const PredictRegBridge* pBridge) {
+vector<unsigned int> PBRf::sweepVec(const List& lArgs) {
+  vector<unsigned int> treeSweep;
+  if (!Rf_isNull(lArgs["treeSweep"])) {
+    IntegerVector sweepFE(as<IntegerVector>(lArgs["treeSweep"]));
+    for (auto nTree : sweepFE) {
+      if (nTree > 0)
+	treeSweep.push_back(nTree);
+    }
+  }
+  return treeSweep;
+}
+
+
+List PBRf::summary(const List& lDeframe, SEXP sYTest, const PredictRegBridge* pBridge, const PredictOutR& out, const LeafSinkR* leafSink) {
   BEGIN_RCPP
 
   List summaryReg;
   if (Rf_isNull(sYTest)) {
     summaryReg = List::create(
-			      _["prediction"] = getPrediction(pBridge)
+			      _["prediction"] = getPrediction(pBridge, out, leafSink)
 			      );
   }
   else if (!pBridge->permutes()) { // Validation, no importance.
     summaryReg = List::create(
-			      _["prediction"] = getPrediction(pBridge),
+			      _["prediction"] = getPrediction(pBridge, out, leafSink),
 			      _["validation"] = getValidation(pBridge, NumericVector((SEXP)sYTest))
 			      );
   }
   else { // Validation + importance
     summaryReg = List::create(
-			      _["prediction"] = getPrediction(pBridge),
+			      _["prediction"] = getPrediction(pBridge, out, leafSink),
 			      _["validation"] = getValidation(pBridge, NumericVector((SEXP)sYTest)),
 			      _["importance"] = getImportance(pBridge, NumericVector((SEXP) sYTest), Signature::unwrapColNames(lDeframe))
 			      );
@@ -184,9 +459,40 @@ List PBRf::predictCtg(const List& lDeframe,
   BEGIN_RCPP
 
     unique_ptr<PredictCtgBridge> pBridge(unwrapCtg(lDeframe, lTrain, lSampler, sYTest, lArgs));
+  if (as<bool>(lArgs["stat"]))
+    pBridge->enableStat();
+  if (as<bool>(lArgs["shareNodes"]))
+    pBridge->enableShare();
+  if (as<string>(lArgs["engine"]) != "fixed")
+    pBridge->enableAuto(as<string>(lArgs["engine"]) == "calibrate");
+  if (as<bool>(lArgs["traffic"]))
+    pBridge->enableTraffic();
+  bool shap = as<bool>(lArgs["shap"]);
+  if (shap)
+    pBridge->enableShap();
+  bool partial = enablePartial(pBridge.get(), lArgs);
+  bool localImp = as<bool>(lArgs["localImp"]);
+  if (localImp)
+    pBridge->enableLocalImp();
+  unique_ptr<LeafSinkR> leafSink(LeafSinkR::unwrap(lArgs));
+  if (leafSink)
+    pBridge->setLeafSink(leafSink.get());
+  IntegerVector yTrain(as<IntegerVector>(lSampler["yTrain"]));
+  PredictOutR out(pBridge.get(), lArgs, as<CharacterVector>(yTrain.attr("levels")).length());
   pBridge->predict();
-
-  return LeafCtgRf::summary(lDeframe, lSampler, pBridge.get(), sYTest);
+  if (leafSink)
+    leafSink->consume(pBridge.get());
+
+  List summaryCtg = LeafCtgRf::summary(lDeframe, lSampler, pBridge.get(), out, sYTest, leafSink.get());
+  if (shap)
+    summaryCtg.push_back(wrapShap(pBridge.get(), lTrain, lDeframe, yTrain.attr("levels")), "shap");
+  if (partial)
+    summaryCtg.push_back(wrapPartial(pBridge.get(), lArgs, yTrain.attr("levels")), "partial");
+  if (localImp)
+    summaryCtg.push_back(wrapLocalImp(pBridge.get(), lTrain, lDeframe, yTrain.attr("levels")), "localImp");
+  if (shap || partial || localImp)
+    summaryCtg.attr("class") = "SummaryCtg";
+  return summaryCtg;
 
   END_RCPP
 }
@@ -196,18 +502,36 @@ unique_ptr<PredictCtgBridge> PBRf::unwrapCtg(const List& lDeframe,
 					     const List& lTrain,
 					     const List& lSampler,
 					     const SEXP sYTest,
-					     const List& lArgs) {
+					     const List& lArgs,
+					     shared_ptr<RLEFrame> rleShared) {
   unique_ptr<SamplerBridge> samplerBridge(SamplerR::unwrapPredict(lSampler, lDeframe, as<bool>(lArgs["bagging"])));
   unique_ptr<LeafBridge> leafBridge(LeafR::unwrap(lTrain, samplerBridge.get()));
-  return make_unique<PredictCtgBridge>(RLEFrameR::unwrap(lDeframe),
-				       ForestRf::unwrap(lTrain),
+  unique_ptr<DenseFrame> denseFrame(rleShared ? nullptr : RLEFrameR::unwrapDense(lDeframe));
+  shared_ptr<RLEFrame> rleFrame(rleShared);
+  if (!rleFrame && !denseFrame)
+    rleFrame = RLEFrameR::unwrap(lDeframe);
+  return make_unique<PredictCtgBridge>(move(rleFrame),
+				       move(denseFrame),
+				       ForestRf::unwrap(lTrain, as<unsigned int>(lArgs["nThread"])),
 				       move(samplerBridge),
 				       move(leafBridge),
 				       ctgTest(lSampler, sYTest),
 				       as<unsigned int>(lArgs["impPermute"]),
 				       as<bool>(lArgs["ctgProb"]),
+				       as<bool>(lArgs["ctgProbSample"]),
+				       as<bool>(lArgs["census"]),
+				       as<unsigned int>(lArgs["ctgTop"]),
 				       as<bool>(lArgs["trapUnobserved"]),
-				       as<unsigned int>(lArgs["nThread"]));
+				       as<bool>(lArgs["quickScore"]),
+				       as<bool>(lArgs["binCode"]),
+				       as<bool>(lArgs["compact"]),
+				       as<bool>(lArgs["reuseRuns"]),
+				       unwrapCompiled(lArgs["compiled"]),
+				       as<unsigned int>(lArgs["nReplica"]),
+				       as<bool>(lArgs["earlyExit"]),
+				       as<double>(lArgs["exitTolerance"]),
+				       as<unsigned int>(lArgs["nThread"]),
+				       sweepVec(lArgs));
 }
 
 
@@ -224,14 +548,31 @@ vector<unsigned int> PBRf::ctgTest(const List& lSampler, const SEXP sYTest) {
 }
 
 
-List PBRf::getPrediction(const PredictRegBridge* pBridge) {
+List PBRf::getPrediction(const PredictRegBridge* pBridge,
+			 const PredictOutR& out,
+			 const LeafSinkR* leafSink) {
   BEGIN_RCPP
 
   List prediction = List::create(
-				 _["yPred"] = pBridge->getYPred(),
-				 _["qPred"] = getQPred(pBridge),
-				 _["qEst"] = pBridge->getQEst()
+				 _["yPred"] = out.yPred,
+				 _["qPred"] = out.qPred,
+				 _["qEst"] = out.qEst
 				 );
+  if (!pBridge->getJackVar().empty()) {
+    prediction["variance"] = pBridge->getJackVar();
+  }
+  const vector<double>& yMulti = pBridge->getYMulti();
+  if (!yMulti.empty()) {
+    size_t nRow = pBridge->getNRow();
+    prediction["yMulti"] = transpose(NumericMatrix(yMulti.size() / nRow, nRow, yMulti.begin()));
+  }
+  if (leafSink != nullptr) {
+    leafSink->annotate(prediction, pBridge);
+  }
+  if (pBridge->getStat() != nullptr) {
+    prediction["stat"] = wrapStat(pBridge->getStat());
+  }
+  wrapTraffic(pBridge, prediction);
   prediction.attr("class") = "PredictReg";
   return prediction;
 
@@ -239,17 +580,195 @@ List PBRf::getPrediction(const PredictRegBridge* pBridge) {
 }
 
 
-NumericMatrix PBRf::getQPred(const PredictRegBridge* pBridge) {
+List PBRf::wrapShap(const PredictBridge* pBridge,
+		     const List& lTrain,
+		     const List& lDeframe,
+		     SEXP sLevels) {
+  BEGIN_RCPP
+
+  const vector<double>& shap = pBridge->getShap();
+  const vector<double>& base = pBridge->getShapBase();
+  IntegerVector predMap((SEXP) lTrain["predMap"]);
+  R_xlen_t nRow = pBridge->getNRow();
+  R_xlen_t nPred = predMap.length();
+  R_xlen_t nOut = pBridge->getShapWidth();
+  NumericVector phi(nRow * nPred * nOut);
+  for (R_xlen_t row = 0; row < nRow; row++) {
+    for (R_xlen_t predIdx = 0; predIdx < nPred; predIdx++) {
+      for (R_xlen_t outIdx = 0; outIdx < nOut; outIdx++) {
+	phi[row + nRow * (predMap[predIdx] + nPred * outIdx)] = shap[(row * nPred + predIdx) * nOut + outIdx];
+      }
+    }
+  }
+  NumericVector baseOut(base.begin(), base.end());
+  CharacterVector colNames(Signature::unwrapColNames(lDeframe));
+  SEXP predNames = colNames.length() == nPred ? (SEXP) colNames : R_NilValue;
+  if (Rf_isNull(sLevels)) {
+    phi.attr("dim") = IntegerVector::create(nRow, nPred);
+    phi.attr("dimnames") = List::create(R_NilValue, predNames);
+  }
+  else {
+    phi.attr("dim") = IntegerVector::create(nRow, nPred, nOut);
+    phi.attr("dimnames") = List::create(R_NilValue, predNames, CharacterVector(sLevels));
+    baseOut.attr("names") = CharacterVector(sLevels);
+  }
+  return List::create(_["phi"] = phi,
+		      _["base"] = baseOut
+		      );
+
+  END_RCPP
+}
+
+
+NumericVector PBRf::wrapLocalImp(const PredictBridge* pBridge,
+				 const List& lTrain,
+				 const List& lDeframe,
+				 SEXP sLevels) {
+  BEGIN_RCPP
+
+  const vector<double>& localImp = pBridge->getLocalImp();
+  IntegerVector predMap((SEXP) lTrain["predMap"]);
+  R_xlen_t nRow = pBridge->getNRow();
+  R_xlen_t nPred = predMap.length();
+  R_xlen_t nOut = pBridge->getLocalImpWidth();
+  NumericVector imp(nRow * nPred * nOut);
+  for (R_xlen_t row = 0; row < nRow; row++) {
+    for (R_xlen_t predIdx = 0; predIdx < nPred; predIdx++) {
+      for (R_xlen_t outIdx = 0; outIdx < nOut; outIdx++) {
+	imp[row + nRow * (predMap[predIdx] + nPred * outIdx)] = localImp[(row * nPred + predIdx) * nOut + outIdx];
+      }
+    }
+  }
+  CharacterVector colNames(Signature::unwrapColNames(lDeframe));
+  SEXP predNames = colNames.length() == nPred ? (SEXP) colNames : R_NilValue;
+  if (Rf_isNull(sLevels)) {
+    imp.attr("dim") = IntegerVector::create(nRow, nPred);
+    imp.attr("dimnames") = List::create(R_NilValue, predNames);
+  }
+  else {
+    imp.attr("dim") = IntegerVector::create(nRow, nPred, nOut);
+    imp.attr("dimnames") = List::create(R_NilValue, predNames, CharacterVector(sLevels));
+  }
+  return imp;
+
+  END_RCPP
+}
+
+
+bool PBRf::enablePartial(const PredictBridge* pBridge,
+			 const List& lArgs) {
+  if (Rf_isNull(lArgs["partialPred"]))
+    return false;
+
+  IntegerVector predFE(as<IntegerVector>(lArgs["partialPred"]));
+  List gridFE(as<List>(lArgs["partialGrid"]));
+  vector<vector<double>> grid;
+  for (R_xlen_t curveIdx = 0; curveIdx < gridFE.length(); curveIdx++) {
+    grid.emplace_back(as<vector<double>>(gridFE[curveIdx]));
+  }
+  pBridge->enablePartial(vector<unsigned int>(predFE.begin(), predFE.end()), move(grid), as<bool>(lArgs["ice"]));
+  return true;
+}
+
+
+List PBRf::wrapPartial(const PredictBridge* pBridge,
+		       const List& lArgs,
+		       SEXP sLevels) {
   BEGIN_RCPP
 
-  size_t nRow(pBridge->getNRow());
-  auto qPred = pBridge->getQPred();
-  return qPred.empty() ? NumericMatrix(0) : transpose(NumericMatrix(qPred.size() / nRow, nRow, qPred.begin()));
-    
+  List gridFE(as<List>(lArgs["partialGrid"]));
+  bool ice = as<bool>(lArgs["ice"]);
+  R_xlen_t nRow = pBridge->getNRow();
+  R_xlen_t nOut = pBridge->getPartialWidth();
+  List partial(gridFE.length());
+  for (R_xlen_t curveIdx = 0; curveIdx < gridFE.length(); curveIdx++) {
+    R_xlen_t nGrid = as<NumericVector>(gridFE[curveIdx]).length();
+    vector<double> pd = pBridge->getPD(curveIdx);
+    NumericVector pdOut(nGrid * nOut);
+    for (R_xlen_t gridIdx = 0; gridIdx < nGrid; gridIdx++) {
+      for (R_xlen_t outIdx = 0; outIdx < nOut; outIdx++) {
+	pdOut[gridIdx + nGrid * outIdx] = pd[gridIdx * nOut + outIdx];
+      }
+    }
+    if (!Rf_isNull(sLevels)) {
+      pdOut.attr("dim") = IntegerVector::create(nGrid, nOut);
+      pdOut.attr("dimnames") = List::create(R_NilValue, CharacterVector(sLevels));
+    }
+
+    if (ice) {
+      const vector<double>& iceCore = pBridge->getICE(curveIdx);
+      NumericVector iceOut(nRow * nGrid * nOut);
+      for (R_xlen_t row = 0; row < nRow; row++) {
+	for (R_xlen_t gridIdx = 0; gridIdx < nGrid; gridIdx++) {
+	  for (R_xlen_t outIdx = 0; outIdx < nOut; outIdx++) {
+	    iceOut[row + nRow * (gridIdx + nGrid * outIdx)] = iceCore[(row * nGrid + gridIdx) * nOut + outIdx];
+	  }
+	}
+      }
+      if (Rf_isNull(sLevels)) {
+	iceOut.attr("dim") = IntegerVector::create(nRow, nGrid);
+      }
+      else {
+	iceOut.attr("dim") = IntegerVector::create(nRow, nGrid, nOut);
+	iceOut.attr("dimnames") = List::create(R_NilValue, R_NilValue, CharacterVector(sLevels));
+      }
+      partial[curveIdx] = List::create(_["pd"] = pdOut,
+				       _["ice"] = iceOut);
+    }
+    else {
+      partial[curveIdx] = List::create(_["pd"] = pdOut);
+    }
+  }
+  return partial;
+
   END_RCPP
 }
 
 
+List PBRf::wrapStat(const PredictStat* predictStat) {
+  BEGIN_RCPP
+  NumericVector time = NumericVector::create(
+					     _["transpose"] = predictStat->tTranspose,
+					     _["block"] = predictStat->tBlock,
+					     _["walk"] = predictStat->tWalk,
+					     _["score"] = predictStat->tScore,
+					     _["estimate"] = predictStat->tEstimate
+					     );
+  NumericVector count = NumericVector::create(
+					      _["block"] = predictStat->nBlock,
+					      _["row"] = predictStat->nRow,
+					      _["visit"] = predictStat->nVisit,
+					      _["bail"] = predictStat->nBail
+					      );
+  NumericVector depth(predictStat->depthTree.size());
+  for (R_xlen_t tIdx = 0; tIdx < depth.length(); tIdx++) {
+    depth[tIdx] = predictStat->meanDepth(tIdx);
+  }
+
+  return List::create(
+		      _["time"] = time,
+		      _["count"] = count,
+		      _["depth"] = depth,
+		      _["load"] = LoadR::wrap({"score"}, {&predictStat->load}),
+		      _["engine"] = CharacterVector::create(_["short"] = predictStat->engineShort,
+							    _["full"] = predictStat->engineFull)
+		      );
+  END_RCPP
+}
+
+
+void PBRf::wrapTraffic(const PredictBridge* pBridge,
+		       List& prediction) {
+  vector<double> drift = pBridge->getTrafficDrift();
+  if (drift.empty())
+    return;
+  vector<size_t> traffic = pBridge->getTraffic();
+  prediction["traffic"] = List::create(_["drift"] = NumericVector(drift.begin(), drift.end()),
+				       _["node"] = NumericVector(traffic.begin(), traffic.end())
+				       );
+}
+
+
 List PBRf::getValidation(const PredictRegBridge* pBridge,
 			 const NumericVector& yTestFE) {
   BEGIN_RCPP
@@ -260,6 +779,15 @@ List PBRf::getValidation(const PredictRegBridge* pBridge,
 				 _["rsq"] = nRow == 1 ? 0.0 : 1.0 - sse / (var(yTestFE) * (nRow - 1)),
 				 _["mae"] = pBridge->getSAE() / nRow
 				 );
+  const vector<unsigned int>& sweep = pBridge->getSweep();
+  if (!sweep.empty()) {
+    NumericVector mseSweep = as<NumericVector>(wrap(pBridge->getSweepSSE())) / nRow;
+    NumericVector maeSweep = as<NumericVector>(wrap(pBridge->getSweepSAE())) / nRow;
+    validation["sweep"] = List::create(_["nTree"] = IntegerVector(sweep.begin(), sweep.end()),
+				       _["mse"] = mseSweep,
+				       _["mae"] = maeSweep
+				       );
+  }
   validation.attr("class") = "ValidReg";
   return validation;
 
@@ -324,7 +852,7 @@ vector<unsigned int> TestCtg::reconcile(const IntegerVector& test2Merged,
 }
 
 
-List LeafCtgRf::summary(const List& lDeframe, const List& lSampler, const PredictCtgBridge* pBridge, SEXP sYTest) {
+List LeafCtgRf::summary(const List& lDeframe, const List& lSampler, const PredictCtgBridge* pBridge, const PredictOutR& out, SEXP sYTest, const LeafSinkR* leafSink) {
   BEGIN_RCPP
 
   IntegerVector yTrain(as<IntegerVector>(lSampler["yTrain"]));
@@ -334,20 +862,20 @@ List LeafCtgRf::summary(const List& lDeframe, const List& lSampler, const Predic
   List summaryCtg;
   if (Rf_isNull(sYTest)) {
     summaryCtg = List::create(
-			      _["prediction"] = getPrediction(pBridge, levelsTrain, ctgNames)
+			      _["prediction"] = getPrediction(pBridge, out, levelsTrain, ctgNames, leafSink)
 			      );
   }
   else {
     TestCtg testCtg(IntegerVector((SEXP) sYTest), levelsTrain);
     if (!pBridge->permutes()) {
       summaryCtg = List::create(
-			      _["prediction"] = getPrediction(pBridge, levelsTrain, ctgNames),
+			      _["prediction"] = getPrediction(pBridge, out, levelsTrain, ctgNames, leafSink),
 			      _["validation"] = testCtg.getValidation(pBridge)
 			      );
     }
     else {
       summaryCtg = List::create(
-			      _["prediction"] = getPrediction(pBridge, levelsTrain, ctgNames),
+			      _["prediction"] = getPrediction(pBridge, out, levelsTrain, ctgNames, leafSink),
 			      _["validation"] = testCtg.getValidation(pBridge),
 			      _["importance"] = testCtg.getImportance(pBridge, Signature::unwrapColNames(lDeframe))
 			      );
@@ -362,8 +890,10 @@ List LeafCtgRf::summary(const List& lDeframe, const List& lSampler, const Predic
 
 
 List LeafCtgRf::getPrediction(const PredictCtgBridge* pBridge,
+			      const PredictOutR& out,
 			      const CharacterVector& levelsTrain,
-			      const CharacterVector& ctgNames) {
+			      const CharacterVector& ctgNames,
+			      const LeafSinkR* leafSink) {
   BEGIN_RCPP
   auto yPred = pBridge->getYPred();
   IntegerVector yPredZero(yPred.begin(), yPred.end());
@@ -372,9 +902,23 @@ List LeafCtgRf::getPrediction(const PredictCtgBridge* pBridge,
   yPredOne.attr("levels") = levelsTrain;
   List prediction = List::create(
 				 _["yPred"] = yPredOne,
-				 _["census"] = getCensus(pBridge, levelsTrain, ctgNames),
-				 _["prob"] = getProb(pBridge, levelsTrain, ctgNames)
+				 _["census"] = getCensus(out, levelsTrain, ctgNames),
+				 _["prob"] = getProb(out, levelsTrain, ctgNames)
 				 );
+  if (pBridge->getTopK() > 0) {
+    prediction["top"] = getTop(pBridge, ctgNames);
+  }
+  const vector<unsigned int>& nTreeUsed = pBridge->getNTreeUsed();
+  if (!nTreeUsed.empty()) {
+    prediction["nTreeUsed"] = IntegerVector(nTreeUsed.begin(), nTreeUsed.end());
+  }
+  if (leafSink != nullptr) {
+    leafSink->annotate(prediction, pBridge);
+  }
+  if (pBridge->getStat() != nullptr) {
+    prediction["stat"] = PBRf::wrapStat(pBridge->getStat());
+  }
+  PBRf::wrapTraffic(pBridge, prediction);
   prediction.attr("class") = "PredictCtg";
   return prediction;
 
@@ -389,6 +933,12 @@ List TestCtg::getValidation(const PredictCtgBridge* pBridge) {
 			       _["misprediction"] = getMisprediction(pBridge),
 			       _["oobError"] = pBridge->getOOBError()
 			       );
+  const vector<unsigned int>& sweep = pBridge->getSweep();
+  if (!sweep.empty()) {
+    validCtg["sweep"] = List::create(_["nTree"] = IntegerVector(sweep.begin(), sweep.end()),
+				     _["misprediction"] = pBridge->getSweepMispred()
+				     );
+  }
   validCtg.attr("class") = "ValidCtg";
   return validCtg;
   
@@ -454,29 +1004,46 @@ NumericVector TestCtg::oobErrPermuted(const PredictCtgBridge* pBridge,
 }
 
 
-IntegerMatrix LeafCtgRf::getCensus(const PredictCtgBridge* pBridge,
+IntegerMatrix LeafCtgRf::getCensus(const PredictOutR& out,
                                    const CharacterVector& levelsTrain,
                                    const CharacterVector& ctgNames) {
   BEGIN_RCPP
-  IntegerMatrix census = transpose(IntegerMatrix(levelsTrain.length(), pBridge->getNRow(), pBridge->getCensus()));
-  census.attr("dimnames") = List::create(ctgNames, levelsTrain);
+  IntegerMatrix census(out.census);
+  if (census.nrow() > 0) {
+    census.attr("dimnames") = List::create(ctgNames, levelsTrain);
+  }
   return census;
   END_RCPP
 }
 
 
-NumericMatrix LeafCtgRf::getProb(const PredictCtgBridge* pBridge,
+List LeafCtgRf::getTop(const PredictCtgBridge* pBridge,
+		       const CharacterVector& ctgNames) {
+  BEGIN_RCPP
+  unsigned int topK = pBridge->getTopK();
+  vector<unsigned int> topOne(pBridge->getTopCtg());
+  for (auto & ctg : topOne) { // One-based, as factor codes.
+    ctg++;
+  }
+  IntegerMatrix ctgOut = transpose(IntegerMatrix(topK, pBridge->getNRow(), topOne.begin()));
+  NumericMatrix weightOut = transpose(NumericMatrix(topK, pBridge->getNRow(), pBridge->getTopWeight().begin()));
+  ctgOut.attr("dimnames") = List::create(ctgNames, R_NilValue);
+  weightOut.attr("dimnames") = List::create(ctgNames, R_NilValue);
+  return List::create(_["ctg"] = ctgOut,
+		      _["weight"] = weightOut);
+  END_RCPP
+}
+
+
+NumericMatrix LeafCtgRf::getProb(const PredictOutR& out,
                                  const CharacterVector& levelsTrain,
                                  const CharacterVector& ctgNames) {
   BEGIN_RCPP
-  if (!pBridge->getProb().empty()) {
-    NumericMatrix prob = transpose(NumericMatrix(levelsTrain.length(), pBridge->getNRow(), &(pBridge->getProb())[0]));
+  NumericMatrix prob(out.prob);
+  if (prob.nrow() > 0) {
     prob.attr("dimnames") = List::create(ctgNames, levelsTrain);
-    return prob;
-  }
-  else {
-    return NumericMatrix(0);
   }
+  return prob;
   END_RCPP
 }
 
@@ -30,6 +30,11 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 
+#include "predictstream.h"
+#include "proximity.h"
+
+#include <memory>
+
 
 /**
    @brief Prediction with separate test vector.
@@ -62,6 +67,121 @@ RcppExport SEXP validateRcpp(const SEXP sFrame,
 			     const SEXP sArgs);
 
 
+/**
+   @brief Prediction of several trained objects over a single frame.
+
+   @param sTrains is a list of trained objects sharing a signature.
+
+   @return list of wrapped predict objects, one per trained object.
+ */
+RcppExport SEXP predictBatchRcpp(const SEXP sFrame,
+				 const SEXP sTrains,
+				 const SEXP sArgs);
+
+
+/**
+   @brief Configures placement and idling of the persistent threads.
+
+   @param sAffinity is the placement policy:  "none", "compact" or "scatter".
+
+   @param sCpus are the eligible cpus, empty selecting those permitted.
+
+   @param sSpin is the number of polls before an idle worker sleeps.
+
+   @param sWarm is true iff the pool persists between calls.
+ */
+RcppExport SEXP rfThreadsRcpp(const SEXP sAffinity,
+			      const SEXP sCpus,
+			      const SEXP sSpin,
+			      const SEXP sWarm);
+
+
+/**
+   @brief Begins recording a timeline trace, else writes the one recorded.
+
+   @param sPath names the trace file to write, if not null.
+
+   @param sCapacity is the number of spans retained per thread.
+
+   @return number of spans written, else zero if beginning.
+ */
+RcppExport SEXP rfTraceRcpp(const SEXP sPath,
+			    const SEXP sCapacity);
+
+
+/**
+   @brief Accumulates leaf assignments streamed by the core, together
+   with their consumers.
+ */
+struct LeafSinkR : public LeafCollect {
+  const bool embed; // Whether assignments are reported.
+  unique_ptr<Proximity> proximity; // Non-null iff proximities requested.
+
+  LeafSinkR(bool embed_,
+	    unsigned int nNbr,
+	    double proxMin);
+
+
+  /**
+     @return new sink iff requested by the arguments, else null.
+   */
+  static unique_ptr<LeafSinkR> unwrap(const List& lArgs);
+
+
+  /**
+     @brief Derives consumer summaries once prediction completes.
+   */
+  void consume(const struct PredictBridge* pBridge);
+
+
+  /**
+     @brief Appends requested summaries to a prediction list.
+   */
+  void annotate(List& prediction,
+		const struct PredictBridge* pBridge) const;
+
+
+  /**
+     @return compressed-row assignments, with leaf offsets by tree.
+   */
+  List getLeaves(const struct PredictBridge* pBridge) const;
+
+
+  /**
+     @return one-based neighbour and proximity matrices, NA-padded.
+   */
+  List getProximity() const;
+};
+
+
+/**
+   @brief R-owned prediction results, allocated ahead of prediction and
+   bound to the core, which writes them in place.
+ */
+struct PredictOutR {
+  NumericVector yPred; // Per-row prediction, iff regression.
+  NumericMatrix qPred; // Row x quantile, iff quantiles requested.
+  NumericVector qEst; // Per-row estimand quantile, " ".
+  IntegerMatrix census; // Row x category votes, iff census requested.
+  NumericMatrix prob; // Row x category probabilities, iff requested.
+
+  /**
+     @brief Binds regression outputs.
+   */
+  PredictOutR(const struct PredictRegBridge* pBridge);
+
+
+  /**
+     @brief Binds classification outputs, as requested by the arguments.
+
+     @param nCtg is the training cardinality.
+   */
+  PredictOutR(const struct PredictCtgBridge* pBridge,
+	      const List& lArgs,
+	      unsigned int nCtg);
+};
+
+
 /**
    @brief Bridge-variant PredictBridge pins unwrapped front-end structures.
  */
@@ -83,17 +203,30 @@ struct PBRf {
                          const SEXP sYTest,
 			 const List& lArgs);
 
+
+  /**
+     @brief Predicts each of several trained objects over a shared frame.
+
+     @return list of per-object summaries.
+   */
+  static List predictBatch(const List& lDeframe,
+			   const List& lTrains,
+			   const List& lArgs);
+
   
   /**
      @brief Unwraps regression data structurs and moves to box.
 
+     @param rleShared is a frame shared with other models, if any.
+
      @return unique pointer to bridge-variant PredictBridge. 
    */
   static unique_ptr<struct PredictRegBridge> unwrapReg(const List& lDeframe,
 						       const List& lTrain,
 						       const List& lSampler,
 						       const SEXP sYTest,
-						       const List& lArgs);
+						       const List& lArgs,
+						       shared_ptr<struct RLEFrame> rleShared = nullptr);
 
   /**
      @brief Instantiates core prediction object and predicts quantiles.
@@ -112,25 +245,91 @@ struct PBRf {
 						       const List& lTrain,
 						       const List& lSampler,
 						       const SEXP sYTest,
-						       const List& lArgs);
+						       const List& lArgs,
+						       shared_ptr<struct RLEFrame> rleShared = nullptr);
+
 
+  /**
+     @param out holds the bound prediction results.
 
+     @param leafSink holds streamed leaf assignments, if requested.
+   */
   static List summary(const List& lDeframe,
 		      SEXP sYTest,
-                      const struct PredictRegBridge* pBridge);
+                      const struct PredictRegBridge* pBridge,
+		      const PredictOutR& out,
+		      const LeafSinkR* leafSink = nullptr);
+
+
+  static List getPrediction(const PredictRegBridge* pBridge,
+			    const PredictOutR& out,
+			    const LeafSinkR* leafSink);
 
 
   /**
-     @brief Builds a NumericMatrix representation of the quantile predictions.
-     
-     @param pBridge is the prediction handle.
+     @brief Summarizes prediction timers and counters.
 
-     @return transposed core matrix if quantiles requested, else empty matrix.
-  */
-  static NumericMatrix getQPred(const struct PredictRegBridge* pBridge);
+     @return list of times, counts and mean depth by tree.
+   */
+  static List wrapStat(const struct PredictStat* predictStat);
+
+
+  /**
+     @brief Summarizes node traffic, iff tallied.
+
+     @param[in, out] prediction receives the summary as "traffic".
+   */
+  static void wrapTraffic(const struct PredictBridge* pBridge,
+			  List& prediction);
 
 
-  static List getPrediction(const PredictRegBridge* pBridge);
+  /**
+     @brief Summarizes attributions, predictors in training order.
+
+     @param sLevels are the training categories, iff classifying.
+
+     @return list of attributions, by row and predictor, and by category
+     iff classifying, together with the expected forest output.
+   */
+  static List wrapShap(const struct PredictBridge* pBridge,
+		       const List& lTrain,
+		       const List& lDeframe,
+		       SEXP sLevels);
+
+
+  /**
+     @brief Summarizes local importance, predictors in training order.
+
+     @param sLevels are the training categories, iff classifying.
+
+     @return changes by row and predictor, and by category iff
+     classifying.
+   */
+  static NumericVector wrapLocalImp(const struct PredictBridge* pBridge,
+				    const List& lTrain,
+				    const List& lDeframe,
+				    SEXP sLevels);
+
+
+  /**
+     @brief Directs the bridge to evaluate partial dependence, iff requested.
+
+     @return true iff requested.
+   */
+  static bool enablePartial(const struct PredictBridge* pBridge,
+			    const List& lArgs);
+
+
+  /**
+     @brief Summarizes partial dependence, by curve.
+
+     @param sLevels are the training categories, iff classifying.
+
+     @return list of mean curves and, if requested, row-level curves.
+   */
+  static List wrapPartial(const struct PredictBridge* pBridge,
+			  const List& lArgs,
+			  SEXP sLevels);
 
 
   /**
@@ -172,6 +371,12 @@ private:
      @return quantile vector suitable for core.
    */
   static vector<double> quantVec(const List& lArgs);
+
+
+  /**
+     @return tree-count checkpoints suitable for core, possibly empty.
+   */
+  static vector<unsigned int> sweepVec(const List& lArgs);
   
 
   static vector<unsigned int> ctgTest(const List& lSampler,
@@ -209,7 +414,9 @@ struct LeafCtgRf {
   static List summary(const List& lDeframe,
 		      const List& lSampler,
                       const struct PredictCtgBridge* pBridge,
-                      SEXP sYTest);
+		      const PredictOutR& out,
+                      SEXP sYTest,
+		      const LeafSinkR* leafSink = nullptr);
 
 
   /**
@@ -218,9 +425,10 @@ struct LeafCtgRf {
 
      @param rowNames is the user-supplied specification of row names.
 
-     @return matrix of predicted categorical responses, by row.
+     @return matrix of predicted categorical responses, by row, if
+     requested, otherwise empty matrix.
   */
-  static IntegerMatrix getCensus(const PredictCtgBridge* pBridge,
+  static IntegerMatrix getCensus(const PredictOutR& out,
                                  const CharacterVector& levelsTrain,
                                  const CharacterVector& rowNames);
 
@@ -230,14 +438,25 @@ struct LeafCtgRf {
 
      @return probability matrix if requested, otherwise empty matrix.
   */
-  static NumericMatrix getProb(const PredictCtgBridge* pBridge,
+  static NumericMatrix getProb(const PredictOutR& out,
                                const CharacterVector& levelsTrain,
                                const CharacterVector &rowNames);
 
+
+  /**
+     @brief Summarizes the leading categories of each row.
+
+     @return list of one-based category and weight matrices, by row.
+  */
+  static List getTop(const PredictCtgBridge* pBridge,
+		     const CharacterVector& rowNames);
+
   
   static List getPrediction(const PredictCtgBridge* pBridge,
+			    const PredictOutR& out,
 			    const CharacterVector& levelsTrain,
-			    const CharacterVector& ctgNames);
+			    const CharacterVector& ctgNames,
+			    const LeafSinkR* leafSink);
 };
 
 
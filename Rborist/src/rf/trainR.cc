@@ -26,6 +26,7 @@
 #include "forestbridge.h"
 #include "samplerbridge.h"
 #include "leafbridge.h"
+#include "modelbridge.h"
 #include "trainR.h"
 #include "trainbridge.h"
 #include "samplerR.h"
@@ -33,9 +34,30 @@
 #include "forestR.h"
 #include "rleframeR.h"
 #include "rleframe.h"
+#include "trainstat.h"
+#include "trainfootprint.h"
+#include "loadR.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
 
 bool TrainRf::verbose = false;
 
+
+namespace {
+  /**
+     @brief Chunk under training, with the bridges receiving its output.
+   */
+  struct ChunkTask {
+    unsigned int treeOff; // Absolute index of leading tree.
+    unsigned int nTree; // # trees in chunk.
+    unique_ptr<ForestBridge> fb;
+    unique_ptr<LeafBridge> lb;
+    future<unique_ptr<TrainedChunk>> trained; // Joins on destruction, so follows bridges.
+  };
+}
+
 RcppExport SEXP rfTrain(const SEXP sDeframe, const SEXP sSampler, const SEXP sArgList) {
   BEGIN_RCPP
 
@@ -45,30 +67,113 @@ RcppExport SEXP rfTrain(const SEXP sDeframe, const SEXP sSampler, const SEXP sAr
 }
 
 
+RcppExport SEXP rfTrainSweep(const SEXP sDeframe, const SEXP sSampler, const SEXP sArgList) {
+  BEGIN_RCPP
+
+  return TrainRf::trainSweep(List(sDeframe), List(sSampler), List(sArgList));
+
+  END_RCPP
+}
+
+
+RcppExport SEXP rfFootprint(const SEXP sDeframe, const SEXP sSampler, const SEXP sArgList, const SEXP sBudget) {
+  BEGIN_RCPP
+
+  List argList(sArgList);
+  unique_ptr<FrameCache> frameLocal;
+  const FrameCache* frameCache = TrainRf::cacheFrame(List(sDeframe), argList, frameLocal);
+  unique_ptr<SamplerBridge> sb(SamplerR::unwrapTrain(List(sSampler), argList));
+  TrainBridge trainBridge(frameCache);
+  TrainRf::initFromArgs(argList, &trainBridge);
+  if (as<double>(argList["boostRate"]) > 0.0) {
+    trainBridge.initBoost(sb.get(), as<double>(argList["boostRate"]));
+  }
+
+  // One chunk is consumed while its successor trains.
+  TrainFootprint footprint = trainBridge.estimateFootprint(sb.get(), TrainRf::treeChunk, 2);
+  TrainBridge::deInit();
+  size_t budget = static_cast<size_t>(as<double>(sBudget) * 1024 * 1024);
+  unsigned int nThread = as<unsigned int>(argList["nThread"]);
+  if (nThread == 0) {
+    nThread = thread::hardware_concurrency();
+  }
+  unsigned int nConcurrent = budget == 0 ? footprint.nConcurrent : footprint.recommendConcurrent(budget, nThread);
+  List perTree = List::create(_["obsPart"] = static_cast<double>(footprint.obsPart),
+			      _["history"] = static_cast<double>(footprint.history),
+			      _["sampled"] = static_cast<double>(footprint.sampled),
+			      _["preTree"] = static_cast<double>(footprint.preTree));
+  return List::create(_["frame"] = static_cast<double>(footprint.frame),
+		      _["perTree"] = perTree,
+		      _["chunk"] = static_cast<double>(footprint.chunk),
+		      _["total"] = static_cast<double>(footprint.getTotal()),
+		      _["treeBlock"] = nConcurrent,
+		      _["nThread"] = min(nThread, max(nConcurrent, 1u)));
+
+  END_RCPP
+}
+
+
 List TrainRf::train(const List& lDeframe, const List& lSampler, const List& argList) {
   BEGIN_RCPP
 
-  return train(argList, SamplerR::unwrapTrain(lSampler, argList), RLEFrameR::unwrap(lDeframe).get());
+  unique_ptr<FrameCache> frameLocal;
+  const FrameCache* frameCache = cacheFrame(lDeframe, argList, frameLocal);
+  return train(argList, SamplerR::unwrapTrain(lSampler, argList), frameCache);
 
   END_RCPP
 }
 
 
+const FrameCache* TrainRf::cacheFrame(const List& lDeframe,
+				      const List& argList,
+				      unique_ptr<FrameCache>& frameLocal) {
+  double autoCompress = as<double>(argList["autoCompress"]);
+  bool enableCoproc = as<bool>(argList["enableCoproc"]);
+  bool packRanks = as<bool>(argList["packRanks"]);
+  if (!lDeframe.containsElementNamed("frameCache")) {
+    frameLocal = make_unique<FrameCache>(RLEFrameR::unwrap(lDeframe), autoCompress, enableCoproc, packRanks);
+    return frameLocal.get();
+  }
+
+  // Handles do not survive serialization, so may be null.
+  Environment cacheEnv((SEXP) lDeframe["frameCache"]);
+  if (cacheEnv.exists("handle")) {
+    XPtr<FrameCache> handle((SEXP) cacheEnv.get("handle"));
+    if (handle.get() != nullptr && handle->conforms(autoCompress, enableCoproc, packRanks)) {
+      return handle.get();
+    }
+  }
+
+  XPtr<FrameCache> handle(new FrameCache(RLEFrameR::unwrap(lDeframe), autoCompress, enableCoproc, packRanks), true);
+  cacheEnv.assign("handle", handle);
+  return handle.get();
+}
+
+
 List TrainRf::train(const List& argList,
 		    unique_ptr<SamplerBridge> sb,
-		    const RLEFrame* rleFrame) {
+		    const FrameCache* frameCache) {
   BEGIN_RCPP
 
   if (verbose) {
     Rcout << "Beginning training" << endl;
   }
-  vector<string> diag;
-  unique_ptr<TrainBridge> trainBridge(make_unique<TrainBridge>(rleFrame, as<double>(argList["autoCompress"]), as<bool>(argList["enableCoproc"]), diag));
+  vector<string> diag(frameCache->getDiag());
+  unique_ptr<TrainBridge> trainBridge(make_unique<TrainBridge>(frameCache));
   initFromArgs(argList, trainBridge.get());
+  if (as<bool>(argList["trackOOB"])) {
+    trainBridge->initOOB(sb.get());
+  }
+  if (as<double>(argList["boostRate"]) > 0.0) {
+    trainBridge->initBoost(sb.get(), as<double>(argList["boostRate"]));
+  }
 
   TrainRf trainRf(sb.get());
-  trainRf.trainChunks(sb.get(), trainBridge.get(), as<bool>(argList["thinLeaves"]));
-  List outList = trainRf.summarize(trainBridge.get(), diag);
+  trainRf.initStream(argList);
+  trainRf.fitBudget(argList, sb.get(), trainBridge.get(), diag);
+  trainRf.initCheckpoint(argList);
+  trainRf.trainChunks(sb.get(), trainBridge.get(), as<bool>(argList["thinLeaves"]), as<unsigned int>(argList["stopWindow"]), as<double>(argList["stopTolerance"]));
+  List outList = trainRf.summarize(trainBridge.get(), sb.get(), diag);
 
   if (verbose) {
     Rcout << "Training completed" << endl;
@@ -94,7 +199,7 @@ SEXP TrainRf::initFromArgs(const List& argList,
   verbose = as<bool>(argList["verbose"]);
   NumericVector probVecNV((SEXP) argList["probVec"]);
   vector<double> predProb(as<vector<double> >(probVecNV[predMap]));
-  trainBridge->initProb(as<unsigned int>(argList["predFixed"]), predProb);
+  trainBridge->initProb(as<unsigned int>(argList["predFixed"]), predProb, as<bool>(argList["predAlias"]));
 
   NumericVector splitQuantNV((SEXP) argList["splitQuant"]);
   vector<double> splitQuant(as<vector<double> >(splitQuantNV[predMap]));
@@ -104,14 +209,29 @@ SEXP TrainRf::initFromArgs(const List& argList,
 			 splitQuant);
 
   trainBridge->initTree(as<unsigned int>(argList["maxLeaf"]));
-  trainBridge->initBlock(as<unsigned int>(argList["treeBlock"]));
+  trainBridge->initPrune(as<double>(argList["pruneCost"]));
+  trainBridge->initHistory(static_cast<size_t>(as<double>(argList["historyBudget"]) * 1024 * 1024));
+  trainBridge->initExtraTrees(as<bool>(argList["extraTrees"]));
+  trainBridge->initBlock(as<unsigned int>(argList["treeBlock"]),
+			 as<unsigned int>(argList["treeThread"]),
+			 as<bool>(argList["levelSync"]));
   trainBridge->initOmp(as<unsigned int>(argList["nThread"]));
+  trainBridge->initStream(as<size_t>(argList["treeOffset"]));
+  trainBridge->initBin(as<unsigned int>(argList["nBin"]));
+  trainBridge->initSubtree(as<size_t>(argList["subtreeMax"]));
+  trainBridge->initSketch(as<unsigned int>(argList["nCut"]));
+  trainBridge->initScreen(as<unsigned int>(argList["screenTrees"]),
+			  as<double>(argList["screenWeight"]));
   
   if (!Rf_isFactor((SEXP) argList["y"])) {
     NumericVector regMonoNV((SEXP) argList["regMono"]);
     vector<double> regMono(as<vector<double> >(regMonoNV[predMap]));
     trainBridge->initMono(regMono);
   }
+  if (argList.containsElementNamed("yMulti") && !Rf_isNull(argList["yMulti"])) {
+    NumericMatrix yMulti((SEXP) argList["yMulti"]);
+    trainBridge->initMulti(vector<double>(yMulti.begin(), yMulti.end()), yMulti.ncol());
+  }
 
   END_RCPP
 }
@@ -128,8 +248,17 @@ SEXP TrainRf::deInit(TrainBridge* trainBridge) {
 
 void TrainRf::consume(const ForestBridge& fb,
 		      const LeafBridge* lb,
+		      const SamplerBridge* sb,
                       unsigned int treeOff,
                       unsigned int chunkSize) const {
+  if (modelStream != nullptr) {
+    modelStream->consume(fb, lb, sb, treeOff);
+    if (verbose) {
+      Rcout << treeOff + chunkSize << " trees streamed" << endl;
+    }
+    return;
+  }
+
   double scale = safeScale(treeOff + chunkSize);
   forest->bridgeConsume(fb, treeOff, scale);
   leaf->bridgeConsume(lb, scale);
@@ -148,19 +277,81 @@ void TrainRf::consumeInfo(const TrainedChunk* train) {
   else {
     predInfo = predInfo + infoChunk;
   }
+  trainStat->accum(train->getTrainStat());
 }
 
 
 List TrainRf::summarize(const TrainBridge* trainBridge,
+			const SamplerBridge* sb,
 			const vector<string>& diag) const {
   BEGIN_RCPP
-  return List::create(
+  List summary = List::create(
                       _["predInfo"] = scaleInfo(trainBridge),
                       _["diag"] = diag,
-                      _["forest"] = move(forest->wrap()),
+                      _["forest"] = modelStream == nullptr ? SEXP(forest->wrap()) : R_NilValue,
 		      _["predMap"] = move(trainBridge->getPredMap()),
-		      _["leaf"] = move(leaf->wrap())
+		      _["leaf"] = modelStream == nullptr ? SEXP(leaf->wrap()) : R_NilValue,
+		      _["nTree"] = nTrained,
+		      _["nBag"] = sb->getBagTotal(nTrained)
                       );
+  const HistoryStat& historyStat = trainStat->history;
+  summary["history"] = List::create(
+				    _["depthMax"] = historyStat.depthMax,
+				    _["footprintMax"] = static_cast<double>(historyStat.footprintMax),
+				    _["stageMax"] = static_cast<double>(historyStat.stageMax),
+				    _["occupancyMin"] = historyStat.occupancyMin,
+				    _["flushPath"] = static_cast<double>(historyStat.flushPath),
+				    _["flushSparse"] = static_cast<double>(historyStat.flushSparse),
+				    _["flushBudget"] = static_cast<double>(historyStat.flushBudget)
+				    );
+  summary["stat"] = wrapStat();
+  if (trainBridge->hasOOB()) {
+    summary["oob"] = List::create(
+				  _["error"] = trainBridge->getOOBError(),
+				  _["curve"] = trainBridge->getOOBCurve()
+				  );
+  }
+  return summary;
+  END_RCPP
+}
+
+
+List TrainRf::wrapStat() const {
+  BEGIN_RCPP
+  NumericVector time = NumericVector::create(
+					     _["tree"] = trainStat->tTree,
+					     _["repartition"] = trainStat->tRepartition,
+					     _["restage"] = trainStat->tRestage,
+					     _["split"] = trainStat->tSplit,
+					     _["update"] = trainStat->tUpdate,
+					     _["overlap"] = trainStat->tOverlap,
+					     _["consume"] = trainStat->tConsume,
+					     _["leaf"] = trainStat->tLeaf,
+					     _["subtree"] = trainStat->tSubtree
+					     );
+  NumericVector count = NumericVector::create(
+					      _["tree"] = trainStat->nTree,
+					      _["level"] = trainStat->nLevel,
+					      _["candidate"] = trainStat->nCand,
+					      _["scanned"] = trainStat->nScanned,
+					      _["restaged"] = trainStat->nRestaged,
+					      _["subtree"] = trainStat->nSubtree
+					      );
+  NumericVector occupancy(trainStat->occupancySum.size());
+  for (R_xlen_t level = 0; level < occupancy.length(); level++) {
+    size_t nTreeLevel = trainStat->occupancyCount[level];
+    occupancy[level] = nTreeLevel == 0 ? NA_REAL : trainStat->occupancySum[level] / nTreeLevel;
+  }
+
+  NumericMatrix load = LoadR::wrap({"stage", "restage", "split", "update", "leaf", "subtree"},
+				   {&trainStat->loadStage, &trainStat->loadRestage, &trainStat->loadSplit, &trainStat->loadUpdate, &trainStat->loadLeaf, &trainStat->loadSubtree});
+
+  return List::create(
+		      _["time"] = time,
+		      _["count"] = count,
+		      _["occupancy"] = occupancy,
+		      _["load"] = load
+		      );
   END_RCPP
 }
 
@@ -173,7 +364,7 @@ NumericVector TrainRf::scaleInfo(const TrainBridge* trainBridge) const {
   IntegerVector predMap(pm.begin(), pm.end());
 
   // Mapbs back from core order and scales info per-tree.
-  return as<NumericVector>(predInfo[predMap]) / nTree;
+  return as<NumericVector>(predInfo[predMap]) / nTrained;
 
   END_RCPP
 }
@@ -181,20 +372,246 @@ NumericVector TrainRf::scaleInfo(const TrainBridge* trainBridge) const {
 
 TrainRf::TrainRf(const SamplerBridge* sb) :
   nTree(sb->getNTree()),
+  nTrained(0),
   leaf(make_unique<LeafR>()),
-  forest(make_unique<FBTrain>(sb->getNTree())) {
+  forest(make_unique<FBTrain>(sb->getNTree())),
+  trainStat(make_unique<TrainStat>()),
+  checkpointChunks(0) {
+}
+
+
+void TrainRf::initStream(const List& argList) {
+  if (argList.containsElementNamed("modelPath") && !Rf_isNull(argList["modelPath"])) {
+    modelStream = make_unique<ModelStreamBridge>(as<string>(argList["modelPath"]), as<bool>(argList["thinLeaves"]));
+  }
+}
+
+
+void TrainRf::fitBudget(const List& argList,
+			const SamplerBridge* sb,
+			TrainBridge* trainBridge,
+			vector<string>& diag) const {
+  if (!argList.containsElementNamed("memBudget") || as<double>(argList["memBudget"]) <= 0.0)
+    return;
+
+  size_t budget = static_cast<size_t>(as<double>(argList["memBudget"]) * 1024 * 1024);
+  // Unstreamed chunks are all live by the end of training.
+  unsigned int nChunkLive = modelStream == nullptr ? (nTree + treeChunk - 1) / treeChunk + 1 : 2;
+  if (modelStream == nullptr && trainBridge->estimateFootprint(sb, treeChunk, nChunkLive).getTotal() > budget
+      && trainBridge->estimateFootprint(sb, treeChunk, 2).getTotal() <= budget) {
+    stop("Memory budget admits training only if chunks spill:  specify modelPath");
+  }
+  for (const string& concession : trainBridge->fitBudget(sb, treeChunk, nChunkLive, budget)) {
+    if (verbose) {
+      Rcout << "Memory budget:  " << concession << endl;
+    }
+    diag.push_back("Memory budget:  " + concession);
+  }
+}
+
+
+void TrainRf::initCheckpoint(const List& argList) {
+  if (argList.containsElementNamed("checkpoint") && !Rf_isNull(argList["checkpoint"])) {
+    checkpointFn = (SEXP) argList["checkpoint"];
+    checkpointChunks = as<unsigned int>(argList["checkpointChunks"]);
+  }
+  if (argList.containsElementNamed("resume")) {
+    resumeState = (SEXP) argList["resume"];
+  }
+}
+
+
+uint64_t TrainRf::restore() {
+  List state(resumeState);
+  nTrained = as<unsigned int>(state["nTrained"]);
+  forest->restore(List((SEXP) state["forest"]));
+  leaf->restore(List((SEXP) state["leaf"]));
+  predInfo = clone(NumericVector((SEXP) state["predInfo"]));
+  NumericVector seed((SEXP) state["seed"]);
+  return (static_cast<uint64_t>(seed[0]) << 32) | static_cast<uint64_t>(seed[1]);
+}
+
+
+void TrainRf::checkpoint(uint64_t seed) const {
+  List state = List::create(_["nTrained"] = nTrained,
+			    _["seed"] = NumericVector::create(static_cast<double>(seed >> 32), static_cast<double>(seed & 0xffffffffull)),
+			    _["predInfo"] = predInfo,
+			    _["forest"] = forest->snapshot(nTrained),
+			    _["leaf"] = leaf->snapshot()
+			    );
+  Function persist(checkpointFn);
+  persist(state);
+  if (verbose) {
+    Rcout << "Checkpointed " << nTrained << " trees" << endl;
+  }
 }
 
 
 void TrainRf::trainChunks(const SamplerBridge* sb,
 			  const TrainBridge* trainBridge,
-			  bool thinLeaves) {
-  for (unsigned int treeOff = 0; treeOff < nTree; treeOff += treeChunk) {
-    auto chunkThis = treeOff + treeChunk > nTree ? nTree - treeOff : treeChunk;
-    ForestBridge fb(chunkThis);
-    unique_ptr<LeafBridge> lb = LeafBridge::FactoryTrain(sb, thinLeaves);
-    auto trainedChunk = trainBridge->train(fb, sb, treeOff, chunkThis, lb.get());
-    consume(fb, lb.get(), treeOff, chunkThis);
+			  bool thinLeaves,
+			  unsigned int stopWindow,
+			  double stopTolerance) {
+  // Sizes known or bounded in advance supplant growth estimates.
+  if (modelStream == nullptr) {
+    if (!thinLeaves) {
+      leaf->reserve(sb->getBagTotal(nTree), trainBridge->getLeafBound(sb, nTree));
+    }
+    forest->setNodeBound(trainBridge->getNodeBound(sb, nTree));
+  }
+
+  // Launches training of a chunk off the master thread, which alone
+  // may call into R.  The stream key is therefore drawn beforehand,
+  // once per session, so that chunks key their trees identically.
+  auto launchChunk = [&](unsigned int treeOff,
+			 uint64_t seed) {
+    auto chunk = make_unique<ChunkTask>();
+    chunk->treeOff = treeOff;
+    chunk->nTree = treeOff + treeChunk > nTree ? nTree - treeOff : treeChunk;
+    chunk->fb = make_unique<ForestBridge>(chunk->nTree);
+    chunk->lb = LeafBridge::FactoryTrain(sb, thinLeaves);
+    const ForestBridge* fb = chunk->fb.get();
+    const LeafBridge* lb = chunk->lb.get();
+    unsigned int chunkThis = chunk->nTree;
+    chunk->trained = async(launch::async, [=]() {
+      return trainBridge->train(*fb, sb, treeOff, chunkThis, lb, seed);
+    });
+    return chunk;
+  };
+
+  // A resumed session continues under the key of the interrupted one.
+  uint64_t seed = Rf_isNull(resumeState) ? TrainBridge::drawSeed() : restore();
+  unsigned int nSinceCheckpoint = 0;
+
+  // Chunk k + 1 trains while chunk k is copied out.  The stopping test
+  // reads out-of-bag state, so precedes launch of the successor.
+  unique_ptr<ChunkTask> pending = launchChunk(nTrained, seed);
+  while (pending != nullptr) {
+    unique_ptr<TrainedChunk> trainedChunk = pending->trained.get();
+    unique_ptr<ChunkTask> current = move(pending);
+    nTrained = current->treeOff + current->nTree;
+    if (nTrained < nTree && !(stopWindow > 0 && trainBridge->oobPlateau(stopWindow * treeChunk, stopTolerance))) {
+      pending = launchChunk(nTrained, seed);
+    }
+    consume(*current->fb, current->lb.get(), sb, current->treeOff, current->nTree);
     consumeInfo(trainedChunk.get());
+    if (pending != nullptr && !Rf_isNull(checkpointFn) && ++nSinceCheckpoint == checkpointChunks) {
+      checkpoint(seed);
+      nSinceCheckpoint = 0;
+    }
+  }
+  trimTrained(sb);
+}
+
+
+void TrainRf::trimTrained(const SamplerBridge* sb) {
+  if (nTrained < nTree && verbose) {
+    Rcout << "Out-of-bag error levelled off after " << nTrained << " trees" << endl;
   }
+  if (modelStream != nullptr) {
+    modelStream->write(sb);
+    return;
+  }
+
+  if (nTrained < nTree) {
+    forest->trim(nTrained);
+  }
+  leaf->trim(); // Extents are allocated to their bound.
+}
+
+
+List TrainRf::trainSweep(const List& lDeframe,
+			 const List& lSampler,
+			 const List& lArgList) {
+  BEGIN_RCPP
+
+  // Process-wide options are common to all sessions.
+  List argLead(lArgList[0]);
+  verbose = as<bool>(argLead["verbose"]);
+  if (verbose) {
+    Rcout << "Beginning training of " << lArgList.length() << " configurations" << endl;
+  }
+  unique_ptr<FrameCache> frameLocal;
+  const FrameCache* frameCache = cacheFrame(lDeframe, argLead, frameLocal);
+
+  // Sessions share the frame but own their parameters and samplers.
+  vector<unique_ptr<SamplerBridge>> sb;
+  vector<unique_ptr<TrainBridge>> trainBridge;
+  vector<unique_ptr<TrainRf>> trainRf;
+  for (R_xlen_t sessionIdx = 0; sessionIdx < lArgList.length(); sessionIdx++) {
+    List argList(lArgList[sessionIdx]);
+    sb.push_back(SamplerR::unwrapTrain(List(lSampler[sessionIdx]), argList));
+    trainBridge.push_back(make_unique<TrainBridge>(frameCache));
+    initFromArgs(argList, trainBridge.back().get());
+    if (as<bool>(argList["trackOOB"])) {
+      trainBridge.back()->initOOB(sb.back().get());
+    }
+    if (as<double>(argList["boostRate"]) > 0.0) {
+      trainBridge.back()->initBoost(sb.back().get(), as<double>(argList["boostRate"]));
+    }
+    trainRf.push_back(make_unique<TrainRf>(sb.back().get()));
+    trainRf.back()->initStream(argList);
+  }
+
+  // Keys are drawn once per session, so that chunks key their trees
+  // as would a lone, unchunked session.
+  vector<uint64_t> seed;
+  for (size_t sessionIdx = 0; sessionIdx < trainRf.size(); sessionIdx++) {
+    seed.push_back(TrainBridge::drawSeed());
+  }
+
+  vector<bool> live(trainRf.size(), true);
+  for (unsigned int treeOff = 0; find(live.begin(), live.end(), true) != live.end(); treeOff += treeChunk) {
+    vector<size_t> liveIdx;
+    vector<unique_ptr<ForestBridge>> fb;
+    vector<unique_ptr<LeafBridge>> lb;
+    vector<const TrainBridge*> tbLive;
+    vector<const ForestBridge*> fbLive;
+    vector<const SamplerBridge*> sbLive;
+    vector<const LeafBridge*> lbLive;
+    vector<unsigned int> chunkThis;
+    vector<uint64_t> seedLive;
+    for (size_t sessionIdx = 0; sessionIdx < trainRf.size(); sessionIdx++) {
+      if (!live[sessionIdx])
+	continue;
+      unsigned int nTree = trainRf[sessionIdx]->nTree;
+      liveIdx.push_back(sessionIdx);
+      chunkThis.push_back(treeOff + treeChunk > nTree ? nTree - treeOff : treeChunk);
+      fb.push_back(make_unique<ForestBridge>(chunkThis.back()));
+      lb.push_back(LeafBridge::FactoryTrain(sb[sessionIdx].get(), as<bool>(List(lArgList[sessionIdx])["thinLeaves"])));
+      tbLive.push_back(trainBridge[sessionIdx].get());
+      fbLive.push_back(fb.back().get());
+      sbLive.push_back(sb[sessionIdx].get());
+      lbLive.push_back(lb.back().get());
+      seedLive.push_back(seed[sessionIdx]);
+    }
+
+    vector<unique_ptr<TrainedChunk>> trained = TrainBridge::train(tbLive, fbLive, sbLive, treeOff, chunkThis, lbLive, seedLive);
+    for (size_t liveOff = 0; liveOff < liveIdx.size(); liveOff++) {
+      size_t sessionIdx = liveIdx[liveOff];
+      TrainRf* session = trainRf[sessionIdx].get();
+      session->consume(*fb[liveOff], lb[liveOff].get(), sb[sessionIdx].get(), treeOff, chunkThis[liveOff]);
+      session->consumeInfo(trained[liveOff].get());
+      session->nTrained = treeOff + chunkThis[liveOff];
+      List argList(lArgList[sessionIdx]);
+      unsigned int stopWindow = as<unsigned int>(argList["stopWindow"]);
+      if (session->nTrained == session->nTree || (stopWindow > 0 && trainBridge[sessionIdx]->oobPlateau(stopWindow * treeChunk, as<double>(argList["stopTolerance"])))) {
+	live[sessionIdx] = false;
+      }
+    }
+  }
+
+  List outList(trainRf.size());
+  for (size_t sessionIdx = 0; sessionIdx < trainRf.size(); sessionIdx++) {
+    trainRf[sessionIdx]->trimTrained(sb[sessionIdx].get());
+    outList[sessionIdx] = trainRf[sessionIdx]->summarize(trainBridge[sessionIdx].get(), sb[sessionIdx].get(), frameCache->getDiag());
+  }
+  if (verbose) {
+    Rcout << "Training completed" << endl;
+  }
+
+  deInit(trainBridge.front().get());
+  return outList;
+
+  END_RCPP
 }
@@ -43,6 +43,25 @@ RcppExport SEXP rfTrain(const SEXP sRLEFrame,
 			const SEXP sArgList);
 
 
+/**
+   @brief Entry for concurrent training of several configurations.
+ */
+RcppExport SEXP rfTrainSweep(const SEXP sRLEFrame,
+			     const SEXP sSampler,
+			     const SEXP sArgList);
+
+
+/**
+   @brief Estimates the memory footprint of a training session.
+
+   @param sBudget is the memory budget in megabytes, zero for none.
+ */
+RcppExport SEXP rfFootprint(const SEXP sRLEFrame,
+			    const SEXP sSampler,
+			    const SEXP sArgList,
+			    const SEXP sBudget);
+
+
 struct TrainRf {
 
   // Training granularity.  Values guesstimated to minimize footprint of
@@ -53,9 +72,15 @@ struct TrainRf {
   static bool verbose; // Whether to report progress while training.
 
   const unsigned int nTree; // # trees under training.
+  unsigned int nTrained; // # trees actually trained.
   unique_ptr<struct LeafR> leaf; // Summarizes sample-to-leaf mapping.
   unique_ptr<struct FBTrain> forest; // Pointer to core forest.
   NumericVector predInfo; // Forest-wide sum of predictors' split information.
+  unique_ptr<struct TrainStat> trainStat; // Per-phase instrumentation.
+  unique_ptr<struct ModelStreamBridge> modelStream; // Model file sink, if streaming.
+  RObject checkpointFn; // Front-end closure persisting a snapshot, else nil.
+  unsigned int checkpointChunks; // # chunks consumed between checkpoints.
+  RObject resumeState; // Snapshot from which to resume, else nil.
 
 
   /**
@@ -64,9 +89,79 @@ struct TrainRf {
   TrainRf(const struct SamplerBridge* sb);
 
 
+  /**
+     @brief Trains chunks of trees until done or out-of-bag error levels off.
+
+     Training of each chunk overlaps copying out of its predecessor.
+
+     @param stopWindow is the number of chunks over which out-of-bag
+     error is averaged, else zero to train all trees.
+
+     @param stopTolerance is the relative improvement between trailing
+     windows below which to stop.
+   */
   void trainChunks(const struct SamplerBridge* sb,
 		   const struct TrainBridge* tb,
-		   bool thinLeaves);
+		   bool thinLeaves,
+		   unsigned int stopWindow,
+		   double stopTolerance);
+
+
+  /**
+     @brief Diverts trained chunks to a model file, in place of the
+     front-end forest and leaf.
+
+     @param argList supplies the file path, if any.
+   */
+  void initStream(const List& argList);
+
+
+  /**
+     @brief Reads the checkpointing closure and resumption state, if any.
+   */
+  void initCheckpoint(const List& argList);
+
+
+  /**
+     @brief Adjusts the session to train within the memory budget, if any.
+
+     Chunks accumulate in the front end unless streamed, so streaming
+     must have been initialized.
+
+     @param[out] diag accumulates the concessions made.
+   */
+  void fitBudget(const List& argList,
+		 const struct SamplerBridge* sb,
+		 struct TrainBridge* trainBridge,
+		 vector<string>& diag) const;
+
+
+  /**
+     @brief Reinstates the trees, leaves and information of a snapshot.
+
+     @return stream key of the interrupted session.
+   */
+  uint64_t restore();
+
+
+  /**
+     @brief Hands a snapshot of the consumed chunks to the front end.
+
+     Out-of-bag and boosting state are not captured, so the front end
+     precludes checkpointing sessions which employ them.  Errors
+     raised by the closure propagate to the session's entry point.
+
+     @param seed is the session's stream key, common to all chunks.
+   */
+  void checkpoint(uint64_t seed) const;
+
+
+  /**
+     @brief Shrinks the forest and leaf buffers, if stopped early.
+
+     Writes the model file, if streaming.
+   */
+  void trimTrained(const struct SamplerBridge* sb);
 
 
   /**
@@ -115,24 +210,59 @@ struct TrainRf {
    */
   static List train(const List& argList,
 		    unique_ptr<struct SamplerBridge> sb,
-                    const struct RLEFrame* rleFrame);
+                    const struct FrameCache* frameCache);
+
+
+  /**
+     @brief Trains several sessions together over a shared frame.
+
+     Tree tasks of all sessions are interleaved, chunk by chunk.  Frame
+     options, thread count and verbosity are taken from the leading
+     session.
+
+     @param lSampler lists the per-session samplers.
+
+     @param lArgList lists the per-session argument lists.
+
+     @return list of per-session summaries, as returned by 'train'.
+   */
+  static List trainSweep(const List& lDeframe,
+			 const List& lSampler,
+			 const List& lArgList);
+
+
+  /**
+     @brief Looks up the frame cached by the deframed list, if any,
+     rebuilding it when absent or built under other parameters.
+
+     @param[out] frameLocal holds an uncached frame for the session.
+
+     @return frame cache applicable to the training session.
+   */
+  static const struct FrameCache* cacheFrame(const List& lDeframe,
+					     const List& argList,
+					     unique_ptr<struct FrameCache>& frameLocal);
 
   
   /**
      @brief Consumes core representation of a trained tree for writing.
 
+     Chunks are copied to the front end, else staged for the model file.
+
      @unsigned int tIdx is the absolute tree index.
 
      @param scale guesstimates a reallocation size.
    */
   void consume(const struct ForestBridge& fb,
 	       const struct LeafBridge* lb,
+	       const struct SamplerBridge* sb,
                unsigned int tIdx,
                unsigned int chunkSize) const;
 
 
   /**
-     @brief As above, but consumes information vector.
+     @brief As above, but consumes information vector and
+     instrumentation.
    */
   void consumeInfo(const struct TrainedChunk* train);
 
@@ -144,7 +274,15 @@ struct TrainRf {
 
      @return the summary.
    */
+  /**
+     @brief Packages instrumentation as per-phase timings, counts and
+     per-level history occupancy.
+   */
+  List wrapStat() const;
+
+
   List summarize(const TrainBridge* trainBridge,
+		 const struct SamplerBridge* sb,
 		 const vector<string>& diag) const;
 
   
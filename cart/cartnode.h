@@ -66,15 +66,6 @@ struct CartNode : public TreeNode {
 			unsigned int tIdx) const {
     return isTerminal() ? 0 : TreeNode::advanceFactor(factorBits, rowT, tIdx);
   }
-
-
-  inline IndexT advance(const class Predict* predict,
-			const vector<unique_ptr<class BV>>& factorBits,
-			const CtgT* rowFT,
-			const double *rowNT,
-			unsigned int tIdx) const {
-    return isTerminal() ? 0 : TreeNode::advanceMixed(predict, factorBits, rowFT, rowNT, tIdx);
-  }
 };
 
 #endif
@@ -30,6 +30,7 @@ void CutAccumRegCart::split(const SFRegCart* spReg,
 			    SplitNux& cand) {
   CutAccumRegCart cutAccum(cand, spReg);
   cand.setInfo(cutAccum.splitReg(spReg, cand));
+  cutAccum.routeMissing(cand);
   spReg->writeCut(cand, cutAccum);
 }
 
@@ -55,6 +56,46 @@ double CutAccumRegCart::splitReg(const SFRegCart* spReg,
 
 
 void CutAccumRegCart::splitRL(IndexT idxStart, IndexT idxEnd) {
+  if (runScan) {
+    splitRLScalar(idxStart, idxEnd);
+    return;
+  }
+  if (sketched(idxStart, idxEnd)) {
+    splitRLSketch(idxStart, idxEnd);
+    return;
+  }
+  double sumBlock[scanBlock];
+  double sCountBlock[scanBlock];
+  bool cutBlock[scanBlock];
+  double infoBlock[scanBlock];
+  const double sumTot = sumCount.sum;
+  const double sCountTot = sumCount.sCount;
+  for (IndexT idx = idxEnd - 1; idx > idxStart + scanBlock; idx -= scanBlock) {
+    // Running sums carry a dependence, so are unpacked serially.
+    for (IndexT blockIdx = 0; blockIdx != scanBlock; blockIdx++) {
+      cutBlock[blockIdx] = !accumulateReg(obsCell[idx - blockIdx]);
+      sumBlock[blockIdx] = sum;
+      sCountBlock[blockIdx] = sCount;
+    }
+
+#pragma omp simd
+    for (IndexT blockIdx = 0; blockIdx < scanBlock; blockIdx++) {
+      double sumL = sumBlock[blockIdx];
+      double sumR = sumTot - sumL;
+      infoBlock[blockIdx] = (sumL * sumL) / sCountBlock[blockIdx] + (sumR * sumR) / (sCountTot - sCountBlock[blockIdx]);
+    }
+
+    for (IndexT blockIdx = 0; blockIdx != scanBlock; blockIdx++) {
+      if (cutBlock[blockIdx])
+	argmaxRL(infoBlock[blockIdx], idx - blockIdx - 1);
+    }
+    idxEnd = idx + 1 - scanBlock;
+  }
+  splitRLScalar(idxStart, idxEnd);
+}
+
+
+void CutAccumRegCart::splitRLScalar(IndexT idxStart, IndexT idxEnd) {
   for (IndexT idx = idxEnd - 1; idx != idxStart; idx--) {
     if (!accumulateReg(obsCell[idx])) {
       argmaxRL(infoVar(sum, sumCount.sum-sum, sCount, sumCount.sCount-sCount), idx-1);
@@ -63,6 +104,38 @@ void CutAccumRegCart::splitRL(IndexT idxStart, IndexT idxEnd) {
 }
 
 
+void CutAccumRegCart::splitRLSketch(IndexT idxStart, IndexT idxEnd) {
+  IndexT idxRight = idxEnd; // Leftmost position accumulated.
+  for (IndexT cutIdx = 1; cutIdx <= nCut; cutIdx++) {
+    IndexT cutRight = sketchPosition(idxStart, idxEnd, cutIdx);
+    if (cutRight >= idxRight) // Passed by an earlier advance.
+      continue;
+    accumBlock(cutRight, idxRight);
+    idxRight = cutRight;
+    bool tied = obsCell[idxRight].isTied();
+    while (tied && idxRight > idxStart + 1) {
+      tied = accumulateReg(obsCell[--idxRight]);
+    }
+    if (!tied)
+      argmaxRL(infoVar(sum, sumCount.sum-sum, sCount, sumCount.sCount-sCount), idxRight-1);
+  }
+  if (idxRight > idxStart + 1)
+    accumBlock(idxStart + 1, idxRight);
+}
+
+
+void CutAccumRegCart::accumBlock(IndexT idxLeft, IndexT idxRight) {
+  double sumBlock = 0.0;
+  IndexT sCountBlock = 0;
+  for (IndexT idx = idxLeft; idx != idxRight; idx++) {
+    sumBlock += obsCell[idx].getYSum();
+    sCountBlock += obsCell[idx].getSCount();
+  }
+  sum -= sumBlock;
+  sCount -= sCountBlock;
+}
+
+
 void CutAccumRegCart::splitRLMono(IndexT idxStart, IndexT idxEnd) {
   for (IndexT idx = idxEnd - 1; idx!= idxStart; idx--) {
     if (!accumulateReg(obsCell[idx])) {
@@ -73,6 +146,121 @@ void CutAccumRegCart::splitRLMono(IndexT idxStart, IndexT idxEnd) {
 
 
 void CutAccumCtgCart::splitRL(IndexT idxStart, IndexT idxEnd) {
+  if (runScan) {
+    splitRLScalar(idxStart, idxEnd);
+    return;
+  }
+  if (sketched(idxStart, idxEnd)) {
+    splitRLSketch(idxStart, idxEnd);
+    return;
+  }
+  switch (ctgNux.nCtg()) {
+  case 2:
+    splitRLFixed<2>(idxStart, idxEnd);
+    break;
+  case 3:
+    splitRLFixed<3>(idxStart, idxEnd);
+    break;
+  case 4:
+    splitRLFixed<4>(idxStart, idxEnd);
+    break;
+  default:
+    splitRLBlock(idxStart, idxEnd);
+  }
+}
+
+
+template<PredictorT nCtgFixed>
+void CutAccumCtgCart::splitRLFixed(IndexT idxStart, IndexT idxEnd) {
+  double accumR[nCtgFixed]; // Right per-category sums.
+  double ctgTot[nCtgFixed]; // Node per-category sums.
+  for (PredictorT ctg = 0; ctg != nCtgFixed; ctg++) {
+    accumR[ctg] = ctgAccum[ctg];
+    ctgTot[ctg] = ctgNux.ctgSum[ctg];
+  }
+  double sumL = sum;
+  IndexT sCountL = sCount;
+  double ssLeft = ssL;
+  double ssRight = ssR;
+  const double sumTot = sumCount.sum;
+
+  double sumBlock[scanBlock];
+  double ssLBlock[scanBlock];
+  double ssRBlock[scanBlock];
+  bool cutBlock[scanBlock];
+  double infoBlock[scanBlock];
+  IndexT idx = idxEnd - 1;
+  while (idx != idxStart) {
+    IndexT nBlock = min(scanBlock, idx - idxStart);
+    for (IndexT blockIdx = 0; blockIdx != nBlock; blockIdx++) {
+      const Obs& obs = obsCell[idx - blockIdx];
+      double ySum = obs.getYSum();
+      PredictorT yCtg = ctgNux.local(obs.getCtg());
+      sumL -= ySum;
+      sCountL -= obs.getSCount();
+      double sumRCtg = accumR[yCtg];
+      accumR[yCtg] = sumRCtg + ySum;
+      ssRight += ySum * (ySum + 2.0 * sumRCtg);
+      ssLeft += ySum * (ySum - 2.0 * (ctgTot[yCtg] - sumRCtg));
+      cutBlock[blockIdx] = !obs.isTied();
+      sumBlock[blockIdx] = sumL;
+      ssLBlock[blockIdx] = ssLeft;
+      ssRBlock[blockIdx] = ssRight;
+    }
+
+#pragma omp simd
+    for (IndexT blockIdx = 0; blockIdx < nBlock; blockIdx++) {
+      infoBlock[blockIdx] = ssLBlock[blockIdx] / sumBlock[blockIdx] + ssRBlock[blockIdx] / (sumTot - sumBlock[blockIdx]);
+    }
+
+    for (IndexT blockIdx = 0; blockIdx != nBlock; blockIdx++) {
+      if (cutBlock[blockIdx])
+	argmaxRL(infoBlock[blockIdx], idx - blockIdx - 1);
+    }
+    idx -= nBlock;
+  }
+
+  for (PredictorT ctg = 0; ctg != nCtgFixed; ctg++) {
+    ctgAccum[ctg] = accumR[ctg];
+  }
+  sum = sumL;
+  sCount = sCountL;
+  ssL = ssLeft;
+  ssR = ssRight;
+}
+
+
+void CutAccumCtgCart::splitRLBlock(IndexT idxStart, IndexT idxEnd) {
+  double sumBlock[scanBlock];
+  double ssLBlock[scanBlock];
+  double ssRBlock[scanBlock];
+  bool cutBlock[scanBlock];
+  double infoBlock[scanBlock];
+  const double sumTot = sumCount.sum;
+  for (IndexT idx = idxEnd - 1; idx > idxStart + scanBlock; idx -= scanBlock) {
+    for (IndexT blockIdx = 0; blockIdx != scanBlock; blockIdx++) {
+      cutBlock[blockIdx] = !accumulateCtg(obsCell[idx - blockIdx]);
+      sumBlock[blockIdx] = sum;
+      ssLBlock[blockIdx] = ssL;
+      ssRBlock[blockIdx] = ssR;
+    }
+
+#pragma omp simd
+    for (IndexT blockIdx = 0; blockIdx < scanBlock; blockIdx++) {
+      infoBlock[blockIdx] = ssLBlock[blockIdx] / sumBlock[blockIdx] + ssRBlock[blockIdx] / (sumTot - sumBlock[blockIdx]);
+    }
+
+    for (IndexT blockIdx = 0; blockIdx != scanBlock; blockIdx++) {
+      if (cutBlock[blockIdx])
+	argmaxRL(infoBlock[blockIdx], idx - blockIdx - 1);
+    }
+    idxEnd = idx + 1 - scanBlock;
+  }
+  splitRLScalar(idxStart, idxEnd);
+}
+
+
+void CutAccumCtgCart::splitRLScalar(IndexT idxStart, IndexT idxEnd) {
   for (IndexT idx = idxEnd - 1; idx != idxStart; idx--) {
     if (!accumulateCtg(obsCell[idx])) {
       argmaxRL(infoGini(ssL, ssR, sum, sumCount.sum-sum), idx-1);
@@ -81,6 +269,54 @@ void CutAccumCtgCart::splitRL(IndexT idxStart, IndexT idxEnd) {
 }
 
 
+void CutAccumCtgCart::splitRLSketch(IndexT idxStart, IndexT idxEnd) {
+  IndexT idxRight = idxEnd; // Leftmost position accumulated.
+  for (IndexT cutIdx = 1; cutIdx <= nCut; cutIdx++) {
+    IndexT cutRight = sketchPosition(idxStart, idxEnd, cutIdx);
+    if (cutRight >= idxRight) // Passed by an earlier advance.
+      continue;
+    accumBlock(cutRight, idxRight);
+    idxRight = cutRight;
+    bool tied = obsCell[idxRight].isTied();
+    while (tied && idxRight > idxStart + 1) {
+      idxRight--;
+      accumBlock(idxRight, idxRight + 1);
+      tied = obsCell[idxRight].isTied();
+    }
+    if (!tied) {
+      sumSquaresCtg();
+      argmaxRL(infoGini(ssL, ssR, sum, sumCount.sum-sum), idxRight-1);
+    }
+  }
+  if (idxRight > idxStart + 1)
+    accumBlock(idxStart + 1, idxRight);
+  sumSquaresCtg(); // Restores running state for residual splitting.
+}
+
+
+void CutAccumCtgCart::accumBlock(IndexT idxLeft, IndexT idxRight) {
+  for (IndexT idx = idxLeft; idx != idxRight; idx++) {
+    const Obs& obs = obsCell[idx];
+    double ySum = obs.getYSum();
+    sum -= ySum;
+    sCount -= obs.getSCount();
+    ctgAccum[ctgNux.local(obs.getCtg())] += ySum;
+  }
+}
+
+
+void CutAccumCtgCart::sumSquaresCtg() {
+  ssL = 0.0;
+  ssR = 0.0;
+  for (PredictorT ctg = 0; ctg != ctgAccum.size(); ctg++) {
+    double sumR = ctgAccum[ctg];
+    double sumL = ctgNux.ctgSum[ctg] - sumR;
+    ssR += sumR * sumR;
+    ssL += sumL * sumL;
+  }
+}
+
+
 void CutAccumRegCart::splitImpl() {
   if (cutResidual < obsEnd) {
     // Tries obsEnd/obsEnd-1, ..., cut+1/cut.
@@ -116,21 +352,24 @@ void CutAccumRegCart::splitImplMono() {
 void CutAccumRegCart::residualRL() {
   residualReg(obsCell);
   argmaxResidual(infoVar(sum, sumCount.sum-sum, sCount, sumCount.sCount-sCount), false);
-  splitRL(obsStart, cutResidual);
+  if (!singleRun) // Otherwise all remaining cuts are tied.
+    splitRL(obsStart, cutResidual);
 }
 
 
 void CutAccumCtgCart::residualRL() {
   residualCtg(obsCell);
   argmaxResidual(infoGini(ssL, ssR, sum, sumCount.sum-sum), false);
-  splitRL(obsStart, cutResidual);
+  if (!singleRun)
+    splitRL(obsStart, cutResidual);
 }
 
 
 void CutAccumRegCart::residualRLMono() {
   residualReg(obsCell);
   argmaxResidual((senseMonotone() && infoVar(sum, sumCount.sum - sum, sCount, sumCount.sCount - sCount)), false);
-  splitRLMono(obsStart, cutResidual);
+  if (!singleRun)
+    splitRLMono(obsStart, cutResidual);
 }
 
 
@@ -157,6 +396,7 @@ void CutAccumCtgCart::split(SFCtgCart* spCtg,
 			    SplitNux& cand) {
   CutAccumCtgCart cutAccum(cand, spCtg);
   cand.setInfo(cutAccum.splitCtg(spCtg, cand));
+  cutAccum.routeMissing(cand);
   spCtg->writeCut(cand, cutAccum);
 }
 
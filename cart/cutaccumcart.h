@@ -85,11 +85,45 @@ public:
 
   /**
      @brief Splits right to left, no residual.
+
+     Observations are unpacked and accumulated a block at a time, the
+     block's trial information evaluated as a vector, and the argmax
+     revised in traversal order.  Results agree exactly with the scalar
+     scan, to which cells having few runs are dispatched.
    */
   void splitRL(IndexT idxStart,
 	       IndexT idxEnd);
 
 
+  /**
+     @brief Reference scan, one observation at a time.
+
+     Information is evaluated only at run boundaries, so the scan also
+     serves cells having few runs, for which blocked evaluation is
+     mostly wasted on tied positions.
+   */
+  void splitRLScalar(IndexT idxStart,
+		     IndexT idxEnd);
+
+
+  /**
+     @brief Approximate scan, evaluating only 'nCut' positions.
+
+     Observations between positions are accumulated as a block, and
+     positions tied with their left neighbor are advanced leftward.
+     Accumulated state on exit is as with the exhaustive scan.
+   */
+  void splitRLSketch(IndexT idxStart,
+		     IndexT idxEnd);
+
+
+  /**
+     @brief Subtracts an index range from the running left state.
+   */
+  void accumBlock(IndexT idxLeft,
+		  IndexT idxRight);
+
+
   /**
      @brief As above, but applies monotonicty constraint.
    */
@@ -156,6 +190,9 @@ public:
      @brief Splitting method for categorical response over an explicit
      block of numerical observation indices.
 
+     Dispatches to a fixed-width scan for small category counts and
+     to the reference scan for cells having few runs.
+
      @param rightCtg indicates whether a category has been set in an
      initialization or previous invocation.
    */
@@ -163,6 +200,63 @@ public:
 	       IndexT idxEnd);
 
 
+  /**
+     @brief General scan, blocked as in the regression scan.
+
+     Parameters as above.
+   */
+  void splitRLBlock(IndexT idxStart,
+		    IndexT idxEnd);
+
+
+  /**
+     @brief As above, but with a compile-time category count.
+
+     Per-category and running sums are held locally, so that the block
+     accumulation runs over fixed-width arrays, without indirection
+     through the accumulator's members.  Results agree exactly with the
+     general scan.
+
+     @tparam nCtgFixed is the response cardinality.
+   */
+  template<PredictorT nCtgFixed>
+  void splitRLFixed(IndexT idxStart,
+		    IndexT idxEnd);
+
+
+  /**
+     @brief Reference scan, one observation at a time.
+
+     As with regression, also serves cells having few runs.
+   */
+  void splitRLScalar(IndexT idxStart,
+		     IndexT idxEnd);
+
+
+  /**
+     @brief Approximate scan, as with regression.
+
+     Per-category sums are accumulated by block and the sums of
+     squares derived from them only at evaluated positions.
+   */
+  void splitRLSketch(IndexT idxStart,
+		     IndexT idxEnd);
+
+
+  /**
+     @brief Accumulates an index range into the per-category sums.
+   */
+  void accumBlock(IndexT idxLeft,
+		  IndexT idxRight);
+
+
+  /**
+     @brief Derives left and right sums of squares from the
+     per-category sums.
+   */
+  void sumSquaresCtg();
+
+
   /**
      @brief As above, but with implicit dense blob.
    */
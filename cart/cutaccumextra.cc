@@ -0,0 +1,89 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file cutaccumextra.cc
+
+   @brief Methods to implement extremely-randomized cut splitting.
+
+   @author Mark Seligman
+ */
+
+#include "cutaccumextra.h"
+#include "splitnux.h"
+#include "splitfrontier.h"
+#include "obs.h"
+
+
+CutAccumRegExtra::CutAccumRegExtra(const SplitNux& cand,
+				   const SFReg* spReg) :
+  CutAccumReg(cand, spReg) {
+  info = (sum * sum) / sCount;
+}
+
+
+void CutAccumRegExtra::split(const SFReg* spReg,
+			     SplitNux& cand,
+			     double ru) {
+  CutAccumRegExtra cutAccum(cand, spReg);
+  cand.setInfo(cutAccum.splitRandom(ru));
+  cutAccum.routeMissing(cand);
+  spReg->writeCut(cand, cutAccum);
+}
+
+
+double CutAccumRegExtra::splitRandom(double ru) {
+  double infoCell = info;
+  IndexT cutLeft = drawCut(ru);
+  if (cutLeft == obsEnd)
+    return 0.0;
+
+  for (IndexT idx = obsEnd - 1; idx != cutLeft; idx--) {
+    (void) accumulateReg(obsCell[idx]);
+  }
+  if (implicitCand != 0 && cutResidual > cutLeft) { // Residual lies right.
+    residualReg(obsCell);
+  }
+  if (monoMode == 0 || senseMonotone()) {
+    argmaxRL(infoVar(sum, sumCount.sum - sum, sCount, sumCount.sCount - sCount), cutLeft);
+  }
+  return info - infoCell;
+}
+
+
+CutAccumCtgExtra::CutAccumCtgExtra(const SplitNux& cand,
+				   SFCtg* spCtg) :
+  CutAccumCtg(cand, spCtg) {
+  info = ssL / sum;
+}
+
+
+void CutAccumCtgExtra::split(SFCtg* spCtg,
+			     SplitNux& cand,
+			     double ru) {
+  CutAccumCtgExtra cutAccum(cand, spCtg);
+  cand.setInfo(cutAccum.splitRandom(ru));
+  cutAccum.routeMissing(cand);
+  spCtg->writeCut(cand, cutAccum);
+}
+
+
+double CutAccumCtgExtra::splitRandom(double ru) {
+  double infoCell = info;
+  IndexT cutLeft = drawCut(ru);
+  if (cutLeft == obsEnd)
+    return 0.0;
+
+  for (IndexT idx = obsEnd - 1; idx != cutLeft; idx--) {
+    (void) accumulateCtg(obsCell[idx]);
+  }
+  if (implicitCand != 0 && cutResidual > cutLeft) { // Residual lies right.
+    residualCtg(obsCell);
+  }
+  argmaxRL(infoGini(ssL, ssR, sum, sumCount.sum - sum), cutLeft);
+  return info - infoCell;
+}
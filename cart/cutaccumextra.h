@@ -0,0 +1,94 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef CART_CUTACCUMEXTRA_H
+#define CART_CUTACCUMEXTRA_H
+
+/**
+   @file cutaccumextra.h
+
+   @brief Accumulator classes for extremely-randomized cut splitting.
+
+   @author Mark Seligman
+
+ */
+
+#include "cutaccum.h"
+
+
+/**
+   @brief Single-cut workspace for regression.
+
+   Only the observations to the right of the random cut are
+   accumulated, and only the one trial is evaluated.
+ */
+class CutAccumRegExtra : public CutAccumReg {
+
+  /**
+     @return true iff accumulated and monotonicity senses agree.
+   */
+  inline bool senseMonotone() const {
+    IndexT sCountR = sumCount.sCount - sCount;
+    double sumR = sumCount.sum - sum;
+    bool accumNonDecreasing = (sum * sCountR <= sumR * sCount);
+    return monoMode > 0 ? accumNonDecreasing : !accumNonDecreasing;
+  }
+
+
+public:
+  CutAccumRegExtra(const class SplitNux& cand,
+		   const struct SFReg* spReg);
+
+
+  /**
+     @brief Static entry for regression splitting.
+
+     @param ru is a uniform variate selecting the cut.
+   */
+  static void split(const struct SFReg* spReg,
+		    class SplitNux& cand,
+		    double ru);
+
+
+  /**
+     @brief Evaluates the randomly-selected cut.
+
+     @return information gain.
+   */
+  double splitRandom(double ru);
+};
+
+
+/**
+   @brief Single-cut workspace for classification.
+ */
+class CutAccumCtgExtra : public CutAccumCtg {
+
+public:
+  CutAccumCtgExtra(const class SplitNux& cand,
+		   class SFCtg* spCtg);
+
+
+  /**
+     @brief Static entry for classification splitting.
+
+     @param ru is a uniform variate selecting the cut.
+   */
+  static void split(class SFCtg* spCtg,
+		    class SplitNux& cand,
+		    double ru);
+
+
+  /**
+     @brief Evaluates the randomly-selected cut.
+
+     @return information gain.
+   */
+  double splitRandom(double ru);
+};
+
+#endif
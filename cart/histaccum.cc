@@ -0,0 +1,93 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file histaccum.cc
+
+   @brief Methods to implement CART-style splitting over bin histograms.
+
+   @author Mark Seligman
+ */
+
+#include "histaccum.h"
+#include "histset.h"
+#include "splitnux.h"
+#include "splitfrontier.h"
+
+
+HistAccumReg::HistAccumReg(const SplitNux& cand,
+			   const SFReg* sfReg) :
+  CutAccumReg(cand, sfReg) {
+  info = (sum * sum) / sCount;
+}
+
+
+void HistAccumReg::split(const SFReg* sfReg,
+			 const HistSet* histSet,
+			 IndexT histIdx,
+			 SplitNux& cand) {
+  HistAccumReg histAccum(cand, sfReg);
+  cand.setInfo(histAccum.splitHist(histSet->getBins(histIdx), histSet->getNEntry(histIdx)));
+  histAccum.routeMissing(cand);
+  sfReg->writeCut(cand, histAccum);
+}
+
+
+double HistAccumReg::splitHist(const HistBin* histBin,
+			       IndexT nEntry) {
+  double infoCell = info;
+  IndexT obsRight = obsEnd; // Leftmost position accumulated.
+  for (IndexT entryIdx = nEntry; entryIdx > 1; entryIdx--) { // Cut left of entry.
+    const HistBin& hb = histBin[entryIdx - 1];
+    sum -= hb.sumCount.sum;
+    sCount -= hb.sumCount.sCount;
+    obsRight -= hb.obsCount;
+    if (monoMode == 0 || senseMonotone())
+      argmaxRL(infoVar(sum, sumCount.sum - sum, sCount, sumCount.sCount - sCount), obsRight - 1);
+  }
+  return info - infoCell;
+}
+
+
+HistAccumCtg::HistAccumCtg(const SplitNux& cand,
+			   SFCtg* sfCtg) :
+  CutAccumCtg(cand, sfCtg) {
+  info = ssL / sum;
+}
+
+
+void HistAccumCtg::split(SFCtg* sfCtg,
+			 const HistSet* histSet,
+			 IndexT histIdx,
+			 SplitNux& cand) {
+  HistAccumCtg histAccum(cand, sfCtg);
+  cand.setInfo(histAccum.splitHist(histSet->getBins(histIdx), histSet->getCtgSum(histIdx), histSet->getNEntry(histIdx)));
+  histAccum.routeMissing(cand);
+  sfCtg->writeCut(cand, histAccum);
+}
+
+
+double HistAccumCtg::splitHist(const HistBin* histBin,
+			       const double* ctgBin,
+			       IndexT nEntry) {
+  double infoCell = info;
+  PredictorT nCtg = ctgNux.nCtg();
+  IndexT obsRight = obsEnd;
+  for (IndexT entryIdx = nEntry; entryIdx > 1; entryIdx--) { // Cut left of entry.
+    const HistBin& hb = histBin[entryIdx - 1];
+    sum -= hb.sumCount.sum;
+    sCount -= hb.sumCount.sCount;
+    const double* entryCtg = &ctgBin[(entryIdx - 1) * nCtg];
+    for (PredictorT ctg = 0; ctg != nCtg; ctg++) {
+      if (entryCtg[ctg] != 0.0)
+	accumCtgSS(entryCtg[ctg], ctg);
+    }
+    obsRight -= hb.obsCount;
+    argmaxRL(infoGini(ssL, ssR, sum, sumCount.sum - sum), obsRight - 1);
+  }
+  return info - infoCell;
+}
@@ -0,0 +1,106 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef CART_HISTACCUM_H
+#define CART_HISTACCUM_H
+
+/**
+   @file histaccum.h
+
+   @brief Accumulators scanning bin histograms for CART-style cuts.
+
+   @author Mark Seligman
+
+ */
+
+#include "cutaccum.h"
+
+#include <vector>
+
+
+/**
+   @brief Histogram scan for regression.
+
+   Cuts are evaluated only between the bins present in the cell, so
+   the scan is linear in the bin count rather than in the extent.
+   The resulting cut is expressed in staged positions, as with the
+   exact scan, so that restaging and criterion encoding are unchanged.
+ */
+class HistAccumReg : public CutAccumReg {
+
+  /**
+     @return true iff accumulated and monotonicity senses agree.
+   */
+  inline bool senseMonotone() const {
+    IndexT sCountR = sumCount.sCount - sCount;
+    double sumR = sumCount.sum - sum;
+    bool accumNonDecreasing = (sum * sCountR <= sumR * sCount);
+    return monoMode > 0 ? accumNonDecreasing : !accumNonDecreasing;
+  }
+
+
+public:
+  HistAccumReg(const class SplitNux& cand,
+	       const struct SFReg* sfReg);
+
+
+  /**
+     @brief Static entry for regression splitting.
+
+     @param histSet holds the candidate's histogram.
+   */
+  static void split(const struct SFReg* sfReg,
+		    const class HistSet* histSet,
+		    IndexT histIdx,
+		    class SplitNux& cand);
+
+
+  /**
+     @brief Scans bin boundaries right to left.
+
+     @return information gain.
+   */
+  double splitHist(const struct HistBin* histBin,
+		   IndexT nEntry);
+};
+
+
+/**
+   @brief Histogram scan for classification.
+
+   Per-category sums are applied a bin at a time, the sums of squares
+   being updated as by a run of observations.
+ */
+class HistAccumCtg : public CutAccumCtg {
+
+public:
+  HistAccumCtg(const class SplitNux& cand,
+	       class SFCtg* sfCtg);
+
+
+  /**
+     @brief Static entry for classification splitting.
+   */
+  static void split(class SFCtg* sfCtg,
+		    const class HistSet* histSet,
+		    IndexT histIdx,
+		    class SplitNux& cand);
+
+
+  /**
+     @brief Scans bin boundaries right to left.
+
+     @param ctgBin holds the per-category sums of each entry.
+
+     @return information gain.
+   */
+  double splitHist(const struct HistBin* histBin,
+		   const double* ctgBin,
+		   IndexT nEntry);
+};
+
+#endif
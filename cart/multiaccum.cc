@@ -0,0 +1,278 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file multiaccum.cc
+
+   @brief Methods for joint splitting of several responses.
+
+   @author Mark Seligman
+
+ */
+
+#include "multiaccum.h"
+#include "sfmulti.h"
+#include "splitnux.h"
+#include "runset.h"
+#include "obs.h"
+
+
+/**
+   @brief Accumulates a sample's responses, scaled.
+
+   @param scale is the sample count, negated to subtract.
+ */
+static inline void accumResponse(const SFRegMulti* sfMulti,
+				 IndexT sIdx,
+				 double scale,
+				 vector<double>& accum) {
+  const double* y = sfMulti->getResponse(sIdx);
+  for (unsigned int out = 0; out != accum.size(); out++) {
+    accum[out] += scale * y[out];
+  }
+}
+
+
+/**
+   @brief Subtracts missing observations from the node's response sums.
+ */
+static inline vector<double> filterMissingMulti(const SFRegMulti* sfMulti,
+						const SplitNux& cand,
+						const Obs* obsCell,
+						const SampleIdx& sampleIndex,
+						IndexT obsEnd) {
+  vector<double> multiNode = sfMulti->nodeSums(cand);
+  for (IndexT obsIdx = obsEnd; obsIdx != obsEnd + cand.getNMissing(); obsIdx++) {
+    accumResponse(sfMulti, sampleIndex[obsIdx], -static_cast<double>(obsCell[obsIdx].getSCount()), multiNode);
+  }
+  return multiNode;
+}
+
+
+/**
+   @return weighted-variance information of a set, summed over responses.
+ */
+static inline double infoSet(const vector<double>& sumSet,
+			     IndexT sCountSet) {
+  double ss = 0.0;
+  for (double sum : sumSet) {
+    ss += sum * sum;
+  }
+  return ss / sCountSet;
+}
+
+
+/**
+   @return weighted-variance information of a cut, summed over responses.
+ */
+static inline double infoCut(const vector<double>& sumL,
+			     const vector<double>& sumNode,
+			     IndexT sCountL,
+			     IndexT sCountNode) {
+  double ssL = 0.0;
+  double ssR = 0.0;
+  for (unsigned int out = 0; out != sumL.size(); out++) {
+    double sumR = sumNode[out] - sumL[out];
+    ssL += sumL[out] * sumL[out];
+    ssR += sumR * sumR;
+  }
+  return ssL / sCountL + ssR / (sCountNode - sCountL);
+}
+
+
+CutAccumMulti::CutAccumMulti(const SplitNux& cand,
+			     const SFRegMulti* sfMulti_) :
+  CutAccum(cand, sfMulti_),
+  sfMulti(sfMulti_),
+  nOut(sfMulti->getNOut()),
+  multiNode(filterMissingMulti(sfMulti, cand, obsCell, sampleIndex, obsEnd)),
+  multiL(multiNode) {
+  info = infoSet(multiNode, sumCount.sCount);
+}
+
+
+void CutAccumMulti::split(const SFRegMulti* sfMulti,
+			  SplitNux& cand) {
+  CutAccumMulti cutAccum(cand, sfMulti);
+  double infoCell = cutAccum.info;
+  if (cand.getImplicitCount() != 0)
+    cutAccum.splitImpl();
+  else
+    cutAccum.splitRL(cutAccum.obsStart, cutAccum.obsEnd);
+  cand.setInfo(cutAccum.info - infoCell);
+  cutAccum.routeMissing(cand);
+  sfMulti->writeCut(cand, cutAccum);
+}
+
+
+bool CutAccumMulti::accumulateMulti(IndexT obsIdx) {
+  const Obs& obs = obsCell[obsIdx];
+  accumResponse(sfMulti, sampleIndex[obsIdx], -static_cast<double>(obs.getSCount()), multiL);
+  return accumulateReg(obs);
+}
+
+
+double CutAccumMulti::infoMulti() const {
+  return infoCut(multiL, multiNode, sCount, sumCount.sCount);
+}
+
+
+void CutAccumMulti::splitRL(IndexT idxStart,
+			    IndexT idxEnd) {
+  for (IndexT idx = idxEnd - 1; idx != idxStart; idx--) {
+    if (!accumulateMulti(idx)) {
+      argmaxRL(infoMulti(), idx - 1);
+    }
+  }
+}
+
+
+void CutAccumMulti::splitImpl() {
+  if (cutResidual < obsEnd) {
+    // Tries obsEnd/obsEnd-1, ..., cut+1/cut, then cut/resid.
+    splitRL(cutResidual, obsEnd);
+    (void) accumulateMulti(cutResidual);
+    argmaxResidual(infoMulti(), true);
+  }
+  // Tries resid/cut-1, ..., obsStart+1/obsStart, if applicable.
+  if (cutResidual > obsStart) {
+    residualMulti();
+    argmaxResidual(infoMulti(), false);
+    if (!singleRun) // Otherwise all remaining cuts are tied.
+      splitRL(obsStart, cutResidual);
+  }
+}
+
+
+void CutAccumMulti::residualMulti() {
+  residualReg(obsCell);
+  vector<double> multiExpl(nOut);
+  for (IndexT obsIdx = obsStart; obsIdx != obsEnd; obsIdx++) {
+    accumResponse(sfMulti, sampleIndex[obsIdx], obsCell[obsIdx].getSCount(), multiExpl);
+  }
+  for (unsigned int out = 0; out != nOut; out++) {
+    multiL[out] -= multiNode[out] - multiExpl[out];
+  }
+}
+
+
+void CutAccumMulti::routeMissing(const SplitNux& cand) {
+  if (cand.getNMissing() == 0 || !hasArgmax())
+    return;
+
+  vector<double> multiLeft(nOut);
+  vector<double> multiExpl(nOut);
+  IndexT sCountLeft = 0;
+  IndexT sCountExpl = 0;
+  for (IndexT obsIdx = obsStart; obsIdx != obsEnd; obsIdx++) {
+    IndexT sCountObs = obsCell[obsIdx].getSCount();
+    accumResponse(sfMulti, sampleIndex[obsIdx], sCountObs, multiExpl);
+    sCountExpl += sCountObs;
+    if (obsIdx <= obsLeft) {
+      accumResponse(sfMulti, sampleIndex[obsIdx], sCountObs, multiLeft);
+      sCountLeft += sCountObs;
+    }
+  }
+  if (lhImplicit(cand) != 0) {
+    for (unsigned int out = 0; out != nOut; out++) {
+      multiLeft[out] += multiNode[out] - multiExpl[out];
+    }
+    sCountLeft += sumCount.sCount - sCountExpl;
+  }
+
+  vector<double> multiMissing(nOut);
+  IndexT sCountMissing = 0;
+  for (IndexT obsIdx = obsEnd; obsIdx != obsEnd + cand.getNMissing(); obsIdx++) {
+    IndexT sCountObs = obsCell[obsIdx].getSCount();
+    accumResponse(sfMulti, sampleIndex[obsIdx], sCountObs, multiMissing);
+    sCountMissing += sCountObs;
+  }
+
+  // Node sums with the missing observations restored.
+  vector<double> multiAll(multiNode);
+  vector<double> multiLeftMissing(multiLeft);
+  for (unsigned int out = 0; out != nOut; out++) {
+    multiAll[out] += multiMissing[out];
+    multiLeftMissing[out] += multiMissing[out];
+  }
+  IndexT sCountAll = sumCount.sCount + sCountMissing;
+  double infoLeft = infoCut(multiLeftMissing, multiAll, sCountLeft + sCountMissing, sCountAll);
+  double infoRight = infoCut(multiLeft, multiAll, sCountLeft, sCountAll);
+  missingLeft = infoLeft > infoRight;
+}
+
+
+RunAccumMulti::RunAccumMulti(const SFRegMulti* sfMulti_,
+			     const SplitNux& cand,
+			     const RunSet* runSet) :
+  RunAccum(sfMulti_, cand, runSet),
+  sfMulti(sfMulti_),
+  nOut(sfMulti->getNOut()),
+  multiNode(filterMissingMulti(sfMulti, cand, obsCell, sampleIndex, obsEnd)) {
+}
+
+
+void RunAccumMulti::split(const SFRegMulti* sfMulti,
+			  RunSet* runSet,
+			  SplitNux& cand) {
+  RunAccumMulti runAccum(sfMulti, cand, runSet);
+  runAccum.initRuns(runSet, cand);
+  cand.setInfo(runAccum.maxMulti(cand, runSet->getRunNux(cand)));
+  runSet->setToken(cand, runAccum.splitToken);
+}
+
+
+vector<double> RunAccumMulti::runSums(const SplitNux& cand,
+				      const vector<RunNux>& runNux) const {
+  vector<double> runSum(runNux.size() * nOut);
+  vector<double> multiExpl(nOut);
+  PredictorT implicitSlot = runNux.size(); // Inattainable.
+  for (PredictorT slot = 0; slot != runNux.size(); slot++) {
+    if (cand.isImplicit(runNux[slot])) {
+      implicitSlot = slot;
+      continue;
+    }
+    vector<double> multiRun(nOut);
+    IndexRange range = runNux[slot].getRange();
+    for (IndexT obsIdx = range.getStart(); obsIdx != range.getEnd(); obsIdx++) {
+      accumResponse(sfMulti, sampleIndex[obsIdx], obsCell[obsIdx].getSCount(), multiRun);
+    }
+    for (unsigned int out = 0; out != nOut; out++) {
+      runSum[slot * nOut + out] = multiRun[out];
+      multiExpl[out] += multiRun[out];
+    }
+  }
+
+  if (implicitSlot < runNux.size()) {
+    for (unsigned int out = 0; out != nOut; out++) {
+      runSum[implicitSlot * nOut + out] = multiNode[out] - multiExpl[out];
+    }
+  }
+  return runSum;
+}
+
+
+double RunAccumMulti::maxMulti(const SplitNux& cand,
+			       const vector<RunNux>& runNux) {
+  info = infoSet(multiNode, sumCount.sCount);
+  double infoCell = info;
+  vector<double> runSum = runSums(cand, runNux);
+  vector<double> multiAccum(nOut);
+  IndexT sCountAccum = 0;
+  PredictorT runSlot = runNux.size() - 1;
+  for (PredictorT slotTrial = 0; slotTrial < runNux.size() - 1; slotTrial++) {
+    for (unsigned int out = 0; out != nOut; out++) {
+      multiAccum[out] += runSum[slotTrial * nOut + out];
+    }
+    sCountAccum += runNux[slotTrial].sumCount.sCount;
+    if (trialSplit(infoCut(multiAccum, multiNode, sCountAccum, sumCount.sCount))) {
+      runSlot = slotTrial;
+    }
+  }
+  setToken(runSlot);
+  return info - infoCell;
+}
@@ -0,0 +1,134 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef CART_MULTIACCUM_H
+#define CART_MULTIACCUM_H
+
+/**
+   @file multiaccum.h
+
+   @brief Accumulators for joint splitting of several responses.
+
+   @author Mark Seligman
+
+ */
+
+#include "cutaccum.h"
+#include "runaccum.h"
+
+#include <vector>
+
+
+/**
+   @brief Cut accumulator summing squared error over the responses.
+
+   Traversal and residual handling follow the exhaustive regression
+   scan, with per-response sums accumulated alongside the summary.
+ */
+class CutAccumMulti : public CutAccum {
+  const class SFRegMulti* sfMulti;
+  const unsigned int nOut; ///< # responses.
+  const vector<double> multiNode; ///< Node sums by response, missing filtered.
+  vector<double> multiL; ///< Running left sums by response.
+
+
+  /**
+     @brief Accumulates observation state.
+
+     @return true iff rank ties with observation to left.
+   */
+  bool accumulateMulti(IndexT obsIdx);
+
+
+  /**
+     @return summed weighted-variance information of the current cut.
+   */
+  double infoMulti() const;
+
+
+  /**
+     @brief Subtracts the residual from the running left state.
+   */
+  void residualMulti();
+
+
+  /**
+     @brief Splits right to left, no residual.
+   */
+  void splitRL(IndexT idxStart,
+	       IndexT idxEnd);
+
+
+  /**
+     @brief Splits a cell having an implicit blob.
+   */
+  void splitImpl();
+
+
+  /**
+     @brief Routes missing observations to the more informative side.
+   */
+  void routeMissing(const class SplitNux& cand);
+
+
+public:
+  CutAccumMulti(const class SplitNux& cand,
+		const class SFRegMulti* sfMulti_);
+
+
+  /**
+     @brief Static entry for joint splitting.
+   */
+  static void split(const class SFRegMulti* sfMulti,
+		    class SplitNux& cand);
+};
+
+
+/**
+   @brief Run accumulator summing squared error over the responses.
+
+   Runs are ordered by mean summary response, as with regression, and
+   the ordering cut evaluated over the responses.
+ */
+class RunAccumMulti : public RunAccum {
+  const class SFRegMulti* sfMulti;
+  const unsigned int nOut; ///< # responses.
+  const vector<double> multiNode; ///< Node sums by response, missing filtered.
+
+
+  /**
+     @brief Accumulates the response sums of each run.
+
+     @return run x response sums.
+   */
+  vector<double> runSums(const class SplitNux& cand,
+			 const vector<RunNux>& runNux) const;
+
+
+  /**
+     @brief Determines the ordering cut of highest summed information.
+
+     @return gain in summed weighted variance.
+   */
+  double maxMulti(const class SplitNux& cand,
+		  const vector<RunNux>& runNux);
+
+public:
+  RunAccumMulti(const class SFRegMulti* sfMulti_,
+		const class SplitNux& cand,
+		const class RunSet* runSet);
+
+
+  /**
+     @brief Static entry for joint splitting.
+   */
+  static void split(const class SFRegMulti* sfMulti,
+		    class RunSet* runSet,
+		    class SplitNux& cand);
+};
+
+#endif
@@ -17,20 +17,18 @@
 #include "frontier.h"
 #include "sfcart.h"
 #include "splitnux.h"
-#include "ompthread.h"
 #include "splitcart.h"
-#include "branchsense.h"
 #include "runaccum.h"
 #include "cutaccumcart.h"
 
 
 SFRegCart::SFRegCart(Frontier* frontier) :
-  SFReg(frontier, false, EncodingStyle::trueBranch, SplitStyle::slots, static_cast<void (SplitFrontier::*) (vector<SplitNux>&, BranchSense&)>(&SFRegCart::split)) {
+  SFReg(frontier, false, EncodingStyle::trueBranch, SplitStyle::slots) {
 }
 
 
 SFCtgCart::SFCtgCart(Frontier* frontier) :
-  SFCtg(frontier, false, EncodingStyle::trueBranch, frontier->getNCtg() == 2 ? SplitStyle::slots : SplitStyle::bits, static_cast<void (SplitFrontier::*) (vector<SplitNux>&, BranchSense&)>(&SFCtgCart::split)) {
+  SFCtg(frontier, false, EncodingStyle::trueBranch, frontier->getNCtg() == 2 ? SplitStyle::slots : SplitStyle::bits) {
 }
 
 
@@ -39,33 +37,15 @@ void SFRegCart::accumPreset() {
 }
 
 
-void SFRegCart::split(vector<SplitNux>& sc,
-		      BranchSense& branchSense) {
-  OMPBound splitTop = sc.size();
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound splitPos = 0; splitPos < splitTop; splitPos++) {
-      split(sc[splitPos]);
-    }
-  }
-
-  maxSimple(sc, branchSense);
+void SFRegCart::evaluate(SplitNux& cand,
+			 IndexT) {
+  split(cand);
 }
 
 
-void SFCtgCart::split(vector<SplitNux>& sc,
-		      BranchSense& branchSense) {
-  OMPBound splitTop = sc.size();
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound splitPos = 0; splitPos < splitTop; splitPos++) {
-      split(sc[splitPos]);
-    }
-  }
-
-  maxSimple(sc, branchSense);
+void SFCtgCart::evaluate(SplitNux& cand,
+			 IndexT) {
+  split(cand);
 }
 
 
@@ -45,8 +45,8 @@ struct SFRegCart : public SFReg {
   SplitStyle getFactorStyle() const;
 
 
-  void split(vector<class SplitNux>& candidate,
-	     class BranchSense& branchSense);
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
 
 
   /**
@@ -65,14 +65,15 @@ class SFCtgCart : public SFCtg {
   static constexpr double minSumL = 1.0e-8;
   static constexpr double minSumR = 1.0e-5;
 
+protected:
   /**
      @return slot-style for binary response, otherwise bit-style.
    */
   SplitStyle getFactorStyle() const;
 
 
-  void split(vector<class SplitNux>& candidate,
-	     class BranchSense& branchSense);
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
 
 
   /**
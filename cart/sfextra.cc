@@ -0,0 +1,77 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file sfextra.cc
+
+   @brief Methods to implement extremely-randomized splitting of frontier.
+
+   @author Mark Seligman
+ */
+
+
+#include "frontier.h"
+#include "sfextra.h"
+#include "splitnux.h"
+#include "prng.h"
+#include "runaccum.h"
+#include "cutaccumextra.h"
+
+
+SFRegExtra::SFRegExtra(Frontier* frontier) :
+  SFReg(frontier, false, EncodingStyle::trueBranch, SplitStyle::slots) {
+}
+
+
+SFCtgExtra::SFCtgExtra(Frontier* frontier) :
+  SFCtg(frontier, false, EncodingStyle::trueBranch, frontier->getNCtg() == 2 ? SplitStyle::slots : SplitStyle::bits) {
+}
+
+
+void SFRegExtra::stageCandidates(const vector<SplitNux>& sc) {
+  // Variates are drawn serially, ahead of the parallel region.
+  ruCut = PRNG::rUnif(sc.size());
+}
+
+
+void SFRegExtra::evaluate(SplitNux& cand,
+			  IndexT pos) {
+  split(cand, ruCut[pos]);
+}
+
+
+void SFCtgExtra::stageCandidates(const vector<SplitNux>& sc) {
+  ruCut = PRNG::rUnif(sc.size());
+}
+
+
+void SFCtgExtra::evaluate(SplitNux& cand,
+			  IndexT pos) {
+  split(cand, ruCut[pos]);
+}
+
+
+void SFRegExtra::split(SplitNux& cand,
+		       double ru) {
+  if (isFactor(cand)) {
+    RunAccumReg::splitRandom(this, runSet.get(), cand, ru);
+  }
+  else {
+    CutAccumRegExtra::split(this, cand, ru);
+  }
+}
+
+
+void SFCtgExtra::split(SplitNux& cand,
+		       double ru) {
+  if (isFactor(cand)) {
+    RunAccumCtg::splitRandom(this, runSet.get(), cand, ru);
+  }
+  else {
+    CutAccumCtgExtra::split(this, cand, ru);
+  }
+}
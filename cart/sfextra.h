@@ -0,0 +1,86 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef CART_SFEXTRA_H
+#define CART_SFEXTRA_H
+
+/**
+   @file sfextra.h
+
+   @brief Manages extremely-randomized node splitting across the tree frontier.
+
+   @author Mark Seligman
+
+ */
+
+#include "splitfrontier.h"
+
+#include <vector>
+
+
+/**
+   @brief Extremely-randomized splitting for regression trees.
+
+   Each candidate evaluates a single cut, or factor subset, drawn at
+   random, rather than scanning for its maximum.  Node scoring and
+   restaging are as with CART.
+ */
+struct SFRegExtra : public SFReg {
+  vector<double> ruCut; // Per-candidate variates, drawn serially.
+
+  SFRegExtra(class Frontier* frontier_);
+
+  ~SFRegExtra() = default;
+
+
+  void stageCandidates(const vector<class SplitNux>& sc);
+
+
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
+
+
+  /**
+     @brief Splits a single candidate.
+
+     @param ru is the candidate's uniform variate.
+   */
+  void split(class SplitNux& cand,
+	     double ru);
+};
+
+
+/**
+   @brief Extremely-randomized splitting for categorical trees.
+ */
+class SFCtgExtra : public SFCtg {
+  vector<double> ruCut; // Per-candidate variates, drawn serially.
+
+  void stageCandidates(const vector<class SplitNux>& sc);
+
+
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
+
+
+  /**
+     @brief Splits a single candidate.
+
+     @param ru is the candidate's uniform variate.
+   */
+  void split(class SplitNux& cand,
+	     double ru);
+
+
+public:
+  SFCtgExtra(class Frontier* frontier_);
+
+  ~SFCtgExtra() = default;
+};
+
+
+#endif
@@ -0,0 +1,129 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file sfhist.cc
+
+   @brief Methods to implement histogram splitting of frontier.
+
+   @author Mark Seligman
+ */
+
+
+#include "frontier.h"
+#include "sfhist.h"
+#include "splitnux.h"
+#include "predictorframe.h"
+#include "histaccum.h"
+#include "interlevel.h"
+
+
+/**
+   @brief Determines whether a candidate is split from a histogram.
+
+   Implicit observations have no staged positions, so cells holding
+   them are left to the exact scan.
+ */
+static inline bool histEligible(const SplitFrontier* splitFrontier,
+				const PredictorFrame* frame,
+				const SplitNux& cand) {
+  return splitFrontier->isGainable(cand) && !splitFrontier->isFactor(cand) && frame->isBinned(cand.getPredIdx()) && cand.getImplicitCount() == 0;
+}
+
+
+/**
+   @brief Reserves and pairs the level's histograms.
+ */
+static inline void stageHist(const SplitFrontier* splitFrontier,
+			     const PredictorFrame* frame,
+			     const InterLevel* interLevel,
+			     HistSet* histSet,
+			     const vector<SplitNux>& sc,
+			     vector<IndexT>& candHist) {
+  for (IndexT pos = 0; pos != sc.size(); pos++) {
+    if (histEligible(splitFrontier, frame, sc[pos]))
+      candHist[pos] = histSet->preIndex(sc[pos]);
+  }
+  histSet->pairSiblings(interLevel->getHistParent(), interLevel->getParentIdx());
+  histSet->allocate();
+}
+
+
+/**
+   @return cost of filling and scanning a histogram, if any.
+ */
+static inline double histCost(const HistSet* histSet,
+			      const SplitNux& nux,
+			      double cartCost) {
+  IndexT histIdx = histSet->lookup(nux.getNodeIdx(), nux.getPredIdx());
+  return histIdx == HistSet::noHist ? cartCost : histSet->fillCost(histIdx) + nux.getRunCount();
+}
+
+
+SFRegHist::SFRegHist(Frontier* frontier) :
+  SFRegCart(frontier),
+  histSet(nullptr) {
+}
+
+
+SFCtgHist::SFCtgHist(Frontier* frontier) :
+  SFCtgCart(frontier),
+  histSet(nullptr) {
+}
+
+
+void SFRegHist::stageCandidates(const vector<SplitNux>& sc) {
+  histSet = interLevel->stageHist(0);
+  candHist = vector<IndexT>(sc.size(), HistSet::noHist);
+  stageHist(this, frame, interLevel, histSet, sc, candHist);
+}
+
+
+double SFRegHist::splitCost(const SplitNux& nux) const {
+  return histCost(histSet, nux, SplitFrontier::splitCost(nux));
+}
+
+
+void SFRegHist::evaluate(SplitNux& cand,
+			 IndexT pos) {
+  IndexT histIdx = candHist[pos];
+  if (histIdx == HistSet::noHist) {
+    split(cand);
+  }
+  else {
+    histSet->fill(this, histIdx);
+    HistAccumReg::split(this, histSet, histIdx, cand);
+  }
+}
+
+
+void SFCtgHist::stageCandidates(const vector<SplitNux>& sc) {
+  histSet = interLevel->stageHist(nCtg);
+  candHist = vector<IndexT>(sc.size(), HistSet::noHist);
+  if (!ctgPresent.empty()) // Compacted nodes:  sums are not by category.
+    return;
+
+  stageHist(this, frame, interLevel, histSet, sc, candHist);
+}
+
+
+double SFCtgHist::splitCost(const SplitNux& nux) const {
+  return histCost(histSet, nux, SplitFrontier::splitCost(nux));
+}
+
+
+void SFCtgHist::evaluate(SplitNux& cand,
+			 IndexT pos) {
+  IndexT histIdx = candHist[pos];
+  if (histIdx == HistSet::noHist) {
+    split(cand);
+  }
+  else {
+    histSet->fill(this, histIdx);
+    HistAccumCtg::split(this, histSet, histIdx, cand);
+  }
+}
@@ -0,0 +1,85 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef CART_SFHIST_H
+#define CART_SFHIST_H
+
+/**
+   @file sfhist.h
+
+   @brief Splits binned numeric predictors by per-node histograms.
+
+   @author Mark Seligman
+
+ */
+
+#include "sfcart.h"
+#include "histset.h"
+
+#include <vector>
+
+
+/**
+   @brief Histogram splitting for regression trees.
+
+   Binned numeric candidates lacking implicit observations are split
+   from histograms, other candidates as with CART.  The larger of two
+   siblings derives its histogram from the parent's, where retained.
+ */
+struct SFRegHist : public SFRegCart {
+  HistSet* histSet; // Histograms of the level's binned candidates.
+  vector<IndexT> candHist; // Per-candidate histogram index, else noHist.
+
+  SFRegHist(class Frontier* frontier_);
+
+  ~SFRegHist() = default;
+
+
+  /**
+     @brief Reserves a histogram for each eligible candidate.
+   */
+  void stageCandidates(const vector<class SplitNux>& sc);
+
+
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
+
+
+  /**
+     @brief Costs histogram candidates by the fill and scan required.
+   */
+  double splitCost(const class SplitNux& nux) const;
+};
+
+
+/**
+   @brief Histogram splitting for categorical trees.
+
+   Histograms are built only for responses narrow enough to escape
+   per-node category compaction.
+ */
+class SFCtgHist : public SFCtgCart {
+  HistSet* histSet; // Histograms of the level's binned candidates.
+  vector<IndexT> candHist; // Per-candidate histogram index, else noHist.
+
+  void stageCandidates(const vector<class SplitNux>& sc);
+
+
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
+
+public:
+  SFCtgHist(class Frontier* frontier_);
+
+  ~SFCtgHist() = default;
+
+
+  double splitCost(const class SplitNux& nux) const;
+};
+
+
+#endif
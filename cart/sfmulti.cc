@@ -0,0 +1,70 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file sfmulti.cc
+
+   @brief Methods to implement joint splitting of several responses.
+
+   @author Mark Seligman
+ */
+
+
+#include "frontier.h"
+#include "sfmulti.h"
+#include "splitnux.h"
+#include "trainparam.h"
+#include "multiaccum.h"
+
+
+SFRegMulti::SFRegMulti(Frontier* frontier) :
+  SFReg(frontier, false, EncodingStyle::trueBranch, SplitStyle::slots),
+  nOut(frontier->getParam()->nOut),
+  yMulti(frontier->getParam()->yMulti),
+  sampledObs(frontier->getSampledObs()) {
+}
+
+
+void SFRegMulti::accumPreset() {
+  SFReg::accumPreset();
+  const SampleMap& smNonterm = frontier->getNontermMap();
+  nodeMulti = vector<double>(nSplit * nOut);
+  for (IndexT splitIdx = 0; splitIdx != nSplit; splitIdx++) {
+    double* nodeSum = &nodeMulti[splitIdx * nOut];
+    IndexRange range = smNonterm.range[splitIdx];
+    for (IndexT idx = range.getStart(); idx != range.getEnd(); idx++) {
+      IndexT sIdx = smNonterm.sampleIndex[idx];
+      IndexT sCount = sampledObs->getSCount(sIdx);
+      const double* y = getResponse(sIdx);
+      for (unsigned int out = 0; out != nOut; out++) {
+	nodeSum[out] += sCount * y[out];
+      }
+    }
+  }
+}
+
+
+void SFRegMulti::evaluate(SplitNux& cand,
+			  IndexT) {
+  split(cand);
+}
+
+
+void SFRegMulti::split(SplitNux& cand) {
+  if (isFactor(cand)) {
+    RunAccumMulti::split(this, runSet.get(), cand);
+  }
+  else {
+    CutAccumMulti::split(this, cand);
+  }
+}
+
+
+vector<double> SFRegMulti::nodeSums(const SplitNux& cand) const {
+  auto nodeSum = nodeMulti.begin() + cand.getNodeIdx() * nOut;
+  return vector<double>(nodeSum, nodeSum + nOut);
+}
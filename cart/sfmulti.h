@@ -0,0 +1,94 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef CART_SFMULTI_H
+#define CART_SFMULTI_H
+
+/**
+   @file sfmulti.h
+
+   @brief Splits several regression responses jointly.
+
+   @author Mark Seligman
+
+ */
+
+#include "typeparam.h"
+#include "splitfrontier.h"
+#include "sampledobs.h"
+
+#include <vector>
+
+
+/**
+   @brief Joint splitting of several regression responses.
+
+   Splits maximize the reduction in squared error summed over the
+   responses.  Responses are looked up through the sampled rows, as
+   the staged observations carry only the summary response.  The
+   summary orders factor runs and scores the nodes.
+
+   Cuts are evaluated exhaustively:  neither histograms nor sketches
+   are employed.
+ */
+class SFRegMulti : public SFReg {
+  const unsigned int nOut; ///< # responses.
+  const vector<double>& yMulti; ///< Row-major training responses.
+  const class SampledObs* sampledObs; ///< Maps samples to rows.
+  vector<double> nodeMulti; ///< Node x response sums, per level.
+
+public:
+  SFRegMulti(class Frontier* frontier_);
+
+  ~SFRegMulti() = default;
+
+
+  /**
+     @brief Accumulates the per-response sums of each node.
+   */
+  void accumPreset();
+
+
+  void evaluate(class SplitNux& cand,
+		IndexT pos);
+
+
+  /**
+     @brief Dispatches to the run or cut accumulator.
+   */
+  void split(class SplitNux& cand);
+
+
+  /**
+     @return number of responses.
+   */
+  unsigned int getNOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @brief Looks up the responses of a sample's row.
+
+     @param sIdx is the sample index.
+
+     @return responses, unweighted by sample count.
+   */
+  inline const double* getResponse(IndexT sIdx) const {
+    return &yMulti[static_cast<size_t>(sampledObs->getRow(sIdx)) * nOut];
+  }
+
+
+  /**
+     @brief Copies the per-response sums of a candidate's node.
+
+     @return sample-weighted sums, as a vector owned by the caller.
+   */
+  vector<double> nodeSums(const class SplitNux& cand) const;
+};
+
+#endif
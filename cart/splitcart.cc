@@ -16,15 +16,34 @@
 
 #include "splitfrontier.h"
 #include "sfcart.h"
+#include "sfextra.h"
+#include "sfhist.h"
+#include "sfmulti.h"
 #include "splitcart.h"
 #include "frontier.h"
+#include "trainparam.h"
+#include "predictorframe.h"
 
 
 unique_ptr<SplitFrontier> SplitCart::factory(Frontier* frontier) {
+  bool extraTrees = frontier->getParam()->extraTrees;
+  bool binned = frontier->getFrame()->isBinned();
   if (frontier->getNCtg() > 0) {
-    return make_unique<SFCtgCart>(frontier);
+    if (extraTrees)
+      return make_unique<SFCtgExtra>(frontier);
+    else if (binned)
+      return make_unique<SFCtgHist>(frontier);
+    else
+      return make_unique<SFCtgCart>(frontier);
   }
   else {
-    return make_unique<SFRegCart>(frontier);
+    if (frontier->getParam()->nOut != 0)
+      return make_unique<SFRegMulti>(frontier);
+    else if (extraTrees)
+      return make_unique<SFRegExtra>(frontier);
+    else if (binned)
+      return make_unique<SFRegHist>(frontier);
+    else
+      return make_unique<SFRegCart>(frontier);
   }
 }
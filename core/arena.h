@@ -0,0 +1,130 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file arena.h
+
+   @brief Read-only contiguous storage, either owned or aliased.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_ARENA_H
+#define CORE_ARENA_H
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+
+/**
+   @brief Flattened block presenting the read-only face of a vector.
+
+   An arena either owns its items or aliases memory held elsewhere,
+   such as a mapped model file, which must then outlive the arena.
+   Copying is disallowed, as aliases would dangle on the copy's side.
+ */
+template<typename itemType>
+class Arena {
+  vector<itemType> owned; // Backing store, iff not aliasing.
+  const itemType* base; // Base of items, owned or aliased.
+  size_t nItem; // # items.
+
+public:
+  Arena() :
+    base(nullptr),
+    nItem(0) {
+  }
+
+
+  /**
+     @brief Owning constructor.
+   */
+  Arena(vector<itemType> items) :
+    owned(move(items)),
+    base(owned.data()),
+    nItem(owned.size()) {
+  }
+
+
+  /**
+     @brief Aliasing constructor.
+   */
+  Arena(const itemType* base_,
+	size_t nItem_) :
+    base(base_),
+    nItem(nItem_) {
+  }
+
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+
+  /**
+     @brief Moves preserve the owned buffer, hence the base.
+   */
+  Arena(Arena&& other) :
+    owned(move(other.owned)),
+    base(other.base),
+    nItem(other.nItem) {
+  }
+
+
+  Arena& operator=(Arena&& other) {
+    owned = move(other.owned);
+    base = other.base;
+    nItem = other.nItem;
+    return *this;
+  }
+
+
+  /**
+     @return true iff items are held elsewhere.
+   */
+  bool isAliased() const {
+    return nItem != 0 && owned.empty();
+  }
+
+
+  size_t size() const {
+    return nItem;
+  }
+
+
+  bool empty() const {
+    return nItem == 0;
+  }
+
+
+  const itemType* data() const {
+    return base;
+  }
+
+
+  const itemType* begin() const {
+    return base;
+  }
+
+
+  const itemType* end() const {
+    return base + nItem;
+  }
+
+
+  const itemType& operator[](size_t idx) const {
+    return base[idx];
+  }
+
+
+  const itemType& back() const {
+    return base[nItem - 1];
+  }
+};
+
+#endif
@@ -0,0 +1,60 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file bufferpool.cc
+
+   @brief Methods for per-thread buffer recycling.
+
+   @author Mark Seligman
+ */
+
+#include "bufferpool.h"
+
+
+BufferPool& BufferPool::local() {
+  static thread_local BufferPool pool;
+  return pool;
+}
+
+
+size_t BufferPool::sizeClass(size_t nByte) {
+  size_t classSize = classMin;
+  while (classSize < nByte) {
+    classSize <<= 1;
+  }
+  return classSize;
+}
+
+
+char* BufferPool::acquireBytes(size_t nByte) {
+  size_t classSize = sizeClass(nByte);
+  auto it = idle.find(classSize);
+  if (it == idle.end() || it->second.empty()) {
+    return new char[classSize];
+  }
+  char* buf = it->second.back().release();
+  it->second.pop_back();
+  return buf;
+}
+
+
+void BufferPool::releaseBytes(char* buf,
+			      size_t nByte) {
+  vector<unique_ptr<char[]>>& classIdle = idle[sizeClass(nByte)];
+  if (classIdle.size() < retainMax) {
+    classIdle.emplace_back(buf);
+  }
+  else {
+    delete [] buf;
+  }
+}
+
+
+void BufferPool::clear() {
+  local().idle.clear();
+}
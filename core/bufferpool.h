@@ -0,0 +1,97 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file bufferpool.h
+
+   @brief Per-thread recycling of large, tree-scoped buffers.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_BUFFERPOOL_H
+#define CORE_BUFFERPOOL_H
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <type_traits>
+
+using namespace std;
+
+
+/**
+   @brief Idle buffers, keyed by power-of-two size class.
+
+   Most per-tree buffers have the same bag-dependent shape in every
+   tree, so a thread training successive trees can reuse memory
+   already faulted in by its predecessors.  Each thread holds its own
+   pool, hence no locking.  A buffer is returned to the pool of the
+   releasing thread, which need not be that of acquisition.
+
+   Contents are uninitialized on acquisition, so only trivially
+   copyable types are admitted.
+ */
+class BufferPool {
+  static constexpr unsigned int retainMax = 4; // Idle buffers per class.
+  static constexpr size_t classMin = 1 << 12; // Smallest class, bytes.
+
+  map<size_t, vector<unique_ptr<char[]>>> idle; // Idle buffers, by class.
+
+  /**
+     @return smallest power of two accommodating a request.
+   */
+  static size_t sizeClass(size_t nByte);
+
+
+  char* acquireBytes(size_t nByte);
+
+
+  void releaseBytes(char* buf,
+		    size_t nByte);
+
+public:
+
+  /**
+     @return pool of the calling thread.
+   */
+  static BufferPool& local();
+
+
+  /**
+     @brief Borrows an uninitialized buffer.
+
+     @param nItem is the number of items the buffer must hold.
+   */
+  template<typename itemType>
+  static itemType* acquire(size_t nItem) {
+    static_assert(is_trivially_copyable<itemType>::value, "Pooled items must be trivially copyable");
+    return reinterpret_cast<itemType*>(local().acquireBytes(nItem * sizeof(itemType)));
+  }
+
+
+  /**
+     @brief Returns a buffer to the calling thread's pool.
+
+     @param nItem is the item count with which the buffer was acquired.
+   */
+  template<typename itemType>
+  static void release(itemType* buf,
+		      size_t nItem) {
+    if (buf != nullptr)
+      local().releaseBytes(reinterpret_cast<char*>(buf), nItem * sizeof(itemType));
+  }
+
+
+  /**
+     @brief Frees the calling thread's idle buffers.
+   */
+  static void clear();
+};
+
+#endif
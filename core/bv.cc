@@ -16,6 +16,9 @@
 #include "bv.h"
 
 
+constexpr size_t BV::allOnes;
+
+
 void BV::resize(size_t bitMin) {
   size_t slotMin = slotAlign(bitMin);
   if (nSlot >= slotMin)
@@ -30,6 +33,36 @@ void BV::resize(size_t bitMin) {
 }
 
 
+size_t BV::popCount() const {
+  size_t count = 0;
+  for (size_t i = 0; i < nSlot; i++) {
+    count += __builtin_popcountll(raw[i]);
+  }
+  return count;
+}
+
+
+void BV::setRange(size_t bitStart,
+		  size_t bitEnd,
+		  bool on) {
+  if (bitStart >= bitEnd)
+    return;
+  size_t slotStart = bitStart / slotElts;
+  size_t slotLast = (bitEnd - 1) / slotElts;
+  BVSlotT maskStart = allOnes << (bitStart - slotStart * slotElts);
+  BVSlotT maskLast = allOnes >> ((slotLast + 1) * slotElts - bitEnd);
+  BVSlotT* out = rawV.data();
+  if (slotStart == slotLast) {
+    BVSlotT mask = maskStart & maskLast;
+    out[slotStart] = on ? (out[slotStart] | mask) : (out[slotStart] & ~mask);
+    return;
+  }
+  out[slotStart] = on ? (out[slotStart] | maskStart) : (out[slotStart] & ~maskStart);
+  fill(out + slotStart + 1, out + slotLast, on ? allOnes : 0);
+  out[slotLast] = on ? (out[slotLast] | maskLast) : (out[slotLast] & ~maskLast);
+}
+
+
 void BV::delEncode(const vector<IndexT>& delPos) {
   const unsigned int slotBits = getSlotElts();
   unsigned int log2Bits = 0ul;
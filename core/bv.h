@@ -145,53 +145,141 @@ class BV {
   }
 
 
-  BV operator|(const BV& bvR) {
-    /*
-    if (bvR.getNSlot() != nSlot) {
-      throw std::invalid_argument("mismatched bit vector | operation");
-      }*/
+  /**
+     @brief Copies the leading slots of another vector, growing as needed.
+
+     @param bvSrc is the vector copied.
+
+     @param bitPos is the slot-aligned destination position.
+
+     @param bitEnd specifies the ending bit position of the source.
+   */
+  void insertSlots(const BV& bvSrc,
+		   size_t bitPos,
+		   size_t bitEnd) {
+    resize(bitPos + bitEnd);
+    copy(bvSrc.raw, bvSrc.raw + slotAlign(bitEnd), rawV.begin() + bitPos / slotElts);
+  }
+
+
+  // Bulk operations run over raw slot pointers, free of aliasing
+  // through the vector, so that compilers emit vector instructions.
+  // Operands are assumed to have matching slot counts.
+
+  BV operator|(const BV& bvR) const {
     BV bvOr(this);
+    BVSlotT* out = bvOr.rawV.data();
+    const BVSlotT* left = raw;
+    const BVSlotT* right = bvR.raw;
     for (size_t i = 0; i < nSlot; i++) {
-      bvOr.rawV[i] = raw[i] | bvR.raw[i];
+      out[i] = left[i] | right[i];
     }
     return bvOr;
   }
 
   
   BV& operator&=(const BV& bvR) {
-    /*
-    if (nSlot != bvR.getNSlot()) {
-      throw std::invalid_argument("mismatched bit vector &= operation");
-      }*/
-
+    BVSlotT* out = rawV.data();
+    const BVSlotT* right = bvR.raw;
     for (size_t i = 0; i < nSlot; i++) {
-      rawV[i] &= bvR.raw[i];
+      out[i] &= right[i];
     }
     return *this;
   }
 
 
   BV& operator|=(const BV& bvR) {
-    /*
-    if (nSlot != bvR.getNSlot()) {
-      throw std::invalid_argument("mismatched bit vector |= operation");
-      }*/
+    BVSlotT* out = rawV.data();
+    const BVSlotT* right = bvR.raw;
+    for (size_t i = 0; i < nSlot; i++) {
+      out[i] |= right[i];
+    }
+    return *this;
+  }
+
 
+  /**
+     @brief Clears those bits set in another vector.
+   */
+  BV& andNot(const BV& bvR) {
+    BVSlotT* out = rawV.data();
+    const BVSlotT* right = bvR.raw;
     for (size_t i = 0; i < nSlot; i++) {
-      rawV[i] |= bvR.raw[i];
+      out[i] &= ~right[i];
     }
     return *this;
   }
 
 
-  BV operator~() {
+  BV operator~() const {
     BV bvTilde(this);
+    BVSlotT* out = bvTilde.rawV.data();
+    const BVSlotT* in = raw;
     for (size_t i = 0; i < nSlot; i++) {
-      bvTilde.rawV[i] = ~raw[i];
+      out[i] = ~in[i];
     }
     return bvTilde;
   }
 
+
+  /**
+     @return count of set bits, over all slots.
+   */
+  size_t popCount() const;
+
+
+  /**
+     @brief Sets or clears a range of bits, whole slots at a time.
+
+     @param bitStart is the first position affected.
+
+     @param bitEnd is the position beyond the last affected.
+   */
+  void setRange(size_t bitStart,
+		size_t bitEnd,
+		bool on = true);
+
+
+  /**
+     @brief Scans an external slot buffer for a set bit, skipping
+     empty slots whole.
+
+     @param flip is xored with each slot:  all ones scans for clear bits.
+
+     @return least qualifying position in [pos, end), else end.
+   */
+  static inline size_t scanSlots(const BVSlotT slots[],
+				 size_t pos,
+				 size_t end,
+				 BVSlotT flip = 0) {
+    while (pos < end) {
+      size_t slot = pos / slotElts;
+      BVSlotT bits = (slots[slot] ^ flip) >> (pos - slot * slotElts);
+      if (bits != 0)
+	return min(end, pos + static_cast<size_t>(__builtin_ctzll(bits)));
+      pos = (slot + 1) * slotElts;
+    }
+    return end;
+  }
+
+
+  /**
+     @return least set position in [pos, end), else end.
+   */
+  inline size_t findNext(size_t pos,
+			 size_t end) const {
+    return scanSlots(raw, pos, end);
+  }
+
+
+  /**
+     @return least clear position in [pos, end), else end.
+   */
+  inline size_t findNextClear(size_t pos,
+			      size_t end) const {
+    return scanSlots(raw, pos, end, allOnes);
+  }
+
   
   /**
      @brief Resizes to accommodate desired bit size.
@@ -270,6 +358,14 @@ class BV {
     return (raw[slot] & mask) == mask;
   }
 
+
+  /**
+     @return contents of the specified slot.
+   */
+  inline BVSlotT getSlot(size_t slot) const {
+    return raw[slot];
+  }
+
   
   /**
      @brief Tests the bit at a specified position.
@@ -287,6 +383,20 @@ class BV {
     return test(slot, mask);
   }
 
+
+  /**
+     @brief As above, but tests an external slot buffer directly.
+
+     @param slots is the base of the buffer.
+   */
+  static inline bool testBit(const BVSlotT slots[],
+			     size_t pos) {
+    BVSlotT mask;
+    size_t slot = slotMask(pos, mask);
+
+    return (slots[slot] & mask) == mask;
+  }
+
   
   /**
      @brief Sets the bit at position 'pos'.
@@ -308,6 +418,49 @@ class BV {
     rawV[slot] = val;
   }
 
+
+  /**
+     @brief Writes a list of values into whole slots, prefixed by its length.
+
+     @param bitPos is a slot-aligned position.
+
+     @param vals are the values, sorted ascending.
+   */
+  void setList(size_t bitPos,
+	       const vector<IndexT>& vals) {
+    size_t slot = bitPos / slotElts;
+    rawV[slot] = vals.size();
+    for (IndexT val : vals) {
+      rawV[++slot] = val;
+    }
+  }
+
+
+  /**
+     @brief Tests membership in a list written by setList().
+
+     @param slots is the base of an external slot buffer.
+
+     @param bitPos is the position of the list.
+
+     @return true iff value appears in the list.
+   */
+  static inline bool testList(const BVSlotT slots[],
+			      size_t bitPos,
+			      BVSlotT val) {
+    const BVSlotT* list = slots + bitPos / slotElts;
+    return binary_search(list + 1, list + 1 + list[0], val);
+  }
+
+
+  /**
+     @brief As above, but tests the internal buffer.
+   */
+  inline bool testList(size_t bitPos,
+		       BVSlotT val) const {
+    return testList(raw, bitPos, val);
+  }
+
   /**
      @brief Sets all slots to zero.
    */
@@ -391,6 +544,14 @@ class BitMatrix : public BV {
     return stride == 0 ? false : BV::testBit(row * stride + col);
   }
 
+
+  /**
+     @return slot holding the specified run of columns within a row.
+   */
+  inline BVSlotT getSlot(unsigned int row, size_t slotCol) const {
+    return BV::getSlot(row * (stride / slotElts) + slotCol);
+  }
+
   
   inline void setBit(unsigned int row,
 		     IndexT col,
@@ -402,6 +563,19 @@ class BitMatrix : public BV {
   inline void clearBit(unsigned int row, IndexT col) {
     setBit(row, col, false);
   }
+
+
+  /**
+     @return least column in [col, colEnd) clear within a row, else colEnd.
+   */
+  inline IndexT nextClear(unsigned int row,
+			  IndexT col,
+			  IndexT colEnd) const {
+    if (stride == 0)
+      return min(col, colEnd);
+    size_t base = static_cast<size_t>(row) * stride;
+    return findNextClear(base + col, base + colEnd) - base;
+  }
 };
 
 
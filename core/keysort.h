@@ -0,0 +1,146 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file keysort.h
+
+   @brief Stable ranking of short sequences of floating-point keys.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_KEYSORT_H
+#define CORE_KEYSORT_H
+
+#include "bheap.h"
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Ranks slots by key, as when ordering factor runs.
+
+   Sequences are short, typically tens of elements and occasionally
+   thousands, and are ranked in full.  Short sequences are sorted by
+   insertion, which is branch-predictable and touches a single cache
+   line or two.  Longer sequences are radix sorted on the bit pattern
+   of the key, in byte-wide digits, skipping digits on which all keys
+   agree.  Both are stable, so ties rank by slot.
+ */
+namespace KeySort {
+  static constexpr size_t insertionMax = 64; ///> Longest insertion-sorted sequence.
+
+
+  /**
+     @brief Maps a key to an unsigned integer of like order.
+   */
+  inline uint64_t orderBits(double key) {
+    key += 0.0; // Identifies negative zero with zero.
+    uint64_t bits;
+    memcpy(&bits, &key, sizeof(bits));
+    return (bits >> 63) != 0 ? ~bits : bits | (1ull << 63);
+  }
+
+
+  /**
+     @brief Sorts pairs in place by increasing key, stably.
+   */
+  template<typename slotType>
+  void insertionSort(BHPair<slotType> pairVec[],
+		     size_t nElt) {
+    for (size_t idx = 1; idx < nElt; idx++) {
+      BHPair<slotType> input = pairVec[idx];
+      size_t dest = idx;
+      for (; dest > 0 && pairVec[dest - 1].key > input.key; dest--) {
+	pairVec[dest] = pairVec[dest - 1];
+      }
+      pairVec[dest] = input;
+    }
+  }
+
+
+  /**
+     @brief Sorts pairs in place by increasing key, stably, by
+     least-significant-digit radix passes.
+   */
+  template<typename slotType>
+  void radixSort(BHPair<slotType> pairVec[],
+		 size_t nElt) {
+    constexpr unsigned int nDigit = sizeof(uint64_t);
+    vector<uint64_t> bits(nElt);
+    vector<size_t> count(nDigit * 256);
+    for (size_t idx = 0; idx < nElt; idx++) {
+      bits[idx] = orderBits(pairVec[idx].key);
+      for (unsigned int digit = 0; digit < nDigit; digit++) {
+	count[digit * 256 + ((bits[idx] >> (8 * digit)) & 0xff)]++;
+      }
+    }
+
+    vector<BHPair<slotType>> pairAlt(nElt);
+    vector<uint64_t> bitsAlt(nElt);
+    BHPair<slotType>* pairSrc = pairVec;
+    BHPair<slotType>* pairDest = &pairAlt[0];
+    uint64_t* bitsSrc = &bits[0];
+    uint64_t* bitsDest = &bitsAlt[0];
+    for (unsigned int digit = 0; digit < nDigit; digit++) {
+      size_t* digitCount = &count[digit * 256];
+      unsigned int shift = 8 * digit;
+      if (digitCount[(bitsSrc[0] >> shift) & 0xff] == nElt)
+	continue; // All keys share this digit.
+
+      size_t offset = 0;
+      for (unsigned int val = 0; val < 256; val++) {
+	size_t valCount = digitCount[val];
+	digitCount[val] = offset;
+	offset += valCount;
+      }
+      for (size_t idx = 0; idx < nElt; idx++) {
+	size_t dest = digitCount[(bitsSrc[idx] >> shift) & 0xff]++;
+	pairDest[dest] = pairSrc[idx];
+	bitsDest[dest] = bitsSrc[idx];
+      }
+      swap(pairSrc, pairDest);
+      swap(bitsSrc, bitsDest);
+    }
+
+    if (pairSrc != pairVec)
+      copy(pairSrc, pairSrc + nElt, pairVec);
+  }
+
+
+  /**
+     @brief Ranks slots by increasing key.
+
+     @param pairVec holds the key of each slot at the slot's position,
+     and is left sorted.
+
+     @param nElt is the number of slots.
+
+     @return rank of each slot.
+   */
+  template<typename slotType>
+  vector<slotType> rank(BHPair<slotType> pairVec[],
+			slotType nElt) {
+    if (nElt <= insertionMax)
+      insertionSort<slotType>(pairVec, nElt);
+    else
+      radixSort<slotType>(pairVec, nElt);
+
+    vector<slotType> idxRank(nElt);
+    for (slotType pairIdx = 0; pairIdx < nElt; pairIdx++) {
+      idxRank[pairVec[pairIdx].slot] = pairIdx;
+    }
+    return idxRank;
+  }
+};
+
+#endif
@@ -0,0 +1,176 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file levelarena.h
+
+   @brief Bump allocation for objects living no longer than a tree level.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_LEVELARENA_H
+#define CORE_LEVELARENA_H
+
+#include "bufferpool.h"
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+
+/**
+   @brief Block-chained bump allocator, reset wholesale.
+
+   Deallocation is a no-op:  storage is reclaimed only by reset(),
+   which retains the blocks already acquired, so that a tree's later
+   levels allocate without consulting the heap.  Blocks are borrowed
+   from the thread's BufferPool, so that later trees also reuse them.
+   Not thread-safe:  allocation is confined to the thread driving the
+   tree's levels.
+ */
+class LevelArena {
+  static constexpr size_t blockMin = 1 << 16; // Minimal block size, bytes.
+
+  vector<char*> block; // Blocks acquired.
+  vector<size_t> blockSize; // Size of each block.
+  size_t blockIdx; // Block currently allocating.
+  size_t offset; // Bytes consumed from current block.
+
+public:
+  LevelArena() :
+    blockIdx(0),
+    offset(0) {
+  }
+
+
+  ~LevelArena() {
+    for (size_t idx = 0; idx < block.size(); idx++) {
+      BufferPool::release(block[idx], blockSize[idx]);
+    }
+  }
+
+
+  LevelArena(const LevelArena&) = delete;
+  LevelArena& operator=(const LevelArena&) = delete;
+
+
+  /**
+     @brief Carves an aligned region from the current block, advancing
+     to a further block if necessary.
+
+     @param nByte is the region size.
+
+     @param align is the required alignment, a power of two.
+   */
+  void* allocate(size_t nByte,
+		 size_t align) {
+    while (blockIdx < block.size()) {
+      uintptr_t base = reinterpret_cast<uintptr_t>(block[blockIdx]);
+      size_t start = ((base + offset + align - 1) & ~(uintptr_t(align) - 1)) - base;
+      if (start + nByte <= blockSize[blockIdx]) {
+	offset = start + nByte;
+	return block[blockIdx] + start;
+      }
+      blockIdx++;
+      offset = 0;
+    }
+
+    size_t sizeNew = max(static_cast<size_t>(blockMin), nByte + align); // Avoids odr-use.
+    block.push_back(BufferPool::acquire<char>(sizeNew));
+    blockSize.push_back(sizeNew);
+    blockIdx = block.size() - 1;
+    offset = 0;
+    return allocate(nByte, align);
+  }
+
+
+  /**
+     @brief Releases all regions at once, retaining the blocks.
+
+     Objects carved from the arena must have been destroyed.
+   */
+  void reset() {
+    blockIdx = 0;
+    offset = 0;
+  }
+};
+
+
+/**
+   @brief Standard allocator drawing from a LevelArena.
+
+   A null arena defers to the heap, so that containers of a single
+   type may hold either level-scoped or persistent contents.  Move
+   assignment propagates the allocator, as level containers are
+   routinely moved into longer-lived members.
+ */
+template<typename T>
+struct LevelAllocator {
+  typedef T value_type;
+  typedef true_type propagate_on_container_move_assignment;
+  typedef true_type propagate_on_container_swap;
+
+  LevelArena* arena; // Owning arena, iff non-null.
+
+  LevelAllocator(LevelArena* arena_ = nullptr) :
+    arena(arena_) {
+  }
+
+
+  template<typename U>
+  LevelAllocator(const LevelAllocator<U>& other) :
+    arena(other.arena) {
+  }
+
+
+  /**
+     @brief Copies are taken from the heap, lest they outlive the arena.
+   */
+  LevelAllocator select_on_container_copy_construction() const {
+    return LevelAllocator();
+  }
+
+
+  T* allocate(size_t n) {
+    if (arena == nullptr)
+      return allocator<T>().allocate(n);
+    else
+      return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+
+  void deallocate(T* p,
+		  size_t n) {
+    if (arena == nullptr)
+      allocator<T>().deallocate(p, n);
+  }
+};
+
+
+template<typename T, typename U>
+bool operator==(const LevelAllocator<T>& a,
+		const LevelAllocator<U>& b) {
+  return a.arena == b.arena;
+}
+
+
+template<typename T, typename U>
+bool operator!=(const LevelAllocator<T>& a,
+		const LevelAllocator<U>& b) {
+  return a.arena != b.arena;
+}
+
+
+template<typename T>
+using LevelVector = vector<T, LevelAllocator<T>>;
+
+#endif
@@ -0,0 +1,203 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file loadstat.h
+
+   @brief Thread utilization of parallel regions.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_LOADSTAT_H
+#define CORE_LOADSTAT_H
+
+#include "tracelog.h"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+using namespace std;
+
+/**
+   @brief Busy time and iteration counts of a region type, accumulated
+   over invocations.
+
+   A participant's busy time runs from its entry into the region until
+   it finds no further iterations, so excludes time waiting at the
+   join.  Participant-weighted sums allow invocations of differing
+   team size to be combined.
+ */
+struct LoadStat {
+  size_t nCall; // # invocations.
+  size_t nPart; // # participants, summed over invocations.
+  size_t nIter; // # iterations, " ".
+  size_t nIterMaxPart; // Greatest iteration count times team size, " ".
+  double tBusy; // Busy time, summed over participants and invocations.
+  double tMaxPart; // Greatest busy time times team size, summed over invocations.
+  double tSpanPart; // Wall time times team size, " ".
+
+  LoadStat() :
+    nCall(0),
+    nPart(0),
+    nIter(0),
+    nIterMaxPart(0),
+    tBusy(0.0),
+    tMaxPart(0.0),
+    tSpanPart(0.0) {
+  }
+
+
+  /**
+     @return ratio of greatest to mean busy time, weighted by
+     invocation, else zero if never busy.
+   */
+  double imbalance() const {
+    return tBusy > 0.0 ? tMaxPart / tBusy : 0.0;
+  }
+
+
+  /**
+     @return ratio of greatest to mean iteration count, as above.
+   */
+  double iterImbalance() const {
+    return nIter > 0 ? double(nIterMaxPart) / nIter : 0.0;
+  }
+
+
+  /**
+     @return fraction of the team's wall time spent busy.
+   */
+  double utilization() const {
+    return tSpanPart > 0.0 ? tBusy / tSpanPart : 0.0;
+  }
+
+
+  /**
+     @brief Folds in the statistics of further invocations.
+   */
+  void accum(const LoadStat& other) {
+    nCall += other.nCall;
+    nPart += other.nPart;
+    nIter += other.nIter;
+    nIterMaxPart += other.nIterMaxPart;
+    tBusy += other.tBusy;
+    tMaxPart += other.tMaxPart;
+    tSpanPart += other.tSpanPart;
+  }
+};
+
+
+/**
+   @brief Gathers the participants of a single invocation, folding
+   them into a LoadStat on destruction.
+
+   Inert when the target is null, in which case recording costs a
+   single test.  Each participant records only to its own slot, so
+   recording requires no synchronization; the target is read and
+   written only by the thread owning the tally.  While a trace is
+   recorded, each participant's busy interval is also traced, so that
+   idling at the join appears on the timeline.
+ */
+class LoadTally {
+  typedef chrono::steady_clock::time_point Stamp;
+
+  struct Cell {
+    double busy; // Participant's busy time.
+    size_t nIter; // Participant's iteration count.
+  };
+
+  LoadStat* target; // Accumulator, iff instrumenting.
+  const char* label; // Name of participants' trace spans.
+  const bool tracing; // Whether recording a trace on entry.
+  const Stamp start; // Entry into region.
+  vector<Cell> cell; // Per-participant slots.
+
+public:
+  /**
+     @param nPart is the team size.
+
+     @param label_ names the region on a trace, and must be static.
+   */
+  LoadTally(LoadStat* target_,
+	    unsigned int nPart,
+	    const char* label_ = "region") :
+    target(target_),
+    label(label_),
+    tracing(TraceLog::isEnabled()),
+    start(target == nullptr ? Stamp() : now()),
+    cell(vector<Cell>(target == nullptr ? 0 : nPart)) {
+  }
+
+
+  ~LoadTally() {
+    if (target == nullptr)
+      return;
+
+    double tSpan = chrono::duration<double>(now() - start).count();
+    double busyMax = 0.0;
+    size_t iterMax = 0;
+    for (const Cell& part : cell) {
+      target->nIter += part.nIter;
+      target->tBusy += part.busy;
+      busyMax = max(busyMax, part.busy);
+      iterMax = max(iterMax, part.nIter);
+    }
+    target->nIterMaxPart += iterMax * cell.size();
+    target->nCall++;
+    target->nPart += cell.size();
+    target->tMaxPart += busyMax * cell.size();
+    target->tSpanPart += tSpan * cell.size();
+  }
+
+
+  LoadTally(const LoadTally&) = delete;
+  LoadTally& operator=(const LoadTally&) = delete;
+
+
+  static Stamp now() {
+    return chrono::steady_clock::now();
+  }
+
+
+  bool isActive() const {
+    return target != nullptr;
+  }
+
+
+  /**
+     @return entry stamp for a participant, if instrumenting.
+   */
+  Stamp enter() const {
+    return (target == nullptr && !tracing) ? Stamp() : now();
+  }
+
+
+  /**
+     @brief Records a participant's exit from the region.
+
+     @param part is the participant's index within the team.
+
+     @param entry is the participant's entry stamp.
+
+     @param nIter is the number of iterations performed.
+   */
+  void exit(unsigned int part,
+	    const Stamp& entry,
+	    size_t nIter) {
+    if (tracing)
+      TraceLog::record(label, entry, nIter);
+    if (target != nullptr && part < cell.size()) {
+      cell[part].busy += chrono::duration<double>(now() - entry).count();
+      cell[part].nIter += nIter;
+    }
+  }
+};
+
+#endif
@@ -14,9 +14,14 @@
  */
 
 #include "ompthread.h"
+#include "taskpool.h"
 
 #include <algorithm>
 
+#ifdef __linux__
+  #include <sched.h>
+#endif
+
 // Cribbed from data.table.
 #ifdef _OPENMP
   #include <omp.h>
@@ -29,12 +34,33 @@ constexpr int omp_get_max_threads() {
 constexpr int omp_get_thread_limit() {
   return 1;
 }
+
+constexpr int omp_get_thread_num() {
+  return 0;
+}
+
+constexpr int omp_get_max_active_levels() {
+  return 1;
+}
+
+inline void omp_set_max_active_levels(int) {
+}
 #endif
 
 unsigned int OmpThread::nThread = OmpThread::nThreadDefault;
 
 const unsigned int OmpThread::maxThreads = 1024; // Cribbed from above.
 
+unsigned int OmpThread::spinCount = 0;
+
+bool OmpThread::keepWarm = false;
+
+Affinity OmpThread::affinity = Affinity::none;
+
+vector<unsigned int> OmpThread::cpuPlace;
+
+unsigned int OmpThread::nPinned = 0;
+
 
 void OmpThread::init(unsigned int nThread_) {
   unsigned int ompMax = std::min(omp_get_max_threads(), omp_get_thread_limit());
@@ -42,9 +68,103 @@ void OmpThread::init(unsigned int nThread_) {
   // Guards agains unreasonable value from system calls:
   unsigned int maxLocal = std::min(ompMax, maxThreads);
   nThread = nThread_ > 0 ? std::min(nThread_, maxLocal) : maxLocal;
+
+  if (TaskPool::getNWorker() > 0 && TaskPool::getNWorker() != nThread - 1)
+    TaskPool::halt(); // Warm pool of the wrong size:  restarts on use.
+  if (affinity != Affinity::none && nPinned != nThread)
+    pinTeam();
 }
 
 
 void OmpThread::deInit() {
+  if (!keepWarm)
+    TaskPool::halt();
   nThread = nThreadDefault;
 }
+
+
+void OmpThread::initPool(Affinity affinity_,
+			 const vector<unsigned int>& cpuList,
+			 unsigned int spinCount_,
+			 bool keepWarm_) {
+  TaskPool::halt(); // Workers restart under the new policy.
+  affinity = affinity_;
+  spinCount = spinCount_;
+  keepWarm = keepWarm_;
+  nPinned = 0;
+  cpuPlace = cpuList;
+#ifdef __linux__
+  cpu_set_t permitted;
+  CPU_ZERO(&permitted);
+  if (sched_getaffinity(0, sizeof(permitted), &permitted) == 0) {
+    if (cpuPlace.empty()) {
+      for (unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+	if (CPU_ISSET(cpu, &permitted))
+	  cpuPlace.push_back(cpu);
+      }
+    }
+    else { // Drops cpus the process may not use.
+      cpuPlace.erase(remove_if(cpuPlace.begin(), cpuPlace.end(), [&permitted](unsigned int cpu) {
+	    return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &permitted);
+	  }), cpuPlace.end());
+    }
+  }
+#endif
+  if (cpuPlace.empty())
+    affinity = Affinity::none;
+}
+
+
+void OmpThread::releasePool() {
+  initPool(Affinity::none, vector<unsigned int>(), 0, false);
+}
+
+
+void OmpThread::pinSelf(unsigned int idx) {
+  if (affinity == Affinity::none)
+    return;
+
+  size_t nCpu = cpuPlace.size();
+  size_t nTeam = std::max(1u, nThread);
+  size_t slot = (affinity == Affinity::scatter && nTeam <= nCpu) ? (idx * nCpu) / nTeam : idx % nCpu;
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(cpuPlace[slot], &cpuSet);
+  (void) sched_setaffinity(0, sizeof(cpuSet), &cpuSet); // Advisory.
+#else
+  (void) slot;
+#endif
+}
+
+
+void OmpThread::pinTeam() {
+  unsigned int nTeam = nThread;
+#pragma omp parallel default(shared) num_threads(std::max(1u, nTeam))
+  {
+    pinSelf(omp_get_thread_num());
+  }
+  nPinned = nTeam;
+}
+
+
+unsigned int OmpThread::threadIdx() {
+  return omp_get_thread_num();
+}
+
+
+OmpNest::OmpNest(unsigned int nOuter_) :
+  nThreadSaved(OmpThread::nThread),
+  levelSaved(omp_get_max_active_levels()),
+  nOuter(std::max(1u, std::min(nOuter_, OmpThread::nThread))) {
+  TaskPool::start(); // Sized to the full budget.
+  OmpThread::nThread = std::max(1u, nThreadSaved / nOuter);
+  if (OmpThread::nThread > 1)
+    omp_set_max_active_levels(std::max(levelSaved, 2));
+}
+
+
+OmpNest::~OmpNest() {
+  omp_set_max_active_levels(levelSaved);
+  OmpThread::nThread = nThreadSaved;
+}
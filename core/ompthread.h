@@ -18,16 +18,63 @@
 #define CORE_OMPTHREAD_H
 
 #include <memory>
+#include <vector>
 using namespace std;
 
 // Some versions of OpenMP will not parallelize on unsigned types.
 typedef size_t OMPBound;
 
+/**
+   @brief Placement of threads onto the permitted cpus.
+ */
+enum class Affinity {
+  none, // Left to the system.
+  compact, // Consecutive threads on consecutive cpus.
+  scatter // Threads spread evenly across the cpu list.
+};
+
+
 /**
    @brief Static members parametrize implementation of thread parallelism.
  */
 struct OmpThread {
   static unsigned int nThread;
+  static unsigned int spinCount; // # polls before an idle worker sleeps.
+  static bool keepWarm; // Whether the pool survives deinitialization.
+
+  /**
+     @brief Configures placement and idling of the persistent threads.
+
+     Remains in effect across calls to init() and deInit() until
+     released.
+
+     @param cpuList are the cpus eligible for placement, in order.  Empty
+     selects those permitted the process.  A NUMA domain is requested by
+     listing its cpus.
+
+     @param spinCount_ is the number of polls before an idle worker sleeps.
+
+     @param keepWarm_ is true iff the pool should persist between calls.
+   */
+  static void initPool(Affinity affinity_,
+		       const vector<unsigned int>& cpuList,
+		       unsigned int spinCount_,
+		       bool keepWarm_);
+
+
+  /**
+     @brief Reverts to unpinned, sleeping threads and halts the pool.
+   */
+  static void releasePool();
+
+
+  /**
+     @brief Pins the calling thread according to the placement policy.
+
+     @param idx is the thread's position within the pool.
+   */
+  static void pinSelf(unsigned int idx);
+
   /**
      @brief Sets number of threads to safe value.
    */
@@ -38,9 +85,48 @@ struct OmpThread {
    */
   static void deInit();
 
+
+  /**
+     @return index of the calling thread within its team.
+   */
+  static unsigned int threadIdx();
+
 private:
   static constexpr unsigned int nThreadDefault = 0; // Static initialization.
   static const unsigned int maxThreads;
+  static Affinity affinity;
+  static vector<unsigned int> cpuPlace; // Eligible cpus, in placement order.
+  static unsigned int nPinned; // Size of the team last pinned, else zero.
+
+
+  /**
+     @brief Pins the members of the OpenMP team, warming it as well.
+   */
+  static void pinTeam();
+};
+
+
+/**
+   @brief Scopes a two-level division of the thread budget.
+
+   While live, regions sized by OmpThread::nThread receive an equal
+   share of the budget, allowing them to nest within an outer team of
+   the requested size.  The budget and nesting depth are restored on
+   exit.
+ */
+class OmpNest {
+  const unsigned int nThreadSaved; // Budget on entry.
+  const int levelSaved; // Maximal active nesting depth on entry.
+
+public:
+  const unsigned int nOuter; // Size of outer team.
+
+  /**
+     @param nOuter_ is the requested size of the outer team.
+   */
+  OmpNest(unsigned int nOuter_);
+
+  ~OmpNest();
 };
 
 #endif
@@ -0,0 +1,92 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file pairsum.h
+
+   @brief Blocked pairwise summation of wide reductions.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_PAIRSUM_H
+#define CORE_PAIRSUM_H
+
+#include "typeparam.h"
+
+#include <cstdint>
+
+/**
+   @brief Streaming accumulator summing fixed-size blocks sequentially
+   and combining block sums pairwise.
+
+   Rounding error grows logarithmically, rather than linearly, with
+   the number of terms.  The association of terms depends only upon
+   their order, so that a range partitioned at block-aligned powers of
+   two and summed piecewise, as by concurrent sub-scans, combines to a
+   bit-identical total.
+ */
+class PairSum {
+  static constexpr unsigned int blockSize = 64; ///< Terms per block.
+  static constexpr unsigned int levelMax = 8 * sizeof(IndexT); ///< Carry depth.
+
+  double block; ///< Sum over the current, incomplete block.
+  unsigned int blockCount; ///< # terms in current block.
+  IndexT nFull; ///< # complete blocks; bit set iff level occupied.
+  double partial[levelMax]; ///< Sum of 2^level blocks, iff occupied.
+
+
+  /**
+     @brief Retires the current block, merging equal-sized partials.
+   */
+  inline void carry() {
+    double carried = block;
+    unsigned int level = 0;
+    while ((nFull >> level) & 1) {
+      carried = partial[level] + carried;
+      level++;
+    }
+    partial[level] = carried;
+    nFull++;
+    block = 0.0;
+    blockCount = 0;
+  }
+
+public:
+
+  PairSum() :
+    block(0.0),
+    blockCount(0),
+    nFull(0) {
+  }
+
+
+  /**
+     @brief Accumulates a single term.
+   */
+  inline void add(double term) {
+    block += term;
+    if (++blockCount == blockSize)
+      carry();
+  }
+
+
+  /**
+     @return sum of terms accumulated, combining partials from the
+     smallest upward.
+   */
+  inline double total() const {
+    double sum = block;
+    for (unsigned int level = 0; level != levelMax; level++) {
+      if ((nFull >> level) & 1)
+	sum = partial[level] + sum;
+    }
+    return sum;
+  }
+};
+
+#endif
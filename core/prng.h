@@ -18,6 +18,8 @@
 #define CORE_PRNG_H
 
 #include <vector>
+#include <memory>
+#include <cstdint>
 using namespace std;
 
 namespace PRNG {
@@ -55,4 +57,169 @@ namespace PRNG {
   vector<size_t> rUnifIndex(const vector<size_t>& scale);
 };
 
+
+/**
+   @brief Counter-based generator:  Philox4x32-10.
+
+   A variate is a pure function of key and counter, so that distinct
+   streams are had by fixing a portion of the counter.  No state other
+   than the counter advances, and none need be shared.
+ */
+class Philox {
+  static constexpr uint32_t mult0 = 0xD2511F53;
+  static constexpr uint32_t mult1 = 0xCD9E8D57;
+  static constexpr uint32_t weyl0 = 0x9E3779B9;
+  static constexpr uint32_t weyl1 = 0xBB67AE85;
+  static constexpr unsigned int nRound = 10;
+
+  const uint32_t key[2];
+  const uint64_t stream; // Fixed high half of the counter.
+  uint64_t count; // Low half, advanced per block.
+  uint32_t block[4]; // Most recently generated variates.
+  unsigned int blockIdx; // Next unconsumed slot in block.
+
+  /**
+     @brief Generates the block for the current counter.
+   */
+  void generate();
+
+public:
+
+  Philox(uint64_t seed,
+	 uint64_t stream_);
+
+
+  /**
+     @return next 32-bit variate in the stream.
+   */
+  inline uint32_t next() {
+    if (blockIdx == 4) {
+      generate();
+    }
+    return block[blockIdx++];
+  }
+
+
+  /**
+     @return uniform variate on [0, 1) with 53 random bits.
+   */
+  inline double unif() {
+    uint64_t hi = next() >> 5;
+    uint64_t lo = next() >> 6;
+    return (hi * 67108864.0 + lo) * (1.0 / 9007199254740992.0);
+  }
+};
+
+
+/**
+   @brief Generator private to the calling thread.
+
+   Front-end generators may be called from the master thread only.
+   Training instead draws from a core stream keyed by a single
+   front-end seed and indexed by tree.  Results then depend on the
+   seed alone, not on scheduling or thread count, and so remain
+   reproducible under a fixed front-end seed.  The front end's
+   generators defer to the local stream while one is live.
+ */
+class PRNGLocal {
+  static thread_local unique_ptr<Philox> engine; // Null unless scoped.
+  static uint64_t streamBase; // Stream of the session's leading tree.
+  unique_ptr<Philox> parked; // Own engine while another is live.
+  unique_ptr<Philox> outer; // Engine live on entry, restored on exit.
+
+public:
+
+  /**
+     @brief Offsets stream indices, as when training a shard of a forest.
+
+     A shard whose base is its leading tree's absolute index then draws
+     the same streams as would the corresponding trees of a single
+     session keyed identically.
+   */
+  static void initStream(uint64_t streamBase_) {
+    streamBase = streamBase_;
+  }
+
+
+  static void deInitStream() {
+    streamBase = 0;
+  }
+
+
+  /**
+     @brief Draws a stream key from the front end.
+
+     Called once per training session, from the master thread.
+   */
+  static uint64_t sessionSeed();
+
+
+  /**
+     @brief Draws a key for a nested stream.
+
+     Drawn from the live engine, if any, so that the keys of a tree's
+     subtrees follow from the tree's own stream.
+
+     @return 64-bit stream key.
+   */
+  static uint64_t drawKey();
+
+
+  /**
+     @brief Scopes a stream on the calling thread.
+
+     Scopes nest:  an engine live on entry is reinstated on exit.
+
+     @param seed is the session key.
+
+     @param stream distinguishes the stream, typically by tree index.
+   */
+  PRNGLocal(uint64_t seed,
+	    uint64_t stream);
+
+  ~PRNGLocal();
+
+
+  /**
+     @brief Sets the engine aside, preserving its position.
+
+     Permits several scopes to interleave on a single thread, as when
+     the trees of a block are trained in lockstep.
+   */
+  void park() {
+    parked = move(engine);
+  }
+
+
+  /**
+     @brief Reinstates a parked engine as the thread's live engine.
+   */
+  void resume() {
+    engine = move(parked);
+  }
+
+
+  /**
+     @return true iff the calling thread has a live engine.
+   */
+  static bool active() {
+    return engine != nullptr;
+  }
+
+
+  /**
+     @return single uniform variate from the local engine.
+   */
+  static inline double unif() {
+    return engine->unif();
+  }
+
+
+  /**
+     @brief As PRNG::rUnif(), but drawing from the local engine.
+   */
+  static vector<double> rUnif(size_t len,
+			      double scale = 1.0);
+};
+
 #endif
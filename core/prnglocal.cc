@@ -0,0 +1,97 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file prnglocal.cc
+
+   @brief Core-native uniform variates, by stream.
+
+   @author Mark Seligman
+ */
+
+#include "prng.h"
+
+#include <cmath>
+
+thread_local unique_ptr<Philox> PRNGLocal::engine = nullptr;
+uint64_t PRNGLocal::streamBase = 0;
+
+
+Philox::Philox(uint64_t seed,
+	       uint64_t stream_) :
+  key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+  stream(stream_),
+  count(0),
+  blockIdx(4) {
+}
+
+
+void Philox::generate() {
+  uint32_t ctr[4] = {static_cast<uint32_t>(count),
+		     static_cast<uint32_t>(count >> 32),
+		     static_cast<uint32_t>(stream),
+		     static_cast<uint32_t>(stream >> 32)};
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (unsigned int round = 0; round < nRound; round++) {
+    uint64_t prod0 = static_cast<uint64_t>(mult0) * ctr[0];
+    uint64_t prod1 = static_cast<uint64_t>(mult1) * ctr[2];
+    uint32_t hi0 = prod0 >> 32;
+    uint32_t hi1 = prod1 >> 32;
+    ctr[0] = hi1 ^ ctr[1] ^ k0;
+    ctr[1] = static_cast<uint32_t>(prod1);
+    ctr[2] = hi0 ^ ctr[3] ^ k1;
+    ctr[3] = static_cast<uint32_t>(prod0);
+    k0 += weyl0;
+    k1 += weyl1;
+  }
+  for (unsigned int i = 0; i < 4; i++) {
+    block[i] = ctr[i];
+  }
+  count++;
+  blockIdx = 0;
+}
+
+
+uint64_t PRNGLocal::sessionSeed() {
+  // Two front-end variates supply the full key width.
+  vector<double> ru = PRNG::rUnif(2);
+  return (static_cast<uint64_t>(ldexp(ru[0], 32)) << 32) | static_cast<uint64_t>(ldexp(ru[1], 32));
+}
+
+
+uint64_t PRNGLocal::drawKey() {
+  if (engine == nullptr)
+    return sessionSeed();
+
+  uint64_t hi = engine->next();
+  uint64_t lo = engine->next();
+  return (hi << 32) | lo;
+}
+
+
+PRNGLocal::PRNGLocal(uint64_t seed,
+		     uint64_t stream) :
+  outer(move(engine)) {
+  engine = make_unique<Philox>(seed, streamBase + stream);
+}
+
+
+PRNGLocal::~PRNGLocal() {
+  if (parked == nullptr)
+    engine = move(outer);
+}
+
+
+vector<double> PRNGLocal::rUnif(size_t len,
+				double scale) {
+  vector<double> rv(len);
+  for (auto & val : rv) {
+    val = engine->unif() * scale;
+  }
+  return rv;
+}
@@ -22,10 +22,15 @@
 
 #include <vector>
 #include <numeric>
+#include <unordered_set>
 
 using namespace std;
 
 namespace Sample {
+  // Sparse sampling without replacement is preferred when the sample
+  // count falls below this fraction of the sequence size.
+  constexpr size_t floydRatio = 16;
+
 
   template<typename indexType>
   struct Walker {
@@ -67,7 +72,7 @@ namespace Sample {
     }
 
     
-    vector<size_t> sample(size_t nSamp) {
+    vector<size_t> sample(size_t nSamp) const {
       vector<size_t> idxOut(nSamp);
 
       // Some implementions piggybacks index lookup with random weight
@@ -93,6 +98,9 @@ namespace Sample {
    
    @param nObs is the sequence size from which to sample.
 
+   Small samples employ Floyd's algorithm, whose state is proportional
+   to the sample count rather than to 'nObs'.
+
    @return vector of sampled indices.
  */
   template<typename indexType>
@@ -100,8 +108,25 @@ namespace Sample {
 				  indexType nObs) {
     vector<size_t> rn = PRNG::rUnifIndex(sampleScale);
     indexType nSamp = sampleScale.size();
-    vector<indexType> idxSeq(nObs);
     vector<indexType> idxOut(nSamp);
+    if (static_cast<size_t>(nSamp) * floydRatio < static_cast<size_t>(nObs)) {
+      // Variate 'i' lies in [0, nObs - i), so Floyd's ascending tops
+      // consume the variates in reverse.
+      unordered_set<indexType> drawn(2 * nSamp);
+      indexType outIdx = 0;
+      for (indexType i = nSamp; i-- > 0; ) {
+	indexType top = nObs - 1 - i;
+	indexType index = rn[i];
+	if (!drawn.insert(index).second) { // Already drawn:  top is fresh.
+	  index = top;
+	  drawn.insert(top);
+	}
+	idxOut[outIdx++] = index;
+      }
+      return idxOut;
+    }
+
+    vector<indexType> idxSeq(nObs);
     iota(idxSeq.begin(), idxSeq.end(), 0);
     for (indexType i = 0; i < nSamp; i++) {
       indexType index = rn[i];
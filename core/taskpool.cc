@@ -0,0 +1,201 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file taskpool.cc
+
+   @brief Methods for the persistent training scheduler.
+
+   @author Mark Seligman
+ */
+
+#include "taskpool.h"
+#include "loadstat.h"
+
+#include <algorithm>
+
+unsigned int TaskPool::nWorker = 0;
+vector<unique_ptr<TaskPool::WorkQueue>> TaskPool::queue;
+vector<thread> TaskPool::worker;
+mutex TaskPool::sleepLock;
+condition_variable TaskPool::wake;
+atomic<size_t> TaskPool::nQueued(0);
+atomic<unsigned int> TaskPool::dealIdx(0);
+bool TaskPool::halting = false;
+mutex TaskPool::startLock;
+thread_local int TaskPool::selfIdx = -1;
+
+
+void TaskGroup::submit(function<void()> task) {
+  nPending.fetch_add(1, memory_order_acq_rel);
+  TaskPool::enqueue(TaskPool::Task{move(task), this});
+}
+
+
+void TaskGroup::wait() {
+  while (!done()) {
+    if (!TaskPool::runOne())
+      this_thread::yield();
+  }
+}
+
+
+void TaskPool::start() {
+  lock_guard<mutex> guard(startLock);
+  if (nWorker > 0 || OmpThread::nThread <= 1)
+    return;
+
+  nWorker = OmpThread::nThread - 1; // Submitter participates.
+  for (unsigned int idx = 0; idx < nWorker; idx++) {
+    queue.emplace_back(make_unique<WorkQueue>());
+  }
+  for (unsigned int idx = 0; idx < nWorker; idx++) {
+    worker.emplace_back(work, idx);
+  }
+}
+
+
+void TaskPool::halt() {
+  lock_guard<mutex> guard(startLock);
+  if (nWorker == 0)
+    return;
+
+  {
+    lock_guard<mutex> sleepGuard(sleepLock);
+    halting = true;
+  }
+  wake.notify_all();
+  for (auto & thr : worker) {
+    thr.join();
+  }
+  worker.clear();
+  queue.clear();
+  nWorker = 0;
+  nQueued = 0;
+  halting = false;
+}
+
+
+void TaskPool::work(unsigned int idx) {
+  selfIdx = idx;
+  OmpThread::pinSelf(idx + 1); // Submitter occupies the first place.
+  unsigned int spinCount = OmpThread::spinCount;
+  while (true) {
+    if (runOne())
+      continue;
+
+    bool found = false;
+    for (unsigned int spin = 0; spin < spinCount && !found; spin++) {
+      this_thread::yield();
+      found = nQueued.load() > 0;
+    }
+    if (found)
+      continue;
+
+    unique_lock<mutex> sleepGuard(sleepLock);
+    wake.wait(sleepGuard, [] { return halting || nQueued.load() > 0; });
+    if (halting)
+      return;
+  }
+}
+
+
+void TaskPool::enqueue(Task&& task) {
+  if (nWorker == 0) { // No pool:  executes inline.
+    task.body();
+    task.group->retire();
+    return;
+  }
+
+  unsigned int idx = selfIdx >= 0 ? selfIdx : dealIdx++ % nWorker;
+  {
+    lock_guard<mutex> guard(queue[idx]->lock);
+    queue[idx]->task.emplace_back(move(task));
+  }
+  nQueued++;
+  { // Closes the window between a sleeper's test and its wait.
+    lock_guard<mutex> sleepGuard(sleepLock);
+  }
+  wake.notify_one();
+}
+
+
+bool TaskPool::acquire(Task& task) {
+  if (nQueued.load() == 0)
+    return false;
+
+  if (selfIdx >= 0) { // Own deque, newest first.
+    WorkQueue& own = *queue[selfIdx];
+    lock_guard<mutex> guard(own.lock);
+    if (!own.task.empty()) {
+      task = move(own.task.back());
+      own.task.pop_back();
+      nQueued--;
+      return true;
+    }
+  }
+
+  unsigned int base = selfIdx >= 0 ? selfIdx + 1 : 0;
+  for (unsigned int off = 0; off < nWorker; off++) { // Steals oldest.
+    WorkQueue& victim = *queue[(base + off) % nWorker];
+    lock_guard<mutex> guard(victim.lock);
+    if (!victim.task.empty()) {
+      task = move(victim.task.front());
+      victim.task.pop_front();
+      nQueued--;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool TaskPool::runOne() {
+  Task task;
+  if (!acquire(task))
+    return false;
+
+  task.body();
+  task.group->retire();
+  return true;
+}
+
+
+void TaskPool::parallelFor(OMPBound idxEnd,
+			   const function<void(OMPBound)>& body,
+			   LoadStat* load,
+			   const char* label) {
+  unsigned int nPart = min(static_cast<OMPBound>(OmpThread::nThread), idxEnd);
+  LoadTally tally(load, max(1u, nPart), label);
+  if (nPart <= 1) {
+    auto entry = tally.enter();
+    for (OMPBound idx = 0; idx < idxEnd; idx++) {
+      body(idx);
+    }
+    tally.exit(0, entry, idxEnd);
+    return;
+  }
+
+  start();
+  atomic<OMPBound> idxNext(0);
+  auto drain = [&idxNext, idxEnd, &body, &tally](unsigned int part) {
+    auto entry = tally.enter();
+    size_t nIter = 0;
+    for (OMPBound idx = idxNext++; idx < idxEnd; idx = idxNext++) {
+      body(idx);
+      nIter++;
+    }
+    tally.exit(part, entry, nIter);
+  };
+
+  TaskGroup group;
+  for (unsigned int part = 1; part < nPart; part++) {
+    group.submit([&drain, part]() { drain(part); });
+  }
+  drain(0);
+  group.wait();
+}
@@ -0,0 +1,174 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file taskpool.h
+
+   @brief Persistent work-stealing scheduler for fine-grained training stages.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_TASKPOOL_H
+#define CORE_TASKPOOL_H
+
+#include "ompthread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Tracks completion of a set of tasks.
+
+   Waiting on a group is the join point of the tasks submitted to it,
+   and so expresses dependence of subsequent work upon them.  Waiters
+   execute pending tasks rather than block, so groups may be waited on
+   from within tasks.
+ */
+class TaskGroup {
+  atomic<size_t> nPending; // # tasks submitted but not yet retired.
+
+public:
+  TaskGroup() :
+    nPending(0) {
+  }
+
+
+  /**
+     @brief Schedules a task as a member of the group.
+   */
+  void submit(function<void()> task);
+
+
+  /**
+     @brief Returns once all members have retired.
+   */
+  void wait();
+
+
+  /**
+     @brief Retires a member.
+   */
+  void retire() {
+    nPending.fetch_sub(1, memory_order_acq_rel);
+  }
+
+
+  bool done() const {
+    return nPending.load(memory_order_acquire) == 0;
+  }
+};
+
+
+/**
+   @brief Pool of workers persisting across training levels.
+
+   Each worker owns a deque:  tasks submitted by a worker are pushed onto
+   its own deque and popped LIFO, while idle workers steal FIFO from the
+   deques of others.  Submitters external to the pool deal their tasks
+   round-robin.  Workers are started on first use, sized to the thread
+   budget then in effect, and persist until the budget is deinitialized,
+   so levels incur no fork and join.
+ */
+class TaskPool {
+  struct Task {
+    function<void()> body;
+    TaskGroup* group;
+  };
+
+  struct WorkQueue {
+    mutex lock;
+    deque<Task> task;
+  };
+
+  static unsigned int nWorker; // # persistent threads.
+  static vector<unique_ptr<WorkQueue>> queue; // Per-worker deques.
+  static vector<thread> worker;
+  static mutex sleepLock;
+  static condition_variable wake;
+  static atomic<size_t> nQueued; // # tasks not yet dequeued.
+  static atomic<unsigned int> dealIdx; // Round-robin index for external submitters.
+  static bool halting;
+  static mutex startLock;
+  static thread_local int selfIdx; // Worker index, else -1.
+
+  /**
+     @brief Worker main loop.
+
+     Idle workers poll for OmpThread::spinCount iterations before sleeping.
+   */
+  static void work(unsigned int idx);
+
+
+  /**
+     @brief Dequeues a task, first locally, then by stealing.
+
+     @return true iff a task was dequeued.
+   */
+  static bool acquire(Task& task);
+
+
+  static void enqueue(Task&& task);
+
+public:
+
+  /**
+     @brief Ensures a pool sized to the current thread budget.
+   */
+  static void start();
+
+
+  /**
+     @brief Executes a single dequeued task, if any.
+
+     @return true iff a task was executed.
+   */
+  static bool runOne();
+
+
+  /**
+     @brief Joins and discards the workers.
+   */
+  static void halt();
+
+
+  /**
+     @return # persistent workers, zero if none running.
+   */
+  static unsigned int getNWorker() {
+    return nWorker;
+  }
+
+
+  /**
+     @brief Applies a body to a range of indices, as with dynamic scheduling.
+
+     Up to OmpThread::nThread participants, the caller included, draw
+     indices one at a time.  Small or single-threaded ranges execute on
+     the caller.
+
+     @param load accumulates the participants' busy time, if non-null.
+
+     @param label names the participants' spans on a trace.
+   */
+  static void parallelFor(OMPBound idxEnd,
+			  const function<void(OMPBound)>& body,
+			  struct LoadStat* load = nullptr,
+			  const char* label = "region");
+
+  friend class TaskGroup;
+};
+
+#endif
@@ -0,0 +1,99 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file tracelog.cc
+
+   @brief Recording and writing of timeline spans.
+
+   @author Mark Seligman
+ */
+
+#include "tracelog.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+atomic<bool> TraceLog::enabled(false);
+atomic<unsigned int> TraceLog::generation(0);
+size_t TraceLog::capacity = 0;
+TraceLog::Stamp TraceLog::origin;
+mutex TraceLog::ringLock;
+vector<unique_ptr<TraceLog::Ring>> TraceLog::ring;
+thread_local TraceLog::Ring* TraceLog::self = nullptr;
+thread_local unsigned int TraceLog::selfGeneration = 0;
+
+
+void TraceLog::start(size_t capacity_) {
+  if (capacity_ == 0)
+    throw invalid_argument("Trace capacity must be positive");
+
+  lock_guard<mutex> guard(ringLock);
+  enabled = false;
+  ring.clear();
+  capacity = capacity_;
+  origin = now();
+  generation++; // Orphans the rings of previous recordings.
+  enabled = true;
+}
+
+
+TraceLog::Ring* TraceLog::getRing() {
+  unsigned int current = generation.load(memory_order_acquire);
+  if (self == nullptr || selfGeneration != current) {
+    lock_guard<mutex> guard(ringLock);
+    ring.emplace_back(make_unique<Ring>(ring.size(), capacity));
+    self = ring.back().get();
+    selfGeneration = current;
+  }
+  return self;
+}
+
+
+void TraceLog::record(const char* name,
+		      const Stamp& start,
+		      long long arg) {
+  if (!isEnabled())
+    return;
+  Ring* own = getRing();
+  own->span[own->nRecorded++ % own->span.size()] = Span{name, start, now(), arg};
+}
+
+
+size_t TraceLog::dump(const string& path) {
+  lock_guard<mutex> guard(ringLock);
+  enabled = false;
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr)
+    throw runtime_error("Unable to open trace file " + path);
+
+  size_t nWritten = 0;
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (const unique_ptr<Ring>& own : ring) {
+    fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", nWritten == 0 ? "" : ",", own->tid, own->tid);
+    nWritten++;
+    size_t nRetained = min(own->nRecorded, own->span.size());
+    for (size_t idx = own->nRecorded - nRetained; idx != own->nRecorded; idx++) {
+      const Span& span = own->span[idx % own->span.size()];
+      double ts = chrono::duration<double, micro>(span.start - origin).count();
+      double dur = chrono::duration<double, micro>(span.end - span.start).count();
+      fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"arborist\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", span.name, own->tid, ts, dur);
+      if (span.arg >= 0)
+	fprintf(file, ",\"args\":{\"arg\":%lld}", span.arg);
+      fprintf(file, "}");
+    }
+    nWritten += nRetained;
+  }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+
+  size_t nSpan = nWritten - ring.size();
+  ring.clear();
+  generation++;
+  return nSpan;
+}
@@ -0,0 +1,148 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file tracelog.h
+
+   @brief Opt-in timeline of per-thread spans, in trace-event form.
+
+   @author Mark Seligman
+ */
+
+#ifndef CORE_TRACELOG_H
+#define CORE_TRACELOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+   @brief Records spans into per-thread rings and writes them as
+   Chrome/Perfetto trace-event JSON.
+
+   A thread registers a ring of its own on recording its first span, so
+   that recording takes no lock.  A full ring overwrites its oldest
+   spans.  Spans are written only by 'dump', which expects no span to be
+   open, as following training or prediction.  Disabled, a span costs a
+   single test of a flag.
+ */
+class TraceLog {
+public:
+  typedef chrono::steady_clock::time_point Stamp;
+
+private:
+  struct Span {
+    const char* name; // Static string.
+    Stamp start;
+    Stamp end;
+    long long arg; // Tree, level, row or similar, else negative.
+  };
+
+  struct Ring {
+    const unsigned int tid; // Registration order.
+    vector<Span> span; // Circular.
+    size_t nRecorded; // # spans recorded, including overwritten.
+
+    Ring(unsigned int tid_,
+	 size_t capacity) :
+      tid(tid_),
+      span(vector<Span>(capacity)),
+      nRecorded(0) {
+    }
+  };
+
+  static atomic<bool> enabled; // Whether recording.
+  static atomic<unsigned int> generation; // Advances with each start.
+  static size_t capacity; // Spans per ring.
+  static Stamp origin; // Onset of recording.
+  static mutex ringLock; // Guards registration.
+  static vector<unique_ptr<Ring>> ring; // Registered rings.
+  static thread_local Ring* self; // Calling thread's ring, if current.
+  static thread_local unsigned int selfGeneration; // Generation of 'self'.
+
+
+  /**
+     @return calling thread's ring, registered if not current.
+   */
+  static Ring* getRing();
+
+public:
+  /**
+     @brief Discards any spans recorded and begins recording.
+
+     @param capacity_ is the number of spans retained per thread.
+   */
+  static void start(size_t capacity_);
+
+
+  /**
+     @brief Writes the retained spans and ceases recording.
+
+     @param path names the file to be written.
+
+     @return number of spans written.
+   */
+  static size_t dump(const string& path);
+
+
+  static bool isEnabled() {
+    return enabled.load(memory_order_relaxed);
+  }
+
+
+  static Stamp now() {
+    return chrono::steady_clock::now();
+  }
+
+
+  /**
+     @brief Records a completed span on the calling thread.
+
+     @param name must have static storage.
+   */
+  static void record(const char* name,
+		     const Stamp& start,
+		     long long arg = -1);
+};
+
+
+/**
+   @brief Records a span over its own lifetime, if recording on entry.
+ */
+class TraceSpan {
+  const char* name;
+  const long long arg;
+  const bool active; // Whether recording on entry.
+  const TraceLog::Stamp start;
+
+public:
+  TraceSpan(const char* name_,
+	    long long arg_ = -1) :
+    name(name_),
+    arg(arg_),
+    active(TraceLog::isEnabled()),
+    start(active ? TraceLog::now() : TraceLog::Stamp()) {
+  }
+
+
+  ~TraceSpan() {
+    if (active)
+      TraceLog::record(name, start, arg);
+  }
+
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif
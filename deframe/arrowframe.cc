@@ -0,0 +1,200 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file arrowframe.cc
+
+   @brief Columnar ingestion through the Arrow C data interface.
+
+   @author Mark Seligman
+ */
+
+#include "arrowframe.h"
+#include "typeparam.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+  /**
+     @return true iff the format denotes a supported fixed-width type.
+   */
+  bool fixedWidth(const char* format) {
+    return format != nullptr && format[0] != '\0' && format[1] == '\0'
+      && strchr("cCsSiIlLfg", format[0]) != nullptr;
+  }
+
+
+  inline bool isValid(const uint8_t* validity,
+		      int64_t idx) {
+    return validity == nullptr || ((validity[idx >> 3] >> (idx & 7)) & 1);
+  }
+
+
+  /**
+     @brief Appends runs of a chunk's values, coalescing adjacent ties,
+     including across chunk boundaries.
+
+     @param decode maps a valid source value to the encoded value.
+
+     @param missing is the encoding of a null entry.
+   */
+  template<typename valType, typename srcType, typename Decode>
+  void appendRuns(vector<RLEVal<valType>>& runs,
+		  const ArrowArray* array,
+		  int64_t offset,
+		  size_t rowBase,
+		  valType missing,
+		  Decode decode) {
+    const uint8_t* validity = array->null_count == 0 ? nullptr : static_cast<const uint8_t*>(array->buffers[0]);
+    const srcType* data = static_cast<const srcType*>(array->buffers[1]);
+    int64_t base = array->offset + offset;
+    for (int64_t idx = 0; idx < array->length; idx++) {
+      valType val = isValid(validity, base + idx) ? decode(data[base + idx]) : missing;
+      if (!runs.empty() && runs.back().getRowEnd() == rowBase + idx && areEqual(val, runs.back().val)) {
+	runs.back().extent++;
+      }
+      else {
+	runs.emplace_back(val, rowBase + idx);
+      }
+    }
+  }
+
+
+  /**
+     @brief Dispatches on the chunk's format.
+   */
+  template<typename valType, typename Decode>
+  void appendChunk(vector<RLEVal<valType>>& runs,
+		   const char* format,
+		   const ArrowArray* array,
+		   int64_t offset,
+		   size_t rowBase,
+		   valType missing,
+		   Decode decode) {
+    switch (format[0]) {
+    case 'c':
+      appendRuns<valType, int8_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'C':
+      appendRuns<valType, uint8_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 's':
+      appendRuns<valType, int16_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'S':
+      appendRuns<valType, uint16_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'i':
+      appendRuns<valType, int32_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'I':
+      appendRuns<valType, uint32_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'l':
+      appendRuns<valType, int64_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'L':
+      appendRuns<valType, uint64_t>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'f':
+      appendRuns<valType, float>(runs, array, offset, rowBase, missing, decode);
+      break;
+    case 'g':
+      appendRuns<valType, double>(runs, array, offset, rowBase, missing, decode);
+      break;
+    }
+  }
+}
+
+
+vector<ArrowColumn> ArrowColumn::fromBatches(const ArrowSchema* schema,
+					     const vector<const ArrowArray*>& batch) {
+  if (schema->format == nullptr || strcmp(schema->format, "+s") != 0)
+    throw invalid_argument("Record batch schema must be a struct type");
+
+  vector<ArrowColumn> column;
+  for (int64_t field = 0; field < schema->n_children; field++) {
+    column.emplace_back(schema->children[field]);
+  }
+  for (const ArrowArray* array : batch) {
+    if (array->n_children != schema->n_children)
+      throw invalid_argument("Record batch does not conform to schema");
+    for (int64_t field = 0; field < array->n_children; field++) {
+      column[field].addChunk(array->children[field], array->offset);
+    }
+  }
+  return column;
+}
+
+
+size_t ArrowColumn::getLength() const {
+  size_t length = 0;
+  for (const Chunk& ck : chunk) {
+    length += ck.array->length;
+  }
+  return length;
+}
+
+
+void ArrowColumn::check() const {
+  if (!fixedWidth(schema->format))
+    throw invalid_argument(string("Unsupported Arrow format:  ") + (schema->format == nullptr ? "" : schema->format));
+  if (isFactor()) {
+    if (strchr("cCsSiIlL", schema->format[0]) == nullptr)
+      throw invalid_argument("Dictionary indices must be integral");
+    (void) getCardinality();
+  }
+  for (const Chunk& ck : chunk) {
+    if (ck.array->n_buffers != 2)
+      throw invalid_argument("Fixed-width chunk expected to have two buffers");
+  }
+}
+
+
+unsigned int ArrowColumn::getCardinality() const {
+  int64_t cardinality = -1;
+  for (const Chunk& ck : chunk) {
+    if (ck.array->dictionary == nullptr)
+      throw invalid_argument("Dictionary-encoded chunk lacks dictionary");
+    if (cardinality >= 0 && ck.array->dictionary->length != cardinality)
+      throw invalid_argument("Factor chunks must share a dictionary");
+    cardinality = ck.array->dictionary->length;
+  }
+  if (cardinality <= 0)
+    throw invalid_argument("Factor dictionary is empty");
+  return cardinality;
+}
+
+
+vector<RLEVal<double>> ArrowColumn::numRuns() const {
+  vector<RLEVal<double>> runs;
+  size_t rowBase = 0;
+  for (const Chunk& ck : chunk) {
+    appendChunk<double>(runs, schema->format, ck.array, ck.offset, rowBase, nan(""),
+			[](auto val) { return static_cast<double>(val); });
+    rowBase += ck.array->length;
+  }
+  return runs;
+}
+
+
+vector<RLEVal<unsigned int>> ArrowColumn::facRuns(unsigned int cardinality) const {
+  vector<RLEVal<unsigned int>> runs;
+  size_t rowBase = 0;
+  for (const Chunk& ck : chunk) {
+    // Out-of-range indices are treated as missing.
+    appendChunk<unsigned int>(runs, schema->format, ck.array, ck.offset, rowBase, cardinality + 1,
+			      [cardinality](auto idx) {
+				return (idx < 0 || static_cast<uint64_t>(idx) >= cardinality) ? cardinality + 1 : static_cast<unsigned int>(idx) + 1;
+			      });
+    rowBase += ck.array->length;
+  }
+  return runs;
+}
@@ -0,0 +1,161 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file arrowframe.h
+
+   @brief Columnar ingestion through the Arrow C data interface.
+
+   @author Mark Seligman
+ */
+
+#ifndef DEFRAME_ARROWFRAME_H
+#define DEFRAME_ARROWFRAME_H
+
+#include "rle.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// ABI-stable structures, as given by the Arrow specification.  The
+// guard admits coexistence with Arrow's own headers, so no library
+// dependency is incurred.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+
+/**
+   @brief Single predictor presented as a sequence of Arrow chunks.
+
+   Numeric columns may be of any fixed-width integer or floating type.
+   Dictionary-encoded columns are factors, their indices taken as codes
+   without decoding the dictionary.  Chunks of a factor must therefore
+   share a dictionary, as after unification.  Null entries, as given by
+   the validity bitmap, are missing:  NaN if numeric, else a code beyond
+   the top level.
+
+   Buffers are owned by the caller and must remain live while encoding.
+ */
+struct ArrowColumn {
+  /**
+     @brief Chunk of a column, offset additionally by its parent.
+   */
+  struct Chunk {
+    const ArrowArray* array;
+    int64_t offset; ///> Parent offset, as for children of a batch.
+  };
+
+  const ArrowSchema* schema;
+  vector<Chunk> chunk;
+
+  ArrowColumn(const ArrowSchema* schema_) :
+    schema(schema_) {
+  }
+
+
+  /**
+     @brief Appends a chunk to the column.
+
+     @param parentOffset is the offset of an enclosing struct array.
+   */
+  void addChunk(const ArrowArray* array,
+		int64_t parentOffset = 0) {
+    chunk.push_back(Chunk{array, parentOffset});
+  }
+
+
+  /**
+     @brief Splits a sequence of record batches into columns.
+
+     @param schema describes the batches as a struct type.
+
+     @param batch are struct arrays, one per record batch, exported in
+     order.
+
+     @return one column per field, chunked by batch.
+   */
+  static vector<ArrowColumn> fromBatches(const ArrowSchema* schema,
+					 const vector<const ArrowArray*>& batch);
+
+
+  /**
+     @return true iff the column is dictionary-encoded.
+   */
+  bool isFactor() const {
+    return schema->dictionary != nullptr;
+  }
+
+
+  /**
+     @return total length over all chunks.
+   */
+  size_t getLength() const;
+
+
+  /**
+     @brief Throws unless the format and chunking are supported.
+   */
+  void check() const;
+
+
+  /**
+     @return dictionary length, common to all chunks.
+   */
+  unsigned int getCardinality() const;
+
+
+  /**
+     @brief Collects runs of equal values, chunk by chunk.
+
+     Memory is proportional to the number of runs, rather than to the
+     number of rows, and no chunk is concatenated.
+   */
+  vector<RLEVal<double>> numRuns() const;
+
+
+  /**
+     @brief As above, but one-based factor codes.
+
+     @param cardinality is the dictionary length.
+   */
+  vector<RLEVal<unsigned int>> facRuns(unsigned int cardinality) const;
+};
+
+#endif
@@ -0,0 +1,93 @@
+// This file is part of deframe
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file denseframe.h
+
+   @brief Unencoded view of dense observation blocks.
+
+   @author Mark Seligman
+ */
+
+#ifndef DEFRAME_DENSEFRAME_H
+#define DEFRAME_DENSEFRAME_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Aliases caller-owned numeric and factor blocks, without ranking
+   or run-length encoding.
+
+   Numeric predictors precede factors, as in RLEFrame.  Factor values are
+   zero-based codes.  Contents must outlive the frame.
+ */
+struct DenseFrame {
+  const size_t nRow;
+  const unsigned int nPredNum;
+  const unsigned int nPredFac;
+  const double* num; // Numeric block, possibly null.
+  const unsigned int* fac; // Factor block, possibly null.
+  const bool colMajor; // Whether blocks are column-major, as in R.
+
+  DenseFrame(size_t nRow_,
+	     unsigned int nPredNum_,
+	     const double num_[],
+	     unsigned int nPredFac_,
+	     const unsigned int fac_[],
+	     bool colMajor_) :
+    nRow(nRow_),
+    nPredNum(nPredNum_),
+    nPredFac(nPredFac_),
+    num(num_),
+    fac(fac_),
+    colMajor(colMajor_) {
+  }
+
+
+  size_t getNRow() const {
+    return nRow;
+  }
+
+
+  unsigned int getNPredNum() const {
+    return nPredNum;
+  }
+
+
+  unsigned int getNPredFac() const {
+    return nPredFac;
+  }
+
+
+  unsigned int getNPred() const {
+    return nPredNum + nPredFac;
+  }
+
+
+  /**
+     @brief Numeric value at the specified coordinates.
+   */
+  inline double getNum(size_t row,
+		       unsigned int numIdx) const {
+    return colMajor ? num[numIdx * nRow + row] : num[row * nPredNum + numIdx];
+  }
+
+
+  /**
+     @brief As above, but factor code.
+   */
+  inline unsigned int getFac(size_t row,
+			     unsigned int facIdx) const {
+    return colMajor ? fac[facIdx * nRow + row] : fac[row * nPredFac + facIdx];
+  }
+};
+
+#endif
@@ -0,0 +1,347 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file extpresort.cc
+
+   @brief External-memory presorting of frames too large to sort in RAM.
+
+   @author Mark Seligman
+ */
+
+#include "extpresort.h"
+#include "rleframe.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+  void seekTo(FILE* file,
+	      uint64_t offset) {
+#ifdef _WIN32
+    int status = _fseeki64(file, offset, SEEK_SET);
+#else
+    int status = fseeko(file, offset, SEEK_SET);
+#endif
+    if (status != 0)
+      throw runtime_error("Cannot seek within presort input");
+  }
+
+
+  FILE* openFile(const string& path,
+		 const char* mode) {
+    FILE* file = fopen(path.c_str(), mode);
+    if (file == nullptr)
+      throw runtime_error("Cannot open presort file:  " + path);
+    return file;
+  }
+
+
+  void writeAll(FILE* file,
+		const void* src,
+		size_t nByte) {
+    if (nByte > 0 && fwrite(src, 1, nByte, file) != nByte)
+      throw runtime_error("Short write to presort scratch file");
+  }
+
+
+  void readAll(FILE* file,
+	       void* dest,
+	       size_t nByte) {
+    if (nByte > 0 && fread(dest, 1, nByte, file) != nByte)
+      throw runtime_error("Short read from presort file");
+  }
+
+
+  /**
+     @brief Buffered sequential reader over a sorted run.
+   */
+  template<typename itemType>
+  class RunReader {
+    FILE* file;
+    vector<itemType> buffer;
+    size_t bufTop; // # items buffered.
+    size_t bufIdx; // Position of next item.
+
+  public:
+    RunReader(const string& path,
+	      size_t bufItems) :
+      file(openFile(path, "rb")),
+      buffer(bufItems),
+      bufTop(0),
+      bufIdx(0) {
+    }
+
+    ~RunReader() {
+      fclose(file);
+    }
+
+    /**
+       @return true iff an item was read.
+     */
+    bool next(itemType& item) {
+      if (bufIdx == bufTop) {
+	bufTop = fread(buffer.data(), sizeof(itemType), buffer.size(), file);
+	bufIdx = 0;
+	if (bufTop == 0)
+	  return false;
+      }
+      item = buffer[bufIdx++];
+      return true;
+    }
+  };
+}
+
+
+ExtPresort::ExtPresort(size_t nRow_,
+		       size_t memBudget_,
+		       const string& spillDir_) :
+  nRow(nRow_ > numeric_limits<szType>::max() ? throw invalid_argument("Frame row count exceeds run index width") : nRow_),
+  memBudget(memBudget_),
+  spillDir(spillDir_) {
+  if (nRow == 0)
+    throw invalid_argument("Presort requires at least one row");
+}
+
+
+ExtPresort::~ExtPresort() {
+  for (const string& path : scratch) {
+    remove(path.c_str());
+  }
+}
+
+
+string ExtPresort::scratchPath(const string& stem) {
+  string path = spillDir + "/arb_" + to_string(reinterpret_cast<uintptr_t>(this)) + "_" + stem + "_" + to_string(scratch.size());
+  scratch.push_back(path);
+  return path;
+}
+
+
+unique_ptr<RLEFrame> ExtPresort::presort(const vector<ExtColumn>& column) {
+  string spillPath = scratchPath("spill");
+  FILE* spill = openFile(spillPath, "wb");
+
+  vector<unsigned int> factorTop;
+  vector<size_t> rleHeight;
+  vector<double> numVal;
+  vector<size_t> numHeight;
+  vector<unsigned int> facVal;
+  vector<size_t> facHeight;
+  size_t height = 0;
+  try {
+    for (const ExtColumn& col : column) {
+      factorTop.push_back(col.cardinality);
+      if (col.cardinality == 0) {
+	vector<double> valOut;
+	height += encodeColumn<double>(col, spill, valOut);
+	numVal.insert(numVal.end(), valOut.begin(), valOut.end());
+	numHeight.push_back(numVal.size());
+      }
+      else {
+	vector<unsigned int> valOut;
+	height += encodeColumn<unsigned int>(col, spill, valOut);
+	facVal.insert(facVal.end(), valOut.begin(), valOut.end());
+	facHeight.push_back(facVal.size());
+      }
+      rleHeight.push_back(height);
+    }
+  }
+  catch (...) {
+    fclose(spill);
+    throw;
+  }
+  if (fclose(spill) != 0)
+    throw runtime_error("Cannot close presort spill file");
+
+  return make_unique<RLEFrame>(nRow,
+			       factorTop,
+			       loadSpill(spillPath, rleHeight),
+			       numVal,
+			       numHeight,
+			       facVal,
+			       facHeight);
+}
+
+
+template<typename valType>
+size_t ExtPresort::encodeColumn(const ExtColumn& column,
+				FILE* spill,
+				vector<valType>& valOut) {
+  vector<string> runPath = sortRuns<valType>(column);
+  size_t nRun = mergeRuns<valType>(runPath, spill, valOut);
+  for (const string& path : runPath) { // Bounds scratch disk by column.
+    remove(path.c_str());
+  }
+  return nRun;
+}
+
+
+template<typename valType>
+vector<string> ExtPresort::sortRuns(const ExtColumn& column) {
+  // Value, key/row pairs double-buffered by the radix sort, row output.
+  constexpr size_t bytesPerRow = sizeof(valType) + 4 * sizeof(size_t) + sizeof(RunItem<valType>);
+  size_t chunkRows = max<size_t>(1, memBudget / bytesPerRow);
+
+  vector<string> runPath;
+  FILE* in = openFile(column.path, "rb");
+  try {
+    seekTo(in, column.offset);
+    vector<valType> val;
+    vector<RunItem<valType>> run;
+    for (size_t rowStart = 0; rowStart < nRow; rowStart += chunkRows) {
+      size_t extent = min<size_t>(chunkRows, nRow - rowStart);
+      val.resize(extent);
+      readAll(in, val.data(), extent * sizeof(valType));
+
+      run.clear();
+      for (size_t idx : RadixSort::sortedRows(val.data(), extent, OmpThread::nThread)) {
+	run.push_back(RunItem<valType>{val[idx], static_cast<szType>(rowStart + idx)});
+      }
+
+      runPath.push_back(scratchPath("run"));
+      FILE* out = openFile(runPath.back(), "wb");
+      try {
+	writeAll(out, run.data(), run.size() * sizeof(RunItem<valType>));
+      }
+      catch (...) {
+	fclose(out);
+	throw;
+      }
+      if (fclose(out) != 0)
+	throw runtime_error("Cannot close presort run file");
+    }
+  }
+  catch (...) {
+    fclose(in);
+    throw;
+  }
+  fclose(in);
+
+  return runPath;
+}
+
+
+template<typename valType>
+size_t ExtPresort::mergeRuns(const vector<string>& runPath,
+			     FILE* spill,
+			     vector<valType>& valOut) {
+  size_t bufItems = max<size_t>(1024, memBudget / (2 * runPath.size() * sizeof(RunItem<valType>)));
+  vector<unique_ptr<RunReader<RunItem<valType>>>> reader;
+  for (const string& path : runPath) {
+    reader.push_back(make_unique<RunReader<RunItem<valType>>>(path, bufItems));
+  }
+
+  // Min-heap on key, then row, as in the radix ordering of each run.
+  struct Head {
+    decltype(RadixSort::key(valType())) key;
+    RunItem<valType> item;
+    size_t runIdx;
+    bool operator>(const Head& other) const {
+      return key > other.key || (key == other.key && item.row > other.item.row);
+    }
+  };
+  priority_queue<Head, vector<Head>, greater<Head>> heads;
+  for (size_t runIdx = 0; runIdx < reader.size(); runIdx++) {
+    RunItem<valType> item;
+    if (reader[runIdx]->next(item))
+      heads.push(Head{RadixSort::key(item.val), item, runIdx});
+  }
+
+  vector<SpillItem> spillBuf;
+  spillBuf.reserve(bufItems);
+  size_t nRun = 0;
+  auto emit = [&](const SpillItem& spillItem) {
+    spillBuf.push_back(spillItem);
+    nRun++;
+    if (spillBuf.size() == bufItems) {
+      writeAll(spill, spillBuf.data(), spillBuf.size() * sizeof(SpillItem));
+      spillBuf.clear();
+    }
+  };
+
+  // Streaming counterpart of RLECresc::encode().
+  SpillItem current{0, 0, 0};
+  while (!heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    const RunItem<valType>& item = head.item;
+    if (valOut.empty()) {
+      valOut.push_back(item.val);
+      current = SpillItem{0, item.row, 1};
+    }
+    else if (!areEqual(item.val, valOut.back())) {
+      valOut.push_back(item.val);
+      emit(current);
+      current = SpillItem{current.val + 1, item.row, 1};
+    }
+    else if (item.row == current.row + current.extent) {
+      current.extent++;
+    }
+    else {
+      emit(current);
+      current = SpillItem{current.val, item.row, 1};
+    }
+
+    RunItem<valType> itemNext;
+    if (reader[head.runIdx]->next(itemNext))
+      heads.push(Head{RadixSort::key(itemNext.val), itemNext, head.runIdx});
+  }
+  emit(current);
+  writeAll(spill, spillBuf.data(), spillBuf.size() * sizeof(SpillItem));
+
+  return nRun;
+}
+
+
+vector<vector<RLEIdx>> ExtPresort::loadSpill(const string& path,
+					     const vector<size_t>& rleHeight) {
+  size_t nByte = rleHeight.back() * sizeof(SpillItem);
+  const SpillItem* spillItem;
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw runtime_error("Cannot open presort spill file");
+  void* addr = mmap(nullptr, nByte, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // Mapping persists.
+  if (addr == MAP_FAILED)
+    throw runtime_error("Cannot map presort spill file");
+  spillItem = static_cast<const SpillItem*>(addr);
+#else
+  // No mapping:  reads the file whole.
+  vector<SpillItem> owned(rleHeight.back());
+  FILE* file = openFile(path, "rb");
+  readAll(file, owned.data(), nByte);
+  fclose(file);
+  spillItem = owned.data();
+#endif
+
+  vector<vector<RLEIdx>> rlePred(rleHeight.size());
+  size_t rleOff = 0;
+  for (unsigned int predIdx = 0; predIdx < rleHeight.size(); predIdx++) {
+    rlePred[predIdx].reserve(rleHeight[predIdx] - rleOff);
+    for (; rleOff < rleHeight[predIdx]; rleOff++) {
+      rlePred[predIdx].emplace_back(spillItem[rleOff].val, spillItem[rleOff].row, spillItem[rleOff].extent);
+    }
+  }
+
+#ifndef _WIN32
+  munmap(addr, nByte);
+#endif
+  return rlePred;
+}
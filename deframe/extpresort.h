@@ -0,0 +1,150 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file extpresort.h
+
+   @brief External-memory presorting of frames too large to sort in RAM.
+
+   @author Mark Seligman
+ */
+
+#ifndef DEFRAME_EXTPRESORT_H
+#define DEFRAME_EXTPRESORT_H
+
+#include "rlecresc.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Location of a single predictor column on disk.
+
+   A column consists of 'nRow' consecutive items in native byte order:
+   float64 values if numeric, else uint32 one-based factor codes, with
+   codes exceeding the cardinality denoting missing observations.
+ */
+struct ExtColumn {
+  string path; ///> File holding the column.
+  uint64_t offset; ///> Byte offset of the column's leading item.
+  unsigned int cardinality; ///> Factor level count, zero iff numeric.
+};
+
+
+/**
+   @brief Sorts columns in memory-bounded runs and merges them to disk.
+
+   Each column is read in chunks sized to the memory budget.  Every
+   chunk is radix-ordered and written as a sorted run.  The runs are
+   then merged in a single k-way pass, emitting run-length encodings
+   to a spill file as they are produced, so that only the distinct
+   values of a column need be retained.  The spill file is finally
+   mapped to populate the frame's run vectors, which therefore need
+   fit in memory only once encoded.
+ */
+class ExtPresort {
+  const szType nRow;
+  const size_t memBudget; ///> Bytes available for sorting.
+  const string spillDir; ///> Directory for scratch files.
+  vector<string> scratch; ///> Scratch files, removed on destruction.
+
+  /**
+     @brief Sorted-run item, as written to disk.
+   */
+  template<typename valType>
+  struct RunItem {
+    valType val;
+    szType row;
+  };
+
+
+  /**
+     @brief Encoded run, as written to the spill file.
+   */
+  struct SpillItem {
+    szType val; ///> Rank.
+    szType row;
+    szType extent;
+  };
+
+
+  /**
+     @return path to a fresh scratch file, registered for removal.
+   */
+  string scratchPath(const string& stem);
+
+
+  /**
+     @brief Reads a column chunk by chunk, writing each as a sorted run.
+
+     @return paths of the runs written.
+   */
+  template<typename valType>
+  vector<string> sortRuns(const ExtColumn& column);
+
+
+  /**
+     @brief Merges sorted runs, encoding ranked runs into the spill file.
+
+     @param[out] valOut collects the distinct values, in rank order.
+
+     @return number of encoded runs written.
+   */
+  template<typename valType>
+  size_t mergeRuns(const vector<string>& runPath,
+		   FILE* spill,
+		   vector<valType>& valOut);
+
+
+  /**
+     @brief Sorts and encodes a single column.
+
+     @return number of encoded runs written.
+   */
+  template<typename valType>
+  size_t encodeColumn(const ExtColumn& column,
+		      FILE* spill,
+		      vector<valType>& valOut);
+
+
+  /**
+     @brief Reads the spill file back as per-predictor run vectors.
+
+     @param rleHeight is the cumulative run count, by predictor.
+   */
+  static vector<vector<RLEIdx>> loadSpill(const string& path,
+					  const vector<size_t>& rleHeight);
+
+public:
+
+  /**
+     @param memBudget bounds the bytes held by sorting and merging.
+
+     @param spillDir receives scratch files, which are removed on exit.
+   */
+  ExtPresort(size_t nRow_,
+	     size_t memBudget_,
+	     const string& spillDir_);
+
+
+  ~ExtPresort();
+
+
+  /**
+     @brief Presorts the columns.
+
+     @return ranked frame, predictors in the order given.
+   */
+  unique_ptr<struct RLEFrame> presort(const vector<ExtColumn>& column);
+};
+
+#endif
@@ -0,0 +1,198 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file framearray.h
+
+   @brief Read-mostly array either owning its contents or viewing
+   external storage, such as a mapped file.
+
+   @author Mark Seligman
+ */
+
+#ifndef DEFRAME_FRAMEARRAY_H
+#define DEFRAME_FRAMEARRAY_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Mutable view of fixed extent.
+
+   Elements may be written, but storage can be neither resized nor
+   replaced, so pointers cached into it remain valid.
+ */
+template<typename T>
+class FrameSpan {
+  T* const base;
+  const size_t extent;
+
+public:
+  FrameSpan(T* base_,
+	    size_t extent_) :
+    base(base_),
+    extent(extent_) {
+  }
+
+
+  FrameSpan(vector<T>& vec) :
+    base(vec.data()),
+    extent(vec.size()) {
+  }
+
+
+  size_t size() const {
+    return extent;
+  }
+
+
+  T* begin() const {
+    return base;
+  }
+
+
+  T* end() const {
+    return base + extent;
+  }
+
+
+  T& operator[](size_t idx) const {
+    return base[idx];
+  }
+};
+
+
+/**
+   @brief Presents owned and viewed contents through a common interface.
+
+   Viewed contents are never written:  mutation first copies them into
+   owned storage.  The viewed storage must outlive the array.
+ */
+template<typename T>
+class FrameArray {
+  vector<T> owned;
+  bool view; ///> Whether contents are external.
+  const T* base; ///> Either external or owned.data().
+  size_t extent;
+
+public:
+  FrameArray() :
+    view(false),
+    base(nullptr),
+    extent(0) {
+  }
+
+
+  /**
+     @brief Takes ownership of a vector.
+   */
+  FrameArray(vector<T> owned_) :
+    owned(move(owned_)),
+    view(false),
+    base(owned.data()),
+    extent(owned.size()) {
+  }
+
+
+  /**
+     @brief Views external storage.
+   */
+  FrameArray(const T* base_,
+	     size_t extent_) :
+    view(true),
+    base(base_),
+    extent(extent_) {
+  }
+
+
+  FrameArray(const FrameArray& other) :
+    owned(other.owned),
+    view(other.view),
+    base(view ? other.base : owned.data()),
+    extent(other.extent) {
+  }
+
+
+  FrameArray(FrameArray&& other) :
+    owned(move(other.owned)),
+    view(other.view),
+    base(view ? other.base : owned.data()),
+    extent(other.extent) {
+  }
+
+
+  FrameArray& operator=(FrameArray other) {
+    owned = move(other.owned);
+    view = other.view;
+    base = view ? other.base : owned.data();
+    extent = other.extent;
+    return *this;
+  }
+
+
+  /**
+     @return true iff contents are external.
+   */
+  bool isView() const {
+    return view;
+  }
+
+
+  /**
+     @brief Copies viewed contents into owned storage on first call.
+
+     @return writable span over the owned contents.
+   */
+  FrameSpan<T> mutate() {
+    if (view) {
+      owned = vector<T>(base, base + extent);
+      view = false;
+      base = owned.data();
+    }
+    return FrameSpan<T>(owned);
+  }
+
+
+  size_t size() const {
+    return extent;
+  }
+
+
+  bool empty() const {
+    return extent == 0;
+  }
+
+
+  const T* data() const {
+    return base;
+  }
+
+
+  const T* begin() const {
+    return base;
+  }
+
+
+  const T* end() const {
+    return base + extent;
+  }
+
+
+  const T& operator[](size_t idx) const {
+    return base[idx];
+  }
+
+
+  const T& back() const {
+    return base[extent - 1];
+  }
+};
+
+#endif
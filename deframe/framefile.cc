@@ -0,0 +1,330 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file framefile.cc
+
+   @brief Persistence of ranked frames in a mappable layout.
+
+   @author Mark Seligman
+ */
+
+#include "framefile.h"
+#include "rleframe.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(is_standard_layout<RLEIdx>::value && sizeof(RLEIdx) == 3 * sizeof(szType), "Runs must be packed for mapping");
+
+const uint64_t FrameFile::magic = 0x454d415246425241ull; // "ARBFRAME", little-endian.
+const uint32_t FrameFile::version = 1;
+const uint32_t FrameFile::endianTag = 0x01020304;
+const size_t FrameFile::alignment = 64;
+
+
+namespace {
+  /**
+     @brief Section offsets, derived from the header and heights.
+   */
+  struct Sections {
+    uint64_t factorTop;
+    uint64_t rleHeight;
+    uint64_t numHeight;
+    uint64_t facHeight;
+    uint64_t run;
+    uint64_t numVal;
+    uint64_t facVal;
+    uint64_t end;
+
+    /**
+       @brief Lays out the leading sections, whose extents are known
+       from the header alone.
+     */
+    Sections(const FrameFile::Header& header) :
+      factorTop(FrameFile::alignUp(sizeof(FrameFile::Header))),
+      rleHeight(FrameFile::alignUp(factorTop + header.nPred * sizeof(uint32_t))),
+      numHeight(FrameFile::alignUp(rleHeight + header.nPred * sizeof(uint64_t))),
+      facHeight(FrameFile::alignUp(numHeight + header.nNum * sizeof(uint64_t))),
+      run(FrameFile::alignUp(facHeight + header.nFac * sizeof(uint64_t))),
+      numVal(0),
+      facVal(0),
+      end(0) {
+    }
+
+
+    /**
+       @brief Lays out the trailing sections.
+     */
+    void setTail(uint64_t nRun,
+		 uint64_t nNumVal,
+		 uint64_t nFacVal) {
+      numVal = FrameFile::alignUp(run + nRun * sizeof(RLEIdx));
+      facVal = FrameFile::alignUp(numVal + nNumVal * sizeof(double));
+      end = FrameFile::alignUp(facVal + nFacVal * sizeof(uint32_t));
+    }
+  };
+
+
+  /**
+     @brief Owns the mapping, or the file contents if not mappable.
+   */
+  class FrameMap {
+    const unsigned char* base;
+    size_t nByte;
+    vector<unsigned char> owned; // Backing store, iff not mapped.
+
+  public:
+    FrameMap(const string& path) :
+      base(nullptr),
+      nByte(0) {
+#ifndef _WIN32
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+	throw runtime_error("Cannot open frame file:  " + path);
+      }
+      struct stat fileStat;
+      if (fstat(fd, &fileStat) != 0) {
+	close(fd);
+	throw runtime_error("Cannot query frame file:  " + path);
+      }
+      nByte = fileStat.st_size;
+      if (nByte >= sizeof(FrameFile::Header)) {
+	void* addr = mmap(nullptr, nByte, PROT_READ, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+	  close(fd);
+	  throw runtime_error("Cannot map frame file:  " + path);
+	}
+	base = static_cast<const unsigned char*>(addr);
+      }
+      close(fd); // Mapping persists.
+#else
+      // No mapping:  reads the file whole.
+      FILE* file = fopen(path.c_str(), "rb");
+      if (file == nullptr) {
+	throw runtime_error("Cannot open frame file:  " + path);
+      }
+      fseek(file, 0, SEEK_END);
+      nByte = ftell(file);
+      fseek(file, 0, SEEK_SET);
+      owned = vector<unsigned char>(nByte);
+      size_t nRead = fread(owned.data(), 1, nByte, file);
+      fclose(file);
+      if (nRead != nByte) {
+	throw runtime_error("Short read from frame file:  " + path);
+      }
+      base = owned.data();
+#endif
+    }
+
+
+    ~FrameMap() {
+#ifndef _WIN32
+      if (base != nullptr) {
+	munmap(const_cast<unsigned char*>(base), nByte);
+      }
+#endif
+    }
+
+
+    FrameMap(const FrameMap&) = delete;
+    FrameMap& operator=(const FrameMap&) = delete;
+
+
+    size_t getNByte() const {
+      return nByte;
+    }
+
+
+    template<typename itemType>
+    const itemType* at(uint64_t offset) const {
+      return reinterpret_cast<const itemType*>(base + offset);
+    }
+  };
+
+
+  /**
+     @brief Slices a concatenated section by cumulative height.
+   */
+  template<typename itemType>
+  vector<FrameArray<itemType>> slice(const itemType* base,
+				     const uint64_t* height,
+				     size_t nSlice) {
+    vector<FrameArray<itemType>> sliced;
+    uint64_t off = 0;
+    for (size_t idx = 0; idx < nSlice; idx++) {
+      sliced.emplace_back(base + off, height[idx] - off);
+      off = height[idx];
+    }
+    return sliced;
+  }
+
+
+  /**
+     @return true iff heights are nondecreasing and bounded.
+   */
+  bool checkHeight(const uint64_t* height,
+		   size_t nSlice,
+		   uint64_t bound) {
+    uint64_t prev = 0;
+    for (size_t idx = 0; idx < nSlice; idx++) {
+      if (height[idx] < prev || height[idx] > bound)
+	return false;
+      prev = height[idx];
+    }
+    return true;
+  }
+}
+
+
+void FrameFile::write(const RLEFrame* rleFrame,
+		      const string& path,
+		      bool rowOrder) {
+  Header header{magic, version, endianTag, rleFrame->nObs, rleFrame->getNPred(), rleFrame->getNPredNum(), rleFrame->getNPredFac(), static_cast<uint32_t>(sizeof(RLEIdx)), rowOrder || rleFrame->rowOrdered, 0};
+
+  vector<uint64_t> rleHeight;
+  uint64_t height = 0;
+  for (const auto& rle : rleFrame->rlePred) {
+    height += rle.size();
+    rleHeight.push_back(height);
+  }
+  vector<uint64_t> numHeight;
+  height = 0;
+  for (const auto& numRanked : rleFrame->numRanked) {
+    height += numRanked.size();
+    numHeight.push_back(height);
+  }
+  vector<uint64_t> facHeight;
+  height = 0;
+  for (const auto& facRanked : rleFrame->facRanked) {
+    height += facRanked.size();
+    facHeight.push_back(height);
+  }
+
+  Sections sections(header);
+  sections.setTail(rleHeight.empty() ? 0 : rleHeight.back(),
+		   numHeight.empty() ? 0 : numHeight.back(),
+		   facHeight.empty() ? 0 : facHeight.back());
+  header.nByte = sections.end;
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw runtime_error("Cannot open frame file for writing:  " + path);
+  }
+
+  static const unsigned char pad[64] = {0};
+  uint64_t written = 0;
+  auto emit = [&](const void* src, size_t nByte) {
+    if (nByte > 0 && fwrite(src, 1, nByte, file) != nByte) {
+      fclose(file);
+      throw runtime_error("Short write to frame file:  " + path);
+    }
+    written += nByte;
+  };
+  auto padTo = [&](uint64_t target) {
+    while (written < target) {
+      emit(pad, min<uint64_t>(sizeof(pad), target - written));
+    }
+  };
+
+  emit(&header, sizeof(header));
+  padTo(sections.factorTop);
+  emit(rleFrame->factorTop.data(), rleFrame->factorTop.size() * sizeof(uint32_t));
+  padTo(sections.rleHeight);
+  emit(rleHeight.data(), rleHeight.size() * sizeof(uint64_t));
+  padTo(sections.numHeight);
+  emit(numHeight.data(), numHeight.size() * sizeof(uint64_t));
+  padTo(sections.facHeight);
+  emit(facHeight.data(), facHeight.size() * sizeof(uint64_t));
+  padTo(sections.run);
+  for (const auto& rle : rleFrame->rlePred) {
+    if (header.rowOrdered && !rleFrame->rowOrdered) {
+      vector<RLEIdx> rleRow(rle.begin(), rle.end());
+      RLEFrame::sortRow(rleRow, rleFrame->nObs);
+      emit(rleRow.data(), rleRow.size() * sizeof(RLEIdx));
+    }
+    else {
+      emit(rle.data(), rle.size() * sizeof(RLEIdx));
+    }
+  }
+  padTo(sections.numVal);
+  for (const auto& numRanked : rleFrame->numRanked) {
+    emit(numRanked.data(), numRanked.size() * sizeof(double));
+  }
+  padTo(sections.facVal);
+  for (const auto& facRanked : rleFrame->facRanked) {
+    emit(facRanked.data(), facRanked.size() * sizeof(uint32_t));
+  }
+  padTo(sections.end);
+
+  if (fclose(file) != 0) {
+    throw runtime_error("Cannot close frame file:  " + path);
+  }
+}
+
+
+unique_ptr<RLEFrame> FrameFile::map(const string& path) {
+  auto frameMap = make_shared<FrameMap>(path);
+  size_t nByte = frameMap->getNByte();
+  if (nByte < sizeof(Header)) {
+    throw invalid_argument("Frame file truncated");
+  }
+  const Header& header = *frameMap->at<Header>(0);
+  if (header.magic != magic) {
+    throw invalid_argument("Not a frame file");
+  }
+  if (header.endian != endianTag) {
+    throw invalid_argument("Frame file written with foreign byte order");
+  }
+  if (header.version != version || header.runSize != sizeof(RLEIdx)) {
+    throw invalid_argument("Unsupported frame file version");
+  }
+  if (header.nByte != nByte || header.nPred == 0 || header.nNum + header.nFac != header.nPred
+      || header.nPred > nByte / sizeof(uint64_t)) {
+    throw invalid_argument("Frame file truncated");
+  }
+
+  Sections sections(header);
+  if (sections.run > nByte) {
+    throw invalid_argument("Frame file truncated");
+  }
+  const uint32_t* factorTop = frameMap->at<uint32_t>(sections.factorTop);
+  const uint64_t* rleHeight = frameMap->at<uint64_t>(sections.rleHeight);
+  const uint64_t* numHeight = frameMap->at<uint64_t>(sections.numHeight);
+  const uint64_t* facHeight = frameMap->at<uint64_t>(sections.facHeight);
+  uint64_t nRun = rleHeight[header.nPred - 1];
+  uint64_t nNumVal = header.nNum == 0 ? 0 : numHeight[header.nNum - 1];
+  uint64_t nFacVal = header.nFac == 0 ? 0 : facHeight[header.nFac - 1];
+  if (nRun > nByte / sizeof(RLEIdx) || nNumVal > nByte / sizeof(double) || nFacVal > nByte / sizeof(uint32_t)) {
+    throw invalid_argument("Frame file truncated");
+  }
+  sections.setTail(nRun, nNumVal, nFacVal);
+  if (sections.end != nByte
+      || !checkHeight(rleHeight, header.nPred, nRun)
+      || !checkHeight(numHeight, header.nNum, nNumVal)
+      || !checkHeight(facHeight, header.nFac, nFacVal)
+      || header.nNum != static_cast<uint64_t>(count(factorTop, factorTop + header.nPred, 0u))) {
+    throw invalid_argument("Frame file corrupt");
+  }
+
+  return make_unique<RLEFrame>(header.nObs,
+			       vector<unsigned int>(factorTop, factorTop + header.nPred),
+			       slice(frameMap->at<RLEIdx>(sections.run), rleHeight, header.nPred),
+			       slice(frameMap->at<double>(sections.numVal), numHeight, header.nNum),
+			       slice(frameMap->at<unsigned int>(sections.facVal), facHeight, header.nFac),
+			       header.rowOrdered != 0,
+			       frameMap);
+}
@@ -0,0 +1,98 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file framefile.h
+
+   @brief Persistence of ranked frames in a mappable layout.
+
+   @author Mark Seligman
+ */
+
+#ifndef DEFRAME_FRAMEFILE_H
+#define DEFRAME_FRAMEFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+
+/**
+   @brief Layout of a persisted RLEFrame.
+
+   A file consists of a fixed header followed by the sections below,
+   each beginning on an 'alignment' boundary, so that a mapped file is
+   read in place:
+
+     factor tops (uint32, by predictor),
+     cumulative run heights (uint64, by predictor),
+     cumulative numeric value heights (uint64, by numeric predictor),
+     cumulative factor value heights (uint64, by factor predictor),
+     runs (RLEIdx),
+     numeric values (double),
+     factor values (uint32).
+
+   Items are written in native byte order and layout.  The header
+   records the endianness and run size, so that a foreign or stale file
+   is rejected rather than misread.
+ */
+struct FrameFile {
+  static const uint64_t magic; // "ARBFRAME", native order.
+  static const uint32_t version; // Bumped on any incompatible change.
+  static const uint32_t endianTag; // Reads back permuted if foreign.
+  static const size_t alignment; // Section alignment, in bytes.
+
+  struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t endian;
+    uint64_t nObs;
+    uint64_t nPred;
+    uint64_t nNum; // # numeric predictors.
+    uint64_t nFac; // # factor predictors.
+    uint32_t runSize; // sizeof(RLEIdx).
+    uint32_t rowOrdered; // Nonzero iff runs ordered by row.
+    uint64_t nByte; // Total file size, for truncation checks.
+  };
+
+
+  /**
+     @return least multiple of the alignment not below an offset.
+   */
+  static uint64_t alignUp(uint64_t offset) {
+    return ((offset + alignment - 1) / alignment) * alignment;
+  }
+
+
+  /**
+     @brief Writes a frame.
+
+     @param path is the file to be created or truncated.
+
+     @param rowOrder is true iff runs are to be written ordered by row,
+     as consumed by prediction.  Training requires rank order.
+   */
+  static void write(const struct RLEFrame* rleFrame,
+		    const string& path,
+		    bool rowOrder = false);
+
+
+  /**
+     @brief Maps a file, mapped where the platform permits.
+
+     Concurrent jobs mapping the same file share a single page-cached
+     copy.  The frame's arrays view the mapping, which persists for
+     the lifetime of the frame.
+
+     @return frame viewing the mapped file.
+   */
+  static unique_ptr<struct RLEFrame> map(const string& path);
+};
+
+#endif
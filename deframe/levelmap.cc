@@ -0,0 +1,87 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file levelmap.cc
+
+   @brief Methods for reconciling factor levels by hashing.
+
+   @author Mark Seligman
+ */
+
+#include "levelmap.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+LevelMap::LevelMap(const vector<vector<string>>& levelTrain) :
+  trainCode(levelTrain.size()) {
+  for (size_t facIdx = 0; facIdx < levelTrain.size(); facIdx++) {
+    trainCode[facIdx].reserve(levelTrain[facIdx].size());
+    for (unsigned int code = 0; code < levelTrain[facIdx].size(); code++) {
+      trainCode[facIdx].emplace(levelTrain[facIdx][code], code + 1);
+    }
+  }
+}
+
+
+vector<vector<unsigned int>> LevelMap::reconcile(const vector<vector<string>>& levelTest,
+						 const vector<const int*>& colCode,
+						 size_t nObs,
+						 Unseen& unseen) const {
+  if (levelTest.size() != trainCode.size() || colCode.size() != trainCode.size())
+    throw invalid_argument("Factor column count differs from training");
+
+  vector<vector<unsigned int>> recoded(trainCode.size());
+  vector<size_t> levelUnseen(trainCode.size());
+  vector<size_t> obsUnseen(trainCode.size());
+  OMPBound nFac = trainCode.size();
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound facIdx = 0; facIdx < nFac; facIdx++) {
+    const unordered_map<string, unsigned int>& levelCode = trainCode[facIdx];
+    unsigned int proxy = levelCode.size() + 1;
+    bool identity = levelTest[facIdx].size() == levelCode.size();
+    vector<unsigned int> codeMap(levelTest[facIdx].size());
+    for (unsigned int code = 0; code < codeMap.size(); code++) {
+      auto found = levelCode.find(levelTest[facIdx][code]);
+      codeMap[code] = found == levelCode.end() ? proxy : found->second;
+      identity = identity && codeMap[code] == code + 1;
+    }
+    if (identity)
+      continue;
+
+    vector<bool> unseenCode(codeMap.size());
+    vector<unsigned int>& facOut = recoded[facIdx];
+    facOut.resize(nObs);
+    const int* code = colCode[facIdx];
+    for (size_t obsIdx = 0; obsIdx < nObs; obsIdx++) {
+      // Missing codes fall outside the dictionary.
+      if (code[obsIdx] < 1 || static_cast<size_t>(code[obsIdx]) > codeMap.size()) {
+	facOut[obsIdx] = proxy;
+      }
+      else if ((facOut[obsIdx] = codeMap[code[obsIdx] - 1]) == proxy) {
+	unseenCode[code[obsIdx] - 1] = true;
+	obsUnseen[facIdx]++;
+      }
+    }
+    levelUnseen[facIdx] = count(unseenCode.begin(), unseenCode.end(), true);
+  }
+  }
+
+  unseen = Unseen{0, 0, 0};
+  for (size_t facIdx = 0; facIdx < trainCode.size(); facIdx++) {
+    unseen.nCol += levelUnseen[facIdx] > 0 ? 1 : 0;
+    unseen.nLevel += levelUnseen[facIdx];
+    unseen.nObs += obsUnseen[facIdx];
+  }
+
+  return recoded;
+}
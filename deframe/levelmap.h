@@ -0,0 +1,77 @@
+// This file is part of deframe.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file levelmap.h
+
+   @brief Reconciles factor levels of new observations with training.
+
+   @author Mark Seligman
+ */
+
+#ifndef DEFRAME_LEVELMAP_H
+#define DEFRAME_LEVELMAP_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Maps level strings to training codes, by factor column.
+
+   Codes are one-based.  Levels absent from training, as well as
+   missing or out-of-range codes, map to a proxy beyond the training
+   levels, so are treated as missing.
+ */
+class LevelMap {
+  vector<unordered_map<string, unsigned int>> trainCode; // Per factor.
+
+public:
+
+  /**
+     @param levelTrain are the training levels of each factor column.
+   */
+  LevelMap(const vector<vector<string>>& levelTrain);
+
+
+  /**
+     @brief Bulk census of unseen levels.
+   */
+  struct Unseen {
+    unsigned int nCol; ///> # columns having unseen levels.
+    size_t nLevel; ///> # distinct unseen levels.
+    size_t nObs; ///> # observations taking an unseen level.
+  };
+
+
+  /**
+     @brief Recodes dictionary-encoded factor columns to training codes.
+
+     Each column's dictionary is matched once, after which its codes
+     are translated by table.  Columns are recoded in parallel.
+
+     @param levelTest are the dictionaries of each factor column.
+
+     @param colCode are the columns' one-based codes.
+
+     @param nObs is the number of observations per column.
+
+     @param[out] unseen summarizes the levels absent from training.
+
+     @return recoded columns, empty where dictionaries agree with training.
+   */
+  vector<vector<unsigned int>> reconcile(const vector<vector<string>>& levelTest,
+					 const vector<const int*>& colCode,
+					 size_t nObs,
+					 Unseen& unseen) const;
+};
+
+#endif
@@ -44,12 +44,14 @@ struct RLE {
 
 /**
   @brief Sparse representation imposed by front-end.
+
+  @tparam idxType is wide enough to index the observations.
 */
-template<typename valType>
+template<typename valType, typename idxType = size_t>
 struct RLEVal {
   valType val;
-  size_t row;
-  size_t extent;
+  idxType row;
+  idxType extent;
 
   RLEVal(valType val_,
          size_t row_,
@@ -58,13 +60,16 @@ struct RLEVal {
 			   extent(extent_) {
   }
 
-  RLEVal(const RLEVal<valType>& rle) :
+  RLEVal(const RLEVal<valType, idxType>& rle) :
     val(rle.val),
     row(rle.row),
     extent(rle.extent) {
   }
 
 
+  RLEVal& operator=(const RLEVal<valType, idxType>&) = default;
+
+
   /**
      @brief Computes end position.
 
@@ -14,40 +14,58 @@
  */
 
 #include "rlecresc.h"
+#include "arrowframe.h"
 #include "ompthread.h"
 #include <cmath>
+#include <limits>
+#include <stdexcept>
 
 
 RLECresc::RLECresc(size_t nRow_,
 		   unsigned int nPred) :
-  nRow(nRow_),
+  nRow(checkRow(nRow_)),
   topIdx(vector<unsigned int>(nPred)),
   typedIdx(vector<unsigned int>(nPred)),
-  rle(vector<vector<RLEVal<szType>>>(nPred)),
+  rle(vector<vector<RLEIdx>>(nPred)),
   nFactor(0),
   nNumeric(0) {
 }
 
 
-void RLECresc::encodeFrame(const vector<void*>& colBase) {
-  valFac = vector<vector<unsigned int>>(nFactor);
-  valNum = vector<vector<double>>(nNumeric);
+void RLECresc::encodeColumns(unsigned int nPred,
+			     const function<void(unsigned int, unsigned int)>& encodePred) {
+  if (nPred < OmpThread::nThread) {
+    for (unsigned int predIdx = 0; predIdx < nPred; predIdx++) {
+      encodePred(predIdx, OmpThread::nThread);
+    }
+    return;
+  }
 
-  OMPBound nPred = colBase.size();
+  OMPBound predEnd = nPred;
 #pragma omp parallel default(shared) num_threads(OmpThread::nThread)
   {
 #pragma omp for schedule(dynamic, 1)
-  for (OMPBound predIdx = 0; predIdx < nPred; predIdx++) {
+  for (OMPBound predIdx = 0; predIdx < predEnd; predIdx++) {
+    encodePred(predIdx, 1);
+  }
+  }
+}
+
+
+void RLECresc::encodeFrame(const vector<void*>& colBase) {
+  valFac = vector<vector<unsigned int>>(nFactor);
+  valNum = vector<vector<double>>(nNumeric);
+
+  encodeColumns(colBase.size(), [&](unsigned int predIdx, unsigned int nThread) {
     bool isFactor;
     unsigned int typedIdx = getTypedIdx(predIdx, isFactor);
     if (isFactor) { // Only factors and numerics present.
-      encodeColumn<unsigned int>(static_cast<unsigned int*>(colBase[predIdx]), valFac[typedIdx], rle[predIdx]);
+      encodeColumn<unsigned int>(static_cast<unsigned int*>(colBase[predIdx]), valFac[typedIdx], rle[predIdx], nThread);
     }
     else {
-      encodeColumn<double>(static_cast<double*>(colBase[predIdx]), valNum[typedIdx], rle[predIdx]);
+      encodeColumn<double>(static_cast<double*>(colBase[predIdx]), valNum[typedIdx], rle[predIdx], nThread);
     }
-  }
-  }
+  });
 }
 
 
@@ -59,37 +77,67 @@ void RLECresc::encodeFrameNum(const vector<double>&  feVal,
 }
 
 
+void RLECresc::encodeFrameArrow(const vector<ArrowColumn>& column) {
+  if (column.size() != topIdx.size())
+    throw invalid_argument("Arrow column count differs from predictor count");
+
+  // Validation precedes the parallel region, which cannot throw.
+  for (unsigned int predIdx = 0; predIdx < column.size(); predIdx++) {
+    column[predIdx].check();
+    if (column[predIdx].getLength() != nRow)
+      throw invalid_argument("Arrow column length differs from row count");
+    setFactor(predIdx, column[predIdx].isFactor() ? column[predIdx].getCardinality() : 0);
+  }
+  valFac = vector<vector<unsigned int>>(nFactor);
+  valNum = vector<vector<double>>(nNumeric);
+
+  encodeColumns(column.size(), [&](unsigned int predIdx, unsigned int nThread) {
+    bool isFactor;
+    unsigned int typedIdx = getTypedIdx(predIdx, isFactor);
+    if (isFactor) {
+      vector<RLEVal<unsigned int>> runs = column[predIdx].facRuns(topIdx[predIdx]);
+      sortRuns(runs, nThread);
+      encodeSparse(valFac[typedIdx], runs, rle[predIdx]);
+    }
+    else {
+      vector<RLEVal<double>> runs = column[predIdx].numRuns();
+      sortRuns(runs, nThread);
+      encodeSparse(valNum[typedIdx], runs, rle[predIdx]);
+    }
+  });
+}
+
+
 void RLECresc::encodeFrameNum(const double* feVal) {
-  OMPBound nPred = topIdx.size();
+  unsigned int nPred = topIdx.size();
   valFac = vector<vector<unsigned int>>(0);
   valNum = vector<vector<double>>(nPred);
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound predIdx = 0; predIdx < nPred; predIdx++) {
-      encodeColumn(&feVal[predIdx * nRow], valNum[predIdx], rle[predIdx]);
-    }
-  }
+  encodeColumns(nPred, [&](unsigned int predIdx, unsigned int nThread) {
+    encodeColumn(&feVal[predIdx * nRow], valNum[predIdx], rle[predIdx], nThread);
+  });
 }
 
 
 void RLECresc::encodeFrameFac(const uint32_t*  feVal) {
-  OMPBound nPred = topIdx.size();
+  unsigned int nPred = topIdx.size();
   valFac = vector<vector<unsigned int>>(nPred);
   valNum = vector<vector<double>>(0);
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound predIdx = 0; predIdx < nPred; predIdx++) {
-      encodeColumn(&feVal[predIdx * nRow], valFac[predIdx], rle[predIdx]);
-    }
-  }
+  encodeColumns(nPred, [&](unsigned int predIdx, unsigned int nThread) {
+    encodeColumn(&feVal[predIdx * nRow], valFac[predIdx], rle[predIdx], nThread);
+  });
+}
+
+
+szType RLECresc::checkRow(size_t nRow) {
+  if (nRow > numeric_limits<szType>::max())
+    throw invalid_argument("Frame row count exceeds run index width");
+  return nRow;
 }
 
 
-void RLECresc::dump(vector<size_t>& valOut,
-		    vector<size_t>& extentOut,
-		    vector<size_t>& rowOut) const {
+void RLECresc::dump(vector<szType>& valOut,
+		    vector<szType>& extentOut,
+		    vector<szType>& rowOut) const {
   size_t i = 0;
   for (auto rlePred : rle) {
     for (auto rlEnc : rlePred) {
@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <vector>
+#include <functional>
 
 using namespace std;
 
@@ -43,7 +44,8 @@ inline bool RLECompare(const RLEVal<double>& a,
 }
 
 
-typedef size_t szType; // Size type sufficient for observations.
+typedef uint32_t szType; // Size type sufficient for observations, as IndexT.
+typedef RLEVal<szType, szType> RLEIdx; // Ranked run, compactly indexed.
 
 
 /**
@@ -59,7 +61,7 @@ class RLECresc {
 
   // Encodes observations as run characteristics, not values.
   // Error if empty.
-  vector<vector<RLEVal<szType>>> rle;
+  vector<vector<RLEIdx>> rle;
   vector<vector<unsigned int>> valFac;
   vector<vector<double>> valNum;
   unsigned int nFactor; // Count of factor predictors.
@@ -75,7 +77,7 @@ class RLECresc {
   template<typename obsType>
   void encode(const RankedObs<obsType>& rankedObs,
 	      vector<obsType>& runValue,
-	      vector<RLEVal<szType>>& rlePred) {
+	      vector<RLEIdx>& rlePred) {
     size_t rowNext = nRow; // Inattainable row number.
 
     obsType valPrev = rankedObs.getVal(0); // Ensures intial rle pushed at first iteration.
@@ -85,10 +87,10 @@ class RLECresc {
       obsType valThis = rankedObs.getVal(idx);
       if (!areEqual(valThis, valPrev)) {
 	runValue.push_back(valThis);
-	rlePred.emplace_back(RLEVal<szType>(rankedObs.getRank(idx), rowThis));
+	rlePred.emplace_back(RLEIdx(rankedObs.getRank(idx), rowThis));
       }
       else if (rowThis != rowNext) {
-	rlePred.emplace_back(RLEVal<szType>(rankedObs.getRank(idx), rowThis));
+	rlePred.emplace_back(RLEIdx(rankedObs.getRank(idx), rowThis));
       }
       else {
 	rlePred.back().extent++;
@@ -152,7 +154,7 @@ class RLECresc {
   template<typename valType>
   void encodeSparse(vector<valType>& runValue,
 		    const vector<RLEVal<valType>>& rleVal,
-		    vector<RLEVal<szType>>& rlePred) {
+		    vector<RLEIdx>& rlePred) {
     size_t rowNext = nRow; // Inattainable row number.
     size_t rk = 0;
     runValue.push_back(rleVal[0].val);
@@ -166,15 +168,113 @@ class RLECresc {
 	  rk++;
 	  runValue.push_back(elt.val);
 	}
-	rlePred.emplace_back(RLEVal<szType>(rk, elt.row, elt.extent));
+	rlePred.emplace_back(RLEIdx(rk, elt.row, elt.extent));
       }
       rowNext = rlePred.back().row + rlePred.back().extent;
     }
   }
 
 
+  /**
+     @brief Encodes a single compressed sparse column.
+
+     Only the nonzero values are sorted.  Zero-valued rows are entered
+     as the gaps between nonzero rows, so are never expanded, and are
+     ranked between the negative and positive values.  Explicit zeroes
+     are absorbed into the gaps.
+
+     @param nzStart, nzEnd bound the column's nonzero entries.
+   */
+  template<typename idxType>
+  void encodeColumnCSC(const double eltNZ[],
+		       const idxType rowNZ[],
+		       size_t nzStart,
+		       size_t nzEnd,
+		       vector<double>& valOut,
+		       vector<RLEIdx>& rlePred,
+		       unsigned int nThread) {
+    vector<RLEVal<double>> zeroRun;
+    vector<double> valNZ;
+    vector<size_t> rowOfNZ;
+    size_t rowNext = 0; // Least row not yet visited.
+    for (size_t nzIdx = nzStart; nzIdx != nzEnd; nzIdx++) {
+      if (eltNZ[nzIdx] == 0.0)
+	continue;
+      size_t row = rowNZ[nzIdx];
+      if (row > rowNext) {
+	zeroRun.emplace_back(0.0, rowNext, row - rowNext);
+      }
+      valNZ.push_back(eltNZ[nzIdx]);
+      rowOfNZ.push_back(row);
+      rowNext = row + 1;
+    }
+    if (rowNext < nRow) {
+      zeroRun.emplace_back(0.0, rowNext, nRow - rowNext);
+    }
+
+    vector<size_t> nzSorted = RadixSort::sortedRows(valNZ.data(), valNZ.size(), nThread);
+    vector<RLEVal<double>> rleVal;
+    rleVal.reserve(nzSorted.size() + zeroRun.size());
+    size_t idx = 0;
+    for (; idx != nzSorted.size() && valNZ[nzSorted[idx]] < 0.0; idx++) {
+      rleVal.emplace_back(valNZ[nzSorted[idx]], rowOfNZ[nzSorted[idx]]);
+    }
+    rleVal.insert(rleVal.end(), zeroRun.begin(), zeroRun.end());
+    for (; idx != nzSorted.size(); idx++) {
+      rleVal.emplace_back(valNZ[nzSorted[idx]], rowOfNZ[nzSorted[idx]]);
+    }
+
+    encodeSparse(valOut, rleVal, rlePred);
+  }
+
+
+  /**
+     @brief Orders runs by value, ties by row, as does RLECompare.
+
+     Runs must enter in row order, which the stable radix passes then
+     preserve among ties.
+
+     @param nThread is the maximal team size employed.
+   */
+  template<typename valType>
+  static void sortRuns(vector<RLEVal<valType>>& runs,
+		       unsigned int nThread) {
+    vector<valType> runVal(runs.size());
+    for (size_t idx = 0; idx != runs.size(); idx++) {
+      runVal[idx] = runs[idx].val;
+    }
+    vector<size_t> runOrder = RadixSort::sortedRows(runVal.data(), runVal.size(), nThread);
+    vector<RLEVal<valType>> runSorted;
+    runSorted.reserve(runs.size());
+    for (size_t idx : runOrder) {
+      runSorted.push_back(runs[idx]);
+    }
+    runs = move(runSorted);
+  }
+
+
+  /**
+     @brief Applies a column encoder to each predictor.
+
+     Columns are distributed across threads when at least as numerous
+     as the threads, else are visited in turn with each column
+     receiving the full team.
+
+     @param encodePred encodes a column given its index and team size.
+   */
+  void encodeColumns(unsigned int nPred,
+		     const function<void(unsigned int, unsigned int)>& encodePred);
+
+  /**
+     @return row count, unless too large to index.
+   */
+  static szType checkRow(size_t nRow);
+
 public:
 
+  /**
+     @brief Throws if the rows are not indexable by szType.
+   */
   RLECresc(size_t nRow_,
 	   unsigned int nPred);
 
@@ -188,7 +288,7 @@ public:
      @brief Computes unit size for cross-compatibility of serialization.
    */
   static constexpr size_t unitSize() {
-    return sizeof(RLEVal<szType>);
+    return sizeof(RLEIdx);
   }
 
 
@@ -278,6 +378,43 @@ public:
 		      const vector<size_t>&  feRunLength);
 
 
+  /**
+     @brief Encodes numeric frame from compressed sparse columns.
+
+     @param eltNZ are the nonzero values, column-major.
+
+     @param rowNZ are the rows of the nonzero values, increasing
+     within each column.
+
+     @param colStart has length nPred + 1, giving the offset of each
+     column's nonzeros, followed by their total.
+   */
+  template<typename idxType>
+  void encodeFrameCSC(const double eltNZ[],
+		      const idxType rowNZ[],
+		      const idxType colStart[]) {
+    unsigned int nPred = topIdx.size();
+    valFac = vector<vector<unsigned int>>(0);
+    valNum = vector<vector<double>>(nPred);
+    encodeColumns(nPred, [&](unsigned int predIdx, unsigned int nThread) {
+      encodeColumnCSC(eltNZ, rowNZ, colStart[predIdx], colStart[predIdx + 1], valNum[predIdx], rle[predIdx], nThread);
+    });
+  }
+
+
+  /**
+     @brief Encodes a frame of Arrow columns, chunk by chunk.
+
+     Predictor types are taken from the columns:  dictionary-encoded
+     columns are factors, their cardinality the dictionary length.
+     Runs are ordered by radix, tall columns in parallel when fewer
+     than the threads, as in encodeFrame().
+
+     @param column has one element per predictor, each spanning all rows.
+   */
+  void encodeFrameArrow(const vector<struct ArrowColumn>& column);
+
+
   /**
      @brief Encodes entire frame from dense numeric block.
    */
@@ -290,9 +427,9 @@ public:
   void encodeFrameFac(const uint32_t* feVal);
 
 
-  void dump(vector<size_t>& valOut,
-	    vector<size_t>& lengthOut,
-	    vector<size_t>& rowOut) const;
+  void dump(vector<szType>& valOut,
+	    vector<szType>& lengthOut,
+	    vector<szType>& rowOut) const;
   
 
   /**
@@ -309,12 +446,15 @@ public:
      @param[out] valOut tabulates the predictor values.
 
      @param[out] rleVal encodes the run-length elements.
+
+     @param nThread is the team size available for ordering the column.
    */
   template<typename valType>
   void encodeColumn(const valType val[],
 		    vector<valType>& valOut,
-		    vector<RLEVal<szType>>& rleVal) {
-    encode(RankedObs<valType>(val, nRow), valOut, rleVal);
+		    vector<RLEIdx>& rleVal,
+		    unsigned int nThread = 1) {
+    encode(RankedObs<valType>(val, nRow, nThread), valOut, rleVal);
   }
 };
 #endif
@@ -14,26 +14,135 @@
  */
 
 #include "rleframe.h"
+#include "ompthread.h"
+
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace {
+  template<typename valType>
+  inline bool ranksBefore(const valType& a,
+			  const valType& b) {
+    return a < b;
+  }
+
+
+  template<>
+  inline bool ranksBefore(const double& a,
+			  const double& b) {
+    return a < b || (!isnan(a) && isnan(b));
+  }
+
+
+  /**
+     @brief Merges two tables of distinct, ranked values.
+
+     @param[out] baseRank, deltaRank map each input rank to its merged rank.
+   */
+  template<typename valType>
+  vector<valType> mergeRanked(const FrameArray<valType>& baseVal,
+			      const FrameArray<valType>& deltaVal,
+			      vector<szType>& baseRank,
+			      vector<szType>& deltaRank) {
+    vector<valType> merged;
+    merged.reserve(baseVal.size() + deltaVal.size());
+    size_t baseIdx = 0;
+    size_t deltaIdx = 0;
+    while (baseIdx < baseVal.size() || deltaIdx < deltaVal.size()) {
+      bool takeBase = deltaIdx == deltaVal.size() || (baseIdx < baseVal.size() && !ranksBefore(deltaVal[deltaIdx], baseVal[baseIdx]));
+      bool takeDelta = baseIdx == baseVal.size() || (deltaIdx < deltaVal.size() && !ranksBefore(baseVal[baseIdx], deltaVal[deltaIdx]));
+      merged.push_back(takeBase ? baseVal[baseIdx] : deltaVal[deltaIdx]);
+      if (takeBase) {
+	baseRank.push_back(merged.size() - 1);
+	baseIdx++;
+      }
+      if (takeDelta) {
+	deltaRank.push_back(merged.size() - 1);
+	deltaIdx++;
+      }
+    }
+    return merged;
+  }
+
+
+  /**
+     @brief Interleaves remapped runs by rank, splicing contiguous
+     runs of equal rank.
+
+     @param rowOff offsets the rows of delta's runs.
+   */
+  vector<RLEIdx> spliceRuns(const FrameArray<RLEIdx>& baseRLE,
+			    const vector<szType>& baseRank,
+			    const FrameArray<RLEIdx>& deltaRLE,
+			    const vector<szType>& deltaRank,
+			    size_t rowOff) {
+    vector<RLEIdx> rle;
+    rle.reserve(baseRLE.size() + deltaRLE.size());
+    size_t baseIdx = 0;
+    size_t deltaIdx = 0;
+    while (baseIdx < baseRLE.size() || deltaIdx < deltaRLE.size()) {
+      // Base rows precede delta rows, so base wins ties in rank.
+      bool takeBase = deltaIdx == deltaRLE.size() || (baseIdx < baseRLE.size() && baseRank[baseRLE[baseIdx].val] <= deltaRank[deltaRLE[deltaIdx].val]);
+      RLEIdx run = takeBase ? baseRLE[baseIdx++] : deltaRLE[deltaIdx++];
+      if (takeBase) {
+	run.val = baseRank[run.val];
+      }
+      else {
+	run.val = deltaRank[run.val];
+	run.row += rowOff;
+      }
+      if (!rle.empty() && rle.back().val == run.val && rle.back().getRowEnd() == run.row) {
+	rle.back().extent += run.extent;
+      }
+      else {
+	rle.push_back(run);
+      }
+    }
+    return rle;
+  }
+}
 
 
 RLEFrame::RLEFrame(size_t nRow_,
 		   const vector<unsigned int>& factorTop_,
-		   const vector<size_t>& runVal,
-		   const vector<size_t>& runLength,
-		   const vector<size_t>& runRow,
+		   const vector<szType>& runVal,
+		   const vector<szType>& runLength,
+		   const vector<szType>& runRow,
 		   const vector<size_t>& rleHeight,
 		   const vector<double>& numVal,
 		   const vector<size_t>& numHeight,
 		   const vector<unsigned int>& facVal,
 		   const vector<size_t>& facHeight) :
+  RLEFrame(nRow_,
+	   factorTop_,
+	   packRLE(rleHeight, runVal, runRow, runLength),
+	   numVal,
+	   numHeight,
+	   facVal,
+	   facHeight) {
+}
+
+
+RLEFrame::RLEFrame(size_t nRow_,
+		   const vector<unsigned int>& factorTop_,
+		   vector<vector<RLEIdx>> rlePred_,
+		   const vector<double>& numVal,
+		   const vector<size_t>& numHeight,
+		   const vector<unsigned int>& facVal,
+		   const vector<size_t>& facHeight) :
   nObs(nRow_),
   factorTop(factorTop_),
   noRank(max(nObs, static_cast<size_t>(*max_element(factorTop.begin(), factorTop.end())))),
-  rlePred(packRLE(rleHeight, runVal, runRow, runLength)),
-  numRanked(vector<vector<double>>(numHeight.size())),
-  facRanked(vector<vector<unsigned int>>(facHeight.size())),
-  blockIdx(vector<unsigned int>(rleHeight.size())) {
+  rlePred(make_move_iterator(rlePred_.begin()), make_move_iterator(rlePred_.end())),
+  numRanked(vector<FrameArray<double>>(numHeight.size())),
+  facRanked(vector<FrameArray<unsigned int>>(facHeight.size())),
+  blockIdx(vector<unsigned int>(rlePred.size())),
+  rowOrdered(false) {
 
   unsigned int numIdx = 0;
   unsigned int factorIdx = 0;
@@ -41,27 +150,52 @@ RLEFrame::RLEFrame(size_t nRow_,
   size_t facOff = 0;
   for (unsigned predIdx = 0; predIdx != blockIdx.size(); predIdx++) {
     if (factorTop[predIdx] == 0) {
-      for (; numOff < numHeight[numIdx]; numOff++) {
-	numRanked[numIdx].emplace_back(numVal[numOff]);
-      }
+      numRanked[numIdx] = vector<double>(numVal.begin() + numOff, numVal.begin() + numHeight[numIdx]);
+      numOff = numHeight[numIdx];
       blockIdx[predIdx] = numIdx++;
     }
     else {
       unsigned int maxVal = factorTop[predIdx] + 1;
+      vector<unsigned int> ranked;
       for (; facOff < facHeight[factorIdx]; facOff++) {
-	facRanked[factorIdx].emplace_back(min(maxVal, facVal[facOff]));
+	ranked.emplace_back(min(maxVal, facVal[facOff]));
       }
+      facRanked[factorIdx] = move(ranked);
       blockIdx[predIdx] = factorIdx++;
     }
   }
 }
 
 
-vector<vector<RLEVal<szType>>> RLEFrame::packRLE(const vector<size_t>& rleHeight,
-		       const vector<size_t>& runVal,
-		       const vector<size_t>& runRow,
-		       const vector<size_t>& runLength) {
-  vector<vector<RLEVal<szType>>> rlePred(rleHeight.size());
+RLEFrame::RLEFrame(size_t nRow_,
+		   const vector<unsigned int>& factorTop_,
+		   vector<FrameArray<RLEIdx>> rlePred_,
+		   vector<FrameArray<double>> numRanked_,
+		   vector<FrameArray<unsigned int>> facRanked_,
+		   bool rowOrdered_,
+		   shared_ptr<const void> backing_) :
+  nObs(nRow_),
+  factorTop(factorTop_),
+  noRank(max(nObs, static_cast<size_t>(*max_element(factorTop.begin(), factorTop.end())))),
+  rlePred(move(rlePred_)),
+  numRanked(move(numRanked_)),
+  facRanked(move(facRanked_)),
+  blockIdx(vector<unsigned int>(rlePred.size())),
+  rowOrdered(rowOrdered_),
+  backing(move(backing_)) {
+  unsigned int numIdx = 0;
+  unsigned int factorIdx = 0;
+  for (unsigned predIdx = 0; predIdx != blockIdx.size(); predIdx++) {
+    blockIdx[predIdx] = factorTop[predIdx] == 0 ? numIdx++ : factorIdx++;
+  }
+}
+
+
+vector<vector<RLEIdx>> RLEFrame::packRLE(const vector<size_t>& rleHeight,
+		       const vector<szType>& runVal,
+		       const vector<szType>& runRow,
+		       const vector<szType>& runLength) {
+  vector<vector<RLEIdx>> rlePred(rleHeight.size());
   size_t rleOff = 0;
   for (unsigned int predIdx = 0; predIdx < rleHeight.size(); predIdx++) {
     for (; rleOff < rleHeight[predIdx]; rleOff++) {
@@ -74,6 +208,103 @@ vector<vector<RLEVal<szType>>> RLEFrame::packRLE(const vector<size_t>& rleHeight
 
 
 
+size_t RLEFrame::getFootprint() const {
+  size_t footprint = 0;
+  for (const FrameArray<RLEIdx>& rle : rlePred) {
+    footprint += rle.size() * sizeof(RLEIdx);
+  }
+  for (const FrameArray<double>& num : numRanked) {
+    footprint += num.size() * sizeof(double);
+  }
+  for (const FrameArray<unsigned int>& fac : facRanked) {
+    footprint += fac.size() * sizeof(unsigned int);
+  }
+  return footprint;
+}
+
+
+unique_ptr<RLEFrame> RLEFrame::append(const RLEFrame& base,
+				      const RLEFrame& delta) {
+  if (base.factorTop != delta.factorTop)
+    throw invalid_argument("Appended rows must be typed as the frame");
+  if (base.rowOrdered || delta.rowOrdered)
+    throw invalid_argument("Appending requires runs ordered by rank");
+  if (base.nObs + delta.nObs > numeric_limits<szType>::max())
+    throw invalid_argument("Frame row count exceeds run index width");
+
+  unsigned int nPred = base.getNPred();
+  vector<FrameArray<RLEIdx>> rlePred(nPred);
+  vector<FrameArray<double>> numRanked(base.getNPredNum());
+  vector<FrameArray<unsigned int>> facRanked(base.getNPredFac());
+  OMPBound nPredOMP = nPred;
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound predIdx = 0; predIdx < nPredOMP; predIdx++) {
+    unsigned int blockIdx = base.blockIdx[predIdx];
+    vector<szType> baseRank, deltaRank;
+    if (base.factorTop[predIdx] == 0) {
+      numRanked[blockIdx] = mergeRanked(base.numRanked[blockIdx], delta.numRanked[blockIdx], baseRank, deltaRank);
+    }
+    else {
+      facRanked[blockIdx] = mergeRanked(base.facRanked[blockIdx], delta.facRanked[blockIdx], baseRank, deltaRank);
+    }
+    rlePred[predIdx] = spliceRuns(base.rlePred[predIdx], baseRank, delta.rlePred[predIdx], deltaRank, base.nObs);
+  }
+  }
+
+  return make_unique<RLEFrame>(base.nObs + delta.nObs, base.factorTop, move(rlePred), move(numRanked), move(facRanked), false, nullptr);
+}
+
+
+unique_ptr<RLEFrame> RLEFrame::slice(shared_ptr<const RLEFrame> whole,
+				     size_t rowStart,
+				     size_t rowEnd) {
+  if (rowStart >= rowEnd || rowEnd > whole->nObs)
+    throw invalid_argument("Row range must be nonempty and within frame");
+
+  unsigned int nPred = whole->getNPred();
+  vector<FrameArray<RLEIdx>> rlePred(nPred);
+  OMPBound nPredOMP = nPred;
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound predIdx = 0; predIdx < nPredOMP; predIdx++) {
+    const FrameArray<RLEIdx>& rle = whole->rlePred[predIdx];
+    const RLEIdx* run = rle.begin();
+    if (whole->rowOrdered) { // Skips runs ending before the range.
+      run = upper_bound(rle.begin(), rle.end(), rowStart, [](size_t row, const RLEIdx& run) {
+	  return row < run.getRowEnd();
+	});
+    }
+    vector<RLEIdx> rleSlice;
+    for (; run != rle.end(); run++) {
+      if (whole->rowOrdered && run->row >= rowEnd)
+	break;
+      size_t runStart = max(static_cast<size_t>(run->row), rowStart);
+      size_t runEnd = min(static_cast<size_t>(run->getRowEnd()), rowEnd);
+      if (runStart < runEnd)
+	rleSlice.emplace_back(run->val, runStart - rowStart, runEnd - runStart);
+    }
+    rlePred[predIdx] = move(rleSlice);
+  }
+  }
+
+  vector<FrameArray<double>> numRanked;
+  for (const FrameArray<double>& ranked : whole->numRanked) {
+    numRanked.emplace_back(ranked.data(), ranked.size());
+  }
+  vector<FrameArray<unsigned int>> facRanked;
+  for (const FrameArray<unsigned int>& ranked : whole->facRanked) {
+    facRanked.emplace_back(ranked.data(), ranked.size());
+  }
+
+  bool rowOrdered = whole->rowOrdered;
+  vector<unsigned int> factorTop = whole->factorTop;
+  return make_unique<RLEFrame>(rowEnd - rowStart, factorTop, move(rlePred), move(numRanked), move(facRanked), rowOrdered, move(whole));
+}
+
+
 size_t RLEFrame::findRankMissing(unsigned int predIdx) const {
   size_t rankMissing = noRank;
   unsigned int idx = blockIdx[predIdx];
@@ -93,22 +324,65 @@ size_t RLEFrame::findRankMissing(unsigned int predIdx) const {
 
 
 void RLEFrame::reorderRow() {
-  for (auto & rleVal : rlePred) {
-    sort(rleVal.begin(), rleVal.end(), RLECompareRow<szType>);
+  if (rowOrdered)
+    return;
+  OMPBound nPred = rlePred.size();
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound predIdx = 0; predIdx < nPred; predIdx++) {
+    sortRow(rlePred[predIdx].mutate(), nObs);
+  }
+  }
+  rowOrdered = true;
+}
+
+
+void RLEFrame::sortRow(FrameSpan<RLEIdx> rle,
+		       size_t nObs) {
+  // Marks the starting row of each run.
+  constexpr unsigned int wordBits = 64;
+  vector<uint64_t> startBits((nObs + wordBits - 1) / wordBits);
+  for (const RLEIdx& run : rle) {
+    if (run.row >= nObs)
+      break;
+    startBits[run.row / wordBits] |= 1ull << (run.row % wordBits);
   }
+
+  // Starting rows are distinct iff every run is marked.
+  size_t nStart = 0;
+  vector<size_t> wordRank(startBits.size());
+  for (size_t wordIdx = 0; wordIdx < startBits.size(); wordIdx++) {
+    wordRank[wordIdx] = nStart;
+    nStart += __builtin_popcountll(startBits[wordIdx]);
+  }
+  if (nStart != rle.size()) {
+    sort(rle.begin(), rle.end(), RLECompareRow<RLEIdx>);
+    return;
+  }
+
+  // A run's position is the number of runs starting at lower rows.
+  vector<RLEIdx> rleRow(rle.begin(), rle.end());
+  for (const RLEIdx& run : rle) {
+    uint64_t below = startBits[run.row / wordBits] & ((1ull << (run.row % wordBits)) - 1);
+    rleRow[wordRank[run.row / wordBits] + __builtin_popcountll(below)] = run;
+  }
+  copy(rleRow.begin(), rleRow.end(), rle.begin());
 }
 
 
-vector<RLEVal<szType>> RLEFrame::permute(unsigned int predIdx,
+vector<RLEIdx> RLEFrame::permute(unsigned int predIdx,
 					 const vector<size_t>& idxPerm) const {
-  vector<size_t> row2Rank(nObs);
-  for (auto rle : rlePred[predIdx]) {
-    for (size_t row = rle.row; row != rle.row + rle.extent; row++) {
-      row2Rank[row] = rle.val;
-    }
+  // Runs are disjoint, so scatter independently.
+  vector<szType> row2Rank(nObs);
+  const FrameArray<RLEIdx>& rle = rlePred[predIdx];
+  OMPBound nRun = rle.size();
+#pragma omp parallel for default(shared) schedule(static) num_threads(max(1u, OmpThread::nThread))
+  for (OMPBound runIdx = 0; runIdx < nRun; runIdx++) {
+    fill(row2Rank.begin() + rle[runIdx].row, row2Rank.begin() + rle[runIdx].getRowEnd(), rle[runIdx].val);
   }
 
-  vector<RLEVal<szType>> rleOut;
+  vector<RLEIdx> rleOut;
   size_t rankPrev = nObs; // Inattainable.  Forces new RLE on first iteration.
   size_t row = 0;
   for (auto idx : idxPerm) {
@@ -125,3 +399,48 @@ vector<RLEVal<szType>> RLEFrame::permute(unsigned int predIdx,
 
   return rleOut;
 }
+
+
+vector<size_t> RLEFrame::groupRows(const vector<double>& rowKey) const {
+  auto mix = [](uint64_t hash, uint64_t word) -> uint64_t {
+    hash = (hash ^ word) * 0x100000001b3ull;
+    return hash ^ (hash >> 29);
+  };
+
+  vector<uint64_t> rowHash(nObs);
+  for (size_t row = 0; row < nObs; row++) {
+    double key = rowKey[row] + 0.0; // Identifies negative zero with zero.
+    memcpy(&rowHash[row], &key, sizeof(uint64_t));
+  }
+  for (const FrameArray<RLEIdx>& rle : rlePred) {
+    for (const RLEIdx& run : rle) {
+      for (size_t row = run.row; row < run.getRowEnd(); row++) {
+	rowHash[row] = mix(rowHash[row], run.val);
+      }
+    }
+  }
+
+  vector<size_t> rowRep(nObs);
+  unordered_map<uint64_t, size_t> firstRow;
+  for (size_t row = 0; row < nObs; row++) {
+    rowRep[row] = firstRow.emplace(rowHash[row], row).first->second;
+  }
+
+  // Verifies candidates column by column.
+  for (size_t row = 0; row < nObs; row++) {
+    if (rowKey[row] != rowKey[rowRep[row]])
+      rowRep[row] = row;
+  }
+  vector<szType> row2Rank(nObs);
+  for (const FrameArray<RLEIdx>& rle : rlePred) {
+    for (const RLEIdx& run : rle) {
+      fill(row2Rank.begin() + run.row, row2Rank.begin() + run.getRowEnd(), run.val);
+    }
+    for (size_t row = 0; row < nObs; row++) {
+      if (row2Rank[row] != row2Rank[rowRep[row]])
+	rowRep[row] = row;
+    }
+  }
+
+  return rowRep;
+}
@@ -17,12 +17,15 @@
 #define DEFRAME_RLEFRAME_H
 
 #include "rlecresc.h"
+#include "framearray.h"
+
+#include <memory>
 
 /**
    @brief Sorts on row, for reorder.
 */
-template<typename valType>
-bool RLECompareRow (const RLEVal<valType>& a, const RLEVal<valType>& b) {
+template<typename rleType>
+bool RLECompareRow (const rleType& a, const rleType& b) {
   return (a.row < b.row);
 }
 
@@ -34,19 +37,21 @@ struct RLEFrame {
   const size_t nObs;
   const vector<unsigned int> factorTop; ///> top factor index / 0.
   const size_t noRank; ///> Inattainable rank index.
-  vector<vector<RLEVal<szType>>> rlePred;
-  vector<vector<double>> numRanked;
-  vector<vector<unsigned int>> facRanked;
+  vector<FrameArray<RLEIdx>> rlePred;
+  vector<FrameArray<double>> numRanked;
+  vector<FrameArray<unsigned int>> facRanked;
   vector<unsigned int> blockIdx; ///> position of value in block.
+  bool rowOrdered; ///> Whether runs are ordered by row, rather than rank.
+  shared_ptr<const void> backing; ///> Keeps viewed storage live, if any.
 
   /**
      @brief Constructor from unpacked representation.
    */
   RLEFrame(size_t nObs_,
 	   const vector<unsigned int>& factorTop_,
-	   const vector<size_t>& runVal,
-	   const vector<size_t>& runLength,
-	   const vector<size_t>& runObs,
+	   const vector<szType>& runVal,
+	   const vector<szType>& runLength,
+	   const vector<szType>& runObs,
 	   const vector<size_t>& rleHeight_,
 	   const vector<double>& numVal_,
 	   const vector<size_t>& numHeight_,
@@ -54,13 +59,39 @@ struct RLEFrame {
 	   const vector<size_t>& facHeight_);
 
 
+  /**
+     @brief As above, but with runs already packed by predictor.
+   */
+  RLEFrame(size_t nObs_,
+	   const vector<unsigned int>& factorTop_,
+	   vector<vector<RLEIdx>> rlePred_,
+	   const vector<double>& numVal_,
+	   const vector<size_t>& numHeight_,
+	   const vector<unsigned int>& facVal_,
+	   const vector<size_t>& facHeight_);
+
+
+  /**
+     @brief As above, but viewing external storage, such as a mapped file.
+
+     @param backing_ owns the viewed storage.
+   */
+  RLEFrame(size_t nObs_,
+	   const vector<unsigned int>& factorTop_,
+	   vector<FrameArray<RLEIdx>> rlePred_,
+	   vector<FrameArray<double>> numRanked_,
+	   vector<FrameArray<unsigned int>> facRanked_,
+	   bool rowOrdered_,
+	   shared_ptr<const void> backing_);
+
+
   /**
      @brief Builds the per-predictor vectors of run-length encodings.
    */
-  static vector<vector<RLEVal<szType>>> packRLE(const vector<size_t>& rleHeight,
-						const vector<size_t>& runVal,
-						const vector<size_t>& runRow,
-						const vector<size_t>& runLength);
+  static vector<vector<RLEIdx>> packRLE(const vector<size_t>& rleHeight,
+						const vector<szType>& runVal,
+						const vector<szType>& runRow,
+						const vector<szType>& runLength);
 
 
   /**
@@ -112,7 +143,7 @@ struct RLEFrame {
   }
   
 
-  const vector<RLEVal<szType>>& getRLE(unsigned int predIdx) const {
+  const FrameArray<RLEIdx>& getRLE(unsigned int predIdx) const {
     return rlePred[predIdx];
   }
 
@@ -129,42 +160,105 @@ struct RLEFrame {
   }
 
 
+  /**
+     @return bytes held by runs and ranked values, owned or viewed.
+   */
+  size_t getFootprint() const;
+
+
   /**
      @brief Reorders the predictor RLE vectors by row.
+
+     Predictors are reordered in parallel.  Viewed runs are copied
+     before reordering.  No-op if already ordered by row.
    */
   void reorderRow();
 
 
+  /**
+     @brief Orders a predictor's runs by row, in linear time.
+
+     Runs partition the rows, so each row begins at most one run.  A
+     run's position is then the count of marked starting rows below its
+     own, obtained by population count.  Reverts to a comparison sort
+     should starting rows collide.
+
+     @param nObs is the number of rows spanned.
+   */
+  static void sortRow(FrameSpan<RLEIdx> rle,
+		      size_t nObs);
+
+
   /**
      @return rank index of missing data, if any, else noRank.
    */
   size_t findRankMissing(unsigned int predIdx) const;
 
 
-  vector<RLEVal<szType>> permute(unsigned int predIdx,
+  /**
+     @brief Encodes a predictor's ranks under a row permutation.
+
+     @param idxPerm maps each output row to its source row.
+
+     @return runs of the permuted column, ordered by row.
+   */
+  vector<RLEIdx> permute(unsigned int predIdx,
 				 const vector<size_t>& idxPerm) const;
 
 
   /**
-     @brief Obtains the predictor rank at a given row.
+     @brief Appends the rows of a second frame to those of a first.
 
-     @param[in, out] idxTr gives the element referencing row.
+     Only the appended rows need have been sorted:  value tables are
+     merged, ranks remapped and runs spliced, in time linear in the
+     values and runs of both frames.
 
-     @param row is the specified row.
+     @param base holds the leading rows.
 
-     @return rank at the given row, per predictor.
+     @param delta holds the trailing rows, typed as base.
+
+     @return frame spanning the rows of both, ordered by rank.
    */
-  vector<szType> idxRank(vector<size_t>& idxTr,
-			       size_t row) const {
-    vector<szType> rankVec(idxTr.size());
-    for (unsigned int predIdx = 0; predIdx < rankVec.size(); predIdx++) {
-      if (row >= rlePred[predIdx][idxTr[predIdx]].getRowEnd()) {
-	idxTr[predIdx]++;
-      }
-      rankVec[predIdx] = rlePred[predIdx][idxTr[predIdx]].val;
-    }
-    return rankVec;
-  }
+  static unique_ptr<RLEFrame> append(const RLEFrame& base,
+				     const RLEFrame& delta);
+
+
+  /**
+     @brief Restricts a frame to a range of rows, as for a shard of a
+     distributed prediction.
+
+     Runs are clipped to the range and rebased to its first row, in
+     their existing order.  Value tables and factor tops are unchanged,
+     so ranks and codes agree with those of the whole frame.  The tables
+     are viewed rather than copied:  the slice holds the whole frame.
+     Intended for prediction, as training expects every tabulated value
+     to be present.
+
+     @param whole is the frame to be sliced, possibly mapped.
+
+     @param rowStart is the first row of the range.
+
+     @param rowEnd is the sup of the range, which must be nonempty.
+
+     @return frame spanning the rows of the range.
+   */
+  static unique_ptr<RLEFrame> slice(shared_ptr<const RLEFrame> whole,
+				    size_t rowStart,
+				    size_t rowEnd);
+
+
+  /**
+     @brief Identifies rows agreeing in rank on every predictor.
+
+     Rows are bucketed by a hash of their ranks, then verified against
+     their bucket's first row, so that colliding rows remain distinct.
+
+     @param rowKey is an additional per-row value, such as the response,
+     on which rows must also agree.
+
+     @return lowest row equal to each row, possibly itself.
+   */
+  vector<size_t> groupRows(const vector<double>& rowKey) const;
 };
 
 #endif
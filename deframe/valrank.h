@@ -18,9 +18,13 @@
 #define DEFRAME_VALRANK_H
 
 #include "typeparam.h" // For now
+#include "ompthread.h"
 
 #include <algorithm>
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
 
 using namespace std;
 
@@ -64,15 +68,183 @@ inline bool ValRankCompare (const ValRank<double>& a,
 }
 
 
+/**
+   @brief Least-significant-digit radix ordering of rows by value.
+
+   Rows enter in increasing order and each pass is stable, so tied
+   values remain ordered by row, as with ValRankCompare.  Passes over
+   digits held in common by all keys are skipped, so that small factor
+   codes typically require a single pass.  Columns exceeding
+   'parallelMin' rows partition each pass into contiguous chunks, with
+   per-chunk histograms merged in chunk order to preserve stability.
+ */
+struct RadixSort {
+  static constexpr unsigned int digitBits = 8;
+  static constexpr size_t nDigit = 1ul << digitBits;
+  static constexpr size_t parallelMin = 1ul << 20; // Rows per column.
+
+  template<typename keyType>
+  struct KeyRow {
+    keyType key;
+    size_t row;
+  };
+
+
+  /**
+     @brief Maps a double to an unsigned key of identical order.
+
+     Negative values are complemented and nonnegative values have their
+     sign bit set.  Zeroes of either sign share a key, and all NaN map
+     to the maximal key, hence sort last.
+   */
+  static uint64_t key(double val) {
+    if (isnan(val))
+      return UINT64_MAX;
+    if (val == 0.0)
+      val = 0.0;
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return (bits >> 63) != 0 ? ~bits : bits | (1ull << 63);
+  }
+
+
+  static uint32_t key(unsigned int val) {
+    return val;
+  }
+
+
+  /**
+     @brief Orders rows of a double-valued column.
+
+     @param nThread is the maximal team size employed.
+
+     @return row indices in increasing value order, ties by row.
+   */
+  static vector<size_t> sortedRows(const double val[],
+				   size_t nRow,
+				   unsigned int nThread) {
+    return keyedRows<uint64_t>(val, nRow, nThread);
+  }
+
+
+  /**
+     @brief As above, but for factor codes.
+   */
+  static vector<size_t> sortedRows(const unsigned int val[],
+				   size_t nRow,
+				   unsigned int nThread) {
+    return keyedRows<uint32_t>(val, nRow, nThread);
+  }
+
+
+  /**
+     @brief Comparison-sort fallback for types lacking a radix key.
+   */
+  template<typename valType>
+  static vector<size_t> sortedRows(const valType val[],
+				   size_t nRow,
+				   unsigned int nThread) {
+    vector<ValRank<valType>> valRow;
+    for (size_t row = 0; row < nRow; row++) {
+      valRow.emplace_back(val[row], row);
+    }
+    sort(valRow.begin(), valRow.end(), ValRankCompare<valType>);
+    vector<size_t> rowOut(nRow);
+    for (size_t idx = 0; idx < nRow; idx++) {
+      rowOut[idx] = valRow[idx].row;
+    }
+    return rowOut;
+  }
+
+
+  template<typename keyType, typename valType>
+  static vector<size_t> keyedRows(const valType val[],
+				  size_t nRow,
+				  unsigned int nThread) {
+    vector<KeyRow<keyType>> keyRow(nRow);
+    for (size_t row = 0; row < nRow; row++) {
+      keyRow[row] = KeyRow<keyType>{static_cast<keyType>(key(val[row])), row};
+    }
+    order(keyRow, nRow < parallelMin ? 1 : max(1u, nThread));
+
+    vector<size_t> rowOut(nRow);
+    for (size_t idx = 0; idx < nRow; idx++) {
+      rowOut[idx] = keyRow[idx].row;
+    }
+    return rowOut;
+  }
+
+
+  /**
+     @brief Stably orders key/row pairs by key.
+
+     @param nChunk is the number of contiguous chunks processed in parallel.
+   */
+  template<typename keyType>
+  static void order(vector<KeyRow<keyType>>& keyRow,
+		    unsigned int nChunk) {
+    size_t nObs = keyRow.size();
+    vector<KeyRow<keyType>> work(nObs);
+    vector<size_t> offset(nChunk * nDigit);
+    for (unsigned int shift = 0; shift < 8 * sizeof(keyType); shift += digitBits) {
+      fill(offset.begin(), offset.end(), 0);
+#pragma omp parallel for default(shared) schedule(static, 1) num_threads(nChunk)
+      for (OMPBound chunk = 0; chunk < nChunk; chunk++) {
+	size_t* histo = &offset[chunk * nDigit];
+	for (size_t idx = chunkStart(nObs, nChunk, chunk); idx != chunkStart(nObs, nChunk, chunk + 1); idx++) {
+	  histo[(keyRow[idx].key >> shift) & (nDigit - 1)]++;
+	}
+      }
+
+      // Converts counts to scatter origins, digit-major and chunk-minor.
+      size_t base = 0;
+      bool common = false; // Whether a single digit holds all keys.
+      for (size_t digit = 0; digit < nDigit; digit++) {
+	size_t digitBase = base;
+	for (unsigned int chunk = 0; chunk < nChunk; chunk++) {
+	  size_t count = offset[chunk * nDigit + digit];
+	  offset[chunk * nDigit + digit] = base;
+	  base += count;
+	}
+	common = common || (base - digitBase == nObs);
+      }
+      if (common)
+	continue;
+
+#pragma omp parallel for default(shared) schedule(static, 1) num_threads(nChunk)
+      for (OMPBound chunk = 0; chunk < nChunk; chunk++) {
+	size_t* dest = &offset[chunk * nDigit];
+	for (size_t idx = chunkStart(nObs, nChunk, chunk); idx != chunkStart(nObs, nChunk, chunk + 1); idx++) {
+	  work[dest[(keyRow[idx].key >> shift) & (nDigit - 1)]++] = keyRow[idx];
+	}
+      }
+      keyRow.swap(work);
+    }
+  }
+
+
+  static size_t chunkStart(size_t nObs,
+			   unsigned int nChunk,
+			   size_t chunk) {
+    return (nObs * chunk) / nChunk;
+  }
+};
+
+
 template<typename valType>
 class RankedObs {
   vector<ValRank<valType> > valRow;
 
 public:
 
+  /**
+     @param nThread is the maximal team size for ordering tall columns.
+   */
   RankedObs(const valType val[],
-	    size_t nRow) {
-    for (size_t row = 0; row < nRow; row++) {
+	    size_t nRow,
+	    unsigned int nThread = 1) {
+    valRow.reserve(nRow);
+    for (size_t row : RadixSort::sortedRows(val, nRow, nThread)) {
       valRow.emplace_back(val[row], row);
     }
     order();
@@ -115,15 +287,9 @@ public:
   
   
   /**
-     @brief Orders and assigns ranks.
-     
-     Ensures a stable sort ut identify maximal runs.
-
-     N.B.:  extraneous parentheses work around parser error in older g++.
+     @brief Assigns ranks to the stably-ordered rows.
    */
   void order() {
-    sort(valRow.begin(), valRow.end(), ValRankCompare<valType>);
-
     // Increments rank values beginning from default value of zero at base.
     //
     for (size_t idx = 1; idx < valRow.size(); idx++) {
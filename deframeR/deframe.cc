@@ -27,6 +27,8 @@
 #include "deframe.h"
 #include "block.h"
 #include "rleframeR.h"
+#include "rleframe.h"
+#include "framefile.h"
 
 #include<memory>
 
@@ -100,6 +102,20 @@ RcppExport SEXP deframeNum(SEXP sX) {
 }
 
 
+RcppExport SEXP deframeDense(SEXP sX) {
+  NumericMatrix blockNum(sX);
+  List deframe = List::create(
+			      _["denseNum"] = blockNum,
+			      _["nRow"] = blockNum.nrow(),
+			      _["signature"] = Signature::wrapNum(blockNum.ncol(),
+								  colnames(blockNum),
+								  rownames(blockNum))
+			      );
+  deframe.attr("class") = "Deframe";
+  return deframe;
+}
+
+
 /**
    @brief Reads an S4 object containing (sparse) dgCMatrix.
  */
@@ -146,11 +162,7 @@ RcppExport SEXP deframeIP(SEXP sX) {
   IntegerVector dim = spNum.slot("Dim"); // #row, #pred
   size_t nRow = dim[0];
   unsigned int nPred = dim[1];
-  unique_ptr<BlockIPCresc<double> > blockIPCresc = make_unique<BlockIPCresc<double> >(nRow, nPred);
-
-  vector<size_t> rowNZ(i.begin(), i.end());
-  vector<size_t> idxPred(p.begin(), p.end());
-  blockIPCresc->nzRow(&as<NumericVector>(spNum.slot("x"))[0], rowNZ, idxPred);
+  NumericVector x(spNum.slot("x"));
 
   List dimNames;
   CharacterVector rowName = CharacterVector(0);
@@ -167,7 +179,7 @@ RcppExport SEXP deframeIP(SEXP sX) {
   UNPROTECT(1);
 
   List deframe = List::create(
-			      _["rleFrame"] = RLEFrameR::presortIP(blockIPCresc.get(), nRow, nPred),
+			      _["rleFrame"] = RLEFrameR::presortCSC(x, i, p, nRow, nPred),
 			      _["nRow"] = nRow,
 			      _["signature"] = Signature::wrapNum(nPred, colName, rowName));
   deframe.attr("class") = "Deframe";
@@ -175,3 +187,46 @@ RcppExport SEXP deframeIP(SEXP sX) {
 
   END_RCPP
 }
+
+
+RcppExport SEXP deframeSave(SEXP sDeframe,
+			    SEXP sPath,
+			    SEXP sRowOrder) {
+  BEGIN_RCPP
+
+  unique_ptr<RLEFrame> rleFrame = RLEFrameR::unwrap(List(sDeframe));
+  FrameFile::write(rleFrame.get(), as<string>(sPath), as<bool>(sRowOrder));
+  return R_NilValue;
+
+  END_RCPP
+}
+
+
+RcppExport SEXP deframeGroupRows(SEXP sDeframe,
+				 SEXP sKey) {
+  BEGIN_RCPP
+
+  unique_ptr<RLEFrame> rleFrame = RLEFrameR::unwrap(List(sDeframe));
+  NumericVector key(sKey);
+  if (static_cast<size_t>(key.length()) != rleFrame->getNRow())
+    stop("Key length must match row count");
+  vector<size_t> rowRep = rleFrame->groupRows(as<vector<double>>(key));
+  IntegerVector repOut(rowRep.size());
+  for (size_t row = 0; row < rowRep.size(); row++) {
+    repOut[row] = rowRep[row] + 1;
+  }
+  return repOut;
+
+  END_RCPP
+}
+
+
+RcppExport SEXP deframeAppend(SEXP sDeframe,
+			      SEXP sDelta) {
+  BEGIN_RCPP
+
+  unique_ptr<RLEFrame> rleFrame = RLEFrame::append(*RLEFrameR::unwrap(List(sDeframe)), *RLEFrameR::unwrap(List(sDelta)));
+  return RLEFrameR::wrapFrame(rleFrame.get());
+
+  END_RCPP
+}
@@ -71,6 +71,56 @@ RcppExport SEXP deframeFac(SEXP sX);
 RcppExport SEXP deframeNum(SEXP sX);
 
 
+/**
+   @brief Wraps a numeric matrix for prediction, without encoding.
+
+   @param sX is the matrix, referenced in place.
+ */
+RcppExport SEXP deframeDense(SEXP sX);
+
+
 RcppExport SEXP deframeIP(SEXP sX);
 
+
+/**
+   @brief Persists the ranked frame of a deframed object for mapping.
+
+   @param sDeframe is the deframed object.
+
+   @param sPath is the file to be written.
+
+   @param sRowOrder is true iff runs are to be written ordered by row,
+   for prediction only.
+ */
+RcppExport SEXP deframeSave(SEXP sDeframe,
+			    SEXP sPath,
+			    SEXP sRowOrder);
+
+
+/**
+   @brief Identifies rows of a deframed object equal on every predictor
+   and on a key.
+
+   @param sDeframe is the deframed object.
+
+   @param sKey is a numeric vector of per-row keys, such as the response.
+
+   @return one-based index of the lowest row equal to each row.
+ */
+RcppExport SEXP deframeGroupRows(SEXP sDeframe,
+				 SEXP sKey);
+
+
+/**
+   @brief Appends the rows of one deframed object to those of another.
+
+   @param sDeframe is the deframed object holding the leading rows.
+
+   @param sDelta is the deframed object holding the trailing rows.
+
+   @return run-length encoding spanning the rows of both.
+ */
+RcppExport SEXP deframeAppend(SEXP sDeframe,
+			      SEXP sDelta);
+
 #endif
@@ -24,12 +24,14 @@
 */
 
 #include "rleframeR.h"
+#include "framefile.h"
+#include "levelmap.h"
 
 
 List RLEFrameR::presortDF(const DataFrame& df, SEXP sSigTrain, SEXP sLevel) {
   BEGIN_RCPP
 
-  IntegerMatrix factorRemap;
+  vector<vector<unsigned int>> factorRemap;
   if (!Rf_isNull(sSigTrain)) {
     factorRemap = factorReconcile(df, List(sSigTrain), List(sLevel));
   }
@@ -42,13 +44,14 @@ List RLEFrameR::presortDF(const DataFrame& df, SEXP sSigTrain, SEXP sLevel) {
   // loop.
   // N.B.:  According to Rcpp documentation, this style of Vector
   // constructor merely wraps a pointer and does not generate a copy.
-  List lLevel(sLevel);
+  // Recoded factors take the training cardinality.
+  List lLevel(Rf_isNull(sSigTrain) ? sLevel : (SEXP) List(sSigTrain)["level"]);
   unsigned int nFac = 0;
   vector<void*> colBase(df.length());
   for (unsigned int predIdx = 0; predIdx < df.length(); predIdx++) {
     if (Rf_isFactor(df[predIdx])) {
       rleCresc->setFactor(predIdx, as<CharacterVector>(lLevel[nFac]).length());
-      colBase[predIdx] = !Rf_isNull(sSigTrain) ? IntegerVector(factorRemap(_, nFac)).begin() : IntegerVector(df[predIdx]).begin();
+      colBase[predIdx] = !factorRemap.empty() && !factorRemap[nFac].empty() ? static_cast<void*>(factorRemap[nFac].data()) : static_cast<void*>(IntegerVector(df[predIdx]).begin());
       nFac++;
     }
     else {
@@ -65,72 +68,40 @@ List RLEFrameR::presortDF(const DataFrame& df, SEXP sSigTrain, SEXP sLevel) {
 }
 
 
-IntegerMatrix RLEFrameR::factorReconcile(const DataFrame& df,
-					 const List& lSigTrain,
-					 const List& levelTest) {
-  BEGIN_RCPP
-
+vector<vector<unsigned int>> RLEFrameR::factorReconcile(const DataFrame& df,
+							const List& lSigTrain,
+							const List& lLevel) {
   List levelTrain(as<List>(lSigTrain["level"]));
-  IntegerMatrix mappedFactor(df.nrow(), levelTrain.length());
+  vector<vector<string>> dictTrain, dictTest;
+  vector<const int*> colCode;
   unsigned int nFac = 0;
   for (int col = 0; col < df.length(); col++) {
     if (Rf_isFactor(df[col])) {
-      mappedFactor(_, nFac) = columnReconcile(IntegerVector(df[col]), as<CharacterVector>(levelTest[nFac]), as<CharacterVector>(levelTrain[nFac]));
+      dictTrain.push_back(as<vector<string>>(levelTrain[nFac]));
+      dictTest.push_back(as<vector<string>>(lLevel[nFac]));
+      colCode.push_back(IntegerVector(df[col]).begin());
       nFac++;
     }
   }
-  return mappedFactor;
-
-  END_RCPP
-}
-
-
-IntegerVector RLEFrameR::columnReconcile(const IntegerVector& dfCol,
-					 const CharacterVector& colTest,
-					 const CharacterVector& colTrain) {
-  BEGIN_RCPP
-    
-  if (is_true(any(colTest != colTrain))) {
-    IntegerVector colMatch(match(colTest, colTrain));
-    // Rcpp match() implementation does not suppport 'na' subsititute.
-    if (is_true(any(is_na(colMatch)))) {
-      warning("Test data contains labels absent from training:  employing proxy factor");
-      colMatch = ifelse(is_na(colMatch), static_cast<int>(colTrain.length()) + 1, colMatch);
-    }
-
-    // N.B.:  Rcpp::match() indices are one-based.
-    IntegerVector dfZero(dfCol - 1); // R factor indices are one-based.
-
-    /*
-    // Checks whether non-proxy output recovers the original string indices.
-    for (int i = 0; i < colOut.length(); i++) {
-      if (colOut[i] < colTrain.length()) {
-	if (colTest[dfZero[i]] != colTrain[colOut[i]] - 1)
-	  Rcout << "mismatch"<< endl;
-      }
-    }
-    */
 
-    // Rcpp subscripting is zero-based.
-    return as<IntegerVector>(colMatch[dfZero]);
+  LevelMap::Unseen unseen;
+  vector<vector<unsigned int>> recoded = LevelMap(dictTrain).reconcile(dictTest, colCode, df.nrow(), unseen);
+  if (unseen.nObs > 0) {
+    warning("Test data contains %d labels absent from training, in %d columns and %d rows:  employing proxy factor", unseen.nLevel, unseen.nCol, unseen.nObs);
   }
-  else {
-    return dfCol;
-  }
-
-  END_RCPP
+  return recoded;
 }
 
 
-List RLEFrameR::presortIP(const BlockIPCresc<double>* rleCrescIP, size_t nRow, unsigned int nPred) {
+List RLEFrameR::presortCSC(const NumericVector& x,
+			   const IntegerVector& i,
+			   const IntegerVector& p,
+			   size_t nRow,
+			   unsigned int nPred) {
   BEGIN_RCPP
 
-    auto rleCresc = make_unique<RLECresc>(nRow, nPred);
-
-  vector<double> valNum(rleCrescIP->getVal());
-  vector<size_t> rowStart(rleCrescIP->getRunStart());
-  vector<size_t> runLength(rleCrescIP->getRunLength());
-  rleCresc->encodeFrameNum(move(valNum), move(rowStart), move(runLength));
+  auto rleCresc = make_unique<RLECresc>(nRow, nPred);
+  rleCresc->encodeFrameCSC(x.begin(), i.begin(), p.begin());
 
   return wrap(rleCresc.get());
 
@@ -236,9 +207,9 @@ List RLEFrameR::wrapRF(const RLECresc* rleCresc) {
 
   vector<size_t> rleHeight(rleCresc->getHeight());
   size_t height = rleHeight.back();
-  vector<size_t> valOut(height);
-  vector<size_t> lengthOut(height);
-  vector<size_t> rowOut(height);
+  vector<szType> valOut(height);
+  vector<szType> lengthOut(height);
+  vector<szType> rowOut(height);
   rleCresc->dump(valOut, lengthOut, rowOut);
   List rankedFrame = List::create(
 				  _["nRow"] = rleCresc->getNRow(),
@@ -254,8 +225,83 @@ List RLEFrameR::wrapRF(const RLECresc* rleCresc) {
 }
 
 
+List RLEFrameR::wrapFrame(const RLEFrame* rleFrame) {
+  BEGIN_RCPP
+
+  vector<szType> valOut, lengthOut, rowOut;
+  vector<size_t> rleHeight;
+  vector<unsigned int> topIdx;
+  for (unsigned int predIdx = 0; predIdx < rleFrame->getNPred(); predIdx++) {
+    for (const RLEIdx& run : rleFrame->getRLE(predIdx)) {
+      valOut.push_back(run.val);
+      lengthOut.push_back(run.extent);
+      rowOut.push_back(run.row);
+    }
+    rleHeight.push_back(valOut.size());
+    topIdx.push_back(rleFrame->getFactorTop(predIdx));
+  }
+  List rankedFrame = List::create(
+				  _["nRow"] = rleFrame->getNRow(),
+				  _["runVal"] = valOut,
+				  _["runLength"] = lengthOut,
+				  _["runRow"] = rowOut,
+				  _["rleHeight"] = rleHeight,
+				  _["topIdx"] = topIdx
+				  );
+  rankedFrame.attr("class") = "RankedFrame";
+
+  vector<double> numValOut;
+  vector<size_t> numHeight;
+  for (const FrameArray<double>& numPred : rleFrame->numRanked) {
+    numValOut.insert(numValOut.end(), numPred.begin(), numPred.end());
+    numHeight.push_back(numValOut.size());
+  }
+  List numRanked = List::create(
+				_["numVal"] = numValOut,
+				_["numHeight"] = numHeight
+				);
+  numRanked.attr("class") = "NumRanked";
+
+  vector<unsigned int> facValOut;
+  vector<size_t> facHeight;
+  for (const FrameArray<unsigned int>& facPred : rleFrame->facRanked) {
+    facValOut.insert(facValOut.end(), facPred.begin(), facPred.end());
+    facHeight.push_back(facValOut.size());
+  }
+  List facRanked = List::create(
+				_["facVal"] = facValOut,
+				_["facHeight"] = facHeight
+				);
+  facRanked.attr("class") = "FacRanked";
+
+  List setOut = List::create(
+			     _["rankedFrame"] = rankedFrame,
+			     _["numRanked"] = numRanked,
+			     _["facRanked"] = facRanked
+			     );
+  setOut.attr("class") = "RLEFrame";
+  return setOut;
+
+  END_RCPP
+}
+
+
 unique_ptr<RLEFrame> RLEFrameR::unwrap(const List& lDeframe) {
+  unique_ptr<RLEFrame> rleFrame(unwrapWhole(lDeframe));
+  if (!lDeframe.containsElementNamed("rowShard")) {
+    return rleFrame;
+  }
+  // Zero-based first row and sup, as set by predictShard().
+  NumericVector rowShard((SEXP) lDeframe["rowShard"]);
+  return RLEFrame::slice(move(rleFrame), rowShard[0], rowShard[1]);
+}
+
+
+unique_ptr<RLEFrame> RLEFrameR::unwrapWhole(const List& lDeframe) {
   List rleList((SEXP) lDeframe["rleFrame"]);
+  if (rleList.containsElementNamed("framePath")) {
+    return FrameFile::map(as<string>(rleList["framePath"]));
+  }
   List blockNum = checkNumRanked((SEXP) rleList["numRanked"]);
   NumericVector numVal(Rf_isNull(blockNum["numVal"]) ? NumericVector(0) : NumericVector((SEXP) blockNum["numVal"]));
   IntegerVector numHeight(Rf_isNull(blockNum["numHeight"]) ? IntegerVector(0) : IntegerVector((SEXP) blockNum["numHeight"]));
@@ -274,17 +320,27 @@ unique_ptr<RLEFrame> RLEFrameR::unwrap(const List& lDeframe) {
 }
 
 
+unique_ptr<DenseFrame> RLEFrameR::unwrapDense(const List& lDeframe) {
+  if (!lDeframe.containsElementNamed("denseNum")) {
+    return nullptr;
+  }
+
+  NumericMatrix blockNum((SEXP) lDeframe["denseNum"]);
+  return make_unique<DenseFrame>(blockNum.nrow(), blockNum.ncol(), blockNum.begin(), 0, nullptr, true);
+}
+
+
 unique_ptr<RLEFrame> RLEFrameR::unwrapFrame(const List& rankedFrame,
 					    const NumericVector& numValFE,
 					    const IntegerVector& numHeightFE,
 					    const IntegerVector& facValFE,
 					    const IntegerVector& facHeightFE) {
   IntegerVector valFE((SEXP) rankedFrame["runVal"]);
-  vector<size_t> runVal(valFE.begin(), valFE.end());
+  vector<szType> runVal(valFE.begin(), valFE.end());
   IntegerVector lengthFE((SEXP) rankedFrame["runLength"]);
-  vector<size_t> runLength(lengthFE.begin(), lengthFE.end());
+  vector<szType> runLength(lengthFE.begin(), lengthFE.end());
   IntegerVector rowFE((SEXP) rankedFrame["runRow"]);
-  vector<size_t> runRow(rowFE.begin(), rowFE.end());
+  vector<szType> runRow(rowFE.begin(), rowFE.end());
   IntegerVector heightFE((SEXP) rankedFrame["rleHeight"]);
   vector<size_t> rleHeight(heightFE.begin(), heightFE.end());
   IntegerVector topIdxFE((SEXP) rankedFrame["topIdx"]);
@@ -36,6 +36,7 @@ using namespace Rcpp;
 using namespace std;
 
 #include "rleframe.h"
+#include "denseframe.h"
 #include "block.h"
 
 
@@ -80,24 +81,20 @@ struct RLEFrameR {
   /**
      @brief Maps factor encodings of current observation set to those of training.
 
-     Employs proxy values for any levels unseen during training.
+     Employs proxy values for any levels unseen during training, warning
+     once with a census of such levels.
 
      @param df is a data frame.
 
-     @param sLevel contain the level strings of core-indexed factor predictors.
+     @param lSigTrain holds the training signature.
 
-     @param sSigTrain holds the training signature.
+     @param lLevel contain the level strings of core-indexed factor predictors.
 
-     @return rewritten data frame.
+     @return recoded factor columns, empty where levels agree with training.
   */
-  static IntegerMatrix factorReconcile(const DataFrame& df,
-				       const List& lSigTrain,
-				       const List& lLevel);
-
-
-  static IntegerVector columnReconcile(const IntegerVector& dfCol,
-				       const CharacterVector& colTest,
-				       const CharacterVector& colTrain);
+  static vector<vector<unsigned int>> factorReconcile(const DataFrame& df,
+						      const List& lSigTrain,
+						      const List& lLevel);
 
 
   /**
@@ -119,11 +116,21 @@ struct RLEFrameR {
 
 
   /**
-     @brief Presorts a dcgMatrix encoded with 'I' and 'P' descriptors.
+     @brief Presorts a dgCMatrix encoded with 'I' and 'P' descriptors.
+
+     The slots are read in place and zeroes are never expanded.
+
+     @param x holds the nonzero values.
+
+     @param i holds the zero-based rows of the nonzero values.
+
+     @param p holds the per-column offsets into 'x' and 'i'.
    */
-  static List presortIP(const class BlockIPCresc<double>* rleCrescIP,
-			size_t nRow,
-			unsigned int nPred);
+  static List presortCSC(const NumericVector& x,
+			 const IntegerVector& i,
+			 const IntegerVector& p,
+			 size_t nRow,
+			 unsigned int nPred);
 
   /**
      @brief Produces an R-style run-length encoding of the frame.
@@ -142,9 +149,34 @@ struct RLEFrameR {
   static List wrapFac(const class RLECresc* rleCresc);
 
   
+  /**
+     @brief As above, but encoding a completed frame.
+   */
+  static List wrapFrame(const RLEFrame* rleFrame);
+
+
+  /**
+     @brief Builds the core frame, mapping it if persisted.
+
+     Restricted to a row range if 'lDeframe' names a shard.
+   */
   static unique_ptr<RLEFrame> unwrap(const List& lDeframe);
 
 
+  /**
+     @brief As above, but spanning every row.
+   */
+  static unique_ptr<RLEFrame> unwrapWhole(const List& lDeframe);
+
+
+  /**
+     @brief Aliases an unencoded numeric block, if present.
+
+     @return dense frame iff deframed without presorting, else null.
+   */
+  static unique_ptr<DenseFrame> unwrapDense(const List& lDeframe);
+
+
   static unique_ptr<RLEFrame> unwrapFrame(const List& rankedFrame,
 					  const NumericVector& numVal,
 					  const IntegerVector& numHeight,
@@ -0,0 +1,76 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file bagstore.cc
+
+   @brief Methods building the observation-major bag.
+
+   @author Mark Seligman
+ */
+
+#include "bagstore.h"
+#include "samplernux.h"
+
+
+BagStore::BagStore(const vector<vector<SamplerNux>>& samples,
+		   size_t nObs_) :
+  nObs(nObs_),
+  nTree(samples.size()) {
+  size_t nRecord = 0;
+  for (auto & nux : samples) {
+    nRecord += nux.size();
+  }
+
+  // Compares bit counts of the two encodings.
+  size_t sparseBits = nRecord * 8 * sizeof(unsigned int) + (nObs + 1) * 8 * sizeof(size_t);
+  size_t denseBits = nObs * ((nTree + BV::slotElts - 1) / BV::slotElts) * BV::slotElts;
+  if (sparseBits < denseBits)
+    fillSparse(samples, nRecord);
+  else
+    fillDense(samples);
+}
+
+
+void BagStore::fillDense(const vector<vector<SamplerNux>>& samples) {
+  bagDense = make_unique<BitMatrix>(nObs, nTree);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    IndexT row = 0;
+    for (auto nux : samples[tIdx]) {
+      row += nux.getDelRow();
+      bagDense->setBit(row, tIdx);
+    }
+  }
+}
+
+
+void BagStore::fillSparse(const vector<vector<SamplerNux>>& samples,
+			  size_t nRecord) {
+  // First pass counts the trees bagging each row, second pass fills.
+  // Trees are visited in order, so each row's list is sorted.
+  rowOffset = vector<size_t>(nObs + 1);
+  for (auto & nux : samples) {
+    IndexT row = 0;
+    for (auto rec : nux) {
+      row += rec.getDelRow();
+      rowOffset[row + 1]++;
+    }
+  }
+  for (size_t row = 0; row < nObs; row++) {
+    rowOffset[row + 1] += rowOffset[row];
+  }
+
+  treeBagged = vector<unsigned int>(nRecord);
+  vector<size_t> rowFill(rowOffset.begin(), rowOffset.end() - 1);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    IndexT row = 0;
+    for (auto rec : samples[tIdx]) {
+      row += rec.getDelRow();
+      treeBagged[rowFill[row]++] = tIdx;
+    }
+  }
+}
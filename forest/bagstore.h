@@ -0,0 +1,107 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file bagstore.h
+
+   @brief Observation-major record of bagging, dense or compressed.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_BAGSTORE_H
+#define FOREST_BAGSTORE_H
+
+#include "bv.h"
+#include "typeparam.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+
+/**
+   @brief Answers membership and out-of-bag iteration by row.
+
+   Dense bags are stored as an observation-major bit matrix.  Sparse
+   bags, as arise from small sample counts, are stored as per-row
+   sorted lists of the bagging trees, whenever the lists occupy less
+   space than the matrix.
+ */
+class BagStore {
+  const size_t nObs;
+  const unsigned int nTree;
+  unique_ptr<BitMatrix> bagDense; // Non-null iff dense.
+  vector<size_t> rowOffset; // Per-row list origins, iff sparse.
+  vector<unsigned int> treeBagged; // Concatenated per-row tree lists.
+
+  /**
+     @brief Builds the compressed encoding.
+   */
+  void fillSparse(const vector<vector<class SamplerNux>>& samples,
+		  size_t nRecord);
+
+  /**
+     @brief Builds the dense encoding.
+   */
+  void fillDense(const vector<vector<class SamplerNux>>& samples);
+
+public:
+
+  /**
+     @param samples are the per-tree sample records.
+   */
+  BagStore(const vector<vector<class SamplerNux>>& samples,
+	   size_t nObs_);
+
+
+  /**
+     @return true iff the compressed encoding is employed.
+   */
+  bool isSparse() const {
+    return bagDense == nullptr;
+  }
+
+
+  /**
+     @return true iff observation is bagged in tree.
+   */
+  inline bool isBagged(size_t row,
+		       unsigned int tIdx) const {
+    if (bagDense != nullptr)
+      return bagDense->testBit(row, tIdx);
+    return binary_search(treeBagged.data() + rowOffset[row], treeBagged.data() + rowOffset[row + 1], tIdx);
+  }
+
+
+  /**
+     @brief Locates the next tree for which a row is out-of-bag.
+
+     Bagged trees are skipped a slot at a time, if dense, else by
+     walking the row's tree list.
+
+     @return least out-of-bag tree index in [tIdx, tEnd), else tEnd.
+   */
+  inline unsigned int nextOOB(size_t row,
+			      unsigned int tIdx,
+			      unsigned int tEnd) const {
+    if (bagDense != nullptr)
+      return bagDense->nextClear(row, tIdx, tEnd);
+
+    const unsigned int* listEnd = treeBagged.data() + rowOffset[row + 1];
+    const unsigned int* bagged = lower_bound(treeBagged.data() + rowOffset[row], listEnd, tIdx);
+    while (bagged != listEnd && *bagged == tIdx && tIdx < tEnd) {
+      bagged++;
+      tIdx++;
+    }
+    return min(tIdx, tEnd);
+  }
+};
+
+#endif
@@ -0,0 +1,82 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file booster.cc
+
+   @brief Methods driving gradient boosting.
+
+   @author Mark Seligman
+ */
+
+#include "booster.h"
+#include "pretree.h"
+#include "predictorframe.h"
+#include "sampler.h"
+#include "sampledobs.h"
+#include "response.h"
+#include "ompthread.h"
+#include "obs.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+
+/**
+   @return regression response of a sampler, else throws.
+ */
+static const ResponseReg* regResponse(const Sampler* sampler) {
+  const Response* response = sampler->getResponse();
+  if (response->getNCtg() != 0)
+    throw invalid_argument("Boosting requires a numeric response");
+  return static_cast<const ResponseReg*>(response);
+}
+
+
+Booster::Booster(const PredictorFrame* frame_,
+		 const Sampler* sampler_,
+		 double shrinkage_) :
+  frame(frame_),
+  sampler(sampler_),
+  response(regResponse(sampler)),
+  yTrain(regResponse(sampler)->getYTrain()),
+  shrinkage(shrinkage_),
+  base(yTrain.empty() ? 0.0 : accumulate(yTrain.begin(), yTrain.end(), 0.0) / yTrain.size()),
+  yEst(vector<double>(yTrain.size(), base)),
+  residual(vector<double>(yTrain.size())) {
+  if (shrinkage <= 0.0 || shrinkage > 1.0)
+    throw invalid_argument("Shrinkage must lie in (0, 1]");
+  if (!yTrain.empty()) { // Residuals lie within the response's span of zero.
+    auto yRange = minmax_element(yTrain.begin(), yTrain.end());
+    double span = *yRange.second - *yRange.first;
+    Obs::setRange(-span, span);
+  }
+  for (size_t row = 0; row < yTrain.size(); row++) {
+    residual[row] = yTrain[row] - base;
+  }
+}
+
+
+unique_ptr<SampledObs> Booster::rootSample(unsigned int tIdx) const {
+  return SampledObs::factoryReg(sampler, response, residual, tIdx);
+}
+
+
+void Booster::consumeTree(PreTree* pretree) {
+  OMPBound rowEnd = static_cast<OMPBound>(yEst.size());
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(static)
+  for (OMPBound row = 0; row < rowEnd; row++) {
+    yEst[row] += shrinkage * pretree->scoreObs(frame, row);
+    residual[row] = yTrain[row] - yEst[row];
+  }
+  }
+
+  pretree->rescore(base, shrinkage * sampler->getNTree());
+}
@@ -0,0 +1,87 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file booster.h
+
+   @brief Gradient boosting over the random-forest engine.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_BOOSTER_H
+#define FOREST_BOOSTER_H
+
+#include "typeparam.h"
+
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Maintains the ensemble estimate as boosted trees are consumed.
+
+   Loss is squared error, so the negative gradient is the residual and
+   the hessian is unity.  Each tree is grown by the usual frontier
+   against the residuals, which stand in for the response when the
+   root is sampled.  A node's mean residual is then its Newton step,
+   so regression scoring applies unchanged.
+
+   Trees train in sequence, each fitting its predecessors' residuals.
+   All rows, bagged or not, walk the finished tree in rank space, as
+   with TrainOOB, to update the estimate.
+
+   Scores are stored so that the usual averaging over the forest's
+   trees yields the boosted sum:  each tree's scores are scaled by the
+   product of shrinkage and tree count, then offset by the base
+   estimate.  Prediction therefore requires the full forest;  bagged
+   and prefix predictions are not meaningful.
+ */
+class Booster {
+  const class PredictorFrame* frame;
+  const class Sampler* sampler;
+  const struct Response* response;
+  const vector<double>& yTrain;
+  const double shrinkage; // Weight applied to each tree's scores.
+  const double base; // Initial estimate:  mean training response.
+  vector<double> yEst; // Current ensemble estimate, per row.
+  vector<double> residual; // Negative gradient, per row.
+
+public:
+
+  /**
+     @param shrinkage_ is the learning rate, in (0, 1].
+   */
+  Booster(const class PredictorFrame* frame_,
+	  const class Sampler* sampler_,
+	  double shrinkage_);
+
+
+  /**
+     @brief Samples the current residuals to construct a tree's root.
+   */
+  unique_ptr<class SampledObs> rootSample(unsigned int tIdx) const;
+
+
+  /**
+     @brief Updates the estimate with a finalized tree, then rescales
+     the tree's scores for averaging.
+   */
+  void consumeTree(class PreTree* pretree);
+
+
+  /**
+     @return current estimate, per training row.
+   */
+  const vector<double>& getEstimate() const {
+    return yEst;
+  }
+};
+
+#endif
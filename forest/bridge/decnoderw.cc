@@ -16,48 +16,87 @@
 #include "decnoderw.h"
 #include "typeparam.h"
 #include "bv.h"
+#include "ompthread.h"
 
+#include <cstring>
 
 using namespace std;
 
-vector<vector<DecNode>> DecNodeRW::unpackNodes(const complex<double> nodes[],
-						const double nodeExtent[],
-						unsigned int nTree) {
-  vector<vector<DecNode>> treeNodes(nTree);
-  size_t feIdx = 0;
+vector<size_t> DecNodeRW::unpackOrigins(const double nodeExtent[],
+					 unsigned int nTree) {
+  vector<size_t> nodeOrigin(nTree);
+  size_t origin = 0;
   for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    for (size_t nodeIdx = 0; nodeIdx < nodeExtent[tIdx]; nodeIdx++) {
-      treeNodes[tIdx].emplace_back(DecNode(nodes[feIdx]));
-      feIdx++;
-    }
+    nodeOrigin[tIdx] = origin;
+    origin += nodeExtent[tIdx];
   }
-  return treeNodes;
+  return nodeOrigin;
 }
 
 
-vector<vector<double>> DecNodeRW::unpackScores(const double scores[],
-						const double nodeExtent[],
-						unsigned int nTree) {
-  vector<vector<double>> treeScore(nTree);
-  IndexT nodeIdx = 0;
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    for (IndexT scoreIdx = 0; scoreIdx != nodeExtent[tIdx]; scoreIdx++)  {
-      treeScore[tIdx].push_back(scores[nodeIdx++]);
+vector<DecNode> DecNodeRW::unpackNodes(const complex<double> nodes[],
+				       const vector<size_t>& nodeOrigin,
+				       size_t nodeCount) {
+  vector<DecNode> decNode(nodeCount);
+  OMPBound nTree = nodeOrigin.size();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : nodeCount;
+    for (size_t feIdx = nodeOrigin[tIdx]; feIdx < nodeEnd; feIdx++) {
+      decNode[feIdx] = DecNode(nodes[feIdx]);
     }
   }
-  return treeScore;
+  }
+  return decNode;
 }
 
 
-vector<unique_ptr<BV>> DecNodeRW::unpackBits(const unsigned char raw[],
-					      const double extent[],
-					      unsigned int nTree) {
-  vector<unique_ptr<BV>> bits;
-  size_t rawIdx = 0;
+vector<double> DecNodeRW::unpackScores(const double scores[],
+				       const vector<size_t>& nodeOrigin,
+				       size_t nodeCount) {
+  vector<double> score(nodeCount);
+  OMPBound nTree = nodeOrigin.size();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : nodeCount;
+    copy(scores + nodeOrigin[tIdx], scores + nodeEnd, score.begin() + nodeOrigin[tIdx]);
+  }
+  }
+  return score;
+}
+
+
+vector<size_t> DecNodeRW::unpackBitOrigins(const double extent[],
+					    unsigned int nTree) {
+  vector<size_t> bitOrigin(nTree + 1);
+  size_t origin = 0;
   for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    bits.emplace_back(make_unique<BV>(raw + rawIdx, extent[tIdx]));
-    rawIdx += extent[tIdx] * sizeof(BVSlotT);
+    bitOrigin[tIdx] = origin;
+    origin += extent[tIdx];
   }
+  bitOrigin[nTree] = origin;
+  return bitOrigin;
+}
+
 
-  return bits;
+vector<BVSlotT> DecNodeRW::unpackBitPool(const unsigned char raw[],
+					  const vector<size_t>& bitOrigin) {
+  vector<BVSlotT> bitPool(bitOrigin.back());
+  OMPBound nTree = bitOrigin.size() - 1;
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < nTree; tIdx++) {
+    // Raw bytes need not be slot-aligned.
+    size_t nSlot = bitOrigin[tIdx + 1] - bitOrigin[tIdx];
+    if (nSlot != 0) {
+      memcpy(&bitPool[bitOrigin[tIdx]], raw + bitOrigin[tIdx] * sizeof(BVSlotT), nSlot * sizeof(BVSlotT));
+    }
+  }
+  }
+  return bitPool;
 }
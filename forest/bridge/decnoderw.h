@@ -18,31 +18,67 @@
 
 
 #include "decnode.h"
+#include "bv.h"
 
 #include <complex>
 #include <memory>
+#include <vector>
 
 struct DecNodeRW {
 
+  /**
+     @brief Derives per-tree arena offsets from front-end extents.
+
+     @return vector of starting node offsets, by tree.
+   */
+  static vector<size_t> unpackOrigins(const double nodeExtent[],
+				      unsigned int nTree);
+
+  
   /**
      @brief Unpacks nodes from a paired-double representation, such as complex.
+
+     Trees decode in parallel, each into its preallocated span of the arena.
+
+     @param nodeOrigin are the per-tree offsets, as derived above.
+
+     @param nodeCount is the forest-wide node count.
+
+     @return forest-wide node arena.
    */
-  static vector<vector<DecNode>> unpackNodes(const complex<double> nodes[],
-					     const double nodeExtent[],
-					     unsigned int nTree);
+  static vector<DecNode> unpackNodes(const complex<double> nodes[],
+				     const vector<size_t>& nodeOrigin,
+				     size_t nodeCount);
 
   
   /**
      @brief Builds a forest-wide score vector from R-internal format.
+
+     Copies in parallel, as above.
    */
-  static vector<vector<double>> unpackScores(const double scores[],
-					     const double nodeExtent[],
-					     unsigned int nTree);
+  static vector<double> unpackScores(const double scores[],
+				     const vector<size_t>& nodeOrigin,
+				     size_t nodeCount);
 
 
-  static vector<unique_ptr<class BV>> unpackBits(const unsigned char raw[],
-						 const double extent[],
-						 unsigned int nTree);
+  /**
+     @brief Derives per-tree slot offsets from front-end factor extents.
+
+     @return vector of starting slot offsets, by tree, plus sup.
+   */
+  static vector<size_t> unpackBitOrigins(const double extent[],
+					 unsigned int nTree);
+
+
+  /**
+     @brief Copies the front end's raw factor bytes into a slot pool.
+
+     Trees copy in parallel, as above.
+
+     @return forest-wide pool of splitting bits.
+   */
+  static vector<BVSlotT> unpackBitPool(const unsigned char raw[],
+				       const vector<size_t>& bitOrigin);
 };
 
 #endif
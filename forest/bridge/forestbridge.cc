@@ -17,8 +17,10 @@
 #include "forestbridge.h"
 #include "decnoderw.h"
 #include "forestrw.h"
+#include "forestcompile.h"
 #include "typeparam.h"
 #include "bv.h"
+#include "ompthread.h"
 
 using namespace std;
 
@@ -32,10 +34,27 @@ ForestBridge::ForestBridge(unsigned int nTree,
 			   const complex<double> treeNode[],
 			   const double score[],
 			   const double facExtent[],
-                           const unsigned char facSplit[]) {
-  forest = make_unique<Forest>(DecNodeRW::unpackNodes(treeNode, nodeExtent, nTree),
-			       DecNodeRW::unpackScores(score, nodeExtent, nTree),
-			       DecNodeRW::unpackBits(facSplit, facExtent, nTree));
+                           const unsigned char facSplit[],
+			   unsigned int nThread) {
+  // Offsets are computed up front, so that trees decode independently.
+  vector<size_t> nodeOrigin = DecNodeRW::unpackOrigins(nodeExtent, nTree);
+  size_t nodeCount = nTree == 0 ? 0 : nodeOrigin.back() + nodeExtent[nTree - 1];
+  vector<size_t> bitOrigin = DecNodeRW::unpackBitOrigins(facExtent, nTree);
+  OmpThread::init(nThread);
+  vector<DecNode> decNode = DecNodeRW::unpackNodes(treeNode, nodeOrigin, nodeCount);
+  vector<double> scores = DecNodeRW::unpackScores(score, nodeOrigin, nodeCount);
+  vector<BVSlotT> bitPool = DecNodeRW::unpackBitPool(facSplit, bitOrigin);
+  OmpThread::deInit();
+  forest = make_unique<Forest>(move(nodeOrigin),
+			       Arena<DecNode>(move(decNode)),
+			       Arena<double>(move(scores)),
+			       move(bitOrigin),
+			       Arena<BVSlotT>(move(bitPool)));
+}
+
+
+ForestBridge::ForestBridge(unique_ptr<Forest> forest_) :
+  forest(move(forest_)) {
 }
 
 
@@ -48,6 +67,25 @@ unsigned int ForestBridge::getNTree() const {
 }
 
 
+unique_ptr<ForestBridge> ForestBridge::prefix(unsigned int nTree) const {
+  return make_unique<ForestBridge>(forest->prefix(nTree));
+}
+
+
+unique_ptr<ForestBridge> ForestBridge::select(const vector<unsigned int>& treeIdx) const {
+  return make_unique<ForestBridge>(forest->select(treeIdx));
+}
+
+
+unique_ptr<ForestBridge> ForestBridge::merge(const vector<const ForestBridge*>& forestBridges) {
+  vector<const Forest*> forests;
+  for (const ForestBridge* forestBridge : forestBridges) {
+    forests.push_back(forestBridge->getForest());
+  }
+  return make_unique<ForestBridge>(Forest::merge(forests));
+}
+
+
 const vector<size_t>& ForestBridge::getNodeExtents() const {
   return forest->getNodeExtents();
 }
@@ -93,6 +131,35 @@ void ForestBridge::dumpFactorObserved(unsigned char obsOut[]) const {
 }
 
 
+string ForestBridge::emitSource(unsigned int nPredNum) const {
+  return ForestCompile::emit(forest.get(), nPredNum);
+}
+
+
+ForestTable ForestBridge::tabulate(unsigned int nPredNum,
+				   unsigned int nThread) const {
+  ForestTable table;
+  OmpThread::init(nThread);
+  vector<IndexT> delIdx;
+  forest->tabulate(nPredNum, table.predIdx, delIdx, table.split, table.invert);
+  OmpThread::deInit();
+  table.delIdx = vector<unsigned int>(delIdx.begin(), delIdx.end());
+  table.nodeOrigin = forest->getNodeOrigin();
+  const Arena<double>& scores = forest->getTreeScores();
+  table.score = vector<double>(scores.begin(), scores.end());
+
+  for (size_t slotOrigin : forest->getBitOrigin()) {
+    table.bitOrigin.push_back(slotOrigin * sizeof(BVSlotT));
+  }
+  if (!table.bitOrigin.empty()) {
+    const unsigned char* bitRaw = reinterpret_cast<const unsigned char*>(forest->getBitPool());
+    table.facBits = vector<unsigned char>(bitRaw, bitRaw + table.bitOrigin.back());
+  }
+
+  return table;
+}
+
+
 void ForestBridge::dump(vector<vector<unsigned int> >& predTree,
                         vector<vector<double> >& splitTree,
                         vector<vector<double> >& lhDelTree,
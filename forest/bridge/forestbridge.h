@@ -20,9 +20,25 @@
 #include <vector>
 #include <memory>
 #include <complex>
+#include <string>
 
 using namespace std;
 
+/**
+   @brief Node-indexed columnar image of a forest, for export.
+ */
+struct ForestTable {
+  vector<size_t> nodeOrigin; ///> Per-tree offsets into the node columns.
+  vector<unsigned int> predIdx; ///> Core predictor, or leaf index iff terminal.
+  vector<unsigned int> delIdx; ///> Delta to true branch, zero iff terminal.
+  vector<double> split; ///> Numeric cut, or factor bit offset.
+  vector<unsigned char> invert; ///> Nonzero iff missing values branch true.
+  vector<double> score; ///> Score at each node.
+  vector<size_t> bitOrigin; ///> Per-tree byte offsets into 'facBits', plus sup.
+  vector<unsigned char> facBits; ///> Factor-split bits, in native slot order.
+};
+
+
 /**
    @brief Hides class Forest internals from bridge via forward declarations.
  */
@@ -43,13 +59,16 @@ struct ForestBridge {
      @param facExtent the per-tree count of factor-valued splits.
 
      @param facSplit contains the splitting bits for factors.
+
+     @param nThread is the team size for decoding trees in parallel.
    */
   ForestBridge(unsigned int nTree,
 	       const double nodeExtent[],
 	       const complex<double> treeNode[],
 	       const double scores[],
 	       const double facExtent[],
-               const unsigned char facSplit[]);
+               const unsigned char facSplit[],
+	       unsigned int nThread);
 
 
   /**
@@ -57,6 +76,12 @@ struct ForestBridge {
    */
   ForestBridge(unsigned int treeChunk);
 
+
+  /**
+     @brief Wraps an existing core forest.
+   */
+  ForestBridge(unique_ptr<class Forest> forest_);
+
   
   ~ForestBridge();
 
@@ -79,6 +104,32 @@ struct ForestBridge {
   unsigned int getNTree() const;
 
 
+  /**
+     @brief Restricts prediction to the leading trees.
+
+     @param nTree is the number of trees retained.
+
+     @return bridge to a forest of the first 'nTree' trees.
+   */
+  unique_ptr<ForestBridge> prefix(unsigned int nTree) const;
+
+
+  /**
+     @brief Selects a subset of trees, in the order specified.
+
+     The sampler and leaf must be selected correspondingly.
+   */
+  unique_ptr<ForestBridge> select(const vector<unsigned int>& treeIdx) const;
+
+
+  /**
+     @brief Concatenates forests trained over a common frame signature.
+
+     The samplers and leaves must be merged correspondingly.
+   */
+  static unique_ptr<ForestBridge> merge(const vector<const ForestBridge*>& forestBridges);
+
+
   const vector<size_t>& getNodeExtents() const;
 
 
@@ -117,6 +168,29 @@ struct ForestBridge {
   void dumpFactorObserved(unsigned char obsOut[]) const;
   
 
+  /**
+     @brief Emits the forest as compilable C++ source.
+
+     @param nPredNum is the number of numeric predictors.
+
+     @return source text.
+   */
+  string emitSource(unsigned int nPredNum) const;
+
+
+  /**
+     @brief Tabulates the forest as flat node columns, trees in parallel.
+
+     @param nPredNum is the number of numeric predictors.
+
+     @param nThread is the team size for tabulating trees in parallel.
+
+     @return columnar image of the forest.
+   */
+  ForestTable tabulate(unsigned int nPredNum,
+		       unsigned int nThread) const;
+
+
   /**
      @brief Dumps the forest into per-tree vectors.
    */
@@ -19,8 +19,12 @@
 #include "leaf.h"
 #include "samplerbridge.h"
 #include "sampler.h"
+#include "response.h"
+#include "valrank.h"
 
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
 using namespace std;
 
 
@@ -40,76 +44,68 @@ unique_ptr<LeafBridge> LeafBridge::FactoryPredict(const SamplerBridge* samplerBr
 						  bool thin,
 						  const double extent_[],
 						  const double index_[]) {
-  vector<vector<size_t>> extent = unpackExtent(samplerBridge, thin, extent_);
-  vector<vector<vector<size_t>>> index = unpackIndex(samplerBridge, thin, extent, index_);
-  return make_unique<LeafBridge>(samplerBridge, thin, move(extent), move(index));
+  return make_unique<LeafBridge>(samplerBridge, thin, extent_, index_);
 }
 
 
 LeafBridge::LeafBridge(const SamplerBridge* samplerBridge,
 		       bool thin,
-		       vector<vector<size_t>> extent,
-		       vector<vector<vector<size_t>>> index) :
+		       const double extent_[],
+		       const double index_[]) :
   leaf(Leaf::predict(samplerBridge->getSampler(),
 		     thin,
-		     move(extent),
-		     move(index))) {
+		     extent_,
+		     index_)) {
 }
 
 
-LeafBridge::~LeafBridge() {
+unique_ptr<LeafBridge> LeafBridge::FactoryPredict(const SamplerBridge* samplerBridge,
+						  bool thin,
+						  const double extent_[],
+						  const unsigned char pack_[],
+						  size_t packSize) {
+  return make_unique<LeafBridge>(samplerBridge, thin, extent_, pack_, packSize);
 }
 
 
-vector<vector<size_t>> LeafBridge::unpackExtent(const SamplerBridge* samplerBridge,
-						bool thin,
-						const double extentNum[]) {
-  Sampler* sampler = samplerBridge->getSampler();
-  unsigned int nTree = sampler->getNTree();
-  if (thin) {
-    return vector<vector<size_t>>(0);
-  }
+LeafBridge::LeafBridge(const SamplerBridge* samplerBridge,
+		       bool thin,
+		       const double extent_[],
+		       const unsigned char pack_[],
+		       size_t packSize) :
+  leaf(Leaf::predict(samplerBridge->getSampler(),
+		     thin,
+		     extent_,
+		     pack_,
+		     packSize)) {
+}
 
-  vector<vector<size_t>> unpacked(nTree);
-  size_t idx = 0;
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    size_t extentTree = 0;
-    while (extentTree < sampler->getBagCount(tIdx)) {
-      size_t extentLeaf = extentNum[idx++];
-      unpacked[tIdx].push_back(extentLeaf);
-      extentTree += extentLeaf;
-    }
-  }
-  return unpacked;
+
+LeafBridge::LeafBridge(unique_ptr<Leaf> leaf_) :
+  leaf(move(leaf_)) {
 }
 
 
-vector<vector<vector<size_t>>> LeafBridge::unpackIndex(const SamplerBridge* samplerBridge,
-						       bool thin,
-						       const vector<vector<size_t>>& extent,
-						       const double numVal[]) {
-  const Sampler* sampler = samplerBridge->getSampler();
-  unsigned int nTree = sampler->getNTree();
-  if (thin)
-    return vector<vector<vector<size_t>>>(0);
-
-  vector<vector<vector<size_t>>> unpacked(nTree);
-
-  size_t idx = 0;
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    unpacked[tIdx] = vector<vector<size_t>>(extent[tIdx].size());
-    for (size_t leafIdx = 0; leafIdx < unpacked[tIdx].size(); leafIdx++) {
-      vector<size_t> unpackedLeaf(extent[tIdx][leafIdx]);
-      for (size_t slot = 0; slot < unpackedLeaf.size(); slot++) {
-	unpackedLeaf[slot] = numVal[idx];
-	idx++;
-      }
-      unpacked[tIdx][leafIdx] = unpackedLeaf;
-    }
+LeafBridge::~LeafBridge() {
+}
+
+
+unique_ptr<LeafBridge> LeafBridge::select(const SamplerBridge* samplerBridge,
+					  const vector<unsigned int>& treeIdx) const {
+  return make_unique<LeafBridge>(leaf->select(samplerBridge->getSampler(), treeIdx));
+}
+
+
+unique_ptr<LeafBridge> LeafBridge::merge(const SamplerBridge* samplerBridge,
+					 const vector<const LeafBridge*>& leafBridges) {
+  vector<const Leaf*> leaves;
+  for (const LeafBridge* leafBridge : leafBridges) {
+    leaves.push_back(leafBridge->getLeaf());
   }
-  return unpacked;
+  return make_unique<LeafBridge>(Leaf::merge(samplerBridge->getSampler(), leaves));
 }
 
+
 Leaf* LeafBridge::getLeaf() const {
   return leaf.get();
 }
@@ -139,3 +135,24 @@ void LeafBridge::dumpIndex(double indexOut[]) const {
     indexOut[i] = index[i];
   }
 }
+
+
+void LeafBridge::prepareQuantiles(const SamplerBridge* samplerBridge) const {
+  const Sampler* sampler = samplerBridge->getSampler();
+  if (sampler->getResponse()->getNCtg() != 0) {
+    throw invalid_argument("Quantiles require a numeric response");
+  }
+  const vector<double>& yTrain = static_cast<const ResponseReg*>(sampler->getResponse())->getYTrain();
+  leaf->getRankAligned(sampler, RankedObs<double>(yTrain.data(), yTrain.size()).rank());
+}
+
+
+size_t LeafBridge::getPackSize() const {
+  return leaf->getPackCresc().size();
+}
+
+
+void LeafBridge::dumpPack(unsigned char packOut[]) const {
+  const vector<unsigned char>& pack = leaf->getPackCresc();
+  copy(pack.begin(), pack.end(), packOut);
+}
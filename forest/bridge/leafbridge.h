@@ -35,34 +35,82 @@ struct LeafBridge {
 					       const double index_[]);
 
 
+  /**
+     @brief Prediction factory:  sample indices in packed form.
+
+     @param pack_ is the encoding produced by 'dumpPack'.
+
+     @param packSize is the encoding's length, in bytes.
+   */
+  static unique_ptr<LeafBridge> FactoryPredict(const struct SamplerBridge* samplerBridge,
+					       bool thin,
+					       const double extent_[],
+					       const unsigned char pack_[],
+					       size_t packSize);
+
+
   LeafBridge(const struct SamplerBridge* sb,
 	     bool thin);
   
 
+  /**
+     @brief Prediction constructor:  front-end buffers are decoded lazily.
+
+     The extent and index buffers must outlive the bridge.
+   */
   LeafBridge(const struct SamplerBridge* samplerBridge,
 	     bool thin,
-	     vector<vector<size_t>> extent,
-	     vector<vector<vector<size_t>>> index);
+	     const double extent_[],
+	     const double index_[]);
+
+
+  LeafBridge(const struct SamplerBridge* samplerBridge,
+	     bool thin,
+	     const double extent_[],
+	     const unsigned char pack_[],
+	     size_t packSize);
+
+
+  /**
+     @brief Wraps an existing core leaf.
+   */
+  LeafBridge(unique_ptr<struct Leaf> leaf_);
 
 
   ~LeafBridge();
 
 
+  /**
+     @brief Selects a subset of trees, in the order specified.
+
+     @param samplerBridge is the correspondingly selected sampler.
+   */
+  unique_ptr<LeafBridge> select(const struct SamplerBridge* samplerBridge,
+				const vector<unsigned int>& treeIdx) const;
+
+
+  /**
+     @brief Concatenates leaves trained independently.
+
+     @param samplerBridge is the correspondingly merged sampler.
+   */
+  static unique_ptr<LeafBridge> merge(const struct SamplerBridge* samplerBridge,
+				      const vector<const LeafBridge*>& leafBridges);
+
+
   struct Leaf* getLeaf() const;
-  
 
-  
-  static vector<vector<size_t>> unpackExtent(const struct SamplerBridge* samplerBridge,
-					     bool thin,
-					     const double numVal[]);
 
-  
-  static vector<vector<vector<size_t>>> unpackIndex(const struct SamplerBridge* samplerBridge,
-						    bool thin,
-						    const vector<vector<size_t>>& extent,
-						    const double numVal[]);
+  /**
+     @brief Aligns the leaf samples with the ranked training response,
+     once, as quantile prediction requires.
 
+     Retained by the leaf, hence by any model file saved from it.
+   */
+  void prepareQuantiles(const struct SamplerBridge* samplerBridge) const;
+  
 
+  
   /**
      @brief Copies leaf extents as doubles.
    */
@@ -79,6 +127,18 @@ struct LeafBridge {
 
 
   size_t getIndexSize() const;
+
+
+  /**
+     @brief Copies the packed encoding of the sample indices.
+   */
+  void dumpPack(unsigned char packOut[]) const;
+
+
+  /**
+     @return length of the packed encoding, in bytes.
+   */
+  size_t getPackSize() const;
   
 
 private:
@@ -0,0 +1,245 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelbridge.cc
+
+   @brief Saves and maps binary model files.
+
+   @author Mark Seligman
+ */
+
+#include "modelbridge.h"
+#include "modelfile.h"
+#include "modelstream.h"
+#include "forestbridge.h"
+#include "samplerbridge.h"
+#include "leafbridge.h"
+#include "samplerrw.h"
+#include "forest.h"
+#include "sampler.h"
+#include "samplernux.h"
+#include "leaf.h"
+#include "leafpack.h"
+#include "response.h"
+
+using namespace std;
+
+
+namespace {
+  /**
+     @brief Model-wide scalars and flattened sampler records.
+   */
+  struct SamplerBlocks {
+    vector<uint64_t> scalar;
+    vector<IndexT> bagCount;
+    vector<PackedT> nux;
+
+    /**
+       @param nTree is the number of leading trees recorded.
+     */
+    SamplerBlocks(const Sampler* sampler,
+		  unsigned int nTree,
+		  bool thin) :
+      scalar(static_cast<size_t>(ModelFile::Scalar::nScalar)),
+      bagCount(nTree) {
+      scalar[static_cast<size_t>(ModelFile::Scalar::nTree)] = nTree;
+      scalar[static_cast<size_t>(ModelFile::Scalar::nObs)] = sampler->getNObs();
+      scalar[static_cast<size_t>(ModelFile::Scalar::nSamp)] = sampler->getNSamp();
+      scalar[static_cast<size_t>(ModelFile::Scalar::nCtg)] = sampler->getResponse()->getNCtg();
+      scalar[static_cast<size_t>(ModelFile::Scalar::bagging)] = sampler->isBagging();
+      scalar[static_cast<size_t>(ModelFile::Scalar::thin)] = thin;
+
+      // Sampler records are flattened, as the core holds them per tree.
+      for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+	bagCount[tIdx] = sampler->getBagCount(tIdx);
+	for (const SamplerNux& sampleNux : sampler->getSamples(tIdx)) {
+	  nux.push_back(sampleNux.getPacked());
+	}
+      }
+    }
+
+
+    void add(ModelWriter& writer,
+	     const Sampler* sampler) const {
+      writer.add(ModelFile::Tag::scalar, scalar);
+      writer.add(ModelFile::Tag::bagCount, bagCount);
+      writer.add(ModelFile::Tag::samplerNux, nux);
+      if (sampler->getResponse()->getNCtg() == 0) {
+	writer.add(ModelFile::Tag::yReg, static_cast<const ResponseReg*>(sampler->getResponse())->getYTrain());
+      }
+      else {
+	writer.add(ModelFile::Tag::yCtg, static_cast<const ResponseCtg*>(sampler->getResponse())->getYCtg());
+      }
+    }
+  };
+}
+
+
+void ModelBridge::save(const string& path,
+		       const ForestBridge* forestBridge,
+		       const SamplerBridge* samplerBridge,
+		       const LeafBridge* leafBridge) {
+  const Forest* forest = forestBridge->getForest();
+  const Sampler* sampler = samplerBridge->getSampler();
+  const Leaf* leaf = leafBridge == nullptr ? nullptr : leafBridge->getLeaf();
+  bool thin = leaf == nullptr || leaf->isThin();
+  SamplerBlocks samplerBlocks(sampler, sampler->getNTree(), thin);
+
+  vector<unsigned char> leafPack;
+  if (!thin) {
+    const vector<size_t>& leafOrigin = leaf->getLeafOrigin();
+    vector<IndexT> extent(leafOrigin.empty() ? 0 : leafOrigin.size() - 1);
+    for (size_t leafPos = 0; leafPos < extent.size(); leafPos++) {
+      extent[leafPos] = leafOrigin[leafPos + 1] - leafOrigin[leafPos];
+    }
+    LeafPack::pack(extent.data(), extent.size(), leaf->getIndex().data(), leafPack);
+  }
+
+  ModelWriter writer;
+  samplerBlocks.add(writer, sampler);
+  writer.add(ModelFile::Tag::nodeOrigin, forest->getNodeOrigin());
+  writer.add(ModelFile::Tag::decNode, forest->getNode().data(), forest->getNode().size());
+  writer.add(ModelFile::Tag::score, forest->getTreeScores().data(), forest->getTreeScores().size());
+  writer.add(ModelFile::Tag::bitOrigin, forest->getBitOrigin());
+  writer.add(ModelFile::Tag::bitPool, forest->getBitPool(), forest->getBitOrigin().empty() ? 0 : forest->getBitOrigin().back());
+  if (!thin) {
+    writer.add(ModelFile::Tag::treeOrigin, leaf->getTreeOrigin());
+    writer.add(ModelFile::Tag::leafOrigin, leaf->getLeafOrigin());
+    writer.add(ModelFile::Tag::leafPack, leafPack);
+    if (leaf->isRankAligned()) {
+      vector<PackedT> rankPacked;
+      rankPacked.reserve(leaf->getRankStored().size());
+      for (const RankCount& rc : leaf->getRankStored()) {
+	rankPacked.push_back(rc.getPacked());
+      }
+      writer.add(ModelFile::Tag::rankCount, rankPacked);
+    }
+  }
+  writer.write(path);
+}
+
+
+ModelBridge::ModelBridge(const string& path) :
+  modelMap(make_unique<ModelMap>(path)) {
+  size_t nObs = modelMap->getScalar(ModelFile::Scalar::nObs);
+  size_t nSamp = modelMap->getScalar(ModelFile::Scalar::nSamp);
+  unsigned int nTree = modelMap->getScalar(ModelFile::Scalar::nTree);
+  PredictorT nCtg = modelMap->getScalar(ModelFile::Scalar::nCtg);
+  bool bagging = modelMap->getScalar(ModelFile::Scalar::bagging) != 0;
+  bool thin = modelMap->getScalar(ModelFile::Scalar::thin) != 0;
+
+  SamplerNux::setMasks(nObs);
+  Arena<IndexT> bagCount = modelMap->alias<IndexT>(ModelFile::Tag::bagCount);
+  Arena<PackedT> nux = modelMap->alias<PackedT>(ModelFile::Tag::samplerNux);
+  if (bagCount.size() != nTree) {
+    throw invalid_argument("Model file sampler inconsistent with forest");
+  }
+  vector<vector<SamplerNux>> samples = SamplerRW::unpack(nux.data(), bagCount.data(), nTree, nCtg);
+  if (nCtg == 0) {
+    samplerBridge = make_unique<SamplerBridge>(modelMap->copy<double>(ModelFile::Tag::yReg), nSamp, move(samples), bagging);
+  }
+  else {
+    samplerBridge = make_unique<SamplerBridge>(modelMap->copy<unsigned int>(ModelFile::Tag::yCtg), nSamp, move(samples), nCtg, bagging);
+  }
+
+  // Forest arenas alias the mapping in place; origins are small.
+  forestBridge = make_unique<ForestBridge>(make_unique<Forest>(modelMap->copy<size_t>(ModelFile::Tag::nodeOrigin),
+							       modelMap->alias<DecNode>(ModelFile::Tag::decNode),
+							       modelMap->alias<double>(ModelFile::Tag::score),
+							       modelMap->copy<size_t>(ModelFile::Tag::bitOrigin),
+							       modelMap->alias<BVSlotT>(ModelFile::Tag::bitPool)));
+
+  Sampler* sampler = samplerBridge->getSampler();
+  if (thin) {
+    leafBridge = make_unique<LeafBridge>(Leaf::predict(sampler, true, vector<size_t>(), vector<size_t>(), vector<IndexT>()));
+  }
+  else {
+    vector<size_t> treeOrigin = modelMap->copy<size_t>(ModelFile::Tag::treeOrigin);
+    vector<size_t> leafOrigin = modelMap->copy<size_t>(ModelFile::Tag::leafOrigin);
+    vector<IndexT> index;
+    if (modelMap->hasBlock(ModelFile::Tag::leafPack)) {
+      Arena<unsigned char> leafPack = modelMap->alias<unsigned char>(ModelFile::Tag::leafPack);
+      index = LeafPack::unpack(leafPack.data(), leafPack.size(), treeOrigin, leafOrigin);
+    }
+    else {
+      index = modelMap->copy<IndexT>(ModelFile::Tag::leafIndex);
+    }
+    leafBridge = make_unique<LeafBridge>(Leaf::predict(sampler,
+						       false,
+						       move(treeOrigin),
+						       move(leafOrigin),
+						       move(index)));
+    if (modelMap->hasBlock(ModelFile::Tag::rankCount)) {
+      Arena<PackedT> rankPacked = modelMap->alias<PackedT>(ModelFile::Tag::rankCount);
+      vector<RankCount> rankAligned(rankPacked.size());
+      for (size_t idx = 0; idx < rankAligned.size(); idx++) {
+	rankAligned[idx].initPacked(rankPacked[idx]);
+      }
+      leafBridge->getLeaf()->setRankAligned(move(rankAligned));
+    }
+  }
+}
+
+
+ModelBridge::~ModelBridge() {
+}
+
+
+void ModelBridge::prewarm(bool quantiles) const {
+  modelMap->prefault();
+  forestBridge->getForest()->getIndex();
+  if (quantiles && modelMap->getScalar(ModelFile::Scalar::thin) == 0
+      && modelMap->getScalar(ModelFile::Scalar::nCtg) == 0) {
+    leafBridge->prepareQuantiles(samplerBridge.get());
+  }
+}
+
+
+ForestBridge* ModelBridge::getForest() const {
+  return forestBridge.get();
+}
+
+
+SamplerBridge* ModelBridge::getSampler() const {
+  return samplerBridge.get();
+}
+
+
+LeafBridge* ModelBridge::getLeaf() const {
+  return leafBridge.get();
+}
+
+
+ModelStreamBridge::ModelStreamBridge(const string& path_,
+				     bool thin) :
+  path(path_),
+  modelStream(make_unique<ModelStream>(thin)) {
+}
+
+
+ModelStreamBridge::~ModelStreamBridge() {
+}
+
+
+void ModelStreamBridge::consume(const ForestBridge& forestBridge,
+				const LeafBridge* leafBridge,
+				const SamplerBridge* samplerBridge,
+				unsigned int treeOff) {
+  modelStream->consume(forestBridge.getForest(), leafBridge->getLeaf(), samplerBridge->getSampler(), treeOff);
+}
+
+
+void ModelStreamBridge::write(const SamplerBridge* samplerBridge) {
+  const Sampler* sampler = samplerBridge->getSampler();
+  SamplerBlocks samplerBlocks(sampler, modelStream->getNTree(), modelStream->isThin());
+
+  ModelWriter writer;
+  samplerBlocks.add(writer, sampler);
+  modelStream->addBlocks(writer);
+  writer.write(path);
+}
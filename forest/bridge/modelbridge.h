@@ -0,0 +1,130 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelbridge.h
+
+   @brief Front-end access to binary model files.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_BRIDGE_MODELBRIDGE_H
+#define FOREST_BRIDGE_MODELBRIDGE_H
+
+#include <memory>
+#include <string>
+
+using namespace std;
+
+/**
+   @brief Persists and restores forest, sampler and leaf as a single file.
+
+   Loading maps the file and builds the forest's node, score and
+   factor-bit arenas in place, so that cold starts incur neither copying
+   nor decoding of the bulk of the model.  Sampler and leaf contents are
+   bulk-copied out of the mapping, as their core representations are
+   nested.  The mapping persists until the bridge is destroyed.
+ */
+struct ModelBridge {
+
+  /**
+     @brief Writes a post-training model.
+
+     @param leafBridge is optional:  null records a thin leaf.
+   */
+  static void save(const string& path,
+		   const struct ForestBridge* forestBridge,
+		   const struct SamplerBridge* samplerBridge,
+		   const struct LeafBridge* leafBridge);
+
+
+  /**
+     @brief Loading constructor.
+
+     @param path names a file produced by 'save'.
+   */
+  ModelBridge(const string& path);
+
+
+  ~ModelBridge();
+
+
+  /**
+     @brief Builds derived state ahead of serving, so that the first
+     requests pay no initialization.
+
+     Faults in the mapping and builds the forest index.
+
+     @param quantiles is true iff leaf samples are also rank-aligned
+     for quantile prediction.  Ignored for thin leaves and for
+     classification.
+   */
+  void prewarm(bool quantiles) const;
+
+
+  struct ForestBridge* getForest() const;
+
+
+  struct SamplerBridge* getSampler() const;
+
+
+  struct LeafBridge* getLeaf() const;
+
+private:
+
+  unique_ptr<class ModelMap> modelMap; // Declared first:  outlives the arenas.
+  unique_ptr<struct SamplerBridge> samplerBridge;
+  unique_ptr<struct ForestBridge> forestBridge;
+  unique_ptr<struct LeafBridge> leafBridge;
+};
+
+
+/**
+   @brief Writes a model file from chunks as they are trained.
+
+   Chunks are staged on disk as they arrive, so that the forest is
+   never held whole in memory.  The file itself is written once the
+   last chunk has been consumed.
+ */
+struct ModelStreamBridge {
+
+  /**
+     @param path is the file to be written.
+
+     @param thin is true iff leaf maps are omitted.
+   */
+  ModelStreamBridge(const string& path_,
+		    bool thin);
+
+
+  ~ModelStreamBridge();
+
+
+  /**
+     @brief Stages a trained chunk.
+
+     @param treeOff is the absolute index of the chunk's leading tree.
+   */
+  void consume(const struct ForestBridge& forestBridge,
+	       const struct LeafBridge* leafBridge,
+	       const struct SamplerBridge* samplerBridge,
+	       unsigned int treeOff);
+
+
+  /**
+     @brief Writes the staged trees, with their sampler records.
+   */
+  void write(const struct SamplerBridge* samplerBridge);
+
+private:
+
+  const string path;
+  unique_ptr<class ModelStream> modelStream;
+};
+
+#endif
@@ -0,0 +1,186 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelregistry.cc
+
+   @brief Loads, publishes and retires served models.
+
+   @author Mark Seligman
+ */
+
+#include "modelregistry.h"
+#include "modelbridge.h"
+#include "forestbridge.h"
+#include "samplerbridge.h"
+#include "predictor.h"
+#include "forest.h"
+#include "sampler.h"
+#include "samplernux.h"
+#include "leaf.h"
+#include "response.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+ServedModel::ServedModel(unsigned int version_,
+			 const string& path,
+			 unsigned int nPredNum,
+			 unsigned int nPredFac) :
+  version(version_),
+  modelBridge(make_unique<ModelBridge>(path)) {
+  const Sampler* sampler = modelBridge->getSampler()->getSampler();
+  if (sampler->getResponse()->getNCtg() == 0) {
+    predictorReg = make_unique<PredictorReg>(modelBridge->getForest()->getForest(), nPredNum, nPredFac);
+  }
+  else {
+    predictorCtg = make_unique<PredictorCtg>(modelBridge->getForest()->getForest(), sampler, nPredNum, nPredFac);
+  }
+}
+
+
+ServedModel::~ServedModel() {
+}
+
+
+void ServedModel::restoreMasks() const {
+  IndexT nObs = modelBridge->getSampler()->getSampler()->getNObs();
+  SamplerNux::setMasks(nObs);
+  RankCount::setMasks(nObs);
+}
+
+
+ModelRegistry::ModelRegistry(unsigned int nPredNum_,
+			     unsigned int nPredFac_,
+			     bool quantiles_) :
+  nPredNum(nPredNum_),
+  nPredFac(nPredFac_),
+  quantiles(quantiles_),
+  currentVersion(0),
+  nLoaded(0) {
+  Forest::init(nPredNum + nPredFac);
+}
+
+
+ModelRegistry::~ModelRegistry() {
+  lock_guard<mutex> guard(pendingLock);
+  if (pending.valid())
+    pending.wait();
+  Forest::deInit();
+}
+
+
+void ModelRegistry::install(const string& path) {
+  lock_guard<mutex> loading(reloadLock);
+  sweep(); // Bounds residence ahead of the new mapping.
+  shared_ptr<const ServedModel> model = make_shared<const ServedModel>(nLoaded + 1, path, nPredNum, nPredFac);
+  model->modelBridge->prewarm(quantiles);
+  nLoaded++;
+
+  {
+    lock_guard<mutex> exchange(currentLock);
+    current.swap(model);
+    currentVersion = current->version;
+  }
+  if (model != nullptr) {
+    lock_guard<mutex> guard(retireLock);
+    retired.push_back(move(model));
+  }
+  sweep();
+}
+
+
+void ModelRegistry::sweep() const {
+  lock_guard<mutex> guard(retireLock);
+  size_t nRetired = retired.size();
+  // Superseded models cannot be leased anew, so a sole owner is final.
+  retired.erase(remove_if(retired.begin(), retired.end(), [](const shared_ptr<const ServedModel>& model) {
+	return model.use_count() == 1;
+      }), retired.end());
+  if (retired.size() != nRetired) {
+    shared_ptr<const ServedModel> model = acquire();
+    if (model != nullptr)
+      model->restoreMasks();
+  }
+}
+
+
+void ModelRegistry::release(shared_ptr<const ServedModel>& model) const {
+  bool superseded = model->version != currentVersion;
+  model = nullptr;
+  if (superseded)
+    sweep();
+}
+
+
+void ModelRegistry::load(const string& path) {
+  install(path);
+}
+
+
+void ModelRegistry::reload(const string& path) {
+  lock_guard<mutex> guard(pendingLock);
+  if (pending.valid())
+    pending.get();
+  pending = async(launch::async, &ModelRegistry::install, this, path);
+}
+
+
+unsigned int ModelRegistry::awaitReload() {
+  {
+    lock_guard<mutex> guard(pendingLock);
+    if (pending.valid())
+      pending.get();
+  }
+  sweep();
+  return currentVersion;
+}
+
+
+shared_ptr<const ServedModel> ModelRegistry::acquire() const {
+  lock_guard<mutex> exchange(currentLock);
+  return current;
+}
+
+
+unsigned int ModelRegistry::predict(const double num[],
+				    const unsigned int fac[],
+				    size_t nRow,
+				    double yPred[],
+				    unsigned int nThread) const {
+  shared_ptr<const ServedModel> model = acquire();
+  if (model == nullptr)
+    throw logic_error("No model loaded");
+  if (model->predictorReg == nullptr)
+    throw logic_error("Regression request submitted to classification model");
+
+  PredictContext context(model->predictorReg.get(), nThread);
+  model->predictorReg->predictRows(context, num, fac, nRow, yPred);
+  unsigned int version = model->version;
+  release(model);
+  return version;
+}
+
+
+unsigned int ModelRegistry::predict(const double num[],
+				    const unsigned int fac[],
+				    size_t nRow,
+				    unsigned int yPred[],
+				    unsigned int nThread) const {
+  shared_ptr<const ServedModel> model = acquire();
+  if (model == nullptr)
+    throw logic_error("No model loaded");
+  if (model->predictorCtg == nullptr)
+    throw logic_error("Classification request submitted to regression model");
+
+  PredictContext context(model->predictorCtg.get(), nThread);
+  model->predictorCtg->predictRows(context, num, fac, nRow, yPred);
+  unsigned int version = model->version;
+  release(model);
+  return version;
+}
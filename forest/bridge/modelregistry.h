@@ -0,0 +1,204 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelregistry.h
+
+   @brief Reloadable prediction sessions over binary model files.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_BRIDGE_MODELREGISTRY_H
+#define FOREST_BRIDGE_MODELREGISTRY_H
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief A mapped model together with its prediction session.
+
+   Immutable once published, so that any number of callers may score
+   against it concurrently.
+ */
+struct ServedModel {
+  const unsigned int version; // Registry-assigned, increasing.
+  const unique_ptr<struct ModelBridge> modelBridge; // Owns the mapping.
+  unique_ptr<class PredictorReg> predictorReg; // Non-null iff regression.
+  unique_ptr<class PredictorCtg> predictorCtg; // Non-null iff classification.
+
+  /**
+     @brief Maps a model file and builds its session.
+   */
+  ServedModel(unsigned int version_,
+	      const string& path,
+	      unsigned int nPredNum,
+	      unsigned int nPredFac);
+
+
+  ~ServedModel();
+
+
+  /**
+     @brief Reinstates the process-wide unpacking masks for this model's
+     samples, as cleared by the release of another model.
+   */
+  void restoreMasks() const;
+};
+
+
+/**
+   @brief Serves dense-row prediction from a model file, reloadable
+   without interrupting service.
+
+   A reload maps the new file, builds its session and pre-warms its
+   derived state on a background thread, while the current model
+   continues to serve.  The new model is then published by exchanging a
+   shared pointer, under a lock held only for the exchange.  Requests
+   lease the model current on their arrival.  A superseded model is
+   retired, then released by the registry itself once its last lease
+   has drained, so that the sample masks it clears on release can be
+   reinstated for the current model.  Retired models are swept before
+   each load and as requests against them complete.  Reloads are
+   serialized, so that at most one model is under construction.
+
+   Rows are numeric-first and row-major, with zero-based factor codes,
+   as for PredictQueueBridge.  Every model served must share the
+   predictor layout passed to the constructor.
+ */
+class ModelRegistry {
+  const unsigned int nPredNum;
+  const unsigned int nPredFac;
+  const bool quantiles; // Whether reloads pre-align quantile ranks.
+
+  mutable mutex currentLock; // Guards 'current' for the exchange only.
+  shared_ptr<const ServedModel> current; // Null until first load.
+  atomic<unsigned int> currentVersion; // Version of 'current', else zero.
+  unsigned int nLoaded; // # models loaded, guarded by 'reloadLock'.
+
+  mutable mutex retireLock; // Guards 'retired'.
+  mutable vector<shared_ptr<const ServedModel>> retired; // Superseded, possibly leased.
+
+  mutex reloadLock; // Serializes loading.
+  mutex pendingLock; // Guards 'pending'.
+  future<void> pending; // Reload in progress, if valid.
+
+
+  /**
+     @brief Builds, pre-warms and publishes a model.
+   */
+  void install(const string& path);
+
+
+  /**
+     @brief Releases retired models no longer leased.
+   */
+  void sweep() const;
+
+
+  /**
+     @brief Returns a lease, sweeping if it has been superseded.
+
+     @param model is the caller's lease, released here.
+   */
+  void release(shared_ptr<const ServedModel>& model) const;
+
+public:
+
+  /**
+     @param nPredNum_ is the number of numeric predictors per row.
+
+     @param nPredFac_ is the number of factor predictors per row.
+
+     @param quantiles_ is true iff quantile ranks are aligned before
+     publication.
+   */
+  ModelRegistry(unsigned int nPredNum_,
+		unsigned int nPredFac_,
+		bool quantiles_ = false);
+
+
+  /**
+     @brief Waits for any reload in progress before release.
+
+     Resets the node-unpacking parameters, as does PredictBridge.
+   */
+  ~ModelRegistry();
+
+
+  /**
+     @brief Loads and publishes a model on the calling thread.
+   */
+  void load(const string& path);
+
+
+  /**
+     @brief Loads and publishes a model in the background, returning
+     immediately.
+
+     Waits for any preceding reload, whose failure, if any, is rethrown
+     here.
+   */
+  void reload(const string& path);
+
+
+  /**
+     @brief Waits for any reload in progress, rethrowing its failure.
+
+     @return version of the model then current.
+   */
+  unsigned int awaitReload();
+
+
+  /**
+     @brief Leases the current model, which remains mapped for the
+     lifetime of the lease.
+
+     A superseded model leased directly is released by the first load
+     or wait following the lease's release.
+
+     @return current model, or null if none yet published.
+   */
+  shared_ptr<const ServedModel> acquire() const;
+
+
+  /**
+     @brief Scores a regression batch against the current model.
+
+     @param[out] yPred receives the mean score, per row.
+
+     @param nThread is the team size; one scores on the calling thread.
+
+     @return version of the model scoring the batch.
+   */
+  unsigned int predict(const double num[],
+		       const unsigned int fac[],
+		       size_t nRow,
+		       double yPred[],
+		       unsigned int nThread = 1) const;
+
+
+  /**
+     @brief As above, but classification.
+
+     @param[out] yPred receives the zero-based category, per row.
+   */
+  unsigned int predict(const double num[],
+		       const unsigned int fac[],
+		       size_t nRow,
+		       unsigned int yPred[],
+		       unsigned int nThread = 1) const;
+};
+
+#endif
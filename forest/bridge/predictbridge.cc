@@ -23,22 +23,37 @@
 #include "forestbridge.h"
 #include "forest.h"
 #include "rleframe.h"
+#include "denseframe.h"
 #include "ompthread.h"
+#include "predictor.h"
+#include "predictqueue.h"
 
+#include <stdexcept>
 
-PredictRegBridge::PredictRegBridge(unique_ptr<RLEFrame> rleFrame_,
+
+PredictRegBridge::PredictRegBridge(shared_ptr<RLEFrame> rleFrame_,
+				   unique_ptr<DenseFrame> denseFrame_,
 				   unique_ptr<ForestBridge> forestBridge_,
 				   unique_ptr<SamplerBridge> samplerBridge_,
 				   unique_ptr<LeafBridge> leafBridge_,
 				   vector<double> yTest,
 				   unsigned int nPermute_,
 				   bool trapUnobserved,
+				   bool quickScore,
+				   bool binCode,
+				   bool compact,
+				   bool reuseRuns,
+				   CompiledWalk compiledWalk,
+				   unsigned int nReplica,
 				   unsigned int nThread,
-				   vector<double> quantile) :
-  PredictBridge(move(rleFrame_), move(forestBridge_), nPermute_, nThread),
+				   vector<double> quantile,
+				   unsigned int quantSketch,
+				   bool quantExact,
+				   vector<unsigned int> treeSweep) :
+  PredictBridge(move(rleFrame_), move(denseFrame_), move(forestBridge_), nPermute_, nThread),
   samplerBridge(move(samplerBridge_)),
   leafBridge(move(leafBridge_)),
-  predictRegCore(make_unique<PredictReg>(forestBridge->getForest(), samplerBridge->getSampler(), leafBridge->getLeaf(), rleFrame.get(), move(yTest), nPermute, move(quantile), trapUnobserved)) {
+  predictRegCore(make_unique<PredictReg>(forestBridge->getForest(), samplerBridge->getSampler(), leafBridge->getLeaf(), getNRow(), getNPredNum(), getNPredFac(), move(yTest), nPermute, move(quantile), quantSketch, quantExact, trapUnobserved, quickScore, binCode, compact, reuseRuns, compiledWalk, nReplica, treeSweep)) {
 }
 
 
@@ -46,18 +61,32 @@ PredictRegBridge::~PredictRegBridge() {
 }
 
 
-PredictCtgBridge::PredictCtgBridge(unique_ptr<RLEFrame> rleFrame_,
+PredictCtgBridge::PredictCtgBridge(shared_ptr<RLEFrame> rleFrame_,
+				   unique_ptr<DenseFrame> denseFrame_,
 				   unique_ptr<ForestBridge> forestBridge_,
 				   unique_ptr<SamplerBridge> samplerBridge_,
 				   unique_ptr<LeafBridge> leafBridge_,
 				   vector<unsigned int> yTest,
 				   unsigned int nPermute_,
 				   bool doProb,
+				   bool probSample,
+				   bool doCensus,
+				   unsigned int topK,
 				   bool trapUnobserved,
-				   unsigned int nThread) :
-  PredictBridge(move(rleFrame_), move(forestBridge_), nPermute_, nThread),
+				   bool quickScore,
+				   bool binCode,
+				   bool compact,
+				   bool reuseRuns,
+				   CompiledWalk compiledWalk,
+				   unsigned int nReplica,
+				   bool earlyExit,
+				   double exitTolerance,
+				   unsigned int nThread,
+				   vector<unsigned int> treeSweep) :
+  PredictBridge(move(rleFrame_), move(denseFrame_), move(forestBridge_), nPermute_, nThread),
   samplerBridge(move(samplerBridge_)),
-  predictCtgCore(make_unique<PredictCtg>(forestBridge->getForest(), samplerBridge->getSampler(), rleFrame.get(), move(yTest), nPermute, doProb, trapUnobserved)) {
+  leafBridge(move(leafBridge_)),
+  predictCtgCore(make_unique<PredictCtg>(forestBridge->getForest(), samplerBridge->getSampler(), leafBridge->getLeaf(), getNRow(), getNPredNum(), getNPredFac(), move(yTest), nPermute, doProb, probSample, doCensus, topK, trapUnobserved, quickScore, binCode, compact, reuseRuns, compiledWalk, nReplica, earlyExit, exitTolerance, treeSweep)) {
 }
 
 
@@ -65,14 +94,16 @@ PredictCtgBridge::~PredictCtgBridge() {
 }
 
 
-PredictBridge::PredictBridge(unique_ptr<RLEFrame> rleFrame_,
+PredictBridge::PredictBridge(shared_ptr<RLEFrame> rleFrame_,
+			     unique_ptr<DenseFrame> denseFrame_,
                              unique_ptr<ForestBridge> forestBridge_,
 			     unsigned int nPermute_,
 			     unsigned int nThread) :
   rleFrame(move(rleFrame_)),
+  denseFrame(move(denseFrame_)),
   forestBridge(move(forestBridge_)),
-  nPermute(nPermute_) {
-  Forest::init(rleFrame->getNPred());
+  nPermute(rleFrame ? nPermute_ : 0) {
+  Forest::init(getNPredNum() + getNPredFac());
   OmpThread::init(nThread);
 }
 
@@ -84,7 +115,17 @@ PredictBridge::~PredictBridge() {
 
 
 size_t PredictBridge::getNRow() const {
-  return rleFrame->getNRow();
+  return rleFrame ? rleFrame->getNRow() : denseFrame->getNRow();
+}
+
+
+unsigned int PredictBridge::getNPredNum() const {
+  return rleFrame ? rleFrame->getNPredNum() : denseFrame->getNPredNum();
+}
+
+
+unsigned int PredictBridge::getNPredFac() const {
+  return rleFrame ? rleFrame->getNPredFac() : denseFrame->getNPredFac();
 }
 
 
@@ -94,12 +135,191 @@ bool PredictBridge::permutes() const {
 
 
 void PredictRegBridge::predict() const {
-  predictRegCore->predict(rleFrame.get());
+  if (rleFrame)
+    predictRegCore->predict(rleFrame.get());
+  else
+    predictRegCore->predict(denseFrame.get());
 }
 
 
 void PredictCtgBridge::predict() const {
-  predictCtgCore->predict(rleFrame.get());
+  if (rleFrame)
+    predictCtgCore->predict(rleFrame.get());
+  else
+    predictCtgCore->predict(denseFrame.get());
+}
+
+
+void PredictBridge::predictBatch(const vector<PredictBridge*>& models) {
+  bool shared = !models.empty() && models.front()->rleFrame;
+  for (auto model : models) {
+    shared = shared && model->rleFrame == models.front()->rleFrame && !model->permutes();
+  }
+
+  if (shared) {
+    vector<Predict*> cores;
+    for (auto model : models) {
+      cores.push_back(model->getCore());
+    }
+    Predict::predictBatch(cores, models.front()->rleFrame.get());
+  }
+  else {
+    for (auto model : models) {
+      model->predict();
+    }
+  }
+}
+
+
+void PredictBridge::setLeafSink(LeafSink* leafSink) const {
+  getCore()->setLeafSink(leafSink);
+}
+
+
+const vector<size_t>& PredictBridge::getLeafOrigin() const {
+  return getCore()->getLeafOrigin();
+}
+
+
+void PredictBridge::enableStat() const {
+  getCore()->enableStat();
+}
+
+
+void PredictBridge::enableShare() const {
+  getCore()->enableShare(forestBridge->getForest());
+}
+
+
+void PredictBridge::enableAuto(bool calibrate) const {
+  getCore()->enableAuto(forestBridge->getForest(), calibrate);
+}
+
+
+const PredictStat* PredictBridge::getStat() const {
+  return getCore()->getStat();
+}
+
+
+void PredictRegBridge::enableShap() const {
+  predictRegCore->enableShap(forestBridge->getForest(), leafBridge->getLeaf(), 0);
+}
+
+
+void PredictCtgBridge::enableShap() const {
+  predictCtgCore->enableShap(forestBridge->getForest(), leafBridge->getLeaf(), predictCtgCore->getNCtgTrain());
+}
+
+
+const vector<double>& PredictBridge::getShap() const {
+  static const vector<double> empty;
+  const TreeShap* treeShap = getCore()->getShap();
+  return treeShap == nullptr ? empty : treeShap->getAttribution();
+}
+
+
+const vector<double>& PredictBridge::getShapBase() const {
+  static const vector<double> empty;
+  const TreeShap* treeShap = getCore()->getShap();
+  return treeShap == nullptr ? empty : treeShap->getBase();
+}
+
+
+unsigned int PredictBridge::getShapWidth() const {
+  const TreeShap* treeShap = getCore()->getShap();
+  return treeShap == nullptr ? 0 : treeShap->getNOut();
+}
+
+
+void PredictRegBridge::enablePartial(vector<unsigned int> predIdx,
+				     vector<vector<double>> grid,
+				     bool ice) const {
+  predictRegCore->enablePartial(forestBridge->getForest(), 0, move(predIdx), move(grid), ice);
+}
+
+
+void PredictCtgBridge::enablePartial(vector<unsigned int> predIdx,
+				     vector<vector<double>> grid,
+				     bool ice) const {
+  if (!predictCtgCore->getNTreeUsed().empty())
+    throw invalid_argument("Partial dependence requires walking every tree");
+  predictCtgCore->enablePartial(forestBridge->getForest(), predictCtgCore->getNCtgTrain(), move(predIdx), move(grid), ice);
+}
+
+
+vector<double> PredictBridge::getPD(unsigned int curveIdx) const {
+  const PartialDep* partialDep = getCore()->getPartial();
+  return partialDep == nullptr ? vector<double>() : partialDep->getPD(curveIdx);
+}
+
+
+const vector<double>& PredictBridge::getICE(unsigned int curveIdx) const {
+  static const vector<double> empty;
+  const PartialDep* partialDep = getCore()->getPartial();
+  return partialDep == nullptr ? empty : partialDep->getICE(curveIdx);
+}
+
+
+unsigned int PredictBridge::getPartialWidth() const {
+  const PartialDep* partialDep = getCore()->getPartial();
+  return partialDep == nullptr ? 0 : partialDep->getNOut();
+}
+
+
+void PredictRegBridge::enableLocalImp() const {
+  predictRegCore->enableLocalImp(forestBridge->getForest(), 0);
+}
+
+
+void PredictCtgBridge::enableLocalImp() const {
+  if (!predictCtgCore->getNTreeUsed().empty())
+    throw invalid_argument("Local importance requires walking every tree");
+  predictCtgCore->enableLocalImp(forestBridge->getForest(), predictCtgCore->getNCtgTrain());
+}
+
+
+const vector<double>& PredictBridge::getLocalImp() const {
+  static const vector<double> empty;
+  const LocalImp* localImp = getCore()->getLocalImp();
+  return localImp == nullptr ? empty : localImp->getImportance();
+}
+
+
+unsigned int PredictBridge::getLocalImpWidth() const {
+  const LocalImp* localImp = getCore()->getLocalImp();
+  return localImp == nullptr ? 0 : localImp->getNOut();
+}
+
+
+void PredictRegBridge::enableTraffic() const {
+  predictRegCore->enableTraffic(forestBridge->getForest(), leafBridge->getLeaf());
+}
+
+
+void PredictCtgBridge::enableTraffic() const {
+  predictCtgCore->enableTraffic(forestBridge->getForest(), leafBridge->getLeaf());
+}
+
+
+vector<size_t> PredictBridge::getTraffic() const {
+  const NodeTraffic* nodeTraffic = getCore()->getTraffic();
+  return nodeTraffic == nullptr ? vector<size_t>() : nodeTraffic->getTraffic();
+}
+
+
+vector<double> PredictBridge::getTrafficDrift() const {
+  const NodeTraffic* nodeTraffic = getCore()->getTraffic();
+  return nodeTraffic == nullptr ? vector<double>() : nodeTraffic->getDrift();
+}
+
+
+Predict* PredictRegBridge::getCore() const {
+  return predictRegCore.get();
+}
+
+
+Predict* PredictCtgBridge::getCore() const {
+  return predictCtgCore.get();
 }
 
 
@@ -139,16 +359,64 @@ unsigned int PredictCtgBridge::ctgIdx(unsigned int ctgTest,
 }
 
 
-const unsigned int* PredictCtgBridge::getCensus() const {
+vector<unsigned int> PredictCtgBridge::getCensus() const {
   return predictCtgCore->getCensus();
 }
 
 
+unsigned int PredictCtgBridge::getTopK() const {
+  return predictCtgCore->getTopK();
+}
+
+
+const vector<unsigned int>& PredictCtgBridge::getTopCtg() const {
+  return predictCtgCore->getTopCtg();
+}
+
+
+const vector<double>& PredictCtgBridge::getTopWeight() const {
+  return predictCtgCore->getTopWeight();
+}
+
+
 const vector<double>& PredictCtgBridge::getProb() const {
   return predictCtgCore->getProb();
 }
 
 
+void PredictCtgBridge::bindCensus(unsigned int census[],
+				  bool colMajor) const {
+  predictCtgCore->bindCensus(PredictOut(census, getNRow(), predictCtgCore->getNCtgTrain(), colMajor));
+}
+
+
+void PredictCtgBridge::bindProb(double prob[],
+				bool colMajor) const {
+  predictCtgCore->bindProb(PredictOut(prob, getNRow(), predictCtgCore->getNCtgTrain(), colMajor));
+}
+
+
+void PredictCtgBridge::bindProb(float prob[],
+				bool colMajor) const {
+  predictCtgCore->bindProb(PredictOut(prob, getNRow(), predictCtgCore->getNCtgTrain(), colMajor));
+}
+
+
+const vector<unsigned int>& PredictCtgBridge::getNTreeUsed() const {
+  return predictCtgCore->getNTreeUsed();
+}
+
+
+const vector<unsigned int>& PredictCtgBridge::getSweep() const {
+  return predictCtgCore->getSweep();
+}
+
+
+vector<double> PredictCtgBridge::getSweepMispred() const {
+  return predictCtgCore->getSweepMispred();
+}
+
+
 double PredictRegBridge::getSAE() const {
   return predictRegCore->getSAE();
 }
@@ -174,11 +442,148 @@ const vector<double>& PredictRegBridge::getYPred() const {
 }
 
 
-const vector<double> PredictRegBridge::getQPred() const {
+const vector<double>& PredictRegBridge::getQPred() const {
   return predictRegCore->getQPred();
 }
 
 
-const vector<double> PredictRegBridge::getQEst() const {
+const vector<double>& PredictRegBridge::getQEst() const {
   return predictRegCore->getQEst();
 }
+
+
+unsigned int PredictRegBridge::getNQuant() const {
+  return predictRegCore->getNQuant();
+}
+
+
+void PredictRegBridge::bindYPred(double yPred[]) const {
+  predictRegCore->bindYPred(yPred);
+}
+
+
+void PredictRegBridge::bindQuant(double qPred[],
+				 double qEst[],
+				 bool colMajor) const {
+  predictRegCore->bindQuant(PredictOut(qPred, getNRow(), getNQuant(), colMajor), PredictOut(qEst, getNRow(), 1));
+}
+
+
+void PredictRegBridge::bindQuant(float qPred[],
+				 float qEst[],
+				 bool colMajor) const {
+  predictRegCore->bindQuant(PredictOut(qPred, getNRow(), getNQuant(), colMajor), PredictOut(qEst, getNRow(), 1));
+}
+
+
+void PredictRegBridge::enableJackVar() const {
+  predictRegCore->enableJackVar();
+}
+
+
+const vector<double>& PredictRegBridge::getJackVar() const {
+  static const vector<double> empty;
+  const JackVar* jackVar = predictRegCore->getJackVar();
+  return jackVar == nullptr ? empty : jackVar->getVariance();
+}
+
+
+void PredictRegBridge::enableMulti(const vector<double>& yTrain,
+				   unsigned int nOut) const {
+  predictRegCore->enableMulti(leafBridge->getLeaf(), yTrain, nOut);
+}
+
+
+const vector<double>& PredictRegBridge::getYMulti() const {
+  static const vector<double> empty;
+  const MultiReg* multiReg = predictRegCore->getMultiReg();
+  return multiReg == nullptr ? empty : multiReg->getYPred();
+}
+
+
+const vector<unsigned int>& PredictRegBridge::getSweep() const {
+  return predictRegCore->getSweep();
+}
+
+
+vector<double> PredictRegBridge::getSweepSSE() const {
+  return predictRegCore->getSweepSSE();
+}
+
+
+vector<double> PredictRegBridge::getSweepSAE() const {
+  return predictRegCore->getSweepSAE();
+}
+
+
+unique_ptr<PredictQueueBridge> PredictQueueBridge::FactoryReg(unique_ptr<ForestBridge> forestBridge_,
+							      unsigned int nPredNum,
+							      unsigned int nPredFac,
+							      size_t batchRows,
+							      unsigned int nThread) {
+  return make_unique<PredictQueueBridge>(move(forestBridge_), nullptr, nPredNum, nPredFac, batchRows, nThread);
+}
+
+
+unique_ptr<PredictQueueBridge> PredictQueueBridge::FactoryCtg(unique_ptr<ForestBridge> forestBridge_,
+							      unique_ptr<SamplerBridge> samplerBridge_,
+							      unsigned int nPredNum,
+							      unsigned int nPredFac,
+							      size_t batchRows,
+							      unsigned int nThread) {
+  if (samplerBridge_ == nullptr)
+    throw invalid_argument("Classification queue requires a sampler");
+  return make_unique<PredictQueueBridge>(move(forestBridge_), move(samplerBridge_), nPredNum, nPredFac, batchRows, nThread);
+}
+
+
+PredictQueueBridge::PredictQueueBridge(unique_ptr<ForestBridge> forestBridge_,
+				       unique_ptr<SamplerBridge> samplerBridge_,
+				       unsigned int nPredNum,
+				       unsigned int nPredFac,
+				       size_t batchRows,
+				       unsigned int nThread) :
+  forestBridge(move(forestBridge_)),
+  samplerBridge(move(samplerBridge_)) {
+  if (samplerBridge == nullptr) {
+    predictorReg = make_unique<PredictorReg>(forestBridge->getForest(), nPredNum, nPredFac);
+    queueReg = make_unique<PredictQueue<PredictorReg, double>>(predictorReg.get(), batchRows, nThread);
+  }
+  else {
+    predictorCtg = make_unique<PredictorCtg>(forestBridge->getForest(), samplerBridge->getSampler(), nPredNum, nPredFac);
+    queueCtg = make_unique<PredictQueue<PredictorCtg, PredictorT>>(predictorCtg.get(), batchRows, nThread);
+  }
+}
+
+
+PredictQueueBridge::~PredictQueueBridge() {
+  queueReg = nullptr;
+  queueCtg = nullptr;
+}
+
+
+future<void> PredictQueueBridge::submit(const double num[],
+					const unsigned int fac[],
+					size_t nRow,
+					double yPred[],
+					function<void(const double[], size_t)> callback) const {
+  if (queueReg == nullptr)
+    throw logic_error("Regression request submitted to classification queue");
+  return queueReg->submit(num, fac, nRow, yPred, move(callback));
+}
+
+
+future<void> PredictQueueBridge::submit(const double num[],
+					const unsigned int fac[],
+					size_t nRow,
+					unsigned int yPred[],
+					function<void(const unsigned int[], size_t)> callback) const {
+  if (queueCtg == nullptr)
+    throw logic_error("Classification request submitted to regression queue");
+  return queueCtg->submit(num, fac, nRow, yPred, move(callback));
+}
+
+
+double PredictQueueBridge::getCoalescing() const {
+  return queueReg != nullptr ? queueReg->getCoalescing() : queueCtg->getCoalescing();
+}
@@ -19,9 +19,17 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
+#include <future>
 
 using namespace std;
 
+template<typename PredictorType, typename OutT> class PredictQueue;
+
+/**
+   @brief Compiled forest walker, as emitted by ForestBridge::emitSource().
+ */
+typedef void (*CompiledWalk)(const double[], const unsigned int[], unsigned int[]);
 
 
 /**
@@ -33,11 +41,15 @@ struct PredictBridge {
   /**
      @brief Constructor boxes training and output summaries.
 
+     Observations are supplied either as a ranked frame or as dense
+     blocks, the other being null.
+
      @param nThread is the number of OMP threads requested.
 
      Remaining parameters mirror similarly-named members.
    */
-  PredictBridge(unique_ptr<struct RLEFrame> rleFrame_,
+  PredictBridge(shared_ptr<struct RLEFrame> rleFrame_,
+		unique_ptr<struct DenseFrame> denseFrame_,
                 unique_ptr<struct ForestBridge> forest_,
 		unsigned int nPermute,
 		unsigned int nThread);
@@ -51,23 +63,214 @@ struct PredictBridge {
   bool permutes() const;
 
 
+  /**
+     @brief External entry for prediction.
+   */
+  virtual void predict() const = 0;
+
+
+  /**
+     @brief Predicts several models in a single pass over their frame.
+
+     Models sharing a ranked frame are ordered and transposed once,
+     else each predicts separately.
+   */
+  static void predictBatch(const vector<PredictBridge*>& models);
+
+
+  /**
+     @brief Streams leaf assignments of each block to a caller sink.
+
+     @param leafSink must remain live through prediction.
+   */
+  void setLeafSink(struct LeafSink* leafSink) const;
+
+
+  /**
+     @return forest-wide leaf offsets by tree, plus sup, iff sinking.
+   */
+  const vector<size_t>& getLeafOrigin() const;
+
+
+  /**
+     @brief Directs prediction to gather timers and counters.
+   */
+  void enableStat() const;
+
+
+  /**
+     @brief Directs scoring to walk subtrees shared among trees.
+
+     Engaged only if pooling saves space and only scores are consumed.
+   */
+  void enableShare() const;
+
+
+  /**
+     @brief Directs prediction to select its walkers automatically.
+
+     Ignored if an engine was requested explicitly.
+
+     @param calibrate is true iff candidates are timed on synthetic
+     rows, else selection follows the forest's shape.
+   */
+  void enableAuto(bool calibrate) const;
+
+
+  /**
+     @return prediction statistics, iff enabled.
+   */
+  const struct PredictStat* getStat() const;
+
+
+  /**
+     @brief Directs prediction to attribute each row's output by predictor.
+
+     Requires leaf extents and uncoded numeric values.
+   */
+  virtual void enableShap() const = 0;
+
+
+  /**
+     @return attributions, row x core predictor x output, iff enabled.
+   */
+  const vector<double>& getShap() const;
+
+
+  /**
+     @return expected forest output, by output, iff enabled.
+   */
+  const vector<double>& getShapBase() const;
+
+
+  /**
+     @return # outputs attributed per predictor iff enabled, else zero.
+   */
+  unsigned int getShapWidth() const;
+
+
+  /**
+     @brief Directs prediction to evaluate partial dependence.
+
+     Each curve substitutes a grid of values for a single predictor.
+     Requires uncoded numeric values and, if classifying, walking every
+     tree.
+
+     @param predIdx are core predictor indices, by curve.
+
+     @param grid are the values substituted, by curve.  Factor grids
+     are zero-based codes.
+
+     @param ice is true iff row-level curves are to be retained.
+   */
+  virtual void enablePartial(vector<unsigned int> predIdx,
+			     vector<vector<double>> grid,
+			     bool ice) const = 0;
+
+
+  /**
+     @return mean over rows, grid x output, for a given curve.
+   */
+  vector<double> getPD(unsigned int curveIdx) const;
+
+
+  /**
+     @return row x grid x output values for a given curve, iff retained.
+   */
+  const vector<double>& getICE(unsigned int curveIdx) const;
+
+
+  /**
+     @return # outputs evaluated per grid value iff enabled, else zero.
+   */
+  unsigned int getPartialWidth() const;
+
+
+  /**
+     @brief Directs prediction to measure the change in each row's
+     output under substitution of each predictor's value from a donor
+     row.
+
+     Requires uncoded numeric values and, if classifying, walking every
+     tree.
+   */
+  virtual void enableLocalImp() const = 0;
+
+
+  /**
+     @return mean changes, row x core predictor x output, iff enabled.
+   */
+  const vector<double>& getLocalImp() const;
+
+
+  /**
+     @return # outputs measured per predictor iff enabled, else zero.
+   */
+  unsigned int getLocalImpWidth() const;
+
+
+  /**
+     @brief Directs prediction to tally the rows reaching each node.
+
+     Requires leaf extents, against which traffic is compared.
+   */
+  virtual void enableTraffic() const = 0;
+
+
+  /**
+     @return rows reaching each node, indexed as the node arena, iff
+     enabled.
+   */
+  vector<size_t> getTraffic() const;
+
+
+  /**
+     @return per-tree distance of leaf traffic from training cover, iff
+     enabled.
+   */
+  vector<double> getTrafficDrift() const;
+
+
 protected:
-  unique_ptr<struct RLEFrame> rleFrame; // Local ownership
+  /**
+     @return core prediction object.
+   */
+  virtual class Predict* getCore() const = 0;
+
+
+  unsigned int getNPredNum() const;
+
+
+  unsigned int getNPredFac() const;
+
+
+  shared_ptr<struct RLEFrame> rleFrame; // Possibly shared across a batch.
+  unique_ptr<struct DenseFrame> denseFrame; // Local ownership; aliases caller's blocks.
   unique_ptr<struct ForestBridge> forestBridge; // Local ownership.
   const unsigned int nPermute; // # times to permute.
 };
 
 
 struct PredictRegBridge : public PredictBridge {
-  PredictRegBridge(unique_ptr<struct RLEFrame> rleFrame_,
+  PredictRegBridge(shared_ptr<struct RLEFrame> rleFrame_,
+		   unique_ptr<struct DenseFrame> denseFrame_,
 		   unique_ptr<struct ForestBridge> forestBridge_,
 		   unique_ptr<struct SamplerBridge> samplerBridge_,
 		   unique_ptr<struct LeafBridge> leafBridge_,
 		   vector<double> yTest,
 		   unsigned int nPermute_,
 		   bool trapUnobserved,
+		   bool quickScore,
+		   bool binCode,
+		   bool compact,
+		   bool reuseRuns,
+		   CompiledWalk compiledWalk,
+		   unsigned int nReplica,
 		   unsigned int nThread,
-		   vector<double> quantile_);
+		   vector<double> quantile_,
+		   unsigned int quantSketch,
+		   bool quantExact,
+		   vector<unsigned int> treeSweep);
 
   ~PredictRegBridge(); // Forward declaration:  not specified default.
 
@@ -75,7 +278,7 @@ struct PredictRegBridge : public PredictBridge {
   /**
      @brief External entry for prediction.
 
-     May be parametrized for separate entry in distributed setting.
+     Distributed shards enter as a whole, over a sliced frame.
    */
   void predict() const;
 
@@ -93,35 +296,161 @@ struct PredictRegBridge : public PredictBridge {
   
 
   const vector<double>& getYPred() const;
+
+
+  /**
+     @brief Attributes the score.
+   */
+  void enableShap() const;
+
+
+
+  /**
+     @brief Evaluates the score.
+   */
+  void enablePartial(vector<unsigned int> predIdx,
+		     vector<vector<double>> grid,
+		     bool ice) const;
+
+
+  /**
+     @brief Measures the change in score.
+   */
+  void enableLocalImp() const;
+
+
+  void enableTraffic() const;
   
   
   /**
-     @return vector of predection quantiles iff quant non-null else empty.
+     @return vector of predection quantiles iff quant non-null and
+     unbound, else empty.
+   */
+  const vector<double>& getQPred() const;
+
+  /**
+     @return vector of estimate quantiles iff quant non-null and
+     unbound, else empty.
+   */
+  const vector<double>& getQEst() const;
+
+
+  /**
+     @return count of quantiles predicted per row, zero if none.
+   */
+  unsigned int getNQuant() const;
+
+
+  /**
+     @brief Directs predictions into caller storage, which must outlive
+     prediction.  getYPred() is thereafter empty.
+
+     @param yPred has one slot per row.
+   */
+  void bindYPred(double yPred[]) const;
+
+
+  /**
+     @brief As above, but quantiles and estimates.  No effect unless
+     getNQuant() is nonzero.
+
+     @param qPred is row x quantile.
+
+     @param qEst has one slot per row.
+
+     @param colMajor is true iff quantile columns are contiguous, as in R.
+   */
+  void bindQuant(double qPred[],
+		 double qEst[],
+		 bool colMajor) const;
+
+
+  /**
+     @brief As above, but single precision.
    */
-  const vector<double> getQPred() const;
+  void bindQuant(float qPred[],
+		 float qEst[],
+		 bool colMajor) const;
+
+
+  /**
+     @brief Estimates the infinitesimal-jackknife variance of the score.
+   */
+  void enableJackVar() const;
+
 
   /**
-     @return vector of estimate quantiles iff quant non-null else empty.
+     @return per-row variance estimates iff enabled, else empty.
    */
-  const vector<double> getQEst() const;
+  const vector<double>& getJackVar() const;
+
+
+  /**
+     @brief Estimates several responses from the leaves reached.
+
+     @param yTrain holds each training response in turn.
+
+     @param nOut is the number of responses.
+   */
+  void enableMulti(const vector<double>& yTrain,
+		   unsigned int nOut) const;
+
+
+  /**
+     @return row-major estimates of each response iff enabled, else empty.
+   */
+  const vector<double>& getYMulti() const;
+
+
+  /**
+     @return tree-count checkpoints iff sweeping, else empty.
+   */
+  const vector<unsigned int>& getSweep() const;
+
+
+  /**
+     @return squared test error summed over rows, by checkpoint.
+   */
+  vector<double> getSweepSSE() const;
+
+
+  /**
+     @return absolute test error summed over rows, by checkpoint.
+   */
+  vector<double> getSweepSAE() const;
   
 private:
   unique_ptr<struct SamplerBridge> samplerBridge; // Local ownership.
   unique_ptr<struct LeafBridge> leafBridge;
   unique_ptr<class PredictReg> predictRegCore;
+
+  class Predict* getCore() const;
 };
 
 
 struct PredictCtgBridge : public PredictBridge {
-  PredictCtgBridge(unique_ptr<struct RLEFrame> rleFrame_,
+  PredictCtgBridge(shared_ptr<struct RLEFrame> rleFrame_,
+		   unique_ptr<struct DenseFrame> denseFrame_,
 		   unique_ptr<struct ForestBridge> forestBridge_,
 		   unique_ptr<SamplerBridge> samplerBridge_,
 		   unique_ptr<struct LeafBridge> leafBridge_,
 		   vector<unsigned int> yTest,
 		   unsigned int nPermute_,
 		   bool doProb,
+		   bool probSample,
+		   bool doCensus,
+		   unsigned int topK,
 		   bool trapUnobserved,
-		   unsigned int nThread);
+		   bool quickScore,
+		   bool binCode,
+		   bool compact,
+		   bool reuseRuns,
+		   CompiledWalk compiledWalk,
+		   unsigned int nReplica,
+		   bool earlyExit,
+		   double exitTolerance,
+		   unsigned int nThread,
+		   vector<unsigned int> treeSweep);
 
   ~PredictCtgBridge(); // Forward declaration:  not specified default.
 
@@ -147,7 +476,7 @@ struct PredictCtgBridge : public PredictBridge {
   /**
      @brief External entry for prediction.
 
-     May be parametrized for separate entry in distributed setting.
+     Distributed shards enter as a whole, over a sliced frame.
    */
   void predict() const;
 
@@ -155,10 +484,102 @@ struct PredictCtgBridge : public PredictBridge {
                       unsigned int ctgPred) const;
   
 
-  const unsigned int* getCensus() const;
+  /**
+     @return row x category census, empty unless retained and unbound.
+   */
+  vector<unsigned int> getCensus() const;
+
+
+  /**
+     @brief Directs the census into caller storage, which must outlive
+     prediction.  No effect unless the census is retained.
+
+     @param census is row x training category.
+
+     @param colMajor is true iff category columns are contiguous, as in R.
+   */
+  void bindCensus(unsigned int census[],
+		  bool colMajor) const;
+
+
+  /**
+     @brief As above, but probabilities, iff computed.
+   */
+  void bindProb(double prob[],
+		bool colMajor) const;
+
+
+  /**
+     @brief As above, but single precision.
+   */
+  void bindProb(float prob[],
+		bool colMajor) const;
+
+
+  /**
+     @return # leading categories reported per row.
+   */
+  unsigned int getTopK() const;
+
+
+  /**
+     @return row x rank leading categories, iff reported.
+   */
+  const vector<unsigned int>& getTopCtg() const;
+
+
+  /**
+     @return row x rank vote fractions or probabilities, iff reported.
+   */
+  const vector<double>& getTopWeight() const;
   
 
+  /**
+     @return row x category probabilities iff computed and unbound.
+   */
   const vector<double>& getProb() const;
+
+
+  /**
+     @brief Attributes the vote fraction of each training category.
+   */
+  void enableShap() const;
+
+
+
+  /**
+     @brief Evaluates the vote fraction of each training category.
+   */
+  void enablePartial(vector<unsigned int> predIdx,
+		     vector<vector<double>> grid,
+		     bool ice) const;
+
+
+  /**
+     @brief Measures the change in vote fraction of each category.
+   */
+  void enableLocalImp() const;
+
+
+  void enableTraffic() const;
+
+
+  /**
+     @return # trees walked per row iff exiting early, else empty.
+   */
+  const vector<unsigned int>& getNTreeUsed() const;
+
+
+  /**
+     @return tree-count checkpoints iff sweeping, else empty.
+   */
+  const vector<unsigned int>& getSweep() const;
+
+
+  /**
+     @return misprediction rate, by checkpoint.
+   */
+  vector<double> getSweepMispred() const;
   
 
 private:
@@ -166,8 +587,101 @@ private:
   unique_ptr<struct LeafBridge> leafBridge; // " "
   unique_ptr<class PredictCtg> predictCtgCore;
 
+  class Predict* getCore() const;
+
 
 };
 
 
+/**
+   @brief Non-blocking prediction of small dense requests.
+
+   Requests against the same model are coalesced into micro-batches and
+   scored by a persistent dispatcher, completing through a future and an
+   optional callback.  Rows are numeric-first and row-major, with
+   zero-based factor codes.  Buffers must remain live until completion.
+ */
+struct PredictQueueBridge {
+  /**
+     @brief Builds a regression queue.
+
+     @param batchRows bounds the rows coalesced into a micro-batch.
+
+     @param nThread is the team size for scoring a micro-batch.
+   */
+  static unique_ptr<PredictQueueBridge> FactoryReg(unique_ptr<struct ForestBridge> forestBridge_,
+						   unsigned int nPredNum,
+						   unsigned int nPredFac,
+						   size_t batchRows,
+						   unsigned int nThread);
+
+
+  /**
+     @brief As above, but classification.
+
+     @param samplerBridge_ supplies the training response.
+   */
+  static unique_ptr<PredictQueueBridge> FactoryCtg(unique_ptr<struct ForestBridge> forestBridge_,
+						   unique_ptr<struct SamplerBridge> samplerBridge_,
+						   unsigned int nPredNum,
+						   unsigned int nPredFac,
+						   size_t batchRows,
+						   unsigned int nThread);
+
+
+  PredictQueueBridge(unique_ptr<struct ForestBridge> forestBridge_,
+		     unique_ptr<struct SamplerBridge> samplerBridge_,
+		     unsigned int nPredNum,
+		     unsigned int nPredFac,
+		     size_t batchRows,
+		     unsigned int nThread);
+
+  /**
+     @brief Completes outstanding requests before release.
+   */
+  ~PredictQueueBridge();
+
+
+  /**
+     @brief Submits a regression request, returning immediately.
+
+     @param[out] yPred receives the mean score, per row.
+
+     @param callback is invoked on the dispatcher with the outputs, if
+     nonempty.
+   */
+  future<void> submit(const double num[],
+		      const unsigned int fac[],
+		      size_t nRow,
+		      double yPred[],
+		      function<void(const double[], size_t)> callback = nullptr) const;
+
+
+  /**
+     @brief As above, but classification.
+
+     @param[out] yPred receives the zero-based category, per row.
+   */
+  future<void> submit(const double num[],
+		      const unsigned int fac[],
+		      size_t nRow,
+		      unsigned int yPred[],
+		      function<void(const unsigned int[], size_t)> callback = nullptr) const;
+
+
+  /**
+     @return mean # requests coalesced per micro-batch.
+   */
+  double getCoalescing() const;
+
+private:
+  unique_ptr<struct ForestBridge> forestBridge; // Local ownership.
+  unique_ptr<struct SamplerBridge> samplerBridge; // Null iff regression.
+  unique_ptr<class PredictorReg> predictorReg; // Non-null iff regression.
+  unique_ptr<class PredictorCtg> predictorCtg; // Non-null iff classification.
+  unique_ptr<PredictQueue<class PredictorReg, double>> queueReg; // Released first.
+  unique_ptr<PredictQueue<class PredictorCtg, unsigned int>> queueCtg; // " "
+};
+
+
 #endif
@@ -16,8 +16,11 @@
 #include "samplerbridge.h"
 #include "sampler.h"
 #include "samplerrw.h"
+#include "ompthread.h"
+#include "prng.h"
 
 #include <memory>
+#include <numeric>
 using namespace std;
 
 
@@ -46,6 +49,19 @@ unique_ptr<SamplerBridge> SamplerBridge::preSample(size_t nSamp,
 }
 
 
+unique_ptr<SamplerBridge> SamplerBridge::preSampleStrata(size_t nObs,
+							 unsigned int nTree,
+							 bool replace,
+							 const vector<unsigned int>& yCtg,
+							 const vector<size_t>& ctgSamp) {
+  size_t nSamp = accumulate(ctgSamp.begin(), ctgSamp.end(), size_t(0));
+  SamplerNux::setMasks(nObs);
+  auto sb = make_unique<SamplerBridge>(nSamp, nObs, nTree, true, nullptr);
+  sb->sampler->setStrata(yCtg, ctgSamp, replace);
+  return sb;
+}
+
+
 SamplerBridge::SamplerBridge(size_t nSamp,
 			     size_t nObs,
 			     unsigned int nTree,
@@ -72,11 +88,26 @@ SamplerBridge::SamplerBridge(const vector<double>& yTrain,
 }
 
 
+void SamplerBridge::setBlocks(size_t blockSize) {
+  sampler->setBlocks(blockSize);
+}
+
+
 void SamplerBridge::sample() {
   sampler->sample();
 }
 
 
+void SamplerBridge::sampleTrees(unsigned int nThread,
+				size_t treeOffset) {
+  OmpThread::init(nThread);
+  PRNGLocal::initStream(treeOffset);
+  sampler->sampleTrees();
+  PRNGLocal::deInitStream();
+  OmpThread::deInit();
+}
+
+
 void SamplerBridge::appendSamples(const vector<size_t>& idx) { // EXIT
   sampler->appendSamples(idx);
 }
@@ -144,6 +175,25 @@ SamplerBridge::SamplerBridge(const vector<unsigned int>& yTrain,
 }
 
 
+SamplerBridge::SamplerBridge(unique_ptr<Sampler> sampler_) :
+  sampler(move(sampler_)) {
+}
+
+
+unique_ptr<SamplerBridge> SamplerBridge::select(const vector<unsigned int>& treeIdx) const {
+  return make_unique<SamplerBridge>(sampler->select(treeIdx));
+}
+
+
+unique_ptr<SamplerBridge> SamplerBridge::merge(const vector<const SamplerBridge*>& samplerBridges) {
+  vector<const Sampler*> samplers;
+  for (const SamplerBridge* samplerBridge : samplerBridges) {
+    samplers.push_back(samplerBridge->getSampler());
+  }
+  return make_unique<SamplerBridge>(Sampler::merge(samplers));
+}
+
+
 SamplerBridge::~SamplerBridge() {
   SamplerNux::unsetMasks();
 }
@@ -159,6 +209,15 @@ size_t SamplerBridge::getNuxCount() const {
 }
 
 
+size_t SamplerBridge::getBagTotal(unsigned int nTree) const {
+  size_t bagTotal = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    bagTotal += sampler->getBagCount(tIdx);
+  }
+  return bagTotal;
+}
+
+
 void SamplerBridge::dumpNux(double nuxOut[]) const {
   sampler->dumpNux(nuxOut);
 }
@@ -49,6 +49,20 @@ struct SamplerBridge {
 					     bool replace,
 					     const double weight[]);
 
+
+  /**
+     @brief Stratified sampling entry:  fixed counts per category.
+
+     @param yCtg are the zero-based training categories.
+
+     @param ctgSamp are the per-category sample counts.
+   */
+  static unique_ptr<SamplerBridge> preSampleStrata(size_t nObs,
+						   unsigned int nTree,
+						   bool replace,
+						   const vector<unsigned int>& yCtg,
+						   const vector<size_t>& ctgSamp);
+
   /**
      @brief Regression, training entry.
    */
@@ -117,12 +131,49 @@ struct SamplerBridge {
 		unsigned int nCtg,
 		bool bagging);
 
+
+  /**
+     @brief Wraps an existing core sampler.
+   */
+  SamplerBridge(unique_ptr<class Sampler> sampler_);
+
+
+  /**
+     @brief Selects a subset of trees, in the order specified.
+   */
+  unique_ptr<SamplerBridge> select(const vector<unsigned int>& treeIdx) const;
+
+
+  /**
+     @brief Concatenates samplers trained over a common response.
+   */
+  static unique_ptr<SamplerBridge> merge(const vector<const SamplerBridge*>& samplerBridges);
+
   
+  /**
+     @brief Samples rows in blocks of consecutive rows.
+
+     @param blockSize is the number of rows per block:  < 2 samples rows singly.
+   */
+  void setBlocks(size_t blockSize);
+
+
   /**
      @brief Invokes core sampling for a single tree.
    */
   void sample();
 
+
+  /**
+     @brief Invokes core sampling for all trees, in parallel.
+
+     @param nThread is a user-specified thread request.
+
+     @param treeOffset is the absolute index of the leading tree.
+   */
+  void sampleTrees(unsigned int nThread,
+		   size_t treeOffset);
+
   
   void appendSamples(const vector<size_t>& idx); // EXIT: internalized.
 
@@ -151,6 +202,12 @@ struct SamplerBridge {
 
   size_t getNuxCount() const;
 
+
+  /**
+     @return # sampling records held by the leading trees.
+   */
+  size_t getBagTotal(unsigned int nTree) const;
+
   
   /**
      @brief Copies the sampling records into the buffer passed.
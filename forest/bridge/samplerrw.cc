@@ -43,3 +43,23 @@ vector<vector<SamplerNux>> SamplerRW::unpack(const double samples[],
 
   return nuxOut;
 }
+
+
+vector<vector<SamplerNux>> SamplerRW::unpack(const PackedT packed[],
+					     const IndexT bagCount[],
+					     unsigned int nTree,
+					     PredictorT nCtg) {
+  IndexT maxSCount = 0;
+  vector<vector<SamplerNux>> nuxOut(nTree);
+  const PackedT* sample = packed;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    nuxOut[tIdx].reserve(bagCount[tIdx]);
+    for (IndexT idx = 0; idx < bagCount[tIdx]; idx++) {
+      maxSCount = max(SamplerNux::getSCount(*sample), maxSCount);
+      nuxOut[tIdx].emplace_back(*sample++);
+    }
+  }
+  SampleNux::setShifts(nCtg, maxSCount);
+
+  return nuxOut;
+}
@@ -26,6 +26,15 @@ struct SamplerRW {
 						 IndexT nSamp,
 						 unsigned int nTree,
 						 PredictorT nCtg = 0);
+
+
+  /**
+     @brief As above, but from packed records with known per-tree extents.
+   */
+  static vector<vector<class SamplerNux>> unpack(const PackedT packed[],
+						 const IndexT bagCount[],
+						 unsigned int nTree,
+						 PredictorT nCtg = 0);
 };
 
 #endif
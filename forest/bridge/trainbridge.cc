@@ -20,15 +20,56 @@
 
 #include "response.h"
 #include "train.h"
+#include "sampler.h"
+#include "trainoob.h"
+#include "booster.h"
 #include "rftrain.h"
 #include "predictorframe.h"
 #include "coproc.h"
+#include "prng.h"
+#include "rleframe.h"
+#include "trainparam.h"
+#include "trainfootprint.h"
+
+#include <stdexcept>
+
+FrameCache::FrameCache(unique_ptr<RLEFrame> rleFrame_,
+		       double autoCompress_,
+		       bool enableCoproc_,
+		       bool packRanks_) :
+  rleFrame(move(rleFrame_)),
+  autoCompress(autoCompress_),
+  enableCoproc(enableCoproc_),
+  packRanks(packRanks_),
+  frame(make_shared<PredictorFrame>(rleFrame.get(), autoCompress, enableCoproc, packRanks, diag)) {
+}
+
+
+FrameCache::~FrameCache() {
+}
+
 
-TrainBridge::TrainBridge(const RLEFrame* rleFrame, double autoCompress, bool enableCoproc, vector<string>& diag) : frame(make_unique<PredictorFrame>(rleFrame, autoCompress, enableCoproc, diag)) {
+bool FrameCache::conforms(double autoCompress,
+			  bool enableCoproc,
+			  bool packRanks) const {
+  return autoCompress == this->autoCompress && enableCoproc == this->enableCoproc && packRanks == this->packRanks;
+}
+
+
+TrainBridge::TrainBridge(const RLEFrame* rleFrame, double autoCompress, bool enableCoproc, bool packRanks, vector<string>& diag) :
+  frame(make_shared<PredictorFrame>(rleFrame, autoCompress, enableCoproc, packRanks, diag)),
+  param(make_unique<TrainParam>()) {
   Forest::init(rleFrame->getNPred());
 }
 
 
+TrainBridge::TrainBridge(const FrameCache* frameCache) :
+  frame(frameCache->getFrame()),
+  param(make_unique<TrainParam>()) {
+  Forest::init(frame->getNPred());
+}
+
+
 TrainBridge::~TrainBridge() {
 }
 
@@ -44,29 +85,169 @@ unique_ptr<TrainedChunk> TrainBridge::train(const ForestBridge& forestBridge,
 					    unsigned int treeOff,
 					    unsigned int treeChunk,
 					    const LeafBridge* leafBridge) const {
+  return train(forestBridge, samplerBridge, treeOff, treeChunk, leafBridge, drawSeed());
+}
+
+
+unique_ptr<TrainedChunk> TrainBridge::train(const ForestBridge& forestBridge,
+					    const SamplerBridge* samplerBridge,
+					    unsigned int treeOff,
+					    unsigned int treeChunk,
+					    const LeafBridge* leafBridge,
+					    uint64_t seed) const {
   auto trained = Train::train(frame.get(),
+			      param.get(),
 			      samplerBridge->getSampler(),
 			      forestBridge.getForest(),
 			      IndexRange(treeOff, treeChunk),
-			      leafBridge->getLeaf());
+			      leafBridge->getLeaf(),
+			      seed,
+			      trainOOB.get(),
+			      booster.get());
 
   return make_unique<TrainedChunk>(move(trained));
 }
 
 
-void TrainBridge::initBlock(unsigned int trainBlock) {
-  Train::initBlock(trainBlock);
+size_t TrainBridge::getLeafBound(const SamplerBridge* samplerBridge,
+				 unsigned int nTree) const {
+  size_t leafSum = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    leafSum += Train::leafBound(param.get(), samplerBridge->getSampler()->getBagCount(tIdx));
+  }
+  return leafSum;
+}
+
+
+size_t TrainBridge::getNodeBound(const SamplerBridge* samplerBridge,
+				 unsigned int nTree) const {
+  size_t nodeSum = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    nodeSum += Train::nodeBound(Train::leafBound(param.get(), samplerBridge->getSampler()->getBagCount(tIdx)));
+  }
+  return nodeSum;
+}
+
+
+TrainFootprint TrainBridge::estimateFootprint(const SamplerBridge* samplerBridge,
+					      unsigned int treeChunk,
+					      unsigned int nChunkLive) const {
+  return TrainFootprint(frame.get(), param.get(), samplerBridge->getSampler(), booster != nullptr, treeChunk, nChunkLive);
+}
+
+
+vector<string> TrainBridge::fitBudget(const SamplerBridge* samplerBridge,
+				      unsigned int treeChunk,
+				      unsigned int nChunkLive,
+				      size_t budget) {
+  return estimateFootprint(samplerBridge, treeChunk, nChunkLive).fitBudget(param.get(), budget);
+}
+
+
+uint64_t TrainBridge::drawSeed() {
+  return PRNGLocal::sessionSeed();
+}
+
+
+vector<unique_ptr<TrainedChunk>> TrainBridge::train(const vector<const TrainBridge*>& trainBridge,
+						    const vector<const ForestBridge*>& forestBridge,
+						    const vector<const SamplerBridge*>& samplerBridge,
+						    unsigned int treeOff,
+						    const vector<unsigned int>& treeChunk,
+						    const vector<const LeafBridge*>& leafBridge,
+						    const vector<uint64_t>& seed) {
+  vector<const TrainParam*> param;
+  vector<const Sampler*> sampler;
+  vector<Forest*> forest;
+  vector<IndexRange> treeRange;
+  vector<Leaf*> leaf;
+  vector<TrainOOB*> trainOOB;
+  for (unsigned int sessionIdx = 0; sessionIdx < trainBridge.size(); sessionIdx++) {
+    if (trainBridge[sessionIdx]->frame != trainBridge[0]->frame) {
+      throw invalid_argument("Concurrent sessions must share a frame");
+    }
+    if (trainBridge[sessionIdx]->booster != nullptr) {
+      throw invalid_argument("Boosted sessions must train singly");
+    }
+    param.push_back(trainBridge[sessionIdx]->param.get());
+    sampler.push_back(samplerBridge[sessionIdx]->getSampler());
+    forest.push_back(forestBridge[sessionIdx]->getForest());
+    treeRange.emplace_back(treeOff, treeChunk[sessionIdx]);
+    leaf.push_back(leafBridge[sessionIdx]->getLeaf());
+    trainOOB.push_back(trainBridge[sessionIdx]->trainOOB.get());
+  }
+
+  vector<unique_ptr<TrainedChunk>> chunk;
+  for (auto & trained : Train::train(trainBridge[0]->frame.get(), param, sampler, forest, treeRange, leaf, seed, trainOOB)) {
+    chunk.emplace_back(make_unique<TrainedChunk>(move(trained)));
+  }
+  return chunk;
+}
+
+
+void TrainBridge::initOOB(const SamplerBridge* samplerBridge) {
+  trainOOB = make_unique<TrainOOB>(frame.get(), samplerBridge->getSampler());
+}
+
+
+void TrainBridge::initBoost(const SamplerBridge* samplerBridge,
+			    double shrinkage) {
+  booster = make_unique<Booster>(frame.get(), samplerBridge->getSampler(), shrinkage);
+}
+
+
+bool TrainBridge::hasOOB() const {
+  return trainOOB != nullptr;
+}
+
+
+vector<double> TrainBridge::getOOBCurve() const {
+  return trainOOB == nullptr ? vector<double>(0) : trainOOB->getErrCurve();
+}
+
+
+double TrainBridge::getOOBError() const {
+  return trainOOB == nullptr ? 0.0 : trainOOB->getError();
+}
+
+
+bool TrainBridge::oobPlateau(size_t window,
+			     double tolerance) const {
+  return trainOOB != nullptr && trainOOB->plateau(window, tolerance);
+}
+
+
+void TrainBridge::initBlock(unsigned int trainBlock,
+			    unsigned int treeThread,
+			    bool levelSync) {
+  RfTrain::initBlock(param.get(), trainBlock, treeThread, levelSync);
 }
 
 
 void TrainBridge::initProb(unsigned int predFixed,
-                           const vector<double> &predProb) {
-  RfTrain::initProb(predFixed, predProb);
+                           const vector<double> &predProb,
+			   bool predAlias) {
+  RfTrain::initProb(param.get(), predFixed, predProb, predAlias);
 }
 
 
 void TrainBridge::initTree(size_t leafMax) {
-  RfTrain::initTree(leafMax);
+  RfTrain::initTree(param.get(), leafMax);
+}
+
+
+void TrainBridge::initPrune(double pruneCost) {
+  RfTrain::initPrune(param.get(), pruneCost);
+}
+
+
+void TrainBridge::initHistory(size_t historyBudget) {
+  RfTrain::initHistory(param.get(), historyBudget);
+}
+
+
+void TrainBridge::initExtraTrees(bool extraTrees) {
+  RfTrain::initExtraTrees(param.get(), extraTrees);
 }
 
 
@@ -75,23 +256,55 @@ void TrainBridge::initOmp(unsigned int nThread) {
 }
 
 
+void TrainBridge::initStream(size_t treeOffset) {
+  PRNGLocal::initStream(treeOffset);
+}
+
+
 void TrainBridge::initSplit(unsigned int minNode,
                             unsigned int totLevels,
                             double minRatio,
 			    const vector<double>& feSplitQuant) {
-  RfTrain::initSplit(minNode, totLevels, minRatio, feSplitQuant);
+  RfTrain::initSplit(param.get(), minNode, totLevels, minRatio, feSplitQuant);
 }
   
 
 void TrainBridge::initMono(const vector<double> &regMono) {
-  RfTrain::initMono(frame.get(), regMono);
+  RfTrain::initMono(param.get(), frame.get(), regMono);
+}
+
+
+void TrainBridge::initMulti(const vector<double>& yMulti,
+			    unsigned int nOut) {
+  RfTrain::initMulti(param.get(), yMulti, nOut);
+}
+
+
+void TrainBridge::initBin(unsigned int nBin) {
+  frame->quantize(nBin);
+}
+
+
+void TrainBridge::initSubtree(size_t subtreeMax) {
+  RfTrain::initSubtree(param.get(), subtreeMax);
+}
+
+
+void TrainBridge::initSketch(unsigned int nCut) {
+  RfTrain::initSketch(param.get(), nCut);
+}
+
+
+void TrainBridge::initScreen(unsigned int screenTrees,
+			     double screenWeight) {
+  RfTrain::initScreen(param.get(), screenTrees, screenWeight);
 }
 
 
 void TrainBridge::deInit() {
   Forest::deInit();
   RfTrain::deInit();
-  Train::deInit();
+  PRNGLocal::deInitStream();
 }
 
 
@@ -106,3 +319,8 @@ TrainedChunk::~TrainedChunk() {
 const vector<double>& TrainedChunk::getPredInfo() const {
   return train->getPredInfo();
 }
+
+
+const TrainStat& TrainedChunk::getTrainStat() const {
+  return train->getTrainStat();
+}
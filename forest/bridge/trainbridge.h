@@ -19,14 +19,71 @@
 
 #include<vector>
 #include<memory>
+#include<string>
+#include<cstdint>
 
 using namespace std;
 
+/**
+   @brief Retains a predictor frame, with its layout and rank tables,
+   across training sessions over a common observation frame.
+ */
+struct FrameCache {
+  /**
+     @brief Takes ownership of the observations and builds their frame.
+   */
+  FrameCache(unique_ptr<struct RLEFrame> rleFrame_,
+	     double autoCompress_,
+	     bool enableCoproc_,
+	     bool packRanks_ = false);
+
+
+  ~FrameCache();
+
+
+  /**
+     @return true iff the frame was built with the given parameters.
+   */
+  bool conforms(double autoCompress,
+		bool enableCoproc,
+		bool packRanks = false) const;
+
+
+  /**
+     @return diagnostics accumulated while building the frame.
+   */
+  const vector<string>& getDiag() const {
+    return diag;
+  }
+
+
+  shared_ptr<class PredictorFrame> getFrame() const {
+    return frame;
+  }
+
+private:
+  const unique_ptr<struct RLEFrame> rleFrame; // Referenced by frame.
+  const double autoCompress;
+  const bool enableCoproc;
+  const bool packRanks; // Whether frame ranks are bit-packed.
+  vector<string> diag;
+  const shared_ptr<class PredictorFrame> frame;
+};
+
+
 struct TrainBridge {
   TrainBridge(const struct RLEFrame* rleFrame,
 	      double autoCompress,
 	      bool enableCoproc,
+	      bool packRanks,
 	      vector<string>& diag);
+
+
+  /**
+     @brief Cached constructor:  shares a previously-built frame.
+   */
+  TrainBridge(const FrameCache* frameCache);
+
   
   ~TrainBridge();
 
@@ -48,21 +105,200 @@ struct TrainBridge {
 					const struct LeafBridge* leafBridge) const;
 
 
+  /**
+     @brief As above, but keyed by a seed drawn beforehand.
+
+     Sessions trained in several chunks should draw the seed once and
+     pass it to each, as streams are keyed by absolute tree index.
+
+     Draws nothing from the front end, so may be called from a thread
+     other than the master, provided the forest and leaf bridges are
+     private to the call.
+
+     @param seed is as obtained from drawSeed().
+   */
+  unique_ptr<struct TrainedChunk> train(const struct ForestBridge& forest,
+					const struct SamplerBridge* sampler,
+					unsigned int treeOff,
+					unsigned int treeChunk,
+					const struct LeafBridge* leafBridge,
+					uint64_t seed) const;
+
+
+  /**
+     @brief Bounds the total leaf count of the leading trees.
+
+     @param nTree is the number of leading trees.
+   */
+  size_t getLeafBound(const struct SamplerBridge* samplerBridge,
+		      unsigned int nTree) const;
+
+
+  /**
+     @brief As above, but bounds the total node count.
+   */
+  size_t getNodeBound(const struct SamplerBridge* samplerBridge,
+		      unsigned int nTree) const;
+
+
+  /**
+     @brief Bounds the memory held by a session's training structures.
+
+     @param treeChunk is the number of trees per chunk.
+
+     @param nChunkLive is the number of chunks held at once.
+   */
+  struct TrainFootprint estimateFootprint(const struct SamplerBridge* samplerBridge,
+					  unsigned int treeChunk,
+					  unsigned int nChunkLive) const;
+
+
+  /**
+     @brief Adjusts session parameters to train within a byte budget.
+
+     @return description of each concession made.
+   */
+  vector<string> fitBudget(const struct SamplerBridge* samplerBridge,
+			   unsigned int treeChunk,
+			   unsigned int nChunkLive,
+			   size_t budget);
+
+
+  /**
+     @brief Draws a chunk's stream key from the front end.
+
+     Master thread only.
+   */
+  static uint64_t drawSeed();
+
+
+  /**
+     @brief Trains a chunk of trees for each of several sessions.
+
+     Sessions must share a frame, as from a common FrameCache, but
+     have independent parameters, samplers and out-of-bag state.
+     Vector arguments are indexed by session.
+
+     @param treeOff is the common offset of the chunk.
+
+     @param treeChunk is the per-session chunk size.
+
+     @param seed holds the per-session keys, each drawn once by drawSeed().
+
+     @return per-session trained chunks.
+   */
+  static vector<unique_ptr<struct TrainedChunk>> train(const vector<const TrainBridge*>& trainBridge,
+						       const vector<const struct ForestBridge*>& forestBridge,
+						       const vector<const struct SamplerBridge*>& samplerBridge,
+						       unsigned int treeOff,
+						       const vector<unsigned int>& treeChunk,
+						       const vector<const struct LeafBridge*>& leafBridge,
+						       const vector<uint64_t>& seed);
+
+
+  /**
+     @brief Enables out-of-bag accumulation over subsequent chunks.
+   */
+  void initOOB(const struct SamplerBridge* samplerBridge);
+
+
+  /**
+     @return true iff out-of-bag estimates are being accumulated.
+   */
+  bool hasOOB() const;
+
+
+  /**
+     @brief Trains by gradient boosting rather than by bagging.
+
+     Trees are fit in sequence to the residuals of their predecessors,
+     so the session trains singly, regardless of blocking.
+
+     @param shrinkage is the learning rate, in (0, 1].
+   */
+  void initBoost(const struct SamplerBridge* samplerBridge,
+		 double shrinkage);
+
+
+  /**
+     @return out-of-bag error after each trained tree.
+   */
+  vector<double> getOOBCurve() const;
+
+
+  /**
+     @return out-of-bag error of the trained forest.
+   */
+  double getOOBError() const;
+
+
+  /**
+     @brief Passes through to TrainOOB method, if tracking.
+
+     @return true iff tracking and the error curve has levelled off.
+   */
+  bool oobPlateau(size_t window,
+		  double tolerance) const;
+
+
   /**
      @brief Registers training tree-block count.
 
      @param trainBlock_ is the number of trees by which to block.
+
+     @param treeThread is the number of trees to train concurrently.
+
+     @param levelSync is true iff a block's trees split in lockstep.
   */
-  static void initBlock(unsigned int trainBlock);
+  void initBlock(unsigned int trainBlock,
+		 unsigned int treeThread = 1,
+		 bool levelSync = false);
 
 
-  static void initProb(unsigned int predFixed,
-                       const vector<double> &predProb);
+  /**
+     @brief Registers predictor-sampling parameters.
+
+     @param predAlias is true iff weights are sampled by alias table.
+   */
+  void initProb(unsigned int predFixed,
+		const vector<double> &predProb,
+		bool predAlias = false);
 
   /**
      @brief Registers tree-shape parameters.
   */
-  static void initTree(size_t leafMax);
+  void initTree(size_t leafMax);
+
+
+  /**
+     @brief Prunes each trained tree to minimize impurity plus a
+     penalty per leaf.
+
+     @param pruneCost is the penalty, in units of split information;
+     zero disables pruning.
+  */
+  void initPrune(double pruneCost);
+
+
+  /**
+     @brief Bounds the memory held by restaging history.
+
+     Layers are flushed early, at the cost of restaging, to respect
+     the budget.
+
+     @param historyBudget is the budget in bytes, zero for unbounded.
+   */
+  void initHistory(size_t historyBudget);
+
+
+  /**
+     @brief Selects extremely-randomized splitting.
+
+     @param extraTrees is true iff each candidate evaluates a single
+     random cut, in place of a full scan.
+   */
+  void initExtraTrees(bool extraTrees);
+
 
   /**
      @brief Initializes static OMP thread state.
@@ -71,6 +307,14 @@ struct TrainBridge {
    */
   static void initOmp(unsigned int nThread);
 
+
+  /**
+     @brief Registers the absolute index of the leading tree.
+
+     @param treeOffset is nonzero when training a shard of a larger forest.
+   */
+  static void initStream(size_t treeOffset);
+
   
   /**
      @brief Registers parameters governing splitting.
@@ -83,10 +327,10 @@ struct TrainBridge {
      
      @param splitQuant is a per-predictor quantile specification.
   */
-  static void initSplit(unsigned int minNode,
-                        unsigned int totLevels,
-                        double minRatio,
-			const vector<double>& feSplitQuant);
+  void initSplit(unsigned int minNode,
+		 unsigned int totLevels,
+		 double minRatio,
+		 const vector<double>& feSplitQuant);
   
   /**
      @brief Registers monotone specifications for regression.
@@ -96,13 +340,73 @@ struct TrainBridge {
   */
   void initMono(const vector<double>& regMono);
 
+
+  /**
+     @brief Splits several regression responses jointly.
+
+     Splits maximize the reduction in squared error summed over the
+     responses.
+
+     @param yMulti holds each response over all training rows in turn.
+
+     @param nOut is the number of responses.
+   */
+  void initMulti(const vector<double>& yMulti,
+		 unsigned int nOut);
+
+
+  /**
+     @brief Quantizes numeric predictors for binned splitting.
+
+     @param nBin is the maximal bin count; zero splits exactly.
+   */
+  void initBin(unsigned int nBin);
+
+
+  /**
+     @brief Trains nodes of small extent as independent subtrees.
+
+     Such nodes are split depth-first on private copies of their
+     samples, rather than by traversing the tree-wide partition.
+
+     @param subtreeMax is the largest such extent, zero for none.
+   */
+  void initSubtree(size_t subtreeMax);
+
+
+  /**
+     @brief Bounds the cuts evaluated by a numeric scan.
+
+     Complements binning:  bins fix cut positions globally, while
+     these are taken per node.
+
+     @param nCut is the per-scan cut count; zero splits exactly.
+   */
+  void initSketch(unsigned int nCut);
+
+
+  /**
+     @brief Down-weights predictors unused by the leading trees.
+
+     @param screenTrees is the number of leading trees, zero denoting
+     no screen.
+
+     @param screenWeight scales the sampling weight of unused predictors.
+   */
+  void initScreen(unsigned int screenTrees,
+		  double screenWeight);
+
+
   /**
      @brief Static de-initializer.
    */
   static void deInit();
 
 private:
-  unique_ptr<class PredictorFrame> frame;
+  shared_ptr<class PredictorFrame> frame;
+  unique_ptr<struct TrainParam> param; // Session parameters.
+  unique_ptr<class TrainOOB> trainOOB; // Null unless tracking.
+  unique_ptr<class Booster> booster; // Null unless boosting.
 };
 
 
@@ -120,6 +424,12 @@ struct TrainedChunk {
   const vector<double>& getPredInfo() const;
 
 
+  /**
+     @return instrumentation accumulated over the chunk's trees.
+   */
+  const struct TrainStat& getTrainStat() const;
+
+
 private:
 
     unique_ptr<class Train> train;
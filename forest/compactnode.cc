@@ -0,0 +1,88 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file compactnode.cc
+
+   @brief Methods recoding forest nodes into compact form.
+
+   @author Mark Seligman
+ */
+
+#include "compactnode.h"
+#include "forest.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+unique_ptr<CompactForest> CompactForest::factory(const Forest* forest,
+						 PredictorT nPredNum,
+						 PredictorT nPredFac) {
+  unsigned int predBits = predWidth(nPredNum, nPredFac);
+  if (flagBits + predBits >= 32)
+    return nullptr;
+
+  size_t delSup = size_t(1) << (32 - flagBits - predBits);
+  for (auto & node : forest->getNode()) {
+    if (node.getDelIdx() >= delSup)
+      return nullptr;
+    if (node.isNonterminal() && node.getPredIdx() >= nPredNum && (node.isSparse() || node.getBitOffset() > UINT32_MAX))
+      return nullptr;
+  }
+
+  return make_unique<CompactForest>(forest, nPredNum, predBits);
+}
+
+
+unsigned int CompactForest::predWidth(PredictorT nPredNum,
+				      PredictorT nPredFac) {
+  PredictorT nBlock = max(nPredNum, nPredFac);
+  unsigned int width = 1;
+  while ((PredictorT(1) << width) < nBlock)
+    width++;
+  return width;
+}
+
+
+CompactForest::CompactForest(const Forest* forest,
+			     PredictorT nPredNum,
+			     unsigned int predBits_) :
+  predBits(predBits_),
+  predMask((uint32_t(1) << predBits) - 1) {
+  for (auto & node : forest->getNode()) {
+    CompactNode cn = {0, 0};
+    if (node.isNonterminal()) {
+      PredictorT predIdx = node.getPredIdx();
+      uint32_t flags;
+      PredictorT blockIdx;
+      if (predIdx >= nPredNum) {
+	flags = kindFactor;
+	blockIdx = predIdx - nPredNum;
+	cn.aux = node.getBitOffset();
+      }
+      else {
+	double split = node.getSplitNum();
+	float splitFloat = split;
+	blockIdx = predIdx;
+	if (static_cast<double>(splitFloat) == split) {
+	  flags = kindFloat;
+	  memcpy(&cn.aux, &splitFloat, sizeof(cn.aux));
+	}
+	else { // Lossless fallback.
+	  flags = kindExact;
+	  cn.aux = splitExact.size();
+	  splitExact.push_back(split);
+	}
+	if (node.advanceNum(nan("")) != node.getDelIdx())
+	  flags |= nanFalse;
+      }
+      cn.packed = (uint32_t(node.getDelIdx()) << (flagBits + predBits)) | (uint32_t(blockIdx) << flagBits) | flags;
+    }
+    compactNode.push_back(cn);
+  }
+}
@@ -0,0 +1,132 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file compactnode.h
+
+   @brief Eight-byte node encoding for walking trained forests.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_COMPACTNODE_H
+#define FOREST_COMPACTNODE_H
+
+#include "typeparam.h"
+#include "bv.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+/**
+   @brief Packs a split into a threshold word and a structure word.
+
+   The structure word holds, from low to high, a three-bit flag field,
+   the block-relative splitting predictor and the delta to the true
+   branch.  The threshold word holds a single-precision split value,
+   if exact, else an index into the table of double-precision values,
+   else, for factors, the split's starting bit offset.
+ */
+struct CompactNode {
+  uint32_t aux; // Threshold, table index or bit offset, per flags.
+  uint32_t packed; // Flags, predictor and delta.
+};
+
+
+/**
+   @brief Recodes a forest's node arena into CompactNode form.
+
+   Nodes parallel the arena, so terminal indices and leaf lookup are
+   unaffected.  Split values not representable in single precision are
+   retained at full precision in a side table, so that results are
+   identical to those of the DecNode walk.
+ */
+class CompactForest {
+  static constexpr unsigned int flagBits = 3;
+  static constexpr uint32_t kindMask = 3; // Low two flag bits.
+  static constexpr uint32_t kindFloat = 0; // Numeric, float threshold.
+  static constexpr uint32_t kindExact = 1; // Numeric, tabled threshold.
+  static constexpr uint32_t kindFactor = 2; // Factor, bit offset.
+  static constexpr uint32_t nanFalse = 4; // NaN takes the false branch.
+
+  const unsigned int predBits; // Width of predictor field.
+  const uint32_t predMask;
+  vector<CompactNode> compactNode; // Parallels the forest's node arena.
+  vector<double> splitExact; // Thresholds requiring double precision.
+
+  /**
+     @return width of predictor field sufficient for either block.
+   */
+  static unsigned int predWidth(PredictorT nPredNum,
+				PredictorT nPredFac);
+
+public:
+
+  CompactForest(const class Forest* forest,
+		PredictorT nPredNum,
+		unsigned int predBits_);
+
+
+  /**
+     @brief Recodes the forest if every delta fits its field.
+
+     @return encoding, or null if some tree is too large to represent.
+   */
+  static unique_ptr<CompactForest> factory(const class Forest* forest,
+					   PredictorT nPredNum,
+					   PredictorT nPredFac);
+
+
+  /**
+     @return base of encoded nodes for a tree.
+   */
+  const CompactNode* getTree(size_t origin) const {
+    return &compactNode[origin];
+  }
+
+
+  /**
+     @brief Mirrors DecNode::advanceNum() and advanceFactor().
+
+     @param rowNT, rowFT are the row's numeric and factor values.
+
+     @param bits are the tree's factor bits.
+
+     @return delta to next node, if nonterminal, else zero.
+   */
+  inline IndexT advance(const CompactNode& node,
+			const double rowNT[],
+			const CtgT rowFT[],
+			const BVSlotT bits[]) const {
+    IndexT delIdx = node.packed >> (flagBits + predBits);
+    if (delIdx == 0)
+      return 0;
+
+    PredictorT blockIdx = (node.packed >> flagBits) & predMask;
+    uint32_t kind = node.packed & kindMask;
+    if (kind == kindFactor) {
+      return delIdx + (BV::testBit(bits, node.aux + rowFT[blockIdx]) ? 0 : 1);
+    }
+
+    double split;
+    if (kind == kindFloat) {
+      float splitFloat;
+      memcpy(&splitFloat, &node.aux, sizeof(splitFloat));
+      split = splitFloat;
+    }
+    else {
+      split = splitExact[node.aux];
+    }
+    double val = rowNT[blockIdx];
+    return delIdx + ((val > split) | ((val != val) & ((node.packed & nanFalse) != 0)));
+  }
+};
+
+#endif
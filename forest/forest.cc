@@ -18,14 +18,142 @@
 #include "forest.h"
 #include "ompthread.h"
 
+#include <stdexcept>
 
-Forest::Forest(vector<vector<DecNode>> decNode_,
-	       vector<vector<double>> scores_,
+
+Forest::Forest(vector<size_t> nodeOrigin_,
+	       vector<DecNode> decNode_,
+	       vector<double> scores_,
 	       vector<unique_ptr<BV>> factorBits_) :
-  nTree(decNode_.size()),
+  nTree(nodeOrigin_.size()),
+  nodeOrigin(move(nodeOrigin_)),
   decNode(move(decNode_)),
   scores(move(scores_)),
-  factorBits(move(factorBits_)) {
+  bitOrigin(bitOrigins(factorBits_)),
+  bitPool(poolBits(factorBits_)),
+  factorBits(viewBits()) {
+}
+
+
+Forest::Forest(vector<size_t> nodeOrigin_,
+	       Arena<DecNode> decNode_,
+	       Arena<double> scores_,
+	       vector<size_t> bitOrigin_,
+	       Arena<BVSlotT> bitPool_) :
+  nTree(nodeOrigin_.size()),
+  nodeOrigin(move(nodeOrigin_)),
+  decNode(move(decNode_)),
+  scores(move(scores_)),
+  bitOrigin(move(bitOrigin_)),
+  bitPool(move(bitPool_)),
+  factorBits(viewBits()) {
+}
+
+
+unique_ptr<Forest> Forest::prefix(unsigned int nPrefix) const {
+  unsigned int nKeep = min(nPrefix, nTree);
+  size_t nodeEnd = nKeep < nTree ? nodeOrigin[nKeep] : decNode.size();
+  vector<unique_ptr<BV>> bitsKeep;
+  for (unsigned int tIdx = 0; tIdx < nKeep; tIdx++) {
+    bitsKeep.push_back(make_unique<BV>(vector<BVSlotT>(bitPool.begin() + bitOrigin[tIdx], bitPool.begin() + bitOrigin[tIdx + 1])));
+  }
+  return make_unique<Forest>(vector<size_t>(nodeOrigin.begin(), nodeOrigin.begin() + nKeep),
+			     vector<DecNode>(decNode.begin(), decNode.begin() + nodeEnd),
+			     vector<double>(scores.begin(), scores.begin() + nodeEnd),
+			     move(bitsKeep));
+}
+
+
+unique_ptr<Forest> Forest::select(const vector<unsigned int>& treeIdx) const {
+  vector<pair<const Forest*, unsigned int>> treeRef;
+  for (unsigned int tIdx : treeIdx) {
+    if (tIdx >= nTree) {
+      throw invalid_argument("Tree index out of range");
+    }
+    treeRef.emplace_back(this, tIdx);
+  }
+  return gather(treeRef);
+}
+
+
+unique_ptr<Forest> Forest::merge(const vector<const Forest*>& forests) {
+  vector<pair<const Forest*, unsigned int>> treeRef;
+  for (const Forest* forest : forests) {
+    for (unsigned int tIdx = 0; tIdx < forest->nTree; tIdx++) {
+      treeRef.emplace_back(forest, tIdx);
+    }
+  }
+  return gather(treeRef);
+}
+
+
+unique_ptr<Forest> Forest::gather(const vector<pair<const Forest*, unsigned int>>& treeRef) {
+  vector<size_t> nodeOriginOut;
+  vector<size_t> bitOriginOut;
+  size_t nodeTop = 0;
+  size_t slotTop = 0;
+  bitOriginOut.push_back(slotTop);
+  for (auto ref : treeRef) {
+    nodeOriginOut.push_back(nodeTop);
+    nodeTop += ref.first->getTreeHeight(ref.second);
+    slotTop += ref.first->bitOrigin[ref.second + 1] - ref.first->bitOrigin[ref.second];
+    bitOriginOut.push_back(slotTop);
+  }
+
+  vector<DecNode> nodeOut(nodeTop);
+  vector<double> scoreOut(nodeTop);
+  vector<BVSlotT> bitOut(slotTop);
+  OMPBound nOut = treeRef.size();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound outIdx = 0; outIdx < nOut; outIdx++) {
+    const Forest* forest = treeRef[outIdx].first;
+    unsigned int tIdx = treeRef[outIdx].second;
+    size_t nodeStart = forest->nodeOrigin[tIdx];
+    size_t nodeEnd = nodeStart + forest->getTreeHeight(tIdx);
+    copy(forest->decNode.begin() + nodeStart, forest->decNode.begin() + nodeEnd, nodeOut.begin() + nodeOriginOut[outIdx]);
+    copy(forest->scores.begin() + nodeStart, forest->scores.begin() + nodeEnd, scoreOut.begin() + nodeOriginOut[outIdx]);
+    copy(forest->bitPool.begin() + forest->bitOrigin[tIdx], forest->bitPool.begin() + forest->bitOrigin[tIdx + 1], bitOut.begin() + bitOriginOut[outIdx]);
+  }
+  }
+
+  return make_unique<Forest>(move(nodeOriginOut),
+			     Arena<DecNode>(move(nodeOut)),
+			     Arena<double>(move(scoreOut)),
+			     move(bitOriginOut),
+			     Arena<BVSlotT>(move(bitOut)));
+}
+
+
+vector<size_t> Forest::bitOrigins(const vector<unique_ptr<BV>>& treeBits) {
+  vector<size_t> origin;
+  size_t slotTop = 0;
+  origin.push_back(slotTop);
+  for (auto & bits : treeBits) {
+    slotTop += bits->getNSlot();
+    origin.push_back(slotTop);
+  }
+  return origin;
+}
+
+
+vector<BVSlotT> Forest::poolBits(const vector<unique_ptr<BV>>& treeBits) {
+  vector<BVSlotT> pool;
+  for (auto & bits : treeBits) {
+    vector<BVSlotT> slots = bits->dumpVec(0, bits->getNSlot());
+    pool.insert(pool.end(), slots.begin(), slots.end());
+  }
+  return pool;
+}
+
+
+vector<unique_ptr<BV>> Forest::viewBits() const {
+  vector<unique_ptr<BV>> views;
+  for (size_t tIdx = 0; tIdx + 1 < bitOrigin.size(); tIdx++) {
+    views.emplace_back(make_unique<BV>(bitPool.data() + bitOrigin[tIdx], bitOrigin[tIdx + 1] - bitOrigin[tIdx]));
+  }
+  return views;
 }
 
 
@@ -51,8 +179,8 @@ vector<size_t> Forest::produceHeight(const vector<size_t>& extents) const {
 
 size_t Forest::maxTreeHeight() const {
   size_t maxHeight = 0;
-  for (unsigned int tIdx = 0; tIdx < decNode.size(); tIdx++) {
-    maxHeight = max(maxHeight, decNode[tIdx].size());
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    maxHeight = max(maxHeight, static_cast<size_t>(getTreeHeight(tIdx)));
   }
   return maxHeight;
 }
@@ -69,52 +197,81 @@ void Forest::dump(vector<vector<PredictorT> >& predTree,
 void Forest::dump(vector<vector<PredictorT> >& pred,
                   vector<vector<double> >& split,
                   vector<vector<IndexT> >& delIdx) const {
-  for (unsigned int tIdx = 0; tIdx < decNode.size(); tIdx++) {
-    for (IndexT nodeIdx = 0; nodeIdx < decNode[tIdx].size(); nodeIdx++) {
-      pred[tIdx].push_back(decNode[tIdx][nodeIdx].getPredIdx());
-      delIdx[tIdx].push_back(decNode[tIdx][nodeIdx].getDelIdx());
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    const DecNode* tree = getTreeNode(tIdx);
+    for (IndexT nodeIdx = 0; nodeIdx < getTreeHeight(tIdx); nodeIdx++) {
+      pred[tIdx].push_back(tree[nodeIdx].getPredIdx());
+      delIdx[tIdx].push_back(tree[nodeIdx].getDelIdx());
 
       // N.B.:  split field must fit within a double.
-      split[tIdx].push_back(decNode[tIdx][nodeIdx].getSplitNum());
+      split[tIdx].push_back(tree[nodeIdx].getSplitNum());
+    }
+  }
+}
+
+
+void Forest::tabulate(PredictorT nPredNum,
+		      vector<PredictorT>& predIdx,
+		      vector<IndexT>& delIdx,
+		      vector<double>& split,
+		      vector<unsigned char>& invert) const {
+  predIdx.resize(decNode.size());
+  delIdx.resize(decNode.size());
+  split.resize(decNode.size());
+  invert.resize(decNode.size());
+
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    const DecNode* tree = getTreeNode(tIdx);
+    size_t origin = nodeOrigin[tIdx];
+    for (IndexT nodeIdx = 0; nodeIdx < getTreeHeight(tIdx); nodeIdx++) {
+      const DecNode& node = tree[nodeIdx];
+      size_t idx = origin + nodeIdx;
+      delIdx[idx] = node.getDelIdx();
+      invert[idx] = node.getInvert() ? 1 : 0;
+      if (node.isTerminal()) {
+	predIdx[idx] = node.getLeafIdx();
+	split[idx] = 0.0;
+      }
+      else {
+	predIdx[idx] = node.getPredIdx();
+	split[idx] = predIdx[idx] < nPredNum ? node.getSplitNum() : node.getCritVal();
+      }
     }
   }
+  }
 }
 
 
 vector<IndexT> Forest::getLeafNodes(unsigned int tIdx,
 				    IndexT extent) const {
   vector<IndexT> leafIndices(extent);
-  IndexT nodeIdx = 0;
+  const DecNode* tree = getTreeNode(tIdx);
   IndexT leavesSeen = 0;
-  for (auto node : decNode[tIdx]) {
+  for (IndexT nodeIdx = 0; nodeIdx < getTreeHeight(tIdx); nodeIdx++) {
     IndexT leafIdx;
-    if (node.getLeafIdx(leafIdx)) {
+    if (tree[nodeIdx].getLeafIdx(leafIdx)) {
       leafIndices[leafIdx] = nodeIdx;
       leavesSeen++;
     }
-    nodeIdx++;
   }
 
   return leafIndices;
 }
 
 
-vector<vector<IndexRange>> Forest::leafDominators() const {
-  vector<vector<IndexRange>> leafDom(nTree);
-  
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    leafDom[tIdx] = leafDominators(decNode[tIdx]);
-  }
-  }
-  return leafDom;
+const ForestIndex& Forest::getIndex() const {
+  call_once(indexOnce, [this]() {
+    forestIndex = make_unique<ForestIndex>(this);
+  });
+  return *forestIndex;
 }
-  
-  
-vector<IndexRange> Forest::leafDominators(const vector<DecNode>& tree) {
-  IndexT height = tree.size();
+
+
+vector<IndexRange> Forest::leafDominators(const DecNode tree[],
+					  IndexT height) {
   // Gives each node the offset of its predecessor.
   vector<IndexT> delPred(height);
   for (IndexT i = 0; i < height; i++) {
@@ -20,7 +20,10 @@
 #include "decnode.h"
 #include "bv.h"
 #include "typeparam.h"
+#include "arena.h"
+#include "forestindex.h"
 
+#include <mutex>
 #include <numeric>
 #include <vector>
 #include <complex>
@@ -35,9 +38,21 @@ class NodeCresc {
 public:
 
 
+  /**
+     @brief Reserves space for nodes yet to be consumed.
+
+     @param nodeBound bounds the number of nodes to be appended.
+   */
+  void reserve(size_t nodeBound,
+	       unsigned int nTree) {
+    treeNode.reserve(treeNode.size() + nodeBound);
+    extents.reserve(extents.size() + nTree);
+  }
+
+
   void consumeNodes(const vector<DecNode>& nodes,
 		    IndexT height) {
-    copy(nodes.begin(), nodes.begin() + height, back_inserter(treeNode));
+    treeNode.insert(treeNode.end(), nodes.begin(), nodes.begin() + height);
     extents.push_back(height);
   }
 
@@ -45,6 +60,11 @@ public:
   const vector<size_t>& getExtents() const {
     return extents;
   }
+
+
+  const vector<DecNode>& getNodes() const {
+    return treeNode;
+  }
   
 
   void dump(complex<double> nodeComplex[]) const {
@@ -57,11 +77,14 @@ public:
   /**
      @brief Tree-level dispatch to low-level member.
 
-     Parameters as with low-level implementation.
+     @param nodeStart, nodeEnd delimit the nodes of a single tree, so
+     that distinct trees update concurrently.
   */
-  void splitUpdate(const class PredictorFrame* frame) {
-    for (auto & tn : treeNode) {
-      tn.setQuantRank(frame);
+  void splitUpdate(const class PredictorFrame* frame,
+		   size_t nodeStart,
+		   size_t nodeEnd) {
+    for (size_t nodeIdx = nodeStart; nodeIdx != nodeEnd; nodeIdx++) {
+      treeNode[nodeIdx].setQuantRank(frame);
     }
   }
 };
@@ -92,6 +115,11 @@ public:
   const vector<size_t>& getExtents() const {
     return extents;
   }
+
+
+  const vector<BVSlotT>& getSplitBits() const {
+    return splitBits;
+  }
   
 
   size_t getFactorBytes() const {
@@ -142,9 +170,14 @@ public:
 */
 class Forest {
   const unsigned int nTree;
-  const vector<vector<DecNode>> decNode;
-  const vector<vector<double>> scores; // " "
-  const vector<unique_ptr<BV>> factorBits;
+  const vector<size_t> nodeOrigin; // Per-tree offsets into node arena.
+  const Arena<DecNode> decNode; // Forest-wide node arena.
+  const Arena<double> scores; // Accessed as decNode.
+  const vector<size_t> bitOrigin; // Per-tree slot offsets into pool, plus sup.
+  const Arena<BVSlotT> bitPool; // Forest-wide factor-split bits.
+  const vector<unique_ptr<BV>> factorBits; // Per-tree views into pool.
+  mutable once_flag indexOnce; // Guards lazy index build.
+  mutable unique_ptr<ForestIndex> forestIndex; // Derived metadata, once built.
 
   // Crescent data structures:  training only.
   unique_ptr<NodeCresc> nodeCresc; // Crescent node block.
@@ -156,6 +189,35 @@ class Forest {
   void dump(vector<vector<PredictorT>>& predTree,
             vector<vector<double>>& splitTree,
             vector<vector<IndexT>>& lhDelTree) const;
+
+
+  /**
+     @return cumulative slot offsets of the per-tree bit vectors.
+   */
+  static vector<size_t> bitOrigins(const vector<unique_ptr<BV>>& treeBits);
+
+
+  /**
+     @brief Agglomerates the per-tree bit vectors into a single pool.
+   */
+  static vector<BVSlotT> poolBits(const vector<unique_ptr<BV>>& treeBits);
+
+
+  /**
+     @brief Wraps per-tree views of the bit pool.
+   */
+  vector<unique_ptr<BV>> viewBits() const;
+
+
+  /**
+     @brief Copies an arbitrary sequence of trees into a standalone forest.
+
+     Node deltas and factor-bit offsets are tree-relative, so only the
+     per-tree origins require remapping.
+
+     @param treeRef pairs each output tree with its source forest and index.
+   */
+  static unique_ptr<Forest> gather(const vector<pair<const Forest*, unsigned int>>& treeRef);
   
  public:
 
@@ -180,13 +242,64 @@ class Forest {
 
   
   /**
-     Post-training constructor.
+     @brief Post-training constructor.
+
+     @param nodeOrigin_ are the per-tree starting offsets into the arenas.
+
+     @param decNode_ is the forest-wide node arena.
+
+     @param scores_ are the forest-wide scores, indexed as nodes.
    */
-  Forest(const vector<vector<DecNode>> decNode_,
-	 vector<vector<double>> scores_,
+  Forest(vector<size_t> nodeOrigin_,
+	 vector<DecNode> decNode_,
+	 vector<double> scores_,
 	 vector<unique_ptr<BV>> factorBits_);
 
 
+  /**
+     @brief Post-training constructor from flattened arenas.
+
+     Arenas may alias external storage, such as a mapped model file.
+
+     @param bitOrigin_ are the per-tree slot offsets into the bit pool, plus sup.
+   */
+  Forest(vector<size_t> nodeOrigin_,
+	 Arena<DecNode> decNode_,
+	 Arena<double> scores_,
+	 vector<size_t> bitOrigin_,
+	 Arena<BVSlotT> bitPool_);
+
+
+  /**
+     @brief Copies the leading trees into a standalone forest.
+
+     Trees are trained independently, so any prefix is itself a forest.
+
+     @param nPrefix is the number of trees retained, clamped to 'nTree'.
+
+     @return forest consisting of the first 'nPrefix' trees.
+   */
+  unique_ptr<Forest> prefix(unsigned int nPrefix) const;
+
+
+  /**
+     @brief Copies a subset of trees, in the order specified.
+
+     @param treeIdx are the source indices, possibly repeated.
+
+     @return forest consisting of the trees selected.
+   */
+  unique_ptr<Forest> select(const vector<unsigned int>& treeIdx) const;
+
+
+  /**
+     @brief Concatenates forests trained independently over a common frame.
+
+     @return forest consisting of each forest's trees, in order.
+   */
+  static unique_ptr<Forest> merge(const vector<const Forest*>& forests);
+
+
   const vector<size_t>& getFacExtents() const {
     return fbCresc->getExtents();
   }
@@ -229,31 +342,74 @@ class Forest {
   }
 
   /**
-     @brief Getter for node record vector.
+     @brief Getter for forest-wide node arena.
 
-     @return reference to node vector.
+     @return reference to node arena.
    */
-  const vector<vector<DecNode>>& getNode() const {
+  const Arena<DecNode>& getNode() const {
     return decNode;
   }
 
 
+  /**
+     @brief Getter for per-tree arena offsets.
+   */
+  const vector<size_t>& getNodeOrigin() const {
+    return nodeOrigin;
+  }
+
+
+  /**
+     @return base of node block for a given tree.
+   */
+  inline const DecNode* getTreeNode(unsigned int tIdx) const {
+    return &decNode[nodeOrigin[tIdx]];
+  }
+
+
+  /**
+     @return number of nodes in a given tree.
+   */
+  inline IndexT getTreeHeight(unsigned int tIdx) const {
+    return (tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : decNode.size()) - nodeOrigin[tIdx];
+  }
+
+
   /**
      @return vector of domininated leaf ranges, per node.
    */
-  static vector<IndexRange> leafDominators(const vector<DecNode>& tree);
+  static vector<IndexRange> leafDominators(const DecNode tree[],
+					   IndexT height);
 
 
   /**
-     @brief Computes a vector of leaf dominators for every tree.
-   */  
-  vector<vector<IndexRange>> leafDominators() const;
+     @brief Obtains the derived metadata, building on first request.
+
+     @return index shared by all consumers of this forest.
+   */
+  const ForestIndex& getIndex() const;
 
 
   inline const vector<unique_ptr<BV>>& getFactorBits() const {
     return factorBits;
   }
 
+
+  /**
+     @return base of the forest-wide factor bit pool, possibly null.
+   */
+  inline const BVSlotT* getBitPool() const {
+    return bitPool.data();
+  }
+
+
+  /**
+     @return per-tree slot offsets into the bit pool.
+   */
+  inline const vector<size_t>& getBitOrigin() const {
+    return bitOrigin;
+  }
+
   
   /**
      @brief Obtains node count from score vector.
@@ -274,11 +430,39 @@ class Forest {
   }
 
 
+  /**
+     @return crescent nodes, in native layout.
+   */
+  const vector<DecNode>& getNodeCresc() const {
+    return nodeCresc->getNodes();
+  }
+
+
+  /**
+     @return crescent factor-split bits, in native layout.
+   */
+  const vector<BVSlotT>& getSplitBitsCresc() const {
+    return fbCresc->getSplitBits();
+  }
+
+
+  /**
+     @brief Reserves crescent space for a chunk of trees.
+
+     @param nodeBound bounds the chunk's total node count.
+   */
+  void reserve(size_t nodeBound,
+	       unsigned int nTree) {
+    nodeCresc->reserve(nodeBound, nTree);
+    scoresCresc.reserve(scoresCresc.size() + nodeBound);
+  }
+
+
   void consumeTree(const vector<DecNode>& nodes,
 		   const vector<double>& scores_) {
     IndexT height = nodes.size();
     nodeCresc->consumeNodes(nodes, height);
-    copy(scores_.begin(), scores_.begin() + height, back_inserter(scoresCresc));
+    scoresCresc.insert(scoresCresc.end(), scores_.begin(), scores_.begin() + height);
   }
 
 
@@ -297,12 +481,16 @@ class Forest {
 
 
   /**
-     @brief Post-pass to update numerical splitting values from ranks.
+     @brief Updates a tree's numerical splitting values from ranks.
 
-     @param summaryFrame records the predictor types.
+     @param frame records the predictor types.
+
+     @param nodeStart, nodeEnd delimit the tree's crescent nodes.
   */
-  void splitUpdate(const class PredictorFrame* frame) {
-    nodeCresc->splitUpdate(frame);
+  void splitUpdate(const class PredictorFrame* frame,
+		   size_t nodeStart,
+		   size_t nodeEnd) {
+    nodeCresc->splitUpdate(frame, nodeStart, nodeEnd);
   }
 
   
@@ -331,15 +519,68 @@ class Forest {
    */
   size_t maxTreeHeight() const;
 
+
+  /**
+     @brief Indexes the trees splitting on each predictor.
+
+     @param nPred is the number of predictors.
+
+     @return increasing tree indices, per predictor.
+   */
+  vector<vector<unsigned int>> splitTrees(PredictorT nPred) const {
+    return getIndex().splitTrees(nPred);
+  }
+
+
+  /**
+     @brief Flags the predictors split by some tree.
+
+     @param nPred is the number of predictors.
+
+     @return nonzero iff split, per predictor.
+   */
+  vector<unsigned char> splitMask(PredictorT nPred) const {
+    return getIndex().splitMask(nPred);
+  }
+
   
   /**
-     @return per-tree vector of scores.
+     @return forest-wide score vector, indexed as node arena.
    */
-  const vector<vector<double>>& getTreeScores() const {
+  const Arena<double>& getTreeScores() const {
     return scores;
   }
 
 
+  /**
+     @brief Tabulates the node fields as forest-wide columns.
+
+     Columns are indexed as the node arena.  Trees are written
+     independently, in parallel.
+
+     @param nPredNum is the number of numeric predictors, which precede
+     the factors in core indexing.
+
+     @param[out] predIdx outputs the splitting predictor, or the leaf
+     index iff terminal.
+
+     @param[out] delIdx outputs the delta to the true branch, zero iff
+     terminal.
+
+     @param[out] split outputs the numeric cut, or the tree-relative bit
+     offset iff splitting on a factor.  Offsets of level lists retain
+     the Crit::sparseBit flag.
+
+     @param[out] invert outputs nonzero iff missing values take the true
+     branch.
+   */
+  void tabulate(PredictorT nPredNum,
+		vector<PredictorT>& predIdx,
+		vector<IndexT>& delIdx,
+		vector<double>& split,
+		vector<unsigned char>& invert) const;
+
+
   /**
      @brief Dumps forest-wide structure fields as per-tree vectors.
      
@@ -0,0 +1,100 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestcompile.cc
+
+   @brief Methods for emitting a trained forest as C++ source.
+
+   @author Mark Seligman
+ */
+
+#include "forestcompile.h"
+#include "forest.h"
+#include "bv.h"
+
+#include <iomanip>
+#include <limits>
+
+const string ForestCompile::entryName = "arboristWalk";
+
+
+string ForestCompile::emit(const Forest* forest,
+			   PredictorT nPredNum) {
+  ostringstream out;
+  out << setprecision(numeric_limits<double>::max_digits10);
+  out << "// Generated from an Arborist forest of " << forest->getNTree() << " trees." << endl;
+  out << "// Do not edit." << endl << endl;
+
+  for (unsigned int tIdx = 0; tIdx < forest->getNTree(); tIdx++) {
+    emitTree(forest, tIdx, nPredNum, out);
+  }
+
+  out << "extern \"C\" void " << entryName << "(const double rowNum[], const unsigned int rowFac[], unsigned int nodeOut[]) {" << endl;
+  for (unsigned int tIdx = 0; tIdx < forest->getNTree(); tIdx++) {
+    out << "  nodeOut[" << tIdx << "] = walk" << tIdx << "(rowNum, rowFac);" << endl;
+  }
+  out << "}" << endl;
+
+  return out.str();
+}
+
+
+void ForestCompile::emitTree(const Forest* forest,
+			     unsigned int tIdx,
+			     PredictorT nPredNum,
+			     ostringstream& out) {
+  const DecNode* tree = forest->getTreeNode(tIdx);
+  IndexT height = forest->getTreeHeight(tIdx);
+  const vector<unique_ptr<BV>>& factorBits = forest->getFactorBits();
+  size_t nSlot = factorBits.empty() ? 0 : factorBits[tIdx]->getNSlot();
+  if (nSlot > 0) {
+    vector<BVSlotT> slots = factorBits[tIdx]->dumpVec(0, nSlot);
+    out << "static const unsigned long long bits" << tIdx << "[] = {";
+    for (size_t slot = 0; slot < nSlot; slot++) {
+      out << (slot == 0 ? "" : ", ") << slots[slot] << "ull";
+    }
+    out << "};" << endl;
+  }
+
+  out << "static unsigned int walk" << tIdx << "(const double rowNum[], const unsigned int rowFac[]) {" << endl;
+  for (IndexT nodeIdx = 0; nodeIdx < height; nodeIdx++) {
+    const DecNode& node = tree[nodeIdx];
+    if (nodeIdx != 0) {
+      out << " n" << nodeIdx << ":" << endl;
+    }
+    if (node.isTerminal()) {
+      out << "  return " << nodeIdx << ";" << endl;
+      continue;
+    }
+
+    PredictorT predIdx = node.getPredIdx();
+    if (predIdx < nPredNum) {
+      // N.B.:  NaN takes the true branch iff the node is inverted.
+      bool nanTrue = node.advanceNum(numeric_limits<double>::quiet_NaN()) == node.getDelIdx();
+      out << "  if (" << (nanTrue ? "!(" : "") << "rowNum[" << predIdx << "]" << (nanTrue ? " > " : " <= ") << node.getSplitNum() << (nanTrue ? ")" : "") << ")";
+    }
+    else if (node.isSparse()) { // Level lists become case labels.
+      const BV* bits = factorBits[tIdx].get();
+      size_t listSlot = node.getBitOffset() / BV::getSlotElts();
+      IndexT idxTrue = nodeIdx + node.getDelIdx();
+      out << "  switch (rowFac[" << predIdx - nPredNum << "]) {";
+      for (size_t slot = listSlot + 1; slot <= listSlot + bits->getSlot(listSlot); slot++) {
+	out << " case " << bits->getSlot(slot) << "u:";
+      }
+      out << " goto n" << idxTrue << "; } goto n" << idxTrue + 1 << ";" << endl;
+      continue;
+    }
+    else {
+      size_t bitOffset = node.getBitOffset();
+      out << "  if ((bits" << tIdx << "[(" << bitOffset << "u + rowFac[" << predIdx - nPredNum << "]) / " << BV::getSlotElts() << "] >> ((" << bitOffset << "u + rowFac[" << predIdx - nPredNum << "]) % " << BV::getSlotElts() << ")) & 1ull)";
+    }
+    IndexT idxTrue = nodeIdx + node.getDelIdx();
+    out << " goto n" << idxTrue << "; goto n" << idxTrue + 1 << ";" << endl;
+  }
+  out << "}" << endl << endl;
+}
@@ -0,0 +1,66 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestcompile.h
+
+   @brief Emits a trained forest as C++ source.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_FORESTCOMPILE_H
+#define FOREST_FORESTCOMPILE_H
+
+#include "typeparam.h"
+
+#include <sstream>
+#include <string>
+using namespace std;
+
+
+/**
+   @brief Generates one function per tree, with splitting values and
+   factor bits inlined as constants.
+
+   The emitted entry has C linkage and the signature of
+   Predict::CompiledWalk:
+
+     void arboristWalk(const double rowNum[],
+                       const unsigned int rowFac[],
+                       unsigned int nodeOut[]);
+
+   'rowNum' and 'rowFac' are the transposed numeric and factor blocks of
+   a single row, as walked by Predict.  'nodeOut' receives the
+   tree-relative terminal index reached in each tree.
+ */
+struct ForestCompile {
+  static const string entryName; // Name of the emitted walker.
+
+  /**
+     @brief Emits complete, self-contained source for the forest.
+
+     @param nPredNum is the number of numeric predictors, which precede
+     factors in core ordering.
+
+     @return source text.
+   */
+  static string emit(const class Forest* forest,
+		     PredictorT nPredNum);
+
+private:
+
+  /**
+     @brief Emits the walker for a single tree.
+   */
+  static void emitTree(const class Forest* forest,
+		       unsigned int tIdx,
+		       PredictorT nPredNum,
+		       ostringstream& out);
+};
+
+#endif
@@ -0,0 +1,98 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestdag.cc
+
+   @brief Methods identifying and pooling equal subtrees.
+
+   @author Mark Seligman
+ */
+
+#include "forestdag.h"
+#include "forest.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+
+namespace {
+  typedef array<uint64_t, 5> DagKey; // Kind, split and successors.
+
+  struct DagHash {
+    size_t operator()(const DagKey& key) const {
+      uint64_t hash = 0;
+      for (auto word : key) {
+	hash = (hash ^ word) * 0x100000001b3ull;
+	hash ^= hash >> 29;
+      }
+      return hash;
+    }
+  };
+
+  uint64_t valBits(double val) {
+    val += 0.0; // Identifies negative zero with zero.
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return bits;
+  }
+}
+
+
+unique_ptr<ForestDag> ForestDag::factory(const Forest* forest,
+					 PredictorT nPredNum) {
+  auto forestDag = make_unique<ForestDag>(forest, nPredNum);
+  if (forestDag->pool.size() * (sizeof(DagNode) + sizeof(double)) >= forest->getNode().size() * (sizeof(DecNode) + sizeof(double)))
+    return nullptr;
+
+  return forestDag;
+}
+
+
+ForestDag::ForestDag(const Forest* forest,
+		     PredictorT nPredNum_) :
+  nPredNum(nPredNum_),
+  treeRoot(vector<IndexT>(forest->getNTree())) {
+  const Arena<double>& treeScore = forest->getTreeScores();
+  unordered_map<DagKey, IndexT, DagHash> poolMap;
+  for (unsigned int tIdx = 0; tIdx < forest->getNTree(); tIdx++) {
+    const DecNode* treeNode = forest->getTreeNode(tIdx);
+    size_t nodeOrigin = forest->getNodeOrigin()[tIdx];
+    vector<IndexT> poolIdx(forest->getTreeHeight(tIdx));
+    // Successors follow their predecessor, so a reverse pass suffices.
+    for (IndexT nodeIdx = poolIdx.size(); nodeIdx-- > 0; ) {
+      const DecNode& node = treeNode[nodeIdx];
+      DagNode dagNode = {node, {0, 0}};
+      DagKey key;
+      if (node.isTerminal()) {
+	key = {0, valBits(treeScore[nodeOrigin + nodeIdx]), 0, 0, 0};
+      }
+      else {
+	IndexT delIdx = node.getDelIdx();
+	dagNode.succ[0] = poolIdx[nodeIdx + delIdx];
+	dagNode.succ[1] = poolIdx[nodeIdx + delIdx + 1];
+	dagNode.node.setDelIdx(1);
+	PredictorT predIdx = node.getPredIdx();
+	if (predIdx < nPredNum) {
+	  key = {1, predIdx | (uint64_t(node.getInvert()) << 32), valBits(node.getSplitNum()), dagNode.succ[0], dagNode.succ[1]};
+	}
+	else { // Bit offsets are tree-relative.
+	  key = {2, predIdx | (uint64_t(tIdx) << 32), uint64_t(node.getBitOffset()), dagNode.succ[0], dagNode.succ[1]};
+	}
+      }
+      auto found = poolMap.emplace(key, pool.size());
+      if (found.second) {
+	pool.push_back(dagNode);
+	score.push_back(node.isTerminal() ? treeScore[nodeOrigin + nodeIdx] : 0.0);
+      }
+      poolIdx[nodeIdx] = found.first->second;
+    }
+    treeRoot[tIdx] = poolIdx[0];
+  }
+}
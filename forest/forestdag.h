@@ -0,0 +1,110 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestdag.h
+
+   @brief Shares identical subtrees of a trained forest among trees.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_FORESTDAG_H
+#define FOREST_FORESTDAG_H
+
+#include "typeparam.h"
+#include "decnode.h"
+#include "bv.h"
+
+#include <memory>
+#include <vector>
+
+
+/**
+   @brief Pool entry, addressing its successors absolutely.
+ */
+struct DagNode {
+  DecNode node; // Delta normalized to unity iff nonterminal.
+  IndexT succ[2]; // Pool indices of the successors at offsets zero and one.
+};
+
+
+/**
+   @brief Recodes a forest's trees as a directed acyclic graph over a
+   single pool of distinct subtrees.
+
+   Subtrees are identified bottom-up by their split and the pool
+   indices of their successors, terminals by their score, so that
+   equal subtrees occurring within or across trees are stored once.
+   Factor splits are identified by their tree-relative bit offset, so
+   are shared only within a tree.
+
+   Terminals in the pool no longer identify a tree's leaf, so the walk
+   supports scoring only.
+ */
+class ForestDag {
+  const PredictorT nPredNum; // Numeric predictors precede factors.
+  vector<DagNode> pool; // Distinct subtrees, successors preceding.
+  vector<double> score; // Terminal scores, parallel to pool.
+  vector<IndexT> treeRoot; // Pool index of each tree's root.
+
+public:
+
+  ForestDag(const class Forest* forest,
+	    PredictorT nPredNum_);
+
+
+  /**
+     @brief Builds the pool if it is smaller than the node arena.
+
+     @return shared encoding, or null if sharing saves no space.
+   */
+  static unique_ptr<ForestDag> factory(const class Forest* forest,
+				       PredictorT nPredNum);
+
+
+  /**
+     @return number of distinct subtrees.
+   */
+  size_t getPoolSize() const {
+    return pool.size();
+  }
+
+
+  /**
+     @return score of a pooled terminal.
+   */
+  inline double getScore(IndexT poolIdx) const {
+    return score[poolIdx];
+  }
+
+
+  /**
+     @brief Walks a tree from its root.
+
+     @param rowNT, rowFT are the row's numeric and factor values.
+
+     @param bits are the tree's factor bits.
+
+     @return pool index of the terminal reached.
+   */
+  inline IndexT walk(unsigned int tIdx,
+		     const double rowNT[],
+		     const CtgT rowFT[],
+		     const BVSlotT bits[]) const {
+    IndexT poolIdx = treeRoot[tIdx];
+    while (pool[poolIdx].node.isNonterminal()) {
+      const DagNode& dagNode = pool[poolIdx];
+      PredictorT predIdx = dagNode.node.getPredIdx();
+      IndexT delIdx = predIdx < nPredNum ? dagNode.node.advanceNum(rowNT[predIdx]) : dagNode.node.advanceFactor(bits, rowFT[predIdx - nPredNum]);
+      poolIdx = dagNode.succ[delIdx - 1];
+    }
+    return poolIdx;
+  }
+};
+
+#endif
@@ -0,0 +1,142 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestindex.cc
+
+   @brief Derived per-node and per-predictor metadata, cached by forest.
+
+   @author Mark Seligman
+ */
+
+#include "forestindex.h"
+#include "forest.h"
+#include "leaf.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+const vector<vector<IndexRange>> ForestIndex::noDom;
+
+
+ForestIndex::ForestIndex(const Forest* forest_) :
+  forest(forest_),
+  nTree(forest->getNTree()),
+  nPred(splitPredSup(forest)),
+  leafDom(nTree),
+  splitNode(nPred),
+  splitTree(nPred),
+  coverLeaf(nullptr) {
+  vector<vector<pair<PredictorT, IndexT>>> treeSplit(nTree); // Per tree.
+  OMPBound treeEnd = nTree;
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+    const DecNode* tree = forest->getTreeNode(tIdx);
+    IndexT height = forest->getTreeHeight(tIdx);
+    leafDom[tIdx] = Forest::leafDominators(tree, height);
+    for (IndexT nodeIdx = 0; nodeIdx < height; nodeIdx++) {
+      if (!tree[nodeIdx].isTerminal())
+	treeSplit[tIdx].emplace_back(tree[nodeIdx].getPredIdx(), nodeIdx);
+    }
+  }
+  }
+
+  // Merged in tree order, so that lists are increasing.
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    for (const auto& split : treeSplit[tIdx]) {
+      PredictorT predIdx = split.first;
+      splitNode[predIdx].push_back(SplitRef{tIdx, split.second});
+      if (splitTree[predIdx].empty() || splitTree[predIdx].back() != tIdx)
+	splitTree[predIdx].push_back(tIdx);
+    }
+  }
+}
+
+
+PredictorT ForestIndex::splitPredSup(const Forest* forest) {
+  PredictorT predSup = 0;
+  for (const DecNode& node : forest->getNode()) {
+    if (!node.isTerminal())
+      predSup = max(predSup, static_cast<PredictorT>(node.getPredIdx() + 1));
+  }
+  return predSup;
+}
+
+
+const vector<SplitRef>& ForestIndex::getSplitNode(PredictorT predIdx) const {
+  static const vector<SplitRef> empty;
+  return predIdx < nPred ? splitNode[predIdx] : empty;
+}
+
+
+const vector<unsigned int>& ForestIndex::getSplitTree(PredictorT predIdx) const {
+  static const vector<unsigned int> empty;
+  return predIdx < nPred ? splitTree[predIdx] : empty;
+}
+
+
+vector<vector<unsigned int>> ForestIndex::splitTrees(PredictorT nPredOut) const {
+  vector<vector<unsigned int>> predTrees(nPredOut);
+  for (PredictorT predIdx = 0; predIdx < min(nPred, nPredOut); predIdx++) {
+    predTrees[predIdx] = splitTree[predIdx];
+  }
+  return predTrees;
+}
+
+
+vector<unsigned char> ForestIndex::splitMask(PredictorT nPredOut) const {
+  vector<unsigned char> predSplit(nPredOut);
+  for (PredictorT predIdx = 0; predIdx < min(nPred, nPredOut); predIdx++) {
+    predSplit[predIdx] = splitTree[predIdx].empty() ? 0 : 1;
+  }
+  return predSplit;
+}
+
+
+const vector<double>& ForestIndex::getCover(const Leaf* leaf) const {
+  lock_guard<mutex> guard(coverLock);
+  if (leaf != coverLeaf) {
+    setCover(leaf);
+    coverLeaf = leaf;
+  }
+  return cover;
+}
+
+
+void ForestIndex::setCover(const Leaf* leaf) const {
+  if (leaf->isThin())
+    throw invalid_argument("Node cover requires leaf extents:  train without thinning");
+  const vector<size_t>& treeOrigin = leaf->getTreeOrigin();
+  if (treeOrigin.size() < nTree + 1)
+    throw invalid_argument("Leaf extents do not match forest");
+
+  cover = vector<double>(forest->getNode().size());
+  OMPBound treeEnd = nTree;
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+    const DecNode* tree = forest->getTreeNode(tIdx);
+    double* treeCover = &cover[forest->getNodeOrigin()[tIdx]];
+    // Successors lie above their predecessor, so reverse order sums upward.
+    for (IndexT nodeIdx = forest->getTreeHeight(tIdx); nodeIdx-- > 0; ) {
+      const DecNode& node = tree[nodeIdx];
+      if (node.isTerminal()) {
+	treeCover[nodeIdx] = leaf->getExtent(treeOrigin[tIdx] + node.getLeafIdx());
+      }
+      else {
+	IndexT trueIdx = nodeIdx + node.getDelIdx();
+	treeCover[nodeIdx] = treeCover[trueIdx] + treeCover[trueIdx + 1];
+      }
+    }
+  }
+  }
+}
@@ -0,0 +1,121 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestindex.h
+
+   @brief Derived per-node and per-predictor metadata, cached by forest.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_FORESTINDEX_H
+#define FOREST_FORESTINDEX_H
+
+#include "typeparam.h"
+
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Identifies a nonterminal by tree and tree-relative node index.
+ */
+struct SplitRef {
+  unsigned int tIdx;
+  IndexT nodeIdx;
+};
+
+
+/**
+   @brief Metadata derived from the node arena alone, shared by
+   consumers such as selective permutation, quantile trapping,
+   QuickScorer, partial dependence and attribution.
+
+   Built once, in parallel over trees, upon the forest's first
+   request.  Node cover additionally depends upon leaf extents, so is
+   built upon first request with a given leaf.
+ */
+class ForestIndex {
+  const class Forest* forest;
+  const unsigned int nTree;
+  const PredictorT nPred; ///> One beyond the highest predictor split.
+  vector<vector<IndexRange>> leafDom; ///> Dominated leaves, per tree, per node.
+  vector<vector<SplitRef>> splitNode; ///> Nonterminals, in forest order, per predictor.
+  vector<vector<unsigned int>> splitTree; ///> Increasing trees, per predictor.
+
+  mutable mutex coverLock; ///> Guards lazy cover build.
+  mutable const struct Leaf* coverLeaf; ///> Leaf of most recent cover build.
+  mutable vector<double> cover; ///> Sample counts, per forest-wide node.
+
+  /**
+     @return one beyond the highest predictor split by any tree.
+   */
+  static PredictorT splitPredSup(const class Forest* forest);
+
+  /**
+     @brief Accumulates leaf extents upward through each tree.
+   */
+  void setCover(const struct Leaf* leaf) const;
+
+public:
+
+  static const vector<vector<IndexRange>> noDom; ///> Stands in when not trapping.
+
+
+  ForestIndex(const class Forest* forest_);
+
+
+  /**
+     @return vector of dominated leaf ranges, per tree, per node.
+   */
+  const vector<vector<IndexRange>>& getLeafDom() const {
+    return leafDom;
+  }
+
+
+  /**
+     @return nonterminals splitting on a predictor, in forest order.
+   */
+  const vector<SplitRef>& getSplitNode(PredictorT predIdx) const;
+
+
+  /**
+     @return increasing indices of trees splitting on a predictor.
+   */
+  const vector<unsigned int>& getSplitTree(PredictorT predIdx) const;
+
+
+  /**
+     @brief Indexes the trees splitting on each of a number of predictors.
+
+     @return increasing tree indices, per predictor.
+   */
+  vector<vector<unsigned int>> splitTrees(PredictorT nPredOut) const;
+
+
+  /**
+     @brief Flags the predictors split by some tree.
+
+     @return nonzero iff split, per predictor.
+   */
+  vector<unsigned char> splitMask(PredictorT nPredOut) const;
+
+
+  /**
+     @brief Obtains node training cover, building as needed.
+
+     @param leaf supplies the extents, which must not be thinned.
+
+     @return forest-wide sample counts, indexed as the node arena.
+   */
+  const vector<double>& getCover(const struct Leaf* leaf) const;
+};
+
+#endif
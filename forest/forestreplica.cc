@@ -0,0 +1,44 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestreplica.cc
+
+   @brief Methods building per-socket forest copies.
+
+   @author Mark Seligman
+ */
+
+#include "forestreplica.h"
+#include "forest.h"
+
+
+ForestReplica::ForestReplica(const Forest* forest,
+			     unsigned int nReplica_) :
+  nReplica(nReplica_),
+  nThread(max(nReplica, OmpThread::nThread)),
+  node(vector<vector<DecNode>>(nReplica)),
+  score(vector<vector<double>>(nReplica)),
+  bits(vector<vector<BVSlotT>>(nReplica)) {
+  const BVSlotT* bitPool = forest->getBitPool();
+  size_t nSlot = forest->getBitOrigin().back();
+
+  // Each member of the team allocates, and so first-touches, its own copy.
+#pragma omp parallel default(shared) num_threads(nReplica) proc_bind(spread)
+  {
+    unsigned int repIdx = OmpThread::threadIdx();
+    node[repIdx] = vector<DecNode>(forest->getNode().begin(), forest->getNode().end());
+    score[repIdx] = vector<double>(forest->getTreeScores().begin(), forest->getTreeScores().end());
+    bits[repIdx] = vector<BVSlotT>(bitPool, bitPool + nSlot);
+  }
+}
+
+
+unique_ptr<ForestReplica> ForestReplica::factory(const Forest* forest,
+						 unsigned int nReplica) {
+  return (nReplica > 1 && OmpThread::nThread >= nReplica) ? make_unique<ForestReplica>(forest, nReplica) : nullptr;
+}
@@ -0,0 +1,95 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file forestreplica.h
+
+   @brief Per-socket copies of the forest arrays walked in prediction.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_FORESTREPLICA_H
+#define FOREST_FORESTREPLICA_H
+
+#include "typeparam.h"
+#include "bv.h"
+#include "decnode.h"
+#include "ompthread.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+
+/**
+   @brief Replicates the node arena, scores and factor bits, one copy
+   per memory domain.
+
+   Each copy is filled by its own thread of a spread-bound team, so that
+   first-touch placement assigns its pages to that thread's domain.
+   Scoring teams are spread-bound in the same fashion, whence thread
+   'i' of 'nThread' resides in the domain of replica
+   'i * nReplica / nThread'.  Placement therefore follows OMP_PLACES,
+   typically 'sockets' or 'numa_domains', rather than any OS affinity
+   interface.
+ */
+class ForestReplica {
+  const unsigned int nReplica; // # copies, one per domain.
+  const unsigned int nThread; // Size of scoring team.
+  vector<vector<DecNode>> node; // Per-replica node arena.
+  vector<vector<double>> score; // Per-replica scores, as node.
+  vector<vector<BVSlotT>> bits; // Per-replica factor bits.
+
+public:
+
+  ForestReplica(const class Forest* forest,
+		unsigned int nReplica_);
+
+
+  /**
+     @brief Replicates a forest if more than a single domain requested.
+
+     @return replica set, or null if replication not warranted.
+   */
+  static unique_ptr<ForestReplica> factory(const class Forest* forest,
+					   unsigned int nReplica);
+
+
+  /**
+     @return index of the replica local to the calling thread.
+   */
+  inline unsigned int localIdx() const {
+    return min(nReplica - 1, (OmpThread::threadIdx() * nReplica) / nThread);
+  }
+
+
+  /**
+     @return base of the calling thread's node arena.
+   */
+  inline const DecNode* getNode() const {
+    return node[localIdx()].data();
+  }
+
+
+  /**
+     @return base of the calling thread's scores.
+   */
+  inline const double* getScore() const {
+    return score[localIdx()].data();
+  }
+
+
+  /**
+     @return base of the calling thread's factor bits.
+   */
+  inline const BVSlotT* getBits() const {
+    return bits[localIdx()].data();
+  }
+};
+
+#endif
@@ -0,0 +1,87 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file foresttop.cc
+
+   @brief Methods building the complete upper levels of a forest.
+
+   @author Mark Seligman
+ */
+
+#include "foresttop.h"
+#include "forest.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+ForestTop::ForestTop(const Forest* forest,
+		     unsigned int depth_) :
+  depth(depth_),
+  nInternal((1u << depth) - 1),
+  topNode(vector<TopNode>(forest->getNTree() * nInternal)),
+  exitNode(vector<IndexT>(forest->getNTree() * (nInternal + 1))) {
+  vector<IndexT> slotNode(2 * nInternal + 1);
+  for (unsigned int tIdx = 0; tIdx < forest->getNTree(); tIdx++) {
+    const DecNode* cTree = forest->getTreeNode(tIdx);
+    TopNode* top = &topNode[tIdx * nInternal];
+    slotNode[0] = 0;
+    for (unsigned int slot = 0; slot < nInternal; slot++) {
+      IndexT nodeIdx = slotNode[slot];
+      const DecNode& node = cTree[nodeIdx];
+      if (node.isNonterminal()) {
+	top[slot] = TopNode{node.getSplitNum(), node.getPredIdx(), node.advanceNum(nan("")) != node.getDelIdx()};
+	slotNode[2 * slot + 1] = nodeIdx + node.getDelIdx();
+	slotNode[2 * slot + 2] = nodeIdx + node.getDelIdx() + 1;
+      }
+      else { // Pass-through:  either branch exits to the terminal.
+	top[slot] = TopNode{0.0, 0, false};
+	slotNode[2 * slot + 1] = nodeIdx;
+	slotNode[2 * slot + 2] = nodeIdx;
+      }
+    }
+    copy(slotNode.begin() + nInternal, slotNode.end(), exitNode.begin() + tIdx * (nInternal + 1));
+  }
+}
+
+
+unique_ptr<ForestTop> ForestTop::factory(const Forest* forest) {
+  unsigned int depth = fillDepth(forest);
+  return depth > 1 ? make_unique<ForestTop>(forest, depth) : nullptr;
+}
+
+
+unsigned int ForestTop::fillDepth(const Forest* forest) {
+  unsigned int nTree = forest->getNTree();
+  if (nTree == 0)
+    return 0;
+
+  vector<size_t> nSplit(depthMax); // Genuine splits, by level.
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    const DecNode* cTree = forest->getTreeNode(tIdx);
+    vector<IndexT> level{0};
+    for (unsigned int lev = 0; lev < depthMax && !level.empty(); lev++) {
+      vector<IndexT> levelNext;
+      for (IndexT nodeIdx : level) {
+	const DecNode& node = cTree[nodeIdx];
+	if (node.isNonterminal()) {
+	  nSplit[lev]++;
+	  levelNext.push_back(nodeIdx + node.getDelIdx());
+	  levelNext.push_back(nodeIdx + node.getDelIdx() + 1);
+	}
+      }
+      level = move(levelNext);
+    }
+  }
+
+  unsigned int depth = 0;
+  while (depth < depthMax && 2 * nSplit[depth] >= (static_cast<size_t>(nTree) << depth)) {
+    depth++;
+  }
+  return depth;
+}
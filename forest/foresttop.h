@@ -0,0 +1,97 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file foresttop.h
+
+   @brief Complete-binary encoding of the upper levels of each tree.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_FORESTTOP_H
+#define FOREST_FORESTTOP_H
+
+#include "typeparam.h"
+
+#include <memory>
+#include <vector>
+
+
+/**
+   @brief Numeric split within the complete upper levels.
+ */
+struct TopNode {
+  double split; // Splitting value.
+  PredictorT predIdx; // Splitting predictor.
+  bool nanFalse; // Whether NaN takes the false branch.
+};
+
+
+/**
+   @brief Lays out the top 'depth' levels of every tree as a complete
+   binary array, children of slot 'i' at '2i + 1' and '2i + 2'.
+
+   Terminals lying above 'depth' are padded with pass-through slots,
+   both of whose subtrees exit to the terminal itself.  Descent is
+   then a fixed number of branch-free steps, after which the general
+   walk resumes at the exit node.  The encoding is derived from the
+   forest on demand and is not serialized.
+ */
+class ForestTop {
+  static constexpr unsigned int depthMax = 4; // Deepest level encoded.
+
+  const unsigned int depth; // # complete levels.
+  const unsigned int nInternal; // # slots per tree above exit level.
+  vector<TopNode> topNode; // Complete levels, by tree.
+  vector<IndexT> exitNode; // Tree-relative resumption node, by exit slot.
+
+  /**
+     @brief Determines the number of levels worth encoding.
+
+     A level is encoded only if at least half its slots, forest-wide,
+     hold genuine splits.
+
+     @return number of levels to encode.
+   */
+  static unsigned int fillDepth(const class Forest* forest);
+
+public:
+
+  ForestTop(const class Forest* forest,
+	    unsigned int depth_);
+
+
+  /**
+     @brief Encodes the upper levels if sufficiently populated.
+
+     @return encoding, or null if trees are too shallow to benefit.
+   */
+  static unique_ptr<ForestTop> factory(const class Forest* forest);
+
+
+  /**
+     @brief Descends the complete levels of a tree, as advanceNum().
+
+     @param rowT is a row base within the transposed numerical set.
+
+     @return tree-relative node at which the general walk resumes.
+   */
+  inline IndexT descend(unsigned int tIdx,
+			const double rowT[]) const {
+    const TopNode* top = &topNode[tIdx * nInternal];
+    unsigned int slot = 0;
+    for (unsigned int level = 0; level < depth; level++) {
+      const TopNode& node = top[slot];
+      double val = rowT[node.predIdx];
+      slot = 2 * slot + 1 + ((val > node.split) | ((val != val) & node.nanFalse));
+    }
+    return exitNode[tIdx * (nInternal + 1) + slot - nInternal];
+  }
+};
+
+#endif
@@ -0,0 +1,126 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file jackvar.cc
+
+   @brief Infinitesimal-jackknife variance of regression predictions.
+
+   @author Mark Seligman
+ */
+
+#include "jackvar.h"
+#include "predict.h"
+#include "sampler.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+JackVar::JackVar(const Sampler* sampler,
+		 size_t nRow) :
+  nTree(sampler->getNTree()),
+  gram(static_cast<size_t>(nTree) * nTree),
+  countVar(0.0),
+  variance(nRow),
+  scratch(vector<Scratch>(max(1u, OmpThread::nThread), Scratch(nTree))) {
+  if (!sampler->hasSamples())
+    throw invalid_argument("Variance estimation requires sampler contents");
+  setGram(sampler);
+}
+
+
+void JackVar::setGram(const Sampler* sampler) {
+  // Decodes each tree's absolute rows once.
+  vector<vector<IndexT>> treeRow(nTree);
+  vector<double> countMean(sampler->getNObs());
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    IndexT row = 0;
+    for (IndexT sIdx = 0; sIdx != sampler->getBagCount(tIdx); sIdx++) {
+      row += sampler->getDelRow(tIdx, sIdx);
+      treeRow[tIdx].push_back(row);
+      countMean[row] += sampler->getSCount(tIdx, sIdx);
+    }
+  }
+
+  OMPBound treeEnd = nTree;
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+    vector<IndexT> dense(sampler->getNObs());
+#pragma omp for schedule(dynamic, 1)
+    for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+      for (IndexT sIdx = 0; sIdx != treeRow[tIdx].size(); sIdx++) {
+	dense[treeRow[tIdx][sIdx]] = sampler->getSCount(tIdx, sIdx);
+      }
+      for (unsigned int tPair = tIdx; tPair < nTree; tPair++) {
+	double inner = 0.0;
+	for (IndexT sIdx = 0; sIdx != treeRow[tPair].size(); sIdx++) {
+	  inner += static_cast<double>(dense[treeRow[tPair][sIdx]]) * sampler->getSCount(tPair, sIdx);
+	}
+	gram[tIdx * nTree + tPair] = gram[static_cast<size_t>(tPair) * nTree + tIdx] = inner;
+      }
+      for (IndexT row : treeRow[tIdx]) {
+	dense[row] = 0;
+      }
+    }
+  }
+
+  double countSquare = 0.0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    countSquare += gram[static_cast<size_t>(tIdx) * nTree + tIdx];
+  }
+  double meanSquare = 0.0;
+  for (double& mean : countMean) {
+    mean /= nTree;
+    meanSquare += mean * mean;
+  }
+  countVar = countSquare / nTree - meanSquare;
+}
+
+
+void JackVar::predictRow(const Predict* predict,
+			 size_t row) {
+  Scratch& rowScratch = scratch[OmpThread::threadIdx()];
+  vector<unsigned int>& treeIdx = rowScratch.treeIdx;
+  vector<double>& score = rowScratch.score;
+  treeIdx.clear();
+  score.clear();
+  double scoreSum = 0.0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    double treeScore;
+    if (predict->isLeafIdx(row, tIdx, treeScore)) {
+      treeIdx.push_back(tIdx);
+      score.push_back(treeScore);
+      scoreSum += treeScore;
+    }
+  }
+  size_t nReached = treeIdx.size();
+  if (nReached < 2) {
+    variance[row] = nan("");
+    return;
+  }
+
+  double scoreMean = scoreSum / nReached;
+  double devSquare = 0.0;
+  for (double& dev : score) {
+    dev -= scoreMean;
+    devSquare += dev * dev;
+  }
+  double quadForm = 0.0;
+  for (size_t idx = 0; idx < nReached; idx++) {
+    const double* gramRow = &gram[static_cast<size_t>(treeIdx[idx]) * nTree];
+    double inner = 0.0;
+    for (size_t pairIdx = 0; pairIdx < nReached; pairIdx++) {
+      inner += gramRow[treeIdx[pairIdx]] * score[pairIdx];
+    }
+    quadForm += score[idx] * inner;
+  }
+  double scale = 1.0 / (static_cast<double>(nReached) * nReached);
+  variance[row] = max(0.0, (quadForm - countVar * devSquare) * scale);
+}
@@ -0,0 +1,97 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file jackvar.h
+
+   @brief Infinitesimal-jackknife variance of regression predictions.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_JACKVAR_H
+#define FOREST_JACKVAR_H
+
+#include "typeparam.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Estimates the sampling variance of each row's prediction
+   from the covariance of in-bag counts and tree predictions.
+
+   The estimate of Wager, Hastie and Efron sums, over training
+   observations, the squared covariance across trees of the
+   observation's sample count with the tree's prediction.  Expanding
+   the square, this is a quadratic form in the row's centred tree
+   predictions, whose matrix is the tree x tree inner product of
+   sample counts.  That matrix depends only upon the sampler, so is
+   built once.  Each row then costs the square of the number of trees
+   reached, rather than the number of trees times the bag size, and no
+   tree x row prediction matrix is retained.
+
+   The Monte Carlo bias is removed using the empirical variance of the
+   sample counts, and the corrected estimate is floored at zero.
+ */
+class JackVar {
+  const unsigned int nTree;
+  vector<double> gram; ///> Tree x tree inner products of sample counts.
+  double countVar; ///> Sample-count variance, summed over observations.
+  vector<double> variance; ///> Per-row estimate.
+
+
+  /**
+     @brief Per-thread workspace.
+   */
+  struct Scratch {
+    vector<unsigned int> treeIdx; ///> Trees reached by the row.
+    vector<double> score; ///> Centred predictions, by tree reached.
+
+    Scratch(unsigned int nTree) {
+      treeIdx.reserve(nTree);
+      score.reserve(nTree);
+    }
+  };
+  vector<Scratch> scratch; ///> Indexed by thread.
+
+
+  /**
+     @brief Builds the inner products of every pair of trees' counts.
+   */
+  void setGram(const class Sampler* sampler);
+
+public:
+
+  /**
+     @param nRow is the number of rows to be estimated.
+   */
+  JackVar(const class Sampler* sampler,
+	  size_t nRow);
+
+
+  /**
+     @brief Estimates the variance of a scored row.
+
+     Scratch is that of the calling thread, so rows may be estimated
+     concurrently.
+   */
+  void predictRow(const class Predict* predict,
+		  size_t row);
+
+
+  /**
+     @return per-row variance estimates.
+   */
+  const vector<double>& getVariance() const {
+    return variance;
+  }
+};
+
+#endif
@@ -11,7 +11,12 @@
 #include "pretree.h"
 #include "response.h"
 #include "leaf.h"
+#include "leafpack.h"
 #include "ompthread.h"
+#include "loadstat.h"
+
+#include <algorithm>
+#include <stdexcept>
 
 
 PackedT RankCount::rankMask = 0;
@@ -27,25 +32,186 @@ unique_ptr<Leaf> Leaf::train(IndexT nObs,
 
 unique_ptr<Leaf> Leaf::predict(const Sampler* sampler,
 			       bool thin,
-			       vector<vector<size_t>> extent,
-			       vector<vector<vector<size_t>>> index) {
+			       const double extentFE[],
+			       const double indexFE[]) {
+  RankCount::setMasks(sampler->getNObs());
+  return make_unique<Leaf>(sampler, thin, extentFE, indexFE);
+}
+
+
+unique_ptr<Leaf> Leaf::predict(const Sampler* sampler,
+			       bool thin,
+			       const double extentFE[],
+			       const unsigned char packFE[],
+			       size_t packSize) {
   RankCount::setMasks(sampler->getNObs());
-  return make_unique<Leaf>(sampler, thin, extent, index);
+  return make_unique<Leaf>(sampler, thin, extentFE, packFE, packSize);
 }
 
 
 Leaf::Leaf(bool thin_)
-  : thin(thin_) {
+  : thin(thin_),
+    sampler(nullptr),
+    extentFE(nullptr),
+    indexFE(nullptr),
+    packFE(nullptr),
+    packSize(0) {
+}
+
+
+Leaf::Leaf(const Sampler* sampler_,
+	   bool thin_,
+	   const double extentFE_[],
+	   const double indexFE_[]) :
+  thin(thin_),
+  sampler(sampler_),
+  extentFE(extentFE_),
+  indexFE(indexFE_),
+  packFE(nullptr),
+  packSize(0) {
+}
+
+
+Leaf::Leaf(const Sampler* sampler_,
+	   bool thin_,
+	   const double extentFE_[],
+	   const unsigned char packFE_[],
+	   size_t packSize_) :
+  thin(thin_),
+  sampler(sampler_),
+  extentFE(extentFE_),
+  indexFE(nullptr),
+  packFE(packFE_),
+  packSize(packSize_) {
 }
 
 
-Leaf::Leaf(const Sampler* sampler,
+unique_ptr<Leaf> Leaf::predict(const Sampler* sampler,
+			       bool thin,
+			       vector<size_t> treeOrigin_,
+			       vector<size_t> leafOrigin_,
+			       vector<IndexT> index_) {
+  RankCount::setMasks(sampler->getNObs());
+  return make_unique<Leaf>(sampler, thin, move(treeOrigin_), move(leafOrigin_), move(index_));
+}
+
+
+Leaf::Leaf(const Sampler* sampler_,
 	   bool thin_,
-	   vector<vector<size_t>> extent_,
-	   vector<vector<vector<size_t>>> index_) :
+	   vector<size_t> treeOrigin_,
+	   vector<size_t> leafOrigin_,
+	   vector<IndexT> index_) :
   thin(thin_),
-  extent(extent_),
-  index(index_) {
+  sampler(sampler_),
+  extentFE(nullptr),
+  indexFE(nullptr),
+  packFE(nullptr),
+  packSize(0),
+  treeOrigin(move(treeOrigin_)),
+  leafOrigin(move(leafOrigin_)),
+  index(move(index_)) {
+}
+
+
+unique_ptr<Leaf> Leaf::select(const Sampler* sampler,
+			      const vector<unsigned int>& treeIdx) const {
+  bool thinOut = thin || getTreeOrigin().empty();
+  vector<pair<const Leaf*, unsigned int>> treeRef;
+  for (unsigned int tIdx : treeIdx) {
+    if (!thinOut && tIdx + 1 >= treeOrigin.size()) {
+      throw invalid_argument("Tree index out of range");
+    }
+    treeRef.emplace_back(this, tIdx);
+  }
+  return gather(sampler, thinOut, treeRef);
+}
+
+
+unique_ptr<Leaf> Leaf::merge(const Sampler* sampler,
+			     const vector<const Leaf*>& leaves) {
+  bool thinOut = false;
+  vector<pair<const Leaf*, unsigned int>> treeRef;
+  for (const Leaf* leaf : leaves) {
+    thinOut = thinOut || leaf->thin || leaf->getTreeOrigin().empty();
+    unsigned int nTree = leaf->treeOrigin.empty() ? 0 : leaf->treeOrigin.size() - 1;
+    for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+      treeRef.emplace_back(leaf, tIdx);
+    }
+  }
+  return gather(sampler, thinOut, treeRef);
+}
+
+
+unique_ptr<Leaf> Leaf::gather(const Sampler* sampler,
+			      bool thin,
+			      const vector<pair<const Leaf*, unsigned int>>& treeRef) {
+  if (thin) {
+    return predict(sampler, true, vector<size_t>(), vector<size_t>(), vector<IndexT>());
+  }
+
+  vector<size_t> treeOriginOut;
+  vector<size_t> leafOriginOut;
+  vector<IndexT> indexOut;
+  for (auto ref : treeRef) {
+    const Leaf* leaf = ref.first;
+    leaf->decode();
+    treeOriginOut.push_back(leafOriginOut.size());
+    size_t leafStart = leaf->treeOrigin[ref.second];
+    size_t leafEnd = leaf->treeOrigin[ref.second + 1];
+    for (size_t leafPos = leafStart; leafPos < leafEnd; leafPos++) {
+      leafOriginOut.push_back(indexOut.size());
+      indexOut.insert(indexOut.end(), leaf->index.begin() + leaf->leafOrigin[leafPos], leaf->index.begin() + leaf->leafOrigin[leafPos + 1]);
+    }
+  }
+  treeOriginOut.push_back(leafOriginOut.size());
+  leafOriginOut.push_back(indexOut.size());
+
+  return predict(sampler, false, move(treeOriginOut), move(leafOriginOut), move(indexOut));
+}
+
+
+void Leaf::decode() const {
+  call_once(decodeFlag, [this]() { unpack(); });
+}
+
+
+void Leaf::unpack() const {
+  if (thin || extentFE == nullptr)
+    return;
+
+  // Leaves of a tree consume its bag, so the total bag count bounds
+  // the number of leaves.
+  unsigned int nTree = sampler->getNTree();
+  size_t bagTot = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    bagTot += sampler->getBagCount(tIdx);
+  }
+  leafOrigin.reserve(bagTot + 1);
+  treeOrigin = vector<size_t>(nTree + 1);
+  size_t idx = 0;
+  size_t indexTot = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    treeOrigin[tIdx] = idx;
+    size_t extentTree = 0;
+    while (extentTree < sampler->getBagCount(tIdx)) {
+      size_t extentLeaf = extentFE[idx++];
+      leafOrigin.push_back(indexTot);
+      indexTot += extentLeaf;
+      extentTree += extentLeaf;
+    }
+  }
+  treeOrigin[nTree] = idx;
+  leafOrigin.push_back(indexTot);
+  leafOrigin.shrink_to_fit();
+
+  if (packFE != nullptr) {
+    index = LeafPack::unpack(packFE, packSize, treeOrigin, leafOrigin);
+    return;
+  }
+  index = vector<IndexT>(indexTot);
+  for (size_t idx = 0; idx != indexTot; idx++) {
+    index[idx] = indexFE[idx];
+  }
 }
 
 
@@ -54,8 +220,19 @@ Leaf::~Leaf() {
 }
 
 
+void Leaf::reserve(size_t indexCount,
+		   size_t leafBound) {
+  if (thin)
+    return;
+
+  indexCresc.reserve(indexCresc.size() + indexCount);
+  extentCresc.reserve(extentCresc.size() + leafBound);
+}
+
+
 void Leaf::consumeTerminals(const PreTree* pretree,
-			    const SampleMap& terminalMap) {
+			    const SampleMap& terminalMap,
+			    LoadStat* load) {
   if (thin)
     return;
   
@@ -82,76 +259,148 @@ void Leaf::consumeTerminals(const PreTree* pretree,
     leafStart[leafIdx] = exchange(startAccum, startAccum + extentCresc[extentStart + leafIdx]);
   }
 
+  LoadTally tally(load, OmpThread::nThread, "leaf");
 #pragma omp parallel default(shared) num_threads(OmpThread::nThread)
   {
-#pragma omp for schedule(dynamic, 1)
+  auto entry = tally.enter();
+  size_t nIter = 0;
+#pragma omp for schedule(dynamic, 1) nowait
   for (OMPBound rangeIdx = 0; rangeIdx < terminalMap.range.size(); rangeIdx++) {
     IndexT leafIdx = pretree->getLeafIdx(terminalMap.ptIdx[rangeIdx]);
     IndexT idBegin = leafStart[leafIdx];
     for (IndexT idx = terminalMap.range[rangeIdx].getStart(); idx != terminalMap.range[rangeIdx].getEnd(); idx++) {
       indexCresc[idBegin++] = terminalMap.sampleIndex[idx];
     }
+    sort(indexCresc.begin() + leafStart[leafIdx], indexCresc.begin() + idBegin);
+    nIter++;
   }
+  tally.exit(OmpThread::threadIdx(), entry, nIter);
   }
+  leafPending.push_back(nLeaf);
 }
 
 
+void Leaf::packPending() {
+  if (thin || leafPending.empty())
+    return;
 
-vector<vector<vector<size_t>>> Leaf::countLeafCtg(const Sampler* sampler,
-						  const ResponseCtg* response) const {
-  unsigned int nTree = sampler->getNTree();
-  vector<vector<vector<size_t>>> ctgCount(nTree);
+  // Pending trees occupy the tails of the crescent maps.
+  vector<size_t> leafStart(leafPending.size() + 1);
+  vector<size_t> indexStart(leafPending.size() + 1);
+  size_t leafPos = extentCresc.size();
+  size_t indexPos = indexCresc.size();
+  for (size_t treeIdx = leafPending.size(); treeIdx-- > 0; ) {
+    leafStart[treeIdx + 1] = leafPos;
+    indexStart[treeIdx + 1] = indexPos;
+    for (IndexT leafIdx = 0; leafIdx < leafPending[treeIdx]; leafIdx++) {
+      indexPos -= extentCresc[--leafPos];
+    }
+  }
+  leafStart[0] = leafPos;
+  indexStart[0] = indexPos;
+
+  vector<vector<unsigned char>> packTree(leafPending.size());
+  OMPBound treeEnd = leafPending.size();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound treeIdx = 0; treeIdx < treeEnd; treeIdx++) {
+    LeafPack::pack(extentCresc.data() + leafStart[treeIdx], leafPending[treeIdx], indexCresc.data() + indexStart[treeIdx], packTree[treeIdx]);
+  }
+  }
+
+  for (auto& pack : packTree) {
+    packCresc.insert(packCresc.end(), pack.begin(), pack.end());
+  }
+  leafPending.clear();
+}
+
+
+
+vector<IndexT> Leaf::countLeafCtg(const Sampler* sampler,
+				  const ResponseCtg* response) const {
   if (!sampler->hasSamples())
-    return ctgCount;
+    return vector<IndexT>(0);
+  decode();
+  if (treeOrigin.empty())
+    return vector<IndexT>(0);
   PredictorT nCtg = response->getNCtg();
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+  vector<IndexT> ctgCount(getLeafTotal() * nCtg);
+
+  OMPBound treeEnd = sampler->getNTree();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
     IndexT row = 0;
     vector<PredictorT> sIdx2Ctg(sampler->getBagCount(tIdx));
     for (IndexT sIdx = 0; sIdx != sIdx2Ctg.size(); sIdx++) {
       row += sampler->getDelRow(tIdx, sIdx);
       sIdx2Ctg[sIdx] = response->getCtg(row);
     }
-    size_t leafIdx = 0;
-    ctgCount[tIdx] = vector<vector<size_t>>(getLeafCount(tIdx));
-    for (vector<size_t> sIdxVec : getIndices(tIdx)) {
-      ctgCount[tIdx][leafIdx] = vector<size_t>(sIdxVec.size() * nCtg);
-      for (size_t sIdx : sIdxVec) {
-	PredictorT ctg = sIdx2Ctg[sIdx];
-	ctgCount[tIdx][leafIdx][ctg] += sampler->getSCount(tIdx, sIdx);
+    for (size_t leafPos = treeOrigin[tIdx]; leafPos != treeOrigin[tIdx + 1]; leafPos++) {
+      for (size_t idx = leafOrigin[leafPos]; idx != leafOrigin[leafPos + 1]; idx++) {
+	IndexT sIdx = index[idx];
+	ctgCount[leafPos * nCtg + sIdx2Ctg[sIdx]] += sampler->getSCount(tIdx, sIdx);
       }
-      leafIdx++;
     }
   }
+  }
 
   return ctgCount;
 }
 
 
-vector<vector<vector<RankCount>>> Leaf::alignRanks(const class Sampler* sampler,
-						   const vector<IndexT>& row2Rank) const {
-  unsigned int nTree = sampler->getNTree();
-  vector<vector<vector<RankCount>>> rankCount(nTree);
+vector<RankCount> Leaf::alignRanks(const class Sampler* sampler,
+				   const vector<IndexT>& row2Rank) const {
   if (!sampler->hasSamples())
-    return rankCount;
+    return vector<RankCount>(0);
+  decode();
+  if (treeOrigin.empty())
+    return vector<RankCount>(0);
+  vector<RankCount> rankCount(index.size());
 
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+  OMPBound treeEnd = sampler->getNTree();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
     IndexT row = 0;
-    vector<size_t> sIdx2Rank(sampler->getBagCount(tIdx));
+    vector<IndexT> sIdx2Rank(sampler->getBagCount(tIdx));
     for (IndexT sIdx = 0 ; sIdx != sIdx2Rank.size(); sIdx++) {
       row += sampler->getDelRow(tIdx, sIdx);
       sIdx2Rank[sIdx] = row2Rank[row];
     }
-    size_t leafIdx = 0;
-    rankCount[tIdx] = vector<vector<RankCount>>(getLeafCount(tIdx));
-    for (vector<size_t> sIdxVec : getIndices(tIdx)) {
-      rankCount[tIdx][leafIdx] = vector<RankCount>(sIdxVec.size());
-      size_t idx = 0;
-      for (size_t sIdx : sIdxVec) {
-	rankCount[tIdx][leafIdx][idx++].init(sIdx2Rank[sIdx], sampler->getSCount(tIdx, sIdx));
-      }
-      leafIdx++;
+    for (size_t idx = leafOrigin[treeOrigin[tIdx]]; idx != leafOrigin[treeOrigin[tIdx + 1]]; idx++) {
+      IndexT sIdx = index[idx];
+      rankCount[idx].init(sIdx2Rank[sIdx], sampler->getSCount(tIdx, sIdx));
     }
+    for (size_t leafPos = treeOrigin[tIdx]; leafPos != treeOrigin[tIdx + 1]; leafPos++) {
+      sort(rankCount.begin() + leafOrigin[leafPos], rankCount.begin() + leafOrigin[leafPos + 1],
+	   [](const RankCount& a, const RankCount& b) {
+	     return a.getRank() < b.getRank();
+	   });
+    }
+  }
   }
 
   return rankCount;
 }
+
+
+const vector<RankCount>& Leaf::getRankAligned(const Sampler* sampler,
+					      const vector<IndexT>& row2Rank) const {
+  call_once(alignFlag, [this, sampler, &row2Rank]() {
+    if (rankAligned.empty())
+      rankAligned = alignRanks(sampler, row2Rank);
+  });
+  return rankAligned;
+}
+
+
+void Leaf::setRankAligned(vector<RankCount> rankAligned_) {
+  if (rankAligned_.size() != getIndex().size()) {
+    throw invalid_argument("Aligned ranks do not conform with leaf samples");
+  }
+  rankAligned = move(rankAligned_);
+}
@@ -20,6 +20,7 @@
 #include "util.h"
 
 #include <vector>
+#include <mutex>
 
 using namespace std;
 
@@ -77,6 +78,22 @@ public:
   IndexT getSCount() const {
     return packed >> rightBits;
   }
+
+
+  /**
+     @brief Packed representation, as persisted.
+   */
+  PackedT getPacked() const {
+    return packed;
+  }
+
+
+  /**
+     @brief Restores a packed representation, under the same masks.
+   */
+  void initPacked(PackedT packed) {
+    this->packed = packed;
+  }
 };
 
 
@@ -89,10 +106,40 @@ struct Leaf {
   // Training only:
   vector<IndexT> indexCresc; // Sample indices within leaves.
   vector<IndexT> extentCresc; // Index extent, per leaf.
+  vector<unsigned char> packCresc; // Sample indices, encoded by LeafPack.
+  vector<IndexT> leafPending; // Leaf counts of trees awaiting encoding.
   
-  // Post-training only:  extent, index maps fixed.
-  const vector<vector<size_t>> extent; // # sample index entries per leaf, per tree.
-  const vector<vector<vector<size_t>>> index; // sample indices per leaf, per tree.
+  // Post-training only:  front-end maps, decoded on first demand.
+  const class Sampler* sampler;
+  const double* extentFE; // Front end's leaf extents, unowned.
+  const double* indexFE; // Front end's sample indices, unowned.
+  const unsigned char* packFE; // Front end's encoded indices, unowned.
+  const size_t packSize; // Length of the encoding, in bytes.
+  mutable once_flag decodeFlag;
+
+  // Decoded extent, index maps, in CSR form.
+  mutable vector<size_t> treeOrigin; // Per-tree offset into leafOrigin, plus sup.
+  mutable vector<size_t> leafOrigin; // Forest-wide per-leaf offset into index, plus sup.
+  mutable vector<IndexT> index; // Forest-wide sample indices, by leaf.
+
+  // Quantile support, aligned on first demand or restored.
+  mutable once_flag alignFlag;
+  mutable vector<RankCount> rankAligned; // Positioned as index, iff aligned.
+
+
+  /**
+     @brief Builds the CSR maps from the front-end buffers, once.
+
+     Only quantile and probability estimation read the maps, so
+     prediction otherwise never pays for decoding.
+   */
+  void decode() const;
+
+
+  /**
+     @brief Decoding body.
+   */
+  void unpack() const;
 
   /**
      @brief Training factory.
@@ -108,14 +155,75 @@ struct Leaf {
 
      @param Sampler guides reading of leaf contents.
 
-     @param extent gives the number of distinct samples, forest-wide.
+     @param extentFE gives the number of distinct samples, forest-wide.
 
-     @param index gives sample positions.
+     @param indexFE gives sample positions.
   */
   static unique_ptr<Leaf> predict(const class Sampler* sampler,
 				  bool thin,
-				  vector<vector<size_t>> extent,
-				  vector<vector<vector<size_t>>> index);
+				  const double extentFE[],
+				  const double indexFE[]);
+
+
+  /**
+     @brief Prediction factory:  sample indices encoded by LeafPack.
+
+     @param packFE is the encoding.
+
+     @param packSize is the encoding's length, in bytes.
+  */
+  static unique_ptr<Leaf> predict(const class Sampler* sampler,
+				  bool thin,
+				  const double extentFE[],
+				  const unsigned char packFE[],
+				  size_t packSize);
+
+
+  /**
+     @brief Prediction factory:  maps supplied already decoded.
+   */
+  static unique_ptr<Leaf> predict(const class Sampler* sampler,
+				  bool thin,
+				  vector<size_t> treeOrigin_,
+				  vector<size_t> leafOrigin_,
+				  vector<IndexT> index_);
+
+
+  /**
+     @brief Copies a subset of trees' maps, in the order specified.
+
+     @param sampler is the correspondingly selected sampler.
+
+     @param treeIdx are the source indices, possibly repeated.
+   */
+  unique_ptr<Leaf> select(const class Sampler* sampler,
+			  const vector<unsigned int>& treeIdx) const;
+
+
+  /**
+     @brief Concatenates the maps of leaves trained independently.
+
+     Thin if any contributor is thin.
+
+     @param sampler is the correspondingly merged sampler.
+
+     @return leaf consisting of each leaf's trees, in order.
+   */
+  static unique_ptr<Leaf> merge(const class Sampler* sampler,
+				const vector<const Leaf*>& leaves);
+
+
+  /**
+     @brief Copies an arbitrary sequence of trees' maps into a new leaf.
+
+     Sample indices are tree-relative, so only the origins require
+     remapping.
+
+     @param treeRef pairs each output tree with its source leaf and index.
+   */
+  static unique_ptr<Leaf> gather(const class Sampler* sampler,
+				 bool thin,
+				 const vector<pair<const Leaf*, unsigned int>>& treeRef);
 
 
   /**
@@ -125,12 +233,35 @@ struct Leaf {
 
 
   /**
-     @brief Post-training constructor:  fixed maps passed in.
+     @brief Post-training constructor:  front-end maps referenced.
+
+     The buffers must outlive the object.
    */
-  Leaf(const class Sampler* sampler,
+  Leaf(const class Sampler* sampler_,
        bool thin_,
-       vector<vector<size_t>> extent_,
-       vector<vector<vector<size_t>>> index_);
+       const double extentFE_[],
+       const double indexFE_[]);
+
+
+  /**
+     @brief Post-training constructor:  encoded front-end indices
+     referenced.
+   */
+  Leaf(const class Sampler* sampler_,
+       bool thin_,
+       const double extentFE_[],
+       const unsigned char packFE_[],
+       size_t packSize_);
+
+
+  /**
+     @brief Post-training constructor:  CSR maps supplied, as from a model file.
+   */
+  Leaf(const class Sampler* sampler_,
+       bool thin_,
+       vector<size_t> treeOrigin_,
+       vector<size_t> leafOrigin_,
+       vector<IndexT> index_);
 
   
   /**
@@ -144,9 +275,30 @@ struct Leaf {
 
      Training caches leaves in order of production.  Depth-first
      leaf numbering requires that the sample maps be reordered.
+     Sample indices are sorted within each leaf, then encoded.
    */
   void consumeTerminals(const class PreTree* pretree,
-			const struct SampleMap& smTerminal);
+			const struct SampleMap& smTerminal,
+			struct LoadStat* load = nullptr);
+
+
+  /**
+     @brief Encodes the sample indices of trees awaiting encoding,
+     tree-parallel.
+   */
+  void packPending();
+
+
+  /**
+     @brief Reserves crescent space for a chunk of trees, unless thin.
+
+     @param indexCount is the chunk's total bag count, which the sample
+     indices match exactly.
+
+     @param leafBound bounds the chunk's total leaf count.
+   */
+  void reserve(size_t indexCount,
+	       size_t leafBound);
 
 
   /**
@@ -154,10 +306,11 @@ struct Leaf {
 
      'probSample' is the only client.
 
-     @return 3-d vector category counts, indexed by tree/leaf/ctg.
+     @return category counts, indexed by forest-wide leaf position and
+     category.
    */
-  vector<vector<vector<size_t>>> countLeafCtg(const class Sampler* sampler,
-					      const class ResponseCtg* response) const;
+  vector<IndexT> countLeafCtg(const class Sampler* sampler,
+			      const class ResponseCtg* response) const;
 
 
   /**
@@ -165,17 +318,84 @@ struct Leaf {
 
      @param row2Rank is the ranked training outcome.
 
-     @return 3-d mapping as described.
+     @return rank counts, by leaf as the sample indices, sorted by
+     rank within each leaf.
+   */
+  vector<RankCount> alignRanks(const class Sampler* sampler,
+			       const vector<IndexT>& row2Rank) const;
+
+
+  /**
+     @brief As above, but aligns only once, retaining the result.
+
+     Later predictions, as well as persisted models, then begin
+     quantile estimation without walking the sampler.
+
+     @return rank counts, aligned now or previously.
+   */
+  const vector<RankCount>& getRankAligned(const class Sampler* sampler,
+					  const vector<IndexT>& row2Rank) const;
+
+
+  /**
+     @brief Adopts rank counts aligned previously, as from a model file.
+
+     @param rankAligned_ must be positioned as the sample indices.
+   */
+  void setRankAligned(vector<RankCount> rankAligned_);
+
+
+  /**
+     @return whether rank counts have been aligned or restored.
+   */
+  bool isRankAligned() const {
+    return !rankAligned.empty();
+  }
+
+
+  /**
+     @return rank counts, empty unless aligned or restored.
    */
-  vector<vector<vector<RankCount>>> alignRanks(const class Sampler* sampler,
-					       const vector<IndexT>& row2Rank) const;
+  const vector<RankCount>& getRankStored() const {
+    return rankAligned;
+  }
 
 
   /**
      @return # leaves at a given tree index.
    */
   size_t getLeafCount(unsigned int tIdx) const {
-    return extent[tIdx].size();
+    decode();
+    return treeOrigin[tIdx + 1] - treeOrigin[tIdx];
+  }
+
+
+  /**
+     @brief Position lookup for hot loops:  maps must already be decoded.
+
+     @return forest-wide position of a tree-relative leaf.
+   */
+  size_t getLeafPos(unsigned int tIdx,
+		    IndexT leafIdx) const {
+    return treeOrigin[tIdx] + leafIdx;
+  }
+
+
+  /**
+     @return total # leaves, forest-wide.
+   */
+  size_t getLeafTotal() const {
+    decode();
+    return treeOrigin.empty() ? 0 : treeOrigin.back();
+  }
+
+
+  /**
+     @return # sample indices at a forest-wide leaf position.
+   */
+  size_t getExtent(size_t leafPos) const {
+    decode();
+    return leafOrigin[leafPos + 1] - leafOrigin[leafPos];
   }
 
 
@@ -187,15 +407,33 @@ struct Leaf {
   const vector<IndexT>& getIndexCresc() const {
     return indexCresc;
   }
+
+
+  const vector<unsigned char>& getPackCresc() const {
+    return packCresc;
+  }
   
   
-  const vector<size_t>& getExtents(unsigned int tIdx) const {
-    return extent[tIdx];
+  bool isThin() const {
+    return thin;
+  }
+
+
+  const vector<size_t>& getTreeOrigin() const {
+    decode();
+    return treeOrigin;
+  }
+
+
+  const vector<size_t>& getLeafOrigin() const {
+    decode();
+    return leafOrigin;
   }
 
 
-  const vector<vector<size_t>>& getIndices(unsigned int tIdx) const {
-    return index[tIdx];
+  const vector<IndexT>& getIndex() const {
+    decode();
+    return index;
   }
 };
 
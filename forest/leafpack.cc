@@ -0,0 +1,141 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file leafpack.cc
+
+   @brief Methods encoding and decoding leaf sample indices.
+
+   @author Mark Seligman
+ */
+
+#include "leafpack.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+void LeafPack::pack(const IndexT extent[],
+		    size_t nLeaf,
+		    const IndexT index[],
+		    vector<unsigned char>& pack) {
+  vector<IndexT> leafIndex;
+  IndexT gap[blockSize];
+  for (size_t leafIdx = 0; leafIdx < nLeaf; leafIdx++) {
+    leafIndex.assign(index, index + extent[leafIdx]);
+    index += extent[leafIdx];
+    if (!is_sorted(leafIndex.begin(), leafIndex.end()))
+      sort(leafIndex.begin(), leafIndex.end());
+
+    IndexT prev = 0;
+    for (size_t blockStart = 0; blockStart < leafIndex.size(); blockStart += blockSize) {
+      unsigned int nVal = min(static_cast<size_t>(blockSize), leafIndex.size() - blockStart);
+      IndexT gapOr = 0;
+      for (unsigned int i = 0; i < nVal; i++) {
+	gap[i] = leafIndex[blockStart + i] - exchange(prev, leafIndex[blockStart + i]);
+	gapOr |= gap[i];
+      }
+      unsigned int width = 0;
+      while (width < 32 && (gapOr >> width) != 0)
+	width++;
+
+      pack.push_back(width);
+      uint64_t acc = 0;
+      unsigned int accBits = 0;
+      for (unsigned int i = 0; i < nVal; i++) {
+	acc |= static_cast<uint64_t>(gap[i]) << accBits;
+	accBits += width;
+	while (accBits >= 8) {
+	  pack.push_back(acc & 0xff);
+	  acc >>= 8;
+	  accBits -= 8;
+	}
+      }
+      if (accBits > 0)
+	pack.push_back(acc & 0xff);
+    }
+  }
+}
+
+
+const unsigned char* LeafPack::unpackLeaf(const unsigned char* pack,
+					  size_t extent,
+					  IndexT indexOut[]) {
+  // Payloads are staged with slack, so that every value is extracted
+  // by a single unaligned eight-byte load.
+  unsigned char payload[blockSize * sizeof(IndexT) + sizeof(uint64_t)];
+  IndexT prev = 0;
+  for (size_t blockStart = 0; blockStart < extent; blockStart += blockSize) {
+    unsigned int nVal = min(static_cast<size_t>(blockSize), extent - blockStart);
+    unsigned int width = *pack++;
+    size_t nByte = payloadBytes(nVal, width);
+    memcpy(payload, pack, nByte);
+    memset(payload + nByte, 0, sizeof(uint64_t));
+    pack += nByte;
+
+    IndexT* gap = indexOut + blockStart;
+    uint64_t mask = (uint64_t(1) << width) - 1;
+#pragma omp simd
+    for (unsigned int i = 0; i < nVal; i++) {
+      unsigned int bitPos = i * width;
+      uint64_t word;
+      memcpy(&word, payload + (bitPos >> 3), sizeof(word));
+      gap[i] = (word >> (bitPos & 7)) & mask;
+    }
+    for (unsigned int i = 0; i < nVal; i++) {
+      prev += gap[i];
+      gap[i] = prev;
+    }
+  }
+
+  return pack;
+}
+
+
+vector<IndexT> LeafPack::unpack(const unsigned char pack[],
+				size_t packSize,
+				const vector<size_t>& treeOrigin,
+				const vector<size_t>& leafOrigin) {
+  // Block headers are scanned sequentially to locate each tree's
+  // encoding, validating the stream as they go.
+  size_t nTree = treeOrigin.empty() ? 0 : treeOrigin.size() - 1;
+  vector<size_t> treePack(nTree);
+  size_t packPos = 0;
+  for (size_t tIdx = 0; tIdx < nTree; tIdx++) {
+    treePack[tIdx] = packPos;
+    for (size_t leafPos = treeOrigin[tIdx]; leafPos != treeOrigin[tIdx + 1]; leafPos++) {
+      size_t extent = leafOrigin[leafPos + 1] - leafOrigin[leafPos];
+      for (size_t blockStart = 0; blockStart < extent; blockStart += blockSize) {
+	if (packPos >= packSize || pack[packPos] > 32) {
+	  throw invalid_argument("Leaf index encoding is malformed");
+	}
+	packPos += 1 + payloadBytes(min(static_cast<size_t>(blockSize), extent - blockStart), pack[packPos]);
+      }
+    }
+  }
+  if (packPos > packSize) {
+    throw invalid_argument("Leaf index encoding is malformed");
+  }
+
+  vector<IndexT> index(leafOrigin.empty() ? 0 : leafOrigin.back());
+  OMPBound treeEnd = nTree;
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+    const unsigned char* treeBase = pack + treePack[tIdx];
+    for (size_t leafPos = treeOrigin[tIdx]; leafPos != treeOrigin[tIdx + 1]; leafPos++) {
+      treeBase = unpackLeaf(treeBase, leafOrigin[leafPos + 1] - leafOrigin[leafPos], &index[leafOrigin[leafPos]]);
+    }
+  }
+  }
+
+  return index;
+}
@@ -0,0 +1,104 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file leafpack.h
+
+   @brief Compressed encoding of the sample indices at leaves.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_LEAFPACK_H
+#define FOREST_LEAFPACK_H
+
+#include "typeparam.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Frame-of-reference bit packing of leaves' sample indices.
+
+   The indices of a leaf are coded in ascending order as gaps, the
+   leading gap taken from zero.  Gaps are packed into blocks of at
+   most 'blockSize' values, each prefixed by a byte giving the bit
+   width of its widest gap.  Blocks never span leaves, so an encoding
+   is delimited by the leaf extents alone and the encodings of
+   successive chunks concatenate.
+
+   Fixed-width blocks decode without branches, unlike byte-oriented
+   variable-length codes, and so lend themselves to vectorization.
+ */
+struct LeafPack {
+  static constexpr unsigned int blockSize = 32; // Maximal values per block.
+
+  /**
+     @brief Appends the encoding of a run of leaves.
+
+     @param extent are the leaves' sample-index counts.
+
+     @param nLeaf is the number of leaves.
+
+     @param index are the leaves' sample indices, by leaf, in any order.
+
+     @param[out] pack receives the encoding.
+   */
+  static void pack(const IndexT extent[],
+		   size_t nLeaf,
+		   const IndexT index[],
+		   vector<unsigned char>& pack);
+
+
+  /**
+     @brief Decodes the sample indices of a forest, tree-parallel.
+
+     @param pack is the encoding of all trees' leaves, in order.
+
+     @param packSize is the encoding's length, in bytes.
+
+     @param treeOrigin is the per-tree offset into 'leafOrigin', plus sup.
+
+     @param leafOrigin is the per-leaf offset into the index, plus sup.
+
+     @return sample indices by leaf, ascending within each leaf.
+   */
+  static vector<IndexT> unpack(const unsigned char pack[],
+			       size_t packSize,
+			       const vector<size_t>& treeOrigin,
+			       const vector<size_t>& leafOrigin);
+
+private:
+
+  /**
+     @return byte length of a block's packed values.
+   */
+  static size_t payloadBytes(unsigned int nVal,
+			     unsigned int width) {
+    return (static_cast<size_t>(nVal) * width + 7) >> 3;
+  }
+
+
+  /**
+     @brief Decodes a single leaf.
+
+     @param pack is the leaf's leading block.
+
+     @param extent is the leaf's sample-index count.
+
+     @param[out] indexOut receives the decoded indices.
+
+     @return position following the leaf's final block.
+   */
+  static const unsigned char* unpackLeaf(const unsigned char* pack,
+					 size_t extent,
+					 IndexT indexOut[]);
+};
+
+#endif
@@ -0,0 +1,140 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file localimp.cc
+
+   @brief Per-row permutation importance by selective tree re-walking.
+
+   @author Mark Seligman
+ */
+
+#include "localimp.h"
+#include "forest.h"
+#include "predict.h"
+#include "prng.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+LocalImp::LocalImp(const Forest* forest,
+		   PredictorT nPredNum_,
+		   PredictorT nPredFac,
+		   unsigned int nCtg,
+		   size_t nRow) :
+  decNode(forest->getNode()),
+  nodeOrigin(forest->getNodeOrigin()),
+  scoreBlock(forest->getTreeScores()),
+  bitPool(forest->getBitPool()),
+  bitOrigin(forest->getBitOrigin()),
+  nTree(forest->getNTree()),
+  nPredNum(nPredNum_),
+  nPred(nPredNum_ + nPredFac),
+  nOut(nCtg == 0 ? 1 : nCtg),
+  ctg(nCtg > 0),
+  seed(PRNGLocal::sessionSeed()),
+  importance(nRow * nPred * nOut) {
+}
+
+
+void LocalImp::accumulate(const Predict* predict,
+			  const double* blockNum,
+			  const CtgT* blockFac,
+			  size_t rowStart,
+			  size_t span) {
+  OMPBound spanEnd = static_cast<OMPBound>(span);
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+    Scratch scratch(nPred);
+#pragma omp for schedule(dynamic, 1)
+    for (OMPBound rowIdx = 0; rowIdx < spanEnd; rowIdx++) {
+      evalRow(predict, rowStart + rowIdx, blockNum, blockFac, rowIdx, span, scratch);
+    }
+  }
+}
+
+
+void LocalImp::evalRow(const Predict* predict,
+		       size_t row,
+		       const double* blockNum,
+		       const CtgT* blockFac,
+		       size_t rowIdx,
+		       size_t span,
+		       Scratch& scratch) {
+  Philox stream(seed, row);
+  for (IndexT& donor : scratch.donor) {
+    donor = min(static_cast<IndexT>(stream.unif() * span), static_cast<IndexT>(span - 1));
+  }
+  fill(scratch.seen.begin(), scratch.seen.end(), 0);
+
+  const double* rowNT = blockNum == nullptr ? nullptr : blockNum + rowIdx * nPredNum;
+  const CtgT* rowFT = blockFac == nullptr ? nullptr : blockFac + rowIdx * (nPred - nPredNum);
+  double* rowImp = &importance[row * nPred * nOut];
+  unsigned int nReached = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    IndexT leafIdx;
+    if (!predict->isNodeIdx(row, tIdx, leafIdx))
+      continue;
+    nReached++;
+
+    // Retraces the path, which the leaf assignment alone does not record.
+    const BVSlotT* treeBits = &bitPool[bitOrigin[tIdx]];
+    scratch.path.clear();
+    size_t nodeIdx = nodeOrigin[tIdx];
+    while (!decNode[nodeIdx].isTerminal()) {
+      scratch.path.push_back(nodeIdx);
+      nodeIdx += advance(decNode[nodeIdx], treeBits, rowNT, rowFT);
+    }
+    size_t baseLeaf = nodeIdx;
+
+    for (size_t pathNode : scratch.path) {
+      PredictorT predIdx = decNode[pathNode].getPredIdx();
+      if (scratch.seen[predIdx] == tIdx + 1)
+	continue;
+      scratch.seen[predIdx] = tIdx + 1;
+      IndexT donor = scratch.donor[predIdx];
+      size_t donorLeaf = walkDonor(tIdx, pathNode, predIdx, rowNT, rowFT,
+				   blockNum == nullptr ? nullptr : blockNum + donor * nPredNum,
+				   blockFac == nullptr ? nullptr : blockFac + donor * (nPred - nPredNum));
+      if (donorLeaf != baseLeaf) {
+	addLeaf(donorLeaf, &rowImp[predIdx * nOut], 1.0);
+	addLeaf(baseLeaf, &rowImp[predIdx * nOut], -1.0);
+      }
+    }
+  }
+
+  if (nReached == 0) { // Bagged in every tree.
+    fill(rowImp, rowImp + nPred * nOut, nan(""));
+  }
+  else {
+    double scale = 1.0 / nReached;
+    for (size_t idx = 0; idx < nPred * nOut; idx++) {
+      rowImp[idx] *= scale;
+    }
+  }
+}
+
+
+size_t LocalImp::walkDonor(unsigned int tIdx,
+			   size_t nodeIdx,
+			   PredictorT predIdx,
+			   const double rowNT[],
+			   const CtgT rowFT[],
+			   const double donorNT[],
+			   const CtgT donorFT[]) const {
+  const BVSlotT* treeBits = &bitPool[bitOrigin[tIdx]];
+  while (!decNode[nodeIdx].isTerminal()) {
+    const DecNode& node = decNode[nodeIdx];
+    if (node.getPredIdx() == predIdx)
+      nodeIdx += advance(node, treeBits, donorNT, donorFT);
+    else
+      nodeIdx += advance(node, treeBits, rowNT, rowFT);
+  }
+  return nodeIdx;
+}
@@ -0,0 +1,168 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file localimp.h
+
+   @brief Per-row permutation importance by selective tree re-walking.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_LOCALIMP_H
+#define FOREST_LOCALIMP_H
+
+#include "typeparam.h"
+#include "bv.h"
+#include "arena.h"
+#include "decnode.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Measures, for each row and predictor, the change in output
+   when the row's value of the predictor alone is taken from a donor.
+
+   Donors are drawn uniformly from the row's scoring block, from a
+   stream keyed by row, so that estimates are reproducible under a
+   fixed front-end seed.  A tree whose path for the row does not split
+   on a predictor reaches the same leaf under substitution, so only
+   the trees splitting on the predictor along the path are re-walked,
+   and then only from the first such split.  A row therefore costs on
+   the order of path length times the predictors on its paths, rather
+   than a full prediction per predictor.
+
+   Regression measures the change in score, classification the change
+   in vote fraction of each training category.
+ */
+class LocalImp {
+  const Arena<DecNode>& decNode; ///> Forest-wide node arena.
+  const vector<size_t>& nodeOrigin; ///> Per-tree offsets into arena.
+  const Arena<double>& scoreBlock; ///> Scores, indexed as decNode.
+  const BVSlotT* bitPool; ///> Forest-wide factor bits.
+  const vector<size_t>& bitOrigin; ///> Per-tree offsets into bit pool.
+  const unsigned int nTree;
+  const PredictorT nPredNum;
+  const PredictorT nPred;
+  const unsigned int nOut; ///> # outputs:  categories, else one.
+  const bool ctg; ///> Whether measuring category votes.
+  const uint64_t seed; ///> Keys donor streams.
+  vector<double> importance; ///> Row x core predictor x output.
+
+
+  /**
+     @brief Per-thread workspace.
+   */
+  struct Scratch {
+    vector<size_t> path; ///> Forest-wide nodes on the row's path.
+    vector<unsigned int> seen; ///> Tree stamp, by predictor.
+    vector<IndexT> donor; ///> Block-relative donor row, by predictor.
+
+    Scratch(PredictorT nPred) :
+      seen(nPred),
+      donor(nPred) {
+    }
+  };
+
+
+  /**
+     @brief Adds a leaf's output at a given output slot.
+   */
+  inline void addLeaf(size_t nodeIdx,
+		      double* accOut,
+		      double sign) const {
+    if (ctg) {
+      unsigned int ctgLeaf = static_cast<unsigned int>(scoreBlock[nodeIdx]);
+      if (ctgLeaf < nOut)
+	accOut[ctgLeaf] += sign;
+    }
+    else {
+      accOut[0] += sign * scoreBlock[nodeIdx];
+    }
+  }
+
+
+  /**
+     @return successor offset of a node for a given row.
+   */
+  inline IndexT advance(const DecNode& node,
+			const BVSlotT* treeBits,
+			const double rowNT[],
+			const CtgT rowFT[]) const {
+    PredictorT splitIdx = node.getPredIdx();
+    return splitIdx < nPredNum ? node.advanceNum(rowNT[splitIdx]) : node.advanceFactor(treeBits, rowFT[splitIdx - nPredNum]);
+  }
+
+
+  /**
+     @brief Walks a tree from a given node, substituting the donor's
+     value of a single predictor.
+
+     @return forest-wide index of the leaf reached.
+   */
+  size_t walkDonor(unsigned int tIdx,
+		   size_t nodeIdx,
+		   PredictorT predIdx,
+		   const double rowNT[],
+		   const CtgT rowFT[],
+		   const double donorNT[],
+		   const CtgT donorFT[]) const;
+
+
+  /**
+     @brief Measures all predictors at a single row.
+   */
+  void evalRow(const class Predict* predict,
+	       size_t row,
+	       const double* blockNum,
+	       const CtgT* blockFac,
+	       size_t rowIdx,
+	       size_t span,
+	       Scratch& scratch);
+
+public:
+
+  /**
+     @param nCtg is the training cardinality, zero iff regression.
+   */
+  LocalImp(const class Forest* forest,
+	   PredictorT nPredNum_,
+	   PredictorT nPredFac,
+	   unsigned int nCtg,
+	   size_t nRow);
+
+
+  /**
+     @brief Measures the rows of a predicted block.
+
+     Parameters as PartialDep::accumulate().
+   */
+  void accumulate(const class Predict* predict,
+		  const double* blockNum,
+		  const CtgT* blockFac,
+		  size_t rowStart,
+		  size_t span);
+
+
+  unsigned int getNOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @return mean changes, row x core predictor x output.
+   */
+  const vector<double>& getImportance() const {
+    return importance;
+  }
+};
+
+#endif
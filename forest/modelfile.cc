@@ -0,0 +1,239 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelfile.cc
+
+   @brief Writing and mapping of binary model containers.
+
+   @author Mark Seligman
+ */
+
+#include "modelfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Offsets persist as size_t in core, uint64 on disk.
+static_assert(sizeof(size_t) == sizeof(uint64_t), "Model files require 64-bit offsets");
+
+const uint64_t ModelFile::magic = 0x4c45444f4d425241ull; // "ARBMODEL", little-endian.
+const uint32_t ModelFile::version = 1;
+const uint32_t ModelFile::endianTag = 0x01020304;
+const size_t ModelFile::alignment = 64;
+
+
+void ModelWriter::write(const string& path) {
+  uint64_t offset = ModelFile::alignUp(sizeof(ModelFile::Header) + directory.size() * sizeof(ModelFile::BlockEntry));
+  for (auto & blockEntry : directory) {
+    blockEntry.offset = offset;
+    offset = ModelFile::alignUp(offset + blockEntry.count * blockEntry.unitSize);
+  }
+  ModelFile::Header header{ModelFile::magic, ModelFile::version, ModelFile::endianTag, directory.size(), offset};
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw runtime_error("Cannot open model file for writing:  " + path);
+  }
+
+  static const unsigned char pad[64] = {0};
+  uint64_t written = 0;
+  auto emit = [&](const void* src, size_t nByte) {
+    if (nByte > 0 && fwrite(src, 1, nByte, file) != nByte) {
+      fclose(file);
+      throw runtime_error("Short write to model file:  " + path);
+    }
+    written += nByte;
+  };
+  auto copySpill = [&](FILE* src, uint64_t nByte) {
+    vector<unsigned char> buffer(min<uint64_t>(nByte, 1 << 20));
+    rewind(src);
+    while (nByte > 0) {
+      size_t nCopy = min<uint64_t>(nByte, buffer.size());
+      if (fread(buffer.data(), 1, nCopy, src) != nCopy) {
+	fclose(file);
+	throw runtime_error("Short read from model spill file");
+      }
+      emit(buffer.data(), nCopy);
+      nByte -= nCopy;
+    }
+  };
+  auto padTo = [&](uint64_t target) {
+    while (written < target) {
+      emit(pad, min<uint64_t>(sizeof(pad), target - written));
+    }
+  };
+
+  emit(&header, sizeof(header));
+  emit(directory.data(), directory.size() * sizeof(ModelFile::BlockEntry));
+  for (size_t blockIdx = 0; blockIdx < directory.size(); blockIdx++) {
+    const ModelFile::BlockEntry& blockEntry = directory[blockIdx];
+    padTo(blockEntry.offset);
+    if (spill[blockIdx] == nullptr) {
+      emit(payload[blockIdx], blockEntry.count * blockEntry.unitSize);
+    }
+    else {
+      copySpill(spill[blockIdx], blockEntry.count * blockEntry.unitSize);
+    }
+  }
+  padTo(offset);
+
+  if (fclose(file) != 0) {
+    throw runtime_error("Cannot close model file:  " + path);
+  }
+}
+
+
+ModelMap::ModelMap(const string& path) :
+  base(nullptr),
+  nByte(0),
+  header(nullptr),
+  directory(nullptr) {
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw runtime_error("Cannot open model file:  " + path);
+  }
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0) {
+    close(fd);
+    throw runtime_error("Cannot query model file:  " + path);
+  }
+  nByte = fileStat.st_size;
+  if (nByte >= sizeof(ModelFile::Header)) {
+    void* addr = mmap(nullptr, nByte, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      throw runtime_error("Cannot map model file:  " + path);
+    }
+    base = static_cast<const unsigned char*>(addr);
+  }
+  close(fd); // Mapping persists.
+#else
+  // No mapping:  reads the file whole.
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    throw runtime_error("Cannot open model file:  " + path);
+  }
+  fseek(file, 0, SEEK_END);
+  nByte = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  owned = vector<unsigned char>(nByte);
+  size_t nRead = fread(owned.data(), 1, nByte, file);
+  fclose(file);
+  if (nRead != nByte) {
+    throw runtime_error("Short read from model file:  " + path);
+  }
+  base = owned.data();
+#endif
+
+  try {
+    validate();
+  }
+  catch (...) {
+#ifndef _WIN32
+    if (base != nullptr) {
+      munmap(const_cast<unsigned char*>(base), nByte);
+    }
+#endif
+    throw;
+  }
+}
+
+
+ModelMap::~ModelMap() {
+#ifndef _WIN32
+  if (base != nullptr) {
+    munmap(const_cast<unsigned char*>(base), nByte);
+  }
+#endif
+}
+
+
+void ModelMap::prefault() const {
+#ifndef _WIN32
+  if (base == nullptr)
+    return;
+  madvise(const_cast<unsigned char*>(base), nByte, MADV_WILLNEED);
+  size_t pageSize = sysconf(_SC_PAGESIZE);
+  volatile unsigned char sink = 0;
+  for (size_t offset = 0; offset < nByte; offset += pageSize) {
+    sink = sink ^ base[offset];
+  }
+#endif
+}
+
+
+void ModelMap::validate() {
+  if (nByte < sizeof(ModelFile::Header)) {
+    throw invalid_argument("Model file truncated");
+  }
+  const ModelFile::Header* head = reinterpret_cast<const ModelFile::Header*>(base);
+  if (head->magic != ModelFile::magic) {
+    throw invalid_argument("Not a model file");
+  }
+  if (head->endian != ModelFile::endianTag) {
+    throw invalid_argument("Model file written with foreign byte order");
+  }
+  if (head->version != ModelFile::version) {
+    throw invalid_argument("Unsupported model file version");
+  }
+  if (head->nByte != nByte || head->nBlock > (nByte - sizeof(ModelFile::Header)) / sizeof(ModelFile::BlockEntry)) {
+    throw invalid_argument("Model file truncated");
+  }
+  const ModelFile::BlockEntry* dir = reinterpret_cast<const ModelFile::BlockEntry*>(base + sizeof(ModelFile::Header));
+  for (uint64_t blockIdx = 0; blockIdx < head->nBlock; blockIdx++) {
+    const ModelFile::BlockEntry& blockEntry = dir[blockIdx];
+    if (blockEntry.offset % ModelFile::alignment != 0 || blockEntry.offset > nByte || blockEntry.unitSize == 0
+	|| blockEntry.count > (nByte - blockEntry.offset) / blockEntry.unitSize) {
+      throw invalid_argument("Model file block out of bounds");
+    }
+  }
+
+  header = head;
+  directory = dir;
+}
+
+
+const ModelFile::BlockEntry* ModelMap::lookup(ModelFile::Tag tag) const {
+  for (uint64_t blockIdx = 0; blockIdx < header->nBlock; blockIdx++) {
+    if (directory[blockIdx].tag == static_cast<uint32_t>(tag)) {
+      return &directory[blockIdx];
+    }
+  }
+  return nullptr;
+}
+
+
+const ModelFile::BlockEntry* ModelMap::entry(ModelFile::Tag tag,
+					     size_t unitSize) const {
+  const ModelFile::BlockEntry* blockEntry = lookup(tag);
+  if (blockEntry == nullptr) {
+    throw invalid_argument("Model file missing required block");
+  }
+  if (blockEntry->unitSize != unitSize) {
+    throw invalid_argument("Model file block has incompatible item size");
+  }
+  return blockEntry;
+}
+
+
+uint64_t ModelMap::getScalar(ModelFile::Scalar pos) const {
+  const ModelFile::BlockEntry* blockEntry = entry(ModelFile::Tag::scalar, sizeof(uint64_t));
+  if (static_cast<uint64_t>(pos) >= blockEntry->count) {
+    throw invalid_argument("Model file scalar block too short");
+  }
+  return reinterpret_cast<const uint64_t*>(base + blockEntry->offset)[static_cast<uint32_t>(pos)];
+}
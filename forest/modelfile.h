@@ -0,0 +1,263 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelfile.h
+
+   @brief Versioned binary container for trained models.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_MODELFILE_H
+#define FOREST_MODELFILE_H
+
+#include "arena.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <stdexcept>
+
+using namespace std;
+
+
+/**
+   @brief Layout of the container.
+
+   A file consists of a fixed header, a directory of block entries and
+   the block payloads.  Each payload begins on an 'alignment' boundary,
+   so that a mapped file can be read in place as an array of items.
+   Payloads are written in native byte order and item layout:  the
+   header records the endianness and each entry its item size, so that
+   a foreign or stale file is rejected rather than misread.
+ */
+struct ModelFile {
+  static const uint64_t magic; // "ARBMODEL", native order.
+  static const uint32_t version; // Bumped on any incompatible change.
+  static const uint32_t endianTag; // Reads back permuted if foreign.
+  static const size_t alignment; // Payload alignment, in bytes.
+
+  /**
+     @brief Block identifiers.  Values are persisted:  append only.
+   */
+  enum class Tag : uint32_t {
+    scalar = 0, // Model-wide counts and flags, as uint64.
+    nodeOrigin, // Per-tree offset into decNode.
+    decNode, // Forest-wide node arena.
+    score, // Per-node score, indexed as decNode.
+    bitOrigin, // Per-tree slot offset into bitPool, plus sup.
+    bitPool, // Forest-wide factor-split bits.
+    bagCount, // Per-tree sampler extent.
+    samplerNux, // Packed sampler records, forest-wide.
+    yReg, // Numeric training response.
+    yCtg, // Categorical training response.
+    treeOrigin, // Per-tree offset into leafOrigin, plus sup.
+    leafOrigin, // Per-leaf offset into leafIndex, plus sup.
+    leafIndex, // Forest-wide sample indices, by leaf:  superseded.
+    leafPack, // Sample indices encoded by LeafPack.
+    rankCount // Packed rank counts, positioned as the sample indices.
+  };
+
+
+  /**
+     @brief Positions within the scalar block.
+   */
+  enum class Scalar : uint32_t {
+    nTree = 0,
+    nObs,
+    nSamp,
+    nCtg,
+    bagging,
+    thin,
+    nScalar // Count of scalars.
+  };
+
+
+  struct Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t endian;
+    uint64_t nBlock;
+    uint64_t nByte; // Total file size, for truncation checks.
+  };
+
+
+  struct BlockEntry {
+    uint32_t tag;
+    uint32_t unitSize; // Item size, in bytes.
+    uint64_t offset; // Payload offset from file base.
+    uint64_t count; // # items.
+  };
+
+
+  /**
+     @return least multiple of the alignment not below an offset.
+   */
+  static uint64_t alignUp(uint64_t offset) {
+    return ((offset + alignment - 1) / alignment) * alignment;
+  }
+};
+
+
+/**
+   @brief Gathers blocks and writes them as a single container.
+
+   Blocks are referenced, not copied, so their storage must remain live
+   until written.  Blocks too large to hold in memory may instead be
+   staged in a spill file, which is copied out piecewise.
+ */
+class ModelWriter {
+  vector<ModelFile::BlockEntry> directory;
+  vector<const void*> payload; // Block base, by directory entry.
+  vector<FILE*> spill; // Staging file, iff payload spilled.
+
+public:
+
+  /**
+     @brief Registers a block for writing.
+
+     @param base is the first item, possibly null if 'count' is zero.
+
+     @param count is the number of items.
+   */
+  template<typename itemType>
+  void add(ModelFile::Tag tag,
+	   const itemType* base,
+	   size_t count) {
+    static_assert(is_trivially_copyable<itemType>::value, "Block items must be trivially copyable");
+    directory.push_back(ModelFile::BlockEntry{static_cast<uint32_t>(tag), static_cast<uint32_t>(sizeof(itemType)), 0, count});
+    payload.push_back(base);
+    spill.push_back(nullptr);
+  }
+
+
+  template<typename itemType>
+  void add(ModelFile::Tag tag,
+	   const vector<itemType>& items) {
+    add(tag, items.data(), items.size());
+  }
+
+
+  /**
+     @brief Registers a block staged in a spill file.
+
+     @param file holds the block's items from its beginning, and
+     remains open until written.
+   */
+  template<typename itemType>
+  void addSpill(ModelFile::Tag tag,
+		FILE* file,
+		size_t count) {
+    static_assert(is_trivially_copyable<itemType>::value, "Block items must be trivially copyable");
+    directory.push_back(ModelFile::BlockEntry{static_cast<uint32_t>(tag), static_cast<uint32_t>(sizeof(itemType)), 0, count});
+    payload.push_back(nullptr);
+    spill.push_back(file);
+  }
+
+
+  /**
+     @brief Lays out the directory and writes header, directory and payloads.
+
+     @param path is the file to be created or truncated.
+   */
+  void write(const string& path);
+};
+
+
+/**
+   @brief Read-only view of a container, mapped where the platform permits.
+
+   Arenas obtained from the map alias its pages, so the map must outlive
+   any object built from them.
+ */
+class ModelMap {
+  const unsigned char* base; // File base, mapped or owned.
+  size_t nByte; // File size.
+  vector<unsigned char> owned; // Backing store, iff not mapped.
+  const ModelFile::Header* header;
+  const ModelFile::BlockEntry* directory;
+
+  /**
+     @brief Validates header, directory and payload bounds.
+   */
+  void validate();
+
+
+  /**
+     @return directory entry for a tag, if any, else null.
+   */
+  const ModelFile::BlockEntry* lookup(ModelFile::Tag tag) const;
+
+
+  /**
+     @brief Checks that a block's item size agrees with the reader's.
+
+     @return entry for the tag, required to exist.
+   */
+  const ModelFile::BlockEntry* entry(ModelFile::Tag tag,
+				     size_t unitSize) const;
+
+public:
+
+  /**
+     @brief Maps a file and validates its layout.
+
+     @param path names an existing container.
+   */
+  ModelMap(const string& path);
+
+
+  ~ModelMap();
+
+
+  ModelMap(const ModelMap&) = delete;
+  ModelMap& operator=(const ModelMap&) = delete;
+
+
+  /**
+     @brief Touches each page of the mapping, so that subsequent reads
+     incur no faults.
+   */
+  void prefault() const;
+
+
+  bool hasBlock(ModelFile::Tag tag) const {
+    return lookup(tag) != nullptr;
+  }
+
+
+  /**
+     @return scalar at a given position.
+   */
+  uint64_t getScalar(ModelFile::Scalar pos) const;
+
+
+  /**
+     @return arena aliasing a block in place.
+   */
+  template<typename itemType>
+  Arena<itemType> alias(ModelFile::Tag tag) const {
+    const ModelFile::BlockEntry* blockEntry = entry(tag, sizeof(itemType));
+    return Arena<itemType>(reinterpret_cast<const itemType*>(base + blockEntry->offset), blockEntry->count);
+  }
+
+
+  /**
+     @return copy of a block, for consumers requiring owned storage.
+   */
+  template<typename itemType>
+  vector<itemType> copy(ModelFile::Tag tag) const {
+    const ModelFile::BlockEntry* blockEntry = entry(tag, sizeof(itemType));
+    const itemType* items = reinterpret_cast<const itemType*>(base + blockEntry->offset);
+    return vector<itemType>(items, items + blockEntry->count);
+  }
+};
+
+#endif
@@ -0,0 +1,123 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelstream.cc
+
+   @brief Spilling of trained chunks to staging files.
+
+   @author Mark Seligman
+ */
+
+#include "modelstream.h"
+#include "modelfile.h"
+#include "forest.h"
+#include "leaf.h"
+#include "sampler.h"
+
+
+ModelStream::ModelStream(bool thin_) :
+  thin(thin_),
+  nodeSpill(tmpfile()),
+  scoreSpill(tmpfile()),
+  bitSpill(tmpfile()),
+  leafSpill(thin ? nullptr : tmpfile()),
+  indexSpill(thin ? nullptr : tmpfile()),
+  nodeTop(0),
+  bitTop(0),
+  leafTop(0),
+  indexTop(0),
+  packTop(0) {
+  if (nodeSpill == nullptr || scoreSpill == nullptr || bitSpill == nullptr
+      || (!thin && (leafSpill == nullptr || indexSpill == nullptr))) {
+    for (FILE* file : {nodeSpill, scoreSpill, bitSpill, leafSpill, indexSpill}) {
+      if (file != nullptr)
+	fclose(file);
+    }
+    throw runtime_error("Cannot create model spill file");
+  }
+}
+
+
+ModelStream::~ModelStream() {
+  for (FILE* file : {nodeSpill, scoreSpill, bitSpill, leafSpill, indexSpill}) {
+    if (file != nullptr)
+      fclose(file);
+  }
+}
+
+
+template<typename itemType>
+void ModelStream::append(FILE* file,
+			 const itemType* items,
+			 size_t count) {
+  if (count > 0 && fwrite(items, sizeof(itemType), count, file) != count) {
+    throw runtime_error("Short write to model spill file");
+  }
+}
+
+
+void ModelStream::consume(const Forest* forest,
+			  const Leaf* leaf,
+			  const Sampler* sampler,
+			  unsigned int treeOff) {
+  for (size_t extent : forest->getNodeExtents()) {
+    nodeOrigin.push_back(nodeTop);
+    nodeTop += extent;
+  }
+  const vector<DecNode>& node = forest->getNodeCresc();
+  append(nodeSpill, node.data(), node.size());
+  append(scoreSpill, forest->getScores().data(), forest->getScores().size());
+
+  for (size_t extent : forest->getFacExtents()) {
+    bitOrigin.push_back(bitTop);
+    bitTop += extent;
+  }
+  const vector<BVSlotT>& bits = forest->getSplitBitsCresc();
+  append(bitSpill, bits.data(), bits.size());
+
+  if (thin)
+    return;
+
+  // A tree's leaves partition its bag.
+  const vector<IndexT>& extent = leaf->getExtentCresc();
+  vector<size_t> leafOrigin;
+  leafOrigin.reserve(extent.size());
+  size_t leafIdx = 0;
+  for (unsigned int tIdx = treeOff; tIdx < treeOff + forest->getNodeExtents().size(); tIdx++) {
+    treeOrigin.push_back(leafTop + leafIdx);
+    size_t extentTree = 0;
+    while (extentTree < sampler->getBagCount(tIdx) && leafIdx < extent.size()) {
+      leafOrigin.push_back(indexTop);
+      indexTop += extent[leafIdx];
+      extentTree += extent[leafIdx++];
+    }
+  }
+  leafTop += leafIdx;
+  append(leafSpill, leafOrigin.data(), leafOrigin.size());
+  // Encodings are leaf-delimited, so chunks concatenate.
+  const vector<unsigned char>& pack = leaf->getPackCresc();
+  append(indexSpill, pack.data(), pack.size());
+  packTop += pack.size();
+}
+
+
+void ModelStream::addBlocks(ModelWriter& writer) {
+  bitOrigin.push_back(bitTop);
+  writer.add(ModelFile::Tag::nodeOrigin, nodeOrigin);
+  writer.addSpill<DecNode>(ModelFile::Tag::decNode, nodeSpill, nodeTop);
+  writer.addSpill<double>(ModelFile::Tag::score, scoreSpill, nodeTop);
+  writer.add(ModelFile::Tag::bitOrigin, bitOrigin);
+  writer.addSpill<BVSlotT>(ModelFile::Tag::bitPool, bitSpill, bitTop);
+  if (!thin) {
+    treeOrigin.push_back(leafTop);
+    append(leafSpill, &indexTop, 1);
+    writer.add(ModelFile::Tag::treeOrigin, treeOrigin);
+    writer.addSpill<size_t>(ModelFile::Tag::leafOrigin, leafSpill, leafTop + 1);
+    writer.addSpill<unsigned char>(ModelFile::Tag::leafPack, indexSpill, packTop);
+  }
+}
@@ -0,0 +1,114 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file modelstream.h
+
+   @brief Stages trained chunks for a binary model file.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_MODELSTREAM_H
+#define FOREST_MODELSTREAM_H
+
+#include "typeparam.h"
+#include "decnode.h"
+#include "bv.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Appends the forest and leaf blocks of successive chunks to
+   spill files, so that a forest need never be resident in full.
+
+   Per-tree origins are retained in memory, as are the leaves' only
+   when thin.  The spilled blocks are copied into the container once
+   training completes.
+ */
+class ModelStream {
+  const bool thin; // Whether leaf maps are omitted.
+  FILE* nodeSpill; // Nodes, forest-wide.
+  FILE* scoreSpill; // Scores, parallel to nodes.
+  FILE* bitSpill; // Factor-split bits, forest-wide.
+  FILE* leafSpill; // Per-leaf offset into index, iff not thin.
+  FILE* indexSpill; // Encoded sample indices, by leaf, iff not thin.
+  vector<size_t> nodeOrigin; // Per-tree offset into nodes.
+  vector<size_t> bitOrigin; // Per-tree slot offset into bits, plus sup.
+  vector<size_t> treeOrigin; // Per-tree offset into leaf origins, plus sup.
+  size_t nodeTop; // # nodes spilled.
+  size_t bitTop; // # bit slots spilled.
+  size_t leafTop; // # leaves spilled.
+  size_t indexTop; // # sample indices spilled.
+  size_t packTop; // # bytes of encoded indices spilled.
+
+
+  /**
+     @brief Appends items to a spill file.
+   */
+  template<typename itemType>
+  static void append(FILE* file,
+		     const itemType* items,
+		     size_t count);
+
+public:
+
+  ModelStream(bool thin_);
+
+
+  ~ModelStream();
+
+
+  ModelStream(const ModelStream&) = delete;
+  ModelStream& operator=(const ModelStream&) = delete;
+
+
+  /**
+     @brief Spills a trained chunk.
+
+     @param forest is the chunk's crescent forest.
+
+     @param leaf is the chunk's crescent leaf.
+
+     @param sampler supplies the bag counts delimiting each tree's leaves.
+
+     @param treeOff is the absolute index of the chunk's leading tree.
+   */
+  void consume(const class Forest* forest,
+	       const struct Leaf* leaf,
+	       const class Sampler* sampler,
+	       unsigned int treeOff);
+
+
+  /**
+     @return number of trees consumed.
+   */
+  unsigned int getNTree() const {
+    return nodeOrigin.size();
+  }
+
+
+  bool isThin() const {
+    return thin;
+  }
+
+
+  /**
+     @brief Closes the origin vectors and registers the forest and leaf
+     blocks for writing.
+
+     @param writer receives the blocks, and is written while this
+     object remains live.
+   */
+  void addBlocks(class ModelWriter& writer);
+};
+
+#endif
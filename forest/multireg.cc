@@ -0,0 +1,105 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file multireg.cc
+
+   @brief Estimation of several regression responses from a single walk.
+
+   @author Mark Seligman
+ */
+
+#include "multireg.h"
+#include "predict.h"
+#include "sampler.h"
+#include "leaf.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+MultiReg::MultiReg(const Sampler* sampler,
+		   const Leaf* leaf_,
+		   size_t nRow,
+		   const vector<double>& yTrain,
+		   unsigned int nOut_) :
+  leaf(leaf_),
+  nOut(nOut_),
+  yPred(nRow * nOut) {
+  if (nOut == 0 || yTrain.size() != sampler->getNObs() * nOut)
+    throw invalid_argument("Responses must conform with training rows");
+  if (leaf == nullptr || leaf->isThin())
+    throw invalid_argument("Multiple responses require leaf contents:  train without thinning");
+  if (!sampler->hasSamples())
+    throw invalid_argument("Multiple responses require sampler contents");
+  scoreLeaves(sampler, yTrain);
+}
+
+
+void MultiReg::scoreLeaves(const Sampler* sampler,
+			   const vector<double>& yTrain) {
+  const vector<size_t>& treeOrigin = leaf->getTreeOrigin();
+  const vector<size_t>& leafOrigin = leaf->getLeafOrigin();
+  const vector<IndexT>& index = leaf->getIndex();
+  leafScore = vector<double>(leaf->getLeafTotal() * nOut);
+  size_t nObs = sampler->getNObs();
+
+  OMPBound treeEnd = treeOrigin.empty() ? 0 : sampler->getNTree();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+    IndexT row = 0;
+    vector<IndexT> sIdx2Row(sampler->getBagCount(tIdx));
+    for (IndexT sIdx = 0; sIdx != sIdx2Row.size(); sIdx++) {
+      row += sampler->getDelRow(tIdx, sIdx);
+      sIdx2Row[sIdx] = row;
+    }
+    for (size_t leafPos = treeOrigin[tIdx]; leafPos != treeOrigin[tIdx + 1]; leafPos++) {
+      double* score = &leafScore[leafPos * nOut];
+      IndexT sCountLeaf = 0;
+      for (size_t idx = leafOrigin[leafPos]; idx != leafOrigin[leafPos + 1]; idx++) {
+	IndexT sIdx = index[idx];
+	IndexT sCount = sampler->getSCount(tIdx, sIdx);
+	for (unsigned int out = 0; out < nOut; out++) {
+	  score[out] += sCount * yTrain[out * nObs + sIdx2Row[sIdx]];
+	}
+	sCountLeaf += sCount;
+      }
+      if (sCountLeaf > 0) {
+	for (unsigned int out = 0; out < nOut; out++) {
+	  score[out] /= sCountLeaf;
+	}
+      }
+    }
+  }
+  }
+}
+
+
+void MultiReg::predictRow(const Predict* predict,
+			  size_t row) {
+  double* rowPred = &yPred[row * nOut];
+  fill(rowPred, rowPred + nOut, 0.0);
+  unsigned int nTree = 0;
+  for (unsigned int tIdx = 0; tIdx < predict->getNTree(); tIdx++) {
+    IndexT leafIdx;
+    if (predict->isLeafIdx(row, tIdx, leafIdx)) {
+      const double* score = &leafScore[leaf->getLeafPos(tIdx, leafIdx) * nOut];
+      for (unsigned int out = 0; out < nOut; out++) {
+	rowPred[out] += score[out];
+      }
+      nTree++;
+    }
+  }
+
+  for (unsigned int out = 0; out < nOut; out++) {
+    rowPred[out] = nTree == 0 ? nan("") : rowPred[out] / nTree;
+  }
+}
@@ -0,0 +1,89 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file multireg.h
+
+   @brief Estimation of several regression responses from a single walk.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_MULTIREG_H
+#define FOREST_MULTIREG_H
+
+#include "typeparam.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Scores each leaf by the mean of every response over its
+   samples, so that one walk of the forest estimates all responses.
+
+   Splitting is trained jointly, on the squared error summed over the
+   responses.  Each leaf's score vector is the sample-weighted mean
+   of its bagged rows' responses, and a row's estimate is the mean of
+   the score vectors of the leaves it reaches.
+ */
+class MultiReg {
+  const struct Leaf* leaf;
+  const unsigned int nOut; ///> # responses.
+  vector<double> leafScore; ///> Leaf x response means.
+  vector<double> yPred; ///> Row x response estimates.
+
+
+  /**
+     @brief Accumulates the response means of every leaf.
+
+     @param yTrain holds each response over all training rows in turn.
+   */
+  void scoreLeaves(const class Sampler* sampler,
+		   const vector<double>& yTrain);
+
+public:
+
+  /**
+     @param nRow is the number of rows to be estimated.
+
+     @param yTrain is response-major, as above.
+
+     @param nOut is the number of responses.
+   */
+  MultiReg(const class Sampler* sampler,
+	   const struct Leaf* leaf_,
+	   size_t nRow,
+	   const vector<double>& yTrain,
+	   unsigned int nOut_);
+
+
+  /**
+     @brief Estimates every response of a walked row.
+   */
+  void predictRow(const class Predict* predict,
+		  size_t row);
+
+
+  /**
+     @return number of responses.
+   */
+  unsigned int getNOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @return row-major estimates.
+   */
+  const vector<double>& getYPred() const {
+    return yPred;
+  }
+};
+
+#endif
@@ -0,0 +1,93 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file nodetraffic.cc
+
+   @brief Per-node prediction traffic, for comparison with training cover.
+
+   @author Mark Seligman
+ */
+
+#include "nodetraffic.h"
+#include "forest.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+NodeTraffic::NodeTraffic(const Forest* forest,
+			 const Leaf* leaf) :
+  decNode(forest->getNode()),
+  nodeOrigin(forest->getNodeOrigin()),
+  nTree(forest->getNTree()),
+  cover(forest->getIndex().getCover(leaf)),
+  termCount(decNode.size()),
+  nRow(0) {
+}
+
+
+void NodeTraffic::record(const IndexT predictLeaves[],
+			 size_t span,
+			 IndexT noNode) {
+  OMPBound treeEnd = static_cast<OMPBound>(nTree);
+#pragma omp parallel for default(shared) schedule(dynamic, 1) num_threads(max(1u, OmpThread::nThread))
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+    size_t* treeCount = &termCount[nodeOrigin[tIdx]];
+    for (size_t rowIdx = 0; rowIdx < span; rowIdx++) {
+      IndexT termIdx = predictLeaves[nTree * rowIdx + tIdx];
+      if (termIdx != noNode)
+	treeCount[termIdx]++;
+    }
+  }
+  nRow += span;
+}
+
+
+vector<size_t> NodeTraffic::getTraffic() const {
+  vector<size_t> traffic(termCount);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeStart = nodeOrigin[tIdx];
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : decNode.size();
+    // Successors lie above their predecessor, so reverse order sums upward.
+    for (size_t nodeIdx = nodeEnd; nodeIdx-- > nodeStart; ) {
+      IndexT delIdx = decNode[nodeIdx].getDelIdx();
+      if (delIdx != 0)
+	traffic[nodeIdx] += traffic[nodeIdx + delIdx] + traffic[nodeIdx + delIdx + 1];
+    }
+  }
+  return traffic;
+}
+
+
+vector<double> NodeTraffic::getDrift() const {
+  vector<double> drift(nTree);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeStart = nodeOrigin[tIdx];
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : decNode.size();
+    double leafTraffic = 0.0;
+    double leafCover = 0.0;
+    for (size_t nodeIdx = nodeStart; nodeIdx < nodeEnd; nodeIdx++) {
+      if (decNode[nodeIdx].isTerminal()) {
+	leafTraffic += termCount[nodeIdx];
+	leafCover += cover[nodeIdx];
+      }
+    }
+    if (leafTraffic == 0.0 || leafCover == 0.0) {
+      drift[tIdx] = nan("");
+      continue;
+    }
+    double distance = 0.0;
+    for (size_t nodeIdx = nodeStart; nodeIdx < nodeEnd; nodeIdx++) {
+      if (decNode[nodeIdx].isTerminal())
+	distance += fabs(termCount[nodeIdx] / leafTraffic - cover[nodeIdx] / leafCover);
+    }
+    drift[tIdx] = 0.5 * distance;
+  }
+  return drift;
+}
@@ -0,0 +1,90 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file nodetraffic.h
+
+   @brief Per-node prediction traffic, for comparison with training cover.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_NODETRAFFIC_H
+#define FOREST_NODETRAFFIC_H
+
+#include "typeparam.h"
+#include "arena.h"
+#include "decnode.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Tallies the rows reaching each node of the forest.
+
+   Walkers are not instrumented.  A row visits exactly the ancestors of
+   the node at which it terminates, so only terminations are counted,
+   from each block's leaf assignments, and visits to nonterminals are
+   recovered on request by summing upward.  Counting is partitioned by
+   tree, each of which owns a contiguous range of the arena, so that
+   threads share neither counters nor cache lines other than at tree
+   boundaries.
+ */
+class NodeTraffic {
+  const Arena<DecNode>& decNode; ///> Forest-wide node arena.
+  const vector<size_t>& nodeOrigin; ///> Per-tree offsets into arena.
+  const unsigned int nTree;
+  const vector<double>& cover; ///> Training samples reaching node.
+  vector<size_t> termCount; ///> Rows terminating at node, indexed as decNode.
+  size_t nRow; ///> # rows tallied.
+
+public:
+
+  /**
+     @param leaf supplies the training cover, so must not be thinned.
+   */
+  NodeTraffic(const class Forest* forest,
+	      const struct Leaf* leaf);
+
+
+  /**
+     @brief Tallies the terminations of a predicted block.
+
+     @param predictLeaves are the block's row x tree terminal indices.
+
+     @param noNode marks a tree not walked, as when bagged.
+   */
+  void record(const IndexT predictLeaves[],
+	      size_t span,
+	      IndexT noNode);
+
+
+  size_t getNRow() const {
+    return nRow;
+  }
+
+
+  /**
+     @return rows reaching each node, indexed as the node arena.
+   */
+  vector<size_t> getTraffic() const;
+
+
+  /**
+     @brief Measures, by tree, the departure of leaf traffic from
+     training cover.
+
+     @return total-variation distance between the distributions of
+     prediction and training samples over leaves, per tree; NaN if no
+     row reached a leaf.
+   */
+  vector<double> getDrift() const;
+};
+
+#endif
@@ -0,0 +1,205 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file partialdep.cc
+
+   @brief Partial dependence and individual conditional expectation.
+
+   @author Mark Seligman
+ */
+
+#include "partialdep.h"
+#include "forest.h"
+#include "predict.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+
+PartialDep::PartialDep(const Forest* forest,
+		       PredictorT nPredNum_,
+		       PredictorT nPredFac_,
+		       unsigned int nCtg,
+		       size_t nRow_,
+		       vector<PredictorT> predIdx_,
+		       vector<vector<double>> grid_,
+		       bool ice_) :
+  decNode(forest->getNode()),
+  nodeOrigin(forest->getNodeOrigin()),
+  scoreBlock(forest->getTreeScores()),
+  bitPool(forest->getBitPool()),
+  bitOrigin(forest->getBitOrigin()),
+  nTree(forest->getNTree()),
+  nPredNum(nPredNum_),
+  nPredFac(nPredFac_),
+  nOut(nCtg == 0 ? 1 : nCtg),
+  ctg(nCtg > 0),
+  nRow(nRow_),
+  predIdx(move(predIdx_)),
+  grid(move(grid_)),
+  ice(ice_),
+  nRowPD(predIdx.size()) {
+  if (grid.size() != predIdx.size())
+    throw invalid_argument("Partial dependence requires a grid per predictor");
+
+  const ForestIndex& forestIndex = forest->getIndex();
+  for (unsigned int curveIdx = 0; curveIdx < predIdx.size(); curveIdx++) {
+    PredictorT pred = predIdx[curveIdx];
+    if (pred >= nPredNum + nPredFac)
+      throw invalid_argument("Partial dependence predictor out of range");
+    for (double val : grid[curveIdx]) {
+      if (pred >= nPredNum && !(val >= 0.0))
+	throw invalid_argument("Factor grid values must be nonnegative codes");
+    }
+    predTree.push_back(forestIndex.getSplitTree(pred));
+    pdSum.emplace_back(grid[curveIdx].size() * nOut);
+    iceVal.emplace_back(ice ? nRow * grid[curveIdx].size() * nOut : 0);
+  }
+}
+
+
+void PartialDep::accumulate(const Predict* predict,
+			    const double* blockNum,
+			    const CtgT* blockFac,
+			    size_t rowStart,
+			    size_t span) {
+  size_t gridMax = 0;
+  for (const vector<double>& gridCurve : grid) {
+    gridMax = max(gridMax, gridCurve.size());
+  }
+
+  OMPBound spanEnd = static_cast<OMPBound>(span);
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+    Scratch scratch(nOut, gridMax);
+    vector<vector<double>> pdLocal;
+    for (const vector<double>& pdCurve : pdSum) {
+      pdLocal.emplace_back(pdCurve.size());
+    }
+    vector<size_t> nRowLocal(predIdx.size());
+#pragma omp for schedule(dynamic, 1) nowait
+    for (OMPBound rowIdx = 0; rowIdx < spanEnd; rowIdx++) {
+      evalRow(predict, rowStart + rowIdx,
+	      blockNum == nullptr ? nullptr : blockNum + rowIdx * nPredNum,
+	      blockFac == nullptr ? nullptr : blockFac + rowIdx * nPredFac,
+	      scratch, pdLocal, nRowLocal);
+    }
+#pragma omp critical(partialDep)
+    {
+    for (unsigned int curveIdx = 0; curveIdx < predIdx.size(); curveIdx++) {
+      for (size_t idx = 0; idx < pdLocal[curveIdx].size(); idx++) {
+	pdSum[curveIdx][idx] += pdLocal[curveIdx][idx];
+      }
+      nRowPD[curveIdx] += nRowLocal[curveIdx];
+    }
+    }
+  }
+}
+
+
+void PartialDep::evalRow(const Predict* predict,
+			 size_t row,
+			 const double rowNT[],
+			 const CtgT rowFT[],
+			 Scratch& scratch,
+			 vector<vector<double>>& pdLocal,
+			 vector<size_t>& nRowLocal) {
+  // Sums the base leaves once, for reuse by every curve.
+  fill(scratch.rowTotal.begin(), scratch.rowTotal.end(), 0.0);
+  unsigned int nReached = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    IndexT nodeIdx;
+    if (predict->isNodeIdx(row, tIdx, nodeIdx)) {
+      addLeaf(nodeOrigin[tIdx] + nodeIdx, &scratch.rowTotal[0], 1.0);
+      nReached++;
+    }
+  }
+
+  for (unsigned int curveIdx = 0; curveIdx < predIdx.size(); curveIdx++) {
+    size_t nGrid = grid[curveIdx].size();
+    double* iceRow = ice ? &iceVal[curveIdx][row * nGrid * nOut] : nullptr;
+    if (nReached == 0) { // Bagged in every tree.
+      if (ice)
+	fill(iceRow, iceRow + nGrid * nOut, nan(""));
+      continue;
+    }
+
+    for (size_t gridIdx = 0; gridIdx < nGrid; gridIdx++) {
+      copy(scratch.rowTotal.begin(), scratch.rowTotal.end(), &scratch.acc[gridIdx * nOut]);
+    }
+    for (unsigned int tIdx : predTree[curveIdx]) {
+      IndexT nodeIdx;
+      if (predict->isNodeIdx(row, tIdx, nodeIdx)) {
+	for (size_t gridIdx = 0; gridIdx < nGrid; gridIdx++) {
+	  addLeaf(nodeOrigin[tIdx] + nodeIdx, &scratch.acc[gridIdx * nOut], -1.0);
+	}
+	iota(scratch.gridIdx.begin(), scratch.gridIdx.begin() + nGrid, 0);
+	walkGrid(tIdx, nodeOrigin[tIdx], curveIdx, rowNT, rowFT, scratch, 0, nGrid);
+      }
+    }
+
+    double scale = 1.0 / nReached;
+    for (size_t idx = 0; idx < nGrid * nOut; idx++) {
+      double val = scratch.acc[idx] * scale;
+      pdLocal[curveIdx][idx] += val;
+      if (ice)
+	iceRow[idx] = val;
+    }
+    nRowLocal[curveIdx]++;
+  }
+}
+
+
+void PartialDep::walkGrid(unsigned int tIdx,
+			  size_t nodeIdx,
+			  unsigned int curveIdx,
+			  const double rowNT[],
+			  const CtgT rowFT[],
+			  Scratch& scratch,
+			  size_t gridStart,
+			  size_t gridEnd) const {
+  PredictorT curvePred = predIdx[curveIdx];
+  const BVSlotT* treeBits = &bitPool[bitOrigin[tIdx]];
+  while (!decNode[nodeIdx].isTerminal()) {
+    const DecNode& node = decNode[nodeIdx];
+    PredictorT splitIdx = node.getPredIdx();
+    if (splitIdx == curvePred) {
+      const vector<double>& gridCurve = grid[curveIdx];
+      IndexT delTrue = node.getDelIdx();
+      auto gridBase = scratch.gridIdx.begin();
+      auto gridMid = partition(gridBase + gridStart, gridBase + gridEnd,
+			       [&](unsigned int gridIdx) {
+				 double val = gridCurve[gridIdx];
+				 return (splitIdx < nPredNum ? node.advanceNum(val) : node.advanceFactor(treeBits, static_cast<CtgT>(val))) == delTrue;
+			       });
+      size_t gridSplit = gridMid - gridBase;
+      if (gridSplit > gridStart)
+	walkGrid(tIdx, nodeIdx + delTrue, curveIdx, rowNT, rowFT, scratch, gridStart, gridSplit);
+      if (gridEnd > gridSplit)
+	walkGrid(tIdx, nodeIdx + delTrue + 1, curveIdx, rowNT, rowFT, scratch, gridSplit, gridEnd);
+      return;
+    }
+    nodeIdx += splitIdx < nPredNum ? node.advanceNum(rowNT[splitIdx]) : node.advanceFactor(treeBits, rowFT[splitIdx - nPredNum]);
+  }
+
+  for (size_t idx = gridStart; idx < gridEnd; idx++) {
+    addLeaf(nodeIdx, &scratch.acc[scratch.gridIdx[idx] * nOut], 1.0);
+  }
+}
+
+
+vector<double> PartialDep::getPD(unsigned int curveIdx) const {
+  vector<double> pd(pdSum[curveIdx]);
+  for (double& val : pd) {
+    val = nRowPD[curveIdx] == 0 ? nan("") : val / nRowPD[curveIdx];
+  }
+  return pd;
+}
@@ -0,0 +1,189 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file partialdep.h
+
+   @brief Partial dependence and individual conditional expectation.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PARTIALDEP_H
+#define FOREST_PARTIALDEP_H
+
+#include "typeparam.h"
+#include "bv.h"
+#include "arena.h"
+#include "decnode.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Evaluates the forest over a grid of values for selected
+   predictors, all other predictors held at each row's observations.
+
+   Rows are walked once, unmodified, by prediction proper.  Trees not
+   splitting on a curve's predictor reach the same leaf at every grid
+   value, so their base leaves are reused.  Each remaining tree is
+   walked once per row, the grid being partitioned at every split on
+   the predictor, so that each leaf is scored for exactly those grid
+   values reaching it.
+
+   Regression evaluates the score, classification the vote fraction of
+   each training category.
+ */
+class PartialDep {
+  const Arena<DecNode>& decNode; ///> Forest-wide node arena.
+  const vector<size_t>& nodeOrigin; ///> Per-tree offsets into arena.
+  const Arena<double>& scoreBlock; ///> Scores, indexed as decNode.
+  const BVSlotT* bitPool; ///> Forest-wide factor bits.
+  const vector<size_t>& bitOrigin; ///> Per-tree offsets into bit pool.
+  const unsigned int nTree;
+  const PredictorT nPredNum;
+  const PredictorT nPredFac;
+  const unsigned int nOut; ///> # outputs:  categories, else one.
+  const bool ctg; ///> Whether evaluating category votes.
+  const size_t nRow;
+  const vector<PredictorT> predIdx; ///> Core predictor, by curve.
+  const vector<vector<double>> grid; ///> Grid values, by curve; factor codes iff factor.
+  const bool ice; ///> Whether retaining row-level curves.
+  vector<vector<unsigned int>> predTree; ///> Trees splitting on each curve's predictor.
+  vector<vector<double>> pdSum; ///> Grid x output sums over rows, by curve.
+  vector<size_t> nRowPD; ///> # rows reaching any tree.
+  vector<vector<double>> iceVal; ///> Row x grid x output, by curve, iff retaining.
+
+
+  /**
+     @brief Per-thread workspace.
+   */
+  struct Scratch {
+    vector<double> rowTotal; ///> Output sums over base leaves.
+    vector<double> acc; ///> Grid x output sums.
+    vector<unsigned int> gridIdx; ///> Grid positions, partitioned during walk.
+
+    Scratch(unsigned int nOut,
+	    size_t gridMax) :
+      rowTotal(nOut),
+      acc(gridMax * nOut),
+      gridIdx(gridMax) {
+    }
+  };
+
+
+  /**
+     @brief Adds a leaf's output at a given output slot.
+   */
+  inline void addLeaf(size_t nodeIdx,
+		      double* accOut,
+		      double sign) const {
+    if (ctg) {
+      unsigned int ctgLeaf = static_cast<unsigned int>(scoreBlock[nodeIdx]);
+      if (ctgLeaf < nOut)
+	accOut[ctgLeaf] += sign;
+    }
+    else {
+      accOut[0] += sign * scoreBlock[nodeIdx];
+    }
+  }
+
+
+  /**
+     @brief Walks a tree from a given node, partitioning the grid
+     positions at each split on the curve's predictor.
+
+     @param gridStart, gridEnd delimit the positions reaching the node.
+   */
+  void walkGrid(unsigned int tIdx,
+		size_t nodeIdx,
+		unsigned int curveIdx,
+		const double rowNT[],
+		const CtgT rowFT[],
+		Scratch& scratch,
+		size_t gridStart,
+		size_t gridEnd) const;
+
+
+  /**
+     @brief Evaluates all curves at a single row.
+   */
+  void evalRow(const class Predict* predict,
+	       size_t row,
+	       const double rowNT[],
+	       const CtgT rowFT[],
+	       Scratch& scratch,
+	       vector<vector<double>>& pdLocal,
+	       vector<size_t>& nRowLocal);
+
+public:
+
+  /**
+     @param nCtg is the training cardinality, zero iff regression.
+
+     @param predIdx_ are core predictor indices, by curve.
+
+     @param grid_ are the values substituted, by curve.  Factor grids
+     are zero-based codes.
+
+     @param ice_ is true iff row-level curves are to be retained.
+   */
+  PartialDep(const class Forest* forest,
+	     PredictorT nPredNum_,
+	     PredictorT nPredFac_,
+	     unsigned int nCtg,
+	     size_t nRow_,
+	     vector<PredictorT> predIdx_,
+	     vector<vector<double>> grid_,
+	     bool ice_);
+
+
+  /**
+     @brief Evaluates the curves over a predicted block.
+
+     @param predict supplies the block's base leaves.
+
+     @param blockNum is the block's numeric observations, row-major.
+
+     @param blockFac is the block's factor observations, " ".
+
+     @param rowStart is the absolute row at which the block begins.
+   */
+  void accumulate(const class Predict* predict,
+		  const double* blockNum,
+		  const CtgT* blockFac,
+		  size_t rowStart,
+		  size_t span);
+
+
+  size_t getNCurve() const {
+    return predIdx.size();
+  }
+
+
+  unsigned int getNOut() const {
+    return nOut;
+  }
+
+
+  /**
+     @return mean over rows, grid x output, for a given curve.
+   */
+  vector<double> getPD(unsigned int curveIdx) const;
+
+
+  /**
+     @return row x grid x output values for a given curve, iff retained.
+   */
+  const vector<double>& getICE(unsigned int curveIdx) const {
+    return iceVal[curveIdx];
+  }
+};
+
+#endif
@@ -22,101 +22,344 @@
 #include "quant.h"
 #include "ompthread.h"
 #include "rleframe.h"
+#include "denseframe.h"
 #include "sample.h"
 #include "response.h"
+#include "predictstream.h"
+#include "tracelog.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
 const size_t Predict::scoreChunk = 0x2000;
 const unsigned int Predict::seqChunk = 0x20;
+const size_t Predict::cacheBytes = 0x40000;
+const size_t Predict::transposeTile = 0x100;
+const size_t Predict::permuteCacheBytes = 0x20000000;
+const size_t Predict::calibRows = 0x100;
+const double Predict::quickLeaves = 64.0;
+
+
+/**
+   @brief Broadcasts a value down one column of a row-major block.
+
+   @param stride is the row width.
+
+   @param col is the column index.
+
+   @param rowIdx is the starting row, inclusive.
+
+   @param rowSup is the ending row, exclusive.
+ */
+template<typename valType>
+static inline void fillColumn(valType* block,
+			      size_t stride,
+			      unsigned int col,
+			      size_t rowIdx,
+			      size_t rowSup,
+			      valType val) {
+  valType* out = block + rowIdx * stride + col;
+  if (stride == 1) {
+    fill(out, out + (rowSup - rowIdx), val);
+  }
+  else {
+    for (; rowIdx != rowSup; rowIdx++, out += stride)
+      *out = val;
+  }
+}
+
+
+/**
+   @brief Hints that a node will shortly be read.
+ */
+static inline void prefetchNode(const DecNode* node) {
+#if defined(__GNUC__)
+  __builtin_prefetch(node);
+#endif
+}
 
 
 Predict::Predict(const Forest* forest,
 		 const Sampler* sampler_,
-		 RLEFrame* rleFrame,
+		 size_t nRow_,
+		 PredictorT nPredNum_,
+		 PredictorT nPredFac_,
 		 bool testing_,
 		 unsigned int nPermute_,
-		 bool trapUnobserved_) :
+		 bool trapUnobserved_,
+		 bool quickScore,
+		 bool binCode,
+		 bool compact,
+		 bool reuseRuns,
+		 CompiledWalk compiledWalk_,
+		 unsigned int nReplica) :
   trapUnobserved(trapUnobserved_),
   sampler(sampler_),
   decNode(forest->getNode()),
-  factorBits(forest->getFactorBits()),
+  nodeOrigin(forest->getNodeOrigin()),
+  bitPool(forest->getBitPool()),
+  bitOrigin(forest->getBitOrigin()),
+  obsBag(sampler->getBag()),
   testing(testing_),
   nPermute(nPermute_),
   predictLeaves(vector<IndexT>(scoreChunk * forest->getNTree())),
   accumNEst(vector<IndexT>(scoreChunk)),
+  engine(Walker::factory(this, forest, nPredNum_, nPredFac_, quickScore, binCode, compact, compiledWalk_)),
+  forestDag(nullptr),
+  forestReplica(!engine ? ForestReplica::factory(forest, nReplica) : nullptr),
+  forestTop((nPredFac_ == 0 && !engine) ? ForestTop::factory(forest) : nullptr),
+  predTree(nPermute > 0 ? forest->splitTrees(nPredNum_ + nPredFac_) : vector<vector<unsigned int>>()),
+  predSplit(forest->splitMask(nPredNum_ + nPredFac_)),
+  leafCache(vector<IndexT>((nPermute > 0 && walksSelectively()) ? nRow_ * forest->getNTree() : 0)),
+  permuteTrees(nullptr),
+  permuteIdx(nPredNum_ + nPredFac_),
+  permuteTyped(0),
+  blockCached(false),
+  leafSink(nullptr),
   scoreBlock(forest->getTreeScores()),
-  nPredNum(rleFrame->getNPredNum()),
-  nPredFac(rleFrame->getNPredFac()),
-  nRow(rleFrame->getNRow()),
+  nPredNum(nPredNum_),
+  nPredFac(nPredFac_),
+  nRow(nRow_),
   nTree(forest->getNTree()),
   noNode(forest->maxTreeHeight()),
-  walkTree(nPredFac == 0 ? &Predict::walkNum : (nPredNum == 0 ? &Predict::walkFac : &Predict::walkMixed)),
+  treeBlock(treeBlockSize(forest)),
+  walkTree(engine ? &Predict::walkEngine : typedWalk()),
+  walker(engine.get()),
   trFac(vector<CtgT>(scoreChunk * nPredFac)),
-  trNum(vector<double>(scoreChunk * nPredNum)) {
-  rleFrame->reorderRow(); // For now, all frames pre-ranked.
+  trNum(vector<double>(coding() ? 0 : scoreChunk * nPredNum)),
+  trCode(vector<BinCodeT>(coding() ? scoreChunk * nPredNum : 0)),
+  blockNum(trNum.empty() ? nullptr : &trNum[0]),
+  blockFac(trFac.empty() ? nullptr : &trFac[0]),
+  runRep(vector<IndexT>((reuseRuns && nPermute == 0 && !obsBag) ? scoreChunk : 0)),
+  blockRep(runRep.empty() ? nullptr : &runRep[0]),
+  rowTrap(vector<unsigned char>((trapUnobserved && nPredFac > 0) ? scoreChunk : 0)),
+  blockTrap(rowTrap.empty() ? nullptr : &rowTrap[0]),
+  treesWalked(false) {
+  if (walkTree == &Predict::walkTyped<true, true>) {
+    nodeBlock = blockNodes();
+  }
+}
+
+
+vector<NodeBlock> Predict::blockNodes() const {
+  vector<NodeBlock> blocks(decNode.size());
+  for (size_t nodeIdx = 0; nodeIdx < decNode.size(); nodeIdx++) {
+    if (decNode[nodeIdx].isNonterminal()) {
+      PredictorT predIdx = decNode[nodeIdx].getPredIdx();
+      bool predIsFactor = isFactor(predIdx);
+      blocks[nodeIdx] = NodeBlock{predIsFactor ? predIdx - nPredNum : predIdx, predIsFactor};
+    }
+  }
+  return blocks;
 }
 
 
 PredictReg::PredictReg(const Forest* forest,
 		       const Sampler* sampler_,
 		       const Leaf* leaf,
-		       RLEFrame* rleFrame,
+		       size_t nRow_,
+		       PredictorT nPredNum_,
+		       PredictorT nPredFac_,
 		       const vector<double>& yTest_,
 		       unsigned int nPermute_,
 		       const vector<double>& quantile,
-		       bool trapUnobserved_) :
-  Predict(forest, sampler_, rleFrame, !yTest_.empty(), nPermute_, trapUnobserved_),
+		       unsigned int quantSketch,
+		       bool quantExact,
+		       bool trapUnobserved_,
+		       bool quickScore,
+		       bool binCode,
+		       bool compact,
+		       bool reuseRuns,
+		       CompiledWalk compiledWalk_,
+		       unsigned int nReplica,
+		       const vector<unsigned int>& treeSweep) :
+  Predict(forest, sampler_, nRow_, nPredNum_, nPredFac_, !yTest_.empty(), nPermute_, trapUnobserved_, quickScore, binCode, compact, reuseRuns, compiledWalk_, nReplica),
   response(reinterpret_cast<const ResponseReg*>(sampler->getResponse())),
   yTest(move(yTest_)),
   yPred(vector<double>(nRow)),
   yPermute(vector<double>(nPermute > 0 ? nRow : 0)),
   accumAbsErr(vector<double>(scoreChunk)),
   accumSSE(vector<double>(scoreChunk)),
-  saePermute(nPermute > 0 ? rleFrame->getNPred() : 0),
-  ssePermute(nPermute > 0 ? rleFrame->getNPred() : 0),
-  quant(make_unique<Quant>(forest, leaf, this, response, move(quantile))),
-  yTarg(&yPred),
+  saePermute(nPermute > 0 ? nPredNum + nPredFac : 0),
+  ssePermute(nPermute > 0 ? nPredNum + nPredFac : 0),
+  quant(make_unique<Quant>(forest, leaf, this, response, move(quantile), quantSketch, quantExact)),
+  yOut(yPred.data()),
+  yTarg(yOut),
   saeTarg(&saePredict),
-  sseTarg(&ssePredict) {
+  sseTarg(&ssePredict),
+  sweep(testing ? sweepPoints(treeSweep, nTree) : vector<unsigned int>(0)),
+  sweepPred(vector<double>(max(1u, OmpThread::nThread) * sweep.size())),
+  sweepSAE(vector<double>(sweepPred.size())),
+  sweepSSE(vector<double>(sweepPred.size())) {
 }
 
 
 PredictCtg::PredictCtg(const Forest* forest,
 		       const Sampler* sampler_,
-		       RLEFrame* rleFrame,
+		       const Leaf* leaf,
+		       size_t nRow_,
+		       PredictorT nPredNum_,
+		       PredictorT nPredFac_,
 		       const vector<PredictorT>& yTest_,
 		       unsigned int nPermute_,
 		       bool doProb,
-		       bool trapUnobserved_) :
-  Predict(forest, sampler_, rleFrame, !yTest_.empty(), nPermute_, trapUnobserved_),
+		       bool probSample,
+		       bool doCensus_,
+		       PredictorT topK_,
+		       bool trapUnobserved_,
+		       bool quickScore,
+		       bool binCode,
+		       bool compact,
+		       bool reuseRuns,
+		       CompiledWalk compiledWalk_,
+		       unsigned int nReplica,
+		       bool earlyExit_,
+		       double exitTolerance_,
+		       const vector<unsigned int>& treeSweep) :
+  Predict(forest, sampler_, nRow_, nPredNum_, nPredFac_, !yTest_.empty(), nPermute_, trapUnobserved_, quickScore, binCode, compact, reuseRuns, compiledWalk_, nReplica),
   response(reinterpret_cast<const ResponseCtg*>(sampler->getResponse())),
   yTest(move(yTest_)),
   yPred(vector<PredictorT>(nRow)),
   nCtgTrain(response->getNCtg()),
   nCtgMerged(testing ? 1 + *max_element(yTest.begin(), yTest.end()) : 0),
-  ctgProb(make_unique<CtgProb>(this, response, doProb)),
+  ctgProb(make_unique<CtgProb>(forest, this, response, leaf, doProb, probSample)),
   // Can only predict trained categories, so census and
   // probability matrices have 'nCtgTrain' columns.
   yPermute(vector<PredictorT>(nPermute > 0 ? nRow : 0)),
-  census(vector<PredictorT>(nRow * nCtgTrain)),
+  doCensus(doCensus_),
+  censusNarrow(nTree <= numeric_limits<uint16_t>::max()),
+  census16(vector<uint16_t>(doCensus && censusNarrow ? nRow * nCtgTrain : 0)),
+  census32(vector<PredictorT>(doCensus && !censusNarrow ? nRow * nCtgTrain : 0)),
+  censusRow(vector<vector<PredictorT>>(max(1u, OmpThread::nThread), vector<PredictorT>(nCtgTrain))),
+  topK(min(topK_, nCtgTrain)),
+  topCtg(vector<PredictorT>(nRow * topK)),
+  topWeight(vector<double>(nRow * topK)),
+  topScratch(vector<vector<PredictorT>>(topK > 0 ? max(1u, OmpThread::nThread) : 0, vector<PredictorT>(nCtgTrain))),
   confusion(vector<size_t>(nCtgTrain * nCtgMerged)),
   misprediction(vector<double>(nCtgMerged)),
   oobPredict(0.0),
-  censusPermute(vector<PredictorT>(nPermute > 0 ? census.size() : 0)),
   confusionPermute(vector<size_t>(nPermute > 0 ? confusion.size() : 0)),
-  mispredPermute(vector<vector<double>>(nPermute > 0 ? rleFrame->getNPred(): 0)),
-  oobPermute(vector<double>(nPermute > 0 ? rleFrame->getNPred() : 0)),
+  mispredPermute(vector<vector<double>>(nPermute > 0 ? nPredNum + nPredFac : 0)),
+  oobPermute(vector<double>(nPermute > 0 ? nPredNum + nPredFac : 0)),
+  sweep(testing ? sweepPoints(treeSweep, nTree) : vector<unsigned int>(0)),
+  earlyExit(earlyExit_ && walksSelectively() && runRep.empty() && sweep.empty()),
+  exitTolerance(exitTolerance_),
+  nTreeUsed(vector<unsigned int>(earlyExit ? nRow : 0)),
+  sweepCensus(vector<unsigned int>(sweep.empty() ? 0 : max(1u, OmpThread::nThread) * nCtgTrain)),
+  sweepJitter(vector<vector<double>>(sweep.empty() ? 0 : max(1u, OmpThread::nThread), vector<double>(nCtgTrain))),
+  sweepPred(vector<PredictorT>(max(1u, OmpThread::nThread) * sweep.size())),
+  sweepMiss(vector<size_t>(sweepPred.size())),
   yTarg(&yPred),
   confusionTarg(&confusion),
-  censusTarg(&census),
   mispredTarg(&misprediction),
   oobTarg(&oobPredict) {
 }
 
 
 void Predict::predict(RLEFrame* rleFrame) {
+  engageShare();
+  engageAuto();
+  rleFrame->reorderRow(); // For now, all frames pre-ranked.
+  if (coding()) {
+    coding()->codeRanked(rleFrame);
+  }
+  blockCached = nPermute > 0 && nRow * (nPredNum * (coding() ? sizeof(BinCodeT) : sizeof(double)) + nPredFac * sizeof(CtgT)) <= permuteCacheBytes;
+  if (blockCached) {
+    numCache = vector<double>(trNum.empty() ? 0 : nRow * nPredNum);
+    codeCache = vector<BinCodeT>(trCode.empty() ? 0 : nRow * nPredNum);
+    facCache = vector<CtgT>(nRow * nPredFac);
+  }
   blocks(rleFrame);
   predictPermute(rleFrame);
+  if (blockCached) {
+    blockCached = false;
+    numCache = vector<double>();
+    codeCache = vector<BinCodeT>();
+    facCache = vector<CtgT>();
+  }
+}
+
+
+void Predict::predict(const DenseFrame* denseFrame) {
+  engageShare();
+  engageAuto();
+  blockRep = nullptr; // Runs are only tracked by ranked frames.
+  for (size_t row = 0; row < nRow; row += scoreChunk) {
+    size_t extent = min(scoreChunk, nRow - row);
+    PredictStat::Stamp tStart = PredictStat::now();
+    transpose(denseFrame, row, extent);
+    if (predictStat)
+      predictStat->tTranspose += PredictStat::since(tStart);
+    blockStart = row; // Not local.
+    predictBlock(extent);
+  }
+
+  estAccum();
+}
+
+
+void Predict::predictBatch(const vector<Predict*>& models,
+			   RLEFrame* rleFrame) {
+  if (models.empty())
+    return;
+
+  rleFrame->reorderRow();
+  Predict* lead = nullptr; // Transposes values on behalf of batch.
+  for (auto model : models) {
+    model->engageShare();
+    model->engageAuto();
+    if (model->coding())
+      model->coding()->codeRanked(rleFrame);
+    else if (lead == nullptr)
+      lead = model;
+  }
+
+  // Lead transposes the batch's split predictors, so its runs and traps hold for all.
+  vector<unsigned char> leadSplit;
+  if (lead != nullptr) {
+    leadSplit = lead->predSplit;
+    for (auto model : models) {
+      if (!model->coding()) {
+	for (PredictorT predIdx = 0; predIdx != lead->predSplit.size(); predIdx++)
+	  lead->predSplit[predIdx] |= model->predSplit[predIdx];
+      }
+    }
+  }
+
+  size_t nRow = models.front()->nRow;
+  vector<vector<size_t>> trIdx(models.size(), vector<size_t>(rleFrame->getNPred()));
+  vector<size_t> leadIdx(rleFrame->getNPred());
+  for (size_t row = 0; row < nRow; row += scoreChunk) {
+    size_t extent = min(scoreChunk, nRow - row);
+    if (lead != nullptr)
+      lead->transposeBlock(rleFrame, leadIdx, row, extent);
+    for (size_t modelIdx = 0; modelIdx != models.size(); modelIdx++) {
+      Predict* model = models[modelIdx];
+      if (model->coding()) {
+	model->transposeBlock(rleFrame, trIdx[modelIdx], row, extent);
+      }
+      else {
+	model->blockNum = lead->blockNum;
+	model->blockFac = lead->blockFac;
+	model->blockRep = model->runRep.empty() ? nullptr : lead->blockRep;
+	model->blockTrap = lead->blockTrap;
+      }
+      model->blockStart = row; // Not local.
+      model->predictBlock(extent);
+    }
+  }
+
+  for (auto model : models) {
+    model->blockNum = model->trNum.empty() ? nullptr : &model->trNum[0];
+    model->blockFac = model->trFac.empty() ? nullptr : &model->trFac[0];
+    model->blockRep = model->runRep.empty() ? nullptr : &model->runRep[0];
+    model->blockTrap = model->rowTrap.empty() ? nullptr : &model->rowTrap[0];
+    model->estAccum();
+  }
+  if (lead != nullptr)
+    lead->predSplit = move(leadSplit);
 }
 
 
@@ -124,19 +367,30 @@ void Predict::predictPermute(RLEFrame* rleFrame) {
   if (nPermute == 0) {
     return;
   }
+  leafSink = nullptr; // Permuted assignments are not exported.
   
+  PredictorT numIdx = 0;
+  PredictorT facIdx = 0;
   for (PredictorT predIdx = 0; predIdx < rleFrame->getNPred(); predIdx++) {
+    // Frame ordering may interleave types; trees index core ordering.
+    PredictorT coreIdx = rleFrame->factorTop[predIdx] == 0 ? numIdx++ : nPredNum + facIdx++;
+    permuteTrees = leafCache.empty() ? nullptr : &predTree[coreIdx];
+    permuteIdx = predIdx;
+    permuteTyped = rleFrame->factorTop[predIdx] == 0 ? coreIdx : coreIdx - nPredNum;
     setPermuteTarget(predIdx);
-    vector<RLEVal<szType>> rleTemp = move(rleFrame->rlePred[predIdx]);
-    rleFrame->rlePred[predIdx] = rleFrame->permute(predIdx, Sample::permute(nRow));
+    FrameArray<RLEIdx> rlePermuted(rleFrame->permute(predIdx, Sample::permute(nRow)));
+    FrameArray<RLEIdx> rleTemp = move(rleFrame->rlePred[predIdx]);
+    rleFrame->rlePred[predIdx] = move(rlePermuted);
     blocks(rleFrame);
     rleFrame->rlePred[predIdx] = move(rleTemp);
   }
+  permuteTrees = nullptr;
+  permuteIdx = rleFrame->getNPred();
 }
 
 
 void PredictReg::setPermuteTarget(PredictorT predIdx) {
-  yTarg = &yPermute;
+  yTarg = yPermute.data();
   sseTarg = &ssePermute[predIdx];
   saeTarg = &saePermute[predIdx];
   fill(accumSSE.begin(), accumSSE.end(), 0.0);
@@ -148,11 +402,9 @@ void PredictCtg::setPermuteTarget(PredictorT predIdx) {
   mispredPermute[predIdx] = vector<double>(nCtgMerged);
   yTarg = &yPermute;
   confusionTarg = &confusionPermute;
-  censusTarg = &censusPermute;
   mispredTarg = &mispredPermute[predIdx];
   oobTarg = &oobPermute[predIdx];
   fill(confusionPermute.begin(), confusionPermute.end(), 0);
-  fill(censusPermute.begin(), censusPermute.end(), 0);
 }
 
 
@@ -175,7 +427,7 @@ size_t Predict::predictBlock(const RLEFrame* rleFrame,
   size_t blockRows = min(scoreChunk, rowEnd - rowStart);
   size_t row = rowStart;
   for (; row + blockRows <= rowEnd; row += blockRows) {
-    transpose(rleFrame, trIdx, row, scoreChunk);
+    transposeBlock(rleFrame, trIdx, row, scoreChunk);
     blockStart = row; // Not local.
     predictBlock(blockRows);
   }
@@ -183,185 +435,1067 @@ size_t Predict::predictBlock(const RLEFrame* rleFrame,
 }
 
 
+void Predict::transposeBlock(const RLEFrame* rleFrame,
+			     vector<size_t>& idxTr,
+			     size_t rowStart,
+			     size_t rowExtent) {
+  if (!predictStat) {
+    transpose(rleFrame, idxTr, rowStart, rowExtent);
+  }
+  else {
+    PredictStat::Stamp tStart = PredictStat::now();
+    transpose(rleFrame, idxTr, rowStart, rowExtent);
+    predictStat->tTranspose += PredictStat::since(tStart);
+  }
+}
+
+
 void Predict::transpose(const RLEFrame* rleFrame,
 			vector<size_t>& idxTr,
 			size_t rowStart,
 			size_t rowExtent) {
-  CtgT* facOut = trFac.empty() ? nullptr : &trFac[0];
-  double* numOut = trNum.empty() ? nullptr : &trNum[0];
-  for (size_t row = rowStart; row != min(nRow, rowStart + rowExtent); row++) {
+  size_t rowEnd = min(nRow, rowStart + rowExtent);
+  if (blockCached && permuteIdx < rleFrame->getNPred()) {
+    patchBlock(rleFrame, idxTr, rowStart, rowEnd);
+    return;
+  }
+
+  vector<unsigned char> runStart(runRep.empty() ? 0 : rowEnd - rowStart); // Nonzero iff some run begins.
+  fill(rowTrap.begin(), rowTrap.end(), 0);
+  for (size_t tileStart = rowStart; tileStart < rowEnd; tileStart += transposeTile) {
+    size_t tileEnd = min(rowEnd, tileStart + transposeTile);
     unsigned int numIdx = 0;
     unsigned int facIdx = 0;
-    vector<szType> rankVec = rleFrame->idxRank(idxTr, row);
-    for (unsigned int predIdx = 0; predIdx < rankVec.size(); predIdx++) {
-      unsigned int rank = rankVec[predIdx];
-      if (rleFrame->factorTop[predIdx] == 0) {
-	*numOut++ = rleFrame->numRanked[numIdx++][rank];
+    for (unsigned int predIdx = 0; predIdx < rleFrame->getNPred(); predIdx++) {
+      bool isNum = rleFrame->factorTop[predIdx] == 0;
+      unsigned int typedIdx = isNum ? numIdx++ : facIdx++;
+      if (predSplit[isNum ? typedIdx : nPredNum + typedIdx]) // Unsplit columns are never read.
+	idxTr[predIdx] = expandColumn(rleFrame, predIdx, typedIdx, idxTr[predIdx], rowStart, tileStart, tileEnd, runStart);
+    }
+  }
+
+  if (blockCached) {
+    cacheBlock(rowStart, rowEnd);
+  }
+
+  // Rows beginning no run repeat their predecessor.
+  for (IndexT rowIdx = 0; rowIdx < runStart.size(); rowIdx++) {
+    runRep[rowIdx] = (rowIdx > 0 && runStart[rowIdx] == 0) ? runRep[rowIdx - 1] : rowIdx;
+  }
+}
+
+
+size_t Predict::expandColumn(const RLEFrame* rleFrame,
+			     unsigned int predIdx,
+			     unsigned int typedIdx,
+			     size_t idx,
+			     size_t rowStart,
+			     size_t tileStart,
+			     size_t tileEnd,
+			     vector<unsigned char>& runStart) {
+  const FrameArray<RLEIdx>& rle = rleFrame->rlePred[predIdx];
+  for (size_t row = tileStart; row < tileEnd; idx++) {
+    while (row >= rle[idx].getRowEnd())
+      idx++;
+    size_t runEnd = min(tileEnd, rle[idx].getRowEnd());
+    szType rank = rle[idx].val;
+    if (!runStart.empty() && row == rle[idx].row) {
+      runStart[row - rowStart] = 1;
+    }
+    if (rleFrame->factorTop[predIdx] == 0) {
+      if (!trCode.empty())
+	fillColumn(&trCode[0], nPredNum, typedIdx, row - rowStart, runEnd - rowStart, coding()->getCode(typedIdx, rank));
+      else
+	fillColumn(&trNum[0], nPredNum, typedIdx, row - rowStart, runEnd - rowStart, rleFrame->numRanked[typedIdx][rank]);
+    }
+    else {// TODO:  Replace subtraction with (front end)::fac2Rank()
+      fillColumn(&trFac[0], nPredFac, typedIdx, row - rowStart, runEnd - rowStart, CtgT(rleFrame->facRanked[typedIdx][rank] - 1));
+      // Codes beyond the training levels, including proxies, are unseen.
+      if (!rowTrap.empty() && rleFrame->facRanked[typedIdx][rank] > rleFrame->factorTop[predIdx])
+	fill(rowTrap.begin() + (row - rowStart), rowTrap.begin() + (runEnd - rowStart), 1);
+    }
+    row = runEnd;
+  }
+  return idx - 1; // Run holding the tile's last row.
+}
+
+
+void Predict::cacheBlock(size_t rowStart,
+			 size_t rowEnd) {
+  size_t span = rowEnd - rowStart;
+  if (!numCache.empty())
+    copy(trNum.begin(), trNum.begin() + span * nPredNum, numCache.begin() + rowStart * nPredNum);
+  if (!codeCache.empty())
+    copy(trCode.begin(), trCode.begin() + span * nPredNum, codeCache.begin() + rowStart * nPredNum);
+  if (!facCache.empty())
+    copy(trFac.begin(), trFac.begin() + span * nPredFac, facCache.begin() + rowStart * nPredFac);
+}
+
+
+void Predict::patchBlock(const RLEFrame* rleFrame,
+			 vector<size_t>& idxTr,
+			 size_t rowStart,
+			 size_t rowEnd) {
+  if (!numCache.empty())
+    copy(numCache.begin() + rowStart * nPredNum, numCache.begin() + rowEnd * nPredNum, trNum.begin());
+  if (!codeCache.empty())
+    copy(codeCache.begin() + rowStart * nPredNum, codeCache.begin() + rowEnd * nPredNum, trCode.begin());
+  if (!facCache.empty())
+    copy(facCache.begin() + rowStart * nPredFac, facCache.begin() + rowEnd * nPredFac, trFac.begin());
+
+  fill(rowTrap.begin(), rowTrap.end(), 1); // Permuted values are not screened.
+  vector<unsigned char> runStart; // Runs are not reused when permuting.
+  idxTr[permuteIdx] = expandColumn(rleFrame, permuteIdx, permuteTyped, idxTr[permuteIdx], rowStart, rowStart, rowEnd, runStart);
+}
+
+
+void Predict::transpose(const DenseFrame* denseFrame,
+			size_t rowStart,
+			size_t rowExtent) {
+  CtgT* facOut = trFac.empty() ? nullptr : &trFac[0];
+  double* numOut = trNum.empty() ? nullptr : &trNum[0];
+  BinCodeT* codeOut = trCode.empty() ? nullptr : &trCode[0];
+  fill(rowTrap.begin(), rowTrap.end(), 1); // Dense factors carry no level count.
+  for (size_t row = rowStart; row != rowStart + rowExtent; row++) {
+    for (PredictorT numIdx = 0; numIdx < nPredNum; numIdx++) {
+      if (codeOut != nullptr) {
+	if (predSplit[numIdx])
+	  *codeOut = coding()->encode(numIdx, denseFrame->getNum(row, numIdx));
+	codeOut++;
       }
-      else {// TODO:  Replace subtraction with (front end)::fac2Rank()
-	*facOut++ = rleFrame->facRanked[facIdx++][rank] - 1;
+      else {
+	if (predSplit[numIdx])
+	  *numOut = denseFrame->getNum(row, numIdx);
+	numOut++;
       }
     }
+    for (PredictorT facIdx = 0; facIdx < nPredFac; facIdx++, facOut++) {
+      if (predSplit[nPredNum + facIdx])
+	*facOut = denseFrame->getFac(row, facIdx);
+    }
   }
 }
 
 
 void Predict::predictBlock(size_t span) {
+  TraceSpan traceSpan("predict block", blockStart);
+  PredictStat::Stamp tStart = PredictStat::now();
+  if (walkSelect && walkSelect->isSelected())
+    engageWalker(walkSelect->getChoice(span < laneWidth));
   fill(predictLeaves.begin(), predictLeaves.end(), noNode);
+  if (blockRep != nullptr) {
+    walkRuns(span);
+  }
 
   OMPBound rowEnd = static_cast<OMPBound>(blockStart + span);
   OMPBound rowStart = static_cast<OMPBound>(blockStart);
 
+  scoreRows(rowStart, rowEnd);
+
+  if (leafSink != nullptr)
+    emitLeaves(span);
+
+  if (permuteIdx == nPredNum + nPredFac) { // Unpermuted only.
+    if (treeShap)
+      treeShap->attribute(blockNum, blockFac, blockStart, span);
+    if (partialDep)
+      partialDep->accumulate(this, blockNum, blockFac, blockStart, span);
+    if (localImp)
+      localImp->accumulate(this, blockNum, blockFac, blockStart, span);
+    if (nodeTraffic)
+      nodeTraffic->record(&predictLeaves[0], span, noNode);
+  }
+
+  if (predictStat) {
+    predictStat->tBlock += PredictStat::since(tStart);
+    recordBlock(span);
+  }
+}
+
+
+void Predict::scoreRows(OMPBound rowStart,
+			OMPBound rowEnd) {
+  treesWalked = walkByTree(rowEnd - rowStart);
+  if (treesWalked)
+    walkTrees(rowStart, rowEnd);
+
+  LoadTally tally(predictStat ? &predictStat->load : nullptr, OmpThread::nThread, "score");
+  if (forestReplica) { // Spread binding, as replicas were placed.
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread) proc_bind(spread)
+    {
+    auto entry = tally.enter();
+    size_t nIter = 0;
+#pragma omp for schedule(dynamic, 1) nowait
+    for (OMPBound row = rowStart; row < rowEnd; row += seqChunk) {
+      scoreSeq(row, min(rowEnd, row + seqChunk));
+      nIter++;
+    }
+    tally.exit(OmpThread::threadIdx(), entry, nIter);
+    }
+  }
+  else {
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+    {
+    auto entry = tally.enter();
+    size_t nIter = 0;
+#pragma omp for schedule(dynamic, 1) nowait
+    for (OMPBound row = rowStart; row < rowEnd; row += seqChunk) {
+      scoreSeq(row, min(rowEnd, row + seqChunk));
+      nIter++;
+    }
+    tally.exit(OmpThread::threadIdx(), entry, nIter);
+    }
+  }
+}
+
+
+void Predict::enableShap(const Forest* forest,
+			 const Leaf* leaf,
+			 unsigned int nCtg) {
+  if (coding())
+    throw invalid_argument("Attribution requires uncoded numeric values");
+  treeShap = make_unique<TreeShap>(forest, leaf, nPredNum, nPredFac, nCtg, nRow);
+}
+
+
+void Predict::enablePartial(const Forest* forest,
+			    unsigned int nCtg,
+			    vector<PredictorT> predIdx,
+			    vector<vector<double>> grid,
+			    bool ice) {
+  if (coding())
+    throw invalid_argument("Partial dependence requires uncoded numeric values");
+  partialDep = make_unique<PartialDep>(forest, nPredNum, nPredFac, nCtg, nRow, move(predIdx), move(grid), ice);
+}
+
+
+void Predict::enableLocalImp(const Forest* forest,
+			     unsigned int nCtg) {
+  if (coding())
+    throw invalid_argument("Local importance requires uncoded numeric values");
+  localImp = make_unique<LocalImp>(forest, nPredNum, nPredFac, nCtg, nRow);
+}
+
+
+void Predict::enableTraffic(const Forest* forest,
+			    const Leaf* leaf) {
+  nodeTraffic = make_unique<NodeTraffic>(forest, leaf);
+}
+
+
+void Predict::enableStat() {
+  predictStat = make_unique<PredictStat>(nTree);
+  statThread = vector<PredictStat>(max(1u, OmpThread::nThread));
+
+  // Successors follow their predecessor, so a single pass suffices.
+  nodeDepth = vector<IndexT>(decNode.size());
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : decNode.size();
+    for (size_t nodeIdx = nodeOrigin[tIdx]; nodeIdx < nodeEnd; nodeIdx++) {
+      IndexT delIdx = decNode[nodeIdx].getDelIdx();
+      if (delIdx != 0) {
+	nodeDepth[nodeIdx + delIdx] = nodeDepth[nodeIdx] + 1;
+	nodeDepth[nodeIdx + delIdx + 1] = nodeDepth[nodeIdx] + 1;
+      }
+    }
+  }
+}
+
+
+void Predict::enableShare(const Forest* forest) {
+  if (engine)
+    return;
+  unique_ptr<WalkDag> walkDag = WalkDag::factory(this, forest, nPredNum);
+  forestDag = walkDag ? walkDag->getDag() : nullptr;
+  engine = move(walkDag);
+}
+
+
+bool Predict::scoresOnly() const {
+  return leafSink == nullptr && !trapUnobserved && !treeShap && !partialDep && !localImp && !nodeTraffic && !predictStat;
+}
+
+
+bool PredictReg::scoresOnly() const {
+  return Predict::scoresOnly() && quant->isEmpty() && !jackVar && !multiReg;
+}
+
+
+bool PredictCtg::scoresOnly() const {
+  return Predict::scoresOnly() && ctgProb->isEmpty();
+}
+
+
+void Predict::engageShare() {
+  if (!forestDag)
+    return;
+  if (!scoresOnly()) {
+    forestDag = nullptr;
+    engine.reset();
+    return;
+  }
+
+  forestReplica.reset();
+  forestTop.reset();
+  noNode = max(noNode, static_cast<IndexT>(forestDag->getPoolSize()));
+  engageWalker(engine.get());
+}
+
+
+void Predict::enableAuto(const Forest* forest,
+			 bool calibrate) {
+  if (engine || nPermute > 0)
+    return;
+
+  walkSelect = make_unique<WalkSelect>(forest, calibrate);
+}
+
+
+void PredictCtg::enableAuto(const Forest* forest,
+			    bool calibrate) {
+  if (!earlyExit)
+    Predict::enableAuto(forest, calibrate);
+}
+
+
+void Predict::engageAuto() {
+  if (!walkSelect || walkSelect->isSelected()) // Selects once per session.
+    return;
+  if (forestDag) { // Shared subtrees supersede.
+    walkSelect.reset();
+    return;
+  }
+
+  Walker* compactWalk = walkSelect->admit(WalkCompact::factory(this, walkSelect->forest, nPredNum, nPredFac));
+  Walker* quickWalk = nullptr;
+  if (nPredFac == 0 && treeBlock == nTree) { // Walks every tree per call.
+    quickWalk = walkSelect->admit(make_unique<WalkQuick>(this, walkSelect->forest, nPredNum));
+  }
+
+  Walker* walkShort = nullptr; // Null denotes the typed walk.
+  Walker* walkFull = nullptr;
+  if (walkSelect->calibrate) {
+    vector<Walker*> candidate{nullptr};
+    for (auto walker : walkSelect->getCandidates()) {
+      candidate.push_back(walker);
+    }
+    size_t nCalib = synthesizeRows();
+    double shortBest = numeric_limits<double>::max();
+    double fullBest = numeric_limits<double>::max();
+    for (auto walker : candidate) {
+      (void) timeWalk(walker, nCalib, nCalib); // Warms caches.
+      double tShort = timeWalk(walker, nCalib, 1);
+      double tFull = timeWalk(walker, nCalib, nCalib);
+      if (tShort < shortBest) {
+	shortBest = tShort;
+	walkShort = walker;
+      }
+      if (tFull < fullBest) {
+	fullBest = tFull;
+	walkFull = walker;
+      }
+    }
+  }
+  else { // Shape alone:  shallow trees favor QuickScorer, large forests compaction.
+    size_t nLeaf = count_if(decNode.begin(), decNode.end(), [](const DecNode& node) {
+	return node.isTerminal();
+      });
+    size_t forestBytes = decNode.size() * sizeof(DecNode);
+    if (quickWalk != nullptr && double(nLeaf) / nTree <= quickLeaves)
+      walkFull = quickWalk;
+    else if (compactWalk != nullptr && forestBytes > cacheBytes)
+      walkFull = compactWalk;
+    walkShort = walkFull;
+  }
+
+  walkSelect->select(walkShort, walkFull);
+  engageWalker(walkFull);
+  if (predictStat) {
+    predictStat->engineShort = engineName(walkShort);
+    predictStat->engineFull = engineName(walkFull);
+  }
+}
+
+
+size_t Predict::synthesizeRows() {
+  // Values are drawn between pairs of the predictor's split values.
+  vector<vector<double>> splitVal(nPredNum);
+  for (const DecNode& node : decNode) {
+    if (node.isNonterminal() && !isFactor(node.getPredIdx()))
+      splitVal[node.getPredIdx()].push_back(node.getSplitNum());
+  }
+
+  size_t nCalib = min(nRow, calibRows);
+  blockStart = 0;
+  for (size_t row = 0; row < nCalib; row++) {
+    for (PredictorT predIdx = 0; predIdx < nPredNum; predIdx++) {
+      const vector<double>& val = splitVal[predIdx];
+      size_t mix = (row + 1) * 0x9e3779b1 + predIdx * 0x85ebca6b;
+      trNum[row * nPredNum + predIdx] = val.empty() ? 0.0 : 0.5 * (val[mix % val.size()] + val[(mix >> 16) % val.size()]);
+    }
+  }
+  fill(trFac.begin(), trFac.end(), 0); // Zero is a valid code for any factor.
+  return nCalib;
+}
+
+
+double Predict::timeWalk(Walker* walkTimed,
+			 size_t nCalib,
+			 size_t span) {
+  Walker* walkSaved = walker;
+  engageWalker(walkTimed);
+  PredictStat::Stamp tStart = PredictStat::now();
+  for (size_t row = 0; row < nCalib; row += span) {
+    for (unsigned int tIdx = 0; tIdx < nTree; tIdx += treeBlock) {
+      walkRange(row, min(nCalib, row + span), tIdx, min(nTree, tIdx + treeBlock));
+    }
+  }
+  double tRow = PredictStat::since(tStart) / max<size_t>(1, nCalib);
+  engageWalker(walkSaved);
+  return tRow;
+}
+
+
+const char* Predict::engineName(const Walker* walker) {
+  return walker == nullptr ? "typed" : walker->getName();
+}
+
+
+void Predict::recordBlock(size_t span) {
+  predictStat->nBlock++;
+  predictStat->nRow += span;
+  for (auto & stat : statThread) {
+    predictStat->accum(stat);
+    stat = PredictStat();
+  }
+
+  size_t nBail = 0;
+  OMPBound treeEnd = static_cast<OMPBound>(nTree);
+#pragma omp parallel for default(shared) schedule(dynamic, 1) reduction(+:nBail) num_threads(OmpThread::nThread)
+  for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+    size_t depthSum = 0;
+    size_t nVisit = 0;
+    for (size_t rowIdx = 0; rowIdx < span; rowIdx++) {
+      IndexT termIdx = predictLeaves[nTree * rowIdx + tIdx];
+      if (termIdx != noNode) {
+	size_t nodeIdx = nodeOrigin[tIdx] + termIdx;
+	depthSum += nodeDepth[nodeIdx];
+	nVisit++;
+	nBail += decNode[nodeIdx].isNonterminal() ? 1 : 0;
+      }
+    }
+    predictStat->depthTree[tIdx] += depthSum;
+    predictStat->visitTree[tIdx] += nVisit;
+  }
+  predictStat->nBail += nBail;
+  predictStat->depthSum = accumulate(predictStat->depthTree.begin(), predictStat->depthTree.end(), size_t(0));
+  predictStat->nVisit = accumulate(predictStat->visitTree.begin(), predictStat->visitTree.end(), size_t(0));
+}
+
+
+void Predict::walkRuns(size_t span) {
+  OMPBound spanEnd = static_cast<OMPBound>(span);
 #pragma omp parallel default(shared) num_threads(OmpThread::nThread)
   {
 #pragma omp for schedule(dynamic, 1)
-  for (OMPBound row = rowStart; row < rowEnd; row += seqChunk) {
-    scoreSeq(row, min(rowEnd, row + seqChunk));
+  for (OMPBound rowStart = 0; rowStart < spanEnd; rowStart += seqChunk) {
+    for (OMPBound rowIdx = rowStart; rowIdx < min(spanEnd, rowStart + seqChunk); rowIdx++) {
+      if (blockRep[rowIdx] == rowIdx) {
+	for (unsigned int tStart = 0; tStart < nTree; tStart += treeBlock) {
+	  (this->*walkTree)(blockStart + rowIdx, tStart, min(nTree, tStart + treeBlock));
+	}
+      }
+    }
+  }
+
+#pragma omp for schedule(static)
+  for (OMPBound rowIdx = 0; rowIdx < spanEnd; rowIdx++) {
+    if (blockRep[rowIdx] != rowIdx) {
+      const IndexT* repLeaves = &predictLeaves[nTree * blockRep[rowIdx]];
+      copy(repLeaves, repLeaves + nTree, &predictLeaves[nTree * rowIdx]);
+    }
+  }
   }
+}
+
+
+void Predict::setLeafSink(LeafSink* sink) {
+  leafSink = sink;
+  leafOrigin = vector<size_t>(nTree + 1);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : decNode.size();
+    size_t nLeaf = 0;
+    for (size_t nodeIdx = nodeOrigin[tIdx]; nodeIdx < nodeEnd; nodeIdx++) {
+      nLeaf += decNode[nodeIdx].isTerminal() ? 1 : 0;
+    }
+    leafOrigin[tIdx + 1] = leafOrigin[tIdx] + nLeaf;
+  }
+}
+
+
+void Predict::emitLeaves(size_t span) const {
+  vector<size_t> rowPtr(span + 1);
+  OMPBound spanEnd = static_cast<OMPBound>(span);
+#pragma omp parallel for default(shared) schedule(static) num_threads(OmpThread::nThread)
+  for (OMPBound rowIdx = 0; rowIdx < spanEnd; rowIdx++) {
+    size_t nEntry = 0;
+    for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+      IndexT leafIdx;
+      nEntry += isLeafIdx(blockStart + rowIdx, tIdx, leafIdx) ? 1 : 0;
+    }
+    rowPtr[rowIdx + 1] = nEntry;
+  }
+  partial_sum(rowPtr.begin(), rowPtr.end(), rowPtr.begin());
+
+  vector<size_t> leafCol(rowPtr.back());
+#pragma omp parallel for default(shared) schedule(static) num_threads(OmpThread::nThread)
+  for (OMPBound rowIdx = 0; rowIdx < spanEnd; rowIdx++) {
+    size_t colIdx = rowPtr[rowIdx];
+    for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+      IndexT leafIdx;
+      if (isLeafIdx(blockStart + rowIdx, tIdx, leafIdx))
+	leafCol[colIdx++] = leafOrigin[tIdx] + leafIdx;
+    }
   }
+
+  leafSink->emit(blockStart, span, &rowPtr[0], leafCol.empty() ? nullptr : &leafCol[0]);
 }
 
 
 // Sequential inner loop to avoid false sharing.
 void PredictReg::scoreSeq(size_t rowStart, size_t rowEnd) {
+  PredictStat* stat = statLocal();
+  PredictStat::Stamp tWalk = stat ? PredictStat::now() : PredictStat::Stamp();
+  walkSeq(rowStart, rowEnd);
+  PredictStat::Stamp tScore = stat ? PredictStat::now() : PredictStat::Stamp();
   for (size_t row = rowStart; row != rowEnd; row++) {
-    (this->*Predict::walkTree)(row);
     testing ? testRow(row) : (void) scoreRow(row);
   }
+  if (stat) {
+    stat->tWalk += chrono::duration<double>(tScore - tWalk).count();
+    stat->tScore += PredictStat::since(tScore);
+  }
 }
 
 
 void PredictCtg::scoreSeq(size_t rowStart, size_t rowEnd) {
+  PredictStat* stat = statLocal();
+  PredictStat::Stamp tWalk = stat ? PredictStat::now() : PredictStat::Stamp();
+  if (earlyExit) {
+    vector<IndexT> votes(nCtgTrain);
+    for (size_t row = rowStart; row != rowEnd; row++) {
+      walkEarly(row, votes);
+    }
+  }
+  else {
+    walkSeq(rowStart, rowEnd);
+  }
+  PredictStat::Stamp tScore = stat ? PredictStat::now() : PredictStat::Stamp();
   for (size_t row = rowStart; row != rowEnd; row++) {
-    (this->*Predict::walkTree)(row);
     testing ? testRow(row) : scoreRow(row);
   }
+  if (stat) {
+    stat->tWalk += chrono::duration<double>(tScore - tWalk).count();
+    stat->tScore += PredictStat::since(tScore);
+  }
+}
+
+
+void PredictCtg::walkEarly(size_t row,
+			   vector<IndexT>& votes) {
+  unsigned int tStart = 0;
+  while (tStart < nTree) {
+    unsigned int tEnd = min(nTree, tStart + laneWidth);
+    (this->*walkTree)(row, tStart, tEnd);
+    for (unsigned int tIdx = tStart; tIdx < tEnd; tIdx++) {
+      double score;
+      if (isLeafIdx(row, tIdx, score)) {
+	votes[floor(score)]++; // Truncates jittered score, as in census.
+      }
+    }
+    tStart = tEnd;
+
+    IndexT lead = 0;
+    IndexT runnerUp = 0;
+    for (auto count : votes) {
+      if (count > lead) {
+	runnerUp = lead;
+	lead = count;
+      }
+      else if (count > runnerUp) {
+	runnerUp = count;
+      }
+    }
+    if (lead - runnerUp > (1.0 - exitTolerance) * (nTree - tStart))
+      break;
+  }
+
+  fill(votes.begin(), votes.end(), 0);
+  if (yTarg == &yPred) {
+    nTreeUsed[row] = tStart;
+  }
+}
+
+
+unsigned int Predict::treeBlockSize(const Forest* forest) const {
+  size_t forestBytes = forest->getNode().size() * sizeof(DecNode);
+  if ((engine && !engine->isSelective()) || forestBytes <= cacheBytes) {
+    return nTree;
+  }
+  else {
+    return max<size_t>(1, (nTree * cacheBytes) / forestBytes);
+  }
+}
+
+
+void Predict::walkSeq(size_t rowStart, size_t rowEnd) {
+  if (blockRep != nullptr || treesWalked) { // Terminals already collected.
+    return;
+  }
+  if (permuteTrees != nullptr) {
+    walkPermuted(rowStart, rowEnd);
+    return;
+  }
+
+  for (unsigned int tStart = 0; tStart < nTree; tStart += treeBlock) {
+    walkRange(rowStart, rowEnd, tStart, min(nTree, tStart + treeBlock));
+  }
+
+  if (!leafCache.empty()) {
+    copy(predictLeaves.data() + nTree * (rowStart - blockStart), predictLeaves.data() + nTree * (rowEnd - blockStart), leafCache.data() + nTree * rowStart);
+  }
+}
+
+
+bool Predict::walkByTree(size_t span) const {
+  unsigned int nThread = OmpThread::nThread;
+  return nThread > 1 && blockRep == nullptr && permuteTrees == nullptr
+    && (walker == nullptr || walker->isSelective())
+    && (span + seqChunk - 1) / seqChunk < nThread && nTree >= 2 * nThread;
+}
+
+
+bool PredictCtg::walkByTree(size_t span) const {
+  return !earlyExit && Predict::walkByTree(span);
+}
+
+
+void Predict::walkTrees(size_t rowStart, size_t rowEnd) {
+  // Chunks are no wider than the cache budget, nor so wide as to idle threads.
+  unsigned int nThread = OmpThread::nThread;
+  unsigned int treeChunk = max(1u, min(treeBlock, (nTree + 4 * nThread - 1) / (4 * nThread)));
+  OMPBound nChunk = (nTree + treeChunk - 1) / treeChunk;
+#pragma omp parallel default(shared) num_threads(nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound chunkIdx = 0; chunkIdx < nChunk; chunkIdx++) {
+    unsigned int tStart = chunkIdx * treeChunk;
+    walkRange(rowStart, rowEnd, tStart, min(nTree, tStart + treeChunk));
+  }
+  }
+
+  if (!leafCache.empty()) {
+    copy(predictLeaves.data() + nTree * (rowStart - blockStart), predictLeaves.data() + nTree * (rowEnd - blockStart), leafCache.data() + nTree * rowStart);
+  }
+}
+
+
+void Predict::walkPermuted(size_t rowStart, size_t rowEnd) {
+  copy(leafCache.data() + nTree * rowStart, leafCache.data() + nTree * rowEnd, predictLeaves.data() + nTree * (rowStart - blockStart));
+  for (auto tIdx : *permuteTrees) {
+    walkRange(rowStart, rowEnd, tIdx, tIdx + 1);
+  }
+}
+
+
+void Predict::walkRange(size_t rowStart,
+			size_t rowEnd,
+			unsigned int tStart,
+			unsigned int tEnd) {
+  if (walker != nullptr) {
+    walker->walkRange(rowStart, rowEnd, tStart, tEnd);
+    return;
+  }
+
+  size_t row = rowStart;
+  if (walkTree == &Predict::walkTyped<true, false>) {
+    for (; row + laneWidth <= rowEnd; row += laneWidth) {
+      walkLanes(row, tStart, tEnd);
+    }
+  }
+  for (; row != rowEnd; row++) {
+    (this->*walkTree)(row, tStart, tEnd);
+  }
 }
 
 
 
 unsigned int PredictReg::scoreRow(size_t row) {
-  (*yTarg)[row] = response->predictObs(this, row);
+  yTarg[row] = response->predictObs(this, row);
   if (!quant->isEmpty()) {
+    PredictStat* stat = statLocal();
+    PredictStat::Stamp tStart = stat ? PredictStat::now() : PredictStat::Stamp();
     quant->predictRow(this, row);
+    if (stat)
+      stat->tEstimate += PredictStat::since(tStart);
   }
+  if (jackVar && yTarg == yOut)
+    jackVar->predictRow(this, row);
+  if (multiReg && yTarg == yOut)
+    multiReg->predictRow(this, row);
   return nEst;
 }
 
 
+void PredictReg::enableJackVar() {
+  jackVar = make_unique<JackVar>(sampler, nRow);
+}
+
+
+void PredictReg::enableMulti(const Leaf* leaf,
+			     const vector<double>& yTrain,
+			     unsigned int nOut) {
+  multiReg = make_unique<MultiReg>(sampler, leaf, nRow, yTrain, nOut);
+}
+
+
 void PredictCtg::scoreRow(size_t row) {
-  (*yTarg)[row] = response->predictObs(this, row, &census[ctgIdx(row)]);
-  if (!ctgProb->isEmpty())
-    ctgProb->predictRow(this, row, &census[ctgIdx(row)]);
+  PredictorT* ctgRow = &censusRow[OmpThread::threadIdx()][0];
+  fill(ctgRow, ctgRow + nCtgTrain, 0);
+  (*yTarg)[row] = response->predictObs(this, row, ctgRow);
+  if (yTarg != &yPred) // Permuted:  only the prediction is scored.
+    return;
+
+  if (doCensus) {
+    if (censusOut.isBound()) {
+      for (PredictorT ctg = 0; ctg != nCtgTrain; ctg++)
+	censusOut.set(row, ctg, ctgRow[ctg]);
+    }
+    else if (censusNarrow)
+      copy(ctgRow, ctgRow + nCtgTrain, &census16[ctgIdx(row)]);
+    else
+      copy(ctgRow, ctgRow + nCtgTrain, &census32[ctgIdx(row)]);
+  }
+  if (!ctgProb->isEmpty()) {
+    PredictStat* stat = statLocal();
+    PredictStat::Stamp tStart = stat ? PredictStat::now() : PredictStat::Stamp();
+    ctgProb->predictRow(this, row, ctgRow);
+    if (stat)
+      stat->tEstimate += PredictStat::since(tStart);
+  }
+  if (topK > 0)
+    setTop(row, ctgRow);
+}
+
+
+void PredictCtg::setTop(size_t row,
+			const PredictorT* ctgRow) {
+  vector<PredictorT>& ctgOrder = topScratch[OmpThread::threadIdx()];
+  iota(ctgOrder.begin(), ctgOrder.end(), 0);
+  bool hasProb = !ctgProb->isEmpty();
+  auto weight = [&](PredictorT ctg) -> double {
+    return hasProb ? ctgProb->getProb(row, ctg) : ctgRow[ctg];
+  };
+  partial_sort(ctgOrder.begin(), ctgOrder.begin() + topK, ctgOrder.end(),
+	       [&](PredictorT a, PredictorT b) {
+		 return weight(a) > weight(b) || (weight(a) == weight(b) && a < b);
+	       });
+
+  double scale = 1.0;
+  if (!hasProb) {
+    PredictorT nVote = accumulate(ctgRow, ctgRow + nCtgTrain, 0u);
+    scale = nVote == 0 ? 0.0 : 1.0 / nVote;
+  }
+  for (PredictorT rank = 0; rank < topK; rank++) {
+    topCtg[row * topK + rank] = ctgOrder[rank];
+    topWeight[row * topK + rank] = weight(ctgOrder[rank]) * scale;
+  }
 }
 
 
 void PredictReg::testRow(size_t row) {
   IndexT rowIdx = row - blockStart;
   accumNEst[rowIdx] += scoreRow(row);
-  double testError = fabs(yTest[row] - (*yTarg)[row]);
+  double testError = fabs(yTest[row] - yTarg[row]);
   accumAbsErr[rowIdx] += testError;
   accumSSE[rowIdx] += testError * testError;
+  if (!sweep.empty() && yTarg == yOut)
+    sweepRow(row);
+}
+
+
+void PredictReg::sweepRow(size_t row) {
+  size_t sweepBase = OmpThread::threadIdx() * sweep.size();
+  response->predictSweep(this, row, sweep, &sweepPred[sweepBase]);
+  for (size_t sIdx = 0; sIdx != sweep.size(); sIdx++) {
+    double testError = fabs(yTest[row] - sweepPred[sweepBase + sIdx]);
+    sweepSAE[sweepBase + sIdx] += testError;
+    sweepSSE[sweepBase + sIdx] += testError * testError;
+  }
 }
 
 
 void PredictCtg::testRow(size_t row) {
   scoreRow(row);
+  if (!sweep.empty() && yTarg == &yPred)
+    sweepRow(row);
+}
+
+
+void PredictCtg::sweepRow(size_t row) {
+  unsigned int thrIdx = OmpThread::threadIdx();
+  size_t sweepBase = thrIdx * sweep.size();
+  response->predictSweep(this, row, sweep, &sweepCensus[thrIdx * nCtgTrain], sweepJitter[thrIdx], &sweepPred[sweepBase]);
+  for (size_t sIdx = 0; sIdx != sweep.size(); sIdx++) {
+    sweepMiss[sweepBase + sIdx] += sweepPred[sweepBase + sIdx] == yTest[row] ? 0 : 1;
+  }
+}
+
+
+vector<unsigned int> Predict::sweepPoints(vector<unsigned int> treeSweep,
+					  unsigned int nTree) {
+  treeSweep.erase(remove_if(treeSweep.begin(), treeSweep.end(), [nTree](unsigned int nSweep) { return nSweep == 0 || nSweep > nTree; }), treeSweep.end());
+  sort(treeSweep.begin(), treeSweep.end());
+  treeSweep.erase(unique(treeSweep.begin(), treeSweep.end()), treeSweep.end());
+  return treeSweep;
+}
+
+
+vector<double> PredictReg::getSweepSSE() const {
+  vector<double> sseSweep(sweep.size());
+  for (size_t idx = 0; idx != sweepSSE.size(); idx++) {
+    sseSweep[idx % sweep.size()] += sweepSSE[idx];
+  }
+  return sseSweep;
+}
+
+
+vector<double> PredictReg::getSweepSAE() const {
+  vector<double> saeSweep(sweep.size());
+  for (size_t idx = 0; idx != sweepSAE.size(); idx++) {
+    saeSweep[idx % sweep.size()] += sweepSAE[idx];
+  }
+  return saeSweep;
 }
 
 
-const vector<double>  PredictReg::getQPred() const {
+vector<double> PredictCtg::getSweepMispred() const {
+  vector<double> mispredSweep(sweep.size());
+  for (size_t idx = 0; idx != sweepMiss.size(); idx++) {
+    mispredSweep[idx % sweep.size()] += sweepMiss[idx];
+  }
+  for (auto& mispred : mispredSweep) {
+    mispred /= nRow;
+  }
+  return mispredSweep;
+}
+
+
+const vector<double>& PredictReg::getQPred() const {
   return quant->getQPred();
 }
 
 
-const vector<double> PredictReg::getQEst() const {
+const vector<double>& PredictReg::getQEst() const {
   return quant->getQEst();
 }
 
 
-void Predict::walkNum(size_t row) {
-  auto rowT = baseNum(row);
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    if (!sampler->isBagged(tIdx, row)) {
-      rowNum(tIdx, rowT, row);
+unsigned int PredictReg::getNQuant() const {
+  return quant->isEmpty() ? 0 : quant->getNQuant();
+}
+
+
+void PredictReg::bindYPred(double yPred_[]) {
+  yOut = yTarg = yPred_;
+  yPred = vector<double>();
+}
+
+
+void PredictReg::bindQuant(const PredictOut& qOut,
+			   const PredictOut& qEstOut) {
+  if (!quant->isEmpty())
+    quant->bind(qOut, qEstOut);
+}
+
+
+void PredictCtg::bindCensus(const PredictOut& censusOut_) {
+  if (doCensus) {
+    censusOut = censusOut_;
+    census16 = vector<uint16_t>();
+    census32 = vector<PredictorT>();
+  }
+}
+
+
+template<bool hasNum, bool hasFac>
+void Predict::walkTyped(size_t row,
+			unsigned int tStart,
+			unsigned int tEnd) {
+  const double* rowNT = hasNum ? baseNum(row) : nullptr;
+  const CtgT* rowFT = hasFac ? baseFac(row) : nullptr;
+  const DecNode* nodeBase = nodeLocal();
+  const BVSlotT* bitBase = hasFac ? bitsLocal() : nullptr;
+  unsigned int group[treeWidth];
+  unsigned int tIdx = nextOOB(row, tStart, tEnd);
+  while (tIdx < tEnd) {
+    unsigned int nGroup = 0;
+    for (; tIdx < tEnd && nGroup < treeWidth; tIdx = nextOOB(row, tIdx + 1, tEnd)) {
+      group[nGroup++] = tIdx;
+    }
+    if (nGroup == 1) {
+      rowTyped<hasNum, hasFac>(group[0], rowNT, rowFT, row, nodeBase, bitBase);
+    }
+    else {
+      treesTyped<hasNum, hasFac>(group, nGroup, rowNT, rowFT, row, nodeBase, bitBase);
     }
   }
 }
 
 
-void Predict::walkFac(size_t row) {
-  const CtgT* rowT = baseFac(row);
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    if (!sampler->isBagged(tIdx, row)) {
-      rowFac(tIdx, rowT, row);
+template<bool hasNum, bool hasFac>
+void Predict::treesTyped(const unsigned int group[],
+			 unsigned int nGroup,
+			 const double* rowNT,
+			 const CtgT* rowFT,
+			 size_t row,
+			 const DecNode* nodeBase,
+			 const BVSlotT* bitBase) {
+  size_t nodeStart[treeWidth];
+  const BVSlotT* bits[treeWidth];
+  IndexT idx[treeWidth] = {0};
+  for (unsigned int lane = 0; lane < nGroup; lane++) {
+    nodeStart[lane] = nodeOrigin[group[lane]];
+    bits[lane] = hasFac ? bitBase + bitOrigin[group[lane]] : nullptr;
+    if (!hasFac)
+      idx[lane] = entryNode(group[lane], rowNT);
+  }
+
+  IndexT delAny;
+  do {
+    delAny = 0;
+    for (unsigned int lane = 0; lane < nGroup; lane++) {
+      const DecNode& node = nodeBase[nodeStart[lane] + idx[lane]];
+      if (node.isNonterminal()) {
+	IndexT delIdx = stepTyped<hasNum, hasFac>(node, nodeStart[lane] + idx[lane], rowNT, rowFT, bits[lane]);
+	idx[lane] += delIdx;
+	prefetchNode(&nodeBase[nodeStart[lane] + idx[lane]]);
+	delAny |= delIdx;
+      }
     }
+  } while (delAny != 0);
+
+  for (unsigned int lane = 0; lane < nGroup; lane++) {
+    predictLeaf(row, group[lane], idx[lane]);
   }
 }
 
 
-void Predict::walkMixed(size_t row) {
-  const double* rowNT = baseNum(row);
-  const CtgT* rowFT = baseFac(row);
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    if (!sampler->isBagged(tIdx, row)) {
-      rowMixed(tIdx, rowNT, rowFT, row);
+void Predict::walkLanes(size_t rowStart,
+			unsigned int tStart,
+			unsigned int tEnd) {
+  const double* rowT[laneWidth];
+  for (unsigned int lane = 0; lane < laneWidth; lane++) {
+    rowT[lane] = baseNum(rowStart + lane);
+  }
+
+  const DecNode* nodeBase = nodeLocal();
+  for (unsigned int tIdx = tStart; tIdx < tEnd; tIdx++) {
+    const DecNode* cTree = nodeBase + nodeOrigin[tIdx];
+    IndexT idx[laneWidth];
+    for (unsigned int lane = 0; lane < laneWidth; lane++) {
+      idx[lane] = entryNode(tIdx, rowT[lane]);
+    }
+    IndexT delAny;
+    do {
+      delAny = 0;
+      for (unsigned int lane = 0; lane < laneWidth; lane++) {
+	IndexT delIdx = cTree[idx[lane]].advance(rowT[lane]);
+	idx[lane] += delIdx;
+	delAny |= delIdx;
+      }
+    } while (delAny != 0);
+
+    for (unsigned int lane = 0; lane < laneWidth; lane++) {
+      if (!isBagged(tIdx, rowStart + lane)) {
+	predictLeaf(rowStart + lane, tIdx, idx[lane]);
+      }
     }
   }
 }
 
 
-void Predict::rowNum(unsigned int tIdx,
-		       const double* rowT,
-		       size_t row) {
-  const vector<DecNode>& cTree = decNode[tIdx];
-  auto idx = 0;
-  IndexT delIdx = 0;
-  do {
-    delIdx = cTree[idx].advance(rowT);
-    idx += delIdx;
-  } while (delIdx != 0);
+void Predict::walkEngine(size_t row,
+			 unsigned int tStart,
+			 unsigned int tEnd) {
+  walker->walk(row, tStart, tEnd);
+}
 
-  predictLeaf(row, tIdx, idx);
+
+void (Predict::* Predict::typedWalk() const)(size_t, unsigned int, unsigned int) {
+  return nPredFac == 0 ? &Predict::walkTyped<true, false> : (nPredNum == 0 ? &Predict::walkTyped<false, true> : &Predict::walkTyped<true, true>);
 }
 
 
-void Predict::rowFac(const unsigned int tIdx,
-		     const CtgT* rowT,
-		     size_t row) {
-  const vector<DecNode>& cTree = decNode[tIdx];
-  IndexT idx = 0;
-  IndexT delIdx = 0;
-  do {
-    delIdx = cTree[idx].advance(factorBits, rowT, tIdx);
-    idx += delIdx;
-  } while (delIdx != 0);
+void Predict::engageWalker(Walker* walker_) {
+  walker = walker_;
+  walkTree = walker == nullptr ? typedWalk() : &Predict::walkEngine;
+}
 
-  predictLeaf(row, tIdx, idx);
+
+void Predict::maskBagged(size_t row) {
+  IndexT* leafRow = &predictLeaves[nTree * (row - blockStart)];
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    if (isBagged(tIdx, row)) {
+      leafRow[tIdx] = noNode;
+    }
+  }
 }
 
 
-void Predict::rowMixed(unsigned int tIdx,
+template<bool hasNum, bool hasFac>
+void Predict::rowTyped(unsigned int tIdx,
 		       const double* rowNT,
 		       const CtgT* rowFT,
-		       size_t row) {
-  const vector<DecNode>& cTree = decNode[tIdx];
-  auto idx = 0;
-  IndexT delIdx = 0;
-  do {
-    delIdx = cTree[idx].advance(this, factorBits, rowFT, rowNT, tIdx);
-    idx += delIdx;
-  } while (delIdx != 0);
+		       size_t row,
+		       const DecNode* nodeBase,
+		       const BVSlotT* bitBase) {
+  size_t nodeStart = nodeOrigin[tIdx];
+  const DecNode* cTree = nodeBase + nodeStart;
+  const BVSlotT* bits = hasFac ? bitBase + bitOrigin[tIdx] : nullptr;
+  IndexT idx = hasFac ? 0 : entryNode(tIdx, rowNT);
+  while (!cTree[idx].isTerminal()) {
+    idx += stepTyped<hasNum, hasFac>(cTree[idx], nodeStart + idx, rowNT, rowFT, bits);
+  }
 
   predictLeaf(row, tIdx, idx);
 }
 
 
+template<bool hasNum, bool hasFac>
+IndexT Predict::stepTyped(const DecNode& node,
+			  size_t nodeIdx,
+			  const double* rowNT,
+			  const CtgT* rowFT,
+			  const BVSlotT* bits) const {
+  if (hasNum && hasFac) {
+    const NodeBlock& nb = nodeBlock[nodeIdx];
+    return nb.isFactor ? node.advanceFactor(bits, rowFT[nb.blockIdx]) : node.advanceNum(rowNT[nb.blockIdx]);
+  }
+  else if (hasNum) {
+    return node.advanceNum(rowNT[node.getPredIdx()]);
+  }
+  else {
+    return node.advanceFactor(bits, rowFT[node.getPredIdx()]);
+  }
+}
+
+
 bool Predict::isLeafIdx(size_t row,
 			unsigned int tIdx,
 			IndexT& leafIdx) const {
     IndexT termIdx = predictLeaves[nTree * (row - blockStart) + tIdx];
-    return termIdx == noNode ? false : decNode[tIdx][termIdx].getLeafIdx(leafIdx);
+    return termIdx == noNode ? false : nodeLocal()[nodeOrigin[tIdx] + termIdx].getLeafIdx(leafIdx);
 }
 
 
@@ -417,32 +1551,113 @@ void PredictCtg::dump() const {
 }
 
 
-CtgProb::CtgProb(const Predict* predict,
+CtgProb::CtgProb(const Forest* forest,
+		 const Predict* predict,
 		 const ResponseCtg* response,
-		 bool doProb) :
+		 const Leaf* leaf_,
+		 bool doProb,
+		 bool probSample) :
   nCtg(response->getNCtg()),
   probDefault(response->defaultProb()),
-  probs(vector<double>(doProb ? predict->getNRow() * nCtg : 0)) {
+  probs(vector<double>(doProb ? predict->getNRow() * nCtg : 0)),
+  probOut(doProb ? PredictOut(probs.data(), predict->getNRow(), nCtg) : PredictOut()),
+  leaf(leaf_),
+  leafDom((doProb && probSample && predict->trapAndBail()) ? forest->getIndex().getLeafDom() : ForestIndex::noDom),
+  probAcc(vector<vector<float>>((doProb && probSample) ? max(1u, OmpThread::nThread) : 0, vector<float>(nCtg))) {
+  if (doProb && probSample) {
+    normalizeLeaves(predict->getSampler(), response);
+  }
+}
+
+
+void CtgProb::normalizeLeaves(const Sampler* sampler,
+			      const ResponseCtg* response) {
+  if (leaf == nullptr || leaf->isThin())
+    throw invalid_argument("Sample-weighted probabilities require leaf contents:  train without thinning");
+  vector<IndexT> ctgCount = leaf->countLeafCtg(sampler, response);
+  if (ctgCount.empty())
+    throw invalid_argument("Sample-weighted probabilities require sampler contents");
+
+  size_t nLeaf = ctgCount.size() / nCtg;
+  leafProb = vector<float>(ctgCount.size());
+  if (!leafDom.empty())
+    leafSize = vector<float>(nLeaf);
+  for (size_t leafPos = 0; leafPos < nLeaf; leafPos++) {
+    const IndexT* countLeaf = &ctgCount[leafPos * nCtg];
+    IndexT sCount = accumulate(countLeaf, countLeaf + nCtg, 0ul);
+    if (sCount == 0)
+      continue;
+    for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
+      leafProb[leafPos * nCtg + ctg] = static_cast<float>(countLeaf[ctg]) / sCount;
+    }
+    if (!leafSize.empty())
+      leafSize[leafPos] = sCount;
+  }
+}
+
+
+unsigned int CtgProb::sampleRow(const Predict* predict,
+				size_t row,
+				float* acc) const {
+  fill(acc, acc + nCtg, 0.0f);
+  unsigned int nTree = 0;
+  for (unsigned int tIdx = 0; tIdx < predict->getNTree(); tIdx++) {
+    IndexT leafIdx;
+    IndexT nodeIdx;
+    if (predict->isLeafIdx(row, tIdx, leafIdx)) {
+      addLeaf(leaf->getLeafPos(tIdx, leafIdx), 1.0f, acc);
+      nTree++;
+    }
+    else if (!leafDom.empty() && predict->isTrapped(row) && predict->isNodeIdx(row, tIdx, nodeIdx)) {
+      // Trapped:  pools the dominated leaves' samples.
+      IndexRange leafRange = leafDom[tIdx][nodeIdx];
+      float sizeTot = 0.0;
+      for (IndexT leafIdx = leafRange.getStart(); leafIdx != leafRange.getEnd(); leafIdx++) {
+	sizeTot += leafSize[leaf->getLeafPos(tIdx, leafIdx)];
+      }
+      if (sizeTot > 0.0) {
+	for (IndexT leafIdx = leafRange.getStart(); leafIdx != leafRange.getEnd(); leafIdx++) {
+	  size_t leafPos = leaf->getLeafPos(tIdx, leafIdx);
+	  addLeaf(leafPos, leafSize[leafPos] / sizeTot, acc);
+	}
+	nTree++;
+      }
+    }
+  }
+  return nTree;
 }
 
 
 void CtgProb::predictRow(const Predict* predict, size_t row, PredictorT* ctgRow) {
+  if (!probAcc.empty()) {
+    float* acc = &probAcc[OmpThread::threadIdx()][0];
+    unsigned int nTree = sampleRow(predict, row, acc);
+    if (nTree == 0) {
+      applyDefault(row);
+    }
+    else {
+      double scale = 1.0 / nTree;
+      for (PredictorT ctg = 0; ctg < nCtg; ctg++)
+	probOut.set(row, ctg, acc[ctg] * scale);
+    }
+    return;
+  }
+
   unsigned int nEst = accumulate(ctgRow, ctgRow + nCtg, 0ul);
-  double* probRow = &probs[row * nCtg];
   if (nEst == 0) {
-    applyDefault(probRow);
+    applyDefault(row);
   }
   else {
     double scale = 1.0 / nEst;
     for (PredictorT ctg = 0; ctg < nCtg; ctg++)
-      probRow[ctg] = ctgRow[ctg] * scale;
+      probOut.set(row, ctg, ctgRow[ctg] * scale);
   }
 }
 
 
-void CtgProb::applyDefault(double probPredict[]) const {
+void CtgProb::applyDefault(size_t row) const {
   for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
-    probPredict[ctg] = probDefault[ctg];
+    probOut.set(row, ctg, probDefault[ctg]);
   }
 }
 
@@ -19,35 +19,107 @@
 #include "block.h"
 #include "typeparam.h"
 #include "bv.h"
+#include "bagstore.h"
 #include "decnode.h"
+#include "arena.h"
+#include "walker.h"
+#include "forestreplica.h"
+#include "foresttop.h"
+#include "predictstat.h"
+#include "treeshap.h"
+#include "localimp.h"
+#include "nodetraffic.h"
+#include "partialdep.h"
+#include "jackvar.h"
+#include "multireg.h"
+#include "predictout.h"
+#include "ompthread.h"
 
 #include <vector>
 #include <algorithm>
 
 
+/**
+   @brief Typed-block coordinates of a node's splitting predictor.
+
+   Precomputed for mixed frames, so that the walker need not
+   dispatch on predictor type.
+ */
+struct NodeBlock {
+  PredictorT blockIdx; // Index within the numeric or factor block.
+  bool isFactor; // Whether the predictor is factor-valued.
+};
+
+
 /**
    @brief Categorical probabilities associated with indivdual leaves.
 
    Intimately accesses the raw jagged array it contains.
+
+   If sample-weighted, each leaf's category distribution is normalized
+   once, into a flat arena indexed by leaf position.  A row's
+   probabilities are then the mean of its leaves' distributions, rather
+   than the vote fractions of its census.
  */
 class CtgProb {
   const PredictorT nCtg; // Training cardinality.
   const vector<double> probDefault; // Forest-wide default probability.
   vector<double> probs; // Per-row probabilties.
+  PredictOut probOut; // Destination of probabilities:  probs unless bound.
+  const struct Leaf* leaf; // Leaf positions, iff sample-weighted.
+  vector<float> leafProb; // Leaf x category distributions, iff sample-weighted.
+  vector<float> leafSize; // Leaf sample totals, iff trapping.
+  const vector<vector<IndexRange>>& leafDom; // Dominated leaves, iff trapping.
+  vector<vector<float>> probAcc; // Per-thread distribution sums.
+
+
+  /**
+     @brief Normalizes the category counts of every leaf, once.
+   */
+  void normalizeLeaves(const class Sampler* sampler,
+		       const class ResponseCtg* response);
+
+
+  /**
+     @brief Adds a leaf's scaled distribution to an accumulator.
+   */
+  inline void addLeaf(size_t leafPos,
+		      float scale,
+		      float* acc) const {
+    const float* dist = &leafProb[leafPos * nCtg];
+#pragma omp simd
+    for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
+      acc[ctg] += scale * dist[ctg];
+    }
+  }
+
 
-  
   /**
-     @brief Copies default probability vector into argument.
+     @brief Averages the distributions of a row's leaves.
 
-     @param[out] probPredict outputs the default category probabilities.
+     @return number of trees contributing.
+   */
+  unsigned int sampleRow(const class Predict* predict,
+			 size_t row,
+			 float* acc) const;
+
+  
+  /**
+     @brief Outputs the default probability vector for a row.
    */
-  void applyDefault(double probPredict[]) const;
+  void applyDefault(size_t row) const;
   
 
 public:
-  CtgProb(const class Predict* predict,
+  /**
+     @param probSample is true iff probabilities are sample-weighted.
+   */
+  CtgProb(const class Forest* forest,
+	  const class Predict* predict,
 	  const class ResponseCtg* response,
-	  bool doProb);
+	  const struct Leaf* leaf_,
+	  bool doProb,
+	  bool probSample);
 
   
   /**
@@ -62,17 +134,40 @@ public:
 		  PredictorT* ctgRow);
 
   bool isEmpty() const {
-    return probs.empty();
+    return !probOut.isBound();
   }
 
   
   /**
      @brief Getter for probability vector.
+
+     @return row x category probabilities, empty if bound.
    */
-  const vector<double>& getProb() {
+  const vector<double>& getProb() const {
     return probs;
   }
 
+
+  /**
+     @return probability of a category at a row, as output.
+   */
+  double getProb(size_t row,
+		 PredictorT ctg) const {
+    return probOut.get(row, ctg);
+  }
+
+
+  /**
+     @brief Directs probabilities to caller storage, if computed,
+     releasing the core vector.
+   */
+  void bind(const PredictOut& probOut_) {
+    if (!isEmpty()) {
+      probOut = probOut_;
+      probs = vector<double>();
+    }
+  }
+
   
   /**
      @brief Dumps the probability cells.
@@ -89,11 +184,21 @@ class Predict {
 protected:
   static const size_t scoreChunk; // Score block dimension.
   static const unsigned int seqChunk;  // Effort to minimize false sharing.
+  static constexpr unsigned int treeWidth = 8; // # trees walked in lockstep, per row.
+  static const size_t cacheBytes; // Nominal per-core cache budget.
+  static const size_t transposeTile; // # rows expanded per column pass.
+  static const size_t permuteCacheBytes; // Bound on baseline blocks cached for permutation.
+  static const size_t calibRows; // # synthetic rows timed per candidate walker.
+  static const double quickLeaves; // Mean leaves per tree favoring QuickScorer.
 
   const bool trapUnobserved; // Whether to trap values not observed during training.
   const class Sampler* sampler; // In-bag representation.
-  const vector<vector<DecNode>> decNode; // Forest-wide decision nodes.
-  const vector<unique_ptr<BV>>& factorBits;
+  const Arena<DecNode>& decNode; // Forest-wide node arena, not copied.
+  const vector<size_t>& nodeOrigin; // Per-tree offsets into arena.
+  const BVSlotT* bitPool; // Forest-wide factor bits.
+  const vector<size_t>& bitOrigin; // Per-tree offsets into bit pool.
+  vector<NodeBlock> nodeBlock; // Aligned with decNode iff mixed frame.
+  const BagStore* obsBag; // Observation-major bag, iff bagging.
   const bool testing; // Whether to compare prediction with test vector.
   const unsigned int nPermute; // # times to permute each predictor.
 
@@ -103,24 +208,75 @@ protected:
   vector<IndexT> accumNEst;
 
   size_t nEst; // Total number of estimands.
+
+  unique_ptr<Walker> engine; // Walked in place of the typed nodes, iff requested.
+  unique_ptr<WalkSelect> walkSelect; // Non-null iff selecting the walker on engagement.
+  const ForestDag* forestDag; // Non-null iff walking shared subtrees, owned by 'engine'.
+  unique_ptr<ForestReplica> forestReplica; // Non-null iff replicated per domain.
+  unique_ptr<ForestTop> forestTop; // Non-null iff numeric walk enters below top levels.
+
+  // Permutation state:
+  const vector<vector<unsigned int>> predTree; // Trees splitting on each core predictor.
+  vector<unsigned char> predSplit; // Nonzero iff some tree splits on the core predictor.
+  vector<IndexT> leafCache; // Unpermuted terminals, all rows, iff selective.
+  const vector<unsigned int>* permuteTrees; // Trees to re-walk, iff permuting selectively.
+  PredictorT permuteIdx; // Frame index of predictor permuted, if any.
+  unsigned int permuteTyped; // Typed index of 'permuteIdx'.
+  bool blockCached; // Whether baseline blocks are cached for patching.
+  vector<double> numCache; // Baseline numeric blocks, all rows, iff cached.
+  vector<BinCodeT> codeCache; // Baseline numeric codes, " ".
+  vector<CtgT> facCache; // Baseline factor blocks, " ".
+
+  struct LeafSink* leafSink; // Consumer of leaf assignments, if any.
+  unique_ptr<TreeShap> treeShap; // Non-null iff attributing.
+  unique_ptr<PartialDep> partialDep; // Non-null iff evaluating dependence.
+  unique_ptr<LocalImp> localImp; // Non-null iff measuring local importance.
+  unique_ptr<NodeTraffic> nodeTraffic; // Non-null iff monitoring traffic.
+  vector<size_t> leafOrigin; // Forest-wide leaf offsets by tree, plus sup.
+
+  // Instrumentation:
+  unique_ptr<PredictStat> predictStat; // Non-null iff instrumenting.
+  vector<PredictStat> statThread; // Row-level timers, by thread.
+  vector<IndexT> nodeDepth; // Tree-relative depth, indexed as decNode.
   
   
   /**
-     @brief Assigns a relative node index at the prediction coordinates passed.
+     @brief Emits the current block's leaf assignments to the sink.
 
-     @param row is the row number.
+     @param span is the number of rows in the block.
+   */
+  void emitLeaves(size_t span) const;
 
-     @param tc is the index of the current tree.
 
-     @param idx is an absolute node index.
+  /**
+     @return row-level timers of the calling thread, iff instrumenting.
    */
-  inline void predictLeaf(size_t row,
-                          unsigned int tIdx,
-                          IndexT idx) {
-    predictLeaves[nTree * (row - blockStart) + tIdx] = idx;
+  PredictStat* statLocal() {
+    return predictStat ? &statThread[OmpThread::threadIdx()] : nullptr;
   }
 
 
+  /**
+     @brief Folds the current block's depth, bail and timing statistics
+     into the session's.
+
+     @param span is the number of rows in the block.
+   */
+  void recordBlock(size_t span);
+
+
+  /**
+     @brief Transposes a ranked block, timing the transposition iff
+     instrumenting.
+
+     Parameters as transpose().
+   */
+  void transposeBlock(const struct RLEFrame* rleFrame,
+		      vector<size_t>& idxTr,
+		      size_t rowStart,
+		      size_t rowExtent);
+
+
   /**
      @brief Performs prediction on separately-permuted predictor columns.
 
@@ -148,6 +304,10 @@ protected:
   /**
      @brief Transposes typed blocks, prediction-style.
 
+     Runs are expanded a column at a time, over row tiles small enough
+     that the tile's output lines remain cached across predictors.
+     Values are looked up once per run rather than once per row.
+
      @param[in,out] idxTr is the most-recently accessed RLE index, by predictor.
 
      @param rowStart is the starting source row.
@@ -161,26 +321,293 @@ protected:
 
 
   /**
-     @brief Multi-row prediction with predictors of only numeric.
+     @brief Expands a predictor's runs over a row tile into its column.
+
+     @param typedIdx is the predictor's column within its typed block.
+
+     @param idx is the predictor's most-recently accessed run.
+
+     @param rowStart is the block's starting row.
+
+     @param[out] runStart flags rows at which a run begins, if nonempty.
+
+     @return run holding the tile's final row.
+   */
+  size_t expandColumn(const RLEFrame* rleFrame,
+		      unsigned int predIdx,
+		      unsigned int typedIdx,
+		      size_t idx,
+		      size_t rowStart,
+		      size_t tileStart,
+		      size_t tileEnd,
+		      vector<unsigned char>& runStart);
+
+
+  /**
+     @brief Records the baseline block for reuse by permutation passes.
+   */
+  void cacheBlock(size_t rowStart,
+		  size_t rowEnd);
+
+
+  /**
+     @brief Restores a cached baseline block, expanding only the
+     permuted column.
+   */
+  void patchBlock(const RLEFrame* rleFrame,
+		  vector<size_t>& idxTr,
+		  size_t rowStart,
+		  size_t rowEnd);
+
+
+  /**
+     @brief As above, but copies from dense blocks.
+
+     Parameters as above.
+   */
+  void transpose(const struct DenseFrame* denseFrame,
+		 size_t rowStart,
+		 size_t rowExtent);
+
+
+  /**
+     @brief Multi-row prediction, specialized by predictor-type mix.
+
+     Out-of-bag trees are walked in groups of 'treeWidth', as in
+     treesTyped().
+
+     @tparam hasNum is true iff the frame has numeric predictors.
+
+     @tparam hasFac is true iff the frame has factor predictors.
 
      @param rowStart is the absolute starting row for the block.
+
+     @param tStart is the first tree to walk.
+
+     @param tEnd is the sup of trees to walk.
   */
-  void walkNum(size_t rowStart);
+  template<bool hasNum, bool hasFac>
+  void walkTyped(size_t rowStart,
+		 unsigned int tStart,
+		 unsigned int tEnd);
+
 
   /**
-     @brief Multi-row prediction with predictors of only factor type.
+     @brief Walks a single row through a group of trees in lockstep.
 
-     Parameters as above.
+     Each tree keeps its own node index, and the node next visited is
+     prefetched as soon as it is known.  Loads from distinct trees are
+     therefore in flight together, rather than serialized along a
+     single root-to-leaf path.  Terminal trees advance by zero until
+     all trees in the group have terminated.
+
+     @param group lists the trees to walk.
+
+     @param nGroup is the number of trees in the group.
+
+     Remaining parameters as in rowTyped().
   */
-  void walkFac(size_t rowStart);
-  
+  template<bool hasNum, bool hasFac>
+  void treesTyped(const unsigned int group[],
+		  unsigned int nGroup,
+		  const double* rowNT,
+		  const CtgT* rowFT,
+		  size_t row,
+		  const DecNode* nodeBase,
+		  const BVSlotT* bitBase);
+
+
+  /**
+     @brief Advances from a nonterminal by a single level.
+
+     @param nodeIdx is the forest-wide index of the node.
+
+     @param bits are the tree's factor bits, if any.
+
+     @return offset of the successor node.
+   */
+  template<bool hasNum, bool hasFac>
+  IndexT stepTyped(const DecNode& node,
+		   size_t nodeIdx,
+		   const double* rowNT,
+		   const CtgT* rowFT,
+		   const BVSlotT* bits) const;
+
+
+  /**
+     @brief As above, but walks 'laneWidth' consecutive rows through
+     each tree in lockstep.
+
+     Lanes advance independently, exposing parallelism in node fetch.
+     Terminal lanes advance by zero until all lanes have terminated.
+
+     @param rowStart is the first row of the lane group.
+
+     Remaining parameters as above.
+  */
+  void walkLanes(size_t rowStart,
+		 unsigned int tStart,
+		 unsigned int tEnd);
+
+
+  /**
+     @brief Walks a sequential range of rows, dispatching to lane-wise
+     walker where applicable.
+
+     Trees are walked in blocks of 'treeBlock', each block applied to
+     the full row range before advancing to the next.
+
+     @param rowStart is the first row of the range.
+
+     @param rowEnd is the sup of the range.
+   */
+  void walkSeq(size_t rowStart,
+	       size_t rowEnd);
+
+
+  /**
+     @brief Walks a range of rows over a block of trees, dispatching to
+     lane-wise walker where applicable.
+
+     @param tStart is the first tree of the block.
+
+     @param tEnd is the sup of the block.
+
+     Remaining parameters as above.
+   */
+  void walkRange(size_t rowStart,
+		 size_t rowEnd,
+		 unsigned int tStart,
+		 unsigned int tEnd);
+
+
+  /**
+     @brief Determines whether to walk a block by tree, rather than by row.
+
+     Blocks too short to occupy the threads with row chunks are walked
+     tree-parallel, provided the walker visits trees selectively.
+
+     @param span is the number of rows in the block.
+   */
+  virtual bool walkByTree(size_t span) const;
+
+
+  /**
+     @brief Walks the rows of a block over chunks of trees in parallel.
+
+     Terminals occupy distinct slots, so need no reduction; rows are
+     then scored as usual.
+
+     Parameters as walkSeq().
+   */
+  void walkTrees(size_t rowStart,
+		 size_t rowEnd);
+
 
   /**
-     @brief Prediction with predictors of both numeric and factor type.
+     @brief As walkSeq(), but restores unpermuted terminals from the cache
+     and re-walks only those trees splitting on the permuted predictor.
+
+     Parameters as above.
+   */
+  void walkPermuted(size_t rowStart,
+		    size_t rowEnd);
+
+
+  /**
+     @brief As walkTyped(), but delegates to the engine engaged.
+
      Parameters as above.
   */
-  void walkMixed(size_t rowStart);
-  
+  void walkEngine(size_t rowStart,
+		  unsigned int tStart,
+		  unsigned int tEnd);
+
+
+  /**
+     @return typed walker specialized for the frame's predictor mix.
+   */
+  void (Predict::* typedWalk() const)(size_t, unsigned int, unsigned int);
+
+
+  /**
+     @brief Directs walking to an engine.
+
+     @param walker is the engine to walk, else null for the typed walk.
+   */
+  void engageWalker(Walker* walker);
+
+
+  /**
+     @return true iff the requested engine, if any, walks trees individually.
+   */
+  bool walksSelectively() const {
+    return !engine || engine->isSelective();
+  }
+
+
+  /**
+     @return numeric coding applied at transposition, if any.
+   */
+  ThresholdCode* coding() const {
+    return engine ? engine->getCoding() : nullptr;
+  }
+
+
+  /**
+     @brief Walks the shared subtrees iff only scores are consumed,
+     else releases them.
+   */
+  void engageShare();
+
+
+  /**
+     @brief Selects the walkers for short and full blocks, if requested.
+
+     Candidates are the typed walk and, where representable, the compact
+     and QuickScorer encodings.  Selection either profiles the forest's
+     shape or times the candidates over synthetic rows.
+   */
+  void engageAuto();
+
+
+  /**
+     @brief Times a walker over synthetic rows already transposed.
+
+     @param span is the number of rows walked per call.
+
+     @return seconds per row.
+   */
+  double timeWalk(Walker* walker,
+		  size_t nCalib,
+		  size_t span);
+
+
+  /**
+     @brief Fills the transposition buffers with rows spanning the splits.
+
+     @return number of rows synthesized.
+   */
+  size_t synthesizeRows();
+
+
+  /**
+     @return name of a walker, for reporting.
+   */
+  static const char* engineName(const Walker* walker);
+
+
+  /**
+     @return true iff no consumer requires tree-relative terminals.
+   */
+  virtual bool scoresOnly() const;
+
+
+  /**
+     @brief Builds the typed-block coordinates of every nonterminal.
+   */
+  vector<NodeBlock> blockNodes() const;
+
 
   /**
      @brief Strip-mines prediction by block.
@@ -188,6 +615,26 @@ protected:
   void predictBlock(size_t span);
 
 
+  /**
+     @brief Scores the rows of a block in parallel, by sequential chunk.
+
+     @param rowStart is the first absolute row of the block.
+
+     @param rowEnd is the sup of the block's rows.
+   */
+  void scoreRows(OMPBound rowStart,
+		 OMPBound rowEnd);
+
+
+  /**
+     @brief Walks only the representative rows of a block, then copies
+     their terminals to the rows repeating them.
+
+     @param span is the number of rows in the block.
+   */
+  void walkRuns(size_t span);
+
+
   /**
      @brief Predicts sequentially to minimize false sharing.
    */
@@ -203,41 +650,102 @@ protected:
 
   virtual void setPermuteTarget(PredictorT predIdx) = 0;
 
+
+  /**
+     @brief Determines the number of trees to walk per row tile.
+
+     Forests whose nodes exceed the nominal cache budget are walked
+     tree-major, in blocks sized to remain cache-resident.
+
+     @return block size, in trees.
+   */
+  unsigned int treeBlockSize(const class Forest* forest) const;
+
+
+  /**
+     @brief Normalizes caller-specified tree-count checkpoints.
+
+     @return checkpoints in increasing order, restricted to [1, nTree].
+   */
+  static vector<unsigned int> sweepPoints(vector<unsigned int> treeSweep,
+					  unsigned int nTree);
+
 public:
+  static constexpr unsigned int laneWidth = 8; // # rows walked in lockstep.
 
-  const vector<vector<double>> scoreBlock; // Scores, by tree.
+  const Arena<double>& scoreBlock; // Scores, indexed as decNode.
   const PredictorT nPredNum;
   const PredictorT nPredFac;
   const size_t nRow;
   const unsigned int nTree; // # trees used in training.
-  const IndexT noNode; // Inattainable leaf index value.
+  IndexT noNode; // Inattainable leaf index value.
+  const unsigned int treeBlock; // # trees walked per row tile.
 
   /**
      @brief Aliases a row-prediction method tailored for the frame's
      block structure.
    */
-  void (Predict::* walkTree)(size_t);
+  void (Predict::* walkTree)(size_t, unsigned int, unsigned int);
+  Walker* walker; // Engine walked by walkEngine(), iff any.
 
   vector<CtgT> trFac; // OTF transposed factor observations.
   vector<double> trNum; // OTF transposed numeric observations.
+  vector<BinCodeT> trCode; // OTF transposed numeric codes, if coding.
+  const double* blockNum; // Numeric block walked:  own or batch lead's.
+  const CtgT* blockFac; // Factor block walked:  " ".
+  vector<IndexT> runRep; // Block-relative representative row, iff reusing runs.
+  const IndexT* blockRep; // Representatives consulted:  own or batch lead's, if any.
+  vector<unsigned char> rowTrap; // Nonzero iff row takes an unseen level, iff trapping factors.
+  const unsigned char* blockTrap; // Trap flags consulted:  own or batch lead's, if any.
+  bool treesWalked; // Whether the block's terminals were collected tree-parallel.
 
   Predict(const class Forest* forest_,
 	  const class Sampler* sampler_,
-	  struct RLEFrame* rleFrame_,
+	  size_t nRow_,
+	  PredictorT nPredNum_,
+	  PredictorT nPredFac_,
 	  bool testing_,
 	  PredictorT nPredict_,
-	  bool trapUnobserved_);
+	  bool trapUnobserved_,
+	  bool quickScore,
+	  bool binCode,
+	  bool compact,
+	  bool reuseRuns,
+	  CompiledWalk compiledWalk_,
+	  unsigned int nReplica);
 
   virtual ~Predict() = default;
 
   /**
      @brief Main entry from bridge.
 
-     Distributed prediction will require start and extent parameters.
+     Shards of a distributed prediction are instead restricted to
+     their rows beforehand, by RLEFrame::slice().
    */
   void predict(struct RLEFrame* rleFrame);
 
 
+  /**
+     @brief As above, but transposes directly from dense blocks.
+
+     Permutation is not supported.
+   */
+  void predict(const struct DenseFrame* denseFrame);
+
+
+  /**
+     @brief Predicts several models over a single frame.
+
+     The frame is ordered once and each block is transposed once, then
+     walked by every model while resident.  Models coding numeric values
+     transpose their own codes.  The shared block covers every predictor
+     split by some model sharing it.  Models must share the frame's
+     dimensions.  Permutation is not supported.
+   */
+  static void predictBatch(const vector<Predict*>& models,
+			   struct RLEFrame* rleFrame);
+
+
   /**
      @brief Indicates whether to exit tree prematurely when an unrecognized
      obervation is encountered.
@@ -245,26 +753,86 @@ public:
   bool trapAndBail() const {
     return trapUnobserved;
   }
-  
 
-  const class Sampler* getSampler() const {
-    return sampler;
+
+  /**
+     @brief Determines whether a row must take the trapping path.
+
+     Rows whose factor values all lie within the training levels reach
+     the same leaves either way, so take the direct path.  Rows not
+     flagged by their transposition are trapped conservatively.
+
+     @param row is an absolute row within the current block.
+   */
+  bool isTrapped(size_t row) const {
+    return trapUnobserved && nPredFac > 0 && (blockTrap == nullptr || blockTrap[row - blockStart] != 0);
+  }
+
+
+  /**
+     @return true iff observation is bagged in tree.
+   */
+  inline bool isBagged(unsigned int tIdx,
+		       size_t row) const {
+    return obsBag != nullptr && obsBag->isBagged(row, tIdx);
   }
 
 
   /**
-     @brief Computes block-relative position for a predictor.
+     @brief Locates the next tree for which a row is out-of-bag.
+
+     Bagged trees are skipped without being visited.
+
+     @param tIdx is the first tree to consider.
+
+     @return least out-of-bag tree index in [tIdx, tEnd), else tEnd.
+   */
+  inline unsigned int nextOOB(size_t row,
+			      unsigned int tIdx,
+			      unsigned int tEnd) const {
+    return obsBag == nullptr ? tIdx : obsBag->nextOOB(row, tIdx, tEnd);
+  }
+
+
+  /**
+     @brief Assigns a relative node index at the prediction coordinates passed.
+
+     @param row is the row number.
+
+     @param tc is the index of the current tree.
 
-     @param[out] thisIsFactor outputs true iff predictor is factor-valued.
+     @param idx is an absolute node index.
+   */
+  inline void predictLeaf(size_t row,
+                          unsigned int tIdx,
+                          IndexT idx) {
+    predictLeaves[nTree * (row - blockStart) + tIdx] = idx;
+  }
 
-     @return block-relative index.
+
+  /**
+     @return base of a row's terminals, one per tree.
    */
-  inline unsigned int getIdx(PredictorT predIdx, bool &predIsFactor) const {
-    predIsFactor = isFactor(predIdx);
-    return predIsFactor ? predIdx - nPredNum : predIdx;
+  IndexT* leafRow(size_t row) {
+    return &predictLeaves[nTree * (row - blockStart)];
   }
 
+
+  /**
+     @brief Resets the terminals of bagged trees to the inattainable index.
+
+     Employed by walkers traversing every tree, bagged or not.
+
+     @param row is the row number.
+   */
+  void maskBagged(size_t row);
   
+
+  const class Sampler* getSampler() const {
+    return sampler;
+  }
+
+
   inline bool isFactor(PredictorT predIdx) const {
     return predIdx >= nPredNum;
   }
@@ -280,6 +848,132 @@ public:
   }
 
 
+  /**
+     @brief Directs leaf assignments of each unpermuted block to a sink.
+   */
+  void setLeafSink(struct LeafSink* sink);
+
+
+  /**
+     @brief Begins gathering timers and counters.
+
+     Statistics accumulate over all passes, permuted or not.
+   */
+  void enableStat();
+
+
+  /**
+     @brief Pools equal subtrees for walking, if this saves space.
+
+     Superseded by the other node encodings, and released at
+     prediction if some consumer requires tree-relative terminals.
+   */
+  void enableShare(const class Forest* forest);
+
+
+  /**
+     @brief Defers the choice of walker to prediction.
+
+     Ignored if an engine was requested explicitly, or if permuting.
+
+     @param calibrate is true iff candidates are timed, else the choice
+     follows the forest's shape.
+   */
+  virtual void enableAuto(const class Forest* forest,
+			  bool calibrate);
+
+
+  /**
+     @return session statistics, iff enabled.
+   */
+  const PredictStat* getStat() const {
+    return predictStat.get();
+  }
+
+
+  /**
+     @brief Directs prediction to attribute unpermuted rows by predictor.
+
+     @param nCtg is the training cardinality, zero iff regression.
+   */
+  void enableShap(const class Forest* forest,
+		  const struct Leaf* leaf,
+		  unsigned int nCtg);
+
+
+  /**
+     @return attribution engine, iff enabled.
+   */
+  const TreeShap* getShap() const {
+    return treeShap.get();
+  }
+
+
+  /**
+     @brief Directs prediction to evaluate unpermuted rows over grids
+     of predictor values.
+
+     Parameters as PartialDep constructor.
+   */
+  void enablePartial(const class Forest* forest,
+		     unsigned int nCtg,
+		     vector<PredictorT> predIdx,
+		     vector<vector<double>> grid,
+		     bool ice);
+
+
+  /**
+     @return dependence engine, iff enabled.
+   */
+  const PartialDep* getPartial() const {
+    return partialDep.get();
+  }
+
+
+  /**
+     @brief Directs prediction to measure the importance of each
+     predictor at each unpermuted row.
+
+     @param nCtg is the training cardinality, zero iff regression.
+   */
+  void enableLocalImp(const class Forest* forest,
+		      unsigned int nCtg);
+
+
+  /**
+     @return local importance engine, iff enabled.
+   */
+  const LocalImp* getLocalImp() const {
+    return localImp.get();
+  }
+
+
+  /**
+     @brief Directs prediction to tally the unpermuted rows reaching
+     each node.
+
+     @param leaf supplies the training cover for comparison.
+   */
+  void enableTraffic(const class Forest* forest,
+		     const struct Leaf* leaf);
+
+
+  /**
+     @return traffic counters, iff enabled.
+   */
+  const NodeTraffic* getTraffic() const {
+    return nodeTraffic.get();
+  }
+
+
+  /**
+     @return forest-wide leaf offsets by tree, plus sup, iff sinking.
+   */
+  const vector<size_t>& getLeafOrigin() const {
+    return leafOrigin;
+  }
+
+
   /**
      @param[out] termIdx is the node index of prediction.
 
@@ -298,7 +992,7 @@ public:
 			double& score) const {
     IndexT termIdx = predictLeaves[nTree * (row - blockStart) + tIdx];
     if (termIdx != noNode) {
-      score = scoreBlock[tIdx][termIdx];
+      score = forestDag ? forestDag->getScore(termIdx) : scoreLocal()[nodeOrigin[tIdx] + termIdx];
       return true;
     }
     else {
@@ -328,7 +1022,15 @@ public:
      @return base address for numeric values at row.
   */
   const double* baseNum(size_t row) const {
-    return &trNum[(row - blockStart) * nPredNum];
+    return &blockNum[(row - blockStart) * nPredNum];
+  }
+
+
+  /**
+     @brief As above, but numeric codes.
+   */
+  const BinCodeT* baseCode(size_t row) const {
+    return &trCode[(row - blockStart) * nPredNum];
   }
 
 
@@ -338,43 +1040,63 @@ public:
      @return row is the row number.
    */
   const CtgT* baseFac(size_t row) const {
-    return &trFac[(row - blockStart) * nPredFac];
+    return &blockFac[(row - blockStart) * nPredFac];
   }
 
   
   /**
-     @brief Prediction of single row with mixed predictor types.
+     @brief Prediction of a single row, specialized as walkTyped().
+
+     @param rowNT is the base of the row's numeric values, if any.
+
+     @param rowFT is the base of the row's factor values, if any.
 
      @param row is the absolute row of data over which a prediction is made.
 
-     @param blockRow is the row's block-relative row index.
+     @param nodeBase is the base of the walking thread's node arena.
 
-     @return index of leaf predicted.
+     @param bitBase is the base of the walking thread's factor bits.
   */
-  void rowMixed(unsigned int tIdx,
+  template<bool hasNum, bool hasFac>
+  void rowTyped(unsigned int tIdx,
 		const double* rowNT,
 		const CtgT* rowFT,
-		size_t row);
+		size_t row,
+		const DecNode* nodeBase,
+		const BVSlotT* bitBase);
+
 
-  
   /**
-     @brief Prediction over a single row with factor-valued predictors only.
+     @return tree-relative node at which a numeric walk begins.
+   */
+  inline IndexT entryNode(unsigned int tIdx,
+			  const double* rowNT) const {
+    return forestTop ? forestTop->descend(tIdx, rowNT) : 0;
+  }
 
-     Parameters as in mixed case, above.
-  */
-  void rowFac(unsigned int tIdx,
-	      const CtgT* rowT,
-	      size_t row);
+
+  /**
+     @return base of the node arena local to the calling thread.
+   */
+  const DecNode* nodeLocal() const {
+    return forestReplica ? forestReplica->getNode() : decNode.data();
+  }
 
 
   /**
-     @brief Prediction of a single row with numeric-valued predictors only.
+     @return base of the scores local to the calling thread.
+   */
+  const double* scoreLocal() const {
+    return forestReplica ? forestReplica->getScore() : scoreBlock.data();
+  }
+
 
-     Parameters as in mixed case, above.
+  /**
+     @return base of the factor bits local to the calling thread.
    */
-  void rowNum(unsigned int tIdx,
-		const double* rowT,
-		size_t row);
+  const BVSlotT* bitsLocal() const {
+    return forestReplica ? forestReplica->getBits() : bitPool;
+  }
 };
 
 
@@ -393,25 +1115,49 @@ class PredictReg : public Predict {
   vector<double> ssePermute;
 
   unique_ptr<class Quant> quant;  // Quantile workplace, as needed.
+  unique_ptr<JackVar> jackVar; // Non-null iff estimating variance.
+  unique_ptr<MultiReg> multiReg; // Non-null iff estimating several responses.
 
-  vector<double>* yTarg; // Target of current prediction.
+  double* yOut; // Destination of predictions:  yPred unless bound.
+  double* yTarg; // Target of current prediction.
   double* saeTarg;
   double* sseTarg;
-  
+  const vector<unsigned int> sweep; // Tree-count checkpoints, iff sweeping.
+  vector<double> sweepPred; // Per-thread prefix predictions.
+  vector<double> sweepSAE; // Per-thread absolute error, by checkpoint.
+  vector<double> sweepSSE; // Per-thread squared error, by checkpoint.
+
   void testRow(size_t row);
 
 
+  /**
+     @brief Accumulates error of the row's prediction over each prefix.
+   */
+  void sweepRow(size_t row);
+
+
   unsigned int scoreRow(size_t row);
 
 public:
   PredictReg(const class Forest* forest_,
 	     const class Sampler* sampler_,
 	     const struct Leaf* leaf_,
-	     struct RLEFrame* rleFrame_,
+	     size_t nRow_,
+	     PredictorT nPredNum_,
+	     PredictorT nPredFac_,
 	     const vector<double>& yTest_,
 	     PredictorT nPredict_,
 	     const vector<double>& quantile,
-	     bool trapUnobserved_);
+	     unsigned int quantSketch,
+	     bool quantExact,
+	     bool trapUnobserved_,
+	     bool quickScore,
+	     bool binCode,
+	     bool compact,
+	     bool reuseRuns,
+	     CompiledWalk compiledWalk_,
+	     unsigned int nReplica,
+	     const vector<unsigned int>& treeSweep);
 
 
   /**
@@ -421,6 +1167,9 @@ public:
 		size_t rowEnd);
 
 
+  bool scoresOnly() const;
+
+
   void estAccum();
 
 
@@ -446,6 +1195,23 @@ public:
   const vector<double>& getSAEPermuted() const {
     return saePermute;
   }
+
+
+  const vector<unsigned int>& getSweep() const {
+    return sweep;
+  }
+
+
+  /**
+     @return squared error summed over rows, by checkpoint.
+   */
+  vector<double> getSweepSSE() const;
+
+
+  /**
+     @return absolute error summed over rows, by checkpoint.
+   */
+  vector<double> getSweepSAE() const;
   
 
   const vector<double>& getYTest() const {
@@ -453,26 +1219,85 @@ public:
   }
   
   
+  /**
+     @return per-row predictions, empty if bound.
+   */
   const vector<double>& getYPred() const {
     return yPred;
   }
 
 
   inline double getYPred(size_t row) const {
-    return yPred[row];
+    return yOut[row];
   }
+
+
+  /**
+     @brief Directs predictions to caller storage, releasing the core's.
+
+     @param yPred_ has one slot per row.
+   */
+  void bindYPred(double yPred_[]);
+
+
+  /**
+     @brief Directs quantiles and their estimates to caller storage.
+   */
+  void bindQuant(const PredictOut& qOut,
+		 const PredictOut& qEstOut);
+
+
+  /**
+     @return count of quantiles predicted per row, zero if none.
+   */
+  unsigned int getNQuant() const;
   
 
  /**
-     @return vector of estimated quantile means.
+     @return vector of estimated quantile means, empty if bound.
    */
-  const vector<double> getQEst() const;
+  const vector<double>& getQEst() const;
 
 
   /**
-     @return vector quantile predictions.
+     @return vector quantile predictions, empty if bound.
   */
-  const vector<double> getQPred() const;
+  const vector<double>& getQPred() const;
+
+
+  /**
+     @brief Directs prediction to estimate the variance of unpermuted rows.
+   */
+  void enableJackVar();
+
+
+  /**
+     @return variance engine, iff enabled.
+   */
+  const JackVar* getJackVar() const {
+    return jackVar.get();
+  }
+
+
+  /**
+     @brief Directs prediction to estimate several responses of
+     unpermuted rows from the leaves reached.
+
+     @param yTrain holds each training response in turn.
+
+     @param nOut is the number of responses.
+   */
+  void enableMulti(const struct Leaf* leaf,
+		   const vector<double>& yTrain,
+		   unsigned int nOut);
+
+
+  /**
+     @return multiple-response engine, iff enabled.
+   */
+  const MultiReg* getMultiReg() const {
+    return multiReg.get();
+  }
 };
 
 
@@ -485,35 +1310,93 @@ class PredictCtg : public Predict {
   unique_ptr<CtgProb> ctgProb; // Class prediction probabilities.
 
   vector<PredictorT> yPermute; // Reused.
-  vector<PredictorT> census;
+  const bool doCensus; // Whether to retain the full census.
+  const bool censusNarrow; // Whether retained counts fit in 16 bits.
+  vector<uint16_t> census16; // Row x category votes, iff retained narrow.
+  vector<PredictorT> census32; // Row x category votes, iff retained wide.
+  PredictOut censusOut; // Caller destination of votes, iff bound.
+  vector<vector<PredictorT>> censusRow; // Per-thread row census.
+  const PredictorT topK; // # leading categories reported per row.
+  vector<PredictorT> topCtg; // Row x rank leading categories, iff reported.
+  vector<double> topWeight; // Row x rank vote fraction or probability, " ".
+  vector<vector<PredictorT>> topScratch; // Per-thread category order.
   vector<size_t> confusion; // Confusion matrix; saved.
   vector<double> misprediction; // Mispredction, by merged category; saved.
   double oobPredict; // Out-of-bag error:  % mispredicted rows.
-  vector<PredictorT> censusPermute; // Workspace census for permutations.
   vector<size_t> confusionPermute; // Workspace for permutation.
   vector<vector<double>> mispredPermute; // Saved values for permutation.
   vector<double> oobPermute;
+  const vector<unsigned int> sweep; // Tree-count checkpoints, iff sweeping.
+  const bool earlyExit; // Whether to stop walking once decided.
+  const double exitTolerance; // Fraction of remaining votes discounted.
+  vector<unsigned int> nTreeUsed; // Trees walked per row, iff early exit.
+  vector<unsigned int> sweepCensus; // Per-thread sweep census.
+  vector<vector<double>> sweepJitter; // Per-thread sweep jitter.
+  vector<PredictorT> sweepPred; // Per-thread prefix predictions.
+  vector<size_t> sweepMiss; // Per-thread mispredictions, by checkpoint.
   vector<PredictorT>* yTarg; // Target of current prediction.
   vector<size_t>* confusionTarg;
-  vector<PredictorT>* censusTarg; // Destination of prediction census.
   vector<double>* mispredTarg;
   double *oobTarg;
 
   void testRow(size_t row);
 
 
+  /**
+     @brief Accumulates mispredictions of the row over each prefix.
+   */
+  void sweepRow(size_t row);
+
+
   void scoreRow(size_t row);
 
+
+  /**
+     @brief Records the leading categories of a row.
+
+     @param ctgRow is the row's census.
+   */
+  void setTop(size_t row,
+	      const PredictorT* ctgRow);
+
+
+  /**
+     @brief Walks a row in blocks of trees, stopping once the leading
+     category cannot be overtaken.
+
+     The leader's margin over the runner-up is compared against the
+     count of trees remaining, discounted by 'exitTolerance'.
+
+     @param[in, out] votes is a zeroed workspace of 'nCtgTrain' slots.
+   */
+  void walkEarly(size_t row,
+		 vector<IndexT>& votes);
+
   
 public:
 
   PredictCtg(const class Forest* forest_,
 	     const class Sampler* sampler_,
-	     struct RLEFrame* rleFrame_,
+	     const struct Leaf* leaf_,
+	     size_t nRow_,
+	     PredictorT nPredNum_,
+	     PredictorT nPredFac_,
 	     const vector<PredictorT>& yTest_,
 	     PredictorT nPredict_,
 	     bool doProb,
-	     bool trapUnobserved_);
+	     bool probSample,
+	     bool doCensus_,
+	     PredictorT topK_,
+	     bool trapUnobserved_,
+	     bool quickScore,
+	     bool binCode,
+	     bool compact,
+	     bool reuseRuns,
+	     CompiledWalk compiledWalk_,
+	     unsigned int nReplica,
+	     bool earlyExit_,
+	     double exitTolerance_,
+	     const vector<unsigned int>& treeSweep);
 
 
   /**
@@ -523,6 +1406,22 @@ public:
 		size_t rowEnd);
 
 
+  bool scoresOnly() const;
+
+
+  /**
+     @brief Early exit walks row by row, so precludes walking by tree.
+   */
+  bool walkByTree(size_t span) const;
+
+
+  /**
+     @brief Early exit walks tree subsets, so retains the typed walker.
+   */
+  void enableAuto(const class Forest* forest,
+		  bool calibrate);
+
+
   /**
      @brief Derives an index into a matrix having stride equal to the
      number of training categories.
@@ -580,10 +1479,45 @@ public:
 
   
   /**
-     @brief Getter for census.
+     @return row x category census, widened, iff retained and unbound.
+   */
+  vector<PredictorT> getCensus() const {
+    return censusNarrow ? vector<PredictorT>(census16.begin(), census16.end()) : census32;
+  }
+
+
+  /**
+     @brief Directs the census to caller storage, if retained.
+   */
+  void bindCensus(const PredictOut& censusOut_);
+
+
+  /**
+     @brief Directs probabilities to caller storage, if computed.
+   */
+  void bindProb(const PredictOut& probOut) {
+    ctgProb->bind(probOut);
+  }
+
+
+  PredictorT getTopK() const {
+    return topK;
+  }
+
+
+  /**
+     @return row x rank leading categories, iff reported.
    */
-  const PredictorT* getCensus() const {
-    return &census[0];
+  const vector<PredictorT>& getTopCtg() const {
+    return topCtg;
+  }
+
+
+  /**
+     @return row x rank leading weights, iff reported.
+   */
+  const vector<double>& getTopWeight() const {
+    return topWeight;
   }
 
   /**
@@ -594,6 +1528,22 @@ public:
   }
 
 
+  const vector<unsigned int>& getNTreeUsed() const {
+    return nTreeUsed;
+  }
+
+
+  const vector<unsigned int>& getSweep() const {
+    return sweep;
+  }
+
+
+  /**
+     @return misprediction rate over rows, by checkpoint.
+   */
+  vector<double> getSweepMispred() const;
+
+
   /**
      @brief Dumps and categorical-specific contents.
    */
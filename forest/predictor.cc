@@ -0,0 +1,152 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictor.cc
+
+   @brief Methods for low-latency prediction sessions.
+
+   @author Mark Seligman
+ */
+
+#include "predictor.h"
+#include "forest.h"
+#include "sampler.h"
+#include "response.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+
+const size_t Predictor::inlineRows = 0x40;
+
+
+Predictor::Predictor(const Forest* forest,
+		     PredictorT nPredNum_,
+		     PredictorT nPredFac_) :
+  decNode(forest->getNode()),
+  nodeOrigin(forest->getNodeOrigin()),
+  bitPool(forest->getBitPool()),
+  bitOrigin(forest->getBitOrigin()),
+  scoreBlock(forest->getTreeScores()),
+  nPredNum(nPredNum_),
+  nPredFac(nPredFac_),
+  nTree(forest->getNTree()) {
+}
+
+
+PredictorReg::PredictorReg(const Forest* forest,
+			   PredictorT nPredNum_,
+			   PredictorT nPredFac_) :
+  Predictor(forest, nPredNum_, nPredFac_) {
+}
+
+
+PredictorCtg::PredictorCtg(const Forest* forest,
+			   const Sampler* sampler,
+			   PredictorT nPredNum_,
+			   PredictorT nPredFac_) :
+  Predictor(forest, nPredNum_, nPredFac_),
+  response(reinterpret_cast<const ResponseCtg*>(sampler->getResponse())),
+  nCtg(response->getNCtg()) {
+}
+
+
+PredictContext::PredictContext(const Predictor* predictor,
+			       unsigned int nThread_) :
+  nThread(max(1u, nThread_)),
+  census(vector<unsigned int>(nThread * predictor->getNCtg())),
+  ctgJitter(vector<vector<double>>(predictor->getNCtg() == 0 ? 0 : nThread, vector<double>(predictor->getNCtg()))) {
+}
+
+
+IndexT Predictor::walkTree(unsigned int tIdx,
+			   const double* rowNum,
+			   const CtgT* rowFac) const {
+  const DecNode* cTree = &decNode[nodeOrigin[tIdx]];
+  IndexT idx = 0;
+  while (!cTree[idx].isTerminal()) {
+    const DecNode& node = cTree[idx];
+    PredictorT predIdx = node.getPredIdx();
+    if (predIdx < nPredNum) {
+      idx += node.advanceNum(rowNum[predIdx]);
+    }
+    else {
+      idx += node.advanceFactor(bitPool + bitOrigin[tIdx], rowFac[predIdx - nPredNum]);
+    }
+  }
+  return idx;
+}
+
+
+void PredictorReg::predictRows(PredictContext& context,
+			       const double num[],
+			       const CtgT fac[],
+			       size_t nRow,
+			       double yPred[]) const {
+  if (nRow < inlineRows || context.nThread == 1) {
+    for (size_t row = 0; row < nRow; row++) {
+      yPred[row] = predictRow(rowNum(num, row), rowFac(fac, row));
+    }
+    return;
+  }
+
+  OMPBound rowEnd = static_cast<OMPBound>(nRow);
+#pragma omp parallel for default(shared) schedule(static) num_threads(context.nThread)
+  for (OMPBound row = 0; row < rowEnd; row++) {
+    yPred[row] = predictRow(rowNum(num, row), rowFac(fac, row));
+  }
+}
+
+
+double PredictorReg::predictRow(const double* rowNT,
+				const CtgT* rowFT) const {
+  double sumScore = 0.0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    sumScore += treeScore(tIdx, rowNT, rowFT);
+  }
+  return sumScore / nTree;
+}
+
+
+void PredictorCtg::predictRows(PredictContext& context,
+			       const double num[],
+			       const CtgT fac[],
+			       size_t nRow,
+			       PredictorT yPred[]) const {
+  if (nRow < inlineRows || context.nThread == 1) {
+    for (size_t row = 0; row < nRow; row++) {
+      yPred[row] = predictRow(context, rowNum(num, row), rowFac(fac, row), 0);
+    }
+    return;
+  }
+
+  OMPBound rowEnd = static_cast<OMPBound>(nRow);
+#pragma omp parallel for default(shared) schedule(static) num_threads(context.nThread)
+  for (OMPBound row = 0; row < rowEnd; row++) {
+    yPred[row] = predictRow(context, rowNum(num, row), rowFac(fac, row), OmpThread::threadIdx());
+  }
+}
+
+
+PredictorT PredictorCtg::predictRow(PredictContext& context,
+				    const double* rowNT,
+				    const CtgT* rowFT,
+				    unsigned int thrIdx) const {
+  unsigned int* censusRow = &context.census[thrIdx * nCtg];
+  vector<double>& jitterRow = context.ctgJitter[thrIdx];
+  fill(censusRow, censusRow + nCtg, 0);
+  fill(jitterRow.begin(), jitterRow.end(), 0.0);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    double score = treeScore(tIdx, rowNT, rowFT);
+    PredictorT ctg = floor(score); // Truncates jittered score for indexing.
+    censusRow[ctg]++;
+    jitterRow[ctg] += score - ctg;
+  }
+
+  return response->argMaxJitter(censusRow, jitterRow);
+}
@@ -0,0 +1,200 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictor.h
+
+   @brief Reusable low-latency prediction sessions.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PREDICTOR_H
+#define FOREST_PREDICTOR_H
+
+#include "typeparam.h"
+#include "bv.h"
+#include "decnode.h"
+#include "arena.h"
+
+#include <vector>
+#include <memory>
+
+
+/**
+   @brief Per-caller scratch and parallelism for a shared Predictor.
+
+   Contexts are cheap and are never shared:  each request thread holds
+   its own, so that the Predictor itself remains immutable.
+ */
+struct PredictContext {
+  const unsigned int nThread; // Team size for the caller's batches.
+  vector<unsigned int> census; // Per-thread vote scratch, iff classifying.
+  vector<vector<double>> ctgJitter; // Per-thread jitter scratch, " ".
+
+  /**
+     @param nThread_ is the team size; one scores on the calling thread.
+   */
+  PredictContext(const class Predictor* predictor,
+		 unsigned int nThread_);
+};
+
+
+/**
+   @brief Scores small batches of dense rows against a fixed forest.
+
+   Built once per trained forest, a session walks caller-supplied rows in
+   place, without ranking, transposition or per-call allocation.  Rows
+   are numeric-first and row-major, with zero-based factor codes, as in
+   DenseFrame.  Batches below 'inlineRows' are scored on the calling
+   thread.  Bagging is not consulted:  every tree is walked.  Sessions
+   hold no mutable state, so a single session may serve any number of
+   concurrent callers, each supplying its own PredictContext.
+ */
+class Predictor {
+protected:
+  static const size_t inlineRows; // Batches below this size score inline.
+
+  const Arena<DecNode>& decNode; // Forest-wide node arena, not copied.
+  const vector<size_t>& nodeOrigin; // Per-tree offsets into arena.
+  const BVSlotT* bitPool; // Forest-wide factor bits.
+  const vector<size_t>& bitOrigin; // Per-tree offsets into bit pool.
+  const Arena<double>& scoreBlock; // Scores, indexed as decNode.
+
+  /**
+     @brief Determines the terminal reached by a row in a tree.
+
+     @return tree-relative terminal index.
+   */
+  IndexT walkTree(unsigned int tIdx,
+		  const double* rowNum,
+		  const CtgT* rowFac) const;
+
+
+  /**
+     @return score of the leaf reached by a row in a tree.
+   */
+  inline double treeScore(unsigned int tIdx,
+			  const double* rowNum,
+			  const CtgT* rowFac) const {
+    return scoreBlock[nodeOrigin[tIdx] + walkTree(tIdx, rowNum, rowFac)];
+  }
+
+public:
+  const PredictorT nPredNum;
+  const PredictorT nPredFac;
+  const unsigned int nTree;
+
+  Predictor(const class Forest* forest,
+	    PredictorT nPredNum_,
+	    PredictorT nPredFac_);
+
+  virtual ~Predictor() = default;
+
+
+  /**
+     @return training cardinality, if classification, else zero.
+   */
+  virtual PredictorT getNCtg() const {
+    return 0;
+  }
+
+
+  /**
+     @return base of the numeric values of a row, if any.
+   */
+  const double* rowNum(const double num[],
+		       size_t row) const {
+    return nPredNum == 0 ? nullptr : num + row * nPredNum;
+  }
+
+
+  /**
+     @return base of the factor values of a row, if any.
+   */
+  const CtgT* rowFac(const CtgT fac[],
+		     size_t row) const {
+    return nPredFac == 0 ? nullptr : fac + row * nPredFac;
+  }
+};
+
+
+class PredictorReg : public Predictor {
+
+  /**
+     @return mean score of a single row.
+   */
+  double predictRow(const double* rowNum,
+		    const CtgT* rowFac) const;
+
+public:
+  PredictorReg(const class Forest* forest,
+	       PredictorT nPredNum_,
+	       PredictorT nPredFac_);
+
+
+  /**
+     @brief Predicts a batch of rows.
+
+     @param context is the caller's scratch.
+
+     @param num is the row-major numeric block, possibly null.
+
+     @param fac is the row-major factor block, possibly null.
+
+     @param nRow is the number of rows in the batch.
+
+     @param[out] yPred outputs the mean score, per row.
+   */
+  void predictRows(PredictContext& context,
+		   const double num[],
+		   const CtgT fac[],
+		   size_t nRow,
+		   double yPred[]) const;
+};
+
+
+class PredictorCtg : public Predictor {
+  const class ResponseCtg* response;
+  const PredictorT nCtg; // Training cardinality.
+
+  /**
+     @brief Predicts a single row using the calling thread's scratch.
+   */
+  PredictorT predictRow(PredictContext& context,
+			const double* rowNum,
+			const CtgT* rowFac,
+			unsigned int thrIdx) const;
+
+public:
+  /**
+     @param sampler supplies the training response.
+   */
+  PredictorCtg(const class Forest* forest,
+	       const class Sampler* sampler,
+	       PredictorT nPredNum_,
+	       PredictorT nPredFac_);
+
+
+  PredictorT getNCtg() const {
+    return nCtg;
+  }
+
+
+  /**
+     @brief Predicts a batch of rows, as above.
+
+     @param[out] yPred outputs the zero-based category, per row.
+   */
+  void predictRows(PredictContext& context,
+		   const double num[],
+		   const CtgT fac[],
+		   size_t nRow,
+		   PredictorT yPred[]) const;
+};
+
+#endif
@@ -0,0 +1,124 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictout.h
+
+   @brief Destinations for prediction results.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PREDICTOUT_H
+#define FOREST_PREDICTOUT_H
+
+#include <cstddef>
+
+using namespace std;
+
+
+/**
+   @brief Row x column destination of a prediction result.
+
+   Results default to core-owned, row-major vectors.  Front ends may
+   instead supply their own storage, such as R matrices, which are
+   column-major, or NumPy arrays.  Exactly one typed base is set, so
+   that values may be narrowed to single precision or held as counts.
+ */
+class PredictOut {
+  double* dBase; // Double-precision destination, if any.
+  float* fBase; // Single-precision destination, if any.
+  unsigned int* uBase; // Count destination, if any.
+  size_t rowStride; // Elements between successive rows.
+  size_t colStride; // Elements between successive columns.
+
+  PredictOut(double* dBase_,
+	     float* fBase_,
+	     unsigned int* uBase_,
+	     size_t nRow,
+	     size_t nCol,
+	     bool colMajor) :
+    dBase(dBase_),
+    fBase(fBase_),
+    uBase(uBase_),
+    rowStride(colMajor ? 1 : nCol),
+    colStride(colMajor ? nRow : 1) {
+  }
+
+public:
+
+  /**
+     @brief Unbound destination.
+   */
+  PredictOut() :
+    PredictOut(nullptr, nullptr, nullptr, 0, 0, false) {
+  }
+
+
+  /**
+     @param colMajor is true iff columns are contiguous.
+   */
+  PredictOut(double base[],
+	     size_t nRow,
+	     size_t nCol,
+	     bool colMajor = false) :
+    PredictOut(base, nullptr, nullptr, nRow, nCol, colMajor) {
+  }
+
+
+  PredictOut(float base[],
+	     size_t nRow,
+	     size_t nCol,
+	     bool colMajor = false) :
+    PredictOut(nullptr, base, nullptr, nRow, nCol, colMajor) {
+  }
+
+
+  PredictOut(unsigned int base[],
+	     size_t nRow,
+	     size_t nCol,
+	     bool colMajor = false) :
+    PredictOut(nullptr, nullptr, base, nRow, nCol, colMajor) {
+  }
+
+
+  /**
+     @return true iff a destination has been supplied.
+   */
+  bool isBound() const {
+    return dBase != nullptr || fBase != nullptr || uBase != nullptr;
+  }
+
+
+  /**
+     @brief Stores a value, narrowing to the destination type.
+   */
+  template<typename valType>
+  void set(size_t row,
+	   size_t col,
+	   valType val) const {
+    size_t idx = row * rowStride + col * colStride;
+    if (dBase != nullptr)
+      dBase[idx] = val;
+    else if (fBase != nullptr)
+      fBase[idx] = val;
+    else
+      uBase[idx] = val;
+  }
+
+
+  /**
+     @return stored value, widened to double.
+   */
+  double get(size_t row,
+	     size_t col) const {
+    size_t idx = row * rowStride + col * colStride;
+    return dBase != nullptr ? dBase[idx] : (fBase != nullptr ? fBase[idx] : uBase[idx]);
+  }
+};
+
+#endif
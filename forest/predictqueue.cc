@@ -0,0 +1,152 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictqueue.cc
+
+   @brief Methods coalescing queued prediction requests.
+
+   @author Mark Seligman
+ */
+
+#include "predictqueue.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+template<typename PredictorType, typename OutT>
+PredictQueue<PredictorType, OutT>::PredictQueue(const PredictorType* predictor_,
+						size_t batchRows_,
+						unsigned int nThread) :
+  predictor(predictor_),
+  batchRows(max<size_t>(1, batchRows_)),
+  context(PredictContext(predictor, nThread)),
+  halting(false),
+  nBatch(0),
+  nRequest(0) {
+  dispatcher = thread(&PredictQueue::dispatch, this);
+}
+
+
+template<typename PredictorType, typename OutT>
+PredictQueue<PredictorType, OutT>::~PredictQueue() {
+  {
+    lock_guard<mutex> guard(queueLock);
+    halting = true;
+  }
+  pending.notify_one();
+  dispatcher.join();
+}
+
+
+template<typename PredictorType, typename OutT>
+future<void> PredictQueue<PredictorType, OutT>::submit(const double num[],
+						       const CtgT fac[],
+						       size_t nRow,
+						       OutT yPred[],
+						       Callback callback) {
+  Request request{num, fac, nRow, yPred, move(callback), promise<void>()};
+  future<void> completion = request.done.get_future();
+  {
+    lock_guard<mutex> guard(queueLock);
+    if (halting)
+      throw logic_error("Submission to a halting prediction queue");
+    queue.emplace_back(move(request));
+  }
+  pending.notify_one();
+  return completion;
+}
+
+
+template<typename PredictorType, typename OutT>
+double PredictQueue<PredictorType, OutT>::getCoalescing() {
+  lock_guard<mutex> guard(queueLock);
+  return nBatch == 0 ? 0.0 : double(nRequest) / nBatch;
+}
+
+
+template<typename PredictorType, typename OutT>
+void PredictQueue<PredictorType, OutT>::dispatch() {
+  vector<Request> batch;
+  while (true) {
+    {
+      unique_lock<mutex> guard(queueLock);
+      pending.wait(guard, [this] { return halting || !queue.empty(); });
+      if (queue.empty()) // Halting with nothing outstanding.
+	return;
+
+      // Admits at least one request, then fills to the row target.
+      size_t nRowBatch = 0;
+      do {
+	nRowBatch += queue.front().nRow;
+	batch.emplace_back(move(queue.front()));
+	queue.pop_front();
+      } while (!queue.empty() && nRowBatch + queue.front().nRow <= batchRows);
+    }
+    serve(batch);
+    batch.clear();
+  }
+}
+
+
+template<typename PredictorType, typename OutT>
+void PredictQueue<PredictorType, OutT>::serve(vector<Request>& batch) {
+  try {
+    if (batch.size() == 1) { // Scores in place.
+      Request& request = batch.front();
+      predictor->predictRows(context, request.num, request.fac, request.nRow, request.yPred);
+    }
+    else {
+      size_t nRowBatch = 0;
+      for (const Request& request : batch) {
+	nRowBatch += request.nRow;
+      }
+      numBatch.resize(nRowBatch * predictor->nPredNum);
+      facBatch.resize(nRowBatch * predictor->nPredFac);
+      yBatch.resize(nRowBatch);
+      size_t rowStart = 0;
+      for (const Request& request : batch) {
+	if (predictor->nPredNum > 0)
+	  copy(request.num, request.num + request.nRow * predictor->nPredNum, numBatch.begin() + rowStart * predictor->nPredNum);
+	if (predictor->nPredFac > 0)
+	  copy(request.fac, request.fac + request.nRow * predictor->nPredFac, facBatch.begin() + rowStart * predictor->nPredFac);
+	rowStart += request.nRow;
+      }
+      predictor->predictRows(context, numBatch.data(), facBatch.data(), nRowBatch, yBatch.data());
+      rowStart = 0;
+      for (Request& request : batch) {
+	copy(yBatch.begin() + rowStart, yBatch.begin() + rowStart + request.nRow, request.yPred);
+	rowStart += request.nRow;
+      }
+    }
+  }
+  catch (...) {
+    for (Request& request : batch) {
+      request.done.set_exception(current_exception());
+    }
+    return;
+  }
+
+  for (Request& request : batch) {
+    try {
+      if (request.callback)
+	request.callback(request.yPred, request.nRow);
+      request.done.set_value();
+    }
+    catch (...) { // Callback failure is reported to its submitter alone.
+      request.done.set_exception(current_exception());
+    }
+  }
+  lock_guard<mutex> guard(queueLock);
+  nBatch++;
+  nRequest += batch.size();
+}
+
+
+template class PredictQueue<PredictorReg, double>;
+template class PredictQueue<PredictorCtg, PredictorT>;
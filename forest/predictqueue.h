@@ -0,0 +1,136 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictqueue.h
+
+   @brief Non-blocking submission of small requests to a prediction session.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PREDICTQUEUE_H
+#define FOREST_PREDICTQUEUE_H
+
+#include "typeparam.h"
+#include "predictor.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+   @brief Coalesces concurrent requests against a single session.
+
+   Submitters enqueue rows together with an output buffer and return
+   immediately.  A dispatcher thread drains the queue in micro-batches
+   of up to 'batchRows' rows, gathering the requests' rows into a single
+   block, so that many tiny requests are scored with the efficiency of
+   one larger batch.  Requests arriving while a batch is scored join the
+   next, so coalescing grows with load and adds no latency when idle.
+
+   Row and output buffers remain owned by the submitter and must
+   remain live until the request completes.  Completion is signalled
+   both by the returned future and by the optional callback, the latter
+   executing on the dispatcher thread.
+
+   @tparam PredictorType is the session type.
+
+   @tparam OutT is the per-row output type of the session.
+ */
+template<typename PredictorType, typename OutT>
+class PredictQueue {
+public:
+  /**
+     @brief Receives a request's outputs once written.
+   */
+  typedef function<void(const OutT[], size_t)> Callback;
+
+private:
+  struct Request {
+    const double* num; // Row-major numeric block, possibly null.
+    const CtgT* fac; // Row-major factor block, possibly null.
+    size_t nRow;
+    OutT* yPred; // Caller's output buffer.
+    Callback callback; // Possibly empty.
+    promise<void> done;
+  };
+
+  const PredictorType* predictor;
+  const size_t batchRows; // Row target for coalescing.
+  PredictContext context; // Dispatcher-private scratch.
+  mutex queueLock;
+  condition_variable pending;
+  deque<Request> queue;
+  bool halting; // Set by the destructor; guarded by 'queueLock'.
+  size_t nBatch; // # micro-batches scored.
+  size_t nRequest; // # requests completed.
+  vector<double> numBatch; // Gathered rows, reused across batches.
+  vector<CtgT> facBatch; // " "
+  vector<OutT> yBatch; // " "
+  thread dispatcher; // Started last.
+
+  /**
+     @brief Dispatcher main loop, draining the queue before exit.
+   */
+  void dispatch();
+
+
+  /**
+     @brief Scores a micro-batch and completes its requests.
+   */
+  void serve(vector<Request>& batch);
+
+public:
+  /**
+     @param predictor_ is the session, which must outlive the queue.
+
+     @param batchRows_ bounds the rows coalesced into a micro-batch.
+
+     @param nThread is the team size for scoring a micro-batch.
+   */
+  PredictQueue(const PredictorType* predictor_,
+	       size_t batchRows_,
+	       unsigned int nThread);
+
+
+  /**
+     @brief Completes outstanding requests, then joins the dispatcher.
+   */
+  ~PredictQueue();
+
+
+  /**
+     @brief Enqueues a request, returning immediately.
+
+     @param num, fac are dense row-major blocks, as for Predictor.
+
+     @param[out] yPred receives the per-row outputs.
+
+     @param callback is invoked on completion, if nonempty.
+
+     @return future made ready on completion, carrying any exception.
+   */
+  future<void> submit(const double num[],
+		      const CtgT fac[],
+		      size_t nRow,
+		      OutT yPred[],
+		      Callback callback = nullptr);
+
+
+  /**
+     @return mean # requests per micro-batch.
+   */
+  double getCoalescing();
+};
+
+#endif
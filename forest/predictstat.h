@@ -0,0 +1,107 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictstat.h
+
+   @brief Instrumentation of prediction.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PREDICTSTAT_H
+#define FOREST_PREDICTSTAT_H
+
+#include "loadstat.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+/**
+   @brief Timers and counters gathered over a prediction session.
+
+   Timers are wall-clock seconds.  Block-level phases are read by the
+   driving thread; row-level phases are summed over the walking
+   threads, and so may exceed elapsed time.  Scoring subsumes quantile
+   and probability estimation.
+ */
+struct PredictStat {
+  typedef chrono::steady_clock::time_point Stamp;
+
+  size_t nBlock; // # blocks predicted.
+  size_t nRow; // # rows predicted, over blocks.
+
+  double tTranspose; // Block transposition.
+  double tBlock; // predictBlock(), in full.
+  double tWalk; // Forest walking, summed over threads.
+  double tScore; // Row scoring, " ".
+  double tEstimate; // Quant or CtgProb row estimation, " ".
+
+  size_t nVisit; // # (row, tree) pairs reaching a node.
+  size_t depthSum; // Depth of node reached, summed over visits.
+  size_t nBail; // # visits trapped at a nonterminal.
+
+  vector<size_t> depthTree; // Depth summed by tree.
+  vector<size_t> visitTree; // # visits by tree.
+
+  LoadStat load; // Thread utilization of block scoring.
+
+  string engineShort; // Walker for short blocks, iff selected automatically.
+  string engineFull; // Walker for full blocks, " ".
+
+  PredictStat(unsigned int nTree = 0) :
+    nBlock(0),
+    nRow(0),
+    tTranspose(0.0),
+    tBlock(0.0),
+    tWalk(0.0),
+    tScore(0.0),
+    tEstimate(0.0),
+    nVisit(0),
+    depthSum(0),
+    nBail(0),
+    depthTree(vector<size_t>(nTree)),
+    visitTree(vector<size_t>(nTree)) {
+  }
+
+
+  static Stamp now() {
+    return chrono::steady_clock::now();
+  }
+
+
+  /**
+     @return seconds elapsed since a stamp.
+   */
+  static double since(const Stamp& start) {
+    return chrono::duration<double>(now() - start).count();
+  }
+
+
+  /**
+     @brief Folds in the row-level timers of a walking thread.
+   */
+  void accum(const PredictStat& other) {
+    tWalk += other.tWalk;
+    tScore += other.tScore;
+    tEstimate += other.tEstimate;
+  }
+
+
+  /**
+     @return mean depth reached by a tree, else zero if never visited.
+   */
+  double meanDepth(unsigned int tIdx) const {
+    return visitTree[tIdx] == 0 ? 0.0 : double(depthTree[tIdx]) / visitTree[tIdx];
+  }
+};
+
+#endif
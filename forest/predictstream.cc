@@ -0,0 +1,129 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictstream.cc
+
+   @brief Methods for streaming prediction over row chunks.
+
+   @author Mark Seligman
+ */
+
+#include "predictstream.h"
+#include "ompthread.h"
+
+#include <cmath>
+#include <stdexcept>
+
+
+LeafCollect::LeafCollect() :
+  rowPtr(vector<size_t>(1)) {
+}
+
+
+void LeafCollect::emit(size_t, // Blocks arrive in row order.
+		       size_t nRow,
+		       const size_t rowPtr_[],
+		       const size_t leafCol_[]) {
+  size_t colBase = rowPtr.back();
+  for (size_t rowIdx = 1; rowIdx <= nRow; rowIdx++) {
+    rowPtr.push_back(colBase + rowPtr_[rowIdx]);
+  }
+  leafCol.insert(leafCol.end(), leafCol_, leafCol_ + rowPtr_[nRow]);
+}
+
+
+StreamReg::StreamReg(const PredictorReg* predictor_,
+		     StreamSinkReg* sink_) :
+  predictor(predictor_),
+  sink(sink_),
+  context(PredictContext(predictor, OmpThread::nThread)),
+  nRow(0),
+  nTested(0),
+  saePredict(0.0),
+  ssePredict(0.0) {
+}
+
+
+void StreamReg::push(const double num[],
+		     const CtgT fac[],
+		     size_t nChunk,
+		     const double yTest[]) {
+  if (yChunk.size() < nChunk) {
+    yChunk.resize(nChunk);
+  }
+  predictor->predictRows(context, num, fac, nChunk, &yChunk[0]);
+  if (yTest != nullptr) {
+    for (size_t row = 0; row < nChunk; row++) {
+      double testError = fabs(yTest[row] - yChunk[row]);
+      saePredict += testError;
+      ssePredict += testError * testError;
+    }
+    nTested += nChunk;
+  }
+  sink->emit(nRow, &yChunk[0], nChunk);
+  nRow += nChunk;
+}
+
+
+StreamCtg::StreamCtg(const PredictorCtg* predictor_,
+		     StreamSinkCtg* sink_,
+		     PredictorT nCtgTest_) :
+  predictor(predictor_),
+  sink(sink_),
+  context(PredictContext(predictor, OmpThread::nThread)),
+  nCtgTrain(predictor->getNCtg()),
+  nCtgTest(nCtgTest_),
+  confusion(vector<size_t>(nCtgTest * nCtgTrain)),
+  nRow(0) {
+}
+
+
+void StreamCtg::push(const double num[],
+		     const CtgT fac[],
+		     size_t nChunk,
+		     const PredictorT yTest[]) {
+  if (yChunk.size() < nChunk) {
+    yChunk.resize(nChunk);
+  }
+  if (yTest != nullptr) {
+    if (nCtgTest == 0)
+      throw invalid_argument("Test categories supplied to a stream constructed without them");
+    for (size_t row = 0; row < nChunk; row++) {
+      if (yTest[row] >= nCtgTest)
+	throw invalid_argument("Test category exceeds test cardinality");
+    }
+  }
+  predictor->predictRows(context, num, fac, nChunk, &yChunk[0]);
+  if (yTest != nullptr) {
+    for (size_t row = 0; row < nChunk; row++) {
+      confusion[yTest[row] * nCtgTrain + yChunk[row]]++;
+    }
+  }
+  sink->emit(nRow, &yChunk[0], nChunk);
+  nRow += nChunk;
+}
+
+
+vector<double> StreamCtg::getMisprediction() const {
+  vector<double> misprediction(nCtgTest);
+  for (PredictorT ctgRec = 0; ctgRec < nCtgTest; ctgRec++) {
+    size_t numWrong = 0;
+    size_t numRight = 0;
+    for (PredictorT ctgPred = 0; ctgPred < nCtgTrain; ctgPred++) {
+      size_t numConf = confusion[ctgRec * nCtgTrain + ctgPred];
+      if (ctgPred != ctgRec) {  // Misprediction iff off-diagonal.
+        numWrong += numConf;
+      }
+      else {
+        numRight = numConf;
+      }
+    }
+    misprediction[ctgRec] = numWrong + numRight == 0 ? 0.0 : double(numWrong) / double(numWrong + numRight);
+  }
+  return misprediction;
+}
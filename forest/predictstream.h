@@ -0,0 +1,215 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file predictstream.h
+
+   @brief Bounded-memory prediction over successive row chunks.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PREDICTSTREAM_H
+#define FOREST_PREDICTSTREAM_H
+
+#include "typeparam.h"
+#include "predictor.h"
+
+#include <vector>
+
+
+/**
+   @brief Caller-supplied consumer of per-chunk regression predictions.
+ */
+struct StreamSinkReg {
+  virtual ~StreamSinkReg() = default;
+
+  /**
+     @param rowStart is the stream-relative position of the chunk.
+
+     @param yPred holds the chunk's predictions, valid for the call only.
+   */
+  virtual void emit(size_t rowStart,
+		    const double yPred[],
+		    size_t nRow) = 0;
+};
+
+
+/**
+   @brief As above, but zero-based categorical predictions.
+ */
+struct StreamSinkCtg {
+  virtual ~StreamSinkCtg() = default;
+
+  virtual void emit(size_t rowStart,
+		    const PredictorT yPred[],
+		    size_t nRow) = 0;
+};
+
+
+/**
+   @brief Caller-supplied consumer of per-block leaf assignments.
+
+   Assignments are emitted in compressed-row form, columns numbering
+   leaves forest-wide.  Trees not reaching a leaf, such as bagged trees
+   under out-of-bag prediction, contribute no entry.
+ */
+struct LeafSink {
+  virtual ~LeafSink() = default;
+
+  /**
+     @param rowStart is the absolute position of the block.
+
+     @param rowPtr holds 'nRow' + 1 offsets into 'leafCol', from zero.
+
+     @param leafCol holds forest-wide leaf indices, increasing by tree.
+     Both arrays are valid for the call only.
+   */
+  virtual void emit(size_t rowStart,
+		    size_t nRow,
+		    const size_t rowPtr[],
+		    const size_t leafCol[]) = 0;
+};
+
+
+/**
+   @brief Sink accumulating streamed leaf assignments in place.
+
+   Columns are narrowed to IndexT, halving the footprint of the
+   accumulated assignments.
+ */
+struct LeafCollect : public LeafSink {
+  vector<size_t> rowPtr; // Offsets into 'leafCol', from zero.
+  vector<IndexT> leafCol; // Forest-wide leaf indices.
+
+  LeafCollect();
+
+
+  void emit(size_t rowStart,
+	    size_t nRow,
+	    const size_t rowPtr_[],
+	    const size_t leafCol_[]);
+
+
+  /**
+     @return # rows collected.
+   */
+  size_t getNRow() const {
+    return rowPtr.size() - 1;
+  }
+};
+
+
+/**
+   @brief Drives a regression session over pushed chunks.
+
+   Memory is bounded by the largest chunk pushed.  Test error is
+   accumulated across chunks.
+ */
+class StreamReg {
+  const class PredictorReg* predictor;
+  StreamSinkReg* sink;
+  PredictContext context; // Stream-private scratch.
+  vector<double> yChunk; // Reused across chunks.
+  size_t nRow; // # rows streamed.
+  size_t nTested; // # rows streamed with test values.
+  double saePredict; // Accumulated absolute error.
+  double ssePredict; // Accumulated squared error.
+
+public:
+  StreamReg(const class PredictorReg* predictor_,
+	    StreamSinkReg* sink_);
+
+
+  /**
+     @brief Predicts a chunk and emits the result.
+
+     @param num, fac are dense row-major blocks, as for Predictor.
+
+     @param yTest is the chunk's test vector, possibly null.
+   */
+  void push(const double num[],
+	    const CtgT fac[],
+	    size_t nChunk,
+	    const double yTest[] = nullptr);
+
+
+  size_t getNRow() const {
+    return nRow;
+  }
+
+
+  double getSAE() const {
+    return saePredict;
+  }
+
+
+  double getSSE() const {
+    return ssePredict;
+  }
+
+
+  /**
+     @return mean squared error over tested rows.
+   */
+  double getMSE() const {
+    return nTested == 0 ? 0.0 : ssePredict / nTested;
+  }
+};
+
+
+/**
+   @brief As above, but classification, accumulating a confusion matrix.
+ */
+class StreamCtg {
+  const class PredictorCtg* predictor;
+  StreamSinkCtg* sink;
+  PredictContext context; // Stream-private scratch.
+  const PredictorT nCtgTrain; // Training cardinality.
+  const PredictorT nCtgTest; // Cardinality of test categories.
+  vector<PredictorT> yChunk; // Reused across chunks.
+  vector<size_t> confusion; // Test category major.
+  size_t nRow; // # rows streamed.
+
+public:
+  /**
+     @param nCtgTest is the cardinality of test values, if any, else zero.
+   */
+  StreamCtg(const class PredictorCtg* predictor_,
+	    StreamSinkCtg* sink_,
+	    PredictorT nCtgTest_);
+
+
+  /**
+     @brief Predicts a chunk and emits the result.
+
+     @param yTest holds zero-based test categories, possibly null.
+     Categories must lie below the test cardinality.
+   */
+  void push(const double num[],
+	    const CtgT fac[],
+	    size_t nChunk,
+	    const PredictorT yTest[] = nullptr);
+
+
+  size_t getNRow() const {
+    return nRow;
+  }
+
+
+  const vector<size_t>& getConfusion() const {
+    return confusion;
+  }
+
+
+  /**
+     @return misprediction rate, by test category.
+   */
+  vector<double> getMisprediction() const;
+};
+
+#endif
@@ -22,14 +22,18 @@
 #include "pretree.h"
 
 #include "prng.h"
+
+#include <algorithm>
+#include <cmath>
 #include <queue>
 #include <vector>
 
-IndexT PreTree::leafMax = 0;
-
-
 PreTree::PreTree(const PredictorFrame* frame,
-		 IndexT bagCount) :
+		 IndexT bagCount,
+		 IndexT leafMax_,
+		 double pruneCost_) :
+  leafMax(leafMax_),
+  pruneCost(pruneCost_),
   leafCount(0),
   infoLocal(vector<double>(frame->getNPred())),
   splitBits(BV(bagCount * frame->getFactorExtent())), // Vague estimate.
@@ -39,17 +43,6 @@ PreTree::PreTree(const PredictorFrame* frame,
 }
 
 
-void PreTree::init(IndexT leafMax_) {
-  leafMax = leafMax_;
-}
-
-
-
-void PreTree::deInit() {
-  leafMax = 0;
-}
-
-
 void PreTree::consumeCompound(const SplitFrontier* sf,
 			      const vector<vector<SplitNux>>& nuxMax) {
   // True branches target box exterior.
@@ -84,21 +77,42 @@ void PreTree::addCriterion(const SplitFrontier* sf,
 
   offspring(preallocated ? 0 : 1);
   DecNode& node = getNode(nux.getPTId());
-  node.setInvert(nux.invertTest());
+  // Numeric tests differ under inversion only at NaN, so the sense
+  // encodes the learned routing of missing values.
+  node.setInvert(sf->isFactor(nux) ? nux.invertTest() : sf->missingLeft(nux));
   node.setDelIdx(getHeight() - 2 - nux.getPTId());
   infoLocal[node.getPredIdx()] += nux.getInfo();
+  nodeInfo[nux.getPTId()] = nux.getInfo();
 }
 
 
 void PreTree::critBits(const SplitFrontier* sf,
 		       const SplitNux& nux) {
-  auto bitPos = bitEnd;
+  vector<IndexT> trueCodes = sf->getTrueCodes(nux);
+  vector<IndexT> observedCodes = sf->getObservedCodes(nux);
+
+  // Level lists occupy whole slots, so are preferred only when their
+  // footprint, alignment included, undercuts the dense encoding.
+  size_t listPos = BV::Stride(bitEnd);
+  size_t listEnd = listPos + BV::getSlotElts() * (1 + max(trueCodes.size(), observedCodes.size()));
+  bool sparse = listEnd - bitEnd < sf->critBitCount(nux);
+  auto bitPos = sparse ? listPos : bitEnd;
+  bitEnd = sparse ? listEnd : bitEnd + sf->critBitCount(nux);
   splitBits.resize(bitEnd);
   observedBits.resize(bitEnd);
-  bitEnd += sf->critBitCount(nux);
-  sf->setTrueBits(nux, &splitBits, bitPos);
-  sf->setObservedBits(nux, &observedBits, bitPos);
-  getNode(nux.getPTId()).critBits(nux, bitPos);
+  if (sparse) {
+    sort(trueCodes.begin(), trueCodes.end());
+    sort(observedCodes.begin(), observedCodes.end());
+    splitBits.setList(bitPos, trueCodes);
+    observedBits.setList(bitPos, observedCodes);
+  }
+  else {
+    for (IndexT code : trueCodes)
+      splitBits.setBit(bitPos + code);
+    for (IndexT code : observedCodes)
+      observedBits.setBit(bitPos + code);
+  }
+  getNode(nux.getPTId()).critBits(nux, bitPos, sparse);
 }
 
 
@@ -122,7 +136,75 @@ void PreTree::consume(Train* train,
   forest->consumeTree(nodeVec, scores);
   forest->consumeBits(splitBits, observedBits, bitEnd);
 
-  leaf->consumeTerminals(this, terminalMap);
+  TrainStat::Stamp start = TrainStat::now();
+  leaf->consumeTerminals(this, terminalMap, train->leafLoad());
+  train->consumeLeafTime(TrainStat::since(start));
+}
+
+
+void PreTree::rescore(double offset,
+		      double scale) {
+  for (double& score : scores) {
+    score = offset + scale * score;
+  }
+}
+
+
+double PreTree::scoreObs(const PredictorFrame* frame,
+			 IndexT row) const {
+  IndexT ptIdx = 0;
+  while (nodeVec[ptIdx].isNonterminal()) {
+    const DecNode& node = nodeVec[ptIdx];
+    PredictorT predIdx = node.getPredIdx();
+    IndexT rank = frame->getRanks(predIdx)[row];
+    if (frame->isFactor(predIdx))
+      ptIdx += node.advanceFactor(&splitBits, rank);
+    else
+      ptIdx += node.advanceNum(rank == frame->getMissingRank(predIdx) ? nan("") : rank);
+  }
+  return scores[ptIdx];
+}
+
+
+vector<IndexT> PreTree::graft(const PredictorFrame* frame,
+			      IndexT ptId,
+			      const PreTree* subtree) {
+  IndexT base = getHeight();
+  vector<IndexT> ptMap(subtree->getHeight());
+  ptMap[0] = ptId;
+  for (IndexT subIdx = 1; subIdx != ptMap.size(); subIdx++) {
+    ptMap[subIdx] = base + subIdx - 1;
+  }
+
+  size_t bitBase = BV::Stride(bitEnd);
+  if (subtree->bitEnd != 0) {
+    splitBits.insertSlots(subtree->splitBits, bitBase, subtree->bitEnd);
+    observedBits.insertSlots(subtree->observedBits, bitBase, subtree->bitEnd);
+    bitEnd = bitBase + subtree->bitEnd;
+  }
+
+  // The terminal's score is retained, as computed over the same samples.
+  nodeVec[ptId] = subtree->nodeVec[0];
+  nodeInfo[ptId] = subtree->nodeInfo[0];
+  nodeVec.insert(nodeVec.end(), subtree->nodeVec.begin() + 1, subtree->nodeVec.end());
+  scores.insert(scores.end(), subtree->scores.begin() + 1, subtree->scores.end());
+  nodeInfo.insert(nodeInfo.end(), subtree->nodeInfo.begin() + 1, subtree->nodeInfo.end());
+  for (IndexT subIdx = 0; subIdx != ptMap.size(); subIdx++) {
+    DecNode& node = nodeVec[ptMap[subIdx]];
+    if (node.isNonterminal()) {
+      if (subIdx == 0) // Only the root's successors are displaced.
+	node.setDelIdx(ptMap[node.getDelIdx()] - ptId);
+      if (frame->isFactor(node.getPredIdx()))
+	node.shiftBits(bitBase);
+    }
+  }
+
+  for (PredictorT predIdx = 0; predIdx != infoLocal.size(); predIdx++) {
+    infoLocal[predIdx] += subtree->infoLocal[predIdx];
+  }
+  leafCount += subtree->leafCount - 1;
+
+  return ptMap;
 }
 
 
@@ -130,18 +212,172 @@ void PreTree::setTerminals(SampleMap smTerminal) {
   terminalMap = move(smTerminal);
 
   (void) leafMerge();
+  prune();
   setLeafIndices();
+  hotLayout();
 }
 
 
 void PreTree::setLeafIndices() {
-  vector<IndexRange> dom = Forest::leafDominators(nodeVec);
+  vector<IndexRange> dom = Forest::leafDominators(&nodeVec[0], nodeVec.size());
   for (auto ptIdx : terminalMap.ptIdx) {
     nodeVec[ptIdx].setLeaf(dom[ptIdx].getStart());
   }
 }
 
 
+void PreTree::prune() {
+  if (pruneCost <= 0.0)
+    return;
+
+  // Successors follow their predecessor, so a reverse pass visits
+  // each subtree after its descendants.
+  IndexT height = getHeight();
+  vector<double> cost(height, pruneCost); // Least excess cost of subtree.
+  vector<bool> collapse(height);
+  for (IndexT ptId = height; ptId-- > 0; ) {
+    if (isNonterminal(ptId)) {
+      double costSplit = cost[getIdTrue(ptId)] + cost[getIdFalse(ptId)] - nodeInfo[ptId];
+      if (costSplit < pruneCost)
+	cost[ptId] = costSplit;
+      else
+	collapse[ptId] = true;
+    }
+  }
+
+  // Resolves each node to its retained self or collapsed ancestor.
+  vector<IndexT> target(height);
+  for (IndexT ptId = 0; ptId < height; ptId++) {
+    if (isNonterminal(ptId)) {
+      bool absorbs = collapse[ptId] || target[ptId] != ptId;
+      target[getIdTrue(ptId)] = absorbs ? target[ptId] : getIdTrue(ptId);
+      target[getIdFalse(ptId)] = absorbs ? target[ptId] : getIdFalse(ptId);
+      if (absorbs)
+	infoLocal[nodeVec[ptId].getPredIdx()] -= nodeInfo[ptId];
+    }
+  }
+
+  // Pools the samples of each collapsed subtree.
+  vector<IndexT> termSlot(height, height);
+  vector<IndexT> termExtent;
+  vector<IndexT> termPt;
+  IndexT rangeIdx = 0;
+  for (IndexRange range : terminalMap.range) {
+    IndexT ptTarg = target[terminalMap.ptIdx[rangeIdx++]];
+    if (termSlot[ptTarg] == height) {
+      termSlot[ptTarg] = termExtent.size();
+      termExtent.push_back(0);
+      termPt.push_back(ptTarg);
+    }
+    termExtent[termSlot[ptTarg]] += range.getExtent();
+  }
+
+  SampleMap smPruned(terminalMap.sampleIndex.size());
+  vector<IndexT> termFill;
+  for (IndexT slot = 0; slot < termPt.size(); slot++) {
+    termFill.push_back(smPruned.getEndIdx());
+    smPruned.addNode(termExtent[slot], termPt[slot]);
+  }
+  rangeIdx = 0;
+  for (IndexRange range : terminalMap.range) {
+    IndexT& dest = termFill[termSlot[target[terminalMap.ptIdx[rangeIdx++]]]];
+    for (IndexT idx = range.getStart(); idx != range.getEnd(); idx++) {
+      smPruned.sampleIndex[dest++] = terminalMap.sampleIndex[idx];
+    }
+  }
+
+  // Packs the retained nodes, preserving their order.
+  vector<IndexT> ptMap(height);
+  IndexT ptTop = 0;
+  for (IndexT ptId = 0; ptId < height; ptId++) {
+    ptMap[ptId] = ptTop;
+    ptTop += target[ptId] == ptId ? 1 : 0;
+  }
+  vector<DecNode> nodeOut(ptTop);
+  vector<double> scoreOut(ptTop);
+  vector<double> infoOut(ptTop);
+  for (IndexT ptId = 0; ptId < height; ptId++) {
+    if (target[ptId] != ptId)
+      continue;
+    DecNode node = nodeVec[ptId];
+    if (collapse[ptId]) {
+      node.setTerminal();
+      node.setInvert(false);
+    }
+    else if (node.isNonterminal()) {
+      node.setDelIdx(ptMap[getIdTrue(ptId)] - ptMap[ptId]);
+      infoOut[ptMap[ptId]] = nodeInfo[ptId];
+    }
+    nodeOut[ptMap[ptId]] = node;
+    scoreOut[ptMap[ptId]] = scores[ptId];
+  }
+  nodeVec = move(nodeOut);
+  scores = move(scoreOut);
+  nodeInfo = move(infoOut);
+
+  for (IndexT& ptId : smPruned.ptIdx) {
+    ptId = ptMap[ptId];
+  }
+  terminalMap = move(smPruned);
+  leafCount = terminalMap.getNodeCount();
+}
+
+
+void PreTree::hotLayout() {
+  IndexT height = nodeVec.size();
+  vector<IndexT> cover(height);
+  IndexT rangeIdx = 0;
+  for (IndexRange range : terminalMap.range) {
+    cover[terminalMap.ptIdx[rangeIdx++]] = range.getExtent();
+  }
+  for (IndexT ptId = height; ptId-- > 0; ) {
+    if (isNonterminal(ptId))
+      cover[ptId] = cover[getIdTrue(ptId)] + cover[getIdFalse(ptId)];
+  }
+
+  vector<IndexT> ptMap(height, height); // Original to relocated position.
+  ptMap[0] = 0;
+  IndexT ptTop = 1;
+  vector<IndexT> ptStack{0};
+  while (!ptStack.empty()) {
+    IndexT ptId = ptStack.back();
+    ptStack.pop_back();
+    if (isNonterminal(ptId)) {
+      IndexT ptTrue = getIdTrue(ptId);
+      IndexT ptFalse = getIdFalse(ptId);
+      ptMap[ptTrue] = ptTop++;
+      ptMap[ptFalse] = ptTop++;
+      bool hotTrue = cover[ptTrue] >= cover[ptFalse];
+      ptStack.push_back(hotTrue ? ptFalse : ptTrue);
+      ptStack.push_back(hotTrue ? ptTrue : ptFalse);
+    }
+  }
+
+  // Nodes unreachable from the root, if any, retain their order.
+  IndexT reachTop = ptTop;
+  for (IndexT ptId = 0; ptId < height; ptId++) {
+    if (ptMap[ptId] == height)
+      ptMap[ptId] = ptTop++;
+  }
+
+  vector<DecNode> nodeOut(height);
+  vector<double> scoreOut(height);
+  for (IndexT ptId = 0; ptId < height; ptId++) {
+    DecNode node = nodeVec[ptId];
+    if (ptMap[ptId] < reachTop && node.isNonterminal())
+      node.setDelIdx(ptMap[getIdTrue(ptId)] - ptMap[ptId]);
+    nodeOut[ptMap[ptId]] = node;
+    scoreOut[ptMap[ptId]] = scores[ptId];
+  }
+  nodeVec = move(nodeOut);
+  scores = move(scoreOut);
+
+  for (IndexT& ptId : terminalMap.ptIdx) {
+    ptId = ptMap[ptId];
+  }
+}
+
+
 IndexT PreTree::checkFrontier(const vector<IndexT>& stMap) const {
   vector<bool> ptSeen(getHeight());
   IndexT nonLeaf = 0;
@@ -22,6 +22,7 @@
 #include "forest.h"
 #include "decnode.h"
 #include "samplemap.h"
+#include "trainstat.h"
 
 #include <vector>
 
@@ -30,15 +31,18 @@
    @brief Serialized representation of the pre-tree, suitable for tranfer between devices such as coprocessors, disks and compute nodes.
 */
 class PreTree {
-  static IndexT leafMax; // User option:  maximum # leaves, if > 0.
+  const IndexT leafMax; // User option:  maximum # leaves, if > 0.
+  const double pruneCost; // User option:  penalty per leaf, if > 0.
   IndexT leafCount; // Running count of leaves.
   vector<DecNode> nodeVec; // Vector of tree nodes.
   vector<double> scores;
+  vector<double> nodeInfo; // Information gained by each nonterminal's split.
   vector<double> infoLocal; // Per-predictor nonterminal split information.
   BV splitBits; // Bit encoding of factor splits.
   BV observedBits; // Bit encoding of factor values.
   size_t bitEnd; // Next free slot in either bit vector.
   SampleMap terminalMap;
+  TrainStat trainStat; // Instrumentation of the tree's production.
 
   /**
      @brief Assigns index to leaves.
@@ -51,22 +55,43 @@ class PreTree {
    */
   void setLeafIndices();
 
- public:
+
   /**
+     @brief Collapses subtrees not paying for their leaves.
+
+     Minimizes, bottom-up, the cost-complexity measure: impurity plus
+     'pruneCost' per leaf.  A split's information is the impurity it
+     removes, so a subtree is retained only if the information of its
+     splits exceeds the penalty of the leaves it adds.  Nodes below a
+     collapsed subtree are dropped, and their samples pooled into the
+     new terminal.
    */
-  PreTree(const class PredictorFrame* frame,
-	  IndexT bagCount_);
+  void prune();
 
 
   /**
-   @brief Caches the row count and computes an initial estimate of node count.
+     @brief Relocates nodes so that training traffic runs through
+     contiguous memory.
 
-   @param leafMax is a user-specified limit on the number of leaves.
- */
-  static void init(IndexT leafMax_);
+     Sibling pairs remain adjacent, so pairs are laid out depth-first,
+     descending first into the child of greater training cover.  The
+     hottest path from the root thereby occupies consecutive pairs.
+     Leaf indices, and hence leaf dominators, are unaffected.
+   */
+  void hotLayout();
 
+ public:
+  /**
+   */
+  /**
+     @param leafMax is a user-specified limit on the number of leaves.
 
-  static void deInit();
+     @param pruneCost is a user-specified penalty per leaf.
+   */
+  PreTree(const class PredictorFrame* frame,
+	  IndexT bagCount_,
+	  IndexT leafMax_,
+	  double pruneCost_);
 
   
   /**
@@ -108,6 +133,9 @@ class PreTree {
   /**
      @brief Appends criterion for bit-based branch.
 
+     Encodes densely, as bits, or sparsely, as a level list, whichever
+     is the more compact.
+
      @param nux summarizes the criterion bits.
 
      @param cardinality is the predictor's cardinality.
@@ -141,10 +169,31 @@ class PreTree {
 	       struct Leaf* leaf) const;
 
 
+  /**
+     @brief Walks a training observation through the finalized tree.
+
+     Numeric criteria remain rank-valued until forest-wide update, so
+     the walk compares the observation's ranks.
+
+     @param row is the training row.
+
+     @return score of the terminal reached.
+   */
+  double scoreObs(const class PredictorFrame* frame,
+		  IndexT row) const;
+
+
   void setScore(const class SplitFrontier* sf,
 		const class IndexSet& iSet);
 
 
+  /**
+     @brief Applies an affine map to all node scores.
+   */
+  void rescore(double offset,
+	       double scale);
+
+
   /**
      @brief Assigns scores to all nodes in the map.
    */
@@ -152,6 +201,25 @@ class PreTree {
 		  const struct SampleMap& map);
 
 
+  /**
+     @brief Replaces a terminal by a separately-trained subtree.
+
+     The subtree's root takes the terminal's place and its remaining
+     nodes are appended, so successors continue to follow their
+     predecessors.  Factor bits are appended at a slot boundary, as
+     bit offsets are recorded slot-relative to the tree.
+
+     @param ptId is the index of the terminal replaced.
+
+     @param subtree is a pretree not yet finalized.
+
+     @return map from subtree index to index within this.
+   */
+  vector<IndexT> graft(const class PredictorFrame* frame,
+		       IndexT ptId,
+		       const PreTree* subtree);
+
+
   /**
      @brief Caches terminal map, merges, numbers leaves.
 
@@ -169,6 +237,28 @@ class PreTree {
   inline IndexT getHeight() const {
     return nodeVec.size();
   }
+
+
+  /**
+     @return number of further splits admitted by 'leafMax', each of
+     which adds a single leaf.
+   */
+  inline IndexT leafBudget() const {
+    if (leafMax == 0)
+      return numeric_limits<IndexT>::max();
+    else
+      return leafCount >= leafMax ? 0 : leafMax - leafCount;
+  }
+
+
+  void setTrainStat(const TrainStat& trainStat) {
+    this->trainStat = trainStat;
+  }
+
+
+  const TrainStat& getTrainStat() const {
+    return trainStat;
+  }
   
 
   inline void setTerminal(IndexT ptId) {
@@ -248,6 +338,7 @@ class PreTree {
       DecNode node;
       nodeVec.insert(nodeVec.end(), nCrit + 1, node);
       scores.insert(scores.end(), nCrit + 1, 0.0);
+      nodeInfo.insert(nodeInfo.end(), nCrit + 1, 0.0);
       leafCount++; // Two new terminals, minus one for conversion of lead criterion.
     }
   }
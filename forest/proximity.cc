@@ -0,0 +1,104 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file proximity.cc
+
+   @brief Methods deriving sparse proximities.
+
+   @author Mark Seligman
+ */
+
+#include "proximity.h"
+#include "predictstream.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+
+Proximity::Proximity(unsigned int nNbr_,
+		     double proxMin_) :
+  nNbr(nNbr_),
+  proxMin(proxMin_),
+  nRow(0) {
+}
+
+
+vector<IndexT> Proximity::invert(const LeafCollect* leaves,
+				 size_t nLeaf,
+				 vector<size_t>& leafPtr) {
+  leafPtr = vector<size_t>(nLeaf + 1);
+  for (auto leafIdx : leaves->leafCol) {
+    leafPtr[leafIdx + 1]++;
+  }
+  partial_sum(leafPtr.begin(), leafPtr.end(), leafPtr.begin());
+
+  vector<IndexT> leafRow(leaves->leafCol.size());
+  vector<size_t> leafTop(leafPtr.begin(), leafPtr.end() - 1);
+  for (size_t row = 0; row < leaves->getNRow(); row++) {
+    for (size_t idx = leaves->rowPtr[row]; idx != leaves->rowPtr[row + 1]; idx++) {
+      leafRow[leafTop[leaves->leafCol[idx]]++] = row;
+    }
+  }
+  return leafRow;
+}
+
+
+void Proximity::compute(const LeafCollect* leaves,
+			const vector<size_t>& leafOrigin) {
+  nRow = leaves->getNRow();
+  nbrRow = vector<IndexT>(nRow * nNbr);
+  nbrProx = vector<double>(nRow * nNbr);
+  nbrCount = vector<unsigned int>(nRow);
+  unsigned int nTree = leafOrigin.size() - 1;
+  if (nNbr == 0 || nTree == 0)
+    return;
+
+  vector<size_t> leafPtr;
+  vector<IndexT> leafRow = invert(leaves, leafOrigin.back(), leafPtr);
+  unsigned int countMin = max(1u, static_cast<unsigned int>(ceil(proxMin * nTree)));
+
+  OMPBound rowEnd = static_cast<OMPBound>(nRow);
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+    vector<unsigned int> coCount(nRow); // Co-occurrences with current row.
+    vector<IndexT> touched; // Rows having nonzero count.
+    vector<pair<unsigned int, IndexT>> candidate;
+#pragma omp for schedule(dynamic, 0x100)
+    for (OMPBound row = 0; row < rowEnd; row++) {
+      for (size_t idx = leaves->rowPtr[row]; idx != leaves->rowPtr[row + 1]; idx++) {
+	IndexT leafIdx = leaves->leafCol[idx];
+	for (size_t rowIdx = leafPtr[leafIdx]; rowIdx != leafPtr[leafIdx + 1]; rowIdx++) {
+	  IndexT rowNbr = leafRow[rowIdx];
+	  if (rowNbr != static_cast<IndexT>(row) && coCount[rowNbr]++ == 0)
+	    touched.push_back(rowNbr);
+	}
+      }
+
+      candidate.clear();
+      for (auto rowNbr : touched) {
+	if (coCount[rowNbr] >= countMin)
+	  candidate.emplace_back(coCount[rowNbr], rowNbr);
+	coCount[rowNbr] = 0;
+      }
+      touched.clear();
+
+      size_t nKeep = min(static_cast<size_t>(nNbr), candidate.size());
+      partial_sort(candidate.begin(), candidate.begin() + nKeep, candidate.end(),
+		   [](const pair<unsigned int, IndexT>& a, const pair<unsigned int, IndexT>& b) {
+		     return a.first > b.first || (a.first == b.first && a.second < b.second);
+		   });
+      for (size_t nbrIdx = 0; nbrIdx != nKeep; nbrIdx++) {
+	nbrRow[row * nNbr + nbrIdx] = candidate[nbrIdx].second;
+	nbrProx[row * nNbr + nbrIdx] = static_cast<double>(candidate[nbrIdx].first) / nTree;
+      }
+      nbrCount[row] = nKeep;
+    }
+  }
+}
@@ -0,0 +1,101 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file proximity.h
+
+   @brief Sparse nearest-neighbour proximities from leaf co-occurrence.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_PROXIMITY_H
+#define FOREST_PROXIMITY_H
+
+#include "typeparam.h"
+
+#include <vector>
+
+
+/**
+   @brief Retains, for each row, the rows sharing the most leaves with it.
+
+   Proximity is the fraction of trees in which two rows reach the same
+   leaf.  Rows are gathered per leaf into an inverted index, after which
+   each row's co-occurrence counts are accumulated in a per-thread
+   workspace and only the leading 'nNbr', at or above threshold, are
+   saved.  Memory is therefore bounded by the assignments themselves
+   plus 'nNbr' slots per row, rather than quadratic in the row count.
+ */
+class Proximity {
+  const unsigned int nNbr; // # neighbours retained per row.
+  const double proxMin; // Minimum proximity retained.
+  size_t nRow;
+  vector<IndexT> nbrRow; // Neighbouring rows, row-major, 'nNbr' per row.
+  vector<double> nbrProx; // Proximity of each neighbour.
+  vector<unsigned int> nbrCount; // # neighbours saved, per row.
+
+  /**
+     @brief Inverts the assignments to leaf-major order.
+
+     @param[out] leafPtr outputs offsets into the returned rows, by leaf.
+
+     @return rows reaching each leaf, increasing within leaf.
+   */
+  static vector<IndexT> invert(const struct LeafCollect* leaves,
+			       size_t nLeaf,
+			       vector<size_t>& leafPtr);
+
+public:
+  /**
+     @param nNbr_ is the maximal number of neighbours saved per row.
+
+     @param proxMin_ is the smallest proximity saved.
+   */
+  Proximity(unsigned int nNbr_,
+	    double proxMin_);
+
+
+  /**
+     @brief Derives neighbours from collected leaf assignments.
+
+     @param leafOrigin holds forest-wide leaf offsets by tree, plus sup.
+   */
+  void compute(const struct LeafCollect* leaves,
+	       const vector<size_t>& leafOrigin);
+
+
+  unsigned int getNNbr() const {
+    return nNbr;
+  }
+
+
+  /**
+     @return neighbouring rows, 'nNbr' slots per row.
+   */
+  const vector<IndexT>& getNbrRow() const {
+    return nbrRow;
+  }
+
+
+  /**
+     @return proximities, aligned with neighbouring rows.
+   */
+  const vector<double>& getNbrProx() const {
+    return nbrProx;
+  }
+
+
+  /**
+     @return # slots populated, per row.
+   */
+  const vector<unsigned int>& getNbrCount() const {
+    return nbrCount;
+  }
+};
+
+#endif
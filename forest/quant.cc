@@ -18,9 +18,15 @@
 #include "predict.h"
 #include "response.h"
 #include "sampler.h"
+#include "ompthread.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 const unsigned int Quant::binSize = 0x1000;
+const IndexT Quant::rankSup = numeric_limits<IndexT>::max();
+const double Quant::weightSlop = 1.0e-9;
 
 
 /**
@@ -31,19 +37,118 @@ Quant::Quant(const Forest* forest,
 	     const Leaf* leaf_,
 	     const Predict* predict,
 	     const ResponseReg* response,
-             const vector<double>& quantile_) :
+             const vector<double>& quantile_,
+	     unsigned int sketchSize_,
+	     bool exact_) :
   quantile(move(quantile_)),
   qCount(quantile.size()),
+  sketchSize(sketchSize_),
+  exact(exact_),
   sampler(predict->getSampler()),
   leaf(leaf_),
   empty(!sampler->hasSamples() || quantile.empty()),
-  leafDom((empty || !predict->trapAndBail()) ? vector<vector<IndexRange>>(0) : forest->leafDominators()), 
+  leafDom((empty || !predict->trapAndBail()) ? ForestIndex::noDom : forest->getIndex().getLeafDom()),
   valRank(RankedObs<double>(&response->getYTrain()[0], empty ? 0 : response->getYTrain().size())),
-  rankCount(empty ? vector<vector<vector<RankCount>>>(0) : leaf->alignRanks(sampler, valRank.rank())),
   rankScale(empty ? 0 : binScale()),
   binMean(empty ? vector<double>(0) : binMeans(valRank)),
+  sCountBin(vector<vector<IndexT>>(empty ? 0 : max(1u, OmpThread::nThread), vector<IndexT>(binMean.size()))),
+  countThreshold(vector<vector<double>>(sCountBin.size(), vector<double>(qCount))),
+  rankSorted(nullptr),
+  leafMerge(vector<LeafMerge>(exact ? sCountBin.size() : 0)),
   qPred(vector<double>(empty ? 0 : predict->getNRow() * qCount)),
-  qEst(vector<double>(empty ? 0 : predict->getNRow())) {
+  qEst(vector<double>(empty ? 0 : predict->getNRow())),
+  qOut(qPred.data(), predict->getNRow(), qCount),
+  qEstOut(qEst.data(), predict->getNRow(), 1) {
+  if (exact && sketchSize > 0)
+    throw invalid_argument("Exact quantiles cannot be sketched");
+  if (!empty) {
+    const vector<RankCount>& rankCount = leaf->getRankAligned(sampler, valRank.rank());
+    if (exact)
+      sortLeaves(rankCount);
+    else
+      binLeaves(rankCount);
+  }
+}
+
+
+void Quant::sortLeaves(const vector<RankCount>& rankCount) {
+  rankSorted = rankCount.data();
+  rankVal = vector<double>(valRank.getRankCount());
+  for (IndexT idx = 0; idx < valRank.getNRow(); idx++) {
+    rankVal[valRank.getRank(idx)] = valRank.getVal(idx);
+  }
+
+  const vector<size_t>& leafOrigin = leaf->getLeafOrigin();
+  for (size_t leafPos = 0; leafPos != leaf->getLeafTotal(); leafPos++) {
+    IndexT sampleTot = 0;
+    for (size_t idx = leafOrigin[leafPos]; idx != leafOrigin[leafPos + 1]; idx++) {
+      sampleTot += rankSorted[idx].getSCount();
+    }
+    leafTot.push_back(sampleTot);
+  }
+}
+
+
+void Quant::binLeaves(const vector<RankCount>& rankCount) {
+  vector<IndexT> binCount(binMean.size());
+  vector<unsigned int> binsSeen;
+  const vector<size_t>& leafOrigin = leaf->getLeafOrigin();
+  histStart.push_back(0);
+  for (size_t leafPos = 0; leafPos != leaf->getLeafTotal(); leafPos++) {
+    IndexT sampleTot = 0;
+    for (size_t idx = leafOrigin[leafPos]; idx != leafOrigin[leafPos + 1]; idx++) {
+      RankCount rc = rankCount[idx];
+      unsigned int binIdx = binRank(rc.getRank());
+      if (binCount[binIdx] == 0)
+	binsSeen.push_back(binIdx);
+      binCount[binIdx] += rc.getSCount();
+      sampleTot += rc.getSCount();
+    }
+    sort(binsSeen.begin(), binsSeen.end());
+    if (sketchSize == 0 || binsSeen.size() <= sketchSize) {
+      for (auto binIdx : binsSeen) {
+	histBin.push_back(binIdx);
+	histCount.push_back(binCount[binIdx]);
+      }
+    }
+    else {
+      sketchLeaf(binsSeen, binCount, sampleTot);
+    }
+    for (auto binIdx : binsSeen) {
+      binCount[binIdx] = 0;
+    }
+    binsSeen.clear();
+    histStart.push_back(histBin.size());
+    leafTot.push_back(sampleTot);
+  }
+}
+
+
+void Quant::sketchLeaf(const vector<unsigned int>& binsSeen,
+		       const vector<IndexT>& binCount,
+		       IndexT sampleTot) {
+  size_t histBase = histBin.size();
+  size_t seenIdx = 0;
+  IndexT below = 0; // # samples in bins preceding binsSeen[seenIdx].
+  IndexT entryStart = 0;
+  for (unsigned int entry = 0; entry < sketchSize; entry++) {
+    IndexT entryEnd = (static_cast<size_t>(sampleTot) * (entry + 1)) / sketchSize;
+    if (entryEnd == entryStart)
+      continue;
+    IndexT median = entryStart + (entryEnd - entryStart - 1) / 2;
+    while (below + binCount[binsSeen[seenIdx]] <= median) {
+      below += binCount[binsSeen[seenIdx++]];
+    }
+    unsigned int binIdx = binsSeen[seenIdx];
+    if (histBin.size() > histBase && histBin.back() == binIdx) {
+      histCount.back() += entryEnd - entryStart;
+    }
+    else {
+      histBin.push_back(binIdx);
+      histCount.push_back(entryEnd - entryStart);
+    }
+    entryStart = entryEnd;
+  }
 }
 
 
@@ -76,15 +181,41 @@ vector<double> Quant::binMeans(const RankedObs<double>& valRank) const {
 
 
 void Quant::predictRow(const PredictReg* predict, size_t row) {
-  vector<IndexT> sCountBin(std::min(static_cast<IndexT>(binSize), valRank.getRankCount()));
+  unsigned int thrIdx = OmpThread::threadIdx();
+  if (exact) {
+    LeafMerge& merge = leafMerge[thrIdx];
+    merge.clear();
+    unsigned int nTree = 0;
+    bool trapped = predict->isTrapped(row);
+    for (unsigned int tIdx = 0; tIdx < sampler->getNTree(); tIdx++) {
+      if (trapped) {
+	IndexT nodeIdx;
+	if (predict->isNodeIdx(row, tIdx, nodeIdx)) {
+	  IndexRange leafRange = leafDom[tIdx][nodeIdx];
+	  nTree += mergeTree(tIdx, leafRange.getStart(), leafRange.getEnd(), merge) ? 1 : 0;
+	}
+      }
+      else {
+	IndexT leafIdx;
+	if (predict->isLeafIdx(row, tIdx, leafIdx)) {
+	  nTree += mergeTree(tIdx, leafIdx, leafIdx + 1, merge) ? 1 : 0;
+	}
+      }
+    }
+    mergeSamples(predict, merge, nTree, row);
+    return;
+  }
+
+  vector<IndexT>& binCount = sCountBin[thrIdx];
+  fill(binCount.begin(), binCount.end(), 0);
   IndexT totSamples = 0;
-  if (predict->trapAndBail()) {
+  if (predict->isTrapped(row)) {
     for (unsigned int tIdx = 0; tIdx < sampler->getNTree(); tIdx++) {
       IndexT nodeIdx;
       if (predict->isNodeIdx(row, tIdx, nodeIdx)) {
 	IndexRange leafRange = leafDom[tIdx][nodeIdx];
 	for (IndexT leafIdx = leafRange.getStart(); leafIdx != leafRange.getEnd(); leafIdx++) {
-	  totSamples += sampleLeaf(tIdx, leafIdx, sCountBin);
+	  totSamples += sampleLeaf(tIdx, leafIdx, binCount);
 	}
       }
     }
@@ -93,33 +224,19 @@ void Quant::predictRow(const PredictReg* predict, size_t row) {
     for (unsigned int tIdx = 0; tIdx < sampler->getNTree(); tIdx++) {
       IndexT leafIdx;
       if (predict->isLeafIdx(row, tIdx, leafIdx)) {
-	totSamples += sampleLeaf(tIdx, leafIdx, sCountBin);
+	totSamples += sampleLeaf(tIdx, leafIdx, binCount);
       }
     }
   }
   // Builds sample-count thresholds for each quantile.
-  vector<double> countThreshold(qCount);
+  vector<double>& threshold = countThreshold[thrIdx];
   unsigned int qSlot = 0;
-  for (auto & thresh : countThreshold) {
+  for (auto & thresh : threshold) {
     thresh = totSamples * quantile[qSlot++];  // Rounding properties?
   }
 
   // Fills in quantile estimates.
-  quantSamples(predict, sCountBin, countThreshold, totSamples, row);
-}
-
-
-IndexT Quant::sampleLeaf(unsigned int tIdx,
-			 IndexT leafIdx,
-			 vector<IndexT>& sCountBin) const {
-  IndexT sampleTot = 0;
-  // sampleTot can be precomputed and cached, but rank traversal is
-  // irregular.
-  for (RankCount rc : rankCount[tIdx][leafIdx]) {
-    sCountBin[binRank(rc.getRank())] += rc.getSCount();
-    sampleTot += rc.getSCount();
-  }
-  return sampleTot; // Single leaf, so fits in IndexT.
+  quantSamples(predict, binCount, threshold, totSamples, row);
 }
 
 
@@ -133,11 +250,10 @@ void Quant::quantSamples(const PredictReg* predict,
   IndexT samplesSeen = 0;
   IndexT leftSamples = 0; // # samples with y-values <= yPred.
   double yPred = predict->getYPred(row);
-  double* qRow = &qPred[qCount * row];
   for (auto sc : sCountBin) {
     samplesSeen += sc;
     while (qSlot < qCount && samplesSeen >= threshold[qSlot]) {
-      qRow[qSlot++] = binMean[binIdx];
+      qOut.set(row, qSlot++, binMean[binIdx]);
     }
     if (yPred > binMean[binIdx]) {
       leftSamples = samplesSeen;
@@ -147,5 +263,105 @@ void Quant::quantSamples(const PredictReg* predict,
     binIdx++;
   }
 
-  qEst[row] = static_cast<double>(leftSamples) / totSample;
+  qEstOut.set(row, 0, static_cast<double>(leftSamples) / totSample);
+}
+
+
+bool Quant::mergeTree(unsigned int tIdx,
+		      IndexT leafStart,
+		      IndexT leafEnd,
+		      LeafMerge& merge) const {
+  IndexT treeTot = 0;
+  for (IndexT leafIdx = leafStart; leafIdx != leafEnd; leafIdx++) {
+    treeTot += leafTot[leaf->getLeafPos(tIdx, leafIdx)];
+  }
+  if (treeTot == 0)
+    return false;
+
+  // Each tree contributes unit weight, shared among its samples.
+  const vector<size_t>& leafOrigin = leaf->getLeafOrigin();
+  for (IndexT leafIdx = leafStart; leafIdx != leafEnd; leafIdx++) {
+    size_t leafPos = leaf->getLeafPos(tIdx, leafIdx);
+    if (leafOrigin[leafPos] != leafOrigin[leafPos + 1])
+      merge.addSource(leafOrigin[leafPos], leafOrigin[leafPos + 1], 1.0 / treeTot);
+  }
+  return true;
+}
+
+
+void Quant::mergeSamples(const PredictReg* predict,
+			 LeafMerge& merge,
+			 unsigned int nTree,
+			 size_t row) {
+  if (nTree == 0) { // Bagged in every tree.
+    for (unsigned int qSlot = 0; qSlot != qCount; qSlot++)
+      qOut.set(row, qSlot, nan(""));
+    qEstOut.set(row, 0, nan(""));
+    return;
+  }
+
+  double yPred = predict->getYPred(row);
+  double weightTot = nTree;
+  double weightSeen = 0.0;
+  double leftWeight = 0.0; // Weight of samples with y-values < yPred.
+  double yLast = 0.0;
+  unsigned int qSlot = 0;
+  for (unsigned int src = buildLoser(merge); mergeKey(merge, src) != rankSup; src = replayLoser(merge, src)) {
+    RankCount rc = rankSorted[merge.pos[src]];
+    double yVal = rankVal[rc.getRank()];
+    if (qSlot >= qCount && yVal >= yPred)
+      break;
+    weightSeen += rc.getSCount() * merge.scale[src];
+    if (yVal < yPred)
+      leftWeight = weightSeen;
+    while (qSlot < qCount && weightSeen >= weightTot * quantile[qSlot] * (1.0 - weightSlop)) {
+      qOut.set(row, qSlot++, yVal);
+    }
+    yLast = yVal;
+    merge.pos[src]++;
+  }
+  // Rounding may leave the highest quantiles just short of the total.
+  while (qSlot < qCount) {
+    qOut.set(row, qSlot++, yLast);
+  }
+
+  qEstOut.set(row, 0, min(1.0, leftWeight / weightTot));
+}
+
+
+unsigned int Quant::buildLoser(LeafMerge& merge) const {
+  unsigned int nSrc = merge.pos.size();
+  merge.loser.resize(nSrc);
+  merge.winner.resize(2 * nSrc);
+  for (unsigned int src = 0; src < nSrc; src++) {
+    merge.winner[nSrc + src] = src;
+  }
+  // Internal nodes lie below the sources, each parenting two slots.
+  for (unsigned int node = nSrc - 1; node > 0; node--) {
+    unsigned int left = merge.winner[2 * node];
+    unsigned int right = merge.winner[2 * node + 1];
+    bool rightWins = mergeKey(merge, right) < mergeKey(merge, left);
+    merge.winner[node] = rightWins ? right : left;
+    merge.loser[node] = rightWins ? left : right;
+  }
+  merge.loser[0] = merge.winner[1];
+
+  return merge.loser[0];
+}
+
+
+unsigned int Quant::replayLoser(LeafMerge& merge,
+				unsigned int src) const {
+  unsigned int nSrc = merge.pos.size();
+  IndexT key = mergeKey(merge, src);
+  for (unsigned int node = (src + nSrc) >> 1; node > 0; node >>= 1) {
+    IndexT loserKey = mergeKey(merge, merge.loser[node]);
+    if (loserKey < key) {
+      swap(src, merge.loser[node]);
+      key = loserKey;
+    }
+  }
+  merge.loser[0] = src;
+
+  return src;
 }
@@ -20,27 +20,84 @@
 #include "typeparam.h"
 #include "valrank.h"
 #include "leaf.h" // RankCount definition only.
+#include "predictout.h"
 
 #include <vector>
 
 
+/**
+   @brief Per-thread state for merging a row's leaves in rank order.
+ */
+struct LeafMerge {
+  vector<size_t> pos; // Current sample position, by source.
+  vector<size_t> end; // Sample position supremum, by source.
+  vector<double> scale; // Weight per sample count, by source.
+  vector<unsigned int> loser; // Loser tree:  overall winner at zero.
+  vector<unsigned int> winner; // Scratch for building loser tree.
+
+
+  void clear() {
+    pos.clear();
+    end.clear();
+    scale.clear();
+  }
+
+
+  void addSource(size_t start,
+		 size_t sup,
+		 double weight) {
+    pos.push_back(start);
+    end.push_back(sup);
+    scale.push_back(weight);
+  }
+};
+
+
 /**
  @brief Quantile signature.
+
+ Each leaf's ranked samples are binned once, into a histogram.  If
+ sketching, a leaf's histogram is further compressed to a bounded
+ number of equal-weight entries, each placed at the bin of its median
+ sample.  Entries merge by addition, so a row's cost is bounded by the
+ number of trees times the sketch size, whatever the leaf population.
+ Rank error is bounded by a single entry's weight, and so by roughly a
+ fraction 1 / sketch size of the samples merged.
+
+ In exact mode nothing is binned.  Each leaf retains its samples
+ sorted by rank and each sample is weighted by its share of the tree's
+ predicted samples, as in Meinshausen's quantile regression forests.
+ A row's leaves are merged in rank order through a loser tree, only
+ as far as the highest quantile and the predicted response require.
 */
 class Quant {
   static const unsigned int binSize; // # slots to track.
+  static const IndexT rankSup; // Merge key of an exhausted source.
+  static const double weightSlop; // Relative tolerance of weighted thresholds.
   const vector<double> quantile; // quantile values over which to predict.
   const unsigned int qCount; // caches quantile size for quick reference.
+  const unsigned int sketchSize; // Bound on per-leaf entries; zero iff exact.
+  const bool exact; // Whether merging unbinned, weighted leaf samples.
   const class Sampler* sampler;
   const struct Leaf* leaf;
   const bool empty; // if so, leave vectors empty and bail.
-  const vector<vector<IndexRange>> leafDom;
+  const vector<vector<IndexRange>>& leafDom; // Forest index's, iff trapping.
   const RankedObs<double> valRank;
-  const vector<vector<vector<RankCount>>> rankCount; // forest-wide, by sample.
   const unsigned int rankScale; // log2 of scaling factor.
   const vector<double> binMean;
+  vector<size_t> histStart; // Per-leaf CSR offset into histogram, plus sup.
+  vector<unsigned int> histBin; // Bin index, increasing within leaf.
+  vector<IndexT> histCount; // Sample count at bin.
+  vector<IndexT> leafTot; // Per-leaf sample total.
+  vector<vector<IndexT>> sCountBin; // Per-thread binned sample counts.
+  vector<vector<double>> countThreshold; // Per-thread quantile thresholds.
+  const RankCount* rankSorted; // Leaf samples sorted by rank, iff exact:  leaf's.
+  vector<double> rankVal; // Response value by rank, iff exact.
+  vector<LeafMerge> leafMerge; // Per-thread merge state, iff exact.
   vector<double> qPred; // predicted quantiles.
   vector<double> qEst; // quantile of response estimates.
+  PredictOut qOut; // Destination of quantiles:  qPred unless bound.
+  PredictOut qEstOut; // Destination of estimates:  qEst unless bound.
 
   
   /**
@@ -74,6 +131,90 @@ n     @brief Bins response means.
    */
   vector<double> binMeans(const RankedObs<double>& valRank) const;
 
+
+  /**
+     @brief Bins the ranked sample counts of every leaf, once.
+
+     @param rankCount holds forest-wide sample counts, positioned as
+     the leaf sample indices.
+   */
+  void binLeaves(const vector<RankCount>& rankCount);
+
+
+  /**
+     @brief Appends a leaf's histogram as a sketch of 'sketchSize' entries.
+
+     @param binsSeen are the leaf's occupied bins, in increasing order.
+
+     @param binCount are the sample counts, by bin.
+
+     @param sampleTot is the leaf's sample total.
+   */
+  void sketchLeaf(const vector<unsigned int>& binsSeen,
+		  const vector<IndexT>& binCount,
+		  IndexT sampleTot);
+
+
+
+  /**
+     @brief Retains the rank-sorted samples of every leaf, once.
+
+     @param rankCount holds forest-wide sample counts, sorted by rank
+     within each leaf.  Retained by the leaf, so referenced rather
+     than copied.
+   */
+  void sortLeaves(const vector<RankCount>& rankCount);
+
+
+  /**
+     @brief Appends the samples of a tree's predicted leaves to a merge.
+
+     @param leafStart, leafEnd delimit the tree-relative leaf indices.
+
+     @return true iff any sample was appended.
+   */
+  bool mergeTree(unsigned int tIdx,
+		 IndexT leafStart,
+		 IndexT leafEnd,
+		 LeafMerge& merge) const;
+
+
+  /**
+     @brief Writes exact quantile values for a row of predictions.
+
+     @param nTree is the number of trees contributing samples.
+   */
+  void mergeSamples(const class PredictReg* predictReg,
+		    LeafMerge& merge,
+		    unsigned int nTree,
+		    size_t row);
+
+
+  /**
+     @return rank at a merge source's position, else sentinel if exhausted.
+   */
+  inline IndexT mergeKey(const LeafMerge& merge,
+			 unsigned int src) const {
+    return merge.pos[src] == merge.end[src] ? rankSup : rankSorted[merge.pos[src]].getRank();
+  }
+
+
+  /**
+     @brief Builds the loser tree over the merge sources.
+
+     @return initial winning source.
+   */
+  unsigned int buildLoser(LeafMerge& merge) const;
+
+
+  /**
+     @brief Replays the matches of a source whose position has advanced.
+
+     @return winning source.
+   */
+  unsigned int replayLoser(LeafMerge& merge,
+			   unsigned int src) const;
+
   
   /**
      @brief Writes quantile values for a row of predictions.
@@ -94,7 +235,7 @@ n     @brief Bins response means.
   
 
   /**
-     @brief Accumulates the ranks assocated with predicted leaf.
+     @brief Accumulates the binned histogram of a predicted leaf.
 
      @param tIdx is a tree index.
 
@@ -104,9 +245,15 @@ n     @brief Bins response means.
 
      @return count of samples subsumed by leaf.
   */
-  IndexT sampleLeaf(unsigned int tIdx,
-		    IndexT leafIdx,
-		    vector<IndexT>& scountBin) const;
+  inline IndexT sampleLeaf(unsigned int tIdx,
+			   IndexT leafIdx,
+			   vector<IndexT>& sCountBin) const {
+    size_t leafPos = leaf->getLeafPos(tIdx, leafIdx);
+    for (size_t histIdx = histStart[leafPos]; histIdx != histStart[leafPos + 1]; histIdx++) {
+      sCountBin[histBin[histIdx]] += histCount[histIdx];
+    }
+    return leafTot[leafPos];
+  }
 
 
 public:
@@ -119,7 +266,9 @@ public:
 	const struct Leaf* leaf,
 	const class Predict* predict,
 	const class ResponseReg* response,
-        const vector<double>& quantile_);
+        const vector<double>& quantile_,
+	unsigned int sketchSize_,
+	bool exact_);
 
   ~Quant() = default;
   
@@ -145,9 +294,9 @@ public:
   /**
      @brief Accessor for predicted quantiles.
 
-     @return vector of quantile predictions.
+     @return vector of quantile predictions, empty if bound.
    */
-  const vector<double> getQPred() const {
+  const vector<double>& getQPred() const {
     return qPred;
   }
   
@@ -155,16 +304,35 @@ public:
   /**
      @brief Accessor for estimand quantiles.
 
-     @return pointer to base of estimand quantiles.
+     @return vector of estimand quantiles, empty if bound.
    */
-  const vector<double> getQEst() const {
+  const vector<double>& getQEst() const {
     return qEst;
   }
+
+
+  /**
+     @brief Directs output to caller storage, releasing the core vectors.
+
+     @param qOut_ receives the row x quantile predictions.
+
+     @param qEstOut_ receives the per-row estimand quantiles.
+   */
+  void bind(const PredictOut& qOut_,
+	    const PredictOut& qEstOut_) {
+    qOut = qOut_;
+    qEstOut = qEstOut_;
+    qPred = vector<double>();
+    qEst = vector<double>();
+  }
   
   
   /**
      @brief Writes the quantile values for a given row.
 
+     Scratch is that of the calling thread, so rows may be predicted
+     concurrently.
+
      @param row is the row over which to build prediction quantiles.
   */
   void predictRow(const class PredictReg* predictReg,
@@ -0,0 +1,97 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file quickscorer.cc
+
+   @brief Methods for bit-vector traversal of numeric-only forests.
+
+   @author Mark Seligman
+ */
+
+#include "quickscorer.h"
+#include "forest.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+QuickScorer::QuickScorer(const Forest* forest,
+			 PredictorT nPred_) :
+  nTree(forest->getNTree()),
+  nPred(nPred_),
+  slotOrigin(vector<size_t>(nTree + 1)),
+  leafOrigin(vector<size_t>(nTree + 1)),
+  condOrigin(vector<size_t>(nPred + 1)) {
+  const vector<vector<IndexRange>>& leafDom = forest->getIndex().getLeafDom();
+  vector<vector<QSCond>> predCond(nPred);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    const DecNode* tree = forest->getTreeNode(tIdx);
+    IndexT height = forest->getTreeHeight(tIdx);
+    IndexT nLeaf = tree[0].isTerminal() ? 1 : leafDom[tIdx][0].getExtent();
+    leafOrigin[tIdx + 1] = leafOrigin[tIdx] + nLeaf;
+    slotOrigin[tIdx + 1] = slotOrigin[tIdx] + (nLeaf + slotBits - 1) / slotBits;
+    leafNode.resize(leafOrigin[tIdx + 1]);
+    for (IndexT nodeIdx = 0; nodeIdx < height; nodeIdx++) {
+      const DecNode& node = tree[nodeIdx];
+      if (node.isTerminal()) {
+	leafNode[leafOrigin[tIdx] + leafDom[tIdx][nodeIdx].getStart()] = nodeIdx;
+      }
+      else {
+	predCond[node.getPredIdx()].emplace_back(node.getSplitNum(), tIdx, leafDom[tIdx][nodeIdx + node.getDelIdx()], node.advanceNum(nan("")) == node.getDelIdx());
+      }
+    }
+  }
+
+  bitsInit = vector<PackedT>(slotOrigin[nTree], ~0ull);
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    IndexT tail = (leafOrigin[tIdx + 1] - leafOrigin[tIdx]) % slotBits;
+    if (tail != 0) {
+      bitsInit[slotOrigin[tIdx + 1] - 1] = (1ull << tail) - 1;
+    }
+  }
+
+  for (PredictorT predIdx = 0; predIdx < nPred; predIdx++) {
+    sort(predCond[predIdx].begin(), predCond[predIdx].end());
+    condOrigin[predIdx + 1] = condOrigin[predIdx] + predCond[predIdx].size();
+    cond.insert(cond.end(), predCond[predIdx].begin(), predCond[predIdx].end());
+  }
+}
+
+
+void QuickScorer::walk(const double rowT[],
+		       PackedT bits[],
+		       IndexT nodeOut[]) const {
+  copy(bitsInit.begin(), bitsInit.end(), bits);
+  for (PredictorT predIdx = 0; predIdx < nPred; predIdx++) {
+    double val = rowT[predIdx];
+    const QSCond* condEnd = cond.data() + condOrigin[predIdx + 1];
+    if (isnan(val)) { // Only non-inverted nodes send NaN to the false branch.
+      for (const QSCond* qc = cond.data() + condOrigin[predIdx]; qc != condEnd; qc++) {
+	if (!qc->nanTrue)
+	  exclude(&bits[slotOrigin[qc->tIdx]], qc->leafStart, qc->leafEnd);
+      }
+    }
+    else {
+      for (const QSCond* qc = cond.data() + condOrigin[predIdx]; qc != condEnd && qc->split < val; qc++) {
+	exclude(&bits[slotOrigin[qc->tIdx]], qc->leafStart, qc->leafEnd);
+      }
+    }
+  }
+
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    nodeOut[tIdx] = leafNode[leafOrigin[tIdx] + exitLeaf(&bits[slotOrigin[tIdx]])];
+  }
+}
+
+
+IndexT QuickScorer::exitLeaf(const PackedT treeBits[]) const {
+  IndexT slot = 0;
+  while (treeBits[slot] == 0ull)
+    slot++;
+  return slot * slotBits + __builtin_ctzll(treeBits[slot]);
+}
@@ -0,0 +1,138 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file quickscorer.h
+
+   @brief Bit-vector traversal of numeric-only forests.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_QUICKSCORER_H
+#define FOREST_QUICKSCORER_H
+
+#include "typeparam.h"
+
+#include <vector>
+
+
+/**
+   @brief Condition record:  a numeric split, ordered by value.
+
+   A row arriving at this node with value above the split excludes
+   every leaf of the true branch.
+ */
+struct QSCond {
+  double split; // Splitting value.
+  unsigned int tIdx; // Tree index.
+  IndexT leafStart; // First dominated leaf of true branch.
+  IndexT leafEnd; // Sup of dominated leaves.
+  bool nanTrue; // Whether NaN takes the true branch.
+
+  QSCond(double split_,
+	 unsigned int tIdx_,
+	 const IndexRange& trueRange,
+	 bool nanTrue_) :
+    split(split_),
+    tIdx(tIdx_),
+    leafStart(trueRange.getStart()),
+    leafEnd(trueRange.getEnd()),
+    nanTrue(nanTrue_) {
+  }
+
+
+  bool operator<(const QSCond& other) const {
+    return split < other.split;
+  }
+};
+
+
+/**
+   @brief QuickScorer-style traversal engine.
+
+   Leaves of each tree are placed in true-branch-first order, so the exit
+   leaf of a row is the lowest leaf surviving the exclusions of all
+   conditions the row fails.  Conditions are visited per predictor in
+   increasing split order, so each row touches only the failed conditions
+   together with a single sentinel per predictor.
+ */
+class QuickScorer {
+  static constexpr unsigned int slotBits = 8 * sizeof(PackedT);
+
+  const unsigned int nTree;
+  const PredictorT nPred;
+  vector<size_t> slotOrigin; // Per-tree offset into leaf bits.
+  vector<size_t> leafOrigin; // Per-tree offset into leaf-node map.
+  vector<IndexT> leafNode; // Maps leaf position to tree-relative node index.
+  vector<PackedT> bitsInit; // All leaves reachable.
+  vector<size_t> condOrigin; // Per-predictor offset into conditions.
+  vector<QSCond> cond; // Conditions, grouped by predictor.
+
+  /**
+     @brief Clears a range of leaf bits within a tree.
+
+     @param treeBits is the base of the tree's bit vector.
+   */
+  static inline void exclude(PackedT treeBits[],
+			     IndexT leafStart,
+			     IndexT leafEnd) {
+    IndexT slotStart = leafStart / slotBits;
+    IndexT slotEnd = (leafEnd - 1) / slotBits;
+    PackedT maskStart = ~0ull << (leafStart % slotBits);
+    PackedT maskEnd = ~0ull >> (slotBits - 1 - ((leafEnd - 1) % slotBits));
+    if (slotStart == slotEnd) {
+      treeBits[slotStart] &= ~(maskStart & maskEnd);
+    }
+    else {
+      treeBits[slotStart] &= ~maskStart;
+      for (IndexT slot = slotStart + 1; slot < slotEnd; slot++)
+	treeBits[slot] = 0ull;
+      treeBits[slotEnd] &= ~maskEnd;
+    }
+  }
+
+
+  /**
+     @return position of lowest surviving leaf in tree.
+   */
+  IndexT exitLeaf(const PackedT treeBits[]) const;
+
+public:
+
+  /**
+     @brief Builds condition lists from a numeric-only forest.
+
+     @param nPred is the number of (numeric) predictors.
+   */
+  QuickScorer(const class Forest* forest,
+	      PredictorT nPred_);
+
+
+  /**
+     @return number of slots spanned by the leaf bits of all trees.
+   */
+  size_t getNSlot() const {
+    return bitsInit.size();
+  }
+
+
+  /**
+     @brief Determines the terminal reached by a row in every tree.
+
+     @param rowT is the transposed numeric row.
+
+     @param bits is caller-owned scratch of getNSlot() slots.
+
+     @param[out] nodeOut outputs the tree-relative terminal, per tree.
+   */
+  void walk(const double rowT[],
+	    PackedT bits[],
+	    IndexT nodeOut[]) const;
+};
+
+#endif
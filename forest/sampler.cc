@@ -11,10 +11,18 @@
 #include "response.h"
 #include "samplernux.h"
 #include "prng.h"
+#include "ompthread.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unistd.h>
+#include <stdexcept>
 
 
 PackedT SamplerNux::delMask = 0;
 unsigned int SamplerNux::rightBits = 0;
+const unsigned int Sampler::binExp = Sampler::cacheBinExp();
+const unsigned int Sampler::maxStrata = 16;
 
 
 Sampler::Sampler(IndexT nSamp_,
@@ -24,14 +32,18 @@ Sampler::Sampler(IndexT nSamp_,
 		 const double weight[]) :
     nTree(nTree_),
     nObs(nObs_),
-    nSamp(nSamp_) {
+    nSamp(nSamp_),
+    blockSize(0) {
   setCoefficients(weight, replace);
 }
 
   
 void Sampler::setCoefficients(const double weight[],
 			      bool replace) {
-  if (weight != nullptr) {
+  if (weight != nullptr && stratifyWeight(weight, replace)) {
+    return;
+  }
+  else if (weight != nullptr) {
     if (replace)
       walker = make_unique<Sample::Walker<size_t>>(weight, nObs);
     else {
@@ -46,6 +58,193 @@ void Sampler::setCoefficients(const double weight[],
 }
 
 
+bool Sampler::stratifyWeight(const double weight[],
+			     bool replace) {
+  vector<double> value;
+  vector<size_t> stratum(nObs);
+  for (size_t row = 0; row < nObs; row++) {
+    auto it = find(value.begin(), value.end(), weight[row]);
+    if (it == value.end()) {
+      if (value.size() == maxStrata)
+	return false;
+      it = value.insert(value.end(), weight[row]);
+    }
+    stratum[row] = it - value.begin();
+  }
+
+  // Counting sort by stratum; rows of zero weight are never drawn.
+  vector<size_t> origin(value.size() + 1);
+  for (size_t row = 0; row < nObs; row++) {
+    origin[stratum[row] + 1]++;
+  }
+  partial_sum(origin.begin(), origin.end(), origin.begin());
+  vector<size_t> rowGrouped(nObs);
+  vector<size_t> pos(origin.begin(), origin.end() - 1);
+  for (size_t row = 0; row < nObs; row++) {
+    rowGrouped[pos[stratum[row]]++] = row;
+  }
+
+  strataOrigin = vector<size_t>(1);
+  for (size_t idx = 0; idx < value.size(); idx++) {
+    if (value[idx] > 0.0) {
+      strataRow.insert(strataRow.end(), rowGrouped.begin() + origin[idx], rowGrouped.begin() + origin[idx + 1]);
+      strataOrigin.push_back(strataRow.size());
+      strataWeight.push_back(value[idx]);
+    }
+  }
+  strataReplace = replace;
+  return true;
+}
+
+
+void Sampler::setStrata(const vector<PredictorT>& yCtg,
+			const vector<size_t>& ctgSamp,
+			bool replace) {
+  if (yCtg.size() != nObs)
+    throw invalid_argument("Response length differs from observation count");
+  if (accumulate(ctgSamp.begin(), ctgSamp.end(), size_t(0)) != nSamp)
+    throw invalid_argument("Per-category counts must sum to the sample count");
+
+  strataOrigin = vector<size_t>(ctgSamp.size() + 1);
+  for (auto ctg : yCtg) {
+    if (ctg >= ctgSamp.size())
+      throw invalid_argument("Category exceeds count vector");
+    strataOrigin[ctg + 1]++;
+  }
+  partial_sum(strataOrigin.begin(), strataOrigin.end(), strataOrigin.begin());
+  for (PredictorT ctg = 0; ctg < ctgSamp.size(); ctg++) {
+    size_t nCtg = strataOrigin[ctg + 1] - strataOrigin[ctg];
+    if ((nCtg == 0 && ctgSamp[ctg] > 0) || (!replace && ctgSamp[ctg] > nCtg))
+      throw invalid_argument("Category count exceeds category population");
+  }
+  strataRow = vector<size_t>(nObs);
+  vector<size_t> pos(strataOrigin.begin(), strataOrigin.end() - 1);
+  for (size_t row = 0; row < nObs; row++) {
+    strataRow[pos[yCtg[row]]++] = row;
+  }
+  strataSamp = ctgSamp;
+  strataWeight.clear();
+  strataReplace = replace;
+  walker = nullptr;
+  weightNoReplace.clear();
+  coeffNoReplace.clear();
+}
+
+
+void Sampler::setBlocks(size_t blockSize_) {
+  if (walker != nullptr || !weightNoReplace.empty() || !strataOrigin.empty())
+    throw invalid_argument("Block sampling requires uniform weights");
+  blockSize = blockSize_ < 2 ? 0 : min(blockSize_, nObs);
+
+  // Sampling without replacement falls back to rows if the tiling's
+  // whole blocks cannot accommodate the bag.
+  if (!coeffNoReplace.empty() && blockSize > 0 && (nObs / blockSize) * blockSize < nSamp)
+    blockSize = 0;
+}
+
+
+vector<SamplerNux> Sampler::sampleBlocks() const {
+  size_t nBlock = (nSamp + blockSize - 1) / blockSize;
+  vector<size_t> blockStart;
+  if (coeffNoReplace.empty()) {
+    blockStart = PRNG::rUnifIndex(nBlock, nObs);
+  }
+  else {
+    size_t offset = PRNG::rUnifIndex(1, nObs)[0];
+    size_t nTile = nObs / blockSize;
+    vector<size_t> scale(nBlock);
+    iota(scale.begin(), scale.end(), nTile - nBlock + 1);
+    reverse(scale.begin(), scale.end());
+    for (auto tile : Sample::sampleUniform<size_t>(scale, nTile))
+      blockStart.push_back((offset + tile * blockSize) % nObs);
+  }
+
+  // Coverage changes at block boundaries, wrapped blocks split in two.
+  vector<pair<size_t, int>> edge;
+  edge.reserve(4 * nBlock);
+  for (size_t blockIdx = 0; blockIdx != nBlock; blockIdx++) {
+    size_t start = blockStart[blockIdx];
+    size_t extent = blockIdx + 1 == nBlock ? nSamp - blockIdx * blockSize : blockSize;
+    size_t end = start + extent;
+    edge.emplace_back(start, 1);
+    if (end > nObs) {
+      edge.emplace_back(nObs, -1);
+      edge.emplace_back(0, 1);
+      end -= nObs;
+    }
+    edge.emplace_back(end, -1);
+  }
+  sort(edge.begin(), edge.end());
+
+  vector<SamplerNux> nux;
+  nux.reserve(nSamp);
+  IndexT rowPrev = 0;
+  int cover = 0;
+  for (size_t pos = 0; pos != edge.size(); ) {
+    size_t row = edge[pos].first;
+    for (; pos != edge.size() && edge[pos].first == row; pos++)
+      cover += edge[pos].second;
+    if (cover > 0) {
+      for (; row != edge[pos].first; row++)
+	nux.emplace_back(row - exchange(rowPrev, row), cover);
+    }
+  }
+  return nux;
+}
+
+
+vector<size_t> Sampler::strataCount() const {
+  size_t nStrata = strataWeight.size();
+  vector<size_t> count(nStrata);
+  vector<double> mass(nStrata);
+  for (size_t idx = 0; idx < nStrata; idx++) {
+    mass[idx] = strataWeight[idx] * (strataOrigin[idx + 1] - strataOrigin[idx]);
+  }
+  double massTot = accumulate(mass.begin(), mass.end(), 0.0);
+  vector<double> ru = PRNG::rUnif(nSamp);
+  for (double variate : ru) {
+    double target = variate * massTot;
+    size_t idx = 0;
+    while (idx + 1 < nStrata && (target -= mass[idx]) >= 0.0)
+      idx++;
+    while (idx > 0 && mass[idx] <= 0.0) // Rounding past a depleted stratum.
+      idx--;
+    count[idx]++;
+    if (!strataReplace) { // Depletes the stratum by one row.
+      mass[idx] -= strataWeight[idx];
+      massTot = accumulate(mass.begin(), mass.end(), 0.0);
+    }
+  }
+  return count;
+}
+
+
+vector<size_t> Sampler::sampleStrata() const {
+  vector<size_t> count = strataSamp.empty() ? strataCount() : strataSamp;
+  vector<size_t> idx;
+  idx.reserve(nSamp);
+  for (size_t stratum = 0; stratum < count.size(); stratum++) {
+    size_t nDraw = count[stratum];
+    if (nDraw == 0)
+      continue;
+    const size_t* rowBase = &strataRow[strataOrigin[stratum]];
+    size_t nStratum = strataOrigin[stratum + 1] - strataOrigin[stratum];
+    if (strataReplace) {
+      for (auto off : PRNG::rUnifIndex(nDraw, nStratum))
+	idx.push_back(rowBase[off]);
+    }
+    else {
+      vector<size_t> scale(nDraw);
+      iota(scale.begin(), scale.end(), nStratum - nDraw + 1);
+      reverse(scale.begin(), scale.end());
+      for (auto off : Sample::sampleUniform<size_t>(scale, nStratum))
+	idx.push_back(rowBase[off]);
+    }
+  }
+  return idx;
+}
+
+
 Sampler::Sampler(const vector<double>& yTrain,
 		 IndexT nSamp_,
 		 vector<vector<SamplerNux>> samples_) :
@@ -53,7 +252,8 @@ Sampler::Sampler(const vector<double>& yTrain,
   nObs(yTrain.size()),
   nSamp(nSamp_),
   response(Response::factoryReg(yTrain)),
-  samples(samples_) {
+  samples(samples_),
+  rowCheck(checkpoint(samples)) {
 }
 
 
@@ -66,7 +266,8 @@ Sampler::Sampler(const vector<PredictorT>& yTrain,
   nObs(yTrain.size()),
   nSamp(nSamp_),
   response(Response::factoryCtg(yTrain, nCtg, classWeight)),
-  samples(move(samples_)) {
+  samples(move(samples_)),
+  rowCheck(checkpoint(samples)) {
 }
 
 
@@ -79,7 +280,8 @@ Sampler::Sampler(const vector<double>& yTrain,
   nSamp(nSamp_),
   response(Response::factoryReg(yTrain)),
   samples(move(samples_)),
-  bagMatrix(bagRows(bagging)) {
+  rowCheck(checkpoint(samples)),
+  bagStore(bagging ? make_unique<BagStore>(samples, nObs) : nullptr) {
 }
 
 
@@ -93,7 +295,8 @@ Sampler::Sampler(const vector<PredictorT>& yTrain,
   nSamp(nSamp_),
   response(Response::factoryCtg(yTrain, nCtg)),
   samples(move(samples_)),
-  bagMatrix(bagRows(bagging)) {
+  rowCheck(checkpoint(samples)),
+  bagStore(bagging ? make_unique<BagStore>(samples, nObs) : nullptr) {
 }
 
 
@@ -101,19 +304,67 @@ Sampler::~Sampler() {
 }
 
 
-unique_ptr<BitMatrix> Sampler::bagRows(bool bagging) {
-  if (!bagging)
-    return make_unique<BitMatrix>(0, 0);
+unique_ptr<Sampler> Sampler::select(const vector<unsigned int>& treeIdx) const {
+  vector<pair<const Sampler*, unsigned int>> treeRef;
+  for (unsigned int tIdx : treeIdx) {
+    if (tIdx >= nTree) {
+      throw invalid_argument("Tree index out of range");
+    }
+    treeRef.emplace_back(this, tIdx);
+  }
+  if (treeRef.empty()) {
+    throw invalid_argument("Empty tree selection");
+  }
+  return gather(treeRef);
+}
 
-  unique_ptr<BitMatrix> matrix = make_unique<BitMatrix>(nTree, nObs);
-  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
-    IndexT row = 0;
-    for (IndexT sIdx = 0; sIdx != getBagCount(tIdx); sIdx++) {
-      row += getDelRow(tIdx, sIdx);
-      matrix->setBit(tIdx, row);
+
+unique_ptr<Sampler> Sampler::merge(const vector<const Sampler*>& samplers) {
+  vector<pair<const Sampler*, unsigned int>> treeRef;
+  for (const Sampler* sampler : samplers) {
+    if (!samplers[0]->conforms(sampler)) {
+      throw invalid_argument("Samplers do not share a training response");
+    }
+    for (unsigned int tIdx = 0; tIdx < sampler->nTree; tIdx++) {
+      treeRef.emplace_back(sampler, tIdx);
     }
   }
-  return matrix;
+  if (treeRef.empty()) {
+    throw invalid_argument("Empty tree selection");
+  }
+  return gather(treeRef);
+}
+
+
+unique_ptr<Sampler> Sampler::gather(const vector<pair<const Sampler*, unsigned int>>& treeRef) {
+  vector<vector<SamplerNux>> samplesOut;
+  for (auto ref : treeRef) {
+    samplesOut.push_back(ref.first->samples[ref.second]);
+  }
+
+  const Sampler* proto = treeRef[0].first;
+  PredictorT nCtg = proto->response->getNCtg();
+  if (nCtg == 0) {
+    return make_unique<Sampler>(static_cast<const ResponseReg*>(proto->getResponse())->getYTrain(), move(samplesOut), proto->nSamp, proto->isBagging());
+  }
+  else {
+    return make_unique<Sampler>(static_cast<const ResponseCtg*>(proto->getResponse())->getYCtg(), move(samplesOut), proto->nSamp, nCtg, proto->isBagging());
+  }
+}
+
+
+bool Sampler::conforms(const Sampler* other) const {
+  if (nObs != other->nObs || nSamp != other->nSamp || isBagging() != other->isBagging())
+    return false;
+  PredictorT nCtg = response->getNCtg();
+  if (nCtg != other->response->getNCtg())
+    return false;
+  if (nCtg == 0) {
+    return static_cast<const ResponseReg*>(response.get())->getYTrain() == static_cast<const ResponseReg*>(other->response.get())->getYTrain();
+  }
+  else {
+    return static_cast<const ResponseCtg*>(response.get())->getYCtg() == static_cast<const ResponseCtg*>(other->response.get())->getYCtg();
+  }
 }
 
 
@@ -122,14 +373,35 @@ unique_ptr<SampledObs> Sampler::rootSample(unsigned int tIdx) const {
 }
 
 
-vector<IndexT> Sampler::sampledRows(unsigned int tIdx) const {
-  vector<IndexT> rowsSampled(sbCresc.size());
+vector<vector<IndexT>> Sampler::checkpoint(const vector<vector<SamplerNux>>& samples) {
+  vector<vector<IndexT>> rowCheck(samples.size());
+  for (unsigned int tIdx = 0; tIdx < samples.size(); tIdx++) {
+    rowCheck[tIdx].reserve((samples[tIdx].size() >> checkExp) + 1);
+    IndexT row = 0;
+    for (IndexT sIdx = 0; sIdx != samples[tIdx].size(); sIdx++) {
+      row += samples[tIdx][sIdx].getDelRow();
+      if ((sIdx & ((1ul << checkExp) - 1)) == 0)
+	rowCheck[tIdx].push_back(row);
+    }
+  }
+  return rowCheck;
+}
+
 
-  IndexT sIdx = 0;
-  IndexT row = 0;
-  for (auto nux : sbCresc) {
-    row += nux.getDelRow();
-    rowsSampled[sIdx++] = row;
+vector<IndexT> Sampler::sampledRows(unsigned int tIdx) const {
+  const vector<SamplerNux>& nux = samples[tIdx];
+  vector<IndexT> rowsSampled(nux.size());
+  OMPBound blockEnd = rowCheck[tIdx].size();
+#pragma omp parallel for default(shared) schedule(static) num_threads(OmpThread::nThread) if (blockEnd > 0x400)
+  for (OMPBound blockIdx = 0; blockIdx < blockEnd; blockIdx++) {
+    IndexT sIdx = blockIdx << checkExp;
+    IndexT sEnd = min<size_t>(nux.size(), sIdx + (1ul << checkExp));
+    IndexT row = rowCheck[tIdx][blockIdx];
+    rowsSampled[sIdx] = row;
+    while (++sIdx != sEnd) {
+      row += nux[sIdx].getDelRow();
+      rowsSampled[sIdx] = row;
+    }
   }
 
   return rowsSampled;
@@ -137,8 +409,17 @@ vector<IndexT> Sampler::sampledRows(unsigned int tIdx) const {
 
 
 void Sampler::sample() {
+  if (blockSize > 0) {
+    vector<SamplerNux> nux = sampleBlocks();
+    sbCresc.insert(sbCresc.end(), nux.begin(), nux.end());
+    return;
+  }
+
   vector<size_t> idxOut;
-  if (walker != nullptr) {
+  if (!strataOrigin.empty()) {
+    idxOut = sampleStrata();
+  }
+  else if (walker != nullptr) {
     idxOut = walker->sample(nSamp);
   }
   else if (!weightNoReplace.empty()) {
@@ -155,65 +436,148 @@ void Sampler::sample() {
 }
 
 
-void Sampler::appendSamples(const vector<size_t>& idx) {
-  vector<IndexT> sCountRow = binIdx(nObs) > 0 ? countSamples(binIndices(nObs, idx)) : countSamples(idx);
-  IndexT rowPrev = 0;
-  for (IndexT row = 0; row < nObs; row++) {
-    if (sCountRow[row] > 0) {
-      sbCresc.emplace_back(row - exchange(rowPrev, row), sCountRow[row]);
+void Sampler::sampleTrees() {
+  uint64_t seed = PRNGLocal::sessionSeed();
+  vector<vector<SamplerNux>> treeNux(nTree);
+  OMPBound treeEnd = nTree;
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+    vector<IndexT> sCount(binWidth()); // Reused across the thread's trees.
+#pragma omp for schedule(dynamic, 1)
+    for (OMPBound tIdx = 0; tIdx < treeEnd; tIdx++) {
+      PRNGLocal local(seed, tIdx);
+      treeNux[tIdx] = sampleTree(sCount);
     }
   }
+
+  for (auto & nux : treeNux) {
+    sbCresc.insert(sbCresc.end(), nux.begin(), nux.end());
+    vector<SamplerNux>().swap(nux); // Releases as consumed.
+  }
 }
 
 
-vector<IndexT> Sampler::countSamples(const vector<size_t>& idx) {
-  vector<IndexT> sc(nObs);
-  for (auto index : idx) {
-    sc[index]++;
+vector<SamplerNux> Sampler::sampleTree(vector<IndexT>& sCount) const {
+  if (blockSize > 0)
+    return sampleBlocks();
+
+  bool uniform = walker == nullptr && weightNoReplace.empty() && coeffNoReplace.empty() && strataOrigin.empty();
+  if (uniform && nObs <= sCount.size()) {
+    // Uniform with replacement, cache-resident:  counted as drawn,
+    // without an index copy.
+    for (size_t i = 0; i < nSamp; i++) {
+      sCount[static_cast<size_t>(PRNGLocal::unif() * nObs)]++;
+    }
+    vector<SamplerNux> nux;
+    IndexT rowPrev = 0;
+    emitNux(sCount, 0, nObs, rowPrev, nux);
+    return nux;
+  }
+
+  vector<size_t> idx;
+  if (!strataOrigin.empty())
+    idx = sampleStrata();
+  else if (walker != nullptr)
+    idx = walker->sample(nSamp);
+  else if (!weightNoReplace.empty())
+    idx = Sample::sampleEfraimidis<size_t>(weightNoReplace, nSamp);
+  else if (!coeffNoReplace.empty())
+    idx = Sample::sampleUniform<size_t>(coeffNoReplace, nObs);
+  else {
+    idx = vector<size_t>(nSamp);
+    for (auto & index : idx) {
+      index = PRNGLocal::unif() * nObs;
+    }
   }
 
-  return sc;
+  return countBinned(move(idx), sCount);
 }
 
 
-// Sample counting is sensitive to locality.  In the absence of
-// binning, access is random.  Larger bins improve locality, but
-// performance begins to degrade when bin size exceeds available
-// cache.
-vector<size_t> Sampler::binIndices(size_t nObs,
-				   const vector<size_t>& idx) {
-  // Sets binPop to respective bin population, then accumulates population
-  // of bins to the left.
-  // Performance not sensitive to bin width.
-  //
-  vector<size_t> binPop(1 + binIdx(nObs));
-  for (auto val : idx) {
-    binPop[binIdx(val)]++;
-  }
-  for (unsigned int i = 1; i < binPop.size(); i++) {
-    binPop[i] += binPop[i-1];
+void Sampler::emitNux(vector<IndexT>& sCount,
+		      size_t rowBase,
+		      size_t extent,
+		      IndexT& rowPrev,
+		      vector<SamplerNux>& nux) const {
+  for (size_t off = 0; off != extent; off++) {
+    if (sCount[off] > 0) {
+      IndexT row = rowBase + off;
+      nux.emplace_back(row - exchange(rowPrev, row), exchange(sCount[off], 0));
+    }
   }
+}
+
+
+void Sampler::appendSamples(const vector<size_t>& idx) {
+  vector<IndexT> sCount(binWidth());
+  vector<SamplerNux> nux = countBinned(idx, sCount);
+  sbCresc.insert(sbCresc.end(), nux.begin(), nux.end());
+}
 
-  // Available index initialzed to one less than total population left of and
-  // including bin.  Empty bins have same initial index as bin to the left.
-  // This is not a problem, as empty bins are not (re)visited.
-  //
-  vector<int> idxAvail(binPop.size());
-  for (unsigned int i = 0; i < idxAvail.size(); i++) {
-    idxAvail[i] = static_cast<int>(binPop[i]) - 1;
+
+vector<SamplerNux> Sampler::countBinned(vector<size_t> idx,
+					vector<IndexT>& sCount) const {
+  if (binIdx(nObs - 1) > 0)
+    idx = binIndices(move(idx));
+
+  // Each bin is tabulated within the cache-resident buffer, then
+  // emitted directly, in row order.
+  vector<SamplerNux> nux;
+  IndexT rowPrev = 0;
+  size_t pos = 0;
+  while (pos != idx.size()) {
+    size_t bin = binIdx(idx[pos]);
+    size_t rowBase = bin << binExp;
+    for (; pos != idx.size() && binIdx(idx[pos]) == bin; pos++) {
+      sCount[idx[pos] - rowBase]++;
+    }
+    emitNux(sCount, rowBase, min(sCount.size(), nObs - rowBase), rowPrev, nux);
   }
 
-  // Writes to the current available index for bin, which is then decremented.
-  //
-  // Performance degrades if bin width exceeds available cache.
-  //
+  return nux;
+}
+
+
+unsigned int Sampler::cacheBinExp() {
+  size_t cacheSize = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  cacheSize = l2 > 0 ? l2 : 0;
+#endif
+  if (cacheSize == 0)
+    cacheSize = size_t(1) << 18; // Conservative default.
+
+  // Half the cache is left to the streamed indices.
+  unsigned int exp = 0;
+  while ((size_t(2) << exp) * sizeof(IndexT) <= cacheSize / 2)
+    exp++;
+  return max(12u, min(exp, 24u));
+}
+
+
+vector<size_t> Sampler::binIndices(vector<size_t> idx) const {
+  size_t binTop = binIdx(nObs - 1);
   vector<size_t> idxBinned(idx.size());
-  for (auto index : idx) {
-    int destIdx = idxAvail[binIdx(index)]--;
-    idxBinned[destIdx] = index;
+  constexpr size_t digitMask = (size_t(1) << radixBits) - 1;
+  for (unsigned int shift = 0; (binTop >> shift) != 0; shift += radixBits) {
+    // Sets digitPop to the population of each digit value, then
+    // converts to exclusive offsets.  Scatter is stable, so that each
+    // pass preserves the order established by its predecessors.
+    vector<size_t> digitPop(size_t(1) << radixBits);
+    for (auto index : idx) {
+      digitPop[(binIdx(index) >> shift) & digitMask]++;
+    }
+    size_t offset = 0;
+    for (auto & pop : digitPop) {
+      offset += exchange(pop, offset);
+    }
+    for (auto index : idx) {
+      idxBinned[digitPop[(binIdx(index) >> shift) & digitMask]++] = index;
+    }
+    idx.swap(idxBinned);
   }
 
-  return idxBinned;
+  return idx;
 }
 
 
@@ -21,6 +21,7 @@
 #include "typeparam.h"
 #include "sampledobs.h"
 #include "sample.h"
+#include "bagstore.h"
 
 #include <memory>
 #include <vector>
@@ -29,9 +30,20 @@ using namespace std;
 
 
 class Sampler {
-  // Experimental coarse-grained control of locality:  Not quite
-  // coding-to-cache, but almost.
-  static constexpr unsigned int locExp = 18;  // Log of locality threshold.
+  // Sample counting is bandwidth-bound unless the counts being
+  // incremented remain cache-resident.  Indices are therefore binned
+  // by their high-order bits, with bin width sized at run time to a
+  // share of the L2 cache.
+  static const unsigned int binExp;  // Log of bin width.
+  static constexpr unsigned int radixBits = 8; // Bits per binning pass.
+
+
+  /**
+     @brief Derives bin width from the cache size reported by the system.
+
+     @return log of the bin width.
+   */
+  static unsigned int cacheBinExp();
 
   const unsigned int nTree;
   const size_t nObs; // # training observations
@@ -40,7 +52,13 @@ class Sampler {
   const unique_ptr<struct Response> response;
   
   const vector<vector<class SamplerNux>> samples;
-  const unique_ptr<class BitMatrix> bagMatrix; // empty if training or prediction without bagging.
+
+  // Absolute rows are delta-encoded, hence recoverable only by prefix
+  // summation.  Checkpoints record the absolute row of every 2^checkExp-th
+  // sample, enabling random access and blockwise decoding.
+  static constexpr unsigned int checkExp = 6;
+  const vector<vector<IndexT>> rowCheck; // Per-tree checkpointed rows.
+  const unique_ptr<BagStore> bagStore; // Null if training or predicting without bagging.
 
   // Presampling only.
   vector<SamplerNux> sbCresc; // Crescent block.
@@ -48,11 +66,44 @@ class Sampler {
   vector<double> weightNoReplace; // Non-replacement weights.
   vector<size_t> coeffNoReplace; // Uniform non-replacement coefficients.
 
+  // Stratified presampling only.  Rows are grouped by stratum, either
+  // their category or, when weights take few distinct values, their
+  // weight.  Per-tree counts are either fixed or drawn by stratum mass.
+  static const unsigned int maxStrata; // Bound on distinct weight values stratified.
+  vector<size_t> strataRow; // Rows grouped by stratum.
+  vector<size_t> strataOrigin; // Per-stratum offset into 'strataRow', plus sup.
+  vector<double> strataWeight; // Per-row weight of each stratum, iff counts drawn.
+  vector<size_t> strataSamp; // Per-stratum sample count, iff fixed.
+  bool strataReplace; // Whether strata are sampled with replacement.
+
+  // Block presampling only.  Bags are drawn as runs of consecutive
+  // rows, so that staging reads the observations sequentially.
+  size_t blockSize; // Rows per block, or zero if drawn singly.
+
 
   /**
-     @brief Constructs bag according to encoding.
+     @brief Copies an arbitrary sequence of trees' samples into a new sampler.
+
+     Sample records are tree-relative, so no remapping is required.
+
+     @param treeRef pairs each output tree with its source sampler and index.
    */
-  unique_ptr<BitMatrix> bagRows(bool bagging);
+  static unique_ptr<Sampler> gather(const vector<pair<const Sampler*, unsigned int>>& treeRef);
+
+
+  /**
+     @brief Determines whether two samplers can contribute to a common forest.
+
+     @return true iff observation counts, bag sizes, bagging and training
+     response all agree.
+   */
+  bool conforms(const Sampler* other) const;
+
+
+  /**
+     @brief Builds the per-tree checkpoints over the delta-encoded rows.
+   */
+  static vector<vector<IndexT>> checkpoint(const vector<vector<SamplerNux>>& samples);
 
 
   /**
@@ -62,34 +113,106 @@ class Sampler {
 
      @return bin index.
    */
-  static constexpr unsigned int binIdx(IndexT idx) {
-    return idx >> locExp;
+  static inline size_t binIdx(size_t idx) {
+    return idx >> binExp;
   }
-  
+
 
   /**
-     @brief Bins a vector of indices for coarse locality.
+     @return width of count buffer sufficient for any bin.
+   */
+  size_t binWidth() const {
+    return min(nObs, size_t(1) << binExp);
+  }
+  
 
-     Equivalent to the first pass of a radix sort.
+  /**
+     @brief Orders indices by bin.
 
-     @param nObs specfies the maximum sampled index.
+     Least-significant-digit radix sort on the bin index, so that the
+     number of passes grows with the bin count only logarithmically.
 
      @param idx is an unordered vector of indices.
 
      @return binned version of index vector passed.
    */
-  static vector<size_t> binIndices(size_t nObs,
-				   const vector<size_t>& idx);
+  vector<size_t> binIndices(vector<size_t> idx) const;
 
 
   /**
-     @brief Tabulates a collection of indices by occurrence.
+     @brief Tabulates a collection of indices as run records, by bin.
 
-     @param sampleCount tabulates the occurrence count of each index.
+     @param sCount is a zero-valued buffer of length 'binWidth()',
+     restored to zero on exit.
 
-     @return vector of sample counts.
+     @return run records of the indices, in row order.
    */
-  vector<IndexT> countSamples(const vector<size_t>& idx);
+  vector<SamplerNux> countBinned(vector<size_t> idx,
+				 vector<IndexT>& sCount) const;
+
+
+  /**
+     @brief Draws a single tree's bag from the calling thread's stream.
+
+     @param sCount is a zero-valued buffer of length 'binWidth()',
+     restored to zero on exit.
+
+     @return run records of the bag, in row order.
+   */
+  vector<SamplerNux> sampleTree(vector<IndexT>& sCount) const;
+
+
+  /**
+     @brief Groups rows by weight, if weights take few distinct values.
+
+     @return true iff stratified.
+   */
+  bool stratifyWeight(const double weight[],
+		      bool replace);
+
+
+  /**
+     @brief Draws a tree's per-stratum counts in proportion to mass.
+
+     Without replacement, draws are successive:  each selects a stratum
+     by the mass remaining, as does Efraimidis-Spirakis row by row.
+   */
+  vector<size_t> strataCount() const;
+
+
+  /**
+     @brief Draws a tree's sample by stratum, uniformly within each.
+
+     @return sampled row indices, unordered.
+   */
+  vector<size_t> sampleStrata() const;
+
+
+  /**
+     @brief Draws a tree's bag as blocks of consecutive rows.
+
+     With replacement, blocks begin at uniformly-drawn rows and wrap
+     circularly.  Without, distinct blocks are drawn from a tiling at
+     a random circular offset.  The final block is truncated so that
+     the bag size is exact.
+
+     @return run records of the bag, in row order.
+   */
+  vector<SamplerNux> sampleBlocks() const;
+
+
+  /**
+     @brief Emits run records from a bin's counts, zeroing as it goes.
+
+     @param rowBase is the row corresponding to the buffer's origin.
+
+     @param[in, out] rowPrev is the row of the most recent record.
+   */
+  void emitNux(vector<IndexT>& sCount,
+	       size_t rowBase,
+	       size_t extent,
+	       IndexT& rowPrev,
+	       vector<SamplerNux>& nux) const;
   
 
 public:
@@ -150,6 +273,22 @@ public:
   void appendSamples(const vector<size_t>& idx);
 
 
+  /**
+     @brief Copies a subset of trees' samples, in the order specified.
+
+     @param treeIdx are the source indices, possibly repeated.
+   */
+  unique_ptr<Sampler> select(const vector<unsigned int>& treeIdx) const;
+
+
+  /**
+     @brief Concatenates samplers trained over a common response.
+
+     @return sampler consisting of each sampler's trees, in order.
+   */
+  static unique_ptr<Sampler> merge(const vector<const Sampler*>& samplers);
+
+
   const vector<SamplerNux>& getSamples(unsigned int tIdx) const {
     return samples[tIdx];
   }
@@ -181,10 +320,25 @@ public:
   size_t getBagCount(unsigned int tIdx) const {
     return samples[tIdx].size();
   }
+
+
+  /**
+     @brief Random-access lookup of a sample's absolute row.
+
+     Sums at most 2^checkExp - 1 deltas beyond the nearest checkpoint.
+   */
+  IndexT getRow(unsigned int tIdx,
+		IndexT sIdx) const {
+    IndexT row = rowCheck[tIdx][sIdx >> checkExp];
+    for (IndexT idx = (sIdx >> checkExp) << checkExp; idx != sIdx; idx++) {
+      row += samples[tIdx][idx + 1].getDelRow();
+    }
+    return row;
+  }
   
 
   bool isBagging() const {
-    return !bagMatrix->isEmpty();
+    return bagStore != nullptr;
   }
 
 
@@ -237,6 +391,29 @@ public:
   void setCoefficients(const double weight[],
 		       bool replace);
 
+
+  /**
+     @brief Samples a fixed count of rows from each category.
+
+     @param yCtg are the zero-based training categories.
+
+     @param ctgSamp are the per-category counts, summing to the bag size.
+   */
+  void setStrata(const vector<PredictorT>& yCtg,
+		 const vector<size_t>& ctgSamp,
+		 bool replace);
+
+
+  /**
+     @brief Samples rows in blocks of fixed size.
+
+     Intended for rows shuffled on ingest, for which block and row
+     sampling are equivalent in distribution.  Requires uniform weights.
+
+     @param blockSize_ is the number of rows per block:  < 2 samples rows singly.
+   */
+  void setBlocks(size_t blockSize_);
+
   
   /**
      @brief Samples a single tree's worth of observations.
@@ -244,6 +421,15 @@ public:
   void sample();
 
 
+  /**
+     @brief Samples the bags of all trees, in parallel.
+
+     Each tree draws from its own core stream, keyed by a single
+     front-end seed, so that bags do not depend upon thread count.
+   */
+  void sampleTrees();
+
+
   /**
      @brief Determines whether a given forest coordinate is bagged.
 
@@ -254,7 +440,15 @@ public:
      @return true iff bagging and the coordinate bit is set.
    */
   inline bool isBagged(unsigned int tIdx, size_t row) const {
-    return !bagMatrix->isEmpty() && bagMatrix->testBit(tIdx, row);
+    return bagStore != nullptr && bagStore->isBagged(row, tIdx);
+  }
+
+
+  /**
+     @return observation-major bag, null if not bagging.
+   */
+  const BagStore* getBag() const {
+    return bagStore.get();
   }
 
   
@@ -271,9 +465,9 @@ public:
   /**
      @brief Produces a vector of sampled rows.
 
-     @param tIdx is the absolute tree index.
+     Checkpointed blocks decode independently, hence in parallel.
 
-     tIdx is temporarily ignored, pending completion of presampling.
+     @param tIdx is the absolute tree index.
    */
   vector<IndexT> sampledRows(unsigned int tIdx) const;
 };
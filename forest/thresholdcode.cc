@@ -0,0 +1,84 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file thresholdcode.cc
+
+   @brief Methods for integer coding of numeric thresholds.
+
+   @author Mark Seligman
+ */
+
+#include "thresholdcode.h"
+#include "forest.h"
+#include "rleframe.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+unique_ptr<ThresholdCode> ThresholdCode::factory(const Forest* forest,
+						 PredictorT nPred) {
+  vector<vector<double>> threshold = collect(forest, nPred);
+  for (auto & predThresh : threshold) {
+    if (predThresh.size() >= CodeNode::nanCode) // Codes range to size.
+      return nullptr;
+  }
+
+  return make_unique<ThresholdCode>(forest, move(threshold));
+}
+
+
+vector<vector<double>> ThresholdCode::collect(const Forest* forest,
+					      PredictorT nPred) {
+  vector<vector<double>> threshold(nPred);
+  for (auto & node : forest->getNode()) {
+    if (!node.isTerminal()) {
+      threshold[node.getPredIdx()].push_back(node.getSplitNum());
+    }
+  }
+  for (auto & predThresh : threshold) {
+    sort(predThresh.begin(), predThresh.end());
+    predThresh.erase(unique(predThresh.begin(), predThresh.end()), predThresh.end());
+  }
+
+  return threshold;
+}
+
+
+ThresholdCode::ThresholdCode(const Forest* forest,
+			     vector<vector<double>> threshold_) :
+  threshold(move(threshold_)) {
+  for (auto & node : forest->getNode()) {
+    CodeNode cn = {node.getDelIdx(), 0, 0, 0};
+    if (cn.delIdx != 0) {
+      cn.predIdx = node.getPredIdx();
+      cn.code = encode(cn.predIdx, node.getSplitNum());
+      cn.nanTrue = node.advanceNum(nan("")) == cn.delIdx ? 1 : 0;
+    }
+    codeNode.push_back(cn);
+  }
+}
+
+
+void ThresholdCode::codeRanked(const RLEFrame* rleFrame) {
+  numCode = vector<vector<BinCodeT>>(threshold.size());
+  for (PredictorT numIdx = 0; numIdx < threshold.size(); numIdx++) {
+    for (auto val : rleFrame->numRanked[numIdx]) {
+      numCode[numIdx].push_back(encode(numIdx, val));
+    }
+  }
+}
+
+
+BinCodeT ThresholdCode::encode(PredictorT predIdx,
+			       double val) const {
+  if (isnan(val))
+    return CodeNode::nanCode;
+  const vector<double>& predThresh = threshold[predIdx];
+  return lower_bound(predThresh.begin(), predThresh.end(), val) - predThresh.begin();
+}
@@ -0,0 +1,134 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file thresholdcode.h
+
+   @brief Integer coding of numeric splitting thresholds.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_THRESHOLDCODE_H
+#define FOREST_THRESHOLDCODE_H
+
+#include "typeparam.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+typedef uint32_t BinCodeT;
+
+
+/**
+   @brief Compact numeric node comparing bin codes in place of values.
+
+   Codes are 32 bits wide, so that no predictor's thresholds exceed the
+   code range in practice.  The NaN sense is folded into the predictor
+   field, keeping nodes at twelve bytes.
+ */
+struct CodeNode {
+  static constexpr BinCodeT nanCode = UINT32_MAX; // Reserved for NaN.
+
+  IndexT delIdx; // Delta to true branch; zero iff terminal.
+  PredictorT predIdx : 31; // Splitting predictor.
+  PredictorT nanTrue : 1; // Whether NaN takes the true branch.
+  BinCodeT code; // Position of threshold within predictor's table.
+
+  /**
+     @brief Mirrors DecNode::advanceNum() in the coded domain.
+
+     @param rowCode is the coded row.
+
+     @return delta to next node, if nonterminal, else zero.
+   */
+  inline IndexT advance(const BinCodeT rowCode[]) const {
+    if (delIdx == 0)
+      return 0;
+    BinCodeT rc = rowCode[predIdx];
+    return delIdx + ((rc == nanCode ? nanTrue != 0 : rc <= code) ? 0 : 1);
+  }
+};
+
+
+/**
+   @brief Maps numeric values to the count of a predictor's distinct
+   thresholds lying strictly below.
+
+   As only threshold order matters, a value passes a split iff its code
+   does not exceed the code of the threshold itself.  Results are
+   therefore identical to those of the value-based walk.
+ */
+class ThresholdCode {
+  vector<vector<double>> threshold; // Sorted, distinct, per predictor.
+  vector<CodeNode> codeNode; // Parallels the forest's node arena.
+  vector<vector<BinCodeT>> numCode; // Ranked value codes, per predictor.
+
+  /**
+     @brief Collects the distinct thresholds of each predictor.
+   */
+  static vector<vector<double>> collect(const class Forest* forest,
+					PredictorT nPred);
+
+public:
+
+  /**
+     @brief Codes the forest's nodes.
+
+     @param threshold_ are the collected thresholds.
+   */
+  ThresholdCode(const class Forest* forest,
+		vector<vector<double>> threshold_);
+
+
+  /**
+     @brief Builds a coder if all tables are representable.
+
+     @param nPred is the number of (numeric) predictors.
+
+     @return coder, or null if some predictor has too many thresholds.
+   */
+  static unique_ptr<ThresholdCode> factory(const class Forest* forest,
+					   PredictorT nPred);
+
+
+  /**
+     @brief Codes the distinct values of a ranked frame, for lookup.
+   */
+  void codeRanked(const struct RLEFrame* rleFrame);
+
+
+  /**
+     @brief Ranks a value against a predictor's thresholds.
+   */
+  BinCodeT encode(PredictorT predIdx,
+		  double val) const;
+
+
+  /**
+     @brief Code lookup for the value of a ranked observation.
+
+     @param numIdx is the numeric predictor index.
+
+     @param rank is the observation's rank within the frame.
+   */
+  inline BinCodeT getCode(PredictorT numIdx,
+			  size_t rank) const {
+    return numCode[numIdx][rank];
+  }
+
+
+  /**
+     @return base of coded nodes for a tree.
+   */
+  const CodeNode* getTree(size_t origin) const {
+    return &codeNode[origin];
+  }
+};
+
+#endif
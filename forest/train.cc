@@ -18,73 +18,215 @@
 #include "predictorframe.h"
 #include "frontier.h"
 #include "pretree.h"
+#include "trainparam.h"
 #include "leaf.h"
 #include "sampler.h"
+#include "trainoob.h"
+#include "booster.h"
+#include "ompthread.h"
+#include "prng.h"
+#include "tracelog.h"
 
 #include <algorithm>
 
 
-unsigned int Train::trainBlock = 0;
+unique_ptr<Train> Train::train(const PredictorFrame* frame,
+			       const TrainParam* param,
+			       const Sampler* sampler,
+			       Forest* forest,
+			       const IndexRange& treeRange,
+			       Leaf* leaf,
+			       uint64_t seed,
+			       TrainOOB* trainOOB,
+			       Booster* booster) {
+  auto train = make_unique<Train>(frame, param, forest, trainOOB, booster);
+  train->trainChunk(frame, sampler, treeRange, leaf, seed);
 
-void Train::initBlock(unsigned int trainBlock_) {
-  trainBlock = trainBlock_;
+  return train;
 }
 
 
-void Train::deInit() {
-  trainBlock = 0;
-}
+vector<unique_ptr<Train>> Train::train(const PredictorFrame* frame,
+				       const vector<const TrainParam*>& param,
+				       const vector<const Sampler*>& sampler,
+				       const vector<Forest*>& forest,
+				       const vector<IndexRange>& treeRange,
+				       const vector<Leaf*>& leaf,
+				       const vector<uint64_t>& seed,
+				       const vector<TrainOOB*>& trainOOB) {
+  // Each session keys its own streams, as would a lone session.
+  vector<unique_ptr<Train>> trained;
+  vector<pair<unsigned int, unsigned int>> task; // Session, absolute tree.
+  for (unsigned int sessionIdx = 0; sessionIdx < param.size(); sessionIdx++) {
+    trained.emplace_back(make_unique<Train>(frame, param[sessionIdx], forest[sessionIdx], trainOOB[sessionIdx]));
+    for (unsigned int tIdx = treeRange[sessionIdx].getStart(); tIdx < treeRange[sessionIdx].getEnd(); tIdx++) {
+      task.emplace_back(sessionIdx, tIdx);
+    }
+  }
 
+  vector<unique_ptr<PreTree>> produced(task.size());
+  OmpNest nest(static_cast<unsigned int>(min(task.size(), static_cast<size_t>(OmpThread::nThread))));
+  OMPBound taskEnd = static_cast<OMPBound>(task.size());
+#pragma omp parallel for default(shared) schedule(dynamic, 1) num_threads(nest.nOuter)
+  for (OMPBound taskIdx = 0; taskIdx < taskEnd; taskIdx++) {
+    unsigned int sessionIdx = task[taskIdx].first;
+    PRNGLocal local(seed[sessionIdx], task[taskIdx].second);
+    produced[taskIdx] = Frontier::oneTree(frame, param[sessionIdx], sampler[sessionIdx], task[taskIdx].second);
+  }
 
-unique_ptr<Train> Train::train(const PredictorFrame* frame,
-			       const Sampler* sampler,
-			       Forest* forest,
-			       const IndexRange& treeRange,
-			       Leaf* leaf) {
-  auto train = make_unique<Train>(frame, forest);
-  train->trainChunk(frame, sampler, treeRange, leaf);
-  forest->splitUpdate(frame);
+  // Tasks are grouped by session, in tree order.
+  size_t taskIdx = 0;
+  for (unsigned int sessionIdx = 0; sessionIdx < param.size(); sessionIdx++) {
+    vector<unique_ptr<PreTree>> block;
+    for (IndexT tIdx = 0; tIdx < treeRange[sessionIdx].getExtent(); tIdx++) {
+      block.push_back(move(produced[taskIdx++]));
+    }
+    trained[sessionIdx]->reserve(sampler[sessionIdx], treeRange[sessionIdx], leaf[sessionIdx]);
+    trained[sessionIdx]->blockConsume(frame, block, treeRange[sessionIdx].getStart(), leaf[sessionIdx]);
+  }
 
-  return train;
+  return trained;
 }
 
 
 Train::Train(const PredictorFrame* frame,
-	     Forest* forest_) :
+	     const TrainParam* param_,
+	     Forest* forest_,
+	     TrainOOB* trainOOB_,
+	     Booster* booster_) :
+  param(param_),
   predInfo(vector<double>(frame->getNPred())),
-  forest(forest_) {
+  forest(forest_),
+  trainOOB(trainOOB_),
+  booster(booster_) {
 }
 
 
+Train::~Train() = default;
+
+
 void Train::trainChunk(const PredictorFrame* frame,
 		       const Sampler * sampler,
 		       const IndexRange& treeRange,
-		       Leaf* leaf) {
-  for (unsigned treeStart = treeRange.getStart(); treeStart < treeRange.getEnd(); treeStart += trainBlock) {
-    auto treeBlock = blockProduce(frame, sampler, treeStart, min(treeStart + trainBlock, static_cast<unsigned int>(treeRange.getEnd())));
-    blockConsume(treeBlock, leaf);
+		       Leaf* leaf,
+		       uint64_t seed) {
+  reserve(sampler, treeRange, leaf);
+  for (unsigned treeStart = treeRange.getStart(); treeStart < treeRange.getEnd(); treeStart += param->trainBlock) {
+    auto treeBlock = blockProduce(frame, sampler, seed, treeStart, min(treeStart + param->trainBlock, static_cast<unsigned int>(treeRange.getEnd())));
+    blockConsume(frame, treeBlock, treeStart, leaf);
+    screen(treeStart + treeBlock.size() - treeRange.getStart());
+  }
+}
+
+
+size_t Train::leafBound(const TrainParam* param,
+			size_t bagCount) {
+  size_t bound = bagCount;
+  if (param->totLevels > 0 && param->totLevels < 8 * sizeof(size_t) - 1)
+    bound = min(bound, static_cast<size_t>(1) << param->totLevels);
+  if (param->leafMax > 0)
+    bound = min(bound, static_cast<size_t>(param->leafMax));
+  return bound;
+}
+
+
+void Train::reserve(const Sampler* sampler,
+		    const IndexRange& treeRange,
+		    Leaf* leaf) const {
+  size_t bagSum = 0;
+  size_t leafSum = 0;
+  size_t nodeSum = 0;
+  for (IndexT tIdx = treeRange.getStart(); tIdx < treeRange.getEnd(); tIdx++) {
+    size_t bagCount = sampler->getBagCount(tIdx);
+    size_t leafTree = leafBound(param, bagCount);
+    bagSum += bagCount;
+    leafSum += leafTree;
+    nodeSum += nodeBound(leafTree);
+  }
+  forest->reserve(nodeSum, treeRange.getExtent());
+  leaf->reserve(bagSum, leafSum);
+}
+
+
+void Train::screen(unsigned int nConsumed) {
+  if (param->screenTrees != 0 && paramScreened == nullptr && nConsumed >= param->screenTrees) {
+    paramScreened = param->screen(predInfo);
+    param = paramScreened.get();
   }
 }
 
 
 vector<unique_ptr<PreTree>> Train::blockProduce(const PredictorFrame* frame,
 						const Sampler* sampler,
+						uint64_t seed,
 						unsigned int treeStart,
 						unsigned int treeEnd) const {
+  // Streams are indexed by absolute tree under the session's key,
+  // hence independent of chunking, blocking and thread count.
   vector<unique_ptr<PreTree>> block;
-  for (unsigned int tIdx = treeStart; tIdx < treeEnd; tIdx++) {
-    block.emplace_back(Frontier::oneTree(frame, sampler, tIdx));
+  if (booster != nullptr) { // Each tree fits its predecessors' residuals.
+    for (unsigned int tIdx = treeStart; tIdx < treeEnd; tIdx++) {
+      PRNGLocal local(seed, tIdx);
+      block.emplace_back(Frontier::oneTree(frame, param, booster->rootSample(tIdx)));
+      booster->consumeTree(block.back().get());
+    }
+    return block;
+  }
+  else if (param->levelSync && treeEnd - treeStart > 1) {
+    return Frontier::blockTrees(frame, param, sampler, seed, treeStart, treeEnd);
+  }
+  else if (param->treeThread <= 1 || treeEnd - treeStart <= 1) {
+    for (unsigned int tIdx = treeStart; tIdx < treeEnd; tIdx++) {
+      PRNGLocal local(seed, tIdx);
+      block.emplace_back(Frontier::oneTree(frame, param, sampler, tIdx));
+    }
+    return block;
+  }
+
+  block = vector<unique_ptr<PreTree>>(treeEnd - treeStart);
+  OmpNest nest(min(param->treeThread, static_cast<unsigned int>(block.size())));
+  OMPBound blockEnd = static_cast<OMPBound>(block.size());
+#pragma omp parallel for default(shared) schedule(dynamic, 1) num_threads(nest.nOuter)
+  for (OMPBound blockIdx = 0; blockIdx < blockEnd; blockIdx++) {
+    PRNGLocal local(seed, treeStart + blockIdx);
+    block[blockIdx] = Frontier::oneTree(frame, param, sampler, treeStart + blockIdx);
   }
 
   return block;
 }
 
  
-void Train::blockConsume(const vector<unique_ptr<PreTree>>& treeBlock,
+void Train::blockConsume(const PredictorFrame* frame,
+			 const vector<unique_ptr<PreTree>>& treeBlock,
+			 unsigned int treeStart,
 			 Leaf* leaf) {
+  TraceSpan traceSpan("consume", treeStart);
+  vector<size_t> nodeOrigin; // Crescent offset of each tree's nodes, plus sup.
+  unsigned int tIdx = treeStart;
   for (auto & pretree : treeBlock) {
+    TrainStat::Stamp start = TrainStat::now();
+    nodeOrigin.push_back(forest->getNodeCresc().size());
     pretree->consume(this, forest, leaf);
+    trainStat.tConsume += TrainStat::since(start);
+    trainStat.accum(pretree->getTrainStat());
+    if (trainOOB != nullptr) {
+      trainOOB->consumeTree(tIdx, pretree.get());
+    }
+    tIdx++;
+  }
+  nodeOrigin.push_back(forest->getNodeCresc().size());
+
+  TrainStat::Stamp start = TrainStat::now();
+  OMPBound blockEnd = treeBlock.size();
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+  for (OMPBound blockIdx = 0; blockIdx < blockEnd; blockIdx++) {
+    forest->splitUpdate(frame, nodeOrigin[blockIdx], nodeOrigin[blockIdx + 1]);
+  }
   }
+  leaf->packPending();
+  trainStat.tConsume += TrainStat::since(start);
 }
 
 
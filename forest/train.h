@@ -18,6 +18,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "decnode.h" // Algorithm-specific typedef.
 #include "forest.h"
@@ -29,10 +30,13 @@
    of the data and constructs forest, leaf and diagnostic structures.
 */
 class Train {
-  static unsigned int trainBlock; // Front-end defined buffer size. Unused.
-
+  const struct TrainParam* param; // Session parameters, possibly screened.
+  unique_ptr<struct TrainParam> paramScreened; // Owns screened parameters.
   vector<double> predInfo; // E.g., Gini gain:  nPred.
   class Forest* forest; // Crescent-state forest block.
+  class TrainOOB* trainOOB; // Out-of-bag accumulator, if tracking.
+  class Booster* booster; // Ensemble estimate, iff boosting.
+  TrainStat trainStat; // Instrumentation, over trees consumed.
 
 
   /**
@@ -41,11 +45,14 @@ class Train {
      @param frame summarizes the predictor characteristics.
 
      @param treeChunk is the number of trees in the chunk.
+
+     @param seed keys the per-tree streams.
   */
   void trainChunk(const class PredictorFrame* frame,
 		  const class Sampler* sampler,
 		  const IndexRange& treeRange,
-		  struct Leaf* leaf);
+		  struct Leaf* leaf,
+		  uint64_t seed);
   
 public:
 
@@ -53,7 +60,13 @@ public:
      @brief General constructor.
   */
   Train(const class PredictorFrame* frame,
-	class Forest* forest_);
+	const struct TrainParam* param_,
+	class Forest* forest_,
+	class TrainOOB* trainOOB_ = nullptr,
+	class Booster* booster_ = nullptr);
+
+
+  ~Train();
 
 
   /**
@@ -65,44 +78,152 @@ public:
     return predInfo;
   }
 
-  static void initBlock(unsigned int trainBlock_);
 
- 
+  const TrainStat& getTrainStat() const {
+    return trainStat;
+  }
+
+
+  /**
+     @brief Accrues time spent consuming a tree's terminals.
+   */
+  void consumeLeafTime(double seconds) {
+    trainStat.tLeaf += seconds;
+  }
+
+
   /**
-     @brief Static de-initializer.
+     @return accumulator for the threads consuming terminals.
    */
-  static void deInit();
+  struct LoadStat* leafLoad() {
+    return &trainStat.loadLeaf;
+  }
+
+  /**
+     @brief Bounds the leaf count of a single tree.
+
+     Each leaf holds at least one bagged sample.  If depth is limited,
+     no level exceeds twice the width of its predecessor.  A leaf limit,
+     if any, is enforced by merging.
+
+     @param bagCount is the tree's bag count.
+   */
+  static size_t leafBound(const struct TrainParam* param,
+			  size_t bagCount);
+
+
+  /**
+     @brief Bounds the node count of a binary tree having a given
+     number of leaves.
+   */
+  static size_t nodeBound(size_t leafBound) {
+    return leafBound == 0 ? 0 : 2 * leafBound - 1;
+  }
 
 
   /**
      @brief Main entry to training.
+
+     @param param holds the session's parameters.
+
+     @param seed keys the per-tree streams, as drawn by
+     PRNGLocal::sessionSeed() on the master thread.  Training itself
+     draws nothing from the front end, so may proceed off the master.
+
+     @param trainOOB accumulates out-of-bag estimates, if non-null.
+
+     @param booster fits each tree to its predecessors' residuals, if
+     non-null.
    */
   static unique_ptr<Train> train(const class PredictorFrame* frame,
+				 const struct TrainParam* param,
 				 const class Sampler* sampler,
 				 class Forest* forest_,
 				 const IndexRange& treeRange,
-				 struct Leaf* leaf);
+				 struct Leaf* leaf,
+				 uint64_t seed,
+				 class TrainOOB* trainOOB = nullptr,
+				 class Booster* booster = nullptr);
+
+
+  /**
+     @brief Trains a chunk of trees for each of several sessions
+     sharing a frame.
+
+     Trees of all sessions are scheduled as a single team, so that
+     small sessions do not leave threads idle.  Each session's trees
+     are consumed in order, as by the single-session entry.  Vector
+     arguments are indexed by session.
+
+     @param seed holds the per-session stream keys, common to all chunks.
+
+     @return per-session training summaries.
+   */
+  static vector<unique_ptr<Train>> train(const class PredictorFrame* frame,
+					 const vector<const struct TrainParam*>& param,
+					 const vector<const class Sampler*>& sampler,
+					 const vector<class Forest*>& forest,
+					 const vector<IndexRange>& treeRange,
+					 const vector<struct Leaf*>& leaf,
+					 const vector<uint64_t>& seed,
+					 const vector<class TrainOOB*>& trainOOB);
+
+
+  /**
+     @brief Reserves crescent forest and leaf space for a chunk of trees,
+     so that consumption does not reallocate.
+   */
+  void reserve(const class Sampler* sampler,
+	       const IndexRange& treeRange,
+	       struct Leaf* leaf) const;
 
 
   /**
      @brief Builds segment of decision forest for a block of trees.
 
+     Numeric splitting values are interpolated from ranks, and leaf
+     sample indices encoded, once the block is appended, tree-parallel.
+     Pre-trees retain their ranks.
+
      @param treeBlock is a vector of Sample, PreTree pairs.
+
+     @param treeStart is the absolute index of the block's first tree.
   */
-  void blockConsume(const vector<unique_ptr<PreTree>> &treeBlock,
+  void blockConsume(const class PredictorFrame* frame,
+		    const vector<unique_ptr<PreTree>> &treeBlock,
+		    unsigned int treeStart,
 		    struct Leaf* leaf);
 
 
   /**
      @brief  Creates a block of root samples and trains each one.
 
+     Each tree draws variates from its own core stream, so that
+     trees train concurrently when 'treeThread' exceeds unity, with
+     the thread budget divided among them.
+
+     @param seed keys the per-tree streams.
+
      @return Wrapped collection of Sample, PreTree pairs.
   */
   vector<unique_ptr<PreTree>> blockProduce(const class PredictorFrame* frame,
 					   const class Sampler* sampler,
+					   uint64_t seed,
 					   unsigned int treeStart,
 					   unsigned int treeEnd) const;
 
+  /**
+     @brief Screens out uninformative predictors once enough trees have
+     been consumed.
+
+     Subsequent blocks sample from the screened parameters.  Screening
+     is performed at most once per chunk.
+
+     @param nConsumed is the number of trees consumed by the chunk.
+   */
+  void screen(unsigned int nConsumed);
+
+
   /**
      @brief Accumulates per-predictor information values from trained tree.
    */
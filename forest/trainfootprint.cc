@@ -0,0 +1,121 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainfootprint.cc
+
+   @brief Bounds on the memory held by training structures.
+
+   @author Mark Seligman
+ */
+
+#include "trainfootprint.h"
+#include "predictorframe.h"
+#include "trainparam.h"
+#include "sampler.h"
+#include "train.h"
+#include "partition.h"
+#include "obs.h"
+#include "sampleidx.h"
+#include "samplenux.h"
+#include "stagedcell.h"
+#include "decnode.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+TrainFootprint::TrainFootprint(const PredictorFrame* frame,
+			       const TrainParam* param,
+			       const Sampler* sampler,
+			       bool boosting,
+			       unsigned int treeChunk,
+			       unsigned int nChunkLive_) :
+  frame(frame->getFootprint()),
+  obsPart(0),
+  history(0),
+  sampled(0),
+  preTree(0),
+  chunk(0),
+  nConcurrent(boosting ? 1 : (param->levelSync ? param->trainBlock : min(param->treeThread, param->trainBlock))),
+  trainBlock(boosting ? 1 : param->trainBlock),
+  nChunkLive(nChunkLive_),
+  historyFloor(0),
+  stageMap(0) {
+  // Per-tree terms are bounded by the largest bag.
+  size_t bagMax = 0;
+  for (unsigned int tIdx = 0; tIdx < sampler->getNTree(); tIdx++) {
+    bagMax = max(bagMax, sampler->getBagCount(tIdx));
+  }
+  size_t leafMax = Train::leafBound(param, bagMax);
+  size_t nodeMax = Train::nodeBound(leafMax);
+  PredictorT nPred = frame->getNPred();
+
+  size_t bufferSize = frame->getSafeSize(bagMax);
+  obsPart = 2 * bufferSize * (sizeof(Obs) + (bagMax <= ObsPart::narrowMax ? sizeof(NarrowIdxT) : sizeof(IndexT)));
+
+  // Each node of each retained layer may stage every predictor.
+  // A single layer holds no more nodes than leaves.
+  size_t historyMax = nodeMax * (nPred * sizeof(StagedCell) + sizeof(IndexRange));
+  historyFloor = leafMax * (nPred * sizeof(StagedCell) + sizeof(IndexRange));
+  stageMap = leafMax * nPred * sizeof(PredictorT);
+  history = (param->historyBudget > 0 ? min(historyMax, max(historyFloor, param->historyBudget)) : historyMax) + stageMap;
+
+  sampled = bagMax * (sizeof(SampleNux) + sizeof(IndexT)) + sampler->getNObs() * sizeof(IndexT);
+  preTree = nodeMax * (sizeof(DecNode) + 2 * sizeof(double));
+
+  // Chunks are bounded by their heaviest run of trees.
+  for (unsigned int treeStart = 0; treeStart < sampler->getNTree(); treeStart += treeChunk) {
+    size_t chunkThis = 0;
+    for (unsigned int tIdx = treeStart; tIdx < min(treeStart + treeChunk, sampler->getNTree()); tIdx++) {
+      size_t bagCount = sampler->getBagCount(tIdx);
+      size_t leafTree = Train::leafBound(param, bagCount);
+      chunkThis += Train::nodeBound(leafTree) * (sizeof(DecNode) + sizeof(double))
+	+ (bagCount + leafTree) * sizeof(IndexT);
+    }
+    chunk = max(chunk, chunkThis);
+  }
+}
+
+
+unsigned int TrainFootprint::recommendConcurrent(size_t budget,
+						 unsigned int nThread) const {
+  size_t fixed = frame + nChunkLive * chunk;
+  unsigned int concurrent = 1;
+  for (unsigned int nTry = 2; nTry <= max(1u, nThread); nTry++) {
+    if (fixed + nTry * (getPerTree() + preTree) > budget)
+      break;
+    concurrent = nTry;
+  }
+  return concurrent;
+}
+
+
+vector<string> TrainFootprint::fitBudget(TrainParam* param,
+					 size_t budget) {
+  vector<string> concession;
+  if (getTotal() > budget && nConcurrent > 1) {
+    unsigned int fit = recommendConcurrent(budget, nConcurrent);
+    concession.push_back("treeBlock lowered from " + to_string(trainBlock) + " to " + to_string(fit));
+    param->trainBlock = trainBlock = fit;
+    param->treeThread = min(param->treeThread, fit);
+    nConcurrent = fit;
+  }
+
+  if (getTotal() > budget && history - stageMap > historyFloor) {
+    size_t excess = getTotal() - budget;
+    size_t historyBudget = history - stageMap - min(history - stageMap - historyFloor, (excess + nConcurrent - 1) / nConcurrent);
+    concession.push_back("history bounded to " + to_string(historyBudget) + " bytes per tree");
+    param->historyBudget = historyBudget;
+    history = historyBudget + stageMap;
+  }
+
+  if (getTotal() > budget) {
+    throw runtime_error("Training requires at least " + to_string(getTotal()) + " bytes, exceeding budget of " + to_string(budget));
+  }
+  return concession;
+}
@@ -0,0 +1,110 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainfootprint.h
+
+   @brief Estimates the peak memory of a training session.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_TRAINFOOTPRINT_H
+#define FOREST_TRAINFOOTPRINT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Peak bytes held by the principal training structures.
+
+   Frames are measured; the remaining structures are bounded from the
+   bag counts and the tree-shape parameters, so that estimates are
+   conservative.  Per-tree terms are held once by each tree under
+   concurrent training.
+ */
+struct TrainFootprint {
+  size_t frame; // Observation and predictor frames, measured.
+  size_t obsPart; // Double-buffered partition, per tree.
+  size_t history; // Restaging history and stage map, per tree.
+  size_t sampled; // Sampled observations, per tree.
+  size_t preTree; // Pretree awaiting consumption, per block tree.
+  size_t chunk; // Crescent forest and leaf, per chunk in flight.
+  unsigned int nConcurrent; // # trees trained concurrently.
+  unsigned int trainBlock; // # trees produced per block.
+  unsigned int nChunkLive; // # chunks held at once.
+  size_t historyFloor; // History retaining a single layer, per tree.
+  size_t stageMap; // Unbudgeted portion of history, per tree.
+
+
+  /**
+     @brief Bounds the footprint of a session.
+
+     @param treeChunk is the number of trees per chunk.
+
+     @param nChunkLive is the number of chunks the front end holds at
+     once, as when consumption overlaps training.
+   */
+  TrainFootprint(const class PredictorFrame* frame,
+		 const struct TrainParam* param,
+		 const class Sampler* sampler,
+		 bool boosting,
+		 unsigned int treeChunk,
+		 unsigned int nChunkLive_);
+
+
+  /**
+     @return bytes attributable to each concurrent tree.
+   */
+  size_t getPerTree() const {
+    return obsPart + history + sampled;
+  }
+
+
+  /**
+     @return estimated peak bytes over the session.
+   */
+  size_t getTotal() const {
+    return frame + nConcurrent * getPerTree() + trainBlock * preTree + nChunkLive * chunk;
+  }
+
+
+  /**
+     @brief Chooses the most concurrent blocking fitting a budget.
+
+     @param budget is the number of bytes available.
+
+     @param nThread is the number of threads available.
+
+     @return number of trees to train concurrently, at least one.
+   */
+  unsigned int recommendConcurrent(size_t budget,
+				   unsigned int nThread) const;
+
+
+  /**
+     @brief Lowers concurrency, then the history budget, until the
+     footprint fits.
+
+     Narrow encodings are already selected wherever the bag admits
+     them, so are not revisited.
+
+     @param[in,out] param has its blocking and history budget lowered.
+
+     @return description of each concession made, in order.
+
+     Throws if the floor of the footprint exceeds the budget.
+   */
+  vector<string> fitBudget(struct TrainParam* param,
+			   size_t budget);
+};
+
+#endif
@@ -0,0 +1,125 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainoob.cc
+
+   @brief Methods accumulating out-of-bag prediction during training.
+
+   @author Mark Seligman
+ */
+
+#include "trainoob.h"
+#include "pretree.h"
+#include "predictorframe.h"
+#include "sampler.h"
+#include "response.h"
+#include "ompthread.h"
+
+#include <cmath>
+#include <numeric>
+
+
+TrainOOB::TrainOOB(const PredictorFrame* frame_,
+		   const Sampler* sampler_) :
+  frame(frame_),
+  sampler(sampler_),
+  responseReg(sampler->getResponse()->getNCtg() == 0 ? reinterpret_cast<const ResponseReg*>(sampler->getResponse()) : nullptr),
+  responseCtg(sampler->getResponse()->getNCtg() == 0 ? nullptr : reinterpret_cast<const ResponseCtg*>(sampler->getResponse())),
+  nObs(sampler->getNObs()),
+  nCtg(sampler->getResponse()->getNCtg()),
+  scoreSum(vector<double>(nCtg == 0 ? nObs : 0)),
+  census(vector<IndexT>(nObs * nCtg)),
+  nEst(vector<unsigned int>(nObs)) {
+}
+
+
+vector<unsigned char> TrainOOB::inBag(unsigned int tIdx) const {
+  vector<unsigned char> bagged(nObs);
+  IndexT row = 0;
+  for (IndexT sIdx = 0; sIdx != sampler->getBagCount(tIdx); sIdx++) {
+    row += sampler->getDelRow(tIdx, sIdx);
+    bagged[row] = 1;
+  }
+  return bagged;
+}
+
+
+void TrainOOB::consumeTree(unsigned int tIdx,
+			   const PreTree* pretree) {
+  vector<unsigned char> bagged = inBag(tIdx);
+
+  OMPBound rowEnd = static_cast<OMPBound>(nObs);
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(static)
+  for (OMPBound row = 0; row < rowEnd; row++) {
+    if (bagged[row] == 0) {
+      double score = pretree->scoreObs(frame, row);
+      nEst[row]++;
+      if (nCtg == 0)
+	scoreSum[row] += score;
+      else
+	census[row * nCtg + static_cast<PredictorT>(floor(score))]++;
+    }
+  }
+  }
+
+  errCurve.push_back(nCtg == 0 ? errorReg() : errorCtg());
+}
+
+
+double TrainOOB::errorReg() const {
+  const vector<double>& yTrain = responseReg->getYTrain();
+  double sse = 0.0;
+  size_t nTested = 0;
+  OMPBound rowEnd = static_cast<OMPBound>(nObs);
+#pragma omp parallel for default(shared) reduction(+ : sse, nTested) num_threads(OmpThread::nThread)
+  for (OMPBound row = 0; row < rowEnd; row++) {
+    if (nEst[row] > 0) {
+      double err = yTrain[row] - scoreSum[row] / nEst[row];
+      sse += err * err;
+      nTested++;
+    }
+  }
+
+  return nTested == 0 ? 0.0 : sse / nTested;
+}
+
+
+double TrainOOB::errorCtg() const {
+  size_t nMiss = 0;
+  size_t nTested = 0;
+  OMPBound rowEnd = static_cast<OMPBound>(nObs);
+#pragma omp parallel for default(shared) reduction(+ : nMiss, nTested) num_threads(OmpThread::nThread)
+  for (OMPBound row = 0; row < rowEnd; row++) {
+    if (nEst[row] > 0) {
+      const IndexT* censusRow = &census[row * nCtg];
+      PredictorT argMax = 0;
+      for (PredictorT ctg = 1; ctg < nCtg; ctg++) {
+	if (censusRow[ctg] > censusRow[argMax])
+	  argMax = ctg;
+      }
+      nMiss += argMax == responseCtg->getCtg(row) ? 0 : 1;
+      nTested++;
+    }
+  }
+
+  return nTested == 0 ? 0.0 : static_cast<double>(nMiss) / nTested;
+}
+
+
+bool TrainOOB::plateau(size_t window,
+		       double tolerance) const {
+  if (window == 0 || errCurve.size() < 2 * window)
+    return false;
+
+  auto trailEnd = errCurve.end();
+  double meanTrail = accumulate(trailEnd - window, trailEnd, 0.0) / window;
+  double meanPrev = accumulate(trailEnd - 2 * window, trailEnd - window, 0.0) / window;
+  return meanPrev - meanTrail < tolerance * meanPrev;
+}
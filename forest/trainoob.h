@@ -0,0 +1,108 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainoob.h
+
+   @brief Out-of-bag prediction accumulated during training.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_TRAINOOB_H
+#define FOREST_TRAINOOB_H
+
+#include "typeparam.h"
+
+#include <vector>
+
+
+/**
+   @brief Running out-of-bag estimates, updated as each tree is consumed.
+
+   Trees are consumed in increasing index, so the error after each tree
+   traces the out-of-bag error as a function of forest size.  Rows walk
+   in rank space, as criteria are not yet interpolated to values.
+ */
+class TrainOOB {
+  const class PredictorFrame* frame;
+  const class Sampler* sampler;
+  const class ResponseReg* responseReg; // Non-null iff regression.
+  const class ResponseCtg* responseCtg; // Non-null iff classification.
+  const size_t nObs;
+  const PredictorT nCtg; // Training cardinality, else zero.
+  vector<double> scoreSum; // Per-row sum of out-of-bag scores:  regression.
+  vector<IndexT> census; // Per-row out-of-bag votes:  classification.
+  vector<unsigned int> nEst; // Per-row # out-of-bag trees.
+  vector<double> errCurve; // Error after each consumed tree.
+
+
+  /**
+     @return per-row indicator of bag membership.
+   */
+  vector<unsigned char> inBag(unsigned int tIdx) const;
+
+
+  /**
+     @return mean squared error over rows estimated so far.
+   */
+  double errorReg() const;
+
+
+  /**
+     @return misprediction rate over rows estimated so far.
+   */
+  double errorCtg() const;
+
+public:
+
+  TrainOOB(const class PredictorFrame* frame_,
+	   const class Sampler* sampler_);
+
+
+  /**
+     @brief Updates estimates with the out-of-bag rows of a finalized tree.
+
+     @param tIdx is the absolute tree index.
+   */
+  void consumeTree(unsigned int tIdx,
+		   const class PreTree* pretree);
+
+
+  /**
+     @return error after each consumed tree.
+   */
+  const vector<double>& getErrCurve() const {
+    return errCurve;
+  }
+
+
+  /**
+     @brief Determines whether the error curve has levelled off.
+
+     Compares the mean error over the trailing window of trees with
+     that over the window preceding it.
+
+     @param window is the number of trees per window.
+
+     @param tolerance is the relative improvement below which to stop.
+
+     @return true iff both windows are filled and improvement falls short.
+   */
+  bool plateau(size_t window,
+	       double tolerance) const;
+
+
+  /**
+     @return current out-of-bag error.
+   */
+  double getError() const {
+    return errCurve.empty() ? 0.0 : errCurve.back();
+  }
+};
+
+#endif
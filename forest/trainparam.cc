@@ -0,0 +1,59 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainparam.cc
+
+   @brief Methods deriving session parameters.
+
+   @author Mark Seligman
+ */
+
+#include "trainparam.h"
+
+#include <algorithm>
+#include <numeric>
+
+
+void TrainParam::setWeighted(const vector<double>& prob) {
+  probSum = accumulate(prob.begin(), prob.end(), 0.0);
+  nPositive = count_if(prob.begin(), prob.end(), [](double weight) {return weight > 0.0;});
+  vector<double> probNorm(prob.size());
+  transform(prob.begin(), prob.end(), probNorm.begin(), [this](double weight) {return weight / probSum;});
+  walker = make_shared<const Sample::Walker<PredictorT>>(&probNorm[0], probNorm.size());
+}
+
+
+unique_ptr<TrainParam> TrainParam::screen(const vector<double>& predInfo) const {
+  auto screened = make_unique<TrainParam>(*this);
+  vector<double> probScreened(predInfo.size());
+  bool anyScreened = false;
+  bool anyInformed = false;
+  for (PredictorT predIdx = 0; predIdx != predInfo.size(); predIdx++) {
+    double prob = predProb.empty() ? 1.0 : predProb[predIdx];
+    if (predInfo[predIdx] > 0.0) {
+      probScreened[predIdx] = prob;
+      anyInformed = true;
+    }
+    else {
+      probScreened[predIdx] = prob * screenWeight;
+      anyScreened = true;
+    }
+  }
+
+  // Nothing to distinguish:  sampling unchanged.
+  if (!anyScreened || !anyInformed)
+    return screened;
+
+  screened->predProb = move(probScreened);
+  screened->probCommon = -1.0;
+  if (predFixed != 0 || walker != nullptr) {
+    screened->setWeighted(screened->predProb);
+  }
+
+  return screened;
+}
@@ -0,0 +1,117 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainparam.h
+
+   @brief Per-session training parameters.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_TRAINPARAM_H
+#define FOREST_TRAINPARAM_H
+
+#include "typeparam.h"
+#include "sample.h"
+
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+   @brief Parameters governing a single training session.
+
+   Formerly held as statics of the classes consulting them.  Held per
+   session, instead, so that sessions sharing a frame may train
+   concurrently.  Read-only once training begins.
+ */
+struct TrainParam {
+  // Predictor sampling:
+  PredictorT predFixed; // Fixed candidate count, else zero.
+  vector<double> predProb; // Per-predictor Bernoulli probability.
+  double probCommon; // Common value of 'predProb', else negative.
+  shared_ptr<const Sample::Walker<PredictorT>> walker; // Iff weighted mtry.
+  PredictorT nPositive; // # predictors of positive probability.
+  double probSum; // Expected per-node candidate count.
+  unsigned int screenTrees; // Trees trained before screening, if > 0.
+  double screenWeight; // Probability scale of screened predictors.
+
+  // Splitting:
+  IndexT minNode; // Minimal splitable index-set extent.
+  unsigned int totLevels; // Maximal tree depth, if > 0.
+  double minRatio; // Minimal ratio of successor to parent information.
+  vector<double> splitQuant; // Where within CDF to cut, by predictor.
+  vector<double> mono; // Numeric monotonicity constraints, if any.
+  size_t historyBudget; // Bytes permitted the restaging history, if > 0.
+  IndexT subtreeMax; // Extent trained depth-first as a subtree, if > 0.
+  bool extraTrees; // Evaluates a single random cut per candidate.
+  IndexT nCut; // Cuts evaluated per numeric scan, if > 0.
+  unsigned int nOut; // # regression responses split jointly, if > 0.
+  vector<double> yMulti; // Row-major joint responses, iff 'nOut' > 0.
+
+  // Tree shape:
+  IndexT leafMax; // Maximal # leaves, if > 0.
+  double pruneCost; // Cost-complexity penalty per leaf, if > 0.
+
+  // Blocking:
+  unsigned int trainBlock; // # trees per block.
+  unsigned int treeThread; // # trees trained concurrently.
+  bool levelSync; // Trains a block's trees in level lockstep.
+
+  /**
+     @brief Default values, as for a session with no user options.
+   */
+  TrainParam() :
+    predFixed(0),
+    probCommon(-1.0),
+    walker(nullptr),
+    nPositive(0),
+    probSum(0.0),
+    screenTrees(0),
+    screenWeight(1.0),
+    minNode(0),
+    totLevels(0),
+    minRatio(0.0),
+    historyBudget(0),
+    subtreeMax(0),
+    extraTrees(false),
+    nCut(0),
+    nOut(0),
+    leafMax(0),
+    pruneCost(0.0),
+    trainBlock(1),
+    treeThread(1),
+    levelSync(false) {
+  }
+
+
+  /**
+     @brief Builds the alias table for weighted predictor sampling.
+
+     @param prob are the per-predictor weights, not necessarily
+     normalized.
+   */
+  void setWeighted(const vector<double>& prob);
+
+
+  /**
+     @brief Derives the parameters for trees trained after screening.
+
+     Predictors having accrued no information have their sampling
+     weight scaled by 'screenWeight'.  Fixed-count sampling is then
+     performed by alias table, as the weights are no longer uniform.
+
+     @param predInfo is the per-predictor information accrued so far.
+
+     @return copy of this block with screened sampling weights.
+   */
+  unique_ptr<TrainParam> screen(const vector<double>& predInfo) const;
+};
+
+#endif
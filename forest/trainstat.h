@@ -0,0 +1,174 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file trainstat.h
+
+   @brief Per-phase timers and counters for training.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_TRAINSTAT_H
+#define FOREST_TRAINSTAT_H
+
+#include "historystat.h"
+#include "loadstat.h"
+
+#include <chrono>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+/**
+   @brief Instrumentation gathered per tree and accumulated over trees.
+
+   Timers are wall-clock seconds, read only by the thread driving a
+   tree's levels and so at level granularity:  the overhead is a few
+   clock reads per level.  Phases nest:  restaging is a part of
+   repartitioning and leaf consumption a part of consumption.
+ */
+struct TrainStat {
+  typedef chrono::steady_clock::time_point Stamp;
+
+  size_t nTree; // # trees summarized.
+  size_t nLevel; // # levels trained, over trees.
+
+  double tTree; // Tree production, in full.
+  double tRepartition; // InterLevel::repartition().
+  double tRestage; // Staging and restaging.
+  double tSplit; // SplitFrontier::split().
+  double tUpdate; // Sample-map update following splitting.
+  double tOverlap; // Successor production and InterLevel::overlap().
+  double tConsume; // PreTree::consume().
+  double tLeaf; // Leaf::consumeTerminals().
+  double tSubtree; // Subtree training and grafting.
+
+  size_t nCand; // # splitting candidates evaluated.
+  size_t nScanned; // # observation cells scanned by candidates.
+  size_t nRestaged; // # staged cells restaged.
+  size_t nSubtree; // # subtrees trained depth-first.
+
+  vector<double> occupancySum; // Mean history occupancy, by level, summed.
+  vector<size_t> occupancyCount; // # trees contributing, by level.
+
+  HistoryStat history; // Restaging-history use.
+
+  // Thread utilization, by parallel region:
+  LoadStat loadStage; // Root staging, by predictor.
+  LoadStat loadRestage; // Restaging, by ancestor.
+  LoadStat loadSplit; // Candidate splitting.
+  LoadStat loadUpdate; // Sample-map update, by node.
+  LoadStat loadLeaf; // Leaf::consumeTerminals().
+  LoadStat loadSubtree; // Subtree training, by subtree.
+
+  TrainStat() :
+    nTree(0),
+    nLevel(0),
+    tTree(0.0),
+    tRepartition(0.0),
+    tRestage(0.0),
+    tSplit(0.0),
+    tUpdate(0.0),
+    tOverlap(0.0),
+    tConsume(0.0),
+    tLeaf(0.0),
+    tSubtree(0.0),
+    nCand(0),
+    nScanned(0),
+    nRestaged(0),
+    nSubtree(0) {
+  }
+
+
+  static Stamp now() {
+    return chrono::steady_clock::now();
+  }
+
+
+  /**
+     @return seconds elapsed since a stamp.
+   */
+  static double since(const Stamp& start) {
+    return chrono::duration<double>(now() - start).count();
+  }
+
+
+  /**
+     @brief Records the mean occupancy of the history at a level.
+   */
+  void recordOccupancy(unsigned int level,
+		       double occupancy) {
+    if (occupancySum.size() <= level) {
+      occupancySum.resize(level + 1);
+      occupancyCount.resize(level + 1);
+    }
+    occupancySum[level] += occupancy;
+    occupancyCount[level]++;
+  }
+
+
+  /**
+     @brief Folds in the statistics of further trees.
+   */
+  void accum(const TrainStat& other) {
+    nTree += other.nTree;
+    nLevel += other.nLevel;
+    tTree += other.tTree;
+    tRepartition += other.tRepartition;
+    tRestage += other.tRestage;
+    tSplit += other.tSplit;
+    tUpdate += other.tUpdate;
+    tOverlap += other.tOverlap;
+    tConsume += other.tConsume;
+    tLeaf += other.tLeaf;
+    tSubtree += other.tSubtree;
+    nCand += other.nCand;
+    nScanned += other.nScanned;
+    nRestaged += other.nRestaged;
+    nSubtree += other.nSubtree;
+    if (occupancySum.size() < other.occupancySum.size()) {
+      occupancySum.resize(other.occupancySum.size());
+      occupancyCount.resize(other.occupancyCount.size());
+    }
+    for (size_t level = 0; level < other.occupancySum.size(); level++) {
+      occupancySum[level] += other.occupancySum[level];
+      occupancyCount[level] += other.occupancyCount[level];
+    }
+    history.accum(other.history);
+    loadStage.accum(other.loadStage);
+    loadRestage.accum(other.loadRestage);
+    loadSplit.accum(other.loadSplit);
+    loadUpdate.accum(other.loadUpdate);
+    loadLeaf.accum(other.loadLeaf);
+    loadSubtree.accum(other.loadSubtree);
+  }
+
+
+  /**
+     @brief Folds in the work of a subtree trained on the tree's behalf.
+
+     Levels and occupancy are subtree-relative, so are not folded.
+     Phase timers are summed over subtrees trained concurrently, and
+     so may exceed the subtree wall-clock time.
+   */
+  void accumSubtree(const TrainStat& sub) {
+    nSubtree++;
+    tRepartition += sub.tRepartition;
+    tRestage += sub.tRestage;
+    tSplit += sub.tSplit;
+    tUpdate += sub.tUpdate;
+    tOverlap += sub.tOverlap;
+    nCand += sub.nCand;
+    nScanned += sub.nScanned;
+    nRestaged += sub.nRestaged;
+    history.accum(sub.history);
+  }
+};
+
+#endif
@@ -17,7 +17,6 @@
 #include "treenode.h"
 #include "predictorframe.h"
 #include "bv.h"
-#include "predict.h"
 #include "splitnux.h"
 
 unsigned int TreeNode::rightBits = 0;
@@ -44,9 +43,10 @@ void TreeNode::critCut(const SplitNux& nux,
 
 
 void TreeNode::critBits(const SplitNux& nux,
-			size_t bitPos) {
+			size_t bitPos,
+			bool sparse) {
   setPredIdx(nux.getPredIdx());
-  criterion.critBits(bitPos);
+  criterion.critBits(bitPos, sparse);
 }
   
 
@@ -56,19 +56,3 @@ void TreeNode::setQuantRank(const PredictorFrame* frame) {
     criterion.setQuantRank(frame, predIdx);
   }
 }
-
-
-IndexT TreeNode::advanceMixed(const Predict* predict,
-			      const vector<unique_ptr<BV>>& factorBits,
-			      const CtgT* rowFT,
-			      const double* rowNT,
-			      unsigned int tIdx) const {
-  bool isFactor;
-  IndexT blockIdx = predict->getIdx(getPredIdx(), isFactor);
-  if (isFactor) {
-    return advanceFactor(factorBits[tIdx].get(), getBitOffset() + rowFT[blockIdx]);
-  }
-  else {
-    return advanceNum(rowNT[blockIdx]);
-  }
-}
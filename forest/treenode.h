@@ -91,6 +91,14 @@ public:
   }
 
 
+  /**
+     @return true iff missing values take the true branch.
+   */
+  inline bool getInvert() const {
+    return invert;
+  }
+
+
   inline void setPredIdx(PredictorT predIdx) {
     packed |= predIdx;
   }
@@ -106,8 +114,11 @@ public:
   }
 
 
+  /**
+     @brief Overwrites the delta, retaining the predictor.
+   */
   inline void setDelIdx(IndexT delIdx) {
-    packed |= (size_t(delIdx) << rightBits);
+    packed = (packed & rightMask) | (PackedT(delIdx) << rightBits);
   }
   
 
@@ -157,7 +168,8 @@ public:
 
 
   void critBits(const class SplitNux& nux,
-		size_t bitPos);
+		size_t bitPos,
+		bool sparse);
 
 
   /**
@@ -178,9 +190,38 @@ public:
   }
 
 
+  /**
+     @return true iff factor criterion is coded as a level list.
+   */
+  inline bool isSparse() const {
+    return criterion.isSparse();
+  }
+
+
+  /**
+     @brief Relocates the bits of a factor criterion, as when grafting.
+
+     @param bitBase is the slot-aligned offset applied.
+   */
+  inline void shiftBits(size_t bitBase) {
+    criterion.critBits(getBitOffset() + bitBase, isSparse());
+  }
+
+
+  /**
+     @return criterion in its context-free encoding.
+   */
+  inline double getCritVal() const {
+    return criterion.getVal();
+  }
+
+
   /**
      @brief Advances to next node when observations are all numerical.
 
+     Inversion alters only the routing of NaN, which takes the left
+     branch iff inverted.  Training sets the sense accordingly.
+
      @param rowT is a row base within the transposed numerical set.
 
      @param[out] leafIdx outputs predictor index iff at terminal.
@@ -198,11 +239,22 @@ public:
      Factor criteria are randomized during training, so inversion state may be
      ignored.
 
+     @param code is the observation's factor code.
+
      @return delta to branch target.
    */
   inline IndexT advanceFactor(const BV* bits,
-			      size_t bitOffset) const {
-    return delTest(bits->testBit(bitOffset));
+			      CtgT code) const {
+    return delTest(isSparse() ? bits->testList(getBitOffset(), code) : bits->testBit(getBitOffset() + code));
+  }
+
+
+  /**
+     @brief As above, but tests a tree's slots within the forest-wide pool.
+   */
+  inline IndexT advanceFactor(const BVSlotT treeBits[],
+			      CtgT code) const {
+    return delTest(isSparse() ? BV::testList(treeBits, getBitOffset(), code) : BV::testBit(treeBits, getBitOffset() + code));
   }
   
 
@@ -224,29 +276,10 @@ public:
   IndexT advanceFactor(const vector<unique_ptr<BV>>& factorBits,
 		       const CtgT rowFT[],
 		       unsigned int tIdx) const {
-    return advanceFactor(factorBits[tIdx].get(), getBitOffset() + rowFT[getPredIdx()]);
+    return advanceFactor(factorBits[tIdx].get(), rowFT[getPredIdx()]);
   }
 
 
-  /**
-     @brief Node advancer, as above, but for mixed observation.
-
-     Splitting for factor values is a set-membership relation.  Randomization
-     is implemented at training, making it unnecessary to read the inversion
-     sense.
-
-     Parameters as above, along with:
-
-     @param rowNT contains the transponsed numerical observations.
-
-     @return terminal/nonterminal : 0 / delta to next node.
-   */
-  IndexT advanceMixed(const class Predict* predict,
-		      const vector<unique_ptr<class BV>>& factorBits,
-		      const CtgT* rowFT,
-		      const double *rowNT,
-		      unsigned int tIdx) const;
-
   /**
      @brief Interplates split values from fractional intermediate rank.
 
@@ -0,0 +1,216 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file treeshap.cc
+
+   @brief Path-dependent TreeSHAP attribution over the forest's node arena.
+
+   @author Mark Seligman
+ */
+
+#include "treeshap.h"
+#include "forest.h"
+#include "ompthread.h"
+
+#include <algorithm>
+
+
+TreeShap::TreeShap(const Forest* forest,
+		   const Leaf* leaf,
+		   PredictorT nPredNum_,
+		   PredictorT nPredFac,
+		   unsigned int nCtg,
+		   size_t nRow) :
+  decNode(forest->getNode()),
+  nodeOrigin(forest->getNodeOrigin()),
+  scoreBlock(forest->getTreeScores()),
+  bitPool(forest->getBitPool()),
+  bitOrigin(forest->getBitOrigin()),
+  nTree(forest->getNTree()),
+  nPredNum(nPredNum_),
+  nPred(nPredNum_ + nPredFac),
+  nOut(nCtg == 0 ? 1 : nCtg),
+  ctg(nCtg > 0),
+  cover(forest->getIndex().getCover(leaf)),
+  pathDepth(0),
+  base(nOut),
+  attribution(nRow * nPred * nOut) {
+  setBase();
+}
+
+
+void TreeShap::setBase() {
+  vector<unsigned int> depth(decNode.size());
+  unsigned int depthMax = 0;
+  for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+    size_t nodeStart = nodeOrigin[tIdx];
+    size_t nodeEnd = tIdx + 1 < nTree ? nodeOrigin[tIdx + 1] : decNode.size();
+    for (size_t nodeIdx = nodeStart; nodeIdx < nodeEnd; nodeIdx++) {
+      const DecNode& node = decNode[nodeIdx];
+      if (!node.isTerminal()) {
+	size_t trueIdx = nodeIdx + node.getDelIdx();
+	depth[trueIdx] = depth[trueIdx + 1] = depth[nodeIdx] + 1;
+      }
+      else {
+	depthMax = max(depthMax, depth[nodeIdx]);
+	double rootCover = cover[nodeStart];
+	if (rootCover > 0.0) {
+	  for (unsigned int outIdx = 0; outIdx < nOut; outIdx++) {
+	    base[outIdx] += cover[nodeIdx] * leafValue(nodeIdx, outIdx) / rootCover;
+	  }
+	}
+      }
+    }
+  }
+  for (double& baseOut : base) {
+    baseOut /= max(1u, nTree);
+  }
+  pathDepth = depthMax + 2;
+}
+
+
+void TreeShap::attribute(const double* blockNum,
+			 const CtgT* blockFac,
+			 size_t rowStart,
+			 size_t span) {
+  OMPBound spanEnd = static_cast<OMPBound>(span);
+  size_t pathSize = (static_cast<size_t>(pathDepth) * (pathDepth + 1)) / 2;
+  double scale = 1.0 / max(1u, nTree);
+#pragma omp parallel default(shared) num_threads(max(1u, OmpThread::nThread))
+  {
+    vector<PathElt> path(pathSize);
+#pragma omp for schedule(dynamic, 1)
+    for (OMPBound rowIdx = 0; rowIdx < spanEnd; rowIdx++) {
+      const double* rowNT = blockNum == nullptr ? nullptr : blockNum + rowIdx * nPredNum;
+      const CtgT* rowFT = blockFac == nullptr ? nullptr : blockFac + rowIdx * (nPred - nPredNum);
+      double* phi = &attribution[(rowStart + rowIdx) * nPred * nOut];
+      for (unsigned int tIdx = 0; tIdx < nTree; tIdx++) {
+	recurse(tIdx, nodeOrigin[tIdx], rowNT, rowFT, &path[0], 0, 1.0, 1.0, nPred, phi);
+      }
+      for (size_t phiIdx = 0; phiIdx < nPred * nOut; phiIdx++) {
+	phi[phiIdx] *= scale;
+      }
+    }
+  }
+}
+
+
+void TreeShap::recurse(unsigned int tIdx,
+		       size_t nodeIdx,
+		       const double rowNT[],
+		       const CtgT rowFT[],
+		       PathElt* parentPath,
+		       unsigned int depth,
+		       double zeroFrac,
+		       double oneFrac,
+		       PredictorT predIdx,
+		       double phi[]) const {
+  PathElt* path = parentPath + depth + 1;
+  copy(parentPath, parentPath + depth + 1, path);
+  extendPath(path, depth, zeroFrac, oneFrac, predIdx);
+
+  const DecNode& node = decNode[nodeIdx];
+  if (node.isTerminal()) {
+    for (unsigned int pathIdx = 1; pathIdx <= depth; pathIdx++) {
+      const PathElt& elt = path[pathIdx];
+      double scale = unwoundSum(path, depth, pathIdx) * (elt.oneFrac - elt.zeroFrac);
+      double* phiPred = &phi[elt.predIdx * nOut];
+      if (ctg) {
+	unsigned int ctgLeaf = static_cast<unsigned int>(scoreBlock[nodeIdx]);
+	if (ctgLeaf < nOut)
+	  phiPred[ctgLeaf] += scale;
+      }
+      else {
+	phiPred[0] += scale * scoreBlock[nodeIdx];
+      }
+    }
+    return;
+  }
+
+  PredictorT splitIdx = node.getPredIdx();
+  IndexT delHot = splitIdx < nPredNum ? node.advanceNum(rowNT[splitIdx]) : node.advanceFactor(&bitPool[bitOrigin[tIdx]], rowFT[splitIdx - nPredNum]);
+  size_t hotIdx = nodeIdx + delHot;
+  size_t coldIdx = nodeIdx + (delHot == node.getDelIdx() ? delHot + 1 : node.getDelIdx());
+  double nodeCover = cover[nodeIdx];
+  double hotFrac = nodeCover > 0.0 ? cover[hotIdx] / nodeCover : 0.0;
+  double coldFrac = nodeCover > 0.0 ? cover[coldIdx] / nodeCover : 0.0;
+
+  // A repeated predictor is unwound, then re-extended at this split.
+  double inZero = 1.0;
+  double inOne = 1.0;
+  unsigned int pathIdx = 0;
+  while (pathIdx <= depth && path[pathIdx].predIdx != splitIdx)
+    pathIdx++;
+  if (pathIdx <= depth) {
+    inZero = path[pathIdx].zeroFrac;
+    inOne = path[pathIdx].oneFrac;
+    unwindPath(path, depth, pathIdx);
+    depth--;
+  }
+
+  recurse(tIdx, hotIdx, rowNT, rowFT, path, depth + 1, hotFrac * inZero, inOne, splitIdx, phi);
+  recurse(tIdx, coldIdx, rowNT, rowFT, path, depth + 1, coldFrac * inZero, 0.0, splitIdx, phi);
+}
+
+
+void TreeShap::extendPath(PathElt* path,
+			  unsigned int depth,
+			  double zeroFrac,
+			  double oneFrac,
+			  PredictorT predIdx) {
+  path[depth] = PathElt{predIdx, zeroFrac, oneFrac, depth == 0 ? 1.0 : 0.0};
+  for (unsigned int idx = depth; idx-- > 0; ) {
+    path[idx + 1].weight += oneFrac * path[idx].weight * (idx + 1) / (depth + 1);
+    path[idx].weight = zeroFrac * path[idx].weight * (depth - idx) / (depth + 1);
+  }
+}
+
+
+void TreeShap::unwindPath(PathElt* path,
+			  unsigned int depth,
+			  unsigned int pathIdx) {
+  double oneFrac = path[pathIdx].oneFrac;
+  double zeroFrac = path[pathIdx].zeroFrac;
+  double nextOne = path[depth].weight;
+  for (unsigned int idx = depth; idx-- > 0; ) {
+    if (oneFrac != 0.0) {
+      double weight = path[idx].weight;
+      path[idx].weight = nextOne * (depth + 1) / ((idx + 1) * oneFrac);
+      nextOne = weight - path[idx].weight * zeroFrac * (depth - idx) / (depth + 1);
+    }
+    else {
+      path[idx].weight = path[idx].weight * (depth + 1) / (zeroFrac * (depth - idx));
+    }
+  }
+  for (unsigned int idx = pathIdx; idx < depth; idx++) {
+    path[idx].predIdx = path[idx + 1].predIdx;
+    path[idx].zeroFrac = path[idx + 1].zeroFrac;
+    path[idx].oneFrac = path[idx + 1].oneFrac;
+  }
+}
+
+
+double TreeShap::unwoundSum(const PathElt* path,
+			    unsigned int depth,
+			    unsigned int pathIdx) {
+  double oneFrac = path[pathIdx].oneFrac;
+  double zeroFrac = path[pathIdx].zeroFrac;
+  double nextOne = path[depth].weight;
+  double total = 0.0;
+  for (unsigned int idx = depth; idx-- > 0; ) {
+    if (oneFrac != 0.0) {
+      double weight = nextOne * (depth + 1) / ((idx + 1) * oneFrac);
+      total += weight;
+      nextOne = path[idx].weight - weight * zeroFrac * (depth - idx) / (depth + 1);
+    }
+    else if (zeroFrac != 0.0) {
+      total += path[idx].weight * (depth + 1) / (zeroFrac * (depth - idx));
+    }
+  }
+  return total;
+}
@@ -0,0 +1,179 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file treeshap.h
+
+   @brief Path-dependent TreeSHAP attribution over the forest's node arena.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_TREESHAP_H
+#define FOREST_TREESHAP_H
+
+#include "typeparam.h"
+#include "bv.h"
+#include "arena.h"
+#include "decnode.h"
+
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Attributes each row's forest output to its predictors.
+
+   Node cover is the number of training samples reaching the node,
+   taken from the leaf extents and summed toward the root.  The
+   path-dependent algorithm of Lundberg et al. then runs once per row
+   and tree, costing time proportional to the number of leaves and the
+   square of the depth.  Rows are attributed in parallel, each thread
+   owning its own path buffer.
+
+   Regression attributes the score.  Classification attributes the
+   vote fraction of each training category.
+ */
+class TreeShap {
+  /**
+   @brief Element of the unique path from the root to a node.
+   */
+  struct PathElt {
+    PredictorT predIdx; ///> Core predictor splitting, or nPred at root.
+    double zeroFrac; ///> Fraction of cover flowing along the path.
+    double oneFrac; ///> 1.0 iff the row follows the path, else 0.0.
+    double weight; ///> Permutation weight.
+  };
+
+  const Arena<DecNode>& decNode; ///> Forest-wide node arena.
+  const vector<size_t>& nodeOrigin; ///> Per-tree offsets into arena.
+  const Arena<double>& scoreBlock; ///> Scores, indexed as decNode.
+  const BVSlotT* bitPool; ///> Forest-wide factor bits.
+  const vector<size_t>& bitOrigin; ///> Per-tree offsets into bit pool.
+  const unsigned int nTree;
+  const PredictorT nPredNum;
+  const PredictorT nPred; ///> Core predictor count.
+  const unsigned int nOut; ///> # outputs:  categories, else one.
+  const bool ctg; ///> Whether attributing category votes.
+  const vector<double>& cover; ///> Training samples reaching node, from forest index.
+  unsigned int pathDepth; ///> Bound on path length, root included.
+  vector<double> base; ///> Expected forest output, by output.
+  vector<double> attribution; ///> Row x predictor x output, iff attributing.
+
+
+  /**
+     @brief Derives expected output and depth bound from the node cover.
+   */
+  void setBase();
+
+
+  /**
+     @return leaf value at a given output.
+   */
+  inline double leafValue(size_t nodeIdx,
+			  unsigned int outIdx) const {
+    return ctg ? (static_cast<unsigned int>(scoreBlock[nodeIdx]) == outIdx ? 1.0 : 0.0) : scoreBlock[nodeIdx];
+  }
+
+
+  /**
+     @brief Accumulates the attributions of a single tree.
+
+     @param depth is the number of elements on the path, exclusive.
+
+     @param[in, out] phi accumulates predictor x output attributions.
+   */
+  void recurse(unsigned int tIdx,
+	       size_t nodeIdx,
+	       const double rowNT[],
+	       const CtgT rowFT[],
+	       PathElt* path,
+	       unsigned int depth,
+	       double zeroFrac,
+	       double oneFrac,
+	       PredictorT predIdx,
+	       double phi[]) const;
+
+
+  /**
+     @brief Extends the path by a single split.
+   */
+  static void extendPath(PathElt* path,
+			 unsigned int depth,
+			 double zeroFrac,
+			 double oneFrac,
+			 PredictorT predIdx);
+
+
+  /**
+     @brief Removes an element from the path, undoing its extension.
+   */
+  static void unwindPath(PathElt* path,
+			 unsigned int depth,
+			 unsigned int pathIdx);
+
+
+  /**
+     @return total permutation weight were an element unwound.
+   */
+  static double unwoundSum(const PathElt* path,
+			   unsigned int depth,
+			   unsigned int pathIdx);
+
+public:
+
+  /**
+     @param nCtg is the training cardinality, zero iff regression.
+
+     @param nRow is the number of rows to be attributed.
+   */
+  TreeShap(const class Forest* forest,
+	   const struct Leaf* leaf,
+	   PredictorT nPredNum_,
+	   PredictorT nPredFac,
+	   unsigned int nCtg,
+	   size_t nRow);
+
+
+  /**
+     @brief Attributes a transposed block of rows.
+
+     @param blockNum is the block's numeric observations, row-major.
+
+     @param blockFac is the block's factor observations, " ".
+
+     @param rowStart is the absolute row at which the block begins.
+   */
+  void attribute(const double* blockNum,
+		 const CtgT* blockFac,
+		 size_t rowStart,
+		 size_t span);
+
+
+  /**
+     @return attributions, row x core predictor x output.
+   */
+  const vector<double>& getAttribution() const {
+    return attribution;
+  }
+
+
+  /**
+     @return expected forest output, by output.
+   */
+  const vector<double>& getBase() const {
+    return base;
+  }
+
+
+  unsigned int getNOut() const {
+    return nOut;
+  }
+};
+
+#endif
@@ -0,0 +1,303 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file walker.cc
+
+   @brief Methods for the alternate traversal engines.
+
+   @author Mark Seligman
+ */
+
+#include "walker.h"
+#include "predict.h"
+#include "forest.h"
+#include "ompthread.h"
+
+#include <algorithm>
+
+
+/**
+   @brief Invokes a compiled walker, whose terminals are 32-bit.
+
+   Terminals of matching width are written in place.
+ */
+static inline void walkCompiledRow(CompiledWalk compiledWalk,
+				   const double* rowNT,
+				   const CtgT* rowFT,
+				   unsigned int leafOut[],
+				   unsigned int) {
+  compiledWalk(rowNT, rowFT, leafOut);
+}
+
+
+/**
+   @brief As above, but widens the terminals through a buffer.
+ */
+template<typename idxType>
+static inline void walkCompiledRow(CompiledWalk compiledWalk,
+				   const double* rowNT,
+				   const CtgT* rowFT,
+				   idxType leafOut[],
+				   unsigned int nTree) {
+  vector<unsigned int> nodeOut(nTree);
+  compiledWalk(rowNT, rowFT, &nodeOut[0]);
+  copy(nodeOut.begin(), nodeOut.end(), leafOut);
+}
+
+
+Walker::Walker(Predict* predict_,
+	       const Forest* forest) :
+  predict(predict_),
+  nodeOrigin(forest->getNodeOrigin()),
+  bitPool(forest->getBitPool()),
+  bitOrigin(forest->getBitOrigin()) {
+}
+
+
+unique_ptr<Walker> Walker::factory(Predict* predict,
+				   const Forest* forest,
+				   PredictorT nPredNum,
+				   PredictorT nPredFac,
+				   bool quickScore,
+				   bool binCode,
+				   bool compact,
+				   CompiledWalk compiledWalk) {
+  if (compiledWalk != nullptr)
+    return make_unique<WalkCompiled>(predict, forest, compiledWalk);
+  if (quickScore && nPredFac == 0)
+    return make_unique<WalkQuick>(predict, forest, nPredNum);
+
+  unique_ptr<Walker> walker;
+  if (binCode && nPredFac == 0)
+    walker = WalkCode::factory(predict, forest, nPredNum);
+  if (!walker && compact)
+    walker = WalkCompact::factory(predict, forest, nPredNum, nPredFac);
+  return walker;
+}
+
+
+void Walker::walkRange(size_t rowStart,
+		       size_t rowEnd,
+		       unsigned int tStart,
+		       unsigned int tEnd) {
+  for (size_t row = rowStart; row != rowEnd; row++) {
+    walk(row, tStart, tEnd);
+  }
+}
+
+
+WalkQuick::WalkQuick(Predict* predict_,
+		     const Forest* forest,
+		     PredictorT nPredNum) :
+  Walker(predict_, forest),
+  quickScorer(make_unique<QuickScorer>(forest, nPredNum)),
+  quickBits(vector<vector<PackedT>>(max(1u, OmpThread::nThread), vector<PackedT>(quickScorer->getNSlot()))) {
+}
+
+
+void WalkQuick::walk(size_t row,
+		     unsigned int,
+		     unsigned int) {
+  quickScorer->walk(predict->baseNum(row), &quickBits[OmpThread::threadIdx()][0], predict->leafRow(row));
+  predict->maskBagged(row);
+}
+
+
+WalkCode::WalkCode(Predict* predict_,
+		   const Forest* forest,
+		   unique_ptr<ThresholdCode> thresholdCode_) :
+  Walker(predict_, forest),
+  thresholdCode(move(thresholdCode_)) {
+}
+
+
+unique_ptr<Walker> WalkCode::factory(Predict* predict,
+				     const Forest* forest,
+				     PredictorT nPredNum) {
+  unique_ptr<ThresholdCode> thresholdCode = ThresholdCode::factory(forest, nPredNum);
+  return thresholdCode ? make_unique<WalkCode>(predict, forest, move(thresholdCode)) : nullptr;
+}
+
+
+void WalkCode::walk(size_t row,
+		    unsigned int tStart,
+		    unsigned int tEnd) {
+  const BinCodeT* rowT = predict->baseCode(row);
+  for (unsigned int tIdx = predict->nextOOB(row, tStart, tEnd); tIdx < tEnd; tIdx = predict->nextOOB(row, tIdx + 1, tEnd)) {
+    const CodeNode* cTree = thresholdCode->getTree(nodeOrigin[tIdx]);
+    IndexT idx = 0;
+    IndexT delIdx = 0;
+    do {
+      delIdx = cTree[idx].advance(rowT);
+      idx += delIdx;
+    } while (delIdx != 0);
+    predict->predictLeaf(row, tIdx, idx);
+  }
+}
+
+
+void WalkCode::walkRange(size_t rowStart,
+			 size_t rowEnd,
+			 unsigned int tStart,
+			 unsigned int tEnd) {
+  size_t row = rowStart;
+  for (; row + Predict::laneWidth <= rowEnd; row += Predict::laneWidth) {
+    walkLanes(row, tStart, tEnd);
+  }
+  Walker::walkRange(row, rowEnd, tStart, tEnd);
+}
+
+
+void WalkCode::walkLanes(size_t rowStart,
+			 unsigned int tStart,
+			 unsigned int tEnd) {
+  constexpr unsigned int laneWidth = Predict::laneWidth;
+  const BinCodeT* rowT[laneWidth];
+  for (unsigned int lane = 0; lane < laneWidth; lane++) {
+    rowT[lane] = predict->baseCode(rowStart + lane);
+  }
+
+  for (unsigned int tIdx = tStart; tIdx < tEnd; tIdx++) {
+    const CodeNode* cTree = thresholdCode->getTree(nodeOrigin[tIdx]);
+    IndexT idx[laneWidth] = {0};
+    IndexT delAny;
+    do {
+      delAny = 0;
+      for (unsigned int lane = 0; lane < laneWidth; lane++) {
+	IndexT delIdx = cTree[idx[lane]].advance(rowT[lane]);
+	idx[lane] += delIdx;
+	delAny |= delIdx;
+      }
+    } while (delAny != 0);
+
+    for (unsigned int lane = 0; lane < laneWidth; lane++) {
+      if (!predict->isBagged(tIdx, rowStart + lane)) {
+	predict->predictLeaf(rowStart + lane, tIdx, idx[lane]);
+      }
+    }
+  }
+}
+
+
+WalkCompact::WalkCompact(Predict* predict_,
+			 const Forest* forest,
+			 unique_ptr<CompactForest> compactForest_) :
+  Walker(predict_, forest),
+  compactForest(move(compactForest_)) {
+}
+
+
+unique_ptr<Walker> WalkCompact::factory(Predict* predict,
+					const Forest* forest,
+					PredictorT nPredNum,
+					PredictorT nPredFac) {
+  unique_ptr<CompactForest> compactForest = CompactForest::factory(forest, nPredNum, nPredFac);
+  return compactForest ? make_unique<WalkCompact>(predict, forest, move(compactForest)) : nullptr;
+}
+
+
+void WalkCompact::walk(size_t row,
+		       unsigned int tStart,
+		       unsigned int tEnd) {
+  const double* rowNT = predict->nPredNum == 0 ? nullptr : predict->baseNum(row);
+  const CtgT* rowFT = predict->nPredFac == 0 ? nullptr : predict->baseFac(row);
+  for (unsigned int tIdx = predict->nextOOB(row, tStart, tEnd); tIdx < tEnd; tIdx = predict->nextOOB(row, tIdx + 1, tEnd)) {
+    const CompactNode* cTree = compactForest->getTree(nodeOrigin[tIdx]);
+    const BVSlotT* bits = bitPool + bitOrigin[tIdx];
+    IndexT idx = 0;
+    IndexT delIdx = 0;
+    do {
+      delIdx = compactForest->advance(cTree[idx], rowNT, rowFT, bits);
+      idx += delIdx;
+    } while (delIdx != 0);
+    predict->predictLeaf(row, tIdx, idx);
+  }
+}
+
+
+WalkDag::WalkDag(Predict* predict_,
+		 const Forest* forest,
+		 unique_ptr<ForestDag> forestDag_) :
+  Walker(predict_, forest),
+  forestDag(move(forestDag_)) {
+}
+
+
+unique_ptr<WalkDag> WalkDag::factory(Predict* predict,
+				     const Forest* forest,
+				     PredictorT nPredNum) {
+  unique_ptr<ForestDag> forestDag = ForestDag::factory(forest, nPredNum);
+  return forestDag ? make_unique<WalkDag>(predict, forest, move(forestDag)) : nullptr;
+}
+
+
+void WalkDag::walk(size_t row,
+		   unsigned int tStart,
+		   unsigned int tEnd) {
+  const double* rowNT = predict->nPredNum == 0 ? nullptr : predict->baseNum(row);
+  const CtgT* rowFT = predict->nPredFac == 0 ? nullptr : predict->baseFac(row);
+  for (unsigned int tIdx = predict->nextOOB(row, tStart, tEnd); tIdx < tEnd; tIdx = predict->nextOOB(row, tIdx + 1, tEnd)) {
+    predict->predictLeaf(row, tIdx, forestDag->walk(tIdx, rowNT, rowFT, bitPool + bitOrigin[tIdx]));
+  }
+}
+
+
+WalkCompiled::WalkCompiled(Predict* predict_,
+			   const Forest* forest,
+			   CompiledWalk compiledWalk_) :
+  Walker(predict_, forest),
+  compiledWalk(compiledWalk_) {
+}
+
+
+void WalkCompiled::walk(size_t row,
+			unsigned int,
+			unsigned int) {
+  const double* rowNT = predict->nPredNum == 0 ? nullptr : predict->baseNum(row);
+  const CtgT* rowFT = predict->nPredFac == 0 ? nullptr : predict->baseFac(row);
+  walkCompiledRow(compiledWalk, rowNT, rowFT, predict->leafRow(row), predict->nTree);
+  predict->maskBagged(row);
+}
+
+
+WalkSelect::WalkSelect(const Forest* forest_,
+		       bool calibrate_) :
+  selected(false),
+  walkShort(nullptr),
+  walkFull(nullptr),
+  calibrate(calibrate_),
+  forest(forest_) {
+}
+
+
+Walker* WalkSelect::admit(unique_ptr<Walker> walker) {
+  if (!walker)
+    return nullptr;
+  candidate.push_back(move(walker));
+  return candidate.back().get();
+}
+
+
+vector<Walker*> WalkSelect::getCandidates() const {
+  vector<Walker*> walkers;
+  for (const auto& walker : candidate) {
+    walkers.push_back(walker.get());
+  }
+  return walkers;
+}
+
+
+void WalkSelect::select(Walker* walkShort_,
+			Walker* walkFull_) {
+  walkShort = walkShort_;
+  walkFull = walkFull_;
+  selected = true;
+  candidate.erase(remove_if(candidate.begin(), candidate.end(), [this](const unique_ptr<Walker>& walker) {
+	return walker.get() != walkShort && walker.get() != walkFull;
+      }), candidate.end());
+}
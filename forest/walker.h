@@ -0,0 +1,345 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file walker.h
+
+   @brief Traversal engines walked in place of the typed decision nodes.
+
+   @author Mark Seligman
+ */
+
+#ifndef FOREST_WALKER_H
+#define FOREST_WALKER_H
+
+#include "typeparam.h"
+#include "bv.h"
+#include "quickscorer.h"
+#include "thresholdcode.h"
+#include "compactnode.h"
+#include "forestdag.h"
+
+#include <vector>
+#include <memory>
+
+
+/**
+   @brief Signature of a compiled forest walker, as emitted by ForestCompile.
+
+   Outputs the tree-relative terminal index reached in each tree by the
+   numeric and factor blocks of a single transposed row.  The emitted
+   signature is fixed, independent of the index width.
+ */
+typedef void (*CompiledWalk)(const double[], const CtgT[], unsigned int[]);
+
+
+/**
+   @brief Walks rows through an alternate encoding of the forest.
+
+   Each engine owns its encoding and scratch state, and records the
+   terminals reached through the Predict object it serves.  Predict
+   dispatches to the engine selected exactly as to its typed walkers.
+ */
+class Walker {
+protected:
+  class Predict* predict; // Recipient of terminals.
+  const vector<size_t>& nodeOrigin; // Per-tree offsets into node arena.
+  const BVSlotT* bitPool; // Forest-wide factor bits.
+  const vector<size_t>& bitOrigin; // Per-tree offsets into bit pool.
+
+public:
+  Walker(class Predict* predict_,
+	 const class Forest* forest);
+
+  virtual ~Walker() = default;
+
+
+  /**
+     @brief Selects the engine requested, if representable.
+
+     Compiled walkers take precedence, followed by QuickScorer, coded
+     values and compact nodes.
+
+     @return engine, else null to walk the typed nodes.
+   */
+  static unique_ptr<Walker> factory(class Predict* predict,
+				    const class Forest* forest,
+				    PredictorT nPredNum,
+				    PredictorT nPredFac,
+				    bool quickScore,
+				    bool binCode,
+				    bool compact,
+				    CompiledWalk compiledWalk);
+
+
+  /**
+     @brief Walks a single row over a range of trees.
+
+     @param row is the absolute row.
+
+     @param tStart is the first tree to walk.
+
+     @param tEnd is the sup of trees to walk.
+   */
+  virtual void walk(size_t row,
+		    unsigned int tStart,
+		    unsigned int tEnd) = 0;
+
+
+  /**
+     @brief Walks a range of rows, by row unless overridden.
+
+     @param rowEnd is the sup of the row range.
+
+     Remaining parameters as above.
+   */
+  virtual void walkRange(size_t rowStart,
+			 size_t rowEnd,
+			 unsigned int tStart,
+			 unsigned int tEnd);
+
+
+  /**
+     @return true iff trees may be walked individually, else every
+     tree is walked per row.
+   */
+  virtual bool isSelective() const {
+    return true;
+  }
+
+
+  /**
+     @return numeric coding applied at transposition, if any.
+   */
+  virtual ThresholdCode* getCoding() const {
+    return nullptr;
+  }
+
+
+  /**
+     @return name of the engine, for reporting.
+   */
+  virtual const char* getName() const = 0;
+};
+
+
+/**
+   @brief Bit-vector traversal, visiting every tree per row.
+ */
+class WalkQuick : public Walker {
+  const unique_ptr<QuickScorer> quickScorer; // Condition lists.
+  vector<vector<PackedT>> quickBits; // Per-thread leaf bits.
+
+public:
+  WalkQuick(class Predict* predict_,
+	    const class Forest* forest,
+	    PredictorT nPredNum);
+
+  void walk(size_t row,
+	    unsigned int tStart,
+	    unsigned int tEnd);
+
+  bool isSelective() const {
+    return false;
+  }
+
+  const char* getName() const {
+    return "quickScorer";
+  }
+};
+
+
+/**
+   @brief Walks bin codes in place of numeric values.
+ */
+class WalkCode : public Walker {
+  const unique_ptr<ThresholdCode> thresholdCode; // Coded nodes and cuts.
+
+  /**
+     @brief Walks 'laneWidth' consecutive rows through each tree in
+     lockstep.
+   */
+  void walkLanes(size_t rowStart,
+		 unsigned int tStart,
+		 unsigned int tEnd);
+
+public:
+  WalkCode(class Predict* predict_,
+	   const class Forest* forest,
+	   unique_ptr<ThresholdCode> thresholdCode_);
+
+  /**
+     @return engine iff the forest's cuts are codable, else null.
+   */
+  static unique_ptr<Walker> factory(class Predict* predict,
+				    const class Forest* forest,
+				    PredictorT nPredNum);
+
+  void walk(size_t row,
+	    unsigned int tStart,
+	    unsigned int tEnd);
+
+  void walkRange(size_t rowStart,
+		 size_t rowEnd,
+		 unsigned int tStart,
+		 unsigned int tEnd);
+
+  ThresholdCode* getCoding() const {
+    return thresholdCode.get();
+  }
+
+  const char* getName() const {
+    return "code";
+  }
+};
+
+
+/**
+   @brief Walks the eight-byte node encoding.
+ */
+class WalkCompact : public Walker {
+  const unique_ptr<CompactForest> compactForest; // Encoded nodes.
+
+public:
+  WalkCompact(class Predict* predict_,
+	      const class Forest* forest,
+	      unique_ptr<CompactForest> compactForest_);
+
+  /**
+     @return engine iff the forest is representable, else null.
+   */
+  static unique_ptr<Walker> factory(class Predict* predict,
+				    const class Forest* forest,
+				    PredictorT nPredNum,
+				    PredictorT nPredFac);
+
+  void walk(size_t row,
+	    unsigned int tStart,
+	    unsigned int tEnd);
+
+  const char* getName() const {
+    return "compact";
+  }
+};
+
+
+/**
+   @brief Walks the pool of shared subtrees.
+
+   Terminals are recorded as pool indices.
+ */
+class WalkDag : public Walker {
+  const unique_ptr<ForestDag> forestDag; // Pooled subtrees.
+
+public:
+  WalkDag(class Predict* predict_,
+	  const class Forest* forest,
+	  unique_ptr<ForestDag> forestDag_);
+
+  /**
+     @return engine iff pooling saves space, else null.
+   */
+  static unique_ptr<WalkDag> factory(class Predict* predict,
+				     const class Forest* forest,
+				     PredictorT nPredNum);
+
+  void walk(size_t row,
+	    unsigned int tStart,
+	    unsigned int tEnd);
+
+  const ForestDag* getDag() const {
+    return forestDag.get();
+  }
+
+  const char* getName() const {
+    return "dag";
+  }
+};
+
+
+/**
+   @brief Delegates to an externally-compiled forest.
+ */
+class WalkCompiled : public Walker {
+  const CompiledWalk compiledWalk; // Loaded walker.
+
+public:
+  WalkCompiled(class Predict* predict_,
+	       const class Forest* forest,
+	       CompiledWalk compiledWalk_);
+
+  void walk(size_t row,
+	    unsigned int tStart,
+	    unsigned int tEnd);
+
+  bool isSelective() const {
+    return false;
+  }
+
+  const char* getName() const {
+    return "compiled";
+  }
+};
+
+
+/**
+   @brief Candidate engines and the choices made among them, when the
+   walker is selected on engagement.
+
+   Null choices denote the typed walk.
+ */
+class WalkSelect {
+  vector<unique_ptr<Walker>> candidate; // Engines contending with the typed walk.
+  bool selected; // Whether the choice has been made.
+  Walker* walkShort; // Choice for short blocks.
+  Walker* walkFull; // Choice for full blocks.
+
+public:
+  const bool calibrate; // Whether selection times candidates, else profiles.
+  const class Forest* forest; // Source of candidate encodings.
+
+  WalkSelect(const class Forest* forest_,
+	     bool calibrate_);
+
+
+  /**
+     @brief Admits a candidate, if representable.
+
+     @return candidate admitted, else null.
+   */
+  Walker* admit(unique_ptr<Walker> walker);
+
+
+  /**
+     @return admitted candidates.
+   */
+  vector<Walker*> getCandidates() const;
+
+
+  /**
+     @brief Records the choices and releases the remaining candidates.
+   */
+  void select(Walker* walkShort_,
+	      Walker* walkFull_);
+
+
+  bool isSelected() const {
+    return selected;
+  }
+
+
+  /**
+     @return choice for a block of the given size.
+
+     @param isShort is true iff the block is shorter than a lane group.
+   */
+  Walker* getChoice(bool isShort) const {
+    return isShort ? walkShort : walkFull;
+  }
+};
+
+#endif
@@ -25,7 +25,26 @@ BranchSense::BranchSense(IndexT bagCount) :
 }
 
 
+void BranchSense::reset() {
+  if (dirty.size() < expl->getNSlot() / 2) {
+    for (size_t slot : dirty) {
+      expl->setSlot(slot, 0ul);
+      explTrue->setSlot(slot, BV::allOnes);
+    }
+  }
+  else {
+    expl->clear();
+    explTrue->saturate();
+  }
+  dirty.clear();
+}
+
+
 void BranchSense::set(IndexT idx, bool trueEncoding) {
+  BVSlotT mask;
+  size_t slot = BV::slotMask(idx, mask);
+  if (expl->getSlot(slot) == 0ul) // First write since reset, or cleared.
+    dirty.push_back(slot);
   expl->setBit(idx);
   if (!trueEncoding) {
     explTrue->setBit(idx, false);
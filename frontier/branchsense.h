@@ -21,14 +21,32 @@
 #include "typeparam.h"
 
 #include <memory>
+#include <vector>
 
+/**
+   @brief Records the branch sense of explicitly replayed samples.
+
+   The bits span the bag but, at depth, only the samples of live
+   nonterminals are written.  Slots are therefore logged as they are
+   first written, and reset restores only those, unless enough have
+   been written that a full sweep is cheaper.
+ */
 class BranchSense {
   unique_ptr<BV> expl;  // Whether index be explicitly replayed.
   unique_ptr<BV> explTrue;  // If expl set, whether sense is true or false; else undefined.
+  vector<size_t> dirty; // Slots of expl written since reset, possibly repeated.
 
 public:
   BranchSense(IndexT bagCount);
 
+
+  /**
+     @brief Restores the constructed state, for reuse by a further level.
+
+     Cost is proportional to the slots written, rather than to the bag.
+   */
+  void reset();
+
   /**
      @brief Determines whether sample be assigned to explTrue successor.
 
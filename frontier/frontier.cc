@@ -23,85 +23,244 @@
 #include "train.h"
 #include "splitfrontier.h"
 #include "interlevel.h"
-#include "ompthread.h"
+#include "taskpool.h"
 #include "branchsense.h"
+#include "trainparam.h"
+#include "bheap.h"
+#include "splitnux.h"
+#include "prng.h"
+#include "tracelog.h"
 
-unsigned int Frontier::totLevels = 0;
-
-void Frontier::immutables(unsigned int totLevels) {
-  Frontier::totLevels = totLevels;
+unique_ptr<PreTree> Frontier::oneTree(const PredictorFrame* frame,
+				      const TrainParam* param,
+                                      const Sampler* sampler,
+				      unsigned int tIdx) {
+  TraceSpan traceSpan("tree", tIdx);
+  return oneTree(frame, param, sampler->rootSample(tIdx));
 }
 
 
-void Frontier::deImmutables() {
-  totLevels = 0;
+unique_ptr<PreTree> Frontier::oneTree(const PredictorFrame* frame,
+				      const TrainParam* param,
+				      unique_ptr<SampledObs> rootObs) {
+  Frontier frontier(frame, param, move(rootObs));
+  return frontier.levels();
 }
 
 
-unique_ptr<PreTree> Frontier::oneTree(const PredictorFrame* frame,
-                                      const Sampler* sampler,
-				      unsigned int tIdx) {
-  Frontier frontier(frame, sampler, tIdx);
-  return frontier.levels();
+vector<unique_ptr<PreTree>> Frontier::blockTrees(const PredictorFrame* frame,
+						 const TrainParam* param,
+						 const Sampler* sampler,
+						 uint64_t seed,
+						 unsigned int treeStart,
+						 unsigned int treeEnd) {
+  TraceSpan traceSpan("tree block", treeStart);
+  // Each tree draws from its own stream, interleaved on this thread.
+  vector<unique_ptr<PRNGLocal>> stream;
+  vector<unique_ptr<Frontier>> block;
+  for (unsigned int tIdx = treeStart; tIdx < treeEnd; tIdx++) {
+    stream.emplace_back(make_unique<PRNGLocal>(seed, tIdx));
+    block.emplace_back(make_unique<Frontier>(frame, param, sampler->rootSample(tIdx)));
+    block.back()->rootStage();
+    stream.back()->park();
+  }
+
+  vector<vector<SplitNux>> sc(block.size());
+  vector<unsigned int> live(block.size());
+  iota(live.begin(), live.end(), 0);
+  unsigned int level = 0;
+  while (!live.empty()) {
+    TraceSpan levelSpan("level", level++);
+    vector<pair<unsigned int, IndexT>> task; // Block position, candidate.
+    vector<double> cost;
+    for (unsigned int blockIdx : live) {
+      stream[blockIdx]->resume();
+      sc[blockIdx] = block[blockIdx]->candidates();
+      stream[blockIdx]->park();
+      for (IndexT pos = 0; pos != sc[blockIdx].size(); pos++) {
+	if (!block[blockIdx]->splitFrontier->isGainable(sc[blockIdx][pos]))
+	  continue;
+	task.emplace_back(blockIdx, pos);
+	cost.push_back(block[blockIdx]->splitFrontier->splitCost(sc[blockIdx][pos]));
+      }
+    }
+
+    // Costliest first, block-wide, as within a single frontier.
+    vector<size_t> order(task.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&cost](size_t a, size_t b) {
+	return cost[a] > cost[b];
+      });
+    TrainStat::Stamp start = TrainStat::now();
+    TaskPool::parallelFor(order.size(), [&](OMPBound schedPos) {
+	unsigned int blockIdx = task[order[schedPos]].first;
+	IndexT pos = task[order[schedPos]].second;
+	block[blockIdx]->splitFrontier->evaluate(sc[blockIdx][pos], pos);
+      }, &block[live[0]]->trainStat.loadSplit, "split batch");
+    double tShare = TrainStat::since(start) / live.size();
+
+    vector<unsigned int> liveNext;
+    for (unsigned int blockIdx : live) {
+      stream[blockIdx]->resume();
+      block[blockIdx]->trainStat.tSplit += tShare;
+      block[blockIdx]->advance(sc[blockIdx]);
+      stream[blockIdx]->park();
+      if (!block[blockIdx]->frontierNodes.empty())
+	liveNext.push_back(blockIdx);
+    }
+    live = move(liveNext);
+  }
+
+  vector<unique_ptr<PreTree>> trees;
+  for (auto & frontier : block) {
+    trees.emplace_back(frontier->complete());
+  }
+  return trees;
 }
 
 
 Frontier::Frontier(const PredictorFrame* frame_,
-		   const Sampler* sampler,
-		   unsigned int tIdx) :
+		   const TrainParam* param_,
+		   unique_ptr<SampledObs> rootObs,
+		   unsigned int levelBase_,
+		   double rootInfo_) :
   frame(frame_),
-  sampledObs(sampler->rootSample(tIdx)),
+  param(param_),
+  sampledObs(move(rootObs)),
   bagCount(sampledObs->getBagCount()),
   nCtg(sampledObs->getNCtg()),
-  interLevel(make_unique<InterLevel>(frame, sampledObs.get(), this)),
-  pretree(make_unique<PreTree>(frame, bagCount)),
-  smTerminal(SampleMap(bagCount)) {
+  levelBase(levelBase_),
+  rootInfo(rootInfo_),
+  arena(&levelArena[0]),
+  interLevel(make_unique<InterLevel>(frame, sampledObs.get(), this, &trainStat)),
+  pretree(make_unique<PreTree>(frame, bagCount, param->leafMax, param->pruneCost)),
+  smTerminal(SampleMap(bagCount)),
+  branchSense(bagCount) {
 }
 
 
 unique_ptr<PreTree> Frontier::levels() {
-  sampledObs->setRanks(frame);
-  smNonterm = SampleMap(bagCount);
-  smNonterm.addNode(bagCount, 0);
-  iota(smNonterm.sampleIndex.begin(), smNonterm.sampleIndex.end(), 0);
-  frontierNodes.emplace_back(sampledObs.get());
+  grow();
+  return complete();
+}
+
+
+void Frontier::grow() {
+  rootStage();
   while (!frontierNodes.empty()) {
-    smNonterm = splitDispatch();
-    vector<IndexSet> frontierNext = produce();
-    interLevel->overlap(frontierNodes, frontierNext, getNonterminalEnd());
-    frontierNodes = move(frontierNext);
+    TraceSpan levelSpan("level", interLevel->getLevel());
+    CandType cand = restage();
+    TrainStat::Stamp start = TrainStat::now();
+    splitFrontier = SplitFactoryT::factory(this);
+    splitFrontier->split(cand, branchSense);
+    trainStat.tSplit += TrainStat::since(start);
+    produceLevel();
   }
+}
+
+
+void Frontier::rootStage() {
+  treeStart = TrainStat::now();
+  // Root map is dead by the time level one resets its arena.
+  smNonterm = SampleMap(bagCount, &levelArena[1]);
+  smNonterm.addNode(bagCount, 0);
+  iota(smNonterm.sampleIndex.begin(), smNonterm.sampleIndex.end(), 0);
+  frontierNodes.emplace_back(sampledObs.get(), param->minNode, rootInfo);
+}
+
+
+unique_ptr<PreTree> Frontier::complete() {
+  unsigned int subtreeLevel = graftSubtrees();
   pretree->setTerminals(move(smTerminal));
+  trainStat.nTree = 1;
+  trainStat.nLevel = max(interLevel->getLevel(), subtreeLevel);
+  trainStat.tTree = TrainStat::since(treeStart);
+  pretree->setTrainStat(trainStat);
 
   return move(pretree);
 }
 
 
-SampleMap Frontier::splitDispatch() {
+CandType Frontier::restage() {
   earlyExit(interLevel->getLevel());
+  handOff(interLevel->getLevel());
+
+  // Contents of the other arena remain live until the next level.
+  arena = &levelArena[interLevel->getLevel() & 1];
+  arena->reset();
+  branchSense.reset();
 
+  TraceSpan traceSpan("repartition", interLevel->getLevel());
+  TrainStat::Stamp start = TrainStat::now();
   CandType cand = interLevel->repartition(this);
+  trainStat.tRepartition += TrainStat::since(start);
+
+  return cand;
+}
+
+
+vector<SplitNux> Frontier::candidates() {
+  CandType cand = restage();
+  TrainStat::Stamp start = TrainStat::now();
   splitFrontier = SplitFactoryT::factory(this);
-  BranchSense branchSense(bagCount);
-  splitFrontier->split(cand, branchSense);
+  vector<SplitNux> sc = splitFrontier->candidates(cand);
+  trainStat.tSplit += TrainStat::since(start);
+  return sc;
+}
+
+
+void Frontier::advance(const vector<SplitNux>& sc) {
+  TrainStat::Stamp start = TrainStat::now();
+  splitFrontier->consume(sc, branchSense);
+  trainStat.tSplit += TrainStat::since(start);
+  produceLevel();
+}
+
+
+void Frontier::produceLevel() {
+  TrainStat::Stamp settleStart = TrainStat::now();
+  interLevel->settle();
+  trainStat.tRestage += TrainStat::since(settleStart);
+  smNonterm = splitDispatch();
+  TrainStat::Stamp start = TrainStat::now();
+  LevelVector<IndexSet> frontierNext = produce();
+  interLevel->overlap(frontierNodes, frontierNext, getNonterminalEnd());
+  frontierNodes = move(frontierNext);
+  trainStat.tOverlap += TrainStat::since(start);
+}
+
+
+SampleMap Frontier::splitDispatch() {
+  trainStat.nCand += splitFrontier->getNCand();
+  trainStat.nScanned += splitFrontier->getNScanned();
+
+  TrainStat::Stamp start = TrainStat::now();
   SampleMap smNext = surveySplits();
 
+  isolationGain = vector<double>(smNext.getNodeCount());
   ObsFrontier* cellFrontier = interLevel->getFront();
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound splitIdx = 0; splitIdx < frontierNodes.size(); splitIdx++) {
+  TaskPool::parallelFor(frontierNodes.size(), [&](OMPBound splitIdx) {
       setScore(splitIdx);
-      cellFrontier->updateMap(getNode(splitIdx), branchSense, smNonterm, smTerminal, smNext);
-    }
-  }
+      const IndexSet& iSet = getNode(splitIdx);
+      cellFrontier->updateMap(iSet, branchSense, smNonterm, smTerminal, smNext);
+      if (!iSet.isTerminal()) { // Successors bound their gain.
+	for (bool sense : {true, false}) {
+	  IndexT idxSucc = iSet.getIdxSucc(sense);
+	  const IndexT* sIdxSucc = &smNext.sampleIndex[smNext.range[idxSucc].getStart()];
+	  isolationGain[idxSucc] = sampledObs->isolationGain(smNext.range[idxSucc].getExtent(), [sIdxSucc](IndexT pos) {
+	      return sIdxSucc[pos];
+	    });
+	}
+      }
+    }, &trainStat.loadUpdate, "update");
+  trainStat.tUpdate += TrainStat::since(start);
 
   return smNext;
 }
 
 
 void Frontier::earlyExit(unsigned int level) {
-  if (level + 1 == totLevels) {
+  if (levelBase + level + 1 == param->totLevels || pretree->leafBudget() == 0) {
     for (auto & iSet : frontierNodes) {
       iSet.setUnsplitable();
     }
@@ -109,9 +268,94 @@ void Frontier::earlyExit(unsigned int level) {
 }
 
 
-vector<IndexSet> Frontier::produce() const {
-  vector<IndexSet> frontierNext;
-  for (auto iSet : frontierNodes) {
+void Frontier::handOff(unsigned int level) {
+  if (param->subtreeMax == 0 || param->leafMax != 0 || levelBase != 0 || level == 0)
+    return;
+
+  for (auto & iSet : frontierNodes) {
+    if (!iSet.isUnsplitable() && iSet.isGainable() && iSet.getExtent() <= param->subtreeMax) {
+      iSet.setUnsplitable();
+      handoff.push_back(Handoff{iSet.getPTId(), level, iSet.getMinInfo(), PRNGLocal::drawKey()});
+    }
+  }
+}
+
+
+unsigned int Frontier::graftSubtrees() {
+  if (handoff.empty())
+    return 0;
+
+  TrainStat::Stamp start = TrainStat::now();
+
+  // Handed-off nodes are terminal, so each owns a terminal range.
+  IndexT noHandoff = handoff.size();
+  vector<IndexT> ptHandoff(pretree->getHeight(), noHandoff);
+  for (IndexT hIdx = 0; hIdx != handoff.size(); hIdx++) {
+    ptHandoff[handoff[hIdx].ptId] = hIdx;
+  }
+
+  // Sample indices are sorted so that subsets enumerate in row order.
+  vector<vector<IndexT>> subSample(handoff.size());
+  for (IndexT termIdx = 0; termIdx != smTerminal.getNodeCount(); termIdx++) {
+    IndexT hIdx = ptHandoff[smTerminal.ptIdx[termIdx]];
+    if (hIdx != noHandoff) {
+      auto sIdx = smTerminal.sampleIndex.begin() + smTerminal.range[termIdx].getStart();
+      subSample[hIdx] = vector<IndexT>(sIdx, sIdx + smTerminal.range[termIdx].getExtent());
+      sort(subSample[hIdx].begin(), subSample[hIdx].end());
+    }
+  }
+
+  vector<Subtree> subtree(handoff.size());
+  TaskPool::parallelFor(handoff.size(), [&](OMPBound hIdx) {
+      TraceSpan traceSpan("subtree", hIdx);
+      PRNGLocal local(handoff[hIdx].key, 0);
+      Frontier frontier(frame, param, sampledObs->subset(subSample[hIdx]), handoff[hIdx].level, handoff[hIdx].minInfo);
+      frontier.grow();
+      subtree[hIdx] = Subtree{move(frontier.pretree), move(frontier.smTerminal), frontier.trainStat, frontier.interLevel->getLevel()};
+    }, &trainStat.loadSubtree, "subtree");
+
+  vector<vector<IndexT>> ptMap(handoff.size());
+  unsigned int subtreeLevel = 0;
+  for (IndexT hIdx = 0; hIdx != handoff.size(); hIdx++) {
+    ptMap[hIdx] = pretree->graft(frame, handoff[hIdx].ptId, subtree[hIdx].pretree.get());
+    trainStat.accumSubtree(subtree[hIdx].trainStat);
+    subtreeLevel = max(subtreeLevel, handoff[hIdx].level + subtree[hIdx].nLevel);
+  }
+
+  // Each handoff's range gives way to the terminal ranges of its
+  // subtree, whose positions index the handoff's samples.
+  SampleMap smGraft(smTerminal.sampleIndex.size());
+  for (IndexT termIdx = 0; termIdx != smTerminal.getNodeCount(); termIdx++) {
+    IndexT hIdx = ptHandoff[smTerminal.ptIdx[termIdx]];
+    if (hIdx == noHandoff) {
+      const IndexRange& range = smTerminal.range[termIdx];
+      auto sIdx = smTerminal.sampleIndex.begin() + range.getStart();
+      copy(sIdx, sIdx + range.getExtent(), smGraft.sampleIndex.begin() + smGraft.getEndIdx());
+      smGraft.addNode(range.getExtent(), smTerminal.ptIdx[termIdx]);
+    }
+    else {
+      const SampleMap& smSub = subtree[hIdx].smTerminal;
+      for (IndexT subIdx = 0; subIdx != smSub.getNodeCount(); subIdx++) {
+	const IndexRange& range = smSub.range[subIdx];
+	IndexT idxOut = smGraft.getEndIdx();
+	for (IndexT pos = range.getStart(); pos != range.getEnd(); pos++) {
+	  smGraft.sampleIndex[idxOut++] = subSample[hIdx][smSub.sampleIndex[pos]];
+	}
+	smGraft.addNode(range.getExtent(), ptMap[hIdx][smSub.ptIdx[subIdx]]);
+      }
+    }
+  }
+  smTerminal = move(smGraft);
+  trainStat.tSubtree += TrainStat::since(start);
+
+  return subtreeLevel;
+}
+
+
+LevelVector<IndexSet> Frontier::produce() const {
+  LevelVector<IndexSet> frontierNext{LevelAllocator<IndexSet>(arena)};
+  frontierNext.reserve(smNonterm.getNodeCount()); // Two per nonterminal.
+  for (const IndexSet& iSet : frontierNodes) {
     if (!iSet.isTerminal()) {
       frontierNext.emplace_back(this, iSet, true);
       frontierNext.emplace_back(this, iSet, false);
@@ -123,12 +367,14 @@ vector<IndexSet> Frontier::produce() const {
 
 
 SampleMap Frontier::surveySplits() {
-  SampleMap smNext;
+  SampleMap smNext(0, arena);
+  smNext.range.reserve(2 * frontierNodes.size());
+  smNext.ptIdx.reserve(2 * frontierNodes.size());
   for (auto & iSet : frontierNodes) {
     registerSplit(iSet, smNext);
   }
 
-  smNext.sampleIndex = vector<IndexT>(smNext.getEndIdx());
+  smNext.sampleIndex.resize(smNext.getEndIdx());
 
   return smNext;
 }
@@ -175,12 +421,13 @@ IndexT Frontier::getPTIdSucc(IndexT ptId, bool senseTrue) const {
 
 void Frontier::updateSimple(const vector<SplitNux>& nuxMax,
 			    BranchSense& branchSense) {
+  vector<bool> applied = leafSelect(nuxMax);
   IndexT splitIdx = 0;
   for (auto nux : nuxMax) {
-    if (!nux.noNux()) {
+    if (!nux.noNux() && applied[splitIdx]) {
       // splitUpdate() updates the runSet accumulators, so must
       // be invoked prior to updating the pretree's criterion state.
-      frontierNodes[splitIdx].update(splitFrontier->splitUpdate(nux, branchSense));
+      frontierNodes[splitIdx].update(splitFrontier->splitUpdate(nux, branchSense), param->minRatio);
       pretree->addCriterion(splitFrontier.get(), nux);
     }
     splitIdx++;
@@ -188,28 +435,42 @@ void Frontier::updateSimple(const vector<SplitNux>& nuxMax,
 }
 
 
-void Frontier::updateCompound(const vector<vector<SplitNux>>& nuxMax) {
-  pretree->consumeCompound(splitFrontier.get(), nuxMax);
+vector<bool> Frontier::leafSelect(const vector<SplitNux>& nuxMax) const {
+  vector<bool> applied(nuxMax.size(), true);
+  vector<IndexT> informative;
+  for (IndexT splitIdx = 0; splitIdx != nuxMax.size(); splitIdx++) {
+    if (!nuxMax[splitIdx].noNux())
+      informative.push_back(splitIdx);
+  }
+  IndexT budget = pretree->leafBudget();
+  if (informative.size() <= budget)
+    return applied;
+
+  // Min-heap keyed by negated information ranks by decreasing gain.
+  vector<BHPair<IndexT>> infoHeap(informative.size());
+  for (IndexT pos = 0; pos != informative.size(); pos++) {
+    PQueue::insert<IndexT>(&infoHeap[0], -nuxMax[informative[pos]].getInfo(), pos);
+  }
+  vector<IndexT> infoRank = PQueue::depopulate<IndexT>(&infoHeap[0], informative.size());
+  for (IndexT pos = 0; pos != informative.size(); pos++) {
+    applied[informative[pos]] = infoRank[pos] < budget;
+  }
+  return applied;
 }
 
 
-vector<double> Frontier::sumsAndSquares(vector<vector<double> >& ctgSum) {
-  vector<double> sumSquares(frontierNodes.size());
-
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound splitIdx = 0; splitIdx < frontierNodes.size(); splitIdx++) {
-      ctgSum[splitIdx] = frontierNodes[splitIdx].sumsAndSquares(sumSquares[splitIdx]);
-    }
-  }
-  return sumSquares;
+void Frontier::updateCompound(const vector<vector<SplitNux>>& nuxMax) {
+  pretree->consumeCompound(splitFrontier.get(), nuxMax);
 }
 
 
 SplitNux Frontier::candMax(IndexT splitIdx,
-			   const vector<SplitNux>& candV) const {
-  return frontierNodes[splitIdx].candMax(candV);
+			   const SplitNux& argMax) const {
+  const IndexSet& iSet = frontierNodes[splitIdx];
+  if (iSet.isUnsplitable()) // Pure categorical census:  no gain is genuine.
+    return SplitNux();
+
+  return iSet.isInformative(argMax) ? argMax : SplitNux();
 }
 
 
@@ -22,6 +22,9 @@
 #include "indexset.h"
 #include "typeparam.h"
 #include "stagedcell.h"
+#include "levelarena.h"
+#include "trainstat.h"
+#include "algparam.h"
 
 #include <algorithm>
 #include <vector>
@@ -31,21 +34,55 @@
    @brief The index sets associated with nodes at a single subtree level.
  */
 class Frontier {
-  static unsigned int totLevels;
+  /**
+     @brief Node handed off to be trained as a subtree.
+   */
+  struct Handoff {
+    IndexT ptId; // Pretree index of the node.
+    unsigned int level; // Depth of the node.
+    double minInfo; // Split threshold inherited by the node.
+    uint64_t key; // Keys the subtree's stream.
+  };
+
+
+  /**
+     @brief Products of a subtree's training, awaiting grafting.
+   */
+  struct Subtree {
+    unique_ptr<PreTree> pretree;
+    SampleMap smTerminal; // Indexed by position within the handoff.
+    TrainStat trainStat; // Work performed training the subtree.
+    unsigned int nLevel; // # levels trained.
+  };
+
   const class PredictorFrame* frame;
+  const struct TrainParam* param; // Session parameters.
   const unique_ptr<class SampledObs> sampledObs;
   const IndexT bagCount;
   const PredictorT nCtg;
-
-  vector<IndexSet> frontierNodes;
+  const unsigned int levelBase; // Depth of the root:  nonzero iff subtree.
+  const double rootInfo; // Split threshold of the root.
+  vector<Handoff> handoff; // Nodes deferred to depth-first training.
+
+  // Level-scoped state alternates between a pair of arenas, as the
+  // nodes and nonterminal map produced by one level are consumed by
+  // the next.  An arena is reset two levels after its last use.
+  LevelArena levelArena[2];
+  LevelArena* arena; // Arena for the current level.
+
+  LevelVector<IndexSet> frontierNodes;
+  TrainStat trainStat; // Instrumentation, passed to the pretree.
+  TrainStat::Stamp treeStart; // Onset of training.
   unique_ptr<class InterLevel> interLevel;
 
   unique_ptr<PreTree> pretree; // Augmented per frontier.
   
   SampleMap smTerminal; // Persistent terminal sample mapping:  crescent.
   SampleMap smNonterm; // Current nonterminal mapping.
+  vector<double> isolationGain; // Per successor:  bounds split gain.
 
   unique_ptr<class SplitFrontier> splitFrontier; // Per-level.
+  BranchSense branchSense; // Reset per level.
 
   /**
      @brief Determines splitability of frontier nodes just split.
@@ -68,6 +105,79 @@ class Frontier {
   SampleMap splitDispatch();
 
 
+  /**
+     @brief Sets up root node for level zero.
+   */
+  void rootStage();
+
+
+  /**
+     @brief Readies the level's partition for splitting.
+
+     @return candidate sampler for the level.
+   */
+  CandType restage();
+
+
+  /**
+     @brief Restages and draws the level's candidates, deferring their
+     evaluation to the caller.
+   */
+  vector<class SplitNux> candidates();
+
+
+  /**
+     @brief Consumes the level's evaluated candidates and produces the
+     next level.
+   */
+  void advance(const vector<class SplitNux>& sc);
+
+
+  /**
+     @brief Applies the level's splits and produces its successors.
+   */
+  void produceLevel();
+
+
+  /**
+     @brief Grafts any subtrees, then hands off the trained pretree
+     and its instrumentation.
+   */
+  unique_ptr<class PreTree> complete();
+
+
+  /**
+     @brief Splits level by level until the frontier is exhausted.
+   */
+  void grow();
+
+
+  /**
+     @brief Defers sufficiently small nodes to depth-first training.
+
+     A node whose extent fits 'subtreeMax' is made terminal here and
+     retrained afterward, by itself, as a subtree.  The subtree stages
+     a private copy of its samples, so its levels no longer traverse
+     the tree-wide partition, and subtrees train independently of one
+     another.  Not applied under a leaf budget, which orders splits
+     across the full level.
+
+     @param level is the zero-based tree depth.
+   */
+  void handOff(unsigned int level);
+
+
+  /**
+     @brief Trains the deferred subtrees and grafts them into place.
+
+     Each subtree is keyed by a variate drawn at handoff, so results
+     do not depend upon the order in which subtrees are trained.
+
+     @return depth reached by the deepest subtree, else zero.
+   */
+  unsigned int graftSubtrees();
+
+
   /**
      @brief Resets parameters for upcoming levl.
 
@@ -83,31 +193,35 @@ class Frontier {
    */
   void earlyExit(unsigned int level);
 
-public:
-
 
   /**
-     @brief Initializes static invariants.
+     @brief Selects the splits to apply within the leaf budget.
 
-     @param minNode_ is the minimum node size for splitting.
+     When the informative splits outnumber the pretree's remaining
+     leaf budget, only the most informative are applied, the remainder
+     becoming terminal.  Growth thereby honors 'leafMax' best-first
+     within each level, rather than by merging a fully-grown tree.
 
-     @param totLevels_ is the maximum number of levels to evaluate.
-  */
-  static void immutables(unsigned int totLevels);
+     @return per-node indicator of whether to apply the split.
+   */
+  vector<bool> leafSelect(const vector<class SplitNux>& nuxMax) const;
 
+public:
 
   /**
-     @brief Resets statics to default values.
-  */
-  static void deImmutables();
+     @brief Per-tree constructor.
 
+     @param rootObs is the tree's sampled response.
 
-  /**
-     @brief Per-tree constructor.  Sets up root node for level zero.
+     @param levelBase is the depth of the root within the full tree.
+
+     @param rootInfo is the root's split threshold.
   */
   Frontier(const class PredictorFrame* frame,
-	   const class Sampler* sampler,
-	   unsigned int tIdx);
+	   const struct TrainParam* param,
+	   unique_ptr<class SampledObs> rootObs,
+	   unsigned int levelBase = 0,
+	   double rootInfo = 0.0);
 
   
   /**
@@ -120,10 +234,41 @@ public:
     @return trained pretree object.
   */
   static unique_ptr<class PreTree> oneTree(const class PredictorFrame* frame,
+					   const struct TrainParam* param,
 					   const class Sampler* sampler,
 					   unsigned int tIdx);
 
 
+  /**
+     @brief As above, but trained against a response sampled by the
+     caller, as when boosting.
+   */
+  static unique_ptr<class PreTree> oneTree(const class PredictorFrame* frame,
+					   const struct TrainParam* param,
+					   unique_ptr<class SampledObs> rootObs);
+
+
+  /**
+     @brief Trains a block of trees in level-synchronous lockstep.
+
+     The frontiers of the block advance together, each keeping its own
+     partition and pretree, but the candidates of all are evaluated
+     within a single dispatch.  Levels near the root then expose the
+     parallelism of the block rather than that of a lone node.  Each
+     tree draws from its own stream, so results are as with oneTree().
+
+     @param seed keys the trees' streams.
+
+     @return trained pretrees, in tree order.
+   */
+  static vector<unique_ptr<class PreTree>> blockTrees(const class PredictorFrame* frame,
+						      const struct TrainParam* param,
+						      const class Sampler* sampler,
+						      uint64_t seed,
+						      unsigned int treeStart,
+						      unsigned int treeEnd);
+
+
   /**
      @brief Drives breadth-first splitting.
 
@@ -136,7 +281,7 @@ public:
   /**
      @brief Produces frontier nodes for next level.
    */
-  vector<IndexSet> produce() const;
+  LevelVector<IndexSet> produce() const;
 
   
   /**
@@ -161,7 +306,7 @@ public:
   IndexT getNonterminalEnd() const;
   
 
-  const vector<IndexSet>& getNodes() const {
+  const LevelVector<IndexSet>& getNodes() const {
     return frontierNodes;
   }
   
@@ -205,26 +350,17 @@ public:
 
 
   /**
-     @brief Visits all live indices, so likely worth parallelizing.
+     @brief Screens a node's maximal candidate by the node's information
+     threshold.
 
-     @param[out] ctgSum outputs the per-category sum of responses, per node.
-
-     @return category-summed squares of responses, per node.
-  */
-  vector<double> sumsAndSquares(vector<vector<double> >& ctgSum);
-
-  
-  /**
-     @brief Passes through to IndexSet method.
+     @param splitIdx is the node's index.
 
-     @param splitIdx could also be looked up from candV, if nonempty.
+     @param argMax is the node's maximal-information candidate.
 
-     @param candV contains splitting candidates associated with split index.
-
-     @return maximal- or zero-information candidate for split.
+     @return argMax if informative, else zero-information placeholder.
    */
   class SplitNux candMax(IndexT splitIdx,
-			 const vector<class SplitNux>& candV) const;
+			 const class SplitNux& argMax) const;
 
 
   IndexRange getNodeRange(IndexT nodeIdx) const {
@@ -237,9 +373,59 @@ public:
   }
 
 
+  /**
+     @param splitIdx is a successor's index within the nonterminal map.
+
+     @return gain of isolating the successor's samples.
+   */
+  double getIsolationGain(IndexT splitIdx) const {
+    return isolationGain[splitIdx];
+  }
+
+
   auto getFrame() const {
     return frame;
   }
+
+
+  /**
+     @return arena for the current level's transient state.
+   */
+  LevelArena* getArena() const {
+    return arena;
+  }
+
+
+  /**
+     @return the tree's instrumentation.
+   */
+  TrainStat* getTrainStat() {
+    return &trainStat;
+  }
+
+
+  /**
+     @return the tree's sampled observations.
+   */
+  const class SampledObs* getSampledObs() const {
+    return sampledObs.get();
+  }
+
+
+  /**
+     @return sample map of the nodes currently splitting.
+   */
+  const SampleMap& getNontermMap() const {
+    return smNonterm;
+  }
+
+
+  /**
+     @return parameters of the training session.
+   */
+  const struct TrainParam* getParam() const {
+    return param;
+  }
   
 
   /**
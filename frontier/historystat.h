@@ -0,0 +1,64 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file historystat.h
+
+   @brief Instrumentation of the restaging history.
+
+   @author Mark Seligman
+ */
+
+#ifndef FRONTIER_HISTORYSTAT_H
+#define FRONTIER_HISTORYSTAT_H
+
+#include <algorithm>
+#include <cstddef>
+
+using namespace std;
+
+/**
+   @brief Summarizes history use, per tree or accumulated over trees.
+
+   Flushes are counted by layer and ascribed to the first applicable
+   cause:  path width, sparse occupancy or memory budget.
+ */
+struct HistoryStat {
+  unsigned int depthMax; // Deepest history reached.
+  size_t footprintMax; // Peak bytes held by history and front.
+  size_t stageMax; // Peak staged-cell count, over layers.
+  double occupancyMin; // Least occupancy observed among layers.
+  size_t flushPath; // Layers flushed for path representability.
+  size_t flushSparse; // Layers flushed for low occupancy.
+  size_t flushBudget; // Layers flushed to meet the memory budget.
+
+  HistoryStat() :
+    depthMax(0),
+    footprintMax(0),
+    stageMax(0),
+    occupancyMin(1.0),
+    flushPath(0),
+    flushSparse(0),
+    flushBudget(0) {
+  }
+
+
+  /**
+     @brief Folds in the statistics of a further tree.
+   */
+  void accum(const HistoryStat& other) {
+    depthMax = max(depthMax, other.depthMax);
+    footprintMax = max(footprintMax, other.footprintMax);
+    stageMax = max(stageMax, other.stageMax);
+    occupancyMin = min(occupancyMin, other.occupancyMin);
+    flushPath += other.flushPath;
+    flushSparse += other.flushSparse;
+    flushBudget += other.flushBudget;
+  }
+};
+
+#endif
@@ -19,31 +19,24 @@
 #include "splitfrontier.h"
 #include "frontier.h"
 #include "path.h"
-
-IndexT IndexSet::minNode = 0;
-
-
-void IndexSet::immutables(IndexT minNode) {
-  IndexSet::minNode = minNode;
-}
-
-
-void IndexSet::deImmutables() {
-  minNode = 0;
-}
+#include "trainparam.h"
 
 /**
    @brief Root constructor:  some initialization from SampledObs.
  */
-IndexSet::IndexSet(const SampledObs* sample) :
+IndexSet::IndexSet(const SampledObs* sample,
+		   IndexT minNode,
+		   double minInfo_) :
   splitIdx(0),
   bufRange(IndexRange(0, sample->getBagCount())),
   sCount(sample->getNSamp()),
   sum(sample->getBagSum()),
   path(0),
   ptId(0),
-  ctgSum(sample->getCtgRoot()),
-  minInfo(0.0),
+  ctgSquares(ctgSquaresRoot(sample->getCtgRoot())),
+  ctgSum(sample->getCtgRoot().begin(), sample->getCtgRoot().end()),
+  isolationGain(sample->isolationGain(sample->getBagCount(), [](IndexT sIdx) { return sIdx; })),
+  minInfo(minInfo_),
   doesSplit(false),
   unsplitable(bufRange.getExtent() < minNode),
   idxNext(sample->getBagCount()),
@@ -51,7 +44,7 @@ IndexSet::IndexSet(const SampledObs* sample) :
   sCountTrue(0),
   sumTrue(0.0),
   trueEncoding(true),
-  ctgTrue(vector<SumCount>(ctgSum.size())),
+  ctgTrue(ctgSum.size()),
   trueExtinct(false),
   falseExtinct(false) {
 }
@@ -66,53 +59,54 @@ IndexSet::IndexSet(const Frontier *frontier,
   sum(pred.getSumSucc(trueBranch)),
   path(pred.getPathSucc(trueBranch)),
   ptId(pred.getPTIdSucc(frontier, trueBranch)),
-  ctgSum(trueBranch ? pred.ctgTrue : SumCount::minus(pred.ctgSum, pred.ctgTrue)),
+  ctgSquares(0.0),
+  ctgSum(ctgSucc(pred, trueBranch, frontier->getArena(), ctgSquares)),
+  isolationGain(frontier->getIsolationGain(splitIdx)),
   minInfo(pred.getMinInfo()),
   doesSplit(false),
-  unsplitable((bufRange.getExtent() < minNode) || (trueBranch && pred.trueExtinct) || (!trueBranch && pred.falseExtinct)),
+  unsplitable((bufRange.getExtent() < frontier->getParam()->minNode) || (trueBranch && pred.trueExtinct) || (!trueBranch && pred.falseExtinct)),
   idxNext(frontier->getBagCount()), // Inattainable.
   extentTrue(0),
   sCountTrue(0),
   sumTrue(0.0),
   trueEncoding(true),
-  ctgTrue(vector<SumCount>(ctgSum.size())),
+  ctgTrue(ctgSum.size(), SumCount(), LevelAllocator<SumCount>(frontier->getArena())),
   trueExtinct(false),
   falseExtinct(false) {
 }
 
 
-PathT IndexSet::getPathSucc(bool trueBranch) const {
-  return IdxPath::pathSucc(path, trueBranch);
+LevelVector<SumCount> IndexSet::ctgSucc(const IndexSet& pred,
+					bool trueBranch,
+					LevelArena* arena,
+					double& squares) {
+  LevelVector<SumCount> ctgOut{LevelAllocator<SumCount>(arena)};
+  ctgOut.reserve(pred.ctgSum.size());
+  squares = 0.0;
+  for (size_t ctg = 0; ctg < pred.ctgSum.size(); ctg++) {
+    ctgOut.push_back(trueBranch ? pred.ctgTrue[ctg] : SumCount::minus(pred.ctgSum[ctg], pred.ctgTrue[ctg]));
+    squares += ctgOut.back().sum * ctgOut.back().sum;
+  }
+  return ctgOut;
 }
 
 
-IndexT IndexSet::getPTIdSucc(const Frontier* frontier, bool trueBranch) const {
-  return frontier->getPTIdSucc(ptId, trueBranch);
+double IndexSet::ctgSquaresRoot(const vector<SumCount>& ctgRoot) {
+  double squares = 0.0;
+  for (const SumCount& sc : ctgRoot) {
+    squares += sc.sum * sc.sum;
+  }
+  return squares;
 }
 
 
-vector<double> IndexSet::sumsAndSquares(double& sumSquares) {
-  vector<double> sumOut(ctgSum.size());
-  sumSquares =  0.0;
-  for (PredictorT ctg = 0; ctg < ctgSum.size(); ctg++) {
-    unsplitable |= !ctgSum[ctg].splitable(sCount, sumOut[ctg]);
-    sumSquares += sumOut[ctg] * sumOut[ctg];
-  }
-
-  return sumOut;
+PathT IndexSet::getPathSucc(bool trueBranch) const {
+  return IdxPath::pathSucc(path, trueBranch);
 }
 
 
-SplitNux IndexSet::candMax(const vector<SplitNux>& candVec) const {
-  SplitNux argMaxNux;
-  for (auto cand : candVec) {
-    if (cand.maxInfo(argMaxNux))
-      argMaxNux = cand;
-  }
-  if (isInformative(argMaxNux))
-    return argMaxNux;
-  else
-    return SplitNux(); // zero-information placeholder.
+IndexT IndexSet::getPTIdSucc(const Frontier* frontier, bool trueBranch) const {
+  return frontier->getPTIdSucc(ptId, trueBranch);
 }
 
 
@@ -121,10 +115,13 @@ bool IndexSet::isInformative(const SplitNux& nux) const {
 }
 
 
-void IndexSet::update(const CritEncoding& enc) {
+void IndexSet::update(const CritEncoding& enc,
+		      double minRatio) {
   // trueEncoding:  Final state is most recent update.
   // minInfo:  REVISE as update
   doesSplit = true;
-  enc.getISetVals(sCountTrue, sumTrue, extentTrue, trueEncoding, minInfo);
-  SumCount::incr(ctgTrue, trueEncoding ? enc.scCtg : SumCount::minus(ctgSum, enc.scCtg));
+  enc.getISetVals(sCountTrue, sumTrue, extentTrue, trueEncoding, minInfo, minRatio);
+  for (size_t ctg = 0; ctg < ctgTrue.size(); ctg++) {
+    ctgTrue[ctg] += trueEncoding ? enc.scCtg[ctg] : SumCount::minus(ctgSum[ctg], enc.scCtg[ctg]);
+  }
 }
@@ -21,6 +21,7 @@
 #include "splitcoord.h"
 #include "sumcount.h"
 #include "branchsense.h"
+#include "levelarena.h"
 
 
 /**
@@ -29,18 +30,21 @@
    collections of sample indices. The two subnodes of a node, moreover, can
    be thought of as defining a bipartition of the parent's index collection.
 
-   IndexSets only live within a single level.
+   IndexSets only live within a single level.  Per-category vectors are
+   drawn from the frontier's level arena, so that a level's census
+   occupies a single contiguous region rather than a heap allocation
+   per node.
 */
 class IndexSet {
-  static IndexT minNode;
-
   const IndexT splitIdx; // Unique level identifier.
   const IndexRange bufRange;  // Swiss cheese positions within obsPart buffer.
   const IndexT sCount;  // # samples subsumed by this set.
   const double sum; // Sum of all responses in set.
   const PathT path; // Bitwise record of recent reaching L/R path.
   const IndexT ptId; // Index of associated pretree node.
-  const vector<SumCount> ctgSum;  // Per-category sum decomposition.
+  double ctgSquares; // Sum of squared category sums:  precedes ctgSum.
+  const LevelVector<SumCount> ctgSum;  // Per-category sum decomposition.
+  const double isolationGain; // Bounds the gain of any split.
 
   double minInfo; // Split threshold:  reset after splitting.
 
@@ -62,18 +66,44 @@ class IndexSet {
   // May be updated multiple times by successive criteria.  Final
   // criterion prevails, assuming criteria accrue conditionally.
   bool trueEncoding;
-  vector<SumCount> ctgTrue; // Per-category sums updatable from criterion.
+  LevelVector<SumCount> ctgTrue; // Per-category sums updatable from criterion.
 
   // Precipitates setting of unsplitable in respective successor.
   bool trueExtinct;
   bool falseExtinct;
 
+
+  /**
+     @brief Derives a successor's census from that of its predecessor.
+
+     @param arena is the level arena from which to allocate.
+
+     @param[out] squares outputs the sum of squared category sums.
+   */
+  static LevelVector<SumCount> ctgSucc(const IndexSet& pred,
+				       bool trueBranch,
+				       LevelArena* arena,
+				       double& squares);
+
+
+  /**
+     @return sum of squared category sums in a root census.
+   */
+  static double ctgSquaresRoot(const vector<SumCount>& ctgRoot);
+
 public:
 
   /**
      @brief Root node constructor.
+
+     @param minNode is the minimal splitable extent.
+
+     @param minInfo is the split threshold, nonzero iff the root of a
+     subtree.
    */
-  IndexSet(const class SampledObs* sample);
+  IndexSet(const class SampledObs* sample,
+	   IndexT minNode,
+	   double minInfo = 0.0);
 
 
   /**
@@ -84,43 +114,31 @@ public:
 	   bool trueBranch);
 
 
-  static void immutables(IndexT minNode);
-
-  
-  static void deImmutables();
-
-
   /**
      @brief Updates branch state from criterion encoding.
 
      @param enc encapsulates the splitting criteria.
+
+     @param minRatio scales the successors' information threshold.
    */
-  void update(const struct CritEncoding& enc);
+  void update(const struct CritEncoding& enc,
+	      double minRatio);
 
   
   /**
-     @brief Selects best splitter, if any.
-
-     @return maximal- or zero=information candidate for node.
+     @return true iff minimum information threshold exceeded.
    */
-  class SplitNux candMax(const vector<class SplitNux>& cand) const;
+  bool isInformative(const class SplitNux& nux) const;
 
 
   /**
-     @return true iff minimum information threshold exceeded.
+     @return false iff no split of the node can be informative.
    */
-  bool isInformative(const SplitNux& nux) const;
+  bool isGainable() const {
+    return isolationGain > minInfo;
+  }
   
 
-  /**
-     @brief Sums each category for a node splitable in the upcoming level.
-
-     @param[out] sumSquares outputs the response sum of squares, over categories.
-
-     @return per-category sums for the node.
-  */
-  vector<double> sumsAndSquares(double& sumSquares);
-
 
   /**
      @brief Computes the successor path along the specified branch.
@@ -216,9 +234,17 @@ public:
   }
 
 
-  const vector<SumCount>& getCtgSumCount() const {
+  const LevelVector<SumCount>& getCtgSumCount() const {
     return ctgSum;
   }
+
+
+  /**
+     @return sum, over categories, of squared category response sums.
+   */
+  inline double getCtgSquares() const {
+    return ctgSquares;
+  }
   
   
   /**
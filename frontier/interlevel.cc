@@ -13,7 +13,7 @@
    @author Mark Seligman
  */
 
-#include "ompthread.h"
+#include "taskpool.h"
 #include "frontier.h"
 #include "sampledobs.h"
 #include "splitfrontier.h"
@@ -22,32 +22,47 @@
 #include "splitnux.h"
 #include "predictorframe.h"
 #include "indexset.h"
+#include "sampleidx.h"
+#include "trainparam.h"
+#include "histset.h"
 
 #include <algorithm>
 
 
 InterLevel::InterLevel(const PredictorFrame* frame_,
 		       const SampledObs* sampledObs_,
-		       const Frontier* frontier) :
+		       const Frontier* frontier,
+		       TrainStat* trainStat_) :
   frame(frame_),
   nPred(frame->getNPred()),
   positionMask(getPositionMask(nPred)),
   levelShift(getLevelShift(nPred)),
   bagCount(frontier->getBagCount()),
+  splitQuant(frontier->getParam()->splitQuant),
   noRank(frame->getNoRank()),
   sampledObs(sampledObs_),
   rootPath(make_unique<IdxPath>(bagCount)),
-  pathIdx(vector<PathT>(frame->getSafeSize(bagCount))),
+  pathIdx(vector<PathT>(frame->getSafeSize(bagCount, sampledObs_->isSubset()))),
   level(0),
   splitCount(1),
-  obsPart(make_unique<ObsPart>(frame, bagCount)),
-  stageMap(vector<vector<PredictorT>>(1)) {
+  flushStart(0),
+  backPop(0),
+  unsettled(false),
+  obsPart(make_unique<ObsPart>(frame, bagCount, sampledObs_->isSubset())),
+  stageMap(vector<vector<PredictorT>>(1)),
+  historyBudget(frontier->getParam()->historyBudget),
+  trainStat(trainStat_) {
   stageMap[0] = vector<PredictorT>(nPred);
 }
 
 
+InterLevel::~InterLevel() {
+  flushGroup.wait();
+}
+
+
 bool InterLevel::isStaged(const SplitCoord& coord, StagedCell*& cell) const {
-  IndexT dummy;
+  unsigned int dummy;
   PredictorT stagePos;
   if (isStaged(coord, dummy, stagePos)) {
     cell = ofFront->getCellAddr(coord.nodeIdx, stagePos);
@@ -84,7 +99,7 @@ PathT* InterLevel::getPathBlock(PredictorT predIdx) {
 }
 
 
-IndexT* InterLevel::getIdxBuffer(const SplitNux& nux) const {
+SampleIdx InterLevel::getIdxBuffer(const SplitNux& nux) const {
   return obsPart->getIdxBuffer(nux);
 }
 
@@ -101,18 +116,19 @@ ObsFrontier* InterLevel::getFront() {
 
 CandType InterLevel::repartition(const Frontier* frontier) {
   ofFront = make_unique<ObsFrontier>(frontier, this);
-  CandType cand(this);
+  CandType cand(this, frontier->getArena());
   cand.precandidates(frontier, this);
   // Precandidates precipitate restaging ancestors at this level,
   // as do all history flushes.
-  vector<unsigned int> nExtinct;
+  TrainStat::Stamp start = TrainStat::now();
   if (level == 0) {
     nExtinct = stage();
   }
   else {
-    nExtinct = restage();
+    restage();
   }
-  ofFront->prune(nExtinct);
+  trainStat->tRestage += TrainStat::since(start);
+  unsettled = true;
   return cand;
 }
 
@@ -137,62 +153,95 @@ void InterLevel::appendAncestor(StagedCell& scAnc, unsigned int historyIdx) {
 
 
 vector<unsigned int> InterLevel::stage() {
-  ofFront->prestageRoot(frame, sampledObs);
+  ofFront->prestageRoot();
 
   OMPBound predTop = nPred;
-  vector<unsigned int> nExtinct(predTop);
+  vector<unsigned int> stageExtinct(predTop);
 
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound predIdx = 0; predIdx < predTop; predIdx++) {
-      nExtinct[predIdx] = ofFront->stage(predIdx, obsPart.get(), frame, sampledObs);
-    }
-  }
-  return nExtinct;
+  TaskPool::parallelFor(predTop, [&](OMPBound predIdx) {
+      stageExtinct[predIdx] = ofFront->stage(predIdx, obsPart.get(), frame, sampledObs);
+    }, &trainStat->loadStage, "stage");
+  return stageExtinct;
 }
 
 
-vector<unsigned int> InterLevel::restage() {
-  unsigned int backPop = prestageRear(); // Popable layers persist.
+void InterLevel::restage() {
+  flushStart = ancestor.size(); // Precandidate ancestors lead.
+  backPop = prestageRear(); // Popable layers persist.
   ofFront->runValues();
 
-  OMPBound idxTop = ancestor.size();
-  vector<unsigned int> nExtinct(idxTop);
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound idx = 0; idx < idxTop; idx++) {
+  trainStat->nRestaged += ancestor.size();
+  nExtinct = vector<unsigned int>(ancestor.size());
+  TaskPool::parallelFor(flushStart, [&](OMPBound idx) {
       nExtinct[idx] = restage(ancestor[idx]);
-    }
+    }, &trainStat->loadRestage, "restage");
+
+  // Flushed cells and the candidates' cells are disjoint, so the
+  // flush proceeds while candidates are drawn and evaluated.
+  if (ancestor.size() > flushStart)
+    TaskPool::start();
+  for (size_t idx = flushStart; idx < ancestor.size(); idx++) {
+    flushGroup.submit([this, idx]() {
+	nExtinct[idx] = restage(ancestor[idx]);
+      });
   }
+}
+
+
+void InterLevel::settle() {
+  if (!unsettled)
+    return;
+
+  unsettled = false;
+  flushGroup.wait();
+  ofFront->prune(nExtinct);
 
   ancestor.clear();
-  while (backPop--) { // Rear layers may now pop.
+  while (backPop > 0) { // Rear layers may now pop.
     history.pop_back();
+    backPop--;
   }
-
-  return nExtinct;
 }
 
 
 unsigned int InterLevel::prestageRear() {
+  size_t footprint = ofFront->getFootprint();
+  double occupancySum = 0.0;
+  for (auto & layer : history) {
+    footprint += layer->getFootprint();
+    occupancySum += layer->stageOccupancy();
+    trainStat->history.stageMax = max(trainStat->history.stageMax, static_cast<size_t>(layer->getStageCount()));
+    trainStat->history.occupancyMin = min(trainStat->history.occupancyMin, layer->stageOccupancy());
+  }
+  if (!history.empty()) {
+    trainStat->recordOccupancy(level, occupancySum / history.size());
+  }
+  trainStat->history.depthMax = max(trainStat->history.depthMax, static_cast<unsigned int>(history.size()));
+  trainStat->history.footprintMax = max(trainStat->history.footprintMax, footprint);
+
   // TODO:  replace constant.
   // 8-bit paths cannot represent beyond a 7-layer history.
   unsigned int backPop = 0;
   if (history.size() == 7) {//!NodePath::isRepresentable(history.size()))
     history.back()->prestageLayer(ofFront.get());
+    footprint -= history.back()->getFootprint();
+    trainStat->history.flushPath++;
     backPop++;
   }
 
   for (int backLayer = history.size() - backPop - 1; backLayer >= 0; backLayer--) {
     if ((history[backLayer])->stageOccupancy() < stageEfficiency) {
-      history[backLayer]->prestageLayer(ofFront.get());
-      backPop++;
+      trainStat->history.flushSparse++;
+    }
+    else if (historyBudget != 0 && footprint > historyBudget) {
+      trainStat->history.flushBudget++;
     }
     else {
       break;
     }
+    history[backLayer]->prestageLayer(ofFront.get());
+    footprint -= history[backLayer]->getFootprint();
+    backPop++;
   }
 
   return backPop;
@@ -204,8 +253,8 @@ unsigned int InterLevel::restage(Ancestor& ancestor) {
 }
 
 
-void InterLevel::overlap(const vector<IndexSet>& frontierNodes,
-			 const vector<IndexSet>& frontierNext,
+void InterLevel::overlap(const LevelVector<IndexSet>& frontierNodes,
+			 const LevelVector<IndexSet>& frontierNext,
 			 IndexT endIdx) {
   splitCount = frontierNext.size();
   if (splitCount != 0) { // Otherwise no further splitting or repartitioning.
@@ -220,13 +269,25 @@ void InterLevel::overlap(const vector<IndexSet>& frontierNodes,
       (*lv)->applyFront(ofFront.get(), frontierNext);
     }
     history.push_front(move(ofFront));
+    histParent = move(histLevel);
+  }
+  else {
+    histParent.reset();
+    histLevel.reset();
   }
   level++;
 }
 
 
-void InterLevel::reviseStageMap(const vector<IndexSet>& frontierNodes) {
+HistSet* InterLevel::stageHist(PredictorT nCtg) {
+  histLevel = make_unique<HistSet>(nCtg);
+  return histLevel.get();
+}
+
+
+void InterLevel::reviseStageMap(const LevelVector<IndexSet>& frontierNodes) {
   vector<vector<PredictorT>> stageMapNext(splitCount);
+  parentIdx = vector<IndexT>(splitCount);
   IndexT terminalCount = 0;
   for (IndexT parIdx = 0; parIdx < frontierNodes.size(); parIdx++) {
     if (frontierNodes[parIdx].isTerminal()) {
@@ -236,6 +297,8 @@ void InterLevel::reviseStageMap(const vector<IndexSet>& frontierNodes) {
       IndexT splitIdx = 2 * (parIdx - terminalCount);
       stageMapNext[splitIdx] = stageMap[parIdx];
       stageMapNext[splitIdx+1] = stageMap[parIdx];
+      parentIdx[splitIdx] = parIdx;
+      parentIdx[splitIdx+1] = parIdx;
     }
   }
 
@@ -259,12 +322,12 @@ double InterLevel::interpolateRank(const SplitNux& cand,
 				   IndexT obsLeft,
 				   IndexT obsRight) const {
   IndexT sIdx = obsPart->getSampleIndex(cand, obsLeft); 
-  IndexT rankLeft = sampledObs->getRank(cand.getPredIdx(), sIdx);
+  IndexT rankLeft = sampledObs->getRank(frame, cand.getPredIdx(), sIdx);
   sIdx = obsPart->getSampleIndex(cand, obsRight);
-  IndexT rankRight = sampledObs->getRank(cand.getPredIdx(), sIdx);
+  IndexT rankRight = sampledObs->getRank(frame, cand.getPredIdx(), sIdx);
   IndexRange rankRange(rankLeft, rankRight - rankLeft);
 
-  return rankRange.interpolate(cand.getSplitQuant());
+  return rankRange.interpolate(cand.getSplitQuant(splitQuant));
 }
 
 
@@ -273,12 +336,12 @@ double InterLevel::interpolateRank(const SplitNux& cand,
 				   bool residualLeft) const {
   IndexT residualRank = frame->getImplicitRank(cand.getPredIdx());
   IndexT sIdx = obsPart->getSampleIndex(cand, obsIdx);
-  IndexT rank = sampledObs->getRank(cand.getPredIdx(), sIdx);
+  IndexT rank = sampledObs->getRank(frame, cand.getPredIdx(), sIdx);
   IndexT rankLeft = residualLeft ? residualRank : rank;
   IndexT rankRight = residualLeft ? rank : residualRank;
   IndexRange rankRange(rankLeft, rankRight - rankLeft);
 
-  return rankRange.interpolate(cand.getSplitQuant());
+  return rankRange.interpolate(cand.getSplitQuant(splitQuant));
 }
 
 
@@ -289,5 +352,5 @@ IndexT InterLevel::getCode(const SplitNux& cand,
     return frame->getImplicitRank(cand.getPredIdx());
   }
   IndexT sIdx = obsPart->getSampleIndex(cand, obsIdx);
-  return sampledObs->getRank(cand.getPredIdx(), sIdx);
+  return sampledObs->getRank(frame, cand.getPredIdx(), sIdx);
 }
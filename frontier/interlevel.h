@@ -27,6 +27,9 @@
 #include "splitcoord.h"
 #include "stagedcell.h"
 #include "typeparam.h"
+#include "levelarena.h"
+#include "trainstat.h"
+#include "taskpool.h"
 
 #include <deque>
 #include <vector>
@@ -53,6 +56,7 @@ class InterLevel {
   const PredictorT positionMask;
   const unsigned int levelShift;
   const IndexT bagCount;
+  const vector<double>& splitQuant; // Session's splitting quantiles.
   
   static constexpr double stageEfficiency = 0.15; // Work efficiency threshold.
 
@@ -64,19 +68,29 @@ class InterLevel {
   unsigned int level; // Zero-based tree depth.
   IndexT splitCount; // # nodes in the layer about to split.
   vector<Ancestor> ancestor; // Collection of ancestors to restage.
+  size_t flushStart; // Leading ancestor restaged behind splitting.
+  vector<unsigned int> nExtinct; // Extinct counts, by ancestor.
+  unsigned int backPop; // # rear layers to pop once restaged.
+  bool unsettled; // Whether repartitioning awaits settling.
+  TaskGroup flushGroup; // Restaging deferred past candidate selection.
   unique_ptr<class ObsPart> obsPart;
 
   vector<vector<PredictorT>> stageMap; // Packed level, position.
   deque<unique_ptr<class ObsFrontier>> history; // Caches previous frontier layers.
+  const size_t historyBudget; // Bytes permitted history and front, if > 0.
+  struct TrainStat* trainStat; // Owned by the frontier.
 
   unique_ptr<class ObsFrontier> ofFront; // Current frontier, not in deque.
+  unique_ptr<class HistSet> histLevel; // Histograms of splitting level, if any.
+  unique_ptr<class HistSet> histParent; // Histograms of preceding level, if any.
+  vector<IndexT> parentIdx; // Preceding-level node index of each node's parent.
 
   
   /**
-     @brief Rebuilds stage map for new frontier.
+     @brief Rebuilds stage map and parent map for new frontier.
 
   */
-  void reviseStageMap(const vector<class IndexSet>& frontierNodes);
+  void reviseStageMap(const LevelVector<class IndexSet>& frontierNodes);
 
 
   void pathHistory(const class IndexSet& iSet);
@@ -121,20 +135,28 @@ public:
      @param frame_ is the training frame.
 
      @param frontier_ tracks the frontier nodes.
+
+     @param trainStat_ accumulates the tree's instrumentation.
   */
   InterLevel(const class PredictorFrame* frame,
 	     const class SampledObs* sampledObs,
-	     const class Frontier* frontier);
+	     const class Frontier* frontier,
+	     struct TrainStat* trainStat_);
 
   
   /**
-     @brief Class finalizer.
+     @brief Class finalizer:  joins any restaging still in flight.
   */
-  ~InterLevel() = default;
+  ~InterLevel();
 
   /**
      @brief Prestages moribund rear history layers.
 
+     Rear layers are flushed when paths cannot reach them, when sparsely
+     occupied or, failing these, when the history exceeds its budget.
+     The front layer is never flushed, so the budget is a target rather
+     than a guarantee.
+
      @return count of rear layers suitable for popping.
    */
   unsigned int prestageRear();
@@ -224,6 +246,32 @@ public:
   class ObsFrontier* getFront();
 
 
+  /**
+     @brief Opens the histograms of the splitting level.
+
+     The histograms are retained through the following level.
+
+     @return histogram set, reserved serially by the caller.
+   */
+  class HistSet* stageHist(PredictorT nCtg);
+
+
+  /**
+     @return preceding level's histograms, if any.
+   */
+  const class HistSet* getHistParent() const {
+    return histParent.get();
+  }
+
+
+  /**
+     @return preceding-level node index of each node's parent.
+   */
+  const vector<IndexT>& getParentIdx() const {
+    return parentIdx;
+  }
+
+
   /**
      @brief Appends a source cell to the restaging ancestor set.
    */
@@ -301,7 +349,7 @@ public:
   PathT* getPathBlock(PredictorT predIdx);
   
 
-  IndexT* getIdxBuffer(const class SplitNux& nux) const;
+  struct SampleIdx getIdxBuffer(const class SplitNux& nux) const;
 
 
   class Obs* getPredBase(const SplitNux& nux) const;
@@ -315,8 +363,22 @@ public:
 
   /**
      @brief Updates the data (observation) partition.
+
+     Ancestors of the level's precandidates are restaged before
+     returning, as candidate selection depends upon them.  Ancestors
+     restaged only to flush the history reach no candidate, so are
+     left to restage concurrently with splitting.
+   */
+  void restage();
+
+
+  /**
+     @brief Joins restaging left in flight, then accounts for
+     extinction and pops the flushed history layers.
+
+     Precedes any access to the level's cells outside the candidates.
    */
-  vector<unsigned int> restage();
+  void settle();
 
 
   /**
@@ -340,8 +402,8 @@ public:
      during the overlap.  Initializes data structures for restaging and
      splitting the current layer of the subtree.
    */
-  void overlap(const vector<class IndexSet>& frontierNodes,
-	       const vector<class IndexSet>& frontierNext,
+  void overlap(const LevelVector<class IndexSet>& frontierNodes,
+	       const LevelVector<class IndexSet>& frontierNext,
 	       IndexT endIdx);
 
 
@@ -18,6 +18,7 @@
 #define FRONTIER_SAMPLEMAP_H
 
 #include "typeparam.h"
+#include "levelarena.h"
 
 #include <algorithm>
 #include <vector>
@@ -44,20 +45,26 @@
    opportunites for line reuse across the nodes.
 
    Extent vectors record the number of sample indices associated with each node.
+
+   Nonterminal maps draw from the frontier's level arena, while the
+   terminal map, persisting over the tree, draws from the heap.
  */
 struct SampleMap {
-  vector<IndexT> sampleIndex;
-  vector<IndexRange> range;
-  vector<IndexT> ptIdx;
+  LevelVector<IndexT> sampleIndex;
+  LevelVector<IndexRange> range;
+  LevelVector<IndexT> ptIdx;
   IndexT maxExtent; // Tracks width of node-relative indices.
 
   /**
-     @brief Constructor with optional index count.
+     @brief Constructor with optional index count and arena.
+
+     @param arena is the level arena, if any, else null for the heap.
    */
-  SampleMap(IndexT nIdx = 0) :
-    sampleIndex(vector<IndexT>(nIdx)),
-    range(vector<IndexRange>(0)),
-    ptIdx(vector<IndexT>(0)),
+  SampleMap(IndexT nIdx = 0,
+	    LevelArena* arena = nullptr) :
+    sampleIndex(nIdx, LevelAllocator<IndexT>(arena)),
+    range(LevelAllocator<IndexRange>(arena)),
+    ptIdx(LevelAllocator<IndexT>(arena)),
     maxExtent(0) {
   }
 
@@ -21,5 +21,5 @@ PredictorFrame *PredictorFrame::Factory(const RLEFrame* rleFrame,
 			const Coproc *coproc,
 			double autoCompress,
 			vector<string>& diag) {
-  return new PredictorFrame(rleFrame, autoCompress, true, diag);
+  return new PredictorFrame(rleFrame, autoCompress, true, false, diag);
 }
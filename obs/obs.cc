@@ -21,6 +21,10 @@ unsigned int Obs::ctgMask = 0;
 unsigned int Obs::multLow = 0;
 unsigned int Obs::multMask = 0;
 unsigned int Obs::numMask = 0;
+unsigned int Obs::numLow = 0;
+double Obs::yLow = 0.0;
+double Obs::yHigh = 0.0;
+double Obs::yStep = 0.0;
 
   /**
      @brief Sets internal packing parameters.
@@ -31,9 +35,29 @@ void Obs::setShifts(unsigned int ctgBits,
   multMask = (1ul << multBits) - 1;
   ctgMask = (1ul << ctgBits) - 1;
   numMask = ~((1ul << (ctgBits + multBits + 1)) - 1);
+  numLow = ctgBits + multBits + 1;
+  setStep();
+}
+
+
+void Obs::setRange(double yMin,
+		   double yMax) {
+  yLow = yMin;
+  yHigh = yMax;
+  setStep();
+}
+
+
+void Obs::setStep() {
+  // Quantized levels remaining after tie, category and multiplicity.
+  // Zero levels leave only the least value representable.
+  unsigned int numBits = 8 * sizeof(ObsBitsT);
+  double nLevel = numLow < numBits ? (1ul << (numBits - numLow)) - 1 : 0;
+  yStep = (sizeof(ObsBitsT) == sizeof(ObsPacked) || nLevel == 0 || yHigh <= yLow) ? 0.0 : (yHigh - yLow) / nLevel;
 }
 
 
 void Obs::deImmutables() {
-  multLow = multMask = ctgMask = numMask = 0;
+  multLow = multMask = ctgMask = numMask = numLow = 0;
+  yLow = yHigh = yStep = 0.0;
 }
@@ -32,6 +32,16 @@ union ObsPacked {
 };
 
 
+// Packed observation width.  Building with OBS_PACK16 halves the
+// footprint of the observation partition, and hence the restaging
+// traffic, by quantizing the response.
+#ifdef OBS_PACK16
+typedef uint16_t ObsBitsT;
+#else
+typedef uint32_t ObsBitsT;
+#endif
+
+
 /**
    @brief Compact representation for splitting.
  */
@@ -42,9 +52,23 @@ class Obs {
   static unsigned int multLow; ///< Low bit position of multiplicity.
   static unsigned int multMask; ///< Masks bits not encoding multiplicity.
   static unsigned int numMask; ///< Masks bits not encoding numeric.
-  
-  ObsPacked obsPacked;
-  
+  static unsigned int numLow; ///< Low bit position of quantized response.
+  static double yLow; ///< Least response value.
+  static double yHigh; ///< Greatest response value.
+  static double yStep; ///< Quantization step, iff 16-bit packing.
+
+  ObsBitsT obsBits;
+
+
+  /**
+     @brief Derives the quantization step from the packing and range.
+
+     The step is zero when the range is degenerate, as when the
+     response takes a single value.
+   */
+  static void setStep();
+
+
  public:
 
   /**
@@ -53,7 +77,7 @@ class Obs {
      @return sample count.
    */
   inline unsigned int getSCount() const {
-    return 1 + ((obsPacked.bits >> multLow) & multMask);
+    return 1 + ((obsBits >> multLow) & multMask);
   }
 
 
@@ -63,9 +87,13 @@ class Obs {
      @return sum of y-values for sample.
    */
   inline double getYSum() const {
-    ObsPacked fltPacked = obsPacked;
-    fltPacked.bits &= numMask;
+#ifdef OBS_PACK16
+    return (yLow + (obsBits >> numLow) * yStep) * getSCount();
+#else
+    ObsPacked fltPacked;
+    fltPacked.bits = obsBits & numMask;
     return fltPacked.num;
+#endif
   }
 
 
@@ -75,7 +103,7 @@ class Obs {
      @return response cardinality.
    */
   inline PredictorT getCtg() const {
-    return (obsPacked.bits >> ctgLow) & ctgMask;
+    return (obsBits >> ctgLow) & ctgMask;
   }
 
 
@@ -85,12 +113,23 @@ class Obs {
   static void setShifts(unsigned int ctgBits,
 		        unsigned int multBits);
 
+
+  /**
+     @brief Records the response range, for quantization.
+
+     @param yMin is the least per-sample response value.
+
+     @param yMax is the greatest per-sample response value.
+   */
+  static void setRange(double yMin,
+		       double yMax);
+
   
   static void deImmutables();
 
 
   bool isTied() const {
-    return (obsPacked.bits & tieMask) != 0;
+    return (obsBits & tieMask) != 0;
   }
 
 
@@ -103,17 +142,23 @@ class Obs {
   */
   inline void join(const SampleNux& sNux,
 		   bool tie) {
+#ifdef OBS_PACK16
+    IndexT sCount = sNux.getSCount();
+    unsigned int yQuant = yStep == 0.0 ? 0 : static_cast<unsigned int>(lround((sNux.getYSum() / sCount - yLow) / yStep));
+    obsBits = (yQuant << numLow) + ((sCount - 1) << multLow) + (sNux.getCtg() << ctgLow) + (tie ? 1 : 0);
+#else
     ObsPacked fltPacked;
     fltPacked.num = sNux.getYSum();
-    obsPacked.bits = (fltPacked.bits & numMask) + ((sNux.getSCount() - 1) << multLow) + (sNux.getCtg() << ctgLow) + (tie ? 1 : 0); 
+    obsBits = (fltPacked.bits & numMask) + ((sNux.getSCount() - 1) << multLow) + (sNux.getCtg() << ctgLow) + (tie ? 1 : 0); 
+#endif
   }
 
 
   void setTie(bool tie) {
     if (tie)
-      obsPacked.bits |= 1ul;
+      obsBits |= 1ul;
     else
-      obsPacked.bits &= ~1ul;
+      obsBits &= ~1ul;
   }
 
 
@@ -149,11 +194,14 @@ class Obs {
      @param[out] nux accumulates run statistics.
 
      @param[in, out] sumBase accumulates run response by category.
+
+     @param yCtg is the accumulator slot of the observation's category.
    */
   inline void ctgInit(RunNux& nux,
-		      double* sumBase) const {
+		      double* sumBase,
+		      PredictorT yCtg) const {
     nux.sumCount = SumCount(getYSum(), getSCount());
-    sumBase[getCtg()] = nux.sumCount.sum;
+    sumBase[yCtg] = nux.sumCount.sum;
   }
 
 
@@ -163,11 +211,12 @@ class Obs {
      @return true iff the current cell continues a run.
    */
   inline bool ctgAccum(RunNux& nux,
-		       double* sumBase) const {
+		       double* sumBase,
+		       PredictorT yCtg) const {
     if (isTied()) {
       double ySum = getYSum();
       nux.sumCount += SumCount(ySum, getSCount());
-      sumBase[getCtg()] += ySum;
+      sumBase[yCtg] += ySum;
       return true;
     }
     else {
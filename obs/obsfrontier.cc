@@ -25,6 +25,8 @@
 #include "indexset.h"
 #include "algparam.h"
 
+#include <algorithm>
+
 
 ObsFrontier::ObsFrontier(const Frontier* frontier_,
 			 InterLevel* interLevel_) :
@@ -38,19 +40,16 @@ ObsFrontier::ObsFrontier(const Frontier* frontier_,
   runCount(0),
   layerIdx(0), // Not on layer yet, however.
   nodePath(backScale(nSplit)) {
-  NodePath::setNoSplit(frontier->getBagCount());
   // Coprocessor only.
   // LiveBits df;
   //  fill(mrra.begin(), mrra.end(), df);
 }
 
 
-void ObsFrontier::prestageRoot(const PredictorFrame* frame,
-			       const SampledObs* sampledObs) {
+void ObsFrontier::prestageRoot() {
   for (PredictorT predIdx = 0; predIdx != nPred; predIdx++) {
     interLevel->setStaged(0, predIdx, predIdx);
-    stagedCell[0].emplace_back(predIdx, runCount, frontier->getBagCount(), sampledObs->getRunCount(predIdx));
-    runCount += stagedCell[0].back().trackRuns ? sampledObs->getRunCount(predIdx) : 0;
+    stagedCell[0].emplace_back(predIdx, runCount, frontier->getBagCount(), 0);
   }
   stageCount = nPred;
   runValues();
@@ -96,6 +95,18 @@ void ObsFrontier::prestageLayer(ObsFrontier* ofFront) {
 }
 
 
+size_t ObsFrontier::getFootprint() const {
+  size_t footprint = node2Front.capacity() * sizeof(IndexRange)
+    + front2Node.capacity() * sizeof(IndexT)
+    + runValue.capacity() * sizeof(IndexT)
+    + nodePath.capacity() * sizeof(NodePath);
+  for (const vector<StagedCell>& nodeCells : stagedCell) {
+    footprint += nodeCells.capacity() * sizeof(StagedCell);
+  }
+  return footprint;
+}
+
+
 IndexT ObsFrontier::countLive() const {
   IndexT liveCount = 0;
   for (vector<StagedCell> nodeCells : stagedCell) {
@@ -109,8 +120,8 @@ IndexT ObsFrontier::countLive() const {
 }
 
 
-void ObsFrontier::setFrontRange(const vector<IndexSet>& frontierNodes,
-				const vector<IndexSet>& frontierNext) {
+void ObsFrontier::setFrontRange(const LevelVector<IndexSet>& frontierNodes,
+				const LevelVector<IndexSet>& frontierNext) {
   front2Node = vector<IndexT>(frontierNext.size());
   IndexT terminalCount = 0;
   for (IndexT parIdx = 0; parIdx < frontierNodes.size(); parIdx++) {
@@ -125,7 +136,7 @@ void ObsFrontier::setFrontRange(const vector<IndexSet>& frontierNodes,
 }
 
 
-void ObsFrontier::setFrontRange(const vector<IndexSet>& frontierNext,
+void ObsFrontier::setFrontRange(const LevelVector<IndexSet>& frontierNext,
 				IndexT nodeIdx,
 				const IndexRange& range) {
   node2Front[nodeIdx] = range;
@@ -143,7 +154,7 @@ void ObsFrontier::pathInit(NodePath* pathBase, const IndexSet& iSet) {
 
 
 void ObsFrontier::applyFront(const ObsFrontier* ofFront,
-			    const vector<IndexSet>& frontierNext) {
+			    const LevelVector<IndexSet>& frontierNext) {
   layerIdx++;
   nodePath = vector<NodePath>(backScale(nSplit));
   front2Node = vector<IndexT>(frontierNext.size());
@@ -184,44 +195,69 @@ unsigned int ObsFrontier::stage(PredictorT predIdx,
 				ObsPart* obsPart,
 				const PredictorFrame* frame,
 				const SampledObs* sampledObs) {
-  obsPart->setStageRange(predIdx, frame->getSafeRange(predIdx, frontier->getBagCount()));
+  bool subset = sampledObs->isSubset();
+  obsPart->setStageRange(predIdx, frame->getSafeRange(predIdx, frontier->getBagCount(), subset));
   StagedCell& cell = stagedCell[0][predIdx];
   const IndexT rankImplicit = frame->getImplicitRank(predIdx);
   const IndexT rankMissing = frame->getMissingRank(predIdx);
   IndexT obsMissing = 0;
-  IndexT* sIdx;
+  SampleIdx sIdx;
   Obs* srStart = obsPart->buffers(predIdx, 0, sIdx);
   Obs* spn = srStart;
   IndexT rankPrev = interLevel->getNoRank();
   IndexT valIdx = cell.valIdx;
   IndexT runCount = 0;
-  for (auto rle : frame->getRLE(predIdx)) {
-    IndexT rank = rle.val;
-    if (rank != rankImplicit) {
-      for (IndexT row = rle.row; row != rle.row + rle.extent; row++) {
-	IndexT smpIdx;
-	SampleNux sampleNux;
-	if (sampledObs->isSampled(row, smpIdx, sampleNux)) {
-	  bool tie = rank == rankPrev;
-	  spn++->join(sampleNux, tie);
-	  *sIdx++ = smpIdx;
-	  if (!tie) {
-	    rankPrev = rank;
-	    runCount++;
-	    if (cell.trackRuns)
-	      runValue[valIdx++] = rank;
+  auto stageSample = [&](IndexT rank, IndexT smpIdx, const SampleNux& sampleNux) {
+    bool tie = frame->sameRun(predIdx, rank, rankPrev);
+    sIdx.set(spn - srStart, smpIdx);
+    spn++->join(sampleNux, tie);
+    if (!tie) {
+      rankPrev = rank;
+      runCount++;
+      if (cell.trackRuns)
+	runValue[valIdx++] = rank;
+    }
+    if (rank == rankMissing)
+      obsMissing++;
+  };
+
+  if (subset) {
+    // Subset samples are few, so are ranked directly rather than by
+    // walking the frame's run encoding.  Subsets list samples in row
+    // order, so ties retain the encoding's order.
+    vector<pair<IndexT, IndexT>> rankSample; // Rank, sample index.
+    for (IndexT smpIdx = 0; smpIdx != frontier->getBagCount(); smpIdx++) {
+      IndexT rank = sampledObs->getRank(frame, predIdx, smpIdx);
+      if (rank != rankImplicit)
+	rankSample.emplace_back(rank, smpIdx);
+    }
+    sort(rankSample.begin(), rankSample.end());
+    if (rankImplicit != interLevel->getNoRank())
+      cell.preResidual = lower_bound(rankSample.begin(), rankSample.end(), make_pair(rankImplicit, IndexT(0))) - rankSample.begin();
+    for (auto rs : rankSample) {
+      stageSample(rs.first, rs.second, sampledObs->getNux(rs.second));
+    }
+  }
+  else {
+    for (auto rle : frame->getRLE(predIdx)) {
+      IndexT rank = rle.val;
+      if (rank != rankImplicit) {
+	for (IndexT row = rle.row; row != rle.row + rle.extent; row++) {
+	  IndexT smpIdx;
+	  SampleNux sampleNux;
+	  if (sampledObs->isSampled(row, smpIdx, sampleNux)) {
+	    stageSample(rank, smpIdx, sampleNux);
 	  }
-	  if (rank == rankMissing)
-	    obsMissing++;
 	}
       }
-    }
-    else {
-      cell.preResidual = spn - srStart;
+      else {
+	cell.preResidual = spn - srStart;
+      }
     }
   }
   //  cout << "Predictor " << predIdx << ":  " << obsMissing << " missing " << ", " << spn - srStart << " observed" << endl;
   cell.updateCounts(frontier->getBagCount() - (spn - srStart), obsMissing);
+  cell.setRunCount(runCount); // Bins, if binned, else distinct ranks.
 
   if (!cell.splitable()) {
     interLevel->delist(cell.coord);
@@ -339,7 +375,7 @@ vector<IndexT> ObsFrontier::pathRestage(ObsPart* obsPart,
 					const StagedCell& mrra) const {
   IndexRange obsRange = mrra.obsRange;
   const IdxPath* idxPath = interLevel->getRootPath();
-  const IndexT* indexVec = obsPart->idxBuffer(&mrra);
+  SampleIdx indexVec = obsPart->idxBuffer(&mrra);
   PathT* prePath = interLevel->getPathBlock(mrra.getPredIdx());
   vector<IndexT> pathCount(backScale(1));
 
@@ -26,6 +26,7 @@
 #include "stagedcell.h"
 #include "splitcoord.h"
 #include "typeparam.h"
+#include "levelarena.h"
 
 #include <vector>
 #include <numeric>
@@ -104,9 +105,10 @@ public:
   
   /**
      @brief Allocates all 'nPred' StagedCells for staging.
+
+     Run counts are unknown until staging walks the bagged ranks.
    */
-  void prestageRoot(const class PredictorFrame* layout,
-		    const class SampledObs* sampledObs);
+  void prestageRoot();
 
 
   /**
@@ -137,6 +139,12 @@ public:
   double stageOccupancy() const {
     return stageMax == 0 ? 0.0 : double(stageCount) / stageMax;
   }
+
+
+  /**
+     @brief Estimates the heap bytes held by the layer.
+   */
+  size_t getFootprint() const;
   
 
   StagedCell getCell(IndexT nodeIdx,
@@ -151,8 +159,8 @@ public:
   }
 
 
-  void setFrontRange(const vector<IndexSet>& frontierNodes,
-		     const vector<IndexSet>& frontierNext);
+  void setFrontRange(const LevelVector<IndexSet>& frontierNodes,
+		     const LevelVector<IndexSet>& frontierNext);
 
   
   /**
@@ -160,7 +168,7 @@ public:
 
      Must be called in consecutive parIdx order.
    */
-  void setFrontRange(const vector<class IndexSet>& frontierNext,
+  void setFrontRange(const LevelVector<class IndexSet>& frontierNext,
 		     IndexT parIdx,
 		     const IndexRange& range);
 
@@ -181,7 +189,7 @@ public:
      @param frontCount is the number of nodes in the new front.
   */
   void applyFront(const ObsFrontier* ofCurrent,
-		  const vector<class IndexSet>& frontierNext);
+		  const LevelVector<class IndexSet>& frontierNext);
 
   /**
      @brief Allocates the run values vector.
@@ -16,7 +16,9 @@
 #include "partition.h"
 #include "predictorframe.h"
 #include "splitnux.h"
+#include "bufferpool.h"
 
+#include <algorithm>
 #include <numeric>
 
 
@@ -24,12 +26,17 @@
    @brief Base class constructor.
  */
 ObsPart::ObsPart(const PredictorFrame* layout,
-		 IndexT bagCount_) :
+		 IndexT bagCount_,
+		 bool strided) :
   bagCount(bagCount_),
-  bufferSize(layout->getSafeSize(bagCount)),
+  bufferSize(layout->getSafeSize(bagCount, strided)),
+  narrowIdx(bagCount <= narrowMax),
+  indexBase(narrowIdx ? nullptr : BufferPool::acquire<IndexT>(2 * bufferSize)),
+  indexNarrow(narrowIdx ? BufferPool::acquire<NarrowIdxT>(2 * bufferSize) : nullptr),
   stageRange(layout->getNPred()) {
-  indexBase = new IndexT[2* bufferSize];
-  obsCell = new Obs[2 * bufferSize];
+  // Buffers are recycled across trees, sparing the page faults of
+  // fresh allocation.  As before, staging writes cells before reads.
+  obsCell = BufferPool::acquire<Obs>(2 * bufferSize);
 
   // Coprocessor variants:
   //  vector<unsigned int> destRestage(bufferSize);
@@ -41,17 +48,30 @@ ObsPart::ObsPart(const PredictorFrame* layout,
   @brief Base class destructor.
  */
 ObsPart::~ObsPart() {
-  delete [] obsCell;
-  delete [] indexBase;
+  BufferPool::release(obsCell, 2 * bufferSize);
+  BufferPool::release(indexBase, 2 * bufferSize);
+  BufferPool::release(indexNarrow, 2 * bufferSize);
 }
 
 
-IndexT* ObsPart::getIdxBuffer(const SplitNux& nux) const {
+template<>
+IndexT* ObsPart::typedBase<IndexT>() const {
+  return indexBase;
+}
+
+
+template<>
+NarrowIdxT* ObsPart::typedBase<NarrowIdxT>() const {
+  return indexNarrow;
+}
+
+
+SampleIdx ObsPart::getIdxBuffer(const SplitNux& nux) const {
   return idxBuffer(nux.getStagedCell());
 }
 
 
-Obs* ObsPart::getBuffers(const SplitNux& nux, IndexT*& sIdx) const {
+Obs* ObsPart::getBuffers(const SplitNux& nux, SampleIdx& sIdx) const {
   return buffers(nux.getStagedCell(), sIdx);
 }
 
@@ -67,57 +87,126 @@ IndexT ObsPart::getSampleIndex(const SplitNux& cand,
 }
 
 
+void ObsPart::restageDiscrete(const PathT* prePath,
+			      const StagedCell& mrra,
+			      vector<IndexT>& obsScatter) {
+  if (narrowIdx)
+    restageDiscrete<NarrowIdxT>(prePath, mrra, obsScatter);
+  else
+    restageDiscrete<IndexT>(prePath, mrra, obsScatter);
+}
+
+
+IndexT ObsPart::compactBlock(const PathT* prePath,
+			     IndexT blockStart,
+			     IndexT blockEnd,
+			     vector<IndexT>& obsScatter,
+			     IndexT obsSource[],
+			     IndexT obsDest[]) {
+  IndexT nActive = 0;
+  for (IndexT idx = blockStart; idx != blockEnd; idx++) {
+    PathT path = prePath[idx];
+    IndexT active = NodePath::isActive(path) ? 1 : 0;
+    IndexT& scatter = obsScatter[active * path]; // Inert iff inactive.
+    obsSource[nActive] = idx;
+    obsDest[nActive] = scatter;
+    scatter += active;
+    nActive += active;
+  }
+  return nActive;
+}
+
+
+template<typename IdxT>
 void ObsPart::restageDiscrete(const PathT* prePath,
 			      const StagedCell& mrra,
 			      vector<IndexT>& obsScatter) {
   Obs *srSource, *srTarg;
-  IndexT *idxSource, *idxTarg;
+  IdxT *idxSource, *idxTarg;
   buffers(mrra, srSource, idxSource, srTarg, idxTarg);
 
-  for (IndexT idx = mrra.obsRange.getStart(); idx < mrra.obsRange.getEnd(); idx++) {
-    PathT path = prePath[idx];
-    if (NodePath::isActive(path)) {
-      IndexT obsDest = obsScatter[path]++;
-      srTarg[obsDest] = srSource[idx];
-      idxTarg[obsDest] = idxSource[idx];
+  IndexT obsSource[restageBlock];
+  IndexT obsDest[restageBlock];
+  for (IndexT blockStart = mrra.obsRange.getStart(); blockStart < mrra.obsRange.getEnd(); blockStart += restageBlock) {
+    IndexT blockEnd = min(mrra.obsRange.getEnd(), blockStart + restageBlock);
+    IndexT nActive = compactBlock(prePath, blockStart, blockEnd, obsScatter, obsSource, obsDest);
+    for (IndexT i = 0; i < nActive; i++) {
+      srTarg[obsDest[i]] = srSource[obsSource[i]];
     }
+    scatterIdx(idxSource, idxTarg, obsSource, obsDest, nActive);
   }
 }
 
 
+void ObsPart::restageTied(const PathT* prePath,
+			  vector<IndexT>& runCount,
+			  const StagedCell& mrra,
+			  vector<IndexT>& obsScatter) {
+  if (narrowIdx)
+    restageTied<NarrowIdxT>(prePath, runCount, mrra, obsScatter);
+  else
+    restageTied<IndexT>(prePath, runCount, mrra, obsScatter);
+}
+
+
+template<typename IdxT>
 void ObsPart::restageTied(const PathT* prePath,
 			  vector<IndexT>& runCount,
 			  const StagedCell& mrra,
 			  vector<IndexT>& obsScatter) {
   Obs *srSource, *srTarg;
-  IndexT *idxSource, *idxTarg;
+  IdxT *idxSource, *idxTarg;
   buffers(mrra, srSource, idxSource, srTarg, idxTarg);
 
   IndexT rankIdx = 0;
   vector<IndexT> idxPrev(runCount.size());
   fill(idxPrev.begin(), idxPrev.end(), mrra.getRunCount());
   srSource[mrra.obsRange.getStart()].setTie(true); // Fillip;  temporary.
-  for (IndexT idx = mrra.obsRange.getStart(); idx != mrra.obsRange.getEnd(); idx++) {
-    Obs sourceNode = srSource[idx];
-    rankIdx += sourceNode.isTied() ? 0 : 1;
-    PathT path = prePath[idx];
-    if (NodePath::isActive(path)) {
-      if (rankIdx != idxPrev[path]) {
-	sourceNode.setTie(false);
-	runCount[path]++;
-	idxPrev[path] = rankIdx;
-      }
-      else {
-	sourceNode.setTie(true);
+  IndexT obsSource[restageBlock];
+  IndexT obsDest[restageBlock];
+  for (IndexT blockStart = mrra.obsRange.getStart(); blockStart < mrra.obsRange.getEnd(); blockStart += restageBlock) {
+    IndexT blockEnd = min(mrra.obsRange.getEnd(), blockStart + restageBlock);
+    IndexT nActive = 0;
+    for (IndexT idx = blockStart; idx != blockEnd; idx++) {
+      Obs sourceNode = srSource[idx];
+      rankIdx += sourceNode.isTied() ? 0 : 1;
+      PathT path = prePath[idx];
+      if (NodePath::isActive(path)) {
+        if (rankIdx != idxPrev[path]) {
+	  sourceNode.setTie(false);
+	  runCount[path]++;
+	  idxPrev[path] = rankIdx;
+        }
+        else {
+	  sourceNode.setTie(true);
+        }
+        IndexT dest = obsScatter[path]++;
+        srTarg[dest] = sourceNode;
+        obsSource[nActive] = idx;
+        obsDest[nActive++] = dest;
       }
-      IndexT obsDest = obsScatter[path]++;
-      srTarg[obsDest] = sourceNode;
-      idxTarg[obsDest] = idxSource[idx];
     }
+    // Index moves are deferred, as they play no role in tie tracking.
+    scatterIdx(idxSource, idxTarg, obsSource, obsDest, nActive);
   }
 }
 
 
+void ObsPart::restageValues(const PathT* prePath,
+			    vector<IndexT>& runCount,
+			    const StagedCell& mrra,
+			    vector<IndexT>& obsScatter,
+			    vector<IndexT>& valScatter,
+			    const vector<IndexT>& valSource,
+			    vector<IndexT>& valTarg) {
+  if (narrowIdx)
+    restageValues<NarrowIdxT>(prePath, runCount, mrra, obsScatter, valScatter, valSource, valTarg);
+  else
+    restageValues<IndexT>(prePath, runCount, mrra, obsScatter, valScatter, valSource, valTarg);
+}
+
+
+template<typename IdxT>
 void ObsPart::restageValues(const PathT* prePath,
 			    vector<IndexT>& runCount,
 			    const StagedCell& mrra,
@@ -126,31 +215,40 @@ void ObsPart::restageValues(const PathT* prePath,
 			    const vector<IndexT>& valSource,
 			    vector<IndexT>& valTarg) {
   Obs *srSource, *srTarg;
-  IndexT *idxSource, *idxTarg;
+  IdxT *idxSource, *idxTarg;
   buffers(mrra, srSource, idxSource, srTarg, idxTarg);
 
   vector<IndexT> idxPrev(runCount.size());
   fill(idxPrev.begin(), idxPrev.end(), mrra.valIdx + mrra.getRunCount());
   IndexT rankIdx = mrra.valIdx;
   srSource[mrra.obsRange.getStart()].setTie(true); // Fillip;  temporary.
-  for (IndexT idx = mrra.obsRange.getStart(); idx != mrra.obsRange.getEnd(); idx++) {
-    Obs sourceNode = srSource[idx];
-    rankIdx += sourceNode.isTied() ? 0 : 1;
-    PathT path = prePath[idx];
-    if (NodePath::isActive(path)) {
-      if (rankIdx != idxPrev[path]) {
-	sourceNode.setTie(false);
-	runCount[path]++;
-	idxPrev[path] = rankIdx;
-	IndexT valDest = valScatter[path]++;
-	valTarg[valDest] = valSource[rankIdx];
-      }
-      else {
-	sourceNode.setTie(true);
+  IndexT obsSource[restageBlock];
+  IndexT obsDest[restageBlock];
+  for (IndexT blockStart = mrra.obsRange.getStart(); blockStart < mrra.obsRange.getEnd(); blockStart += restageBlock) {
+    IndexT blockEnd = min(mrra.obsRange.getEnd(), blockStart + restageBlock);
+    IndexT nActive = 0;
+    for (IndexT idx = blockStart; idx != blockEnd; idx++) {
+      Obs sourceNode = srSource[idx];
+      rankIdx += sourceNode.isTied() ? 0 : 1;
+      PathT path = prePath[idx];
+      if (NodePath::isActive(path)) {
+        if (rankIdx != idxPrev[path]) {
+	  sourceNode.setTie(false);
+	  runCount[path]++;
+	  idxPrev[path] = rankIdx;
+	  IndexT valDest = valScatter[path]++;
+	  valTarg[valDest] = valSource[rankIdx];
+        }
+        else {
+	  sourceNode.setTie(true);
+        }
+        IndexT dest = obsScatter[path]++;
+        srTarg[dest] = sourceNode;
+        obsSource[nActive] = idx;
+        obsDest[nActive++] = dest;
       }
-      IndexT obsDest = obsScatter[path]++;
-      srTarg[obsDest] = sourceNode;
-      idxTarg[obsDest] = idxSource[idx];
     }
+    // Index moves are deferred, as they play no role in tie tracking.
+    scatterIdx(idxSource, idxTarg, obsSource, obsDest, nActive);
   }
 }
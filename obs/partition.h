@@ -20,6 +20,7 @@
 #include "stagedcell.h"
 #include "path.h"
 #include "typeparam.h"
+#include "sampleidx.h"
 
 #include <vector>
 
@@ -48,7 +49,97 @@ class ObsPart {
   // used for splitting.  More significantly, it reduces memory
   // traffic incurred by transposition on the coprocessor.
   //
+  // Bags small enough to be indexed narrowly store their indices at
+  // half width, halving both footprint and restaging traffic.  Exactly
+  // one of the two bases is allocated.
+  //
+  const bool narrowIdx;
   IndexT* indexBase;
+  NarrowIdxT* indexNarrow;
+
+
+  /**
+     @return index base of the parametrized width.
+   */
+  template<typename IdxT>
+  IdxT* typedBase() const;
+
+
+  template<typename IdxT>
+  inline void buffers(const StagedCell& mrra,
+		      Obs*& source,
+		      IdxT*& sIdxSource,
+		      Obs*& targ,
+		      IdxT*& sIdxTarg) {
+    IndexT offSource = bufferOff(&mrra);
+    IndexT offTarg = bufferOff(&mrra, true);
+    source = obsCell + offSource;
+    sIdxSource = typedBase<IdxT>() + offSource;
+    targ = obsCell + offTarg;
+    sIdxTarg = typedBase<IdxT>() + offTarg;
+  }
+
+
+  /**
+     @brief Compacts the active positions of a block of paths.
+
+     Successor offsets are claimed without branching on path state,
+     so that the ensuing moves can proceed as a single scatter.
+
+     @param[out] obsSource outputs source positions of active observations.
+
+     @param[out] obsDest outputs the corresponding target positions.
+
+     @return count of active observations in the block.
+   */
+  static IndexT compactBlock(const PathT* prePath,
+			     IndexT blockStart,
+			     IndexT blockEnd,
+			     vector<IndexT>& obsScatter,
+			     IndexT obsSource[],
+			     IndexT obsDest[]);
+
+
+  /**
+     @brief Moves compacted sample indices to their targets.
+   */
+  template<typename IdxT>
+  static void scatterIdx(const IdxT* idxSource,
+			 IdxT* idxTarg,
+			 const IndexT obsSource[],
+			 const IndexT obsDest[],
+			 IndexT nActive) {
+#pragma omp simd
+    for (IndexT i = 0; i < nActive; i++) {
+      idxTarg[obsDest[i]] = idxSource[obsSource[i]];
+    }
+  }
+
+
+  /**
+     @brief Width-specialized restaging bodies.
+   */
+  template<typename IdxT>
+  void restageDiscrete(const PathT* prePath,
+		       const StagedCell& mrra,
+		       vector<IndexT>& obsScatter);
+
+
+  template<typename IdxT>
+  void restageTied(const PathT* prePath,
+		   vector<IndexT>& runCount,
+		   const StagedCell& mrra,
+		   vector<IndexT>& obsScatter);
+
+
+  template<typename IdxT>
+  void restageValues(const PathT* prePath,
+		     vector<IndexT>& runCount,
+		     const StagedCell& mrra,
+		     vector<IndexT>& obsScatter,
+		     vector<IndexT>& valScatter,
+		     const vector<IndexT>& runValue,
+		     vector<IndexT>& ranks);
 
  protected:
   //  vector<unsigned int> destRestage;
@@ -57,8 +148,15 @@ class ObsPart {
   
   
  public:
+  static constexpr IndexT restageBlock = 256; // Positions per compaction.
+  static constexpr IndexT narrowMax = IndexT(1) << 16; // Narrow bag limit.
 
-  ObsPart(const class PredictorFrame* frame, IndexT bagCount_);
+  /**
+     @param strided is true iff every predictor is laid out strided.
+   */
+  ObsPart(const class PredictorFrame* frame,
+	  IndexT bagCount_,
+	  bool strided = false);
 
   virtual ~ObsPart();
 
@@ -66,10 +164,10 @@ class ObsPart {
   /**
      @brief Passes through to bufferOff() using definition coordinate.
    */
-  IndexT* getIdxBuffer(const class SplitNux& nux) const;
+  SampleIdx getIdxBuffer(const class SplitNux& nux) const;
 
 
-  Obs* getBuffers(const class SplitNux& nux, IndexT*& sIdx) const;
+  Obs* getBuffers(const class SplitNux& nux, SampleIdx& sIdx) const;
 
 
   Obs* getPredBase(const class SplitNux& nux) const;
@@ -84,6 +182,22 @@ class ObsPart {
   }
 
 
+  /**
+     @return true iff sample indices are stored at narrow width.
+   */
+  inline bool isNarrow() const {
+    return narrowIdx;
+  }
+
+
+  /**
+     @return view onto the full index buffer.
+   */
+  inline SampleIdx indexView() const {
+    return SampleIdx(indexBase, indexNarrow);
+  }
+
+
   /**
      @brief Sets the staging range for a given predictor.
    */
@@ -136,8 +250,8 @@ class ObsPart {
   }
 
   
-  inline IndexT* idxBuffer(const StagedCell* ancestor) const {
-    return indexBase + bufferOff(ancestor);
+  inline SampleIdx idxBuffer(const StagedCell* ancestor) const {
+    return indexView() + bufferOff(ancestor);
   }
 
   
@@ -145,20 +259,20 @@ class ObsPart {
    */
   inline Obs* buffers(PredictorT predIdx,
 		      unsigned int bufBit,
-		      IndexT*& sIdx) const {
+		      SampleIdx& sIdx) const {
     IndexT offset = bufferOff(predIdx, bufBit);
-    sIdx = indexBase + offset;
+    sIdx = indexView() + offset;
     return obsCell + offset;
   }
 
 
-  inline IndexT* indexBuffer(const StagedCell* mrra) const {
-    return indexBase + bufferOff(mrra->getPredIdx(), mrra->bufIdx);
+  inline SampleIdx indexBuffer(const StagedCell* mrra) const {
+    return indexView() + bufferOff(mrra->getPredIdx(), mrra->bufIdx);
   }
 
 
   Obs* buffers(const StagedCell* mrra,
-	       IndexT*& sIdx) const {
+	       SampleIdx& sIdx) const {
     return buffers(mrra->getPredIdx(), mrra->bufIdx, sIdx);
   }
 
@@ -180,24 +294,6 @@ class ObsPart {
   }
 
 
-  inline void buffers(const StagedCell& mrra,
-		      Obs*& source,
-		      IndexT*& sIdxSource,
-		      Obs*& targ,
-		      IndexT*& sIdxTarg) {
-    source = buffers(mrra.getPredIdx(), mrra.bufIdx, sIdxSource);
-    targ = buffers(mrra.getPredIdx(), mrra.compBuffer(), sIdxTarg);
-  }
-
-
-  inline void indexBuffers(const StagedCell* mrra,
-                           IndexT*& sIdxSource,
-                           IndexT*& sIdxTarg) {
-    sIdxSource = indexBase + bufferOff(mrra);
-    sIdxTarg = indexBase + bufferOff(mrra, true);
-  }
-
-
   /**
      @brief Stable partition of observation and index.
    */
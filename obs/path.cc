@@ -15,23 +15,24 @@
  */
 
 #include <numeric>
+#include <algorithm>
 
 #include "frontier.h"
 #include "path.h"
+#include "bufferpool.h"
 
-IndexT NodePath::noSplit = 0;
-
-
-void NodePath::setNoSplit(IndexT bagCount) {
-  noSplit = bagCount;
+IdxPath::IdxPath(IndexT idxLive_) :
+  idxLive(idxLive_),
+  smIdx(BufferPool::acquire<IndexT>(idxLive)),
+  pathFront(BufferPool::acquire<PathT>(idxLive)) {
+  iota(smIdx, smIdx + idxLive, 0);
+  fill(pathFront, pathFront + idxLive, 0);
 }
 
 
-IdxPath::IdxPath(IndexT idxLive_) :
-  idxLive(idxLive_),
-  smIdx(vector<IndexT>(idxLive)),
-  pathFront(vector<PathT>(idxLive)) {
-  iota(smIdx.begin(), smIdx.end(), 0);
+IdxPath::~IdxPath() {
+  BufferPool::release(smIdx, idxLive);
+  BufferPool::release(pathFront, idxLive);
 }
 
 
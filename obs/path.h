@@ -31,7 +31,9 @@ class NodePath {
   // Maximal path length is also an inattainable path index.
   static constexpr unsigned int noPath = 1 << logPathMax;
 
-  static IndexT noSplit;
+  // Inattainable split index.  Fixed, rather than set from a tree's
+  // bag count, as frontiers of distinct trees may be live at once.
+  static constexpr IndexT noSplit = ~static_cast<IndexT>(0);
   
   IndexT frontIdx; // < noIndex iff path extinct.
   IndexRange bufRange; // buffer target range for path.
@@ -58,12 +60,6 @@ public:
   }
 
 
-  /**
-     @brief Sets noSplit to inattainable split index.
-   */
-  static void setNoSplit(IndexT bagCount);
-
-  
   /**
      @brief Determines whether a path size is representable within
      container.
@@ -147,8 +143,8 @@ class IdxPath {
   static constexpr unsigned int maskLive = maskExtinct - 1;
   static constexpr unsigned int relMax = 1ul << 15;
 
-  vector<IndexT> smIdx; // Root- or node-relative SampleMap index.
-  vector<PathT> pathFront;  // Paths reaching the frontier.
+  IndexT* smIdx; // Root- or node-relative SampleMap index:  pooled.
+  PathT* pathFront;  // Paths reaching the frontier:  pooled.
 
   /**
      @brief Setter for path reaching an index.
@@ -196,6 +192,13 @@ class IdxPath {
 
   IdxPath(IndexT idxLive_);
 
+
+  ~IdxPath();
+
+
+  IdxPath(const IdxPath&) = delete;
+  IdxPath& operator=(const IdxPath&) = delete;
+
   /**
      @brief When appropriate, localizes indexing at the cost of
      trebling span of memory accesses:  char (PathT) vs. char + uint16.
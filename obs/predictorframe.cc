@@ -20,9 +20,17 @@
 #include "ompthread.h"
 #include "splitnux.h"
 
+#include <limits>
+#include <stdexcept>
+
+
+constexpr unsigned int PredictorFrame::binMax;
+
+
 PredictorFrame::PredictorFrame(const RLEFrame* rleFrame_,
 			       double autoCompress,
 			       bool enableCoproc,
+			       bool packRanks_,
 			       vector<string>& diag) :
   rleFrame(rleFrame_),
   nRow(rleFrame->nObs),
@@ -35,9 +43,14 @@ PredictorFrame::PredictorFrame(const RLEFrame* rleFrame_,
   feIndex(mapPredictors(rleFrame->factorTop)),
   noRank(rleFrame->noRank),
   denseThresh(autoCompress * nRow),
-  row2Rank(vector<vector<IndexT>>(nPred)),
+  packRanks(packRanks_),
+  row2Rank(vector<RankColumn>(nPred)),
   nonCompact(0),
   lengthCompact(0) {
+  if (rleFrame->nObs > numeric_limits<IndexT>::max())
+    throw length_error("Observation count exceeds index width");
+  if (rleFrame->rowOrdered)
+    throw invalid_argument("Training frame must be ordered by rank");
   implExpl = denseBlock();
   obsPredictorFrame();
 }
@@ -61,7 +74,7 @@ vector<Layout> PredictorFrame::denseBlock() {
 Layout PredictorFrame::surveyRanks(PredictorT predIdx) {
   IndexT rankMissing = rleFrame->findRankMissing(feIndex[predIdx]);
   
-  row2Rank[predIdx] = vector<IndexT>(nRow);
+  row2Rank[predIdx] = RankColumn(nRow, getRankMax(predIdx), packRanks);
   IndexT denseMax = 0; // Running maximum of run counts.
   PredictorT argMax = noRank;
   PredictorT rankPrev = noRank; // Forces write on first iteration.
@@ -85,12 +98,60 @@ Layout PredictorFrame::surveyRanks(PredictorT predIdx) {
 
     // Piggybacks assignment of rank vector.
     for (IndexT idx = 0; idx != extent; idx++) {
-      row2Rank[predIdx][rle.row + idx] = rank;
+      row2Rank[predIdx].set(rle.row + idx, rank);
     }
   }
 
   // Post condition:  rowTot == nRow.
-  return denseMax <= denseThresh ? Layout(noRank, nRow, rankMissing) : Layout(argMax, nRow - denseMax, rankMissing);
+  // Binary predictors, such as flags and one-hot columns, compress
+  // regardless of threshold:  only the minority value is then staged.
+  bool binary = getRankMax(predIdx) == 1 && rankMissing == noRank;
+  if (denseMax <= denseThresh && !binary)
+    return Layout(noRank, nRow, rankMissing);
+  else
+    return Layout(argMax, nRow - denseMax, rankMissing);
+}
+
+
+void PredictorFrame::quantize(unsigned int nBin) {
+  rankBin.clear(); // Frame may be reused across training sessions.
+  if (nBin == 0 || nPredNum == 0)
+    return;
+
+  nBin = min(nBin, binMax);
+  rankBin = vector<vector<unsigned char>>(nPred);
+#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
+  {
+#pragma omp for schedule(dynamic, 1)
+    for (PredictorT predIdx = 0; predIdx < nPredNum; predIdx++) {
+      rankBin[predIdx] = binRanks(predIdx, nBin);
+    }
+  }
+}
+
+
+vector<unsigned char> PredictorFrame::binRanks(PredictorT predIdx,
+					       unsigned int nBin) const {
+  IndexT rankMissing = getMissingRank(predIdx);
+  vector<IndexT> rankCount(getRankMax(predIdx) + 1);
+  IndexT nObserved = 0;
+  for (auto rle : getRLE(predIdx)) {
+    if (rle.val != rankMissing) {
+      rankCount[rle.val] += rle.extent;
+      nObserved += rle.extent;
+    }
+  }
+
+  // Bin of a rank is determined by the count of observations below it,
+  // so that ranks heavier than a bin's quota occupy bins of their own.
+  vector<unsigned char> bin(rankCount.size());
+  size_t obsBelow = 0;
+  for (IndexT rank = 0; rank != rankCount.size(); rank++) {
+    bin[rank] = min<size_t>(nBin - 1, (obsBelow * nBin) / max<IndexT>(1, nObserved));
+    obsBelow += rankCount[rank];
+  }
+
+  return bin;
 }
 
 
@@ -111,8 +172,12 @@ void PredictorFrame::obsPredictorFrame() {
 
 
 IndexRange PredictorFrame::getSafeRange(PredictorT predIdx,
-				IndexT sampleCount) const {
-  if (implExpl[predIdx].rankImpl == noRank) {
+				IndexT sampleCount,
+				bool strided) const {
+  if (strided) {
+    return IndexRange(predIdx * sampleCount, sampleCount);
+  }
+  else if (implExpl[predIdx].rankImpl == noRank) {
     return IndexRange(implExpl[predIdx].safeOffset * sampleCount, sampleCount);
   }
   else {
@@ -132,7 +197,7 @@ vector<PredictorT> PredictorFrame::cardinalities() const {
 
 vector<PredictorT> PredictorFrame::extents() const {
   vector<PredictorT> extentPred;
-  for (auto facRanked : rleFrame->facRanked) {
+  for (const auto& facRanked : rleFrame->facRanked) {
     extentPred.push_back(facRanked.size());
   }
   return extentPred;
@@ -166,3 +231,15 @@ PredictorT PredictorFrame::getFactorExtent(const class SplitNux& nux) const {
 }
 
 
+
+
+size_t PredictorFrame::getFootprint() const {
+  size_t footprint = rleFrame->getFootprint() + implExpl.capacity() * sizeof(Layout);
+  for (const RankColumn& column : row2Rank) {
+    footprint += column.getBytes();
+  }
+  for (const vector<unsigned char>& bin : rankBin) {
+    footprint += bin.capacity();
+  }
+  return footprint;
+}
@@ -18,6 +18,7 @@
 
 #include "typeparam.h"
 #include "rleframe.h"
+#include "rankcolumn.h"
 
 #include <vector>
 #include <cmath>
@@ -62,8 +63,10 @@ class PredictorFrame {
   const vector<PredictorT> feIndex; ///> Maps core predictor index to user position.
   const PredictorT noRank; // Inattainable rank value.
   const IndexT denseThresh; // Threshold run length for autocompression.
+  const bool packRanks; // Whether ranks are bit-packed.
 
-  vector<vector<IndexT>> row2Rank;
+  vector<RankColumn> row2Rank; // Width adapted to cardinality.
+  vector<vector<unsigned char>> rankBin; // Numeric rank-to-bin maps, iff binned.
   PredictorT nonCompact;  // Total count of uncompactified predictors.
   IndexT lengthCompact;  // Sum of compactified lengths.
   vector<Layout> implExpl;
@@ -117,8 +120,20 @@ class PredictorFrame {
    */
   Layout surveyRanks(PredictorT predIdx);
 
+
+  /**
+     @brief Assigns ranks of a numeric predictor to equal-frequency bins.
+
+     Missing observations are excluded from the frequencies.
+
+     @return rank-to-bin map.
+   */
+  vector<unsigned char> binRanks(PredictorT predIdx,
+				 unsigned int nBin) const;
+
   
 public:
+  static constexpr unsigned int binMax = 256; // Bins representable by a byte.
 
   // Factory parametrized by coprocessor state.
   static PredictorFrame *Factory(const class RLEFrame* rleFrame,
@@ -137,6 +152,7 @@ public:
   PredictorFrame(const RLEFrame* rleFrame_,
 	 double autoCompress,
 	 bool enableCoproc,
+	 bool packRanks_,
 	 vector<string>& diag);
 
 
@@ -193,10 +209,14 @@ public:
 
      @param sampleCount serves as a multiplier for strided access.
 
+     @param strided is true iff all predictors are strided, as when
+     staging a sample subset too small to profit from compaction.
+
      @return safe range.
   */
   IndexRange getSafeRange(PredictorT predIdx,
-			  IndexT sampleCount) const;
+			  IndexT sampleCount,
+			  bool strided = false) const;
 
 
   /**
@@ -217,13 +237,23 @@ public:
 
      @param sampleCount is the desired strided access length.
 
+     @param strided is true iff all predictors are strided.
+
      @return buffer size conforming to conservative constraints.
    */
-  IndexT getSafeSize(IndexT sampleCount) const {
-    return nonCompact * sampleCount + lengthCompact; // TODO:  align.
+  IndexT getSafeSize(IndexT sampleCount,
+		     bool strided = false) const {
+    return strided ? nPred * sampleCount : nonCompact * sampleCount + lengthCompact; // TODO:  align.
   }
 
 
+  /**
+     @return bytes held by the rank tables and layouts, together
+     with the observations they index.
+   */
+  size_t getFootprint() const;
+
+
   /**
      @brief Accessor for dense index vector.
 
@@ -239,7 +269,7 @@ public:
   }
 
 
-  const vector<IndexT>& getRanks(PredictorT predIdx) const {
+  const RankColumn& getRanks(PredictorT predIdx) const {
     return row2Rank[predIdx];
   }
 
@@ -249,7 +279,7 @@ public:
   }
   
 
-  const vector<RLEVal<szType>>& getRLE(PredictorT predIdx) const {
+  const FrameArray<RLEIdx>& getRLE(PredictorT predIdx) const {
     return rleFrame->getRLE(feIndex[predIdx]);
   }
 
@@ -258,6 +288,67 @@ public:
     return rleFrame->getRLE(feIndex[predIdx]).back().val;
   }
 
+
+  /**
+     @brief Quantizes the numeric predictors into at most 'nBin' bins.
+
+     Cuts are subsequently considered only between bins, rather than
+     between every pair of distinct ranks.
+
+     @param nBin is the bin count; zero retains exact ranks.  Any
+     previous quantization is discarded.
+   */
+  void quantize(unsigned int nBin);
+
+
+  /**
+     @return true iff predictor has been quantized.
+   */
+  inline bool isBinned(PredictorT predIdx) const {
+    return !rankBin.empty() && !rankBin[predIdx].empty();
+  }
+
+
+  /**
+     @return true iff any predictor has been quantized.
+   */
+  inline bool isBinned() const {
+    return !rankBin.empty();
+  }
+
+
+  /**
+     @brief Looks up the bin of a non-missing rank.
+
+     @return bin index of rank of a quantized predictor.
+   */
+  inline unsigned int getBin(PredictorT predIdx,
+			     IndexT rank) const {
+    return rankBin[predIdx][rank];
+  }
+
+
+  /**
+     @brief Determines whether a rank continues the run of its predecessor.
+
+     Binned predictors run over all ranks of a bin, excepting the
+     missing rank, which always has a run of its own.
+
+     @param rankPrev is the preceding rank, possibly noRank.
+
+     @return true iff ranks are identical or share a bin.
+   */
+  inline bool sameRun(PredictorT predIdx,
+		      IndexT rank,
+		      IndexT rankPrev) const {
+    if (rank == rankPrev)
+      return true;
+    else if (rankPrev == noRank || !isBinned(predIdx) || rank == getMissingRank(predIdx) || rankPrev == getMissingRank(predIdx))
+      return false;
+    else
+      return rankBin[predIdx][rank] == rankBin[predIdx][rankPrev];
+  }
+
   
   /**
      @brief Determines whether predictor is numeric or factor.
@@ -0,0 +1,194 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file rankcolumn.h
+
+   @brief Row-indexed ranks of a single predictor, stored at the
+   narrowest width accommodating the predictor's cardinality.
+
+   @author Mark Seligman
+ */
+
+#ifndef OBS_RANKCOLUMN_H
+#define OBS_RANKCOLUMN_H
+
+#include "typeparam.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+/**
+   @brief Read-only view of bit-packed ranks.
+
+   Indexed as a plain rank array, so that readers templated on
+   width accept it in place of a pointer.
+ */
+class PackedRanks {
+  const uint64_t* word;
+  const unsigned int bits; // Bits per rank, nonzero.
+  const uint64_t mask;
+
+public:
+  PackedRanks(const uint64_t* word_,
+	      unsigned int bits_) :
+    word(word_),
+    bits(bits_),
+    mask(bits == 64 ? ~0ull : (1ull << bits) - 1) {
+  }
+
+
+  inline IndexT operator[](IndexT row) const {
+    size_t bitPos = static_cast<size_t>(row) * bits;
+    size_t wordIdx = bitPos >> 6;
+    unsigned int offset = bitPos & 0x3f;
+    uint64_t val = word[wordIdx] >> offset;
+    if (offset + bits > 64)
+      val |= word[wordIdx + 1] << (64 - offset);
+    return static_cast<IndexT>(val & mask);
+  }
+};
+
+
+/**
+   @brief Ranks of a predictor, by row.
+
+   Width is fixed at construction from the predictor's highest rank:
+   one, two or four bytes, or the minimal number of bits if packing.
+   Most training columns have few distinct values, so the frame's
+   largest allocation shrinks by a factor of two to four, or more when
+   packed.
+ */
+class RankColumn {
+  IndexT nRow;
+  unsigned int bits; // Bits per rank if packed, else zero.
+  vector<uint8_t> rank8;
+  vector<uint16_t> rank16;
+  vector<IndexT> rank32;
+  vector<uint64_t> packed; // Padded by a word, iff packed.
+
+public:
+
+  RankColumn() :
+    nRow(0),
+    bits(0) {
+  }
+
+
+  /**
+     @param rankMax is the highest rank to be stored.
+
+     @param pack is true iff ranks are to be bit-packed.
+   */
+  RankColumn(IndexT nRow_,
+	     IndexT rankMax,
+	     bool pack) :
+    nRow(nRow_),
+    bits(0) {
+    if (pack) {
+      bits = 1;
+      while (bits < 32 && (rankMax >> bits) != 0)
+	bits++;
+      packed = vector<uint64_t>((static_cast<size_t>(nRow) * bits + 63) / 64 + 1);
+    }
+    else if (rankMax <= UINT8_MAX) {
+      rank8 = vector<uint8_t>(nRow);
+    }
+    else if (rankMax <= UINT16_MAX) {
+      rank16 = vector<uint16_t>(nRow);
+    }
+    else {
+      rank32 = vector<IndexT>(nRow);
+    }
+  }
+
+
+  IndexT size() const {
+    return nRow;
+  }
+
+
+  /**
+     @return bytes held by the column.
+   */
+  size_t getBytes() const {
+    return rank8.capacity() * sizeof(uint8_t) + rank16.capacity() * sizeof(uint16_t)
+      + rank32.capacity() * sizeof(IndexT) + packed.capacity() * sizeof(uint64_t);
+  }
+
+
+  /**
+     @return bits per stored rank.
+   */
+  unsigned int getWidth() const {
+    return bits != 0 ? bits : (!rank8.empty() ? 8 : (!rank16.empty() ? 16 : 32));
+  }
+
+
+  /**
+     @brief Assigns a rank.  Not safe for concurrent writers.
+   */
+  inline void set(IndexT row,
+		  IndexT rank) {
+    if (bits != 0) {
+      size_t bitPos = static_cast<size_t>(row) * bits;
+      size_t wordIdx = bitPos >> 6;
+      unsigned int offset = bitPos & 0x3f;
+      packed[wordIdx] |= static_cast<uint64_t>(rank) << offset;
+      if (offset + bits > 64)
+	packed[wordIdx + 1] |= static_cast<uint64_t>(rank) >> (64 - offset);
+    }
+    else if (!rank8.empty()) {
+      rank8[row] = rank;
+    }
+    else if (!rank16.empty()) {
+      rank16[row] = rank;
+    }
+    else {
+      rank32[row] = rank;
+    }
+  }
+
+
+  /**
+     @brief Invokes a reader with the column at its native width.
+
+     @param read accepts an indexable rank array:  a typed pointer or
+     a PackedRanks view.
+   */
+  template<typename Reader>
+  auto dispatch(Reader read) const {
+    if (bits != 0)
+      return read(PackedRanks(&packed[0], bits));
+    else if (!rank8.empty())
+      return read(&rank8[0]);
+    else if (!rank16.empty())
+      return read(&rank16[0]);
+    else
+      return read(rank32.empty() ? nullptr : &rank32[0]);
+  }
+
+
+  /**
+     @return rank at a given row, for occasional access.
+   */
+  inline IndexT operator[](IndexT row) const {
+    if (bits != 0)
+      return PackedRanks(&packed[0], bits)[row];
+    else if (!rank8.empty())
+      return rank8[row];
+    else if (!rank16.empty())
+      return rank16[row];
+    else
+      return rank32[row];
+  }
+};
+
+#endif
@@ -17,6 +17,7 @@
 #include "response.h"
 #include "sampledobs.h"
 #include "sampler.h"
+#include "obs.h"
 
 #include <algorithm>
 
@@ -24,9 +25,9 @@ ResponseReg::ResponseReg(const vector<double>& y_) :
   Response(),
   yTrain(y_),
   defaultPrediction(meanTrain()) {
-  double yMax = 0.0;
-  for (auto y : yTrain) {
-    yMax = max(yMax, abs(y));
+  if (!yTrain.empty()) {
+    auto yRange = minmax_element(yTrain.begin(), yTrain.end());
+    Obs::setRange(*yRange.first, *yRange.second);
   }
 }
 
@@ -39,9 +40,9 @@ ResponseCtg::ResponseCtg(const vector<PredictorT>& yCtg_,
   nCtg(nCtg_),
   classWeight(classWeight_),
   defaultPrediction(ctgDefault()) {
-  double yMax = 0.0;
-  for (auto y : classWeight) {
-    yMax = max(yMax, y);
+  if (!classWeight.empty()) {
+    auto yRange = minmax_element(classWeight.begin(), classWeight.end());
+    Obs::setRange(*yRange.first, *yRange.second);
   }
 }
 
@@ -123,6 +124,26 @@ double ResponseReg::predictObs(const Predict* predict, size_t row) const {
 }
 
 
+void ResponseReg::predictSweep(const Predict* predict,
+			       size_t row,
+			       const vector<unsigned int>& sweep,
+			       double yPrefix[]) const {
+  double sumScore = 0.0;
+  unsigned int nEst = 0;
+  unsigned int tIdx = 0;
+  for (size_t sIdx = 0; sIdx != sweep.size(); sIdx++) {
+    for (; tIdx < sweep[sIdx]; tIdx++) {
+      double score;
+      if (predict->isLeafIdx(row, tIdx, score)) {
+	nEst++;
+	sumScore += score;
+      }
+    }
+    yPrefix[sIdx] = nEst > 0 ? sumScore / nEst : defaultPrediction;
+  }
+}
+
+
 PredictorT ResponseCtg::predictObs(const Predict* predict, size_t row, unsigned int* census) const {
   unsigned int nEst = 0;
   vector<double> ctgJitter(nCtg);
@@ -143,6 +164,31 @@ PredictorT ResponseCtg::predictObs(const Predict* predict, size_t row, unsigned
 }
 
 
+void ResponseCtg::predictSweep(const Predict* predict,
+			       size_t row,
+			       const vector<unsigned int>& sweep,
+			       unsigned int census[],
+			       vector<double>& ctgJitter,
+			       PredictorT ctgPrefix[]) const {
+  fill(census, census + nCtg, 0);
+  fill(ctgJitter.begin(), ctgJitter.end(), 0.0);
+  unsigned int nEst = 0;
+  unsigned int tIdx = 0;
+  for (size_t sIdx = 0; sIdx != sweep.size(); sIdx++) {
+    for (; tIdx < sweep[sIdx]; tIdx++) {
+      double score;
+      if (predict->isLeafIdx(row, tIdx, score)) {
+	nEst++;
+	PredictorT ctg = floor(score);
+	census[ctg]++;
+	ctgJitter[ctg] += score - ctg;
+      }
+    }
+    ctgPrefix[sIdx] = nEst > 0 ? argMaxJitter(census, ctgJitter) : defaultPrediction;
+  }
+}
+
+
 PredictorT ResponseCtg::argMaxJitter(const unsigned int* census,
 				     const vector<double>& ctgJitter) const {
   PredictorT argMax = 0;
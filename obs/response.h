@@ -119,6 +119,20 @@ public:
    */
   double predictObs(const class Predict* predict,
 		    size_t row) const;
+
+
+  /**
+     @brief As above, but predicts over each of a nested sequence of
+     forest prefixes.
+
+     @param sweep holds increasing tree counts.
+
+     @param[out] yPrefix outputs the prediction at each count.
+   */
+  void predictSweep(const class Predict* predict,
+		    size_t row,
+		    const vector<unsigned int>& sweep,
+		    double yPrefix[]) const;
 };
 
 
@@ -162,6 +176,11 @@ public:
   }
 
 
+  const vector<PredictorT>& getYCtg() const {
+    return yCtg;
+  }
+
+
   PredictorT getNCtg() const {
     return nCtg;
   }
@@ -179,6 +198,21 @@ public:
   PredictorT predictObs(const class Predict* predict,
 			size_t row,
 			unsigned int* census) const;
+
+
+  /**
+     @brief As above, but predicts over nested forest prefixes.
+
+     @param[in, out] census, ctgJitter are workspaces of 'nCtg' slots.
+
+     @param[out] ctgPrefix outputs the category at each tree count.
+   */
+  void predictSweep(const class Predict* predict,
+		    size_t row,
+		    const vector<unsigned int>& sweep,
+		    unsigned int census[],
+		    vector<double>& ctgJitter,
+		    PredictorT ctgPrefix[]) const;
   
   
   PredictorT argMaxJitter(const unsigned int* census,
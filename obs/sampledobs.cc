@@ -18,9 +18,9 @@
 #include "response.h"
 #include "sampledobs.h"
 #include "predictorframe.h"
-#include "ompthread.h"
 
 #include <numeric>
+#include <algorithm>
 
 
 SampledObs::SampledObs(const Sampler* sampler,
@@ -33,6 +33,44 @@ SampledObs::SampledObs(const Sampler* sampler,
   bagSum(0.0) {
 }
 
+
+/**
+   @return total multiplicity of the samples indexed.
+ */
+static inline IndexT subsetSCount(const SampledObs* sampledObs,
+				  const vector<IndexT>& sIdx) {
+  IndexT sCount = 0;
+  for (IndexT idx : sIdx) {
+    sCount += sampledObs->getSCount(idx);
+  }
+  return sCount;
+}
+
+
+SampledObs::SampledObs(const SampledObs* sampledObs,
+		       const vector<IndexT>& sIdx) :
+  nSamp(subsetSCount(sampledObs, sIdx)),
+  adder(nullptr),
+  ctgRoot(vector<SumCount>(sampledObs->getNCtg())),
+  bagCount(sIdx.size()),
+  bagSum(0.0) {
+  sampleNux.reserve(bagCount);
+  sample2Row.reserve(bagCount);
+  for (IndexT idx : sIdx) {
+    sampleNux.push_back(sampledObs->sampleNux[idx]);
+    sample2Row.push_back(sampledObs->sample2Row[idx]);
+    const SampleNux& nux = sampleNux.back();
+    bagSum += nux.getYSum();
+    if (!ctgRoot.empty())
+      ctgRoot[nux.getCtg()] += SumCount(nux.getYSum(), nux.getSCount());
+  }
+}
+
+
+unique_ptr<SampledObs> SampledObs::subset(const vector<IndexT>& sIdx) const {
+  return unique_ptr<SampledObs>(new SampledObs(this, sIdx));
+}
+
     
 unique_ptr<SampleCtg> SampledObs::factoryCtg(const Sampler* sampler,
 					     const Response* response,
@@ -105,9 +143,11 @@ void SampledObs::bagSamples(const Sampler* sampler,
   IndexT row = 0;
   bagCount = sampler->getExtent(tIdx);
   fill(row2Sample.begin(), row2Sample.end(), bagCount);
+  sample2Row = vector<IndexT>(bagCount);
   for (SamplerNux nux : sampler->getSamples(tIdx)) {
     row += nux.getDelRow();
     bagSum += (this->*adder)(y[row], nux, yCtg[row]);
+    sample2Row[sIdx] = row;
     row2Sample[row] = sIdx++;
   }
  //}
@@ -118,6 +158,7 @@ void SampledObs::bagTrivial(const vector<double>& y,
 			const vector<PredictorT>& yCtg) {
   bagCount = row2Sample.size();
   iota(row2Sample.begin(), row2Sample.end(), 0);
+  sample2Row = row2Sample;
   SamplerNux nux(1, 1);
   for (IndexT row = 0; row < bagCount; row++) {
     bagSum += (this->*adder)(y[row], nux, yCtg[row]);
@@ -125,32 +166,8 @@ void SampledObs::bagTrivial(const vector<double>& y,
 }
 
 
-void SampledObs::setRanks(const PredictorFrame* layout) {
-  sample2Rank = vector<vector<IndexT>>(layout->getNPred());
-  runCount = vector<IndexT>(layout->getNPred());
-
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound predIdx = 0; predIdx != layout->getNPred(); predIdx++)
-      sample2Rank[predIdx] = sampleRanks(layout, predIdx);
-  }
-}
-
-
-vector<IndexT> SampledObs::sampleRanks(const PredictorFrame* layout, PredictorT predIdx) {
-  vector<IndexT> sampledRanks(bagCount);
-  const vector<IndexT>& row2Rank = layout->getRanks(predIdx);
-  IndexT sIdx = 0;
-  vector<unsigned char> rankSeen(row2Rank.size());
-  for (IndexT row = 0; row != row2Rank.size(); row++) {
-    if (row2Sample[row] < bagCount) {
-      IndexT rank = row2Rank[row];
-      sampledRanks[sIdx++] = rank;
-      rankSeen[rank] = 1;
-    }
-  }
-  runCount[predIdx] = accumulate(rankSeen.begin(), rankSeen.end(), 0);
-
-  return sampledRanks;
+IndexT SampledObs::getRank(const PredictorFrame* frame,
+			   PredictorT predIdx,
+			   IndexT sIdx) const {
+  return frame->getRanks(predIdx)[sample2Row[sIdx]];
 }
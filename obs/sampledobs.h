@@ -22,6 +22,8 @@
 #include "obs.h"
 
 #include <vector>
+#include <algorithm>
+#include <limits>
 
 
 /**
@@ -34,12 +36,9 @@ class SampledObs {
   vector<SampleNux> sampleNux; // Per-sample summary, with row-delta.
   vector<SumCount> ctgRoot; // Root census of categorical response.
   vector<IndexT> row2Sample; // Maps row index to sample index.
+  vector<IndexT> sample2Row; // Inverse of row2Sample, over bagged rows.
   IndexT bagCount;
   double bagSum; // Sum of bagged responses.
-
-  vector<vector<IndexT>> sample2Rank; ///< Splitting rank map.
-  vector<IndexT> runCount; ///< Staging initialization.
-  
   
   /**
      @brief Samples rows and counts resulting occurrences.
@@ -62,10 +61,13 @@ class SampledObs {
 
 
   /**
-     @return map from sample index to predictor rank.
+     @brief Subset constructor:  retains a selection of samples.
+
+     @param sIdx are the indices of the retained samples.
    */
-  vector<IndexT> sampleRanks(const class PredictorFrame* layout,
-			     PredictorT predIdx);
+  SampledObs(const SampledObs* sampledObs,
+	     const vector<IndexT>& sIdx);
+
 
 public:
 
@@ -108,10 +110,31 @@ public:
 	 double (SampledObs::* adder_)(double, const class SamplerNux&, PredictorT) = nullptr);
 
   
+  /**
+     @brief Copies a selection of samples, as for training a subtree.
+
+     The copy is indexed by position within the selection and, lacking
+     a row map, is staged from its samples rather than from the frame.
+
+     @param sIdx are the indices of the samples retained.
+
+     @return new instance over the selected samples.
+   */
+  unique_ptr<SampledObs> subset(const vector<IndexT>& sIdx) const;
+
+
+  /**
+     @return true iff the instance is a subset of another.
+   */
+  inline bool isSubset() const {
+    return row2Sample.empty();
+  }
+
+
   /**
      @brief Getter for root category census vector.
    */
-  inline const vector<SumCount> getCtgRoot() const {
+  inline const vector<SumCount>& getCtgRoot() const {
     return ctgRoot;
   }
 
@@ -166,6 +189,16 @@ public:
   }
 
 
+  /**
+     @brief Getter for a sample's summary.
+
+     @param sIdx is the sample index.
+   */
+  inline const SampleNux& getNux(IndexT sIdx) const {
+    return sampleNux[sIdx];
+  }
+
+
   /**
      @brief Getter for sample count.
 
@@ -176,6 +209,16 @@ public:
   }
 
 
+  /**
+     @brief Getter for the row sampled.
+
+     @param sIdx is the sample index.
+   */
+  inline IndexT getRow(IndexT sIdx) const {
+    return sample2Row[sIdx];
+  }
+
+
   /**
      @brief Getter for row delta.
 
@@ -204,18 +247,74 @@ public:
   }
 
 
-  inline IndexT getRank(PredictorT predIdx,
-		 IndexT sIdx) const {
-    return sample2Rank[predIdx][sIdx];
-  }
+  /**
+     @brief Computes the information gain of a partition isolating each
+     sample of a set or, for classification, each category.
 
+     No split partitions a set more finely, so the gain bounds that of
+     any split.  Sums are accumulated afresh, free of the rounding
+     carried by the running sums of the set's ancestors.
 
-  inline IndexT getRunCount(PredictorT predIdx) const {
-    return runCount[predIdx];
+     @param extent is the number of samples in the set.
+
+     @param sampleIdx maps a position within the set to a sample index.
+
+     @return gain allowing for rounding, or exactly zero if the set's
+     response is constant.
+   */
+  template<typename IdxFn>
+  double isolationGain(IndexT extent,
+		       IdxFn sampleIdx) const {
+    constexpr double roundSlack = 1.0e-12; // Relative to summands.
+    double sum = 0.0;
+    double squares = 0.0;
+    IndexT sCount = 0;
+    double yMin = numeric_limits<double>::max();
+    double yMax = numeric_limits<double>::lowest();
+    vector<double> ctgSum(ctgRoot.size());
+    for (IndexT pos = 0; pos != extent; pos++) {
+      IndexT sIdx = sampleIdx(pos);
+      double ySum = getSum(sIdx);
+      IndexT sc = getSCount(sIdx);
+      sum += ySum;
+      sCount += sc;
+      if (ctgSum.empty()) {
+	double y = ySum / sc;
+	yMin = min(yMin, y);
+	yMax = max(yMax, y);
+	squares += ySum * y;
+      }
+      else {
+	ctgSum[getCtg(sIdx)] += ySum;
+      }
+    }
+
+    if (ctgSum.empty()) {
+      return yMin == yMax ? 0.0 : squares - (sum * sum) / sCount + roundSlack * squares;
+    }
+    else {
+      PredictorT nPopulated = 0;
+      for (double ctgS : ctgSum) {
+	squares += ctgS * ctgS;
+	nPopulated += ctgS != 0.0 ? 1 : 0;
+      }
+      return nPopulated <= 1 ? 0.0 : sum - squares / sum + roundSlack * sum;
+    }
   }
 
-  
-  void setRanks(const class PredictorFrame* layout);
+
+  /**
+     @brief Looks up the rank of a sample through its row.
+
+     Ranks are not cached by sample, as staging consumes them directly
+     from the frame.  Lookup is only performed when a split value is
+     assigned, so indirection is inexpensive.
+
+     @return rank of the sample's row.
+   */
+  IndexT getRank(const class PredictorFrame* frame,
+		 PredictorT predIdx,
+		 IndexT sIdx) const;
 };
 
 
@@ -0,0 +1,66 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file sampleidx.h
+
+   @brief Sample-index buffers of either narrow or full width.
+
+   @author Mark Seligman
+ */
+
+#ifndef OBS_SAMPLEIDX_H
+#define OBS_SAMPLEIDX_H
+
+#include "typeparam.h"
+
+#include <cstdint>
+
+
+typedef uint16_t NarrowIdxT; // Suffices for bags of at most 2^16 samples.
+
+
+/**
+   @brief View onto a sample-index buffer, narrow or wide.
+
+   Exactly one base is non-null.  Width is fixed per tree, so the
+   dispatch is invariant over any loop employing the view.
+ */
+struct SampleIdx {
+  IndexT* wide;
+  NarrowIdxT* narrow;
+
+  SampleIdx(IndexT* wide_ = nullptr,
+	    NarrowIdxT* narrow_ = nullptr) :
+    wide(wide_),
+    narrow(narrow_) {
+  }
+
+
+  inline IndexT operator[](IndexT idx) const {
+    return narrow == nullptr ? wide[idx] : narrow[idx];
+  }
+
+
+  inline void set(IndexT idx,
+		  IndexT sIdx) const {
+    if (narrow == nullptr)
+      wide[idx] = sIdx;
+    else
+      narrow[idx] = sIdx;
+  }
+
+
+  /**
+     @return view displaced by an offset.
+   */
+  inline SampleIdx operator+(IndexT offset) const {
+    return narrow == nullptr ? SampleIdx(wide + offset) : SampleIdx(nullptr, narrow + offset);
+  }
+};
+
+#endif
@@ -16,39 +16,28 @@
 #include "candrf.h"
 #include "interlevel.h"
 #include "frontier.h"
+#include "trainparam.h"
 
 
-PredictorT CandRF::predFixed = 0;
-vector<double> CandRF::predProb;
-
-
-CandRF::CandRF(InterLevel* interLevel) :
-  Cand(interLevel) {
-}
-
-
-
-void CandRF::init(PredictorT feFixed,
-	     const vector<double>& feProb) {
-  predFixed = feFixed;
-  for (auto prob : feProb) {
-    predProb.push_back(prob);
-  }
-}
-
-
-void CandRF::deInit() {
-  predFixed = 0;
-  predProb.clear();
+CandRF::CandRF(InterLevel* interLevel,
+	       LevelArena* arena) :
+  Cand(interLevel, arena) {
 }
 
 
 void CandRF::precandidates(const Frontier* frontier,
 			   InterLevel* interLevel) {
-  if (predFixed == 0) {
-    candidateBernoulli(frontier, interLevel, predProb);
+  const TrainParam* param = frontier->getParam();
+  if (param->walker != nullptr) {
+    candidateWeighted(frontier, interLevel, *param->walker, param->nPositive, param->predFixed, param->probSum);
+  }
+  else if (param->predFixed == 0) {
+    if (param->probCommon >= 0.0)
+      candidateGeometric(frontier, interLevel, param->probCommon);
+    else
+      candidateBernoulli(frontier, interLevel, param->predProb);
   }
   else {
-    candidateFixed(frontier, interLevel, predFixed);
+    candidateFixed(frontier, interLevel, param->predFixed);
   }
 }
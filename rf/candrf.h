@@ -26,23 +26,15 @@
  */
 struct CandRF : public Cand {
 
-  CandRF(class InterLevel* interLevel);
-
-  
-  static void init(PredictorT feFixed,
-		   const vector<double>& feProb);
-
-  static void deInit();
+  CandRF(class InterLevel* interLevel,
+	 class LevelArena* arena);
 
   
+  /**
+     @brief Samples predictors as specified by the frontier's session.
+   */
   void precandidates(const class Frontier* frontier,
 		     class InterLevel* interLevel);
-
-
-private:
-  // Predictor sampling paraemters.
-  static PredictorT predFixed;
-  static vector<double> predProb;
 };
 
 #endif
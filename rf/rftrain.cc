@@ -14,29 +14,80 @@
 */
 
 #include "rftrain.h"
-#include "bv.h"
-#include "train.h"
+#include "trainparam.h"
 #include "predictorframe.h"
-#include "frontier.h"
-#include "pretree.h"
-#include "partition.h"
-#include "sfcart.h"
-#include "splitnux.h"
-#include "sampler.h"
-#include "candrf.h"
+#include "samplenux.h"
 #include "ompthread.h"
-#include "coproc.h"
 
 #include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+void RfTrain::initProb(TrainParam* param,
+		       PredictorT predFixed,
+		       const vector<double> &predProb,
+		       bool predAlias) {
+  param->predFixed = predFixed;
+  param->predProb = predProb;
+  param->probCommon = predProb.empty() ? -1.0 : predProb[0];
+  for (auto prob : predProb) {
+    if (prob != param->probCommon) {
+      param->probCommon = -1.0;
+      break;
+    }
+  }
+
+  if (predAlias && param->probCommon < 0.0) {
+    param->setWeighted(predProb);
+  }
+}
+
+
+void RfTrain::initTree(TrainParam* param,
+		       IndexT leafMax) {
+  param->leafMax = leafMax;
+}
+
+
+void RfTrain::initPrune(TrainParam* param,
+			double pruneCost) {
+  param->pruneCost = pruneCost;
+}
+
+
+void RfTrain::initHistory(TrainParam* param,
+			  size_t historyBudget) {
+  param->historyBudget = historyBudget;
+}
+
 
-void RfTrain::initProb(PredictorT predFixed,
-                     const vector<double> &predProb) {
-  CandRF::init(predFixed, predProb);
+void RfTrain::initExtraTrees(TrainParam* param,
+			     bool extraTrees) {
+  param->extraTrees = extraTrees;
 }
 
 
-void RfTrain::initTree(IndexT leafMax) {
-  PreTree::init(leafMax);
+void RfTrain::initSketch(TrainParam* param,
+			 IndexT nCut) {
+  param->nCut = nCut;
+}
+
+
+void RfTrain::initScreen(TrainParam* param,
+			  unsigned int screenTrees,
+			  double screenWeight) {
+  param->screenTrees = screenTrees;
+  param->screenWeight = screenWeight;
+}
+
+
+void RfTrain::initBlock(TrainParam* param,
+			unsigned int trainBlock,
+			unsigned int treeThread,
+			bool levelSync) {
+  param->treeThread = max(1u, treeThread);
+  param->trainBlock = max(trainBlock, param->treeThread);
+  param->levelSync = levelSync;
 }
 
 
@@ -45,29 +96,55 @@ void RfTrain::initOmp(unsigned int nThread) {
 }
 
 
-void RfTrain::initSplit(unsigned int minNode,
-                      unsigned int totLevels,
-                      double minRatio,
-		      const vector<double>& feSplitQuant) {
-  IndexSet::immutables(minNode);
-  Frontier::immutables(totLevels);
-  SplitNux::immutables(minRatio, feSplitQuant);
+void RfTrain::initSplit(TrainParam* param,
+			unsigned int minNode,
+			unsigned int totLevels,
+			double minRatio,
+			const vector<double>& feSplitQuant) {
+  param->minNode = minNode;
+  param->totLevels = totLevels;
+  param->minRatio = minRatio;
+  param->splitQuant = feSplitQuant;
 }
 
 
-void RfTrain::initMono(const PredictorFrame* frame,
+void RfTrain::initMono(TrainParam* param,
+		       const PredictorFrame* frame,
 		       const vector<double> &regMono) {
-  SFRegCart::immutables(frame, regMono);
+  auto numFirst = frame->getNumFirst();
+  auto numExtent = frame->getNPredNum();
+  auto monoCount = count_if(regMono.begin() + numFirst, regMono.begin() + numExtent, [] (double prob) { return prob != 0.0; });
+  if (monoCount > 0) {
+    param->mono.assign(regMono.begin() + numFirst, regMono.begin() + numFirst + numExtent);
+  }
+}
+
+
+void RfTrain::initSubtree(TrainParam* param,
+			  IndexT subtreeMax) {
+  param->subtreeMax = subtreeMax;
+}
+
+
+void RfTrain::initMulti(TrainParam* param,
+			const vector<double>& yMulti,
+			unsigned int nOut) {
+  if (nOut == 0 || yMulti.size() % nOut != 0)
+    throw invalid_argument("Joint responses must conform with training rows");
+
+  // Transposed, so that a sample's responses are contiguous.
+  size_t nObs = yMulti.size() / nOut;
+  param->nOut = nOut;
+  param->yMulti = vector<double>(yMulti.size());
+  for (unsigned int out = 0; out != nOut; out++) {
+    for (size_t row = 0; row != nObs; row++) {
+      param->yMulti[row * nOut + out] = yMulti[out * nObs + row];
+    }
+  }
 }
 
 
 void RfTrain::deInit() {
-  SplitNux::deImmutables();
-  IndexSet::deImmutables();
-  Frontier::deImmutables();
-  PreTree::deInit();
   SampleNux::deImmutables();
-  CandRF::deInit();
-  SFRegCart::deImmutables();
   OmpThread::deInit();
 }
@@ -22,21 +22,91 @@
 
 
 /**
-   @brief Interface class for front end.  Holds simulation-specific parameters
-   of the data and constructs forest, leaf and diagnostic structures.
+   @brief Interface class for front end.  Fills in the session-specific
+   parameters of the data and initializes process-wide state.
 */
 struct RfTrain {
 
   /**
      @brief Registers per-node probabilities of predictor selection.
+
+     @param param is the session's parameter block.
+
+     @param predAlias selects weighted sampling by alias table.
   */
-  static void initProb(unsigned int predFixed,
-                       const vector<double> &predProb);
+  static void initProb(struct TrainParam* param,
+		       unsigned int predFixed,
+                       const vector<double> &predProb,
+		       bool predAlias = false);
 
   /**
      @brief Registers tree-shape parameters.
   */
-  static void initTree(IndexT leafMax);
+  static void initTree(struct TrainParam* param,
+		       IndexT leafMax);
+
+
+  /**
+     @brief Registers the cost-complexity penalty per leaf.
+  */
+  static void initPrune(struct TrainParam* param,
+			double pruneCost);
+
+
+  /**
+     @brief Registers the memory budget of the restaging history.
+
+     @param historyBudget is a byte count, zero denoting no limit.
+   */
+  static void initHistory(struct TrainParam* param,
+			  size_t historyBudget);
+
+
+  /**
+     @brief Registers the splitting mode.
+
+     @param extraTrees is true iff candidates are split at a single
+     random cut, as in extremely-randomized trees.
+   */
+  static void initExtraTrees(struct TrainParam* param,
+			     bool extraTrees);
+
+
+  /**
+     @brief Registers approximate numeric splitting.
+
+     @param nCut is the number of evenly-spaced positions at which a
+     numeric scan evaluates cuts, zero denoting all positions.
+   */
+  static void initSketch(struct TrainParam* param,
+			 IndexT nCut);
+
+
+  /**
+     @brief Registers the global predictor screen.
+
+     @param screenTrees is the number of trees after which predictors
+     yet to accrue information are screened, zero denoting no screen.
+
+     @param screenWeight scales the sampling weight of screened
+     predictors.
+   */
+  static void initScreen(struct TrainParam* param,
+			 unsigned int screenTrees,
+			 double screenWeight);
+
+
+  /**
+     @brief Registers tree blocking.
+
+     @param treeThread is the number of trees to train concurrently.
+
+     @param levelSync is true iff a block's trees split in lockstep.
+   */
+  static void initBlock(struct TrainParam* param,
+			unsigned int trainBlock,
+			unsigned int treeThread = 1,
+			bool levelSync = false);
 
   /**
      @brief Initializes static OMP thread state.
@@ -57,7 +127,8 @@ struct RfTrain {
      
      @param splitQuant is a per-predictor quantile specification.
   */
-  static void initSplit(unsigned int minNode,
+  static void initSplit(struct TrainParam* param,
+			unsigned int minNode,
                         unsigned int totLevels,
                         double minRatio,
 			const vector<double>& feSplitQuant);
@@ -68,9 +139,32 @@ struct RfTrain {
      @param regMono has length equal to the predictor count.  Only
      numeric predictors may have nonzero entries.
   */
-  static void initMono(const class PredictorFrame* frame,
+  static void initMono(struct TrainParam* param,
+		       const class PredictorFrame* frame,
                        const vector<double> &regMono);
 
+
+  /**
+     @brief Registers the extent below which nodes train depth-first.
+
+     @param subtreeMax is a sample count, zero denoting breadth-first
+     training throughout.
+   */
+  static void initSubtree(struct TrainParam* param,
+			  IndexT subtreeMax);
+
+
+  /**
+     @brief Registers several regression responses to be split jointly.
+
+     @param yMulti holds each response over all training rows in turn.
+
+     @param nOut is the number of responses.
+   */
+  static void initMulti(struct TrainParam* param,
+			const vector<double>& yMulti,
+			unsigned int nOut);
+
   /**
      @brief Static de-initializer.
    */
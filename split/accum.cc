@@ -51,15 +51,15 @@ CtgNux Accum::filterMissingCtg(const SFCtg* sfCtg,
 			       const SplitNux& cand) const {
   vector<double> ctgSum = sfCtg->ctgNodeSums(cand);
   double sumSquares = sfCtg->getSumSquares(cand);
+  CtgNux ctgNux(ctgSum, sumSquares, sfCtg->ctgLocalMap(cand));
   for (IndexT obsIdx = obsEnd; obsIdx != obsEnd + cand.getNMissing(); obsIdx++) {
     const Obs& obs = obsCell[obsIdx];
-    PredictorT ctg = obs.getCtg();
     double ySum = obs.getYSum();
-    sumSquares -= ySum * ySum;
-    ctgSum[ctg] -= ySum;
+    ctgNux.sumSquares -= ySum * ySum;
+    ctgNux.ctgSum[ctgNux.local(obs.getCtg())] -= ySum;
   }
 
-  return CtgNux(ctgSum, sumSquares);
+  return ctgNux;
 }
 
 
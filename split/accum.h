@@ -16,6 +16,7 @@
 
 #include "typeparam.h"
 #include "sumcount.h"
+#include "sampleidx.h"
 
 
 /**
@@ -24,17 +25,31 @@
 struct CtgNux {
   vector<double> ctgSum; ///> # per-category response sum
   double sumSquares; ///> Sum of squares over categories.
+  const PredictorT* ctgLocal; ///> Slot of each category, iff compacted.
 
   CtgNux(vector<double>& ctgSum_,
-	 double sumSquares_) :
+	 double sumSquares_,
+	 const PredictorT* ctgLocal_ = nullptr) :
   ctgSum(ctgSum_),
-    sumSquares(sumSquares_) {
+    sumSquares(sumSquares_),
+    ctgLocal(ctgLocal_) {
   }
 
   
   PredictorT nCtg() const {
     return ctgSum.size();
   }
+
+
+  /**
+     @brief Maps a response category to its accumulator slot.
+
+     Compacted sums are indexed only by the categories present in
+     the node, which are the only ones its observations can take.
+   */
+  inline PredictorT local(PredictorT ctg) const {
+    return ctgLocal == nullptr ? ctg : ctgLocal[ctg];
+  }
 };
 
 
@@ -52,7 +67,7 @@ protected:
 
 public:
   const class Obs* obsCell;
-  const IndexT* sampleIndex;
+  const SampleIdx sampleIndex;
   const IndexT obsStart;///< Low terminus.
   const IndexT obsEnd; ///< sup.
   const SumCount sumCount; ///< Initialized from candidate, filtered.
@@ -20,12 +20,21 @@
 #include "frontier.h"
 #include "splitfrontier.h"
 
+#include <algorithm>
+#include <cmath>
 
 
-Cand::Cand(const InterLevel* interLevel) :
+
+Cand::Cand(const InterLevel* interLevel,
+	   LevelArena* arena) :
   nSplit(interLevel->getNSplit()),
   nPred(interLevel->getNPred()),
-  preCand(vector<vector<PreCand>>(nSplit)) {
+  preCand(LevelAllocator<LevelVector<PreCand>>(arena)) {
+  // Emplaced, as copies would revert to the heap.
+  preCand.reserve(nSplit);
+  for (IndexT splitIdx = 0; splitIdx < nSplit; splitIdx++) {
+    preCand.emplace_back(LevelAllocator<PreCand>(arena));
+  }
 }
 
   
@@ -74,35 +83,122 @@ void Cand::candidateBernoulli(const Frontier* frontier,
 }
 
 
+void Cand::candidateGeometric(const Frontier* frontier,
+			      InterLevel* interLevel,
+			      double prob) {
+  if (prob <= 0.0)
+    return;
+  double logComp = log1p(-prob); // -inf iff certain.
+  for (IndexT splitIdx = 0; splitIdx < nSplit; splitIdx++) {
+    if (frontier->isUnsplitable(splitIdx)) { // Node cannot split.
+      continue;
+    }
+    // Variates are drawn in batches sized to the expected trial count.
+    vector<double> ruSkip;
+    size_t ruIdx = 0;
+    size_t predIdx = 0;
+    while (true) {
+      if (ruIdx == ruSkip.size()) {
+	ruSkip = PRNG::rUnif(static_cast<size_t>(nPred * prob) + 1);
+	ruIdx = 0;
+      }
+      double ru = ruSkip[ruIdx++];
+      double skip = log1p(-ru) / logComp;
+      if (skip >= nPred - predIdx)
+	break;
+      predIdx += static_cast<size_t>(skip);
+      SplitCoord coord(splitIdx, predIdx);
+      if (interLevel->preschedule(coord)) {
+	preCand[splitIdx].emplace_back(coord, getRandLow(ru));
+      }
+      predIdx++;
+    }
+  }
+}
+
+
 void Cand::candidateFixed(const Frontier* frontier,
 			  InterLevel* interLevel,
 			  PredictorT predFixed) {
-  vector<double> ruPred = PRNG::rUnif(nSplit * nPred);
+  unordered_map<PredictorT, PredictorT> displaced;
+  for (IndexT splitIdx = 0; splitIdx < nSplit; splitIdx++) {
+    if (frontier->isUnsplitable(splitIdx)) { // Node cannot split.
+      continue;
+    }
+    displaced.clear();
+    PredictorT schedCount = 0;
+    PredictorT predTop = nPred;
+    while (predTop != 0 && schedCount != predFixed) {
+      // Batch never exceeds the count remaining to be scheduled.
+      vector<double> ruPred = PRNG::rUnif(min(predTop, predFixed - schedCount));
+      for (double ru : ruPred) {
+	PredictorT idxRand = predTop * ru;
+	predTop--;
+	PredictorT predIdx = sparseExchange(displaced, idxRand, predTop);
+	SplitCoord coord(splitIdx, predIdx);
+	if (interLevel->preschedule(coord)) {
+	  preCand[splitIdx].emplace_back(coord, getRandLow(ru));
+	  schedCount++;
+	}
+      }
+    }
+  }
+}
+
 
+void Cand::candidateWeighted(const Frontier* frontier,
+			     InterLevel* interLevel,
+			     const Sample::Walker<PredictorT>& walker,
+			     PredictorT nPositive,
+			     PredictorT predFixed,
+			     double probSum) {
+  vector<IndexT> drawnBy(nPred, nSplit); // Node last drawing predictor.
   for (IndexT splitIdx = 0; splitIdx < nSplit; splitIdx++) {
     if (frontier->isUnsplitable(splitIdx)) { // Node cannot split.
       continue;
     }
-    vector<PredictorT> predRand(nPred);
-    iota(predRand.begin(), predRand.end(), 0);
-    IndexT ruOff = splitIdx * nPred;
+    PredictorT nCand = min(nPositive, predFixed == 0 ? poissonCount(probSum) : predFixed);
     PredictorT schedCount = 0;
-    for (PredictorT predTop = nPred; predTop != 0; predTop--) {
-      PredictorT idxRand = predTop * ruPred[ruOff];
-      PredictorT predIdx = exchange(predRand[idxRand], predRand[predTop-1]);
-      SplitCoord coord(splitIdx, predIdx);
-      if (interLevel->preschedule(coord)) {
-	preCand[splitIdx].emplace_back(coord, getRandLow(ruPred[ruOff]));
-	if (++schedCount == predFixed) {
-	  break;
+    PredictorT nTried = 0;
+    while (schedCount < nCand && nTried < nPositive) {
+      vector<size_t> predDrawn = walker.sample(nCand - schedCount);
+      vector<double> ruArb = PRNG::rUnif(predDrawn.size());
+      for (size_t drawIdx = 0; drawIdx != predDrawn.size(); drawIdx++) {
+	PredictorT predIdx = predDrawn[drawIdx];
+	if (drawnBy[predIdx] == splitIdx) // Repeat:  rejected.
+	  continue;
+	drawnBy[predIdx] = splitIdx;
+	nTried++;
+	SplitCoord coord(splitIdx, predIdx);
+	if (interLevel->preschedule(coord)) {
+	  preCand[splitIdx].emplace_back(coord, getRandLow(ruArb[drawIdx]));
+	  schedCount++;
 	}
       }
-      ruOff++;
     }
   }
 }
 
 
+PredictorT Cand::poissonCount(double lambda) {
+  if (lambda < 30.0) { // Multiplicative method.
+    double thresh = exp(-lambda);
+    PredictorT count = 0;
+    double prod = PRNG::rUnif(1)[0];
+    while (prod > thresh) {
+      prod *= PRNG::rUnif(1)[0];
+      count++;
+    }
+    return count;
+  }
+  else { // Normal approximation, by Box-Muller.
+    vector<double> ru = PRNG::rUnif(2);
+    double z = sqrt(-2.0 * log1p(-ru[0])) * cos(2.0 * M_PI * ru[1]);
+    return static_cast<PredictorT>(max(0.0, round(lambda + sqrt(lambda) * z)));
+  }
+}
+
+
 vector<SplitNux> Cand::getCandidates(const InterLevel* interLevel,
 				     const SplitFrontier* sf) {
   vector<SplitNux> postCand;
@@ -18,8 +18,11 @@
 
 #include "typeparam.h"
 #include "splitcoord.h"
+#include "sample.h"
+#include "levelarena.h"
 
 #include <vector>
+#include <unordered_map>
 
 /**
    @brief Minimal information needed to preschedule a splitting candidate.
@@ -52,9 +55,13 @@ struct Cand {
   const IndexT nSplit;
   const PredictorT nPred;
 
-  vector<vector<PreCand>> preCand;
+  LevelVector<LevelVector<PreCand>> preCand; // Level-scoped.
 
-  Cand(const class InterLevel* interLevel);
+  /**
+     @param arena is the frontier's arena for the current level.
+   */
+  Cand(const class InterLevel* interLevel,
+       LevelArena* arena);
   
 
   void precandidates(const class Frontier* frontier,
@@ -75,13 +82,68 @@ struct Cand {
 			  class InterLevel* interLevel,
 			  const vector<double>& predProb);
 
+
+  /**
+     @brief As above, but with a common probability, by geometric skips.
+
+     Draws a variate per trial accepted, rather than per predictor.
+   */
+  void candidateGeometric(const class Frontier* frontier,
+			  class InterLevel* interLevel,
+			  double prob);
+
   /**
      @brief Samples fixed number of precandidates without replacement.
+
+     Shuffles lazily, recording only the displaced slots, so that cost
+     scales with the number of predictors drawn rather than 'nPred'.
    */
   void candidateFixed(const class Frontier* frontier,
 		      class InterLevel* interLevel,
 		      PredictorT predFixed);
 
+
+  /**
+     @brief Samples precandidates by weight, without replacement.
+
+     Predictors are drawn from an alias table, with repeats rejected,
+     so that cost per node scales with the number of candidates.
+
+     @param nPositive is the number of predictors of positive weight.
+
+     @param predFixed is the per-node candidate count, if positive,
+     else the count is Poisson-distributed about 'probSum'.
+   */
+  void candidateWeighted(const class Frontier* frontier,
+			 class InterLevel* interLevel,
+			 const Sample::Walker<PredictorT>& walker,
+			 PredictorT nPositive,
+			 PredictorT predFixed,
+			 double probSum);
+
+
+  /**
+     @return Poisson-distributed count with a given mean.
+   */
+  static PredictorT poissonCount(double lambda);
+
+
+  /**
+     @brief Exchanges a slot with the top of a sparsely-represented
+     permutation.
+
+     @return predictor formerly at the slot.
+   */
+  static inline PredictorT sparseExchange(unordered_map<PredictorT, PredictorT>& displaced,
+					  PredictorT slot,
+					  PredictorT top) {
+    auto itSlot = displaced.find(slot);
+    PredictorT predSlot = itSlot == displaced.end() ? slot : itSlot->second;
+    auto itTop = displaced.find(top);
+    displaced[slot] = itTop == displaced.end() ? top : itTop->second;
+    return predSlot;
+  }
+
   vector<class SplitNux> getCandidates(const class InterLevel* interLevel,
 				       const class SplitFrontier* splitFrontier);
 
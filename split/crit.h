@@ -113,8 +113,16 @@ struct SplitValD {
    @brief Splitting criterion.
 
    Branch sense implicitly less-than-equal left.
+
+   Factor criteria are bit offsets into the tree's pool.  A dense
+   criterion sets one bit per true level.  A sparse criterion, chosen
+   when the node sees few levels of a wide factor, instead begins a
+   slot-aligned list:  a count followed by the sorted true levels.
+   Sparse offsets carry a flag bit well above any reachable offset yet
+   within the 52 bits preserved by the double encoding.
  */
 struct Crit {
+  static constexpr size_t sparseBit = size_t(1) << 48; // Flags a level list.
   SplitValD val;
 
   Crit(double crit) : val(crit) {
@@ -130,8 +138,12 @@ struct Crit {
 	       const class SplitFrontier* splitFrontier);
 
 
-  void critBits(size_t bitPos) {
-    val.setOffset(bitPos);
+  /**
+     @param sparse is true iff the criterion is coded as a level list.
+   */
+  void critBits(size_t bitPos,
+		bool sparse) {
+    val.setOffset(sparse ? (bitPos | sparseBit) : bitPos);
   }
   
   
@@ -146,7 +158,15 @@ struct Crit {
 
   
   size_t getBitOffset() const {
-    return val.getOffset();
+    return val.getOffset() & ~sparseBit;
+  }
+
+
+  /**
+     @return true iff factor criterion is coded as a level list.
+   */
+  bool isSparse() const {
+    return (val.getOffset() & sparseBit) != 0;
   }
 
 
@@ -7,7 +7,7 @@
 #include "obs.h"
 
 CritEncoding::CritEncoding(const SplitFrontier* sf, const SplitNux& nux_, bool incr) :
-  sum(0.0), sCount(0), extent(0), nux(nux_), scCtg(vector<SumCount>(sf->getNCtg())), implicitTrue(sf->getImplicitTrue(nux)), increment(incr), exclusive(sf->getCompound()), style(sf->getEncodingStyle()) {
+  sum(), sCount(0), extent(0), nux(nux_), scCtg(vector<SumCount>(sf->getNCtg())), implicitTrue(sf->getImplicitTrue(nux)), increment(incr), exclusive(sf->getCompound()), style(sf->getEncodingStyle()) {
 }
 
 
@@ -17,7 +17,7 @@ IndexT CritEncoding::getSCountTrue() const {
 
 
 double CritEncoding::getSumTrue() const {
-  return implicitTrue == 0 ? sum : (nux.getSum() - sum);
+  return implicitTrue == 0 ? sum.total() : (nux.getSum() - sum.total());
 }
 
 
@@ -30,10 +30,11 @@ void CritEncoding::getISetVals(IndexT& sCountTrue,
 			       double& sumTrue,
 			       IndexT& extentTrue,
 			       bool& encodeTrue,
-			       double& minInfo) const {
+			       double& minInfo,
+			       double minRatio) const {
   style == EncodingStyle::direct ? accumDirect(sCountTrue, sumTrue, extentTrue) : accumTrue(sCountTrue, sumTrue, extentTrue);
   encodeTrue = trueEncoding();
-  minInfo = nux.getMinInfo();
+  minInfo = nux.getMinInfo(minRatio);
 }
 
 
@@ -43,7 +44,7 @@ void CritEncoding::accumDirect(IndexT& sCountTrue,
   int coeff = increment ? 1 : -1;
   sCountTrue += coeff * sCount;
   extentTrue += coeff * extent;
-  sumTrue += coeff * sum;
+  sumTrue += coeff * sum.total();
 }
 
 
@@ -80,7 +81,7 @@ void CritEncoding::branchUpdate(const SplitFrontier* sf,
 void CritEncoding::branchUpdate(const ObsPart* obsPart,
 				const IndexRange& range,
 				BranchSense& branchSense) {
-  IndexT* sIdx;
+  SampleIdx sIdx;
   Obs* spn = obsPart->getBuffers(nux, sIdx);
   if (increment) {
     branchSet(sIdx, spn, range, branchSense);
@@ -91,7 +92,7 @@ void CritEncoding::branchUpdate(const ObsPart* obsPart,
 }
 
 
-void CritEncoding::branchSet(IndexT* sIdx,
+void CritEncoding::branchSet(const SampleIdx& sIdx,
 			     Obs* spn,
 			     const IndexRange& range,
 			     BranchSense& branchSense) {
@@ -113,7 +114,7 @@ void CritEncoding::branchSet(IndexT* sIdx,
 }
 
 
-void CritEncoding::branchUnset(IndexT* sIdx,
+void CritEncoding::branchUnset(const SampleIdx& sIdx,
 			       Obs* spn,
 			       const IndexRange& range,
 			       BranchSense& branchSense) {
@@ -18,6 +18,8 @@
 
 #include "typeparam.h"
 #include "sumcount.h"
+#include "pairsum.h"
+#include "sampleidx.h"
 
 #include <vector>
 
@@ -28,7 +30,7 @@ enum class EncodingStyle { direct, trueBranch };
    @brief Encapsulates contributions of an individual split to frontier.
  */
 struct CritEncoding {
-  double sum; // sum of responses over encoding.
+  PairSum sum; // sum of responses over encoding.
   IndexT sCount; // # samples encoded.
   IndexT extent; // # SR indices encoded.
   const class SplitNux& nux;
@@ -71,7 +73,7 @@ struct CritEncoding {
   inline void accum(double ySum,
 		    IndexT sCount,
 		    PredictorT ctg) {
-    this->sum += ySum;
+    this->sum.add(ySum);
     this->sCount += sCount;
     extent++;
     if (!scCtg.empty()) {
@@ -84,7 +86,8 @@ struct CritEncoding {
 		   double& sumTrue,
 		   IndexT& extentTrue,
 		   bool& encodeTrue,
-		   double& minInfo) const;
+		   double& minInfo,
+		   double minRatio) const;
 
 
   void branchUpdate(const class SplitFrontier* sf,
@@ -98,13 +101,13 @@ struct CritEncoding {
 
 
 private:  
-  void branchSet(IndexT* sIdx,
+  void branchSet(const SampleIdx& sIdx,
 		 class Obs* spn,
 		 const IndexRange& range,
 		 class BranchSense& branchSense);
 
 
-  void branchUnset(IndexT* sIdx,
+  void branchUnset(const SampleIdx& sIdx,
 		   class Obs* spn,
 		   const IndexRange& range,
 		   class BranchSense& branchSense);
@@ -19,14 +19,22 @@
 #include "splitfrontier.h"
 #include "partition.h"
 #include "interlevel.h"
+#include "pairsum.h"
+
+
+constexpr IndexT CutAccum::scanBlock;
 
 
 CutAccum::CutAccum(const SplitNux& cand,
 		   const SplitFrontier* splitFrontier) :
   Accum(splitFrontier, cand),
+  nCut(splitFrontier->getNCut()),
+  runScan(cand.getRunCount() <= runScanMax),
+  singleRun(cand.getImplicitCount() != 0 && cand.getRunCount() == 2),
   obsLeft(-1),
   obsRight(-1),
-  residualLeft(false) {
+  residualLeft(false),
+  missingLeft(cand.invertTest()) {
 }
 
 
@@ -60,6 +68,24 @@ double CutAccum::interpolateRank(const InterLevel* interLevel,
 }
 
 
+IndexT CutAccum::drawCut(double ru) const {
+  if (obsEnd - obsStart < 2)
+    return obsEnd;
+
+  IndexT nCut = obsEnd - obsStart - 1;
+  IndexT cutDrawn = obsStart + min(static_cast<IndexT>(ru * nCut), nCut - 1);
+  for (IndexT cutLeft = cutDrawn; cutLeft + 1 != obsEnd; cutLeft++) {
+    if (!obsCell[cutLeft + 1].isTied())
+      return cutLeft;
+  }
+  for (IndexT cutRight = cutDrawn; cutRight != obsStart; cutRight--) {
+    if (!obsCell[cutRight].isTied())
+      return cutRight - 1;
+  }
+  return obsEnd;
+}
+
+
 CutAccumReg::CutAccumReg(const SplitNux& cand,
 			 const SFReg* sfReg) :
   CutAccum(cand, sfReg),
@@ -77,16 +103,102 @@ CutAccumCtg::CutAccumCtg(const SplitNux& cand,
 }
 
 
+void CutAccumReg::routeMissing(const SplitNux& cand) {
+  if (cand.getNMissing() == 0 || !hasArgmax())
+    return;
+
+  PairSum sumLeft, sumExpl;
+  IndexT sCountLeft = 0;
+  IndexT sCountExpl = 0;
+  for (IndexT obsIdx = obsStart; obsIdx != obsEnd; obsIdx++) {
+    const Obs& obs = obsCell[obsIdx];
+    double ySum = obs.getYSum();
+    sumExpl.add(ySum);
+    sCountExpl += obs.getSCount();
+    if (obsIdx <= obsLeft) {
+      sumLeft.add(ySum);
+      sCountLeft += obs.getSCount();
+    }
+  }
+  SumCount scLeft(sumLeft.total(), sCountLeft);
+  SumCount scExpl(sumExpl.total(), sCountExpl);
+  if (lhImplicit(cand) != 0)
+    scLeft += SumCount::minus(sumCount, scExpl);
+
+  SumCount scMissing;
+  for (IndexT obsIdx = obsEnd; obsIdx != obsEnd + cand.getNMissing(); obsIdx++) {
+    const Obs& obs = obsCell[obsIdx];
+    scMissing += SumCount(obs.getYSum(), obs.getSCount());
+  }
+
+  SumCount scRight = SumCount::minus(sumCount, scLeft);
+  double infoLeft = infoVar(scLeft.sum + scMissing.sum, scRight.sum, scLeft.sCount + scMissing.sCount, scRight.sCount);
+  double infoRight = infoVar(scLeft.sum, scRight.sum + scMissing.sum, scLeft.sCount, scRight.sCount + scMissing.sCount);
+  missingLeft = infoLeft > infoRight;
+}
+
+
+void CutAccumCtg::routeMissing(const SplitNux& cand) {
+  if (cand.getNMissing() == 0 || !hasArgmax())
+    return;
+
+  PredictorT nCtg = ctgNux.nCtg();
+  vector<double> ctgLeft(nCtg);
+  vector<double> ctgExpl(nCtg);
+  for (IndexT obsIdx = obsStart; obsIdx != obsEnd; obsIdx++) {
+    const Obs& obs = obsCell[obsIdx];
+    PredictorT ctg = ctgNux.local(obs.getCtg());
+    ctgExpl[ctg] += obs.getYSum();
+    if (obsIdx <= obsLeft)
+      ctgLeft[ctg] += obs.getYSum();
+  }
+  if (lhImplicit(cand) != 0) {
+    for (PredictorT ctg = 0; ctg != nCtg; ctg++) {
+      ctgLeft[ctg] += ctgNux.ctgSum[ctg] - ctgExpl[ctg];
+    }
+  }
+
+  vector<double> ctgMissing(nCtg);
+  for (IndexT obsIdx = obsEnd; obsIdx != obsEnd + cand.getNMissing(); obsIdx++) {
+    const Obs& obs = obsCell[obsIdx];
+    ctgMissing[ctgNux.local(obs.getCtg())] += obs.getYSum();
+  }
+
+  double sumL = 0.0;
+  double sumR = 0.0;
+  double sumMissing = 0.0;
+  double ssL = 0.0; // Sums of squares, missing excluded.
+  double ssR = 0.0;
+  double ssLMissing = 0.0; // " ", missing included.
+  double ssRMissing = 0.0;
+  for (PredictorT ctg = 0; ctg != nCtg; ctg++) {
+    double left = ctgLeft[ctg];
+    double right = ctgNux.ctgSum[ctg] - left;
+    double missing = ctgMissing[ctg];
+    sumL += left;
+    sumR += right;
+    sumMissing += missing;
+    ssL += left * left;
+    ssR += right * right;
+    ssLMissing += (left + missing) * (left + missing);
+    ssRMissing += (right + missing) * (right + missing);
+  }
+  double infoLeft = infoGini(ssLMissing, ssR, sumL + sumMissing, sumR);
+  double infoRight = infoGini(ssL, ssRMissing, sumL, sumR + sumMissing);
+  missingLeft = infoLeft > infoRight;
+}
+
+
 void CutAccum::residualReg(const Obs* obsCell) {
-  double ySumObs = 0.0;
+  PairSum ySumObs;
   IndexT sCountObs = 0;
   for (IndexT obsIdx = obsStart; obsIdx != obsEnd; obsIdx++) {
     const Obs& obs = obsCell[obsIdx];
-    ySumObs += obs.getYSum();
+    ySumObs.add(obs.getYSum());
     sCountObs += obs.getSCount();
   }
 
-  sum -= (sumCount.sum - ySumObs);
+  sum -= (sumCount.sum - ySumObs.total());
   sCount -= (sumCount.sCount - sCountObs);
 }
 
@@ -97,16 +209,16 @@ void CutAccumCtg::residualCtg(const Obs* obsCell) {
     accumCtgSS(ctgResid[ctg], ctg);
   }
 
-  double ySumExpl = 0.0;
+  PairSum ySumExpl;
   IndexT sCountExpl = 0;
   for (IndexT obsIdx = obsStart; obsIdx != obsEnd; obsIdx++) {
     const Obs& obs = obsCell[obsIdx];
     double ySumObs = obs.getYSum();
-    ctgResid[obs.getCtg()] -= ySumObs;
-    ySumExpl += ySumObs;
+    ctgResid[ctgNux.local(obs.getCtg())] -= ySumObs;
+    ySumExpl.add(ySumObs);
     sCountExpl += obs.getSCount();
   }
-  sum -= (sumCount.sum - ySumExpl);
+  sum -= (sumCount.sum - ySumExpl.total());
   sCount -= (sumCount.sCount - sCountExpl);
 }
 
@@ -30,6 +30,35 @@
  */
 class CutAccum : public Accum {
 protected:
+  static constexpr IndexT scanBlock = 16; ///< Positions per vectorized scan block.
+  static constexpr IndexT runScanMax = 16; ///< Most runs scanned by run.
+  const IndexT nCut; ///< Cuts evaluated per scan, if nonzero.
+  const bool runScan; ///< Whether cell is scanned by run, rather than by position.
+  const bool singleRun; ///< Whether explicit observations form a single run.
+
+
+  /**
+     @brief Determines whether a scan is approximated by sketch.
+
+     @return true iff range admits more cuts than are to be evaluated.
+   */
+  bool sketched(IndexT idxStart,
+		IndexT idxEnd) const {
+    return nCut != 0 && idxEnd - idxStart > nCut + 1;
+  }
+
+
+  /**
+     @brief Derives the i-th of 'nCut' evenly-spaced cut positions.
+
+     @return right index of cut, decreasing in 'cutIdx'.
+   */
+  IndexT sketchPosition(IndexT idxStart,
+			IndexT idxEnd,
+			IndexT cutIdx) const {
+    return idxEnd - (static_cast<size_t>(cutIdx) * (idxEnd - idxStart)) / (nCut + 1);
+  }
+
 
   /**
      @brief Trial argmax on right indices.
@@ -78,6 +107,19 @@ protected:
   void residualReg(const Obs* obsCell);
 
 
+  /**
+     @brief Draws a random explicit cut.
+
+     Cuts tied with their left neighbor are advanced to the next
+     untied position to the right, else to the left.
+
+     @param ru is a uniform variate.
+
+     @return left index of cut, else obsEnd if no untied cut exists.
+   */
+  IndexT drawCut(double ru) const;
+
+
   /**
      @brief Revises argmax in right-to-left traversal.
    */
@@ -91,6 +133,7 @@ public:
   IndexT obsLeft; ///< sup left index.  Out of bounds (obsEnd + 1) iff left is dense.
   IndexT obsRight; ///< inf right index.  Out of bounds (obsEnd + 1) iff right is dense.
   bool residualLeft; ///< State of most recent residual argmax:  L/R.
+  bool missingLeft; ///< Whether missing observations take the left branch.
 
   /**
      @param cand encapsulates candidate splitting parameters.
@@ -142,7 +185,7 @@ protected:
   inline bool accumulateCtg(const Obs& obs) {
     sum -= obs.getYSum();
     sCount -= obs.getSCount();
-    accumCtgSS(obs.getYSum(), obs.getCtg());
+    accumCtgSS(obs.getYSum(), ctgNux.local(obs.getCtg()));
 
     return obs.isTied();
   }
@@ -164,8 +207,17 @@ public:
 
      @param ySumCtg is the response sum for a category.
 
-     @param yCtt is the response category.
+     @param yCtg is the accumulator slot of the response category.
+   */
+  /**
+     @brief Routes missing observations to the more informative side
+     of the argmax cut.
+
+     Retains the default, randomized, routing if none are missing.
    */
+  void routeMissing(const class SplitNux& cand);
+
+
   inline void accumCtgSS(double ySumCtg,
 			 PredictorT yCtg) {
     double sumRCtg = exchange(ctgAccum[yCtg], ctgAccum[yCtg] + ySumCtg);
@@ -184,6 +236,12 @@ protected:
 public:
   CutAccumReg(const class SplitNux& splitCand,
 	      const struct SFReg* spReg);
+
+
+  /**
+     @brief As with classification, but weighted-variance.
+   */
+  void routeMissing(const class SplitNux& cand);
 };
 
 
@@ -72,6 +72,11 @@ IndexT CutSet::getImplicitTrue(const SplitNux& nux) const {
 }
 
 
+bool CutSet::missingLeft(const SplitNux& nux) const {
+  return cutSig[nux.getAccumIdx()].missingLeft;
+}
+
+
 void CutSet::write(const InterLevel* interLevel,
 		   const SplitNux& nux, const CutAccum& accum) {
   if (nux.getInfo() > 0) {
@@ -86,5 +91,6 @@ void CutSig::write(const InterLevel* interLevel,
   obsLeft = accum.obsLeft;
   obsRight = accum.obsRight;
   implicitTrue = accum.lhImplicit(nux);
+  missingLeft = accum.missingLeft;
   quantRank = accum.interpolateRank(interLevel, nux);
 }
@@ -31,15 +31,18 @@ struct CutSig {
   IndexT implicitTrue; ///< # implicit Obs indices associated with true sense.
   double quantRank; ///< Interpolated cut rank.
   bool cutLeft; ///< True iff cut encodes left portion.
+  bool missingLeft; ///< True iff missing observations take the left branch.
 
   CutSig(const IndexRange& idxRange) :
     obsLeft(idxRange.getStart()),
     obsRight(idxRange.getEnd() - 1),
-    cutLeft(true) { // Default.
+    cutLeft(true), // Default.
+    missingLeft(false) {
   }
 
   CutSig() :
-    cutLeft(true) {
+    cutLeft(true),
+    missingLeft(false) {
   }
 
 
@@ -108,6 +111,12 @@ public:
 
   
   IndexT getImplicitTrue(const class SplitNux& nux) const;
+
+
+  /**
+     @return true iff missing observations take the left branch.
+   */
+  bool missingLeft(const class SplitNux& nux) const;
 };
 
 #endif
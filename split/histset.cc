@@ -0,0 +1,186 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/**
+   @file histset.cc
+
+   @brief Builds per-cell bin histograms.
+
+   @author Mark Seligman
+ */
+
+#include "histset.h"
+#include "splitfrontier.h"
+#include "splitnux.h"
+#include "obs.h"
+
+
+constexpr IndexT HistSet::noHist;
+
+
+HistCell::HistCell(size_t base_,
+		   IndexT capacity_,
+		   PredictorT predIdx_,
+		   IndexT next_) :
+  base(base_),
+  capacity(capacity_),
+  nEntry(0),
+  predIdx(predIdx_),
+  next(next_),
+  sibling(HistSet::noHist),
+  parent(HistSet::noHist) {
+}
+
+
+HistSet::HistSet(PredictorT nCtg_) :
+  nCtg(nCtg_),
+  nSlot(0),
+  histParent(nullptr) {
+}
+
+
+IndexT HistSet::preIndex(const SplitNux& cand) {
+  IndexT nodeIdx = cand.getNodeIdx();
+  if (nodeIdx >= nodeHead.size())
+    nodeHead.resize(nodeIdx + 1, noHist);
+  histCell.emplace_back(nSlot, cand.getRunCount(), cand.getPredIdx(), nodeHead[nodeIdx]);
+  histNux.push_back(cand);
+  nSlot += cand.getRunCount();
+  nodeHead[nodeIdx] = histCell.size() - 1;
+  return histCell.size() - 1;
+}
+
+
+void HistSet::pairSiblings(const HistSet* histParent_,
+			   const vector<IndexT>& parentIdx) {
+  histParent = histParent_;
+  if (histParent == nullptr)
+    return;
+
+  for (IndexT histIdx = 0; histIdx != histCell.size(); histIdx++) {
+    const SplitNux& nux = histNux[histIdx];
+    IndexT nodeIdx = nux.getNodeIdx();
+    IndexT sibIdx = lookup(nodeIdx ^ 1, nux.getPredIdx());
+    if (sibIdx == noHist)
+      continue;
+    IndexT parIdx = histParent->lookup(parentIdx[nodeIdx], nux.getPredIdx());
+    if (parIdx == noHist)
+      continue;
+    IndexT extent = histExtent(nux);
+    IndexT sibExtent = histExtent(histNux[sibIdx]);
+    if (extent > sibExtent || (extent == sibExtent && (nodeIdx & 1) != 0)) {
+      histCell[histIdx].sibling = sibIdx;
+      histCell[histIdx].parent = parIdx;
+    }
+  }
+}
+
+
+void HistSet::allocate() {
+  histBin.resize(nSlot);
+  ctgSum.resize(nSlot * nCtg);
+  filled = make_unique<once_flag[]>(histCell.size());
+}
+
+
+IndexT HistSet::lookup(IndexT nodeIdx,
+		       PredictorT predIdx) const {
+  if (nodeIdx >= nodeHead.size())
+    return noHist;
+  for (IndexT histIdx = nodeHead[nodeIdx]; histIdx != noHist; histIdx = histCell[histIdx].next) {
+    if (histCell[histIdx].predIdx == predIdx)
+      return histIdx;
+  }
+  return noHist;
+}
+
+
+void HistSet::fill(const SplitFrontier* splitFrontier,
+		   IndexT histIdx) {
+  call_once(filled[histIdx], [this, splitFrontier, histIdx]() {
+      IndexT sibIdx = histCell[histIdx].sibling;
+      if (sibIdx == noHist) {
+	build(splitFrontier, histIdx);
+      }
+      else {
+	fill(splitFrontier, sibIdx);
+	subtract(histIdx);
+      }
+    });
+}
+
+
+double HistSet::fillCost(IndexT histIdx) const {
+  const HistCell& cell = histCell[histIdx];
+  if (cell.sibling == noHist)
+    return histExtent(histNux[histIdx]);
+  else
+    return histParent->getNEntry(cell.parent);
+}
+
+
+void HistSet::build(const SplitFrontier* splitFrontier,
+		    IndexT histIdx) {
+  const SplitNux& cand = histNux[histIdx];
+  HistCell& cell = histCell[histIdx];
+  HistBin* entry = &histBin[cell.base];
+  double* entryCtg = nCtg == 0 ? nullptr : &ctgSum[cell.base * nCtg];
+  const Obs* obsCell = splitFrontier->getPredBase(cand);
+  IndexT obsEnd = cand.getObsEnd() - cand.getNMissing();
+  IndexT nEntry = 0;
+  for (IndexT obsIdx = cand.getObsStart(); obsIdx != obsEnd; obsIdx++) {
+    const Obs& obs = obsCell[obsIdx];
+    if (nEntry == 0 || !obs.isTied()) {
+      unsigned int bin = splitFrontier->getBin(cand, obsIdx);
+      if (nEntry == 0 || bin != entry[nEntry - 1].bin) {
+	entry[nEntry++] = HistBin(bin);
+      }
+    }
+    HistBin& hb = entry[nEntry - 1];
+    hb.obsCount++;
+    double ySum = obs.getYSum();
+    hb.sumCount += SumCount(ySum, obs.getSCount());
+    if (entryCtg != nullptr)
+      entryCtg[(nEntry - 1) * nCtg + obs.getCtg()] += ySum;
+  }
+  cell.nEntry = nEntry;
+}
+
+
+void HistSet::subtract(IndexT histIdx) {
+  HistCell& cell = histCell[histIdx];
+  HistBin* entry = &histBin[cell.base];
+  double* entryCtg = nCtg == 0 ? nullptr : &ctgSum[cell.base * nCtg];
+  const HistBin* parBin = histParent->getBins(cell.parent);
+  const double* parCtg = nCtg == 0 ? nullptr : histParent->getCtgSum(cell.parent);
+  IndexT nPar = histParent->getNEntry(cell.parent);
+  const HistBin* sibBin = getBins(cell.sibling);
+  const double* sibCtg = nCtg == 0 ? nullptr : getCtgSum(cell.sibling);
+  IndexT nSib = getNEntry(cell.sibling);
+
+  IndexT nEntry = 0;
+  IndexT sibPos = 0;
+  for (IndexT parPos = 0; parPos != nPar; parPos++) {
+    HistBin hb = parBin[parPos];
+    bool shared = sibPos != nSib && sibBin[sibPos].bin == hb.bin;
+    if (shared) {
+      hb.obsCount -= sibBin[sibPos].obsCount;
+      hb.sumCount -= sibBin[sibPos].sumCount;
+    }
+    if (hb.obsCount != 0) {
+      if (entryCtg != nullptr) {
+	for (PredictorT ctg = 0; ctg != nCtg; ctg++) {
+	  entryCtg[nEntry * nCtg + ctg] = parCtg[parPos * nCtg + ctg] - (shared ? sibCtg[sibPos * nCtg + ctg] : 0.0);
+	}
+      }
+      entry[nEntry++] = hb;
+    }
+    if (shared)
+      sibPos++;
+  }
+  cell.nEntry = nEntry;
+}
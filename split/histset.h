@@ -0,0 +1,198 @@
+// This file is part of ArboristCore.
+
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef SPLIT_HISTSET_H
+#define SPLIT_HISTSET_H
+
+/**
+   @file histset.h
+
+   @brief Per-cell bin histograms for binned numeric splitting.
+
+   @author Mark Seligman
+
+ */
+
+#include "typeparam.h"
+#include "sumcount.h"
+#include "splitnux.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+
+/**
+   @brief Response summary of a cell's observations lying in one bin.
+ */
+struct HistBin {
+  unsigned int bin; ///< Frame-wide bin index.
+  IndexT obsCount; ///< # staged observations.
+  SumCount sumCount; ///< Response sum and sample count.
+
+  HistBin(unsigned int bin_ = 0) :
+    bin(bin_),
+    obsCount(0) {
+  }
+};
+
+
+/**
+   @brief Sparse histogram of a cell:  one entry per bin present.
+
+   Entries are in increasing bin order, hence in staged order.
+ */
+struct HistCell {
+  size_t base; ///< Offset of leading entry within the set.
+  IndexT capacity; ///< Entries reserved:  the cell's run count.
+  IndexT nEntry; ///< Entries filled.
+  PredictorT predIdx; ///< Predictor summarized.
+  IndexT next; ///< Next histogram of the same node, if any.
+  IndexT sibling; ///< Sibling histogram subtracted, iff derived.
+  IndexT parent; ///< Parent histogram in the preceding level, iff derived.
+
+  HistCell(size_t base_,
+	   IndexT capacity_,
+	   PredictorT predIdx_,
+	   IndexT next_);
+};
+
+
+/**
+   @brief Histograms of a level's binned numeric candidates.
+
+   Storage is reserved ahead of evaluation, so that concurrent fills
+   write disjoint regions without allocating.  The set is retained
+   through the following level, whose candidates may then derive the
+   larger of two siblings by subtraction from the parent.
+ */
+class HistSet {
+  const PredictorT nCtg; ///< Response cardinality, iff classification.
+  size_t nSlot; ///< Total entries reserved.
+  vector<HistCell> histCell; ///< Per-histogram extents.
+  vector<SplitNux> histNux; ///< Candidates:  stale once the level is split.
+  vector<IndexT> nodeHead; ///< Leading histogram of each node, if any.
+  const HistSet* histParent; ///< Preceding level's histograms, if any.
+  unique_ptr<once_flag[]> filled; ///< Per-histogram fill guard.
+  vector<HistBin> histBin; ///< Entries of all histograms.
+  vector<double> ctgSum; ///< Per-category entry sums, iff classification.
+
+
+  /**
+     @brief Accumulates a candidate's explicit, nonmissing observations
+     by bin.
+
+     Bins are looked up only at run heads, as runs of a binned
+     predictor coincide with the bins present in the cell.
+   */
+  void build(const class SplitFrontier* splitFrontier,
+	     IndexT histIdx);
+
+
+  /**
+     @brief Subtracts the sibling's entries from the parent's.
+
+     Bins emptied by the subtraction are dropped, so that entries
+     remain in correspondence with the bins present in the cell.
+   */
+  void subtract(IndexT histIdx);
+
+
+  /**
+     @return staged, nonmissing observation count of a histogram.
+   */
+  static IndexT histExtent(const SplitNux& nux) {
+    return nux.getObsEnd() - nux.getNMissing() - nux.getObsStart();
+  }
+
+
+public:
+  static constexpr IndexT noHist = ~static_cast<IndexT>(0);
+
+  /**
+     @param nCtg_ is the response cardinality, zero for regression.
+   */
+  HistSet(PredictorT nCtg_);
+
+
+  /**
+     @brief Reserves a histogram for a candidate.
+
+     Serial:  precedes allocate().
+
+     @return index of reserved histogram.
+   */
+  IndexT preIndex(const class SplitNux& cand);
+
+
+  /**
+     @brief Marks the larger of each pair of siblings for derivation.
+
+     A sibling is derived only if its parent has a histogram of the
+     same predictor and the smaller sibling, with a tie resolved to
+     the odd node, has a histogram to subtract.  Serial.
+
+     @param histParent_ holds the preceding level's histograms, if any.
+
+     @param parentIdx maps each node to its parent's node index.
+   */
+  void pairSiblings(const HistSet* histParent_,
+		    const vector<IndexT>& parentIdx);
+
+
+  /**
+     @brief Allocates storage for all reserved histograms.
+   */
+  void allocate();
+
+
+  /**
+     @return index of the histogram of a node and predictor, else noHist.
+   */
+  IndexT lookup(IndexT nodeIdx,
+		PredictorT predIdx) const;
+
+
+  /**
+     @brief Builds or derives a histogram, exactly once.
+
+     Safe for concurrent invocation:  a derived histogram fills its
+     sibling ahead of subtracting.
+
+     @param histIdx is the histogram reserved for the candidate.
+   */
+  void fill(const class SplitFrontier* splitFrontier,
+	    IndexT histIdx);
+
+
+  /**
+     @brief Estimates the cost of filling a histogram.
+
+     @return entry count of the parent, if derived, else staged extent.
+   */
+  double fillCost(IndexT histIdx) const;
+
+
+  const HistBin* getBins(IndexT histIdx) const {
+    return &histBin[histCell[histIdx].base];
+  }
+
+
+  IndexT getNEntry(IndexT histIdx) const {
+    return histCell[histIdx].nEntry;
+  }
+
+
+  /**
+     @return per-category sums of the histogram's entries, entry-major.
+   */
+  const double* getCtgSum(IndexT histIdx) const {
+    return &ctgSum[histCell[histIdx].base * nCtg];
+  }
+};
+
+#endif
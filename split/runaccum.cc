@@ -20,12 +20,13 @@
 #include "runset.h"
 
 #include <numeric>
+#include <algorithm>
 
 RunAccum::RunAccum(const SplitFrontier* splitFrontier,
 		   const SplitNux& cand,
 		   const RunSet* runSet) :
   Accum(splitFrontier, cand),
-  heapZero(vector<BHPair<PredictorT>>((runSet->style == SplitStyle::slots || cand.getRunCount() > maxWidth) ? cand.getRunCount() : 0)) {
+  runKey(vector<BHPair<PredictorT>>((runSet->style == SplitStyle::slots || cand.getRunCount() > maxWidth) ? cand.getRunCount() : 0)) {
 }
 
 
@@ -38,20 +39,15 @@ RunAccumReg::RunAccumReg(const SFReg* sfReg,
 RunAccumCtg::RunAccumCtg(const SFCtg* sfCtg,
 			 const SplitNux& cand,
 			 const RunSet* runSet) : RunAccum(sfCtg, cand, runSet),
-						 nCtg(sfCtg->getNCtg()),
 						 ctgNux(filterMissingCtg(sfCtg, cand)),
+						 nCtg(ctgNux.nCtg()),
+						 binary(sfCtg->getNCtg() == 2),
 						 runSum(vector<double>(nCtg * cand.getRunCount())) {
 }
 
 
-bool RunAccum::ctgWide(const SplitFrontier* sf,
-		       const SplitNux& cand) {
-  return (sf->getNCtg() > 2) && (cand.getRunCount() > maxWidth);
-}
-
-
 /**
-   Regression runs always maintained by heap.
+   Regression runs always ordered by mean response.
 */
 void RunAccum::regRuns(RunSet* runSet,
 		       const SplitNux& cand) {
@@ -151,14 +147,14 @@ void RunAccum::initReg(IndexT runLeft,
 
 
 vector<RunNux> RunAccum::orderMean(const vector<RunNux>& runNux) {
-  heapMean(runNux);
+  keyMean(runNux);
   return slotReorder(runNux);
 }
 
 
-void RunAccum::heapMean(const vector<RunNux>& runNux) {
+void RunAccum::keyMean(const vector<RunNux>& runNux) {
   for (PredictorT slot = 0; slot < runNux.size(); slot++) {
-    PQueue::insert<PredictorT>(&heapZero[0], runNux[slot].sumCount.sum / runNux[slot].sumCount.sCount, slot);
+    runKey[slot] = BHPair<PredictorT>(runNux[slot].sumCount.sum / runNux[slot].sumCount.sCount, slot);
   }
 }
 
@@ -170,9 +166,9 @@ void RunAccumCtg::ctgRuns(RunSet* runSet, const SplitNux& cand) {
   else
     runNux = runsExplicit(cand);
 
-  if (nCtg > 2) {
-    if (runNux.size() > maxWidth)
-      runNux = sampleRuns(runSet, cand, runNux);
+  if (!binary) {
+    if (isWide(runNux.size()))
+      runNux = orderWide(runNux);
   }
   else
     runNux = orderBinary(runNux);
@@ -182,14 +178,14 @@ void RunAccumCtg::ctgRuns(RunSet* runSet, const SplitNux& cand) {
 
 
 vector<RunNux> RunAccumCtg::orderBinary(const vector<RunNux>& runNux) {
-  heapBinary(runNux);
+  keyBinary(runNux);
   return slotReorder(runNux);
 }
 
 
 vector<RunNux> RunAccum::slotReorder(const vector<RunNux>& runNux) {
   vector<RunNux> frOrdered(runNux.size());
-  vector<PredictorT> idxRank = PQueue::depopulate<PredictorT>(&heapZero[0], frOrdered.size());
+  vector<PredictorT> idxRank = KeySort::rank<PredictorT>(&runKey[0], frOrdered.size());
 
   for (PredictorT slot = 0; slot < frOrdered.size(); slot++) {
     frOrdered[idxRank[slot]] = runNux[slot];
@@ -204,7 +200,7 @@ vector<RunNux> RunAccumCtg::runsExplicit(const SplitNux& cand) {
   PredictorT runIdx = 0;
   double* sumBase = initCtg(obsStart, runNux[runIdx], runIdx);
   for (IndexT obsIdx = obsStart + 1; obsIdx != obsEnd; obsIdx++) {
-    if (!obsCell[obsIdx].ctgAccum(runNux[runIdx], sumBase)) {
+    if (!obsCell[obsIdx].ctgAccum(runNux[runIdx], sumBase, ctgNux.local(obsCell[obsIdx].getCtg()))) {
       runNux[runIdx++].endRange(obsIdx - 1);
       sumBase = initCtg(obsIdx, runNux[runIdx], runIdx);
     }
@@ -226,7 +222,7 @@ vector<RunNux> RunAccumCtg::runsImplicit(const SplitNux& cand) {
     implicitSlot = runIdx++;
   double* sumBase = initCtg(obsStart, runNux[runIdx], runIdx);
   for (IndexT obsIdx = obsStart + 1; obsIdx != obsEnd; obsIdx++) {
-    if (!obsCell[obsIdx].ctgAccum(runNux[runIdx], sumBase)) {
+    if (!obsCell[obsIdx].ctgAccum(runNux[runIdx], sumBase, ctgNux.local(obsCell[obsIdx].getCtg()))) {
       runNux[runIdx].endRun(scExplicit, obsIdx-1);
       if (cutResidual == obsIdx) {
 	implicitSlot = ++runIdx;
@@ -247,34 +243,71 @@ vector<RunNux> RunAccumCtg::runsImplicit(const SplitNux& cand) {
 }
 
 
-vector<RunNux> RunAccumCtg::sampleRuns(const RunSet* runSet,
-				       const SplitNux& cand,
-				       const vector<RunNux>& runNux) {
-  vector<PredictorT> runIdx(runNux.size());
-  iota(runIdx.begin(), runIdx.end(), 0);
-  const double* rvAccum = runSet->rvSlice(cand.getAccumIdx());
-  vector<double> tempCtgSum(nCtg);
-  vector<double> tempSum(maxWidth * nCtg);
-  vector<RunNux> rvNux(maxWidth);
-  for (unsigned int idx = 0; idx < maxWidth; idx++) {
-    unsigned int runRandom = rvAccum[idx] * (runNux.size() - idx);
-    runIdx[runRandom] = runIdx[runNux.size() - idx - 1];
-    rvNux[idx] = runNux[runRandom];
-    for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
-      double sumCtg = runSum[runRandom * nCtg + ctg];
-      tempCtgSum[ctg] += sumCtg;
-      tempSum[idx * nCtg + ctg] = sumCtg;
+vector<RunNux> RunAccumCtg::orderWide(const vector<RunNux>& runNux) {
+  PredictorT nRun = runNux.size();
+  vector<PredictorT> rankMax(nRun);
+  double giniMax = -1.0;
+  for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
+    for (PredictorT slot = 0; slot < nRun; slot++) {
+      runKey[slot] = BHPair<PredictorT>(getRunSum(slot, ctg) / runNux[slot].sumCount.sum, slot);
     }
+    vector<PredictorT> idxRank = KeySort::rank<PredictorT>(&runKey[0], nRun);
+    vector<PredictorT> slotOrder(nRun);
+    for (PredictorT slot = 0; slot < nRun; slot++) {
+      slotOrder[idxRank[slot]] = slot;
+    }
+
+    PredictorT argMax;
+    double gini = scanOrdered(runNux, slotOrder, argMax);
+    if (gini > giniMax) {
+      giniMax = gini;
+      rankMax = idxRank;
+    }
+  }
+
+  vector<RunNux> runOrdered(nRun);
+  vector<double> sumOrdered(runSum.size());
+  for (PredictorT slot = 0; slot < nRun; slot++) {
+    PredictorT rank = rankMax[slot];
+    runOrdered[rank] = runNux[slot];
+    copy(&runSum[slot * nCtg], &runSum[(slot + 1) * nCtg], &sumOrdered[rank * nCtg]);
   }
+  runSum = move(sumOrdered);
 
-  double tempSS = 0;
-  for (PredictorT ctg = 0; ctg < nCtg; ctg++)
-    tempSS += tempCtgSum[ctg] * tempCtgSum[ctg];
+  return runOrdered;
+}
+
+
+double RunAccumCtg::scanOrdered(const vector<RunNux>& runNux,
+				const vector<PredictorT>& slotOrder,
+				PredictorT& argMax) const {
+  vector<double> sumL(nCtg);
+  double sumLTot = 0.0;
+  double ssL = 0.0;
+  double ssR = 0.0;
+  for (auto sumCtg : ctgNux.ctgSum) {
+    ssR += sumCtg * sumCtg;
+  }
 
-  ctgNux = CtgNux(tempCtgSum, tempSS);
-  runSum = tempSum;
+  double giniMax = -1.0;
+  argMax = runNux.size() - 1;
+  for (PredictorT pos = 0; pos != runNux.size() - 1; pos++) {
+    PredictorT slot = slotOrder[pos];
+    for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
+      double sumRun = getRunSum(slot, ctg);
+      ssL += sumRun * (sumRun + 2.0 * sumL[ctg]);
+      ssR += sumRun * (sumRun - 2.0 * (ctgNux.ctgSum[ctg] - sumL[ctg]));
+      sumL[ctg] += sumRun;
+      sumLTot += sumRun;
+    }
+    double gini = infoGini(ssL, ssR, sumLTot, sumCount.sum - sumLTot);
+    if (gini > giniMax) {
+      giniMax = gini;
+      argMax = pos;
+    }
+  }
 
-  return rvNux;
+  return giniMax;
 }
 
 
@@ -283,7 +316,7 @@ double* RunAccumCtg::initCtg(IndexT obsLeft,
 			     PredictorT runIdx) {
   nux.startRange(obsLeft);
   double* sumBase = &runSum[runIdx * nCtg];
-  obsCell[obsLeft].ctgInit(nux, sumBase);
+  obsCell[obsLeft].ctgInit(nux, sumBase, ctgNux.local(obsCell[obsLeft].getCtg()));
   return sumBase;
 }
 
@@ -320,6 +353,22 @@ void RunAccumCtg::split(const SFCtg* sfCtg, RunSet* runSet, SplitNux& cand) {
 }
 
 
+void RunAccumReg::splitRandom(const SFReg* sfReg, RunSet* runSet, SplitNux& cand, double ru) {
+  RunAccumReg runAccum(sfReg, cand, runSet);
+  runAccum.initRuns(runSet, cand);
+  cand.setInfo(runAccum.randomVar(runSet->getRunNux(cand), ru));
+  runSet->setToken(cand, runAccum.splitToken);
+}
+
+
+void RunAccumCtg::splitRandom(const SFCtg* sfCtg, RunSet* runSet, SplitNux& cand, double ru) {
+  RunAccumCtg runAccum(sfCtg, cand, runSet);
+  runAccum.initRuns(runSet, cand);
+  cand.setInfo(runAccum.randomGini(runSet->getRunNux(cand), ru));
+  runSet->setToken(cand, runAccum.splitToken);
+}
+
+
 void RunAccum::initRuns(RunSet* runSet,
 			const SplitNux& cand) {
   regRuns(runSet, cand);
@@ -342,10 +391,13 @@ double RunAccumReg::split(const RunSet* runSet,
 
 double RunAccumCtg::split(const RunSet* runSet,
 			  const SplitNux& cand) {
-  if (nCtg == 2)
-    return binaryGini(runSet->getRunNux(cand));
+  const vector<RunNux>& runNux = runSet->getRunNux(cand);
+  if (binary)
+    return binaryGini(runNux);
+  else if (isWide(runNux.size()))
+    return wideGini(runNux);
   else
-    return ctgGini(runSet->getRunNux(cand));
+    return ctgGini(runNux);
 }
 
 
@@ -364,6 +416,51 @@ double RunAccum::maxVar(const vector<RunNux>& runNux) {
 }
 
 
+double RunAccum::randomVar(const vector<RunNux>& runNux,
+			   double ru) {
+  double infoCell = info;
+  PredictorT runSlot = runNux.size() - 1;
+  PredictorT slotCut = min(static_cast<PredictorT>(ru * runSlot), runSlot - 1);
+  SumCount scAccum;
+  for (PredictorT slot = 0; slot <= slotCut; slot++) {
+    runNux[slot].accum(scAccum);
+  }
+  setToken(trialSplit(infoVar(scAccum, sumCount)) ? slotCut : runSlot);
+  return info - infoCell;
+}
+
+
+double RunAccumCtg::randomGini(const vector<RunNux>& runNux,
+			       double ru) {
+  double infoCell = info;
+  PredictorT runSlot = runNux.size() - 1;
+  if (binary || isWide(runNux.size())) { // Ordered, hence cut.
+    PredictorT slotCut = min(static_cast<PredictorT>(ru * runSlot), runSlot - 1);
+    double ssL = 0.0;
+    double ssR = 0.0;
+    double sumL = 0.0;
+    for (PredictorT ctg = 0; ctg < nCtg; ctg++) {
+      double sumCtg = 0.0;
+      for (PredictorT slot = 0; slot <= slotCut; slot++) {
+	sumCtg += getRunSum(slot, ctg);
+      }
+      sumL += sumCtg;
+      ssL += sumCtg * sumCtg;
+      ssR += (ctgNux.ctgSum[ctg] - sumCtg) * (ctgNux.ctgSum[ctg] - sumCtg);
+    }
+    setToken(trialSplit(infoGini(ssL, ssR, sumL, sumCount.sum - sumL)) ? slotCut : runSlot);
+  }
+  else {
+    // High bit unset, remainder set, as with exhaustive search.
+    PredictorT lowSet = (1ul << runSlot) - 1;
+    PredictorT subset = 1 + min(static_cast<PredictorT>(ru * lowSet), lowSet - 1);
+    setToken(trialSplit(subsetGini(runNux, subset)) ? subset : 0);
+  }
+
+  return info - infoCell;
+}
+
+
 double RunAccumCtg::ctgGini(const vector<RunNux>& runNux) {
   double infoCell = info;
   // Run index subsets as binary-encoded unsigneds.
@@ -436,13 +533,25 @@ double RunAccumCtg::binaryGini(const vector<RunNux>& runNux) {
 }
 
 
-void RunAccumCtg::heapBinary(const vector<RunNux>& runNux) {
+double RunAccumCtg::wideGini(const vector<RunNux>& runNux) {
+  double infoCell = info;
+  vector<PredictorT> slotOrder(runNux.size());
+  iota(slotOrder.begin(), slotOrder.end(), 0);
+  PredictorT argMaxRun;
+  double gini = scanOrdered(runNux, slotOrder, argMaxRun);
+  setToken(trialSplit(gini) ? argMaxRun : runNux.size() - 1);
+
+  return info - infoCell;
+}
+
+
+void RunAccumCtg::keyBinary(const vector<RunNux>& runNux) {
   // Ordering by category probability is equivalent to ordering by
   // concentration, as weighting by priors does not affect order.
   //
   // In the absence of class weighting, numerator can be (integer) slot
   // sample count, instead of slot sum.
   for (PredictorT slot = 0; slot < runNux.size(); slot++) {
-    PQueue::insert<PredictorT>(&heapZero[0], getRunSum(slot, 1) / runNux[slot].sumCount.sum, slot);
+    runKey[slot] = BHPair<PredictorT>(getRunSum(slot, 1) / runNux[slot].sumCount.sum, slot);
   }
 }
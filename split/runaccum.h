@@ -20,7 +20,7 @@
 #include "splitcoord.h"
 #include "sumcount.h"
 #include "accum.h"
-#include "bheap.h"
+#include "keysort.h"
 #include "runsig.h"
 
 #include <vector>
@@ -48,7 +48,7 @@
 */
 class RunAccum : public Accum {
 protected:
-  vector<BHPair<PredictorT>> heapZero; ///< Sorting workspace.
+  vector<BHPair<PredictorT>> runKey; ///< Sorting workspace.
   PredictorT splitToken; ///< Splitting cut or bits.
 
 
@@ -80,11 +80,22 @@ protected:
    */
   double maxVar(const vector<RunNux>& runNux);
 
+
+  /**
+     @brief As above, but evaluates a single random cut.
+
+     @param ru is a uniform variate selecting the cut.
+
+     @return gain in weighted variance.
+   */
+  double randomVar(const vector<RunNux>& runNux,
+		   double ru);
+
   
   /**
-     @brief Sorts by mean response.
+     @brief Keys runs by mean response.
    */
-  void heapMean(const vector<RunNux>& runNux);
+  void keyMean(const vector<RunNux>& runNux);
 
   
 public:
@@ -99,16 +110,21 @@ public:
 
 
   /**
-     @brief Determines whether run count must be truncated.
+     @brief Determines whether runs are too numerous for subset search.
+
+     Wide runs are instead split as an ordered sequence.
+
+     @param nRun is the number of runs, including any implicit.
 
      @return true iff run count exceeds maximum.
    */
-  static bool ctgWide(const class SplitFrontier* sf,
-		      const class SplitNux& cand);
+  static bool isWide(PredictorT nRun) {
+    return nRun > maxWidth;
+  }
 
 
   /**
-     @brief Depopulates the heap associated with a pair and places sorted ranks into rank vector.
+     @brief Ranks the keyed runs and reorders them accordingly.
   */
   vector<RunNux> slotReorder(const vector<RunNux>& runNux);
 
@@ -130,7 +146,7 @@ public:
 
 
   /**
-     @brief Writes to heap, weighting by slot mean response.
+     @brief Orders runs by mean response.
   */
   vector<RunNux> orderMean(const vector<RunNux>& runNux);
 
@@ -159,6 +175,17 @@ public:
 		    class RunSet* runSet,
 		    class SplitNux& cand);
 
+  /**
+     @brief Static entry for extremely-randomized splitting.
+
+     @param ru is a uniform variate selecting the cut.
+   */
+  static void splitRandom(const class SFReg* sfReg,
+			  class RunSet* runSet,
+			  class SplitNux& cand,
+			  double ru);
+
+
   /**
      @brief Private splitting entry.
    */
@@ -170,16 +197,40 @@ public:
 
 
 class RunAccumCtg : public RunAccum {
-  const PredictorT nCtg;
   CtgNux ctgNux;
+  const PredictorT nCtg; ///< Accumulator width:  categories present, if compacted.
+  const bool binary; ///< Binary response:  runs ordered and cut.
 
   // Initialized as a side-effect of RunNux construction:
   vector<double> runSum; ///>  run x ctg checkerboard.
 
 
-  vector<RunNux> sampleRuns(const class RunSet* runSet,
-			    const class SplitNux& cand,
-			    const vector<RunNux>& runNux);
+  /**
+     @brief Orders wide runs by the one-vs-rest ordering most informative
+     at its best cut.
+
+     Each category in turn orders the runs by its proportion, and the
+     ordered sequence is scanned for its Gini argmax.  For binary
+     response the orderings coincide with that of the exhaustive
+     search.  Run sums are reordered in tandem.
+
+     @return reordered runs.
+   */
+  vector<RunNux> orderWide(const vector<RunNux>& runNux);
+
+
+  /**
+     @brief Scans cuts of runs as ordered by a slot map.
+
+     @param slotOrder maps ordered positions to run slots.
+
+     @param[out] argMax outputs the highest left position at the maximum.
+
+     @return maximal Gini over cuts.
+   */
+  double scanOrdered(const vector<RunNux>& runNux,
+		     const vector<PredictorT>& slotOrder,
+		     PredictorT& argMax) const;
 
 
   void initRuns(class RunSet* runSet,
@@ -229,15 +280,15 @@ public:
 
 
   /**
-     @brief Writes to heap, weighting by category-1 probability.
+     @brief Orders runs by category-1 probability.
   */
   vector<RunNux> orderBinary(const vector<RunNux>& runNux);
 
 
   /**
-     @brief Sorts by probability, binary response.
+     @brief Keys runs by probability, binary response.
    */
-  void heapBinary(const vector<RunNux>& runNux);
+  void keyBinary(const vector<RunNux>& runNux);
 
 
   /**
@@ -246,6 +297,17 @@ public:
   static void split(const class SFCtg* sf,
 		    class RunSet* runSet,
 		    class SplitNux& cand);
+
+
+  /**
+     @brief Static entry for extremely-randomized splitting.
+
+     @param ru is a uniform variate selecting the cut or subset.
+   */
+  static void splitRandom(const class SFCtg* sf,
+			  class RunSet* runSet,
+			  class SplitNux& cand,
+			  double ru);
   
 
   double* initCtg(IndexT runLeft,
@@ -329,6 +391,30 @@ public:
      @return Gini information gain.
    */
   double binaryGini(const vector<RunNux>& runNux);
+
+
+  /**
+     @brief Evaluates the Gini of a single random split.
+
+     Ordered runs, as with binary response or wide runs, are cut at a
+     random position.  Otherwise a random nontrivial subset is taken.
+
+     @param ru is a uniform variate selecting the split.
+
+     @return Gini information gain.
+   */
+  double randomGini(const vector<RunNux>& runNux,
+		    double ru);
+
+
+  /**
+     @brief Gini-based splitting of wide runs, previously ordered.
+
+     As with binary response, the split is expressed as a cut.
+
+     @return Gini information gain.
+   */
+  double wideGini(const vector<RunNux>& runNux);
 };
 
 
@@ -13,7 +13,6 @@
    @author Mark Seligman
  */
 
-#include "prng.h"
 #include "runaccum.h"
 #include "interlevel.h"
 #include "splitfrontier.h"
@@ -27,18 +26,13 @@ RunSet::RunSet(const SplitFrontier* sf) :
 }
 
 
-IndexT RunSet::preIndex(const SplitFrontier*sf, const SplitNux& cand) {
-  if (RunAccum::ctgWide(sf, cand))
-    runWide.push_back(nAccum);
-
+IndexT RunSet::preIndex() {
   return nAccum++;
 }
 
 
-void RunSet::accumPreset(const SplitFrontier* sf) {
+void RunSet::accumPreset() {
   runSig = vector<RunSig>(nAccum);
-  if (!runWide.empty())
-    rvWide = PRNG::rUnif(RunAccum::maxWidth * runWide.size());
 }
 
 
@@ -90,19 +84,15 @@ void RunSet::accumUpdate(const SplitNux& cand) {
 }
 
 
-void RunSet::setTrueBits(const InterLevel* interLevel,
-			 const SplitNux& nux,
-			 class BV* splitBits,
-			 size_t bitPos) const {
-  runSig[nux.getAccumIdx()].setTrueBits(interLevel, nux, splitBits, bitPos);
+vector<IndexT> RunSet::getTrueCodes(const InterLevel* interLevel,
+				    const SplitNux& nux) const {
+  return runSig[nux.getAccumIdx()].getTrueCodes(interLevel, nux);
 }
 
 
-void RunSet::setObservedBits(const InterLevel* interLevel,
-			     const SplitNux& nux,
-			     class BV* splitBits,
-			     size_t bitPos) const {
-  runSig[nux.getAccumIdx()].setObservedBits(interLevel, nux, splitBits, bitPos);
+vector<IndexT> RunSet::getObservedCodes(const InterLevel* interLevel,
+					const SplitNux& nux) const {
+  return runSig[nux.getAccumIdx()].getObservedCodes(interLevel, nux);
 }
 
 
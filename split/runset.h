@@ -35,10 +35,6 @@ class RunSet {
   PredictorT nAccum; ///> # of accumulators.
   vector<RunSig> runSig;
 
-  // Non-binary categorical only:
-  vector<IndexT> runWide; ///> Wide-run accumulator indices, ordered.
-  vector<double> rvWide; ///> Random variates for sampling wide runs.
-
 public:
 
   const SplitStyle style; // Splitting style, fixed by frontier class.
@@ -49,27 +45,13 @@ public:
   RunSet(const class SplitFrontier* sf);
 
 
-  /**
-     @brief Determines position of random-variate slice.
-
-     Slices have an implicit width of RunAccum::maxWidth.
-     
-     @param accumIdx is the index of a wide-run accumulator.
-
-     @return base variate position for accumulator.
-   */
-  inline const double* rvSlice(IndexT accumIdx) const {
-    return &rvWide[RunAccum::maxWidth * (lower_bound(runWide.begin(), runWide.end(), accumIdx) - runWide.begin())];
-  }
-
   
   /**
      @brief Adds local run count to vector of safe counts.
 
      @return offset of run just appended.
    */
-  IndexT preIndex(const class SplitFrontier* sf,
-		  const class SplitNux& cand);
+  IndexT preIndex();
 
 
   //  void addRun(unique_ptr<RunAccum> upt,
@@ -80,10 +62,8 @@ public:
 
   /**
      @brief Consolidates the safe count vector.
-
-     Classification:  only wide run sets use the heap.
   */
-  void accumPreset(const class SplitFrontier* sf);
+  void accumPreset();
 
   
   /**
@@ -116,23 +96,19 @@ public:
   
 
   /**
-     @brief Sets bits corresponding to true-sense branch.
+     @brief Collects codes corresponding to true-sense branch.
 
      Passes through to accumulator method.
    */
-  void setTrueBits(const class InterLevel* interLevel,
-		   const class SplitNux& nux,
-		   class BV* splitBits,
-		   size_t bitPos) const;
+  vector<IndexT> getTrueCodes(const class InterLevel* interLevel,
+			      const class SplitNux& nux) const;
 
   
   /**
-     @brief As above, but all observed bits.
+     @brief As above, but all observed codes.
    */
-  void setObservedBits(const class InterLevel* interLevel,
-		       const class SplitNux& nux,
-		       class BV* splitBits,
-		       size_t bitPos) const;
+  vector<IndexT> getObservedCodes(const class InterLevel* interLevel,
+				  const class SplitNux& nux) const;
 
 
   PredictorT getRunCount(const class SplitNux* nux) const;
@@ -18,6 +18,7 @@
 #include "splitfrontier.h"
 #include "splitnux.h"
 #include "interlevel.h"
+#include "runaccum.h"
 
 vector<IndexRange> RunSig::getTopRange(const CritEncoding& enc) const {
   vector<IndexRange> rangeVec;
@@ -26,25 +27,23 @@ vector<IndexRange> RunSig::getTopRange(const CritEncoding& enc) const {
 }
 
 
-void RunSig::setTrueBits(const InterLevel* interLevel,
-			   const SplitNux& nux,
-			   BV* splitBits,
-			   size_t bitPos) const {
+vector<IndexT> RunSig::getTrueCodes(const InterLevel* interLevel,
+				    const SplitNux& nux) const {
+  vector<IndexT> codes;
   for (PredictorT trueIdx = baseTrue; trueIdx < baseTrue + runsTrue; trueIdx++) {
-    IndexT code = interLevel->getCode(nux, getObs(trueIdx), nux.isImplicit(runNux[trueIdx]));
-    splitBits->setBit(bitPos + code);
+    codes.push_back(interLevel->getCode(nux, getObs(trueIdx), nux.isImplicit(runNux[trueIdx])));
   }
+  return codes;
 }
 
 
-void RunSig::setObservedBits(const InterLevel* interLevel,
-			       const SplitNux& nux,
-			       BV* observedBits,
-			       size_t bitPos) const {
+vector<IndexT> RunSig::getObservedCodes(const InterLevel* interLevel,
+					const SplitNux& nux) const {
+  vector<IndexT> codes;
   for (PredictorT runIdx = 0; runIdx != runNux.size(); runIdx++) {
-    IndexT code = interLevel->getCode(nux, getObs(runIdx), nux.isImplicit(runNux[runIdx]));
-    observedBits->setBit(bitPos + code);
+    codes.push_back(interLevel->getCode(nux, getObs(runIdx), nux.isImplicit(runNux[runIdx])));
   }
+  return codes;
 }
 
 
@@ -81,7 +80,10 @@ void RunSig::updateCriterion(const SplitNux& cand, SplitStyle style) {
     leadSlots(cand);
   }
   else if (style == SplitStyle::bits) {
-    leadBits(cand);
+    if (RunAccum::isWide(runNux.size())) // Ordered, hence cut.
+      leadSlots(cand);
+    else
+      leadBits(cand);
   }
   else if (style == SplitStyle::topSlot) {
     topSlot(cand);
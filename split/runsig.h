@@ -211,24 +211,20 @@ struct RunSig {
 
 
   /**
-     @brief Emits the left-most codes as true-branch bit positions.
+     @brief Emits the left-most codes as true-branch levels.
 
      True codes are enumerated from the left, by convention.  Implicit runs are
      guranteed not to lie on the left.
    */
-  void setTrueBits(const class InterLevel* interLevel,
-		   const class SplitNux& nux,
-		   class BV* splitBits,
-		   size_t bitPos) const;
+  vector<IndexT> getTrueCodes(const class InterLevel* interLevel,
+			      const class SplitNux& nux) const;
 
 
   /**
      @brief Reports the factor codes observed at the node.
    */
-  void setObservedBits(const class InterLevel* interLevel,
-		       const class SplitNux& nux,
-		       class BV* splitBits,
-		       size_t bitPos) const;
+  vector<IndexT> getObservedCodes(const class InterLevel* interLevel,
+				  const class SplitNux& nux) const;
   
   /**
      @brief Establishes cut position of argmax factor.
@@ -22,19 +22,26 @@
 #include "runset.h"
 #include "cutset.h"
 #include "predictorframe.h"
-#include "ompthread.h"
+#include "taskpool.h"
 #include "prng.h"
 #include "algsf.h"
+#include "sampleidx.h"
+#include "trainparam.h"
+#include "runaccum.h"
+#include "tracelog.h"
 
+#include <cmath>
+#include <numeric>
+#include <algorithm>
 
-vector<double> SFReg::mono; // Numeric monotonicity constraints.
+
+const PredictorT SFCtg::compactCtg = 32;
 
 
 SplitFrontier::SplitFrontier(Frontier* frontier_,
 			     bool compoundCriteria_,
 			     EncodingStyle encodingStyle_,
-			     SplitStyle splitStyle_,
-			     void (SplitFrontier::* splitter_)(vector<SplitNux>&, BranchSense&)) :
+			     SplitStyle splitStyle_) :
   frame(frontier_->getFrame()),
   frontier(frontier_),
   interLevel(frontier->getInterLevel()),
@@ -42,22 +49,54 @@ SplitFrontier::SplitFrontier(Frontier* frontier_,
   encodingStyle(encodingStyle_),
   splitStyle(splitStyle_),
   nSplit(frontier->getNSplit()),
-  splitter(splitter_),
   runSet(make_unique<RunSet>(this)),
-  cutSet(make_unique<CutSet>()) {
+  cutSet(make_unique<CutSet>()),
+  gainable(gainableNodes()),
+  nCand(0),
+  nScanned(0) {
 }
 
 
 void SplitFrontier::split(CandType& cand,
 			  BranchSense& branchSense) {
-  vector<SplitNux> candidates = cand.getCandidates(interLevel, this);
+  TraceSpan traceSpan("split");
+  vector<SplitNux> sc = candidates(cand);
+  vector<IndexT> order = scheduleOrder(sc);
+  TaskPool::parallelFor(order.size(), [&](OMPBound schedPos) {
+      IndexT splitPos = order[schedPos];
+      evaluate(sc[splitPos], splitPos);
+    }, &frontier->getTrainStat()->loadSplit, "evaluate");
+
+  consume(sc, branchSense);
+}
+
+
+vector<SplitNux> SplitFrontier::candidates(CandType& cand) {
+  vector<SplitNux> sc = cand.getCandidates(interLevel, this);
+  for (const SplitNux& nux : sc) {
+    if (isGainable(nux)) {
+      nCand++;
+      nScanned += nux.getObsExtent();
+    }
+  }
   accumPreset(); // virtual.
-  (this->*splitter)(candidates, branchSense);
+  stageCandidates(sc);
+  return sc;
+}
+
+
+void SplitFrontier::stageCandidates(const vector<SplitNux>&) {
+}
+
+
+void SplitFrontier::consume(const vector<SplitNux>& sc,
+			    BranchSense& branchSense) {
+  maxSimple(sc, branchSense);
 }
 
 
 void SplitFrontier::accumPreset() {
-  runSet->accumPreset(this);
+  runSet->accumPreset();
   cutSet->accumPreset();
 }
 
@@ -67,12 +106,17 @@ PredictorT SplitFrontier::getNCtg() const {
 }
 
 
+IndexT SplitFrontier::getNCut() const {
+  return frontier->getParam()->nCut;
+}
+
+
 const ObsPart* SplitFrontier::getPartition() const {
   return interLevel->getObsPart();
 }
 
 
-IndexT* SplitFrontier::getIdxBuffer(const SplitNux& nux) const {
+SampleIdx SplitFrontier::getIdxBuffer(const SplitNux& nux) const {
   return interLevel->getIdxBuffer(nux);
 }
 
@@ -82,6 +126,62 @@ Obs* SplitFrontier::getPredBase(const SplitNux& nux) const {
 }
 
 
+unsigned int SplitFrontier::getBin(const SplitNux& nux,
+				   IndexT obsIdx) const {
+  return frame->getBin(nux.getPredIdx(), interLevel->getCode(nux, obsIdx, false));
+}
+
+
+vector<bool> SplitFrontier::gainableNodes() const {
+  vector<bool> nodeGainable(nSplit, true);
+  if (frontier->getParam()->nOut != 0) // Bounds the summary response only.
+    return nodeGainable;
+
+  for (IndexT splitIdx = 0; splitIdx != nSplit; splitIdx++) {
+    nodeGainable[splitIdx] = frontier->getNode(splitIdx).isGainable();
+  }
+  return nodeGainable;
+}
+
+
+bool SplitFrontier::isGainable(const SplitNux& nux) const {
+  return gainable[nux.getNodeIdx()];
+}
+
+
+double SplitFrontier::splitCost(const SplitNux& nux) const {
+  double extent = nux.getObsExtent();
+  if (!isFactor(nux))
+    return extent;
+
+  double nRun = nux.getRunCount();
+  double cost = extent + nRun * log2(nRun + 1.0);
+  PredictorT nCtg = getNCtg();
+  if (nCtg > 2) { // Subsets of at most 'maxWidth' runs, by category.
+    cost += ldexp(1.0, min<int>(nRun, RunAccum::maxWidth) - 1) * nCtg;
+  }
+  return cost;
+}
+
+
+vector<IndexT> SplitFrontier::scheduleOrder(const vector<SplitNux>& sc) const {
+  vector<double> cost(sc.size());
+  for (IndexT splitPos = 0; splitPos != sc.size(); splitPos++) {
+    cost[splitPos] = splitCost(sc[splitPos]);
+  }
+
+  vector<IndexT> order;
+  for (IndexT splitPos = 0; splitPos != sc.size(); splitPos++) {
+    if (isGainable(sc[splitPos]))
+      order.push_back(splitPos);
+  }
+  stable_sort(order.begin(), order.end(), [&cost](IndexT a, IndexT b) {
+      return cost[a] > cost[b];
+    });
+  return order;
+}
+
+
 bool SplitFrontier::isFactor(const SplitNux& nux) const {
   return frame->isFactor(nux);
 }
@@ -94,7 +194,7 @@ PredictorT SplitFrontier::getNumIdx(PredictorT predIdx) const {
 
 IndexT SplitFrontier::accumulatorIndex(const SplitNux& cand) const {
   if (isFactor(cand)) {
-    return runSet->preIndex(this, cand);
+    return runSet->preIndex();
   }
   else {
     return cutSet->preIndex();
@@ -107,6 +207,11 @@ bool SplitFrontier::leftCut(const SplitNux& cand) const {
 }
 
 
+bool SplitFrontier::missingLeft(const SplitNux& cand) const {
+  return cutSet->missingLeft(cand);
+}
+
+
 void SplitFrontier::writeCut(const SplitNux& nux,
 			     const CutAccum& accum) const {
   cutSet->write(interLevel, nux, accum);
@@ -171,30 +276,13 @@ PredictorT SplitFrontier::critBitCount(const SplitNux& nux) const {
 SFReg::SFReg(class Frontier* frontier,
 	     bool compoundCriteria,
 	     EncodingStyle encodingStyle,
-	     SplitStyle splitStyle,
-	     void (SplitFrontier::* splitter)(vector<SplitNux>&, BranchSense&)):
-  SplitFrontier(frontier, compoundCriteria, encodingStyle, splitStyle, splitter),
+	     SplitStyle splitStyle) :
+  SplitFrontier(frontier, compoundCriteria, encodingStyle, splitStyle),
+  mono(frontier->getParam()->mono),
   ruMono(vector<double>(0)) {
 }
 
 
-void SFReg::immutables(const PredictorFrame* frame,
-		      const vector<double>& bridgeMono) {
-  auto numFirst = frame->getNumFirst();
-  auto numExtent = frame->getNPredNum();
-  auto monoCount = count_if(bridgeMono.begin() + numFirst, bridgeMono.begin() + numExtent, [] (double prob) { return prob != 0.0; });
-  if (monoCount > 0) {
-    mono = vector<double>(frame->getNPredNum());
-    mono.assign(bridgeMono.begin() + frame->getNumFirst(), bridgeMono.begin() + frame->getNumFirst() + frame->getNPredNum());
-  }
-}
-
-
-void SFReg::deImmutables() {
-  mono.clear();
-}
-
-
 int SFReg::getMonoMode(const SplitNux& cand) const {
   if (mono.empty())
     return 0;
@@ -230,12 +318,9 @@ void SFReg::accumPreset() {
 SFCtg::SFCtg(class Frontier* frontier,
 	     bool compoundCriteria,
 	     EncodingStyle encodingStyle,
-	     SplitStyle splitStyle,
-	     void (SplitFrontier::* splitter) (vector<SplitNux>&, BranchSense&)) :
-  SplitFrontier(frontier, compoundCriteria, encodingStyle, splitStyle, splitter),
+	     SplitStyle splitStyle) :
+  SplitFrontier(frontier, compoundCriteria, encodingStyle, splitStyle),
   nCtg(frontier->getNCtg()),
-  ctgSum(vector<vector<double>>(nSplit)),
-  sumSquares(frontier->sumsAndSquares(ctgSum)),
   ctgJitter(PRNG::rUnif(nCtg * nSplit, 0.5)) {
 }
 
@@ -264,40 +349,77 @@ double SFCtg::getScore(const IndexSet& iSet) const {
 }
 
 
-const vector<double>& SFCtg::ctgNodeSums(const SplitNux& cand) const {
-  return ctgSum[cand.getNodeIdx()];
+void SFCtg::accumPreset() {
+  SplitFrontier::accumPreset();
+  ctgPresent.clear();
+  if (nCtg < compactCtg)
+    return;
+
+  ctgPresent = vector<vector<PredictorT>>(nSplit);
+  for (IndexT splitIdx = 0; splitIdx != nSplit; splitIdx++) {
+    vector<PredictorT>& present = ctgPresent[splitIdx];
+    PredictorT ctg = 0;
+    for (const SumCount& sc : frontier->getNode(splitIdx).getCtgSumCount()) {
+      if (sc.getSCount() > 0)
+	present.push_back(ctg);
+      ctg++;
+    }
+    if (present.size() == nCtg) // Nothing to compact.
+      present.clear();
+  }
 }
 
 
-void SplitFrontier::maxSimple(const vector<SplitNux>& sc,
-			      BranchSense& branchSense) {
-  frontier->updateSimple(maxCandidates(groupCand(sc)), branchSense);
-}
+const PredictorT* SFCtg::ctgLocalMap(const SplitNux& cand) const {
+  if (ctgPresent.empty() || ctgPresent[cand.getNodeIdx()].empty())
+    return nullptr;
 
+  // Slots of categories absent from the node are stale, but unread.
+  static thread_local vector<PredictorT> ctgLocal;
+  if (ctgLocal.size() < nCtg)
+    ctgLocal.resize(nCtg);
+  PredictorT slot = 0;
+  for (PredictorT ctg : ctgPresent[cand.getNodeIdx()]) {
+    ctgLocal[ctg] = slot++;
+  }
+  return &ctgLocal[0];
+}
 
-vector<SplitNux> SplitFrontier::maxCandidates(const vector<vector<SplitNux>>& candVV) {
-  vector<SplitNux> argMax(nSplit); // Info initialized to zero.
 
-  OMPBound splitTop = nSplit;
-#pragma omp parallel default(shared) num_threads(OmpThread::nThread)
-  {
-#pragma omp for schedule(dynamic, 1)
-    for (OMPBound splitIdx = 0; splitIdx < splitTop; splitIdx++) {
-      argMax[splitIdx] = frontier->candMax(splitIdx, candVV[splitIdx]);
+vector<double> SFCtg::ctgNodeSums(const SplitNux& cand) const {
+  const auto& ctgSumCount = frontier->getNode(cand.getNodeIdx()).getCtgSumCount();
+  vector<double> ctgSum;
+  if (!ctgPresent.empty() && !ctgPresent[cand.getNodeIdx()].empty()) {
+    ctgSum.reserve(ctgPresent[cand.getNodeIdx()].size());
+    for (PredictorT ctg : ctgPresent[cand.getNodeIdx()]) {
+      ctgSum.push_back(ctgSumCount[ctg].sum);
     }
+    return ctgSum;
   }
 
-  return argMax;
+  ctgSum.reserve(nCtg);
+  for (const SumCount& sc : ctgSumCount) {
+    ctgSum.push_back(sc.sum);
+  }
+  return ctgSum;
 }
 
 
-vector<vector<SplitNux>> SplitFrontier::groupCand(const vector<SplitNux>& cand) const {
-  vector<vector<SplitNux>> candVV(nSplit);
-  for (auto nux : cand) {
-    candVV[nux.getNodeIdx()].emplace_back(nux);
+void SplitFrontier::maxSimple(const vector<SplitNux>& sc,
+			      BranchSense& branchSense) {
+  const SplitNux zeroNux; // Zero-information placeholder.
+  vector<const SplitNux*> argMax(nSplit, &zeroNux);
+  for (const SplitNux& nux : sc) {
+    const SplitNux*& amn = argMax[nux.getNodeIdx()];
+    if (nux.maxInfo(*amn))
+      amn = &nux;
   }
 
-  return candVV;
+  vector<SplitNux> nuxMax(nSplit);
+  for (IndexT splitIdx = 0; splitIdx != nSplit; splitIdx++) {
+    nuxMax[splitIdx] = frontier->candMax(splitIdx, *argMax[splitIdx]);
+  }
+  frontier->updateSimple(nuxMax, branchSense);
 }
 
 
@@ -328,12 +450,15 @@ vector<IndexRange> SplitFrontier::getRange(const SplitNux& nux,
 vector<IndexRange> SplitFrontier::getCutRange(const SplitNux& nux,
 					      const CritEncoding& enc) const {
 // Returns the left range iff (BOTH left cut AND true encoding or NEITHER left cut NOR true encoding).
+  bool leftRange = !(leftCut(nux) ^ enc.trueEncoding());
   vector<IndexRange> rangeVec;
-  rangeVec.push_back(nux.cutRange(cutSet.get(), !(leftCut(nux) ^ enc.trueEncoding())));
+  rangeVec.push_back(nux.cutRange(cutSet.get(), leftRange));
+  if (leftRange && missingLeft(nux)) // Missing tail is not contiguous.
+    rangeVec.push_back(nux.missingRange());
   return rangeVec;
 }
 
 
 double SFCtg::getSumSquares(const SplitNux& cand) const {
-  return sumSquares[cand.getNodeIdx()];
+  return frontier->getNode(cand.getNodeIdx()).getCtgSquares();
 }
@@ -46,21 +46,55 @@ protected:
   EncodingStyle encodingStyle; // How to update observation tree.
   const SplitStyle splitStyle;
   const IndexT nSplit; // # subtree nodes at current layer.
-  void (SplitFrontier::* splitter)(vector<class SplitNux>& candidate,
-				   class BranchSense&); // Splitting method.
 
   unique_ptr<RunSet> runSet; // Run accumulators for the current frontier.
   unique_ptr<CutSet> cutSet; // Cut accumulators for the current frontier.
+  const vector<bool> gainable; // Per node:  whether a split might be informative.
+  IndexT nCand; // # candidates evaluated:  instrumentation.
+  size_t nScanned; // # observation cells spanned by candidates.
 
 
   /**
      @brief Derives and applies maximal simple criteria.
+
+     A single pass over the candidates maintains a running arg-max per
+     node, in candidate order, so ties resolve as a per-node scan would.
    */
   void maxSimple(const vector<SplitNux>& sc,
 		 class BranchSense& branchSense);
 
-  
-  vector<class SplitNux> maxCandidates(const vector<vector<class SplitNux>>& candVV);
+
+  /**
+     @brief Readies the level's candidates for evaluation, as by
+     drawing variates serially.
+
+     Invoked once per level, ahead of any call to evaluate().  The
+     default stages nothing.
+   */
+  virtual void stageCandidates(const vector<class SplitNux>& sc);
+
+
+  /**
+     @brief Bounds the attainable gain of each node on the frontier.
+
+     Jointly-split responses are not bounded, as the bound derives
+     from the summary response alone.
+
+     @return per-node vector of gainability.
+   */
+  vector<bool> gainableNodes() const;
+
+
+  /**
+     @brief Orders candidates by decreasing estimated cost.
+
+     Dynamically-scheduled splitting then dispatches the most costly
+     candidates first, so that small candidates fill the tail rather
+     than wait behind a large one.
+
+     @return positions of gainable candidates, in scheduling order.
+   */
+  vector<IndexT> scheduleOrder(const vector<class SplitNux>& sc) const;
 
   
   /**
@@ -78,14 +112,71 @@ public:
   SplitFrontier(class Frontier* frontier_,
 		bool compoundCriteria_,
 		EncodingStyle encodingStyle_,
-		SplitStyle splitStyle_,
-		void (SplitFrontier::* splitter_)(vector<class SplitNux>&, class BranchSense&));
+		SplitStyle splitStyle_);
 
   virtual ~SplitFrontier() = default;
   
 
+  /**
+     @brief Splits the level's nodes:  draws, evaluates and consumes
+     the candidates.
+   */
   void split(CandType& cand,
 	     class BranchSense& branchSense);
+
+
+  /**
+     @brief Draws the level's candidates and readies them for
+     evaluation.
+
+     Separated from split() so that the candidates of several
+     frontiers may be evaluated within a single dispatch.
+
+     @return candidates, in node order.
+   */
+  vector<class SplitNux> candidates(CandType& cand);
+
+
+  /**
+     @brief Evaluates a single candidate, in place.
+
+     Safe for concurrent invocation on distinct candidates.
+
+     @param pos is the candidate's position among the level's.
+   */
+  virtual void evaluate(class SplitNux& cand,
+			IndexT pos) = 0;
+
+
+  /**
+     @brief Applies the maximal evaluated candidates to their nodes.
+   */
+  void consume(const vector<class SplitNux>& sc,
+	       class BranchSense& branchSense);
+
+
+  /**
+     @brief Determines whether a candidate merits evaluation.
+
+     Candidates of nodes whose gain bound falls below the information
+     threshold cannot be informative, and are left unevaluated.  They
+     remain in place, so that positionally-drawn variates are unshifted.
+
+     @return true iff the candidate's node might split informatively.
+   */
+  bool isGainable(const class SplitNux& nux) const;
+
+
+  /**
+     @brief Estimates the relative cost of splitting a candidate.
+
+     Scans are linear in the candidate's extent.  Factor candidates
+     additionally order their runs and, for multi-category responses,
+     enumerate run subsets up to the accumulator's width threshold.
+
+     @return cost estimate, in nominal cell visits.
+   */
+  virtual double splitCost(const class SplitNux& nux) const;
   
 
   auto getEncodingStyle() const {
@@ -112,22 +203,18 @@ public:
   /**
      @brief Passes through to RunSet method.
 
-     Sets bit offsets of factors encoding true criterion.
+     @return factor codes encoding true criterion.
    */
-  void setTrueBits(const SplitNux& nux,
-		   class BV* splitBits,
-		   size_t bitPos) const {
-    runSet->setTrueBits(interLevel, nux, splitBits, bitPos);
+  vector<IndexT> getTrueCodes(const SplitNux& nux) const {
+    return runSet->getTrueCodes(interLevel, nux);
   }
 
 
   /**
-     @brief As above, but observed bits.
+     @brief As above, but observed codes.
    */
-  void setObservedBits(const SplitNux& nux,
-		       class BV* splitBits,
-		       size_t bitPos) const {
-    runSet->setObservedBits(interLevel, nux, splitBits, bitPos);
+  vector<IndexT> getObservedCodes(const SplitNux& nux) const {
+    return runSet->getObservedCodes(interLevel, nux);
   }
 
 
@@ -174,6 +261,17 @@ public:
    */
   class Obs* getPredBase(const SplitNux& cand) const;
 
+
+  /**
+     @brief Looks up the bin of an explicit, nonmissing observation.
+
+     @param obsIdx is the observation's staged position.
+
+     @return bin of observation's rank, predictor assumed binned.
+   */
+  unsigned int getBin(const SplitNux& cand,
+		      IndexT obsIdx) const;
+
   
   /**
      @brief Interpolates a cutting quantile according to front-end specification.
@@ -205,6 +303,12 @@ public:
      @return true iff split is a left cut.
    */
   bool leftCut(const SplitNux& cand) const;
+
+
+  /**
+     @return true iff a numeric cut routes missing observations left.
+   */
+  bool missingLeft(const SplitNux& cand) const;
   
 
   /**
@@ -217,6 +321,16 @@ public:
   bool isFactor(const class SplitNux& nux) const;
 
 
+  IndexT getNCand() const {
+    return nCand;
+  }
+
+
+  size_t getNScanned() const {
+    return nScanned;
+  }
+
+
   /**
      @brief Getter for split count.
    */
@@ -261,7 +375,7 @@ public:
   /**
      @brief Passes through to ObsPart method.
    */
-  IndexT* getIdxBuffer(const class SplitNux& nux) const;
+  struct SampleIdx getIdxBuffer(const class SplitNux& nux) const;
   
 
   /**
@@ -270,6 +384,12 @@ public:
   PredictorT getNCtg() const;
 
 
+  /**
+     @return number of cuts evaluated by a numeric scan, if nonzero.
+   */
+  IndexT getNCut() const;
+
+
   /**
      @brief Updates accumulator state for successful split.
 
@@ -288,12 +408,6 @@ public:
   }
 
 
-  /**
-     @brief Separates candidates into split-specific vectors.
-   */
-  vector<vector<class SplitNux>> groupCand(const vector<SplitNux>& cand) const;
-
-
   // These are run-time invariant and need not be virtual:
   virtual void accumPreset();
 
@@ -303,9 +417,9 @@ public:
 
 
 struct SFReg : public SplitFrontier {
-  // Bridge-supplied monotone constraints.  Length is # numeric predictors
+  // Session's monotone constraints.  Length is # numeric predictors
   // or zero, if none so constrained.
-  static vector<double> mono;
+  const vector<double>& mono;
 
   // Per-layer vector of uniform variates.
   vector<double> ruMono;
@@ -313,25 +427,7 @@ struct SFReg : public SplitFrontier {
   SFReg(class Frontier* frontier,
 	bool compoundCriteria,
 	EncodingStyle encodingStyle,
-	SplitStyle splitStyle,
-	void (SplitFrontier::* splitter_)(vector<class SplitNux>&, class BranchSense&));
-
-
-  /**
-     @brief Caches a dense local copy of the mono[] vector.
-
-     @param summaryFrame contains the predictor block mappings.
-
-     @param bridgeMono has length equal to the predictor count.  Only
-     numeric predictors may have nonzero entries.
-  */
-  static void immutables(const class PredictorFrame* summaryFrame,
-                         const vector<double>& feMono);
-
-  /**
-     @brief Resets the monotone constraint vector.
-   */
-  static void deImmutables();
+	SplitStyle splitStyle);
   
 
   /**
@@ -353,31 +449,54 @@ struct SFReg : public SplitFrontier {
 
 
 class SFCtg : public SplitFrontier {
+  static const PredictorT compactCtg; // Minimal cardinality compacted.
+
 protected:
   const PredictorT nCtg;
-  vector<vector<double> > ctgSum; // Per-category response sums, by node.
-  vector<double> sumSquares; // Per-layer sum of squares, by split.
   vector<double> ctgJitter; // Breaks scoring ties at node.
+  vector<vector<PredictorT>> ctgPresent; // Per-node categories, iff compacted.
 
   
 public:
   SFCtg(class Frontier* frontier,
 	bool compoundCriteria,
 	EncodingStyle encodingStyle,
-	SplitStyle splitStyle,
-	void (SplitFrontier::* splitter_) (vector<class SplitNux>&, class BranchSense&));
+	SplitStyle splitStyle);
   
   double getScore(const class IndexSet& iSet) const;
 
 
+  /**
+     @brief Records the categories sampled at each node, for wide responses.
+
+     Nodes of a high-cardinality response typically hold only a few
+     of its categories, so their accumulators are compacted to these.
+  */
+  void accumPreset();
+
+
+  /**
+     @brief Maps the categories present at a candidate's node to dense
+     accumulator slots.
+
+     The map is thread-local, so remains valid until the calling
+     thread maps another candidate.
+
+     @return slot indexed by category, or null if the node is not compacted.
+   */
+  const PredictorT* ctgLocalMap(const class SplitNux& cand) const;
+
+
   /**
      @brief Copies per-category sum vector associated with candidate's node.
 
+     Sums of a compacted node are restricted to its categories present.
+
      @param cand is the splitting candidate.
 
-     @return reference to vector of per-category sums.
+     @return per-category sums, as a vector owned by the caller.
    */
-  const vector<double>& ctgNodeSums(const class SplitNux& cand) const;
+  vector<double> ctgNodeSums(const class SplitNux& cand) const;
 
 
   /**
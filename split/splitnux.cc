@@ -19,26 +19,6 @@
 #include "splitnux.h"
 
 
-double SplitNux::minRatio = minRatioDefault;
-
-vector<double> SplitNux::splitQuant;
-
-
-void SplitNux::immutables(double minRatio,
-			  const vector<double>& feSplitQuant) {
-  SplitNux::minRatio = minRatio;
-  for (auto quant : feSplitQuant) {
-    splitQuant.push_back(quant);
-  }
-}
-
-
-void SplitNux::deImmutables() {
-  minRatio = minRatioDefault;
-  splitQuant.clear();
-}
-
-
 SplitNux::SplitNux(const StagedCell* cell_,
 		   double randVal_,
 		   const SplitFrontier* splitFrontier) :
@@ -84,5 +64,11 @@ IndexRange SplitNux::cutRangeLeft(const CutSet* cutSet) const {
 
 IndexRange SplitNux::cutRangeRight(const CutSet* cutSet) const {
   IndexT idxRight = cutSet->getIdxRight(*this);
-  return IndexRange(idxRight, getObsExtent() - (idxRight - getObsStart()));
+  IndexT extentMissing = cutSet->missingLeft(*this) ? getNMissing() : 0;
+  return IndexRange(idxRight, getObsExtent() - (idxRight - getObsStart()) - extentMissing);
+}
+
+
+IndexRange SplitNux::missingRange() const {
+  return IndexRange(getObsEnd() - getNMissing(), getNMissing());
 }
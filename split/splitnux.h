@@ -29,9 +29,6 @@
    value updated by splitting method.
  */
 class SplitNux {
-  static constexpr double minRatioDefault = 0.0;
-  static double minRatio;
-
   const StagedCell* cell; // Copied from PreCand.
   uint32_t randVal;
   IndexT accumIdx; // Index into accumulator workspace.
@@ -43,22 +40,6 @@ class SplitNux {
   double info; // CART employs Weighted variance or Gini.
   
 public:  
-  static vector<double> splitQuant; // Where within CDF to cut.  MOVE to CutSet.
-/**
-   @brief Builds static quantile splitting vector from front-end specification.
-
-   @param feSplitQuant specifies the splitting quantiles for numerical predictors.
-  */
-  static void immutables(double minRatio_,
-			 const vector<double>& feSplitQuant);
-
-  
-  /**
-     @brief Empties the static quantile splitting vector.
-   */
-  static void deImmutables();
-
-
   /**
      @retrun true iff run's range exceeds bounds.
    */
@@ -79,10 +60,18 @@ public:
 
   /**
      @brief Computes cut-based right range for numeric splits.
+
+     Missing observations, at the tail, are included unless routed left.
    */
   IndexRange cutRangeRight(const class CutSet* cutSet) const;
 
 
+  /**
+     @return range of the observations missing the predictor.
+   */
+  IndexRange missingRange() const;
+
+
   /**
      @brief Trivial constructor. 'info' value of 0.0 ensures ignoring.
   */  
@@ -159,9 +148,11 @@ public:
 
 
   /**
+     @param minRatio is the session's information ratio.
+
      @return minInfo threshold.
    */
-  double getMinInfo() const {
+  double getMinInfo(double minRatio) const {
     return minRatio * info;
   }
 
@@ -302,8 +293,10 @@ public:
   
   /**
      @brief Looks up splitting quantile for associated predictor.
+
+     @param splitQuant is the session's per-predictor specification.
    */
-  auto getSplitQuant() const {
+  auto getSplitQuant(const vector<double>& splitQuant) const {
     return splitQuant[getPredIdx()];
   }
 };